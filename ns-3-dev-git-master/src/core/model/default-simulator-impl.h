@@ -20,10 +20,10 @@
 #ifndef DEFAULT_SIMULATOR_IMPL_H
 #define DEFAULT_SIMULATOR_IMPL_H
 
+#include "mpsc-queue.h"
 #include "simulator-impl.h"
 
 #include <list>
-#include <mutex>
 #include <thread>
 
 /**
@@ -97,17 +97,8 @@ class DefaultSimulatorImpl : public SimulatorImpl
         EventImpl* event;
     };
 
-    /** Container type for the events from a different context. */
-    typedef std::list<EventWithContext> EventsWithContext;
-    /** The container of events from a different context. */
-    EventsWithContext m_eventsWithContext;
-    /**
-     * Flag \c true if all events with context have been moved to the
-     * primary event queue.
-     */
-    bool m_eventsWithContextEmpty;
-    /** Mutex to control access to the list of events with context. */
-    std::mutex m_eventsWithContextMutex;
+    /** The events from a different context, pushed without a lock. */
+    MpscQueue<EventWithContext> m_eventsWithContext;
 
     /** Container type for the events to run at Simulator::Destroy() */
     typedef std::list<EventId> DestroyEvents;
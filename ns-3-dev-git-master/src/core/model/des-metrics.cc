@@ -25,6 +25,7 @@
 
 #include "des-metrics.h"
 
+#include "fork-impl.h"
 #include "simulator.h"
 #include "system-path.h"
 
@@ -71,6 +72,7 @@ DesMetrics::Initialize(std::vector<std::string> args, std::string outDir /* = ""
     std::string capture_date(date, 24); // discard trailing newline from ctime
 
     m_os.open(jsonFile);
+    ForkImpl::RegisterFile(m_os.rdbuf(), jsonFile, std::ios::out);
     m_os << "{" << std::endl;
     m_os << " \"simulator_name\" : \"ns-3\"," << std::endl;
     m_os << " \"model_name\" : \"" << model_name << "\"," << std::endl;
@@ -146,6 +148,7 @@ DesMetrics::Close()
 
     m_os << " ]" << std::endl;
     m_os << "}" << std::endl;
+    ForkImpl::UnregisterFile(m_os.rdbuf());
     m_os.close();
 
     m_initialized = false;
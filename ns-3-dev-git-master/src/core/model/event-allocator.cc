@@ -0,0 +1,234 @@
+#include "event-allocator.h"
+
+#include "log.h"
+
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventAllocator implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("EventAllocator");
+
+namespace
+{
+
+/** Number of size classes. */
+constexpr std::size_t N_CLASSES = EventAllocator::MAX_SIZE / EventAllocator::GRANULARITY;
+/** Number of free blocks of a size class a thread keeps at most. */
+constexpr uint32_t CACHE_MAX = 512;
+/** Number of blocks a thread takes from the depot at once. */
+constexpr uint32_t BATCH = 64;
+
+/** A free block, linked to the next free block of its size class. */
+struct Block
+{
+    Block* next; //!< The next free block.
+};
+
+/** The free blocks of a size class. */
+struct FreeList
+{
+    Block* head;    //!< The first free block.
+    uint32_t count; //!< The number of free blocks.
+};
+
+/** The free blocks shared by the threads. */
+struct Depot
+{
+    std::mutex mutex;            //!< Protects the depot.
+    FreeList lists[N_CLASSES]{}; //!< The free blocks of each size class.
+    std::vector<void*> slabs;    //!< The slabs, never freed.
+};
+
+/**
+ * The free blocks of a thread. It is trivially destructible, so the events
+ * freed while the thread exits can still check whether it was flushed.
+ */
+struct ThreadCache
+{
+    FreeList lists[N_CLASSES]; //!< The free blocks of each size class.
+    bool flushed;              //!< Whether the blocks went back to the depot.
+};
+
+/** Returns the free blocks of a thread to the depot when the thread exits. */
+struct ThreadCacheFlusher
+{
+    bool used{false}; //!< Whether the thread has kept free blocks.
+    /** Destructor. */
+    ~ThreadCacheFlusher();
+};
+
+/** The number of slabs. */
+std::atomic<uint64_t> g_slabs{0};
+/** The number of blocks larger than EventAllocator::MAX_SIZE. */
+std::atomic<uint64_t> g_large{0};
+/** The free blocks of this thread. */
+thread_local ThreadCache t_cache;
+/** The flush of t_cache at the exit of this thread. */
+thread_local ThreadCacheFlusher t_flusher;
+
+/**
+ * Get the depot. It is never destroyed: events may be freed by the static
+ * destructors.
+ * \return The depot.
+ */
+Depot&
+GetDepot()
+{
+    static Depot* depot = new Depot;
+    return *depot;
+}
+
+/**
+ * Move blocks between free lists.
+ * \param [in,out] from The list to take the blocks from.
+ * \param [in,out] to The list to put the blocks on.
+ * \param [in] n The number of blocks to move, at most.
+ */
+void
+Move(FreeList& from, FreeList& to, uint32_t n)
+{
+    for (; n > 0 && from.head != nullptr; --n)
+    {
+        Block* block = from.head;
+        from.head = block->next;
+        --from.count;
+        block->next = to.head;
+        to.head = block;
+        ++to.count;
+    }
+}
+
+/**
+ * Carve a new slab into the blocks of a size class, the depot mutex held.
+ * \param [in,out] depot The depot, recording the slab.
+ * \param [in,out] list The list to put the blocks on.
+ * \param [in] index The size class.
+ */
+void
+Carve(Depot& depot, FreeList& list, std::size_t index)
+{
+    std::size_t size = (index + 1) * EventAllocator::GRANULARITY;
+    char* slab = static_cast<char*>(::operator new(EventAllocator::SLAB_SIZE));
+    depot.slabs.push_back(slab);
+    g_slabs.fetch_add(1, std::memory_order_relaxed);
+    NS_LOG_LOGIC("slab " << static_cast<void*>(slab) << " of " << size << " bytes blocks");
+    for (std::size_t offset = 0; offset + size <= EventAllocator::SLAB_SIZE; offset += size)
+    {
+        auto block = reinterpret_cast<Block*>(slab + offset);
+        block->next = list.head;
+        list.head = block;
+        ++list.count;
+    }
+}
+
+ThreadCacheFlusher::~ThreadCacheFlusher()
+{
+    Depot& depot = GetDepot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    for (std::size_t i = 0; i < N_CLASSES; ++i)
+    {
+        Move(t_cache.lists[i], depot.lists[i], std::numeric_limits<uint32_t>::max());
+    }
+    t_cache.flushed = true;
+}
+
+} // namespace
+
+void*
+EventAllocator::Allocate(std::size_t size)
+{
+    if (size > MAX_SIZE)
+    {
+        g_large.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    std::size_t index = (size - 1) / GRANULARITY;
+    FreeList& list = t_cache.lists[index];
+    if (list.head == nullptr)
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        if (t_cache.flushed)
+        {
+            // The thread is exiting: work on the depot directly.
+            FreeList& shared = depot.lists[index];
+            if (shared.head == nullptr)
+            {
+                Carve(depot, shared, index);
+            }
+            Block* block = shared.head;
+            shared.head = block->next;
+            --shared.count;
+            return block;
+        }
+        t_flusher.used = true;
+        Move(depot.lists[index], list, BATCH);
+        if (list.head == nullptr)
+        {
+            Carve(depot, list, index);
+        }
+    }
+    Block* block = list.head;
+    list.head = block->next;
+    --list.count;
+    return block;
+}
+
+void
+EventAllocator::Deallocate(void* block, std::size_t size)
+{
+    if (size > MAX_SIZE)
+    {
+        ::operator delete(block);
+        return;
+    }
+    std::size_t index = (size - 1) / GRANULARITY;
+    auto freed = static_cast<Block*>(block);
+    if (t_cache.flushed)
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        freed->next = depot.lists[index].head;
+        depot.lists[index].head = freed;
+        ++depot.lists[index].count;
+        return;
+    }
+    FreeList& list = t_cache.lists[index];
+    freed->next = list.head;
+    list.head = freed;
+    if (++list.count == 1)
+    {
+        t_flusher.used = true;
+    }
+    else if (list.count > CACHE_MAX)
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        Move(list, depot.lists[index], CACHE_MAX / 2);
+    }
+}
+
+uint64_t
+EventAllocator::GetSlabCount()
+{
+    return g_slabs.load(std::memory_order_relaxed);
+}
+
+uint64_t
+EventAllocator::GetLargeCount()
+{
+    return g_large.load(std::memory_order_relaxed);
+}
+
+} // namespace ns3
@@ -0,0 +1,72 @@
+#ifndef EVENT_ALLOCATOR_H
+#define EVENT_ALLOCATOR_H
+
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventAllocator declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup events
+ * \brief Size-class slab allocator of the events.
+ *
+ * The events made by MakeEvent() are small objects holding the function
+ * and its bound arguments inline, created and freed at every Schedule().
+ * The EventImpl operators new and delete take them from this allocator:
+ * the sizes up to MAX_SIZE are rounded to a multiple of GRANULARITY, and
+ * the blocks of each size class are carved from slabs of SLAB_SIZE bytes
+ * and kept on free lists, so an event reuses the block of an event freed
+ * before. Larger events use the system allocator.
+ *
+ * Each thread keeps its free lists, so the common case takes no lock. A
+ * thread returns blocks to a shared depot when it keeps too many, e.g.,
+ * when it frees the events scheduled by another thread, takes blocks from
+ * the depot before carving a new slab, and returns all its blocks to the
+ * depot when it exits. The slabs are never given back to the system.
+ */
+class EventAllocator
+{
+  public:
+    /** Largest size of the pooled blocks, in bytes. */
+    static constexpr std::size_t MAX_SIZE = 256;
+    /** Size difference of two size classes, in bytes. */
+    static constexpr std::size_t GRANULARITY = 16;
+    /** Size of the slabs the blocks are carved from, in bytes. */
+    static constexpr std::size_t SLAB_SIZE = 16384;
+
+    /**
+     * Allocate a block.
+     * \param [in] size The size of the block.
+     * \return The block.
+     */
+    static void* Allocate(std::size_t size);
+    /**
+     * Free a block.
+     * \param [in] block The block, returned by Allocate().
+     * \param [in] size The size given to Allocate().
+     */
+    static void Deallocate(void* block, std::size_t size);
+
+    /**
+     * Get the number of slabs allocated so far.
+     * \return The number of slabs.
+     */
+    static uint64_t GetSlabCount();
+    /**
+     * Get the number of blocks larger than MAX_SIZE allocated so far, by
+     * the system allocator.
+     * \return The number of large blocks.
+     */
+    static uint64_t GetLargeCount();
+};
+
+} // namespace ns3
+
+#endif /* EVENT_ALLOCATOR_H */
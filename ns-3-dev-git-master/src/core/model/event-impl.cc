@@ -19,8 +19,17 @@
 
 #include "event-impl.h"
 
+#include "event-allocator.h"
 #include "log.h"
 
+#ifndef __SANITIZE_ADDRESS__
+/**
+ * Take the events from the EventAllocator. The address sanitizer builds
+ * use the system allocator, to catch the uses of freed events.
+ */
+#define EVENT_IMPL_POOL 1
+#endif
+
 /**
  * \file
  * \ingroup events
@@ -67,4 +76,36 @@ EventImpl::IsCancelled()
     return m_cancel;
 }
 
+void*
+EventImpl::operator new(std::size_t size)
+{
+#ifdef EVENT_IMPL_POOL
+    return EventAllocator::Allocate(size);
+#else
+    return ::operator new(size);
+#endif
+}
+
+void*
+EventImpl::operator new(std::size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+
+void
+EventImpl::operator delete(void* event, std::size_t size)
+{
+#ifdef EVENT_IMPL_POOL
+    EventAllocator::Deallocate(event, size);
+#else
+    ::operator delete(event);
+#endif
+}
+
+void
+EventImpl::operator delete(void* event, std::size_t size, std::align_val_t alignment)
+{
+    ::operator delete(event, alignment);
+}
+
 } // namespace ns3
@@ -21,6 +21,8 @@
 
 #include "simple-ref-count.h"
 
+#include <cstddef>
+#include <new>
 #include <stdint.h>
 
 /**
@@ -41,6 +43,11 @@ namespace ns3
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * The events are allocated by the EventAllocator: the operator delete
+ * called by SimpleRefCount::Unref() when the last reference goes away
+ * gets the size of the actual subclass, and puts the block back on the
+ * free list of its size class.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -67,6 +74,33 @@ class EventImpl : public SimpleRefCount<EventImpl>
      */
     bool IsCancelled();
 
+    /**
+     * Allocate an event from the EventAllocator.
+     * \param [in] size The size of the event.
+     * \return The storage of the event.
+     */
+    static void* operator new(std::size_t size);
+    /**
+     * Allocate an over-aligned event, from the system allocator.
+     * \param [in] size The size of the event.
+     * \param [in] alignment The alignment of the event.
+     * \return The storage of the event.
+     */
+    static void* operator new(std::size_t size, std::align_val_t alignment);
+    /**
+     * Free an event allocated by operator new(std::size_t).
+     * \param [in] event The storage of the event.
+     * \param [in] size The size of the event.
+     */
+    static void operator delete(void* event, std::size_t size);
+    /**
+     * Free an event allocated by operator new(std::size_t, std::align_val_t).
+     * \param [in] event The storage of the event.
+     * \param [in] size The size of the event.
+     * \param [in] alignment The alignment of the event.
+     */
+    static void operator delete(void* event, std::size_t size, std::align_val_t alignment);
+
   protected:
     /**
      * Implementation for Invoke().
@@ -0,0 +1,194 @@
+#include "fork-impl.h"
+
+#include "abort.h"
+#include "log.h"
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+/**
+ * \file
+ * \ingroup forkimpl
+ * ns3::ForkImpl::RegisterFile(), ns3::ForkImpl::UnregisterFile(),
+ * ns3::ForkImpl::RegisterThread(), ns3::ForkImpl::UnregisterThread(),
+ * ns3::ForkImpl::PrepareFork() and ns3::ForkImpl::ReopenFiles() implementations.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ForkImpl");
+
+namespace ForkImpl
+{
+
+namespace
+{
+
+/** The name and the mode a file was opened with. */
+struct FileInfo
+{
+    std::string filename;    //!< The file name.
+    std::ios::openmode mode; //!< The open mode.
+};
+
+/** The registered files and threads. */
+struct FileRegistry
+{
+    std::mutex mutex;                           //!< Protects the files and the threads.
+    std::map<std::filebuf*, FileInfo> files;    //!< The files.
+    std::map<const void*, std::string> threads; //!< The objects running threads.
+};
+
+/**
+ * Get the registry of the files. It is never destroyed: files may be
+ * closed by the static destructors.
+ * \return The registry.
+ */
+FileRegistry&
+GetFileRegistry()
+{
+    static auto registry = new FileRegistry;
+    return *registry;
+}
+
+} // unnamed namespace
+
+void
+RegisterFile(std::filebuf* file, const std::string& filename, std::ios::openmode mode)
+{
+    NS_LOG_FUNCTION(file << filename << mode);
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.files[file] = {filename, mode};
+}
+
+void
+UnregisterFile(std::filebuf* file)
+{
+    NS_LOG_FUNCTION(file);
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.files.erase(file);
+}
+
+void
+RegisterThread(const void* owner, const std::string& name)
+{
+    NS_LOG_FUNCTION(owner << name);
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads[owner] = name;
+}
+
+void
+UnregisterThread(const void* owner)
+{
+    NS_LOG_FUNCTION(owner);
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.erase(owner);
+}
+
+std::string
+GetThreads()
+{
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::ostringstream oss;
+    for (auto& [owner, name] : registry.threads)
+    {
+        oss << (oss.tellp() > 0 ? ", " : "") << name;
+    }
+    return oss.str();
+}
+
+std::string
+GetChildFilename(const std::string& filename, uint32_t index)
+{
+    // The extension starts at the last dot of the base name, past its first character
+    std::size_t start = filename.find_last_of("/\\");
+    start = (start == std::string::npos) ? 0 : start + 1;
+    std::size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos || dot <= start)
+    {
+        dot = filename.size();
+    }
+    std::ostringstream oss;
+    oss << filename.substr(0, dot) << "-fork" << index << filename.substr(dot);
+    return oss.str();
+}
+
+void
+PrepareFork()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    std::cout.flush();
+    std::cerr.flush();
+    std::clog.flush();
+    std::fflush(nullptr);
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& [file, info] : registry.files)
+    {
+        file->pubsync();
+    }
+}
+
+void
+ReopenFiles(uint32_t index)
+{
+    NS_LOG_FUNCTION(index);
+    FileRegistry& registry = GetFileRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& [file, info] : registry.files)
+    {
+        if (!file->is_open())
+        {
+            continue;
+        }
+        bool writing = (info.mode & (std::ios::out | std::ios::app)) != 0;
+        std::ios::openmode which = writing ? std::ios::out : std::ios::in;
+        std::streampos position = file->pubseekoff(0, std::ios::cur, which);
+        file->close();
+
+        std::string filename = info.filename;
+        std::ios::openmode mode = info.mode;
+        if (writing)
+        {
+            filename = GetChildFilename(info.filename, index);
+            {
+                std::ifstream from(info.filename, std::ios::binary);
+                std::ofstream to(filename, std::ios::binary | std::ios::trunc);
+                if (from.peek() != std::ifstream::traits_type::eof())
+                {
+                    to << from.rdbuf();
+                }
+                NS_ABORT_MSG_UNLESS(to.good(),
+                                    "ForkImpl::ReopenFiles(): Unable to copy "
+                                        << info.filename << " to " << filename);
+            }
+            // Do not truncate the copy
+            if ((mode & std::ios::app) == 0)
+            {
+                mode = (mode | std::ios::in) & ~std::ios::trunc;
+            }
+        }
+        NS_ABORT_MSG_UNLESS(file->open(filename, mode) != nullptr,
+                            "ForkImpl::ReopenFiles(): Unable to open " << filename);
+        if ((mode & std::ios::app) == 0 && position != std::streampos(-1))
+        {
+            file->pubseekpos(position, which);
+        }
+        NS_LOG_LOGIC("process " << index << " takes over " << info.filename << " as "
+                                << filename);
+        info.filename = filename;
+    }
+}
+
+} // namespace ForkImpl
+
+} // namespace ns3
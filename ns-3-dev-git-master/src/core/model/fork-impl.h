@@ -0,0 +1,122 @@
+#ifndef FORK_IMPL_H
+#define FORK_IMPL_H
+
+#include <fstream>
+#include <stdint.h>
+#include <string>
+
+/**
+ * \file
+ * \ingroup forkimpl
+ * ns3::ForkImpl::RegisterFile(), ns3::ForkImpl::UnregisterFile(),
+ * ns3::ForkImpl::RegisterThread(), ns3::ForkImpl::UnregisterThread(),
+ * ns3::ForkImpl::PrepareFork() and ns3::ForkImpl::ReopenFiles() declarations.
+ */
+
+/**
+ * \ingroup simulator
+ * \defgroup forkimpl Fork Implementation.
+ *
+ * The processes forked by Simulator::ForkAt() share the file descriptors
+ * of the files open before the fork, and the data still buffered in the
+ * streams. The files registered here are flushed before the fork, and
+ * each child continues writing to a copy of its own.
+ *
+ * Only the thread calling fork() exists in the children: the objects
+ * running threads of their own register them, and Simulator::ForkAt()
+ * refuses to fork while one is registered.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup forkimpl
+ * \brief Implementation namespace for the files of the forked processes.
+ */
+namespace ForkImpl
+{
+
+/**
+ * \ingroup forkimpl
+ * \brief Register an open file to be taken over by the forked processes.
+ *
+ * Users of this function should ensure the file remains valid until
+ * it has been unregistered.
+ *
+ * \param [in] file The buffer of the file stream.
+ * \param [in] filename The name the file was opened with.
+ * \param [in] mode The mode the file was opened with.
+ */
+void RegisterFile(std::filebuf* file, const std::string& filename, std::ios::openmode mode);
+
+/**
+ * \ingroup forkimpl
+ * \brief Unregister a file, before it is closed.
+ *
+ * \param [in] file The buffer of the file stream.
+ */
+void UnregisterFile(std::filebuf* file);
+
+/**
+ * \ingroup forkimpl
+ * \brief Register an object running threads besides the main one.
+ *
+ * \param [in] owner The object.
+ * \param [in] name What runs the threads, for the error message.
+ */
+void RegisterThread(const void* owner, const std::string& name);
+
+/**
+ * \ingroup forkimpl
+ * \brief Unregister an object, after its threads are joined.
+ *
+ * \param [in] owner The object.
+ */
+void UnregisterThread(const void* owner);
+
+/**
+ * \ingroup forkimpl
+ * \brief Get the objects running threads besides the main one.
+ *
+ * \returns The names of the objects, empty if there are none.
+ */
+std::string GetThreads();
+
+/**
+ * \ingroup forkimpl
+ * \brief Get the name of the copy of a file in a forked process.
+ *
+ * The index of the process is inserted before the extension:
+ * \c trace.pcap becomes \c trace-fork2.pcap in the process 2.
+ *
+ * \param [in] filename The name of the file.
+ * \param [in] index The index of the forked process.
+ * \returns The name of the copy.
+ */
+std::string GetChildFilename(const std::string& filename, uint32_t index);
+
+/**
+ * \ingroup forkimpl
+ * \brief Flush the standard streams and the registered files, before
+ * a fork.
+ */
+void PrepareFork();
+
+/**
+ * \ingroup forkimpl
+ * \brief Move the registered files of a forked process to their own copy.
+ *
+ * The files open for writing are copied to GetChildFilename() and
+ * reopened there, at the same position. The files open for reading
+ * only are reopened, so the processes do not share the file offset.
+ *
+ * \param [in] index The index of the forked process.
+ */
+void ReopenFiles(uint32_t index);
+
+} // namespace ForkImpl
+
+} // namespace ns3
+
+#endif /* FORK_IMPL_H */
@@ -0,0 +1,248 @@
+#include "ladder-scheduler.h"
+
+#include "assert.h"
+#include "event-impl.h"
+#include "log.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(LadderScheduler);
+
+TypeId
+LadderScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::LadderScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("Core")
+                            .AddConstructor<LadderScheduler>();
+    return tid;
+}
+
+LadderScheduler::LadderScheduler()
+    : m_topStart(0),
+      m_topMin(std::numeric_limits<uint64_t>::max()),
+      m_topMax(0),
+      m_rungs(MAX_RUNGS),
+      m_nRungs(0),
+      m_bottomLimit(THRESHOLD),
+      m_size(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LadderScheduler::~LadderScheduler()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart(const Rung& rung)
+{
+    return rung.start + rung.current * rung.width;
+}
+
+LadderScheduler::Bucket*
+LadderScheduler::GetBucket(uint64_t ts)
+{
+    if (ts >= m_topStart)
+    {
+        return &m_top;
+    }
+    for (uint32_t i = 0; i < m_nRungs; ++i)
+    {
+        Rung& rung = m_rungs[i];
+        if (ts >= GetCurrentStart(rung))
+        {
+            return &rung.buckets[(ts - rung.start) / rung.width];
+        }
+    }
+    return nullptr;
+}
+
+void
+LadderScheduler::Insert(const Scheduler::Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    ++m_size;
+    Bucket* bucket = GetBucket(ev.key.m_ts);
+    if (bucket == &m_top)
+    {
+        m_topMin = std::min(m_topMin, ev.key.m_ts);
+        m_topMax = std::max(m_topMax, ev.key.m_ts);
+    }
+    if (bucket != nullptr)
+    {
+        bucket->push_back(ev);
+    }
+    else
+    {
+        auto it = std::lower_bound(m_bottom.begin(),
+                                   m_bottom.end(),
+                                   ev,
+                                   std::greater<Scheduler::Event>());
+        m_bottom.insert(it, ev);
+        if (m_bottom.size() > m_bottomLimit && m_nRungs < MAX_RUNGS)
+        {
+            // Spread the Bottom on a rung below the others
+            uint64_t start = m_bottom.back().key.m_ts;
+            uint64_t end = m_nRungs > 0 ? GetCurrentStart(m_rungs[m_nRungs - 1]) : m_topStart;
+            uint64_t width = (end - start) / m_bottom.size() + 1;
+            std::size_t nBuckets = (end - start + width - 1) / width;
+            SpawnRung(m_bottom, start, width, nBuckets);
+        }
+    }
+    Refill();
+}
+
+bool
+LadderScheduler::IsEmpty() const
+{
+    NS_LOG_FUNCTION(this);
+    return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext() const
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!m_bottom.empty());
+    return m_bottom.back();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!m_bottom.empty());
+    Scheduler::Event next = m_bottom.back();
+    m_bottom.pop_back();
+    --m_size;
+    Refill();
+    return next;
+}
+
+void
+LadderScheduler::Remove(const Scheduler::Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    Bucket* bucket = GetBucket(ev.key.m_ts);
+    if (bucket != nullptr)
+    {
+        auto it = std::find_if(bucket->begin(), bucket->end(), [&ev](const Scheduler::Event& e) {
+            return e.key.m_uid == ev.key.m_uid;
+        });
+        NS_ASSERT_MSG(it != bucket->end(), "Event not found " << ev.key.m_uid);
+        *it = bucket->back();
+        bucket->pop_back();
+    }
+    else
+    {
+        auto it = std::lower_bound(m_bottom.begin(),
+                                   m_bottom.end(),
+                                   ev,
+                                   std::greater<Scheduler::Event>());
+        NS_ASSERT_MSG(it != m_bottom.end() && it->key.m_uid == ev.key.m_uid,
+                      "Event not found " << ev.key.m_uid);
+        m_bottom.erase(it);
+    }
+    --m_size;
+    Refill();
+}
+
+void
+LadderScheduler::SpawnRung(Bucket& events, uint64_t start, uint64_t width, std::size_t nBuckets)
+{
+    NS_LOG_FUNCTION(this << events.size() << start << width << nBuckets);
+    NS_ASSERT(m_nRungs < MAX_RUNGS);
+    Rung& rung = m_rungs[m_nRungs++];
+    rung.start = start;
+    rung.width = width;
+    rung.nBuckets = nBuckets;
+    rung.current = 0;
+    if (rung.buckets.size() < nBuckets)
+    {
+        rung.buckets.resize(nBuckets);
+    }
+    for (const auto& ev : events)
+    {
+        rung.buckets[(ev.key.m_ts - start) / width].push_back(ev);
+    }
+    events.clear();
+}
+
+void
+LadderScheduler::MoveToBottom(Bucket& events)
+{
+    NS_LOG_FUNCTION(this << events.size());
+    m_bottom.insert(m_bottom.end(), events.begin(), events.end());
+    std::sort(m_bottom.begin(), m_bottom.end(), std::greater<Scheduler::Event>());
+    events.clear();
+    m_bottomLimit = std::max(THRESHOLD, 2 * m_bottom.size());
+}
+
+void
+LadderScheduler::Refill()
+{
+    while (m_bottom.empty() && m_size > 0)
+    {
+        if (m_nRungs == 0)
+        {
+            NS_ASSERT(!m_top.empty());
+            if (m_top.size() <= THRESHOLD)
+            {
+                m_topStart = m_topMax + 1;
+                MoveToBottom(m_top);
+            }
+            else
+            {
+                // As many buckets as events, over the span of the Top
+                uint64_t width = (m_topMax - m_topMin) / m_top.size() + 1;
+                std::size_t nBuckets = (m_topMax - m_topMin) / width + 1;
+                m_topStart = m_topMin + nBuckets * width;
+                SpawnRung(m_top, m_topMin, width, nBuckets);
+            }
+            m_topMin = std::numeric_limits<uint64_t>::max();
+            m_topMax = 0;
+            continue;
+        }
+
+        Rung& rung = m_rungs[m_nRungs - 1];
+        while (rung.current < rung.nBuckets && rung.buckets[rung.current].empty())
+        {
+            ++rung.current;
+        }
+        if (rung.current == rung.nBuckets)
+        {
+            --m_nRungs;
+            continue;
+        }
+        uint64_t start = GetCurrentStart(rung);
+        Bucket& bucket = rung.buckets[rung.current++];
+        if (bucket.size() > THRESHOLD && rung.width > 1 && m_nRungs < MAX_RUNGS)
+        {
+            // Spread the bucket on a finer rung, one bucket per event
+            uint64_t width = (rung.width + bucket.size() - 1) / bucket.size();
+            std::size_t nBuckets = (rung.width + width - 1) / width;
+            SpawnRung(bucket, start, width, nBuckets);
+        }
+        else
+        {
+            MoveToBottom(bucket);
+        }
+    }
+}
+
+} // namespace ns3
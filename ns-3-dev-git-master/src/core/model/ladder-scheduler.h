@@ -0,0 +1,166 @@
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup scheduler
+ * \brief A ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of
+ * ["Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh
+ * and Ian Li-Jin Thng][Tang].
+ *
+ * [Tang]: https://doi.org/10.1145/1103323.1103324 "Tang"
+ *
+ * The events are kept in three tiers:
+ *
+ * - Top: an unsorted vector of the events later than all the others,
+ *   the time stamps at or after \c m_topStart.
+ * - Ladder: up to MAX_RUNGS rungs of buckets. The first rung is built
+ *   from the whole Top, with as many buckets as events; a bucket holding
+ *   more than THRESHOLD events when it is reached is spread on a new,
+ *   finer rung instead of being sorted. The buckets are unsorted.
+ * - Bottom: the few earliest events, sorted. When the events inserted
+ *   in the Bottom make it too large, it is spread on a new rung, below
+ *   the others.
+ *
+ * Unlike the calendar queue, the bucket width is not estimated from a
+ * sample: each rung is sized from the time span and the number of the
+ * events it receives, so skewed time distributions only add rungs.
+ * The Bottom is refilled, from the Ladder or the Top, as soon as it is
+ * empty, so PeekNext() always finds the next event at the end of the
+ * Bottom. The buckets keep their storage when they are emptied, so in
+ * the steady state the scheduler does not allocate.
+ *
+ * \par Time Complexity
+ *
+ * Operation    | Amortized %Time | Reason
+ * :----------- | :-------------- | :-----
+ * Insert()     | ~Constant       | Append to Top or a bucket; sorted Bottom
+ * IsEmpty()    | Constant        | Explicit queue size
+ * PeekNext()   | Constant        | End of the Bottom
+ * Remove()     | ~Constant       | Search within bucket
+ * RemoveNext() | ~Constant       | Refill the Bottom from a bucket
+ *
+ * \par Memory Complexity
+ *
+ * Category  | Memory                           | Reason
+ * :-------- | :------------------------------- | :-----
+ * Overhead  | Buckets of the rungs             | `std::vector` per bucket
+ * Per Event | `sizeof (Event)`                 | `std::vector`
+ */
+class LadderScheduler : public Scheduler
+{
+  public:
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    /** Constructor. */
+    LadderScheduler();
+    /** Destructor. */
+    ~LadderScheduler() override;
+
+    // Inherited
+    void Insert(const Scheduler::Event& ev) override;
+    bool IsEmpty() const override;
+    Scheduler::Event PeekNext() const override;
+    Scheduler::Event RemoveNext() override;
+    void Remove(const Scheduler::Event& ev) override;
+
+    /** Maximum number of rungs of the Ladder. */
+    static constexpr uint32_t MAX_RUNGS = 8;
+    /** Number of events of a bucket above which it is spread on a new rung. */
+    static constexpr std::size_t THRESHOLD = 50;
+
+  private:
+    /** A bucket, or the Top: unsorted events. */
+    typedef std::vector<Scheduler::Event> Bucket;
+
+    /** A rung of the Ladder. */
+    struct Rung
+    {
+        /** Time stamp of the start of the first bucket. */
+        uint64_t start;
+        /** Time span of a bucket. */
+        uint64_t width;
+        /** Number of buckets in use, the vector may be larger. */
+        std::size_t nBuckets;
+        /** Index of the first bucket not yet moved down. */
+        std::size_t current;
+        /** The buckets. */
+        std::vector<Bucket> buckets;
+    };
+
+    /**
+     * Get the time stamp of the start of the current bucket of a rung:
+     * the earliest time the rung can take.
+     * \param [in] rung The rung.
+     * \returns The start of the current bucket.
+     */
+    static uint64_t GetCurrentStart(const Rung& rung);
+    /**
+     * Get the bucket of an event, in the Ladder or the Top.
+     * \param [in] ts The time stamp of the event.
+     * \returns The bucket, or nullptr if the event belongs to the Bottom.
+     */
+    Bucket* GetBucket(uint64_t ts);
+    /**
+     * Set up a rung and spread events on it.
+     * \param [in] events The events.
+     * \param [in] start The start of the first bucket.
+     * \param [in] width The span of a bucket.
+     * \param [in] nBuckets The number of buckets.
+     */
+    void SpawnRung(Bucket& events, uint64_t start, uint64_t width, std::size_t nBuckets);
+    /**
+     * Sort events into the Bottom.
+     * \param [in] events The events, earlier than all the others.
+     */
+    void MoveToBottom(Bucket& events);
+    /** Refill the Bottom, if it is empty, from the Ladder or the Top. */
+    void Refill();
+
+    /** The Top. */
+    Bucket m_top;
+    /** The earliest time stamp of the Top. */
+    uint64_t m_topStart;
+    /** The smallest time stamp inserted in the Top since it was last emptied. */
+    uint64_t m_topMin;
+    /** The largest time stamp inserted in the Top since it was last emptied. */
+    uint64_t m_topMax;
+    /** The rungs, the first m_nRungs in use. */
+    std::vector<Rung> m_rungs;
+    /** Number of rungs in use. */
+    uint32_t m_nRungs;
+    /** The Bottom, sorted by decreasing time stamp. */
+    Bucket m_bottom;
+    /**
+     * Size of the Bottom above which it is spread on a rung: twice its size
+     * when it was last refilled, so a Bottom of events at the same time,
+     * which a rung cannot spread, is not spread again at each insertion.
+     */
+    std::size_t m_bottomLimit;
+    /** Number of events in the scheduler. */
+    std::size_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -0,0 +1,279 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "assert.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::MpscQueue declaration and template implementation.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup events
+ * \brief A multiple producer, single consumer queue of the items handed
+ * from other threads to the simulator thread.
+ *
+ * The items are kept in a bounded ring, after ["Bounded MPMC queue" by
+ * Dmitry Vyukov][Vyukov]: each slot carries a sequence number telling
+ * whether it is free for the turn of a producer or published for the
+ * consumer. A producer claims a slot with a single compare-and-swap on
+ * the tail and publishes it with a release store; the consumer drains
+ * all the published slots at once without any atomic read-modify-write.
+ *
+ * [Vyukov]: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+ *
+ * When the ring is full, the items go to an overflow list under a mutex,
+ * so Push() never blocks on the consumer and no item is lost: the
+ * consumer may not be draining at all, e.g. before Simulator::Run().
+ * While the overflow list is in use, all the producers append to it, and
+ * Drain() takes the items claimed in the ring before the overflow, so the
+ * items of each producer are drained in the order they were pushed.
+ *
+ * \tparam T \explicit The type of the items, trivially copyable.
+ */
+template <typename T>
+class MpscQueue
+{
+  public:
+    /**
+     * Constructor.
+     * \param [in] capacity The number of items of the ring, a power of 2.
+     */
+    explicit MpscQueue(uint32_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * Append an item, from any thread.
+     * \param [in] item The item.
+     */
+    void Push(const T& item);
+
+    /**
+     * Whether there is no item to drain, from the consumer thread.
+     * \returns \c true if no item was pushed since the last Drain().
+     */
+    bool IsEmpty() const;
+
+    /**
+     * Remove all the items pushed, from the consumer thread.
+     * \tparam F \deduced The type of the function.
+     * \param [in] consume The function called with each item.
+     */
+    template <typename F>
+    void Drain(F consume);
+
+    /**
+     * Get the number of items which went to the overflow list.
+     * \returns The number of items pushed while the ring was full.
+     */
+    uint64_t GetOverflowCount() const;
+
+    /** Default number of items of the ring. */
+    static constexpr uint32_t DEFAULT_CAPACITY = 1024;
+
+  private:
+    /** A slot of the ring. */
+    struct Slot
+    {
+        /**
+         * The position the slot is free for, or the position plus one once
+         * the item at the position is published.
+         */
+        std::atomic<uint64_t> sequence;
+        /** The item. */
+        T item;
+    };
+
+    /**
+     * Append an item to the ring.
+     * \param [in] item The item.
+     * \returns \c false if the ring is full.
+     */
+    bool TryPush(const T& item);
+    /**
+     * Remove the item at the head of the ring, if it is published.
+     * \param [out] item The item.
+     * \returns \c false if the head slot is not published.
+     */
+    bool TryPop(T& item);
+
+    /** The slots. */
+    std::unique_ptr<Slot[]> m_slots;
+    /** The number of slots minus one. */
+    uint64_t m_mask;
+    /** The position of the next slot to claim, shared by the producers. */
+    alignas(64) std::atomic<uint64_t> m_tail;
+    /** The position of the next slot to drain, owned by the consumer. */
+    alignas(64) uint64_t m_head;
+    /** Whether the producers append to the overflow list. */
+    std::atomic<bool> m_overflowing;
+    /** Mutex protecting the overflow list. */
+    mutable std::mutex m_mutex;
+    /** The items pushed while the ring was full. */
+    std::vector<T> m_overflow;
+    /** The number of items pushed to the overflow list. */
+    uint64_t m_overflowCount;
+};
+
+} // namespace ns3
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3
+{
+
+template <typename T>
+MpscQueue<T>::MpscQueue(uint32_t capacity)
+    : m_slots(new Slot[capacity]),
+      m_mask(capacity - 1),
+      m_tail(0),
+      m_head(0),
+      m_overflowing(false),
+      m_overflowCount(0)
+{
+    NS_ASSERT_MSG(capacity > 0 && (capacity & m_mask) == 0, "capacity not a power of 2");
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+bool
+MpscQueue<T>::TryPush(const T& item)
+{
+    uint64_t pos = m_tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Slot& slot = m_slots[pos & m_mask];
+        auto diff = static_cast<int64_t>(slot.sequence.load(std::memory_order_acquire) - pos);
+        if (diff == 0)
+        {
+            // The slot is free for this turn: claim it
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.item = item;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The slot still holds the item of the previous turn
+            return false;
+        }
+        else
+        {
+            // Another producer claimed the slot
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool
+MpscQueue<T>::TryPop(T& item)
+{
+    Slot& slot = m_slots[m_head & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_head + 1)
+    {
+        return false;
+    }
+    item = slot.item;
+    slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+    ++m_head;
+    return true;
+}
+
+template <typename T>
+void
+MpscQueue<T>::Push(const T& item)
+{
+    if (!m_overflowing.load(std::memory_order_acquire) && TryPush(item))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The consumer may have taken the overflow list in the meantime
+    if (!m_overflowing.load(std::memory_order_relaxed) && TryPush(item))
+    {
+        return;
+    }
+    m_overflowing.store(true, std::memory_order_release);
+    m_overflow.push_back(item);
+    ++m_overflowCount;
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty() const
+{
+    return m_tail.load(std::memory_order_acquire) == m_head &&
+           !m_overflowing.load(std::memory_order_acquire);
+}
+
+template <typename T>
+template <typename F>
+void
+MpscQueue<T>::Drain(F consume)
+{
+    T item;
+    while (TryPop(item))
+    {
+        consume(item);
+    }
+    if (!m_overflowing.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::vector<T> overflow;
+    uint64_t tail;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // The slots claimed before the overflow items, maybe not yet published
+        tail = m_tail.load(std::memory_order_acquire);
+        overflow.swap(m_overflow);
+        m_overflowing.store(false, std::memory_order_release);
+    }
+    while (m_head != tail)
+    {
+        if (TryPop(item))
+        {
+            consume(item);
+        }
+        else
+        {
+            // A producer is between its claim and its publication
+            std::this_thread::yield();
+        }
+    }
+    for (const auto& i : overflow)
+    {
+        consume(i);
+    }
+}
+
+template <typename T>
+uint64_t
+MpscQueue<T>::GetOverflowCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_overflowCount;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
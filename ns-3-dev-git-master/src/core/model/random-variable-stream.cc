@@ -37,6 +37,8 @@
 #include <algorithm> // upper_bound
 #include <cmath>
 #include <iostream>
+#include <mutex>
+#include <set>
 
 /**
  * \file
@@ -76,18 +78,68 @@ RandomVariableStream::GetTypeId()
     return tid;
 }
 
+namespace
+{
+
+/** The existing streams, for RandomVariableStream::ReseedAll(). */
+struct StreamRegistry
+{
+    std::mutex mutex;                        //!< Protects the set.
+    std::set<RandomVariableStream*> streams; //!< The streams.
+};
+
+/**
+ * Get the registry of the streams. It is never destroyed: streams may be
+ * destroyed by the static destructors.
+ * \return The registry.
+ */
+StreamRegistry&
+GetStreamRegistry()
+{
+    static auto registry = new StreamRegistry;
+    return *registry;
+}
+
+} // namespace
+
 RandomVariableStream::RandomVariableStream()
     : m_rng(nullptr)
 {
     NS_LOG_FUNCTION(this);
+    StreamRegistry& registry = GetStreamRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.streams.insert(this);
 }
 
 RandomVariableStream::~RandomVariableStream()
 {
     NS_LOG_FUNCTION(this);
+    {
+        StreamRegistry& registry = GetStreamRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.streams.erase(this);
+    }
     delete m_rng;
 }
 
+void
+RandomVariableStream::ReseedAll()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    StreamRegistry& registry = GetStreamRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto stream : registry.streams)
+    {
+        if (stream->m_rng != nullptr)
+        {
+            delete stream->m_rng;
+            stream->m_rng = new RngStream(RngSeedManager::GetSeed(),
+                                          stream->m_streamIndex,
+                                          RngSeedManager::GetRun());
+        }
+    }
+}
+
 void
 RandomVariableStream::SetAntithetic(bool isAntithetic)
 {
@@ -122,16 +174,16 @@ RandomVariableStream::SetStream(int64_t stream)
         // number assignment.
         uint64_t nextStream = RngSeedManager::GetNextStreamIndex();
         NS_ASSERT(nextStream <= ((1ULL) << 63));
-        m_rng = new RngStream(RngSeedManager::GetSeed(), nextStream, RngSeedManager::GetRun());
+        m_streamIndex = nextStream;
     }
     else
     {
         // The last 2^63 streams are reserved for deterministic stream
         // number assignment.
         uint64_t base = ((1ULL) << 63);
-        uint64_t target = base + stream;
-        m_rng = new RngStream(RngSeedManager::GetSeed(), target, RngSeedManager::GetRun());
+        m_streamIndex = base + stream;
     }
+    m_rng = new RngStream(RngSeedManager::GetSeed(), m_streamIndex, RngSeedManager::GetRun());
     m_stream = stream;
 }
 
@@ -153,6 +153,16 @@ class RandomVariableStream : public Object
     // The base implementation returns `(uint32_t)GetValue()`
     virtual uint32_t GetInteger();
 
+    /**
+     * \brief Restart the RngStream of all the existing streams on the
+     * current seed and run number.
+     *
+     * The streams keep their stream number, and draw from the start of
+     * the substream of the run, as if they were created now. This gives
+     * distinct draws to the processes forked by Simulator::ForkAt().
+     */
+    static void ReseedAll();
+
   protected:
     /**
      * \brief Get the pointer to the underlying RngStream.
@@ -170,6 +180,9 @@ class RandomVariableStream : public Object
     /** The stream number for the RngStream. */
     int64_t m_stream;
 
+    /** The index of the RngStream, allocated or derived from #m_stream. */
+    uint64_t m_streamIndex;
+
 }; // class RandomVariableStream
 
 /**
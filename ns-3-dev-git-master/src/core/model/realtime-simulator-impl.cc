@@ -30,6 +30,7 @@
 #include "synchronizer.h"
 #include "wall-clock-synchronizer.h"
 
+#include <algorithm>
 #include <cmath>
 #include <mutex>
 #include <thread>
@@ -102,6 +103,8 @@ void
 RealtimeSimulatorImpl::DoDispose()
 {
     NS_LOG_FUNCTION(this);
+    ProcessEventsWithContext();
+
     while (!m_events->IsEmpty())
     {
         Scheduler::Event next = m_events->RemoveNext();
@@ -217,6 +220,19 @@ RealtimeSimulatorImpl::ProcessOneEvent()
                 m_synchronizer->Realtime(),
                 "RealtimeSimulatorImpl::ProcessOneEvent (): Synchronizer reports not Realtime ()");
 
+            //
+            // We're going to figure out how long we need to delay in order to pace
+            // the simulation time with the real time, and sleep, but need to work
+            // with the synchronizer to make sure we're awakened if something
+            // external happens (like a packet is received).  This next line resets
+            // the synchronizer so that any future event will cause it to interrupt.
+            // The events scheduled by other threads are pushed without the critical
+            // section, so the reset comes before we move them into the event list:
+            // those pushed later will interrupt the wait.
+            //
+            m_synchronizer->SetCondition(false);
+            ProcessEventsWithContext();
+
             //
             // tsNow is set to the normalized current real time.  When the simulation was
             // started, the current real time was effectively set to zero; so tsNow is
@@ -244,15 +260,6 @@ RealtimeSimulatorImpl::ProcessOneEvent()
             {
                 tsDelay = tsNext - tsNow;
             }
-
-            //
-            // We've figured out how long we need to delay in order to pace the
-            // simulation time with the real time.  We're going to sleep, but need
-            // to work with the synchronizer to make sure we're awakened if something
-            // external happens (like a packet is received).  This next line resets
-            // the synchronizer so that any future event will cause it to interrupt.
-            //
-            m_synchronizer->SetCondition(false);
         }
 
         //
@@ -400,7 +407,7 @@ RealtimeSimulatorImpl::IsFinished() const
     bool rc;
     {
         std::unique_lock lock{m_mutex};
-        rc = m_events->IsEmpty() || m_stop;
+        rc = (m_events->IsEmpty() && m_eventsWithContext.IsEmpty()) || m_stop;
     }
 
     return rc;
@@ -442,6 +449,7 @@ RealtimeSimulatorImpl::Run()
         {
             std::unique_lock lock{m_mutex};
 
+            ProcessEventsWithContext();
             if (!m_events->IsEmpty())
             {
                 process = true;
@@ -541,23 +549,27 @@ RealtimeSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay,
 {
     NS_LOG_FUNCTION(this << context << delay << impl);
 
+    if (m_main != std::this_thread::get_id())
     {
-        std::unique_lock lock{m_mutex};
-        uint64_t ts;
+        //
+        // If the simulator is running, we're pacing and have a meaningful
+        // realtime clock.  If we're not, then m_currentTs is where we stopped,
+        // and the main thread adds it when it moves the event into the list.
+        //
+        EventWithContext ev;
+        ev.context = context;
+        ev.realtime = m_running;
+        ev.timestamp = ev.realtime ? m_synchronizer->GetCurrentRealtime() : 0;
+        ev.timestamp += delay.GetTimeStep();
+        ev.event = impl;
+        m_eventsWithContext.Push(ev);
+        m_synchronizer->Signal();
+        return;
+    }
 
-        if (m_main == std::this_thread::get_id())
-        {
-            ts = m_currentTs + delay.GetTimeStep();
-        }
-        else
-        {
-            //
-            // If the simulator is running, we're pacing and have a meaningful
-            // realtime clock.  If we're not, then m_currentTs is where we stopped.
-            //
-            ts = m_running ? m_synchronizer->GetCurrentRealtime() : m_currentTs;
-            ts += delay.GetTimeStep();
-        }
+    {
+        std::unique_lock lock{m_mutex};
+        uint64_t ts = m_currentTs + delay.GetTimeStep();
 
         NS_ASSERT_MSG(ts >= m_currentTs,
                       "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
@@ -573,6 +585,31 @@ RealtimeSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay,
     }
 }
 
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext()
+{
+    if (m_eventsWithContext.IsEmpty())
+    {
+        return;
+    }
+
+    m_eventsWithContext.Drain([this](const EventWithContext& event) {
+        //
+        // The main thread may have run events past the realtime the event was
+        // scheduled at since: it cannot be scheduled before the current event.
+        //
+        Scheduler::Event ev;
+        ev.impl = event.event;
+        ev.key.m_ts = event.realtime ? std::max(event.timestamp, m_currentTs)
+                                     : m_currentTs + event.timestamp;
+        ev.key.m_context = event.context;
+        ev.key.m_uid = m_uid;
+        m_uid++;
+        m_unscheduledEvents++;
+        m_events->Insert(ev);
+    });
+}
+
 EventId
 RealtimeSimulatorImpl::ScheduleNow(EventImpl* impl)
 {
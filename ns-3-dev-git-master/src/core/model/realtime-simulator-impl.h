@@ -21,11 +21,13 @@
 #include "assert.h"
 #include "event-impl.h"
 #include "log.h"
+#include "mpsc-queue.h"
 #include "ptr.h"
 #include "scheduler.h"
 #include "simulator-impl.h"
 #include "synchronizer.h"
 
+#include <atomic>
 #include <list>
 #include <mutex>
 #include <thread>
@@ -181,9 +183,27 @@ class RealtimeSimulatorImpl : public SimulatorImpl
     uint64_t NextTs() const;
     /** Process the next event. */
     void ProcessOneEvent();
+    /**
+     * Move the events scheduled by other threads into the event list.
+     * Should be called with #m_mutex locked.
+     */
+    void ProcessEventsWithContext();
     /** Destructor implementation. */
     void DoDispose() override;
 
+    /** An event scheduled by another thread, with its execution context. */
+    struct EventWithContext
+    {
+        /** The event context. */
+        uint32_t context;
+        /** Event timestamp, or delay from the current time if not \c realtime. */
+        uint64_t timestamp;
+        /** Whether the timestamp was taken on the realtime clock. */
+        bool realtime;
+        /** The event implementation. */
+        EventImpl* event;
+    };
+
     /** Container type for events to be run at destroy time. */
     typedef std::list<EventId> DestroyEvents;
     /** Container for events to be run at destroy time. */
@@ -191,7 +211,7 @@ class RealtimeSimulatorImpl : public SimulatorImpl
     /** Has the stopping condition been reached? */
     bool m_stop;
     /** Is the simulator currently running. */
-    bool m_running;
+    std::atomic<bool> m_running;
 
     /**
      * \name Mutex-protected variables.
@@ -218,6 +238,9 @@ class RealtimeSimulatorImpl : public SimulatorImpl
     /** Mutex to control access to key state. */
     mutable std::mutex m_mutex;
 
+    /** The events scheduled by other threads, pushed without #m_mutex. */
+    MpscQueue<EventWithContext> m_eventsWithContext;
+
     /** The synchronizer in use to track real time. */
     Ptr<Synchronizer> m_synchronizer;
 
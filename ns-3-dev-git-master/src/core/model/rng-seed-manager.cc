@@ -24,6 +24,13 @@
 #include "log.h"
 #include "uinteger.h"
 
+#ifdef NS3_MTP
+#include "simulator.h"
+
+#include <map>
+#include <mutex>
+#endif
+
 /**
  * \file
  * \ingroup randomvariable
@@ -40,7 +47,38 @@ NS_LOG_COMPONENT_DEFINE("RngSeedManager");
  * The next random number generator stream number to use
  * for automatic assignment.
  */
+#ifdef NS3_MTP
+/**
+ * \relates RngSeedManager
+ * Get the next stream number counter of the partition running the
+ * current event.
+ *
+ * Each partition of a multithreaded simulation counts its own streams,
+ * so that the streams of its random variables do not depend on the
+ * threads. A partition only runs on one thread at a time, and a thread
+ * keeps the counter of its last partition.
+ *
+ * \returns The counter.
+ */
+static uint32_t&
+GetPartitionStreamIndex()
+{
+    static std::mutex mutex;
+    static std::map<uint32_t, uint32_t> counters;
+    thread_local uint32_t partition = 0;
+    thread_local uint32_t* counter = nullptr;
+    uint32_t current = Simulator::GetPartitionId();
+    if (counter == nullptr || current != partition)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        partition = current;
+        counter = &counters[current];
+    }
+    return *counter;
+}
+#else
 static uint64_t g_nextStreamIndex = 0;
+#endif
 /**
  * \relates RngSeedManager
  * \anchor GlobalValueRngSeed
@@ -107,9 +145,14 @@ uint64_t
 RngSeedManager::GetNextStreamIndex()
 {
     NS_LOG_FUNCTION_NOARGS();
+#ifdef NS3_MTP
+    // The system id of the partition in the upper 32 bits
+    return static_cast<uint64_t>(Simulator::GetPartitionId()) << 32 | GetPartitionStreamIndex()++;
+#else
     uint64_t next = g_nextStreamIndex;
     g_nextStreamIndex++;
     return next;
+#endif
 }
 
 } // namespace ns3
@@ -40,4 +40,10 @@ SimulatorImpl::GetTypeId()
     return tid;
 }
 
+uint32_t
+SimulatorImpl::GetPartitionId() const
+{
+    return GetSystemId();
+}
+
 } // namespace ns3
@@ -96,6 +96,12 @@ class SimulatorImpl : public Object
     virtual void SetScheduler(ObjectFactory schedulerFactory) = 0;
     /** \copydoc Simulator::GetSystemId */
     virtual uint32_t GetSystemId() const = 0;
+    /**
+     * \copydoc Simulator::GetPartitionId
+     *
+     * The default implementation returns GetSystemId().
+     */
+    virtual uint32_t GetPartitionId() const;
     /** \copydoc Simulator::GetContext */
     virtual uint32_t GetContext() const = 0;
     /** \copydoc Simulator::GetEventCount */
@@ -18,27 +18,41 @@
  */
 #include "simulator.h"
 
+#include "abort.h"
 #include "assert.h"
 #include "des-metrics.h"
 #include "event-impl.h"
+#include "fork-impl.h"
 #include "global-value.h"
 #include "log.h"
 #include "map-scheduler.h"
 #include "object-factory.h"
 #include "ptr.h"
+#include "random-variable-stream.h"
+#include "rng-seed-manager.h"
 #include "scheduler.h"
 #include "simulator-impl.h"
 #include "string.h"
 
 #include "ns3/core-config.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <list>
+#include <set>
+#include <thread>
 #include <vector>
 
+#ifndef __WIN32__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 /**
  * \file
  * \ingroup simulator
@@ -55,6 +69,7 @@ namespace ns3
 NS_LOG_COMPONENT_DEFINE("Simulator");
 
 EventId Simulator::m_stopEvent;
+uint32_t Simulator::m_forkIndex = Simulator::NO_FORK;
 
 /**
  * \ingroup simulator
@@ -341,6 +356,129 @@ Simulator::GetSystemId()
     }
 }
 
+uint32_t
+Simulator::GetPartitionId()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    if (*PeekImpl() != nullptr)
+    {
+        return GetImpl()->GetPartitionId();
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+EventId
+Simulator::ForkAt(const Time& time,
+                  uint32_t children,
+                  const Callback<void, uint32_t>& setup,
+                  uint32_t parallel)
+{
+    NS_LOG_FUNCTION(time << children << parallel);
+    NS_ASSERT_MSG(time >= Now(), "Simulator::ForkAt(): fork in the past");
+    if (parallel == 0)
+    {
+        parallel = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return Schedule(time - Now(), &Simulator::DoFork, children, setup, parallel);
+}
+
+void
+Simulator::DoFork(uint32_t children, Callback<void, uint32_t> setup, uint32_t parallel)
+{
+    NS_LOG_FUNCTION(children << parallel);
+#ifdef __WIN32__
+    NS_FATAL_ERROR("Simulator::ForkAt(): fork() is not available on this platform");
+#else
+    // Only the thread calling fork() runs in the children
+    std::string threads = ForkImpl::GetThreads();
+    NS_ABORT_MSG_IF(!threads.empty(),
+                    "Simulator::ForkAt(): cannot fork while threads are running: " << threads);
+
+    // The children must not write the data buffered by the parent again
+    ForkImpl::PrepareFork();
+    uint64_t run = RngSeedManager::GetRun();
+
+    std::set<pid_t> running;
+    uint32_t failed = 0;
+    // Wait for one of the children forked here to exit, the other
+    // children of the process are left to their owner
+    auto wait = [&running, &failed]() {
+        siginfo_t info;
+        if (waitid(P_ALL, 0, &info, WEXITED | WNOWAIT) < 0)
+        {
+            NS_ABORT_MSG_UNLESS(errno == EINTR,
+                                "Simulator::ForkAt(): waitid() failed: " << std::strerror(errno));
+            return;
+        }
+        int status;
+        pid_t pid = 0;
+        for (auto it = running.begin(); it != running.end() && pid == 0; ++it)
+        {
+            pid = waitpid(*it, &status, WNOHANG);
+        }
+        if (pid == 0)
+        {
+            // Another child exited, and stays unreaped
+            pid = waitpid(*running.begin(), &status, 0);
+        }
+        if (pid < 0)
+        {
+            NS_ABORT_MSG_UNLESS(errno == EINTR,
+                                "Simulator::ForkAt(): waitpid() failed: " << std::strerror(errno));
+            return;
+        }
+        running.erase(pid);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            NS_LOG_WARN("child " << pid << " failed");
+            ++failed;
+        }
+    };
+
+    for (uint32_t i = 0; i < children; ++i)
+    {
+        while (running.size() == parallel)
+        {
+            wait();
+        }
+        pid_t pid = fork();
+        NS_ABORT_MSG_IF(pid < 0, "Simulator::ForkAt(): fork() failed: " << std::strerror(errno));
+        if (pid == 0)
+        {
+            m_forkIndex = i;
+            ForkImpl::ReopenFiles(i);
+            RngSeedManager::SetRun(run + 1 + i);
+            if (!setup.IsNull())
+            {
+                setup(i);
+            }
+            RandomVariableStream::ReseedAll();
+            return;
+        }
+        NS_LOG_LOGIC("child " << i << " is process " << pid);
+        running.insert(pid);
+    }
+    while (!running.empty())
+    {
+        wait();
+    }
+
+    m_forkIndex = FORK_PARENT;
+    NS_ABORT_MSG_IF(failed > 0, "Simulator::ForkAt(): " << failed << " children failed");
+    Stop();
+#endif
+}
+
+uint32_t
+Simulator::GetForkIndex()
+{
+    return m_forkIndex;
+}
+
 void
 Simulator::SetImplementation(Ptr<SimulatorImpl> impl)
 {
@@ -20,6 +20,7 @@
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include "callback.h"
 #include "event-id.h"
 #include "event-impl.h"
 #include "make-event.h"
@@ -507,6 +508,77 @@ class Simulator
      */
     static uint32_t GetSystemId();
 
+    /**
+     * Get the system id of the partition running the current event.
+     *
+     * The same as GetSystemId(), unless the simulator runs several
+     * partitions in this process, e.g., MultithreadedSimulatorImpl.
+     * @return The system id of the current partition.
+     */
+    static uint32_t GetPartitionId();
+
+    /**
+     * Fork the simulation into processes which share its past.
+     *
+     * At \p time, the process forks \p children copies of itself, which
+     * share the memory of the simulation copy-on-write, and continue it
+     * from there. This saves a long warm-up common to the points of a
+     * parameter sweep:
+     *
+     * - Each child gets its index, returned by GetForkIndex(), and the
+     *   run number of the parent plus one plus its index, so the child
+     *   \c i draws from the substream of the run \c run+1+i.
+     * - \p setup is then called in the child with its index, to change
+     *   the attributes, the run number, or to schedule new events.
+     * - All the existing random variable streams are then reseeded on
+     *   the run number of the child, see RandomVariableStream::ReseedAll().
+     * - The trace files registered with ForkImpl::RegisterFile(), which
+     *   include the OutputStreamWrapper and PcapFileWrapper files, are
+     *   flushed before the fork. Each child continues writing to a copy,
+     *   named by ForkImpl::GetChildFilename(): \c trace-fork2.pcap holds
+     *   the whole trace of the child 2.
+     *
+     * The parent only runs at most \p parallel children at once, waits
+     * for them, and stops its simulation: GetForkIndex() then returns
+     * FORK_PARENT. It aborts if a child did not exit successfully.
+     *
+     * The fork only copies the calling thread: the simulator
+     * implementation must run the events in the main thread, and there
+     * should be no other thread using the simulation, such as the
+     * reader threads of the emulation devices. fork() is not available
+     * on Windows.
+     *
+     * @param [in] time The absolute time of the fork.
+     * @param [in] children The number of processes to fork.
+     * @param [in] setup The function called in each child with its index.
+     * @param [in] parallel The number of children running at once, or 0
+     *             for the number of hardware threads.
+     * @returns The id of the fork event.
+     */
+    static EventId ForkAt(const Time& time,
+                          uint32_t children,
+                          const Callback<void, uint32_t>& setup,
+                          uint32_t parallel = 0);
+
+    /**
+     * Get the index of this process among the processes forked by
+     * ForkAt().
+     * @returns The index, NO_FORK if the process was not forked, or
+     *          FORK_PARENT in the parent after its children exited.
+     */
+    static uint32_t GetForkIndex();
+
+    /**
+     * Fork index enum values.
+     */
+    enum : uint32_t
+    {
+        /** The process was not forked by ForkAt(). */
+        NO_FORK = 0xffffffff,
+        /** The process forked its children and waited for them. */
+        FORK_PARENT = 0xfffffffe
+    };
+
   private:
     /**
      * Implementation of the various Schedule methods.
@@ -528,11 +600,22 @@ class Simulator
      */
     static EventId DoScheduleDestroy(EventImpl* event);
 
+    /**
+     * Implementation of ForkAt(), at the time of the fork.
+     * @param [in] children The number of processes to fork.
+     * @param [in] setup The function called in each child with its index.
+     * @param [in] parallel The number of children running at once.
+     */
+    static void DoFork(uint32_t children, Callback<void, uint32_t> setup, uint32_t parallel);
+
     /**
      * Stop event (if present)
      */
     static EventId m_stopEvent;
 
+    /** The index of this process among the forked processes. */
+    static uint32_t m_forkIndex;
+
 }; // class Simulator
 
 /**
@@ -291,6 +291,8 @@ void
 WallClockSynchronizer::DoSetCondition(bool cond)
 {
     NS_LOG_FUNCTION(this << cond);
+    // Signal() may be called by another thread, outside the simulator lock
+    std::unique_lock<std::mutex> lock(m_mutex);
     m_condition = cond;
 }
 
@@ -0,0 +1,199 @@
+#include "ns3/event-allocator.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup events
+ * \ingroup event-allocator-tests
+ * EventAllocator test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup event-allocator-tests EventAllocator test suite
+ */
+
+namespace ns3
+{
+
+namespace tests
+{
+
+/**
+ * \ingroup event-allocator-tests
+ * The blocks of a size class are reused, aligned, and the large blocks
+ * come from the system allocator.
+ */
+class EventAllocatorBlocksTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    EventAllocatorBlocksTestCase();
+    void DoRun() override;
+};
+
+EventAllocatorBlocksTestCase::EventAllocatorBlocksTestCase()
+    : TestCase("Blocks")
+{
+}
+
+void
+EventAllocatorBlocksTestCase::DoRun()
+{
+    void* a = EventAllocator::Allocate(24);
+    void* b = EventAllocator::Allocate(40);
+    NS_TEST_EXPECT_MSG_NE(a, b, "same block for two sizes");
+    NS_TEST_EXPECT_MSG_EQ(reinterpret_cast<uintptr_t>(a) % EventAllocator::GRANULARITY,
+                          0,
+                          "block not aligned");
+    NS_TEST_EXPECT_MSG_EQ(reinterpret_cast<uintptr_t>(b) % EventAllocator::GRANULARITY,
+                          0,
+                          "block not aligned");
+    EventAllocator::Deallocate(a, 24);
+    void* c = EventAllocator::Allocate(17);
+    NS_TEST_EXPECT_MSG_EQ(c, a, "block of the size class not reused");
+    EventAllocator::Deallocate(c, 17);
+    EventAllocator::Deallocate(b, 40);
+
+    uint64_t large = EventAllocator::GetLargeCount();
+    void* d = EventAllocator::Allocate(EventAllocator::MAX_SIZE + 1);
+    NS_TEST_EXPECT_MSG_EQ(EventAllocator::GetLargeCount(), large + 1, "large block not counted");
+    EventAllocator::Deallocate(d, EventAllocator::MAX_SIZE + 1);
+}
+
+/**
+ * \ingroup event-allocator-tests
+ * The blocks freed by another thread are reused without new slabs.
+ */
+class EventAllocatorThreadsTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    EventAllocatorThreadsTestCase();
+    void DoRun() override;
+};
+
+EventAllocatorThreadsTestCase::EventAllocatorThreadsTestCase()
+    : TestCase("Blocks freed by another thread")
+{
+}
+
+void
+EventAllocatorThreadsTestCase::DoRun()
+{
+    const std::size_t size = 200;
+    const std::size_t count = 2000;
+    std::vector<void*> blocks(count);
+    std::thread producer([&blocks, size]() {
+        for (auto& block : blocks)
+        {
+            block = EventAllocator::Allocate(size);
+        }
+    });
+    producer.join();
+    uint64_t slabs = EventAllocator::GetSlabCount();
+
+    for (auto block : blocks)
+    {
+        EventAllocator::Deallocate(block, size);
+    }
+    for (auto& block : blocks)
+    {
+        block = EventAllocator::Allocate(size);
+    }
+    NS_TEST_EXPECT_MSG_EQ(EventAllocator::GetSlabCount(), slabs, "freed blocks not reused");
+    for (auto block : blocks)
+    {
+        EventAllocator::Deallocate(block, size);
+    }
+}
+
+/**
+ * \ingroup event-allocator-tests
+ * A simulation keeping a constant number of pending events reaches a
+ * steady state: no slab is allocated once the population is built.
+ */
+class EventAllocatorSimulationTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    EventAllocatorSimulationTestCase();
+    void DoRun() override;
+
+  private:
+    /**
+     * Event rescheduling itself.
+     * \param [in] value An argument bound to the event.
+     */
+    void Reschedule(uint64_t value);
+
+    uint64_t m_count; //!< The number of events run.
+    uint64_t m_slabs; //!< The slab count once the population is built.
+};
+
+EventAllocatorSimulationTestCase::EventAllocatorSimulationTestCase()
+    : TestCase("Steady state of a simulation")
+{
+}
+
+void
+EventAllocatorSimulationTestCase::Reschedule(uint64_t value)
+{
+    if (++m_count == 1000)
+    {
+        m_slabs = EventAllocator::GetSlabCount();
+    }
+    if (m_count < 100000)
+    {
+        Simulator::Schedule(NanoSeconds(1 + value % 1000),
+                            &EventAllocatorSimulationTestCase::Reschedule,
+                            this,
+                            value * 6364136223846793005ULL + 1);
+    }
+}
+
+void
+EventAllocatorSimulationTestCase::DoRun()
+{
+    m_count = 0;
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        Simulator::Schedule(NanoSeconds(i), &EventAllocatorSimulationTestCase::Reschedule, this, i);
+    }
+    Simulator::Run();
+    Simulator::Destroy();
+    NS_TEST_EXPECT_MSG_EQ(m_count, 100999, "wrong number of events");
+    NS_TEST_EXPECT_MSG_EQ(EventAllocator::GetSlabCount(), m_slabs, "slabs in the steady state");
+}
+
+/**
+ * \ingroup event-allocator-tests
+ * EventAllocator test suite.
+ */
+class EventAllocatorTestSuite : public TestSuite
+{
+  public:
+    EventAllocatorTestSuite()
+        : TestSuite("event-allocator")
+    {
+        AddTestCase(new EventAllocatorBlocksTestCase());
+        AddTestCase(new EventAllocatorThreadsTestCase());
+        AddTestCase(new EventAllocatorSimulationTestCase());
+    }
+};
+
+/**
+ * \ingroup event-allocator-tests
+ * EventAllocatorTestSuite instance variable.
+ */
+static EventAllocatorTestSuite g_eventAllocatorTestSuite;
+
+} // namespace tests
+
+} // namespace ns3
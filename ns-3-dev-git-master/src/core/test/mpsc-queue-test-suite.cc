@@ -0,0 +1,273 @@
+#include "ns3/mpsc-queue.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup events
+ * \ingroup mpsc-queue-tests
+ * MpscQueue test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup mpsc-queue-tests MpscQueue test suite
+ */
+
+namespace ns3
+{
+
+namespace tests
+{
+
+/**
+ * \ingroup mpsc-queue-tests
+ * An item pushed by a producer.
+ */
+struct MpscItem
+{
+    uint32_t producer; //!< The producer.
+    uint32_t index;    //!< The rank of the item among those of the producer.
+};
+
+/**
+ * \ingroup mpsc-queue-tests
+ * The items are drained in order, past the capacity of the ring.
+ */
+class MpscQueueOrderTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    MpscQueueOrderTestCase();
+    void DoRun() override;
+};
+
+MpscQueueOrderTestCase::MpscQueueOrderTestCase()
+    : TestCase("Order and overflow")
+{
+}
+
+void
+MpscQueueOrderTestCase::DoRun()
+{
+    MpscQueue<uint32_t> queue(4);
+    NS_TEST_EXPECT_MSG_EQ(queue.IsEmpty(), true, "new queue not empty");
+
+    for (uint32_t round = 0; round < 3; ++round)
+    {
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            queue.Push(i);
+        }
+        NS_TEST_EXPECT_MSG_EQ(queue.IsEmpty(), false, "items not seen");
+        std::vector<uint32_t> items;
+        queue.Drain([&items](uint32_t i) { items.push_back(i); });
+        NS_TEST_EXPECT_MSG_EQ(queue.IsEmpty(), true, "queue not empty after Drain");
+        NS_TEST_ASSERT_MSG_EQ(items.size(), 10, "items lost");
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            NS_TEST_EXPECT_MSG_EQ(items[i], i, "items out of order");
+        }
+        NS_TEST_EXPECT_MSG_EQ(queue.GetOverflowCount(), 6 * (round + 1), "wrong overflow");
+    }
+}
+
+/**
+ * \ingroup mpsc-queue-tests
+ * The items of concurrent producers are all drained, in the order of
+ * each producer.
+ */
+class MpscQueueProducersTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    MpscQueueProducersTestCase();
+    void DoRun() override;
+};
+
+MpscQueueProducersTestCase::MpscQueueProducersTestCase()
+    : TestCase("Concurrent producers")
+{
+}
+
+void
+MpscQueueProducersTestCase::DoRun()
+{
+    const uint32_t producers = 4;
+    const uint32_t count = 20000;
+    MpscQueue<MpscItem> queue(16);
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&queue, &go, p, count]() {
+            while (!go)
+            {
+                std::this_thread::yield();
+            }
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                queue.Push({p, i});
+            }
+        });
+    }
+
+    std::vector<uint32_t> next(producers, 0);
+    uint32_t received = 0;
+    bool ordered = true;
+    go = true;
+    while (received < producers * count)
+    {
+        queue.Drain([&next, &received, &ordered](const MpscItem& item) {
+            ordered = ordered && item.index == next[item.producer];
+            next[item.producer] = item.index + 1;
+            ++received;
+        });
+        std::this_thread::yield();
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    NS_TEST_EXPECT_MSG_EQ(ordered, true, "items of a producer out of order");
+    NS_TEST_EXPECT_MSG_EQ(queue.IsEmpty(), true, "items left");
+    for (uint32_t p = 0; p < producers; ++p)
+    {
+        NS_TEST_EXPECT_MSG_EQ(next[p], count, "items lost");
+    }
+}
+
+/**
+ * \ingroup mpsc-queue-tests
+ * The events scheduled by other threads while the simulation runs all
+ * run, in the order of each thread.
+ */
+class MpscQueueSimulatorTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor.
+     * \param [in] impl The SimulatorImpl TypeId name.
+     */
+    MpscQueueSimulatorTestCase(std::string impl);
+    void DoRun() override;
+
+  private:
+    /**
+     * An event scheduled by another thread.
+     * \param [in] index The rank of the event among those of the thread.
+     */
+    void Receive(uint32_t index);
+    /** Keep the simulation alive until all the events have run. */
+    void Poll();
+
+    std::string m_impl;           //!< The SimulatorImpl TypeId name.
+    std::atomic<bool> m_go;       //!< Whether the threads may start.
+    std::vector<uint32_t> m_next; //!< The next index expected from each thread.
+    uint32_t m_received;          //!< The number of events run.
+    bool m_ordered;               //!< Whether the events of each thread ran in order.
+
+    static constexpr uint32_t THREADS = 3;   //!< The number of threads.
+    static constexpr uint32_t COUNT = 10000; //!< The number of events of a thread.
+};
+
+MpscQueueSimulatorTestCase::MpscQueueSimulatorTestCase(std::string impl)
+    : TestCase("Events from other threads with " + impl),
+      m_impl(impl)
+{
+}
+
+void
+MpscQueueSimulatorTestCase::Receive(uint32_t index)
+{
+    uint32_t context = Simulator::GetContext();
+    m_ordered = m_ordered && index == m_next[context];
+    m_next[context] = index + 1;
+    if (++m_received == THREADS * COUNT)
+    {
+        Simulator::Stop();
+    }
+}
+
+void
+MpscQueueSimulatorTestCase::Poll()
+{
+    m_go = true;
+    Simulator::Schedule(MicroSeconds(10), &MpscQueueSimulatorTestCase::Poll, this);
+}
+
+void
+MpscQueueSimulatorTestCase::DoRun()
+{
+    ObjectFactory factory;
+    factory.SetTypeId(m_impl);
+    Simulator::SetImplementation(factory.Create<SimulatorImpl>());
+
+    m_go = false;
+    m_next.assign(THREADS, 0);
+    m_received = 0;
+    m_ordered = true;
+    Simulator::Schedule(Time(0), &MpscQueueSimulatorTestCase::Poll, this);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < THREADS; ++t)
+    {
+        threads.emplace_back([this, t]() {
+            while (!m_go)
+            {
+                std::this_thread::yield();
+            }
+            for (uint32_t i = 0; i < COUNT; ++i)
+            {
+                Simulator::ScheduleWithContext(t,
+                                               Time(0),
+                                               &MpscQueueSimulatorTestCase::Receive,
+                                               this,
+                                               i);
+            }
+        });
+    }
+    Simulator::Run();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_received, THREADS * COUNT, "events lost");
+    NS_TEST_EXPECT_MSG_EQ(m_ordered, true, "events of a thread out of order");
+}
+
+/**
+ * \ingroup mpsc-queue-tests
+ * MpscQueue test suite.
+ */
+class MpscQueueTestSuite : public TestSuite
+{
+  public:
+    MpscQueueTestSuite()
+        : TestSuite("mpsc-queue")
+    {
+        AddTestCase(new MpscQueueOrderTestCase());
+        AddTestCase(new MpscQueueProducersTestCase());
+        AddTestCase(new MpscQueueSimulatorTestCase("ns3::DefaultSimulatorImpl"));
+        AddTestCase(new MpscQueueSimulatorTestCase("ns3::RealtimeSimulatorImpl"));
+    }
+};
+
+/**
+ * \ingroup mpsc-queue-tests
+ * MpscQueueTestSuite instance variable.
+ */
+static MpscQueueTestSuite g_mpscQueueTestSuite;
+
+} // namespace tests
+
+} // namespace ns3
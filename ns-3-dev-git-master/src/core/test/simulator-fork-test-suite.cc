@@ -0,0 +1,261 @@
+#include "ns3/fork-impl.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef __WIN32__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup simulator
+ * \ingroup simulator-fork-tests
+ * Simulator::ForkAt() test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup simulator-fork-tests Simulator::ForkAt() test suite
+ */
+
+namespace ns3
+{
+
+namespace tests
+{
+
+/**
+ * \ingroup simulator-fork-tests
+ * The names of the copies of the files.
+ */
+class ForkFilenameTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    ForkFilenameTestCase();
+    void DoRun() override;
+};
+
+ForkFilenameTestCase::ForkFilenameTestCase()
+    : TestCase("Names of the copies of the files")
+{
+}
+
+void
+ForkFilenameTestCase::DoRun()
+{
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetChildFilename("trace.pcap", 2),
+                          "trace-fork2.pcap",
+                          "wrong name");
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetChildFilename("out/a-0-1.tr", 0),
+                          "out/a-0-1-fork0.tr",
+                          "wrong name");
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetChildFilename("out.d/trace", 1),
+                          "out.d/trace-fork1",
+                          "wrong name");
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetChildFilename("out/.trace", 1),
+                          "out/.trace-fork1",
+                          "wrong name");
+}
+
+/**
+ * \ingroup simulator-fork-tests
+ * The objects running threads, which forbid a fork.
+ */
+class ForkThreadsTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    ForkThreadsTestCase();
+    void DoRun() override;
+};
+
+ForkThreadsTestCase::ForkThreadsTestCase()
+    : TestCase("Objects running threads")
+{
+}
+
+void
+ForkThreadsTestCase::DoRun()
+{
+    int first;
+    int second;
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetThreads(), "", "threads before any registration");
+    ForkImpl::RegisterThread(&first, "first");
+    ForkImpl::RegisterThread(&second, "second");
+    std::string threads = ForkImpl::GetThreads();
+    NS_TEST_EXPECT_MSG_NE(threads.find("first"), std::string::npos, "first not registered");
+    NS_TEST_EXPECT_MSG_NE(threads.find("second"), std::string::npos, "second not registered");
+    ForkImpl::UnregisterThread(&first);
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetThreads(), "second", "first not unregistered");
+    ForkImpl::UnregisterThread(&second);
+    NS_TEST_EXPECT_MSG_EQ(ForkImpl::GetThreads(), "", "second not unregistered");
+}
+
+/**
+ * \ingroup simulator-fork-tests
+ * The children continue the simulation with their own index, random
+ * draws and copy of the trace file; the parent stops at the fork, and
+ * leaves the children it did not fork unreaped.
+ */
+class ForkSimulationTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    ForkSimulationTestCase();
+    void DoRun() override;
+
+  private:
+    /** Write a line of trace every second. */
+    void Tick();
+    /**
+     * Set up a child.
+     * \param [in] index The index of the child.
+     */
+    void Setup(uint32_t index);
+
+    std::ofstream m_trace;               //!< The trace file.
+    Ptr<UniformRandomVariable> m_random; //!< A stream created before the fork.
+    uint32_t m_setup;                    //!< The index the setup was called with.
+
+    static constexpr uint32_t CHILDREN = 3; //!< The number of children.
+};
+
+ForkSimulationTestCase::ForkSimulationTestCase()
+    : TestCase("Children of a fork")
+{
+}
+
+void
+ForkSimulationTestCase::Tick()
+{
+    m_trace << Simulator::Now().GetSeconds();
+    if (Simulator::GetForkIndex() != Simulator::NO_FORK)
+    {
+        m_trace << " child " << Simulator::GetForkIndex() << " value "
+                << m_random->GetInteger(0, 1000000);
+    }
+    m_trace << std::endl;
+    Simulator::Schedule(Seconds(1), &ForkSimulationTestCase::Tick, this);
+}
+
+void
+ForkSimulationTestCase::Setup(uint32_t index)
+{
+    m_setup = index;
+}
+
+void
+ForkSimulationTestCase::DoRun()
+{
+#ifndef __WIN32__
+    std::string filename = CreateTempDirFilename("fork-trace.txt");
+    m_trace.open(filename);
+    ForkImpl::RegisterFile(m_trace.rdbuf(), filename, std::ios::out);
+    m_random = CreateObject<UniformRandomVariable>();
+    m_random->GetValue();
+    m_setup = Simulator::NO_FORK;
+
+    // A child of the process, not forked by the simulator
+    pid_t foreign = fork();
+    if (foreign == 0)
+    {
+        _exit(0);
+    }
+
+    Simulator::Schedule(Seconds(0), &ForkSimulationTestCase::Tick, this);
+    Simulator::ForkAt(Seconds(1.5),
+                      CHILDREN,
+                      MakeCallback(&ForkSimulationTestCase::Setup, this),
+                      2);
+    Simulator::Stop(Seconds(3.5));
+    Simulator::Run();
+    Simulator::Destroy();
+    ForkImpl::UnregisterFile(m_trace.rdbuf());
+    m_trace.close();
+
+    uint32_t index = Simulator::GetForkIndex();
+    if (index != Simulator::FORK_PARENT)
+    {
+        // A child: report the setup through the exit status, and do not
+        // return to the test runner.
+        _exit(index < CHILDREN && m_setup == index ? 0 : 1);
+    }
+
+    int status;
+    NS_TEST_EXPECT_MSG_EQ(waitpid(foreign, &status, 0), foreign, "a foreign child was reaped");
+
+    std::ifstream parent(filename);
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(parent, line))
+    {
+        lines.push_back(line);
+    }
+    NS_TEST_ASSERT_MSG_EQ(lines.size(), 2, "the parent ran past the fork");
+    NS_TEST_EXPECT_MSG_EQ(lines[0], "0", "wrong trace before the fork");
+    NS_TEST_EXPECT_MSG_EQ(lines[1], "1", "wrong trace before the fork");
+
+    std::set<std::string> draws;
+    for (uint32_t i = 0; i < CHILDREN; ++i)
+    {
+        std::ifstream child(ForkImpl::GetChildFilename(filename, i));
+        std::vector<std::string> childLines;
+        while (std::getline(child, line))
+        {
+            childLines.push_back(line);
+        }
+        NS_TEST_ASSERT_MSG_EQ(childLines.size(), 4, "wrong trace of child " << i);
+        NS_TEST_EXPECT_MSG_EQ(childLines[0], "0", "trace before the fork not copied");
+        NS_TEST_EXPECT_MSG_EQ(childLines[1], "1", "trace before the fork not copied");
+        for (uint32_t t = 2; t < 4; ++t)
+        {
+            std::istringstream iss(childLines[t]);
+            uint32_t time;
+            std::string word;
+            uint32_t childIndex;
+            std::string value;
+            iss >> time >> word >> childIndex >> word >> value;
+            NS_TEST_EXPECT_MSG_EQ(time, t, "wrong time in child " << i);
+            NS_TEST_EXPECT_MSG_EQ(childIndex, i, "wrong index in child " << i);
+            draws.insert(value);
+        }
+    }
+    NS_TEST_EXPECT_MSG_EQ(draws.size(), 2 * CHILDREN, "children drew the same values");
+#endif
+}
+
+/**
+ * \ingroup simulator-fork-tests
+ * Simulator::ForkAt() test suite.
+ */
+class SimulatorForkTestSuite : public TestSuite
+{
+  public:
+    SimulatorForkTestSuite()
+        : TestSuite("simulator-fork")
+    {
+        AddTestCase(new ForkFilenameTestCase());
+        AddTestCase(new ForkThreadsTestCase());
+        AddTestCase(new ForkSimulationTestCase());
+    }
+};
+
+/**
+ * \ingroup simulator-fork-tests
+ * SimulatorForkTestSuite instance variable.
+ */
+static SimulatorForkTestSuite g_simulatorForkTestSuite;
+
+} // namespace tests
+
+} // namespace ns3
@@ -18,12 +18,16 @@
  */
 #include "ns3/calendar-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/priority-queue-scheduler.h"
 #include "ns3/simulator.h"
 #include "ns3/test.h"
 
+#include <set>
+#include <vector>
+
 using namespace ns3;
 
 /**
@@ -707,6 +711,125 @@ SimulatorTemplateTestCase::DoRun()
     Simulator::Destroy();
 }
 
+/**
+ * \ingroup simulator-tests
+ *
+ * \brief Check a scheduler against a sorted set, with a random mix of
+ * insertions, removals and cancellations and a skewed time distribution:
+ * bursts of events at the same time and a few events in the far future.
+ */
+class SchedulerRandomTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor.
+     * \param schedulerFactory Scheduler factory.
+     */
+    SchedulerRandomTestCase(ObjectFactory schedulerFactory);
+    void DoRun() override;
+
+  private:
+    /**
+     * Draw a pseudo-random number.
+     * \return The number.
+     */
+    uint32_t Random();
+
+    ObjectFactory m_schedulerFactory; //!< Scheduler factory.
+    uint64_t m_state;                 //!< Random generator state.
+};
+
+SchedulerRandomTestCase::SchedulerRandomTestCase(ObjectFactory schedulerFactory)
+    : TestCase("Check random operations on " + schedulerFactory.GetTypeId().GetName()),
+      m_schedulerFactory(schedulerFactory),
+      m_state(1)
+{
+}
+
+uint32_t
+SchedulerRandomTestCase::Random()
+{
+    m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return m_state >> 33;
+}
+
+void
+SchedulerRandomTestCase::DoRun()
+{
+    Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler>();
+    std::set<Scheduler::EventKey> reference;
+    std::vector<Scheduler::EventKey> pending;
+    uint64_t now = 0;
+    uint32_t uid = 0;
+
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        uint32_t op = Random() % 10;
+        if (op < 6 || pending.empty())
+        {
+            uint64_t delay;
+            uint32_t kind = Random() % 10;
+            if (kind < 5)
+            {
+                delay = Random() % 100;
+            }
+            else if (kind < 8)
+            {
+                delay = 0;
+            }
+            else if (kind < 9)
+            {
+                delay = Random() % 1000000;
+            }
+            else
+            {
+                delay = 1000000000000ULL + Random();
+            }
+            Scheduler::Event ev = {nullptr, {now + delay, uid++, 0}};
+            scheduler->Insert(ev);
+            reference.insert(ev.key);
+            pending.push_back(ev.key);
+        }
+        else if (op < 9)
+        {
+            Scheduler::EventKey expected = *reference.begin();
+            NS_TEST_ASSERT_MSG_EQ(scheduler->PeekNext().key.m_uid, expected.m_uid, "wrong next");
+            Scheduler::Event next = scheduler->RemoveNext();
+            NS_TEST_ASSERT_MSG_EQ(next.key.m_uid, expected.m_uid, "wrong next removed");
+            NS_TEST_ASSERT_MSG_EQ(next.key.m_ts, expected.m_ts, "wrong time stamp");
+            reference.erase(reference.begin());
+            now = next.key.m_ts;
+            for (auto& key : pending)
+            {
+                if (key.m_uid == next.key.m_uid)
+                {
+                    key = pending.back();
+                    pending.pop_back();
+                    break;
+                }
+            }
+        }
+        else
+        {
+            std::size_t index = Random() % pending.size();
+            Scheduler::Event ev = {nullptr, pending[index]};
+            scheduler->Remove(ev);
+            reference.erase(ev.key);
+            pending[index] = pending.back();
+            pending.pop_back();
+        }
+        NS_TEST_ASSERT_MSG_EQ(scheduler->IsEmpty(), reference.empty(), "wrong emptiness");
+    }
+
+    while (!reference.empty())
+    {
+        Scheduler::Event next = scheduler->RemoveNext();
+        NS_TEST_ASSERT_MSG_EQ(next.key.m_uid, reference.begin()->m_uid, "wrong next removed");
+        reference.erase(reference.begin());
+    }
+    NS_TEST_EXPECT_MSG_EQ(scheduler->IsEmpty(), true, "scheduler not empty");
+}
+
 /**
  * \ingroup simulator-tests
  *
@@ -730,6 +853,18 @@ class SimulatorTestSuite : public TestSuite
         AddTestCase(new SimulatorEventsTestCase(factory), TestCase::QUICK);
         factory.SetTypeId(PriorityQueueScheduler::GetTypeId());
         AddTestCase(new SimulatorEventsTestCase(factory), TestCase::QUICK);
+        factory.SetTypeId(LadderScheduler::GetTypeId());
+        AddTestCase(new SimulatorEventsTestCase(factory), TestCase::QUICK);
+
+        for (const auto& tid : {MapScheduler::GetTypeId(),
+                                HeapScheduler::GetTypeId(),
+                                CalendarScheduler::GetTypeId(),
+                                PriorityQueueScheduler::GetTypeId(),
+                                LadderScheduler::GetTypeId()})
+        {
+            factory.SetTypeId(tid);
+            AddTestCase(new SchedulerRandomTestCase(factory), TestCase::QUICK);
+        }
     }
 };
 
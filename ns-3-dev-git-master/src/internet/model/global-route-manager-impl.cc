@@ -32,6 +32,7 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "ns3/node-list.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/simulator.h"
 
 #include <algorithm>
@@ -696,6 +697,12 @@ GlobalRouteManagerImpl::InitializeRoutes()
     // Walk the list of nodes in the system.
     //
     NS_LOG_INFO("About to start SPF calculation");
+    // The multithreaded simulator runs the nodes of all the system ids
+    bool allSystems = false;
+#ifdef NS3_MTP
+    allSystems = Simulator::GetImplementation()->GetInstanceTypeId().GetName() ==
+                 "ns3::MultithreadedSimulatorImpl";
+#endif
     for (auto i = NodeList::Begin(); i != NodeList::End(); i++)
     {
         Ptr<Node> node = *i;
@@ -707,7 +714,7 @@ GlobalRouteManagerImpl::InitializeRoutes()
 
         uint32_t systemId = Simulator::GetSystemId();
         // Ignore nodes that are not assigned to our systemId (distributed sim)
-        if (node->GetSystemId() != systemId)
+        if (node->GetSystemId() != systemId && !allSystems)
         {
             continue;
         }
@@ -665,8 +665,10 @@ Ipv6ExtensionSegmentRoutingHeader::GetInstanceTypeId() const
 }
 
 Ipv6ExtensionSegmentRoutingHeader::Ipv6ExtensionSegmentRoutingHeader()
-    : m_routersSegments(0)
+    : m_flags(0),
+      m_tag(0)
 {
+    SetTypeRouting(4);
 }
 
 Ipv6ExtensionSegmentRoutingHeader::~Ipv6ExtensionSegmentRoutingHeader()
@@ -676,8 +678,7 @@ Ipv6ExtensionSegmentRoutingHeader::~Ipv6ExtensionSegmentRoutingHeader()
 void
 Ipv6ExtensionSegmentRoutingHeader::SetNumberSegments(uint8_t n)
 {
-    m_routersSegments.clear();
-    m_routersSegments.assign(n, "");
+    m_routersSegments = SegmentList(n, Segment());
 }
 
 void
@@ -689,40 +690,83 @@ Ipv6ExtensionSegmentRoutingHeader::SetRoutersSegment(std::vector<Segment> router
 std::vector<Segment>
 Ipv6ExtensionSegmentRoutingHeader::GetRoutersSegments() const
 {
-    return m_routersSegments;
+    return m_routersSegments.GetVector();
 }
 
 void
 Ipv6ExtensionSegmentRoutingHeader::SetRouterSegment(uint8_t index, Segment addr)
 {
-    m_routersSegments.at(index) = addr;
+    m_routersSegments.Set(index, addr);
 }
 
 Segment
 Ipv6ExtensionSegmentRoutingHeader::GetRouterSegment(uint8_t index) const
 {
-    return m_routersSegments.at(index);
+    return m_routersSegments.Get(index);
+}
+
+void
+Ipv6ExtensionSegmentRoutingHeader::SetSegmentList(const SegmentList& segments)
+{
+    m_routersSegments = segments;
+}
+
+const SegmentList&
+Ipv6ExtensionSegmentRoutingHeader::GetSegmentList() const
+{
+    return m_routersSegments;
+}
+
+uint8_t
+Ipv6ExtensionSegmentRoutingHeader::GetLastEntry() const
+{
+    return m_routersSegments.IsEmpty() ? 0 : m_routersSegments.GetN() - 1;
+}
+
+void
+Ipv6ExtensionSegmentRoutingHeader::SetFlags(uint8_t flags)
+{
+    m_flags = flags;
+}
+
+uint8_t
+Ipv6ExtensionSegmentRoutingHeader::GetFlags() const
+{
+    return m_flags;
+}
+
+void
+Ipv6ExtensionSegmentRoutingHeader::SetTag(uint16_t tag)
+{
+    m_tag = tag;
+}
+
+uint16_t
+Ipv6ExtensionSegmentRoutingHeader::GetTag() const
+{
+    return m_tag;
 }
 
 void
 Ipv6ExtensionSegmentRoutingHeader::Print(std::ostream& os) const
-{/*
+{
     os << "( nextHeader = " << (uint32_t)GetNextHeader() << " length = " << (uint32_t)GetLength()
        << " typeRouting = " << (uint32_t)GetTypeRouting()
-       << " segmentsLeft = " << (uint32_t)GetSegmentsLeft() << " ";
+       << " segmentsLeft = " << (uint32_t)GetSegmentsLeft()
+       << " lastEntry = " << (uint32_t)GetLastEntry() << " tag = " << m_tag << " ";
 
-    for (auto it = m_routersSegments.begin(); it != m_routersSegments.end(); it++)
+    for (const Segment* it = m_routersSegments.Begin(); it != m_routersSegments.End(); it++)
     {
         os << *it << " ";
     }
 
     os << " )";
-*/}
+}
 
 uint32_t
 Ipv6ExtensionSegmentRoutingHeader::GetSerializedSize() const
 {
-    return 8 + m_routersSegments.size() * 16;
+    return 8 + m_routersSegments.GetN() * 16;
 }
 
 void
@@ -731,15 +775,17 @@ Ipv6ExtensionSegmentRoutingHeader::Serialize(Buffer::Iterator start) const
     Buffer::Iterator i = start;
     uint8_t buff[16];
 
-    uint8_t addressNum = m_routersSegments.size();
+    uint8_t addressNum = m_routersSegments.GetN();
 
     i.WriteU8(GetNextHeader());
     i.WriteU8(addressNum * 2);
     i.WriteU8(GetTypeRouting());
     i.WriteU8(GetSegmentsLeft());
-    i.WriteU32(0);
+    i.WriteU8(GetLastEntry());
+    i.WriteU8(m_flags);
+    i.WriteHtonU16(m_tag);
 
-    for (auto it = m_routersSegments.begin(); it != m_routersSegments.end(); it++)
+    for (const Segment* it = m_routersSegments.Begin(); it != m_routersSegments.End(); it++)
     {
         it->Serialize(buff);
         i.Write(buff, 16);
@@ -756,14 +802,16 @@ Ipv6ExtensionSegmentRoutingHeader::Deserialize(Buffer::Iterator start)
     m_length = i.ReadU8();
     SetTypeRouting(i.ReadU8());
     SetSegmentsLeft(i.ReadU8());
-    i.ReadU32();
+    i.ReadU8(); // Last Entry, implied by the header length
+    m_flags = i.ReadU8();
+    m_tag = i.ReadNtohU16();
 
     uint8_t addressNum = m_length / 2;
-    SetNumberSegments(addressNum);
+    m_routersSegments.Clear();
     for (uint8_t index = 0; index < addressNum; index++)
     {
         i.Read(buff, 16);
-        SetRouterSegment(index, Segment(buff));
+        m_routersSegments.Add(Segment(buff));
     }
 
     return GetSerializedSize();
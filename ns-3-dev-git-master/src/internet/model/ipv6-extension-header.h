@@ -627,7 +627,10 @@ class Ipv6ExtensionType2RoutingHeader : public Ipv6ExtensionRoutingHeader
 /**
  * \ingroup ipv6HeaderExt
  *
- * \brief Header of IPv6 Extension Routing : Type 0 (Segment Routing)
+ * \brief Header of IPv6 Extension Routing : Type 4 (Segment Routing, RFC 8754)
+ *
+ * The SID list is stored in SRH order: index 0 holds the last segment
+ * of the path and the active segment is the one at Segments Left.
  */
 class Ipv6ExtensionSegmentRoutingHeader : public Ipv6ExtensionRoutingHeader
 {
@@ -687,6 +690,48 @@ class Ipv6ExtensionSegmentRoutingHeader : public Ipv6ExtensionRoutingHeader
      */
     Segment GetRouterSegment(uint8_t index) const;
 
+    /**
+     * \brief Set the SID list.
+     * \param segments the SIDs, in SRH order
+     */
+    void SetSegmentList(const SegmentList& segments);
+
+    /**
+     * \brief Get the SID list.
+     * \return the SIDs, in SRH order
+     */
+    const SegmentList& GetSegmentList() const;
+
+    /**
+     * \brief Get the index of the last element of the SID list.
+     * \return the Last Entry field
+     */
+    uint8_t GetLastEntry() const;
+
+    /**
+     * \brief Set the SRH flags.
+     * \param flags the flags
+     */
+    void SetFlags(uint8_t flags);
+
+    /**
+     * \brief Get the SRH flags.
+     * \return the flags
+     */
+    uint8_t GetFlags() const;
+
+    /**
+     * \brief Set the tag used to mark packets as part of a class of packets.
+     * \param tag the tag
+     */
+    void SetTag(uint16_t tag);
+
+    /**
+     * \brief Get the tag.
+     * \return the tag
+     */
+    uint16_t GetTag() const;
+
     /**
      * \brief Print some information about the packet.
      * \param os output stream
@@ -714,14 +759,19 @@ class Ipv6ExtensionSegmentRoutingHeader : public Ipv6ExtensionRoutingHeader
 
   private:
     /**
-     * \brief A vector of IPv6 Address.
+     * \brief The SID list, inline up to SegmentList::INLINE_SEGMENTS.
      */
-    typedef std::vector<Segment> VectorSID_t;
+    SegmentList m_routersSegments;
 
     /**
-     * \brief The vector of Routers' IPv6 Address.
+     * \brief The flags.
+     */
+    uint8_t m_flags;
+
+    /**
+     * \brief The tag.
      */
-    VectorSID_t m_routersSegments;
+    uint16_t m_tag;
 };
 
 
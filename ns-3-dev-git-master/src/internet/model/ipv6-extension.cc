@@ -1208,6 +1208,295 @@ Ipv6ExtensionLooseRouting::Process(Ptr<Packet>& packet,
     return routingHeader.GetSerializedSize();
 }
 
+NS_OBJECT_ENSURE_REGISTERED(Ipv6ExtensionSegmentRouting);
+
+TypeId
+Ipv6ExtensionSegmentRouting::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::Ipv6ExtensionSegmentRouting")
+                            .SetParent<Ipv6ExtensionRouting>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<Ipv6ExtensionSegmentRouting>()
+                            .AddAttribute("CsidBlockLength",
+                                          "Length in bits of the locator block of the "
+                                          "compressed SIDs (NEXT-C-SID flavor), 0 to disable "
+                                          "them. A multiple of 8.",
+                                          UintegerValue(0),
+                                          MakeUintegerAccessor(
+                                              &Ipv6ExtensionSegmentRouting::m_csidBlockLength),
+                                          MakeUintegerChecker<uint8_t>(0, 112))
+                            .AddAttribute("CsidLength",
+                                          "Length in bits of a compressed SID, 16 or 32.",
+                                          UintegerValue(16),
+                                          MakeUintegerAccessor(
+                                              &Ipv6ExtensionSegmentRouting::m_csidLength),
+                                          MakeUintegerChecker<uint8_t>(16, 32));
+    return tid;
+}
+
+Ipv6ExtensionSegmentRouting::Ipv6ExtensionSegmentRouting()
+    : m_csidBlockLength(0),
+      m_csidLength(16)
+{
+}
+
+Ipv6ExtensionSegmentRouting::~Ipv6ExtensionSegmentRouting()
+{
+}
+
+void
+Ipv6ExtensionSegmentRouting::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_localSids.clear();
+    Ipv6ExtensionRouting::DoDispose();
+}
+
+uint8_t
+Ipv6ExtensionSegmentRouting::GetTypeRouting() const
+{
+    return TYPE_ROUTING;
+}
+
+Ipv6ExtensionRoutingHeader*
+Ipv6ExtensionSegmentRouting::GetExtensionRoutingHeaderPtr()
+{
+    return new Ipv6ExtensionSegmentRoutingHeader();
+}
+
+void
+Ipv6ExtensionSegmentRouting::AddLocalSid(Segment sid,
+                                         Behaviour_e behaviour,
+                                         Ipv6Address nextHop,
+                                         uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << sid.GetAddress() << behaviour << nextHop << interface);
+    LocalSid entry;
+    entry.behaviour = behaviour;
+    entry.nextHop = nextHop;
+    entry.interface = interface;
+    m_localSids[sid.GetAddress()] = entry;
+}
+
+void
+Ipv6ExtensionSegmentRouting::RemoveLocalSid(Segment sid)
+{
+    NS_LOG_FUNCTION(this << sid.GetAddress());
+    m_localSids.erase(sid.GetAddress());
+}
+
+bool
+Ipv6ExtensionSegmentRouting::IsLocalSid(Segment sid) const
+{
+    bool nextCsid;
+    return LookupLocalSid(sid.GetAddress(), nextCsid) != nullptr;
+}
+
+const Ipv6ExtensionSegmentRouting::LocalSid*
+Ipv6ExtensionSegmentRouting::LookupLocalSid(Ipv6Address dst, bool& nextCsid) const
+{
+    nextCsid = false;
+    auto it = m_localSids.find(dst);
+    if (it == m_localSids.end() && m_csidBlockLength)
+    {
+        /* a container is bound through its active C-SID */
+        Segment container(dst);
+        it = m_localSids.find(container.GetActiveSid(m_csidBlockLength, m_csidLength).GetAddress());
+        nextCsid = it != m_localSids.end() &&
+                   container.GetNCsids(m_csidBlockLength, m_csidLength) > 1;
+    }
+    return it == m_localSids.end() ? nullptr : &it->second;
+}
+
+uint8_t
+Ipv6ExtensionSegmentRouting::Process(Ptr<Packet>& packet,
+                                     uint8_t offset,
+                                     const Ipv6Header& ipv6Header,
+                                     Ipv6Address dst,
+                                     uint8_t* nextHeader,
+                                     bool& stopProcessing,
+                                     bool& isDropped,
+                                     Ipv6L3Protocol::DropReason& dropReason)
+{
+    NS_LOG_FUNCTION(this << packet << offset << ipv6Header << dst << nextHeader << isDropped);
+
+    // For ICMPv6 Error packets
+    Ptr<Packet> malformedPacket = packet->Copy();
+    malformedPacket->AddHeader(ipv6Header);
+
+    Ptr<Packet> p = packet->Copy();
+    p->RemoveAtStart(offset);
+
+    Ipv6ExtensionSegmentRoutingHeader routingHeader;
+    p->RemoveHeader(routingHeader);
+
+    if (nextHeader)
+    {
+        *nextHeader = routingHeader.GetNextHeader();
+    }
+
+    Ptr<Ipv6L3Protocol> ipv6 = GetNode()->GetObject<Ipv6L3Protocol>();
+    Ptr<Icmpv6L4Protocol> icmpv6 = ipv6->GetIcmpv6();
+
+    Ipv6Address srcAddress = ipv6Header.GetSource();
+    Ipv6Address destAddress = ipv6Header.GetDestination();
+    uint8_t hopLimit = ipv6Header.GetHopLimit();
+    uint8_t segmentsLeft = routingHeader.GetSegmentsLeft();
+
+    LocalSid localSid;
+    localSid.behaviour = END;
+    localSid.interface = 0;
+    bool nextCsid;
+    const LocalSid* found = LookupLocalSid(destAddress, nextCsid);
+    if (found)
+    {
+        localSid = *found;
+    }
+
+    if (segmentsLeft == 0 && !nextCsid)
+    {
+        isDropped = false;
+        if (localSid.behaviour == END_DT6 &&
+            routingHeader.GetNextHeader() == Ipv6Header::IPV6_IPV6 && DecapsulateAndForward(p))
+        {
+            stopProcessing = true;
+        }
+        return routingHeader.GetSerializedSize();
+    }
+
+    if (localSid.behaviour == END_DT6 || segmentsLeft > routingHeader.GetLastEntry() + 1)
+    {
+        NS_LOG_LOGIC("Malformed header. Drop!");
+        icmpv6->SendErrorParameterError(malformedPacket,
+                                        srcAddress,
+                                        Icmpv6Header::ICMPV6_MALFORMED_HEADER,
+                                        offset + 3);
+        dropReason = Ipv6L3Protocol::DROP_MALFORMED_HEADER;
+        isDropped = true;
+        stopProcessing = true;
+        return routingHeader.GetSerializedSize();
+    }
+
+    if (hopLimit <= 1)
+    {
+        NS_LOG_LOGIC("Time Exceeded : Hop Limit <= 1. Drop!");
+        icmpv6->SendErrorTimeExceeded(malformedPacket, srcAddress, Icmpv6Header::ICMPV6_HOPLIMIT);
+        dropReason = Ipv6L3Protocol::DROP_TTL_EXPIRED;
+        isDropped = true;
+        stopProcessing = true;
+        return routingHeader.GetSerializedSize();
+    }
+
+    Ipv6Address nextAddress;
+    if (nextCsid)
+    {
+        /* NEXT-C-SID: the next C-SID of the container becomes active */
+        nextAddress =
+            Segment(destAddress).ShiftCsids(m_csidBlockLength, m_csidLength).GetAddress();
+    }
+    else
+    {
+        segmentsLeft--;
+        nextAddress = routingHeader.GetRouterSegment(segmentsLeft).GetAddress();
+    }
+
+    if (nextAddress.IsMulticast() || destAddress.IsMulticast())
+    {
+        dropReason = Ipv6L3Protocol::DROP_MALFORMED_HEADER;
+        isDropped = true;
+        stopProcessing = true;
+        return routingHeader.GetSerializedSize();
+    }
+
+    /* at most Segments Left changes, the SID list is forwarded as received */
+    routingHeader.SetSegmentsLeft(segmentsLeft);
+    p->AddHeader(routingHeader);
+
+    Ipv6Header ipv6header = ipv6Header;
+    ipv6header.SetDestination(nextAddress);
+    ipv6header.SetHopLimit(hopLimit - 1);
+    ipv6header.SetPayloadLength(p->GetSize());
+
+    /* the next segment is one of our addresses (e.g. the final destination) */
+    int32_t localInterface = ipv6->GetInterfaceForAddress(nextAddress);
+    if (localInterface >= 0 && localSid.behaviour != END_X)
+    {
+        ipv6->LocalDeliver(p, ipv6header, localInterface);
+        isDropped = false;
+        stopProcessing = true;
+        return routingHeader.GetSerializedSize();
+    }
+
+    Ptr<Ipv6Route> rtentry;
+    if (localSid.behaviour == END_X)
+    {
+        rtentry = Create<Ipv6Route>();
+        rtentry->SetDestination(nextAddress);
+        rtentry->SetGateway(localSid.nextHop);
+        rtentry->SetOutputDevice(ipv6->GetNetDevice(localSid.interface));
+        rtentry->SetSource(ipv6->SourceAddressSelection(localSid.interface, localSid.nextHop));
+    }
+    else
+    {
+        Ptr<Ipv6RoutingProtocol> ipv6rp = ipv6->GetRoutingProtocol();
+        Socket::SocketErrno err;
+        NS_ASSERT(ipv6rp);
+        rtentry = ipv6rp->RouteOutput(p, ipv6header, nullptr, err);
+    }
+
+    /* the packet is not for us, do not hand it to the upper layers */
+    stopProcessing = true;
+
+    if (rtentry)
+    {
+        ipv6->SendRealOut(rtentry, p, ipv6header);
+        isDropped = false;
+    }
+    else
+    {
+        NS_LOG_INFO("No route for next segment");
+        dropReason = Ipv6L3Protocol::DROP_NO_ROUTE;
+        isDropped = true;
+    }
+
+    return routingHeader.GetSerializedSize();
+}
+
+bool
+Ipv6ExtensionSegmentRouting::DecapsulateAndForward(Ptr<Packet> p)
+{
+    NS_LOG_FUNCTION(this << p);
+
+    Ptr<Ipv6L3Protocol> ipv6 = GetNode()->GetObject<Ipv6L3Protocol>();
+    Ipv6Header innerHeader;
+    p->PeekHeader(innerHeader);
+
+    if (ipv6->GetInterfaceForAddress(innerHeader.GetDestination()) >= 0)
+    {
+        return false;
+    }
+
+    p->RemoveHeader(innerHeader);
+    if (innerHeader.GetHopLimit() <= 1)
+    {
+        NS_LOG_LOGIC("Inner packet hop limit exceeded. Drop!");
+        return true;
+    }
+    innerHeader.SetHopLimit(innerHeader.GetHopLimit() - 1);
+
+    Socket::SocketErrno err;
+    Ptr<Ipv6Route> rtentry = ipv6->GetRoutingProtocol()->RouteOutput(p, innerHeader, nullptr, err);
+    if (rtentry)
+    {
+        ipv6->SendRealOut(rtentry, p, innerHeader);
+    }
+    else
+    {
+        NS_LOG_INFO("No route for the decapsulated packet");
+    }
+    return true;
+}
+
 NS_OBJECT_ENSURE_REGISTERED(Ipv6ExtensionESP);
 
 TypeId
@@ -660,6 +660,135 @@ class Ipv6ExtensionLooseRouting : public Ipv6ExtensionRouting
                     Ipv6L3Protocol::DropReason& dropReason) override;
 };
 
+/**
+ * \ingroup ipv6HeaderExt
+ *
+ * \brief IPv6 Extension Segment Routing (SRv6, RFC 8754).
+ *
+ * Processes the Segment Routing Header when the active segment is one of
+ * the node's SIDs. By default every SID behaves as End; SIDs registered
+ * with AddLocalSid can be bound to End.X (forward to a given neighbour) or
+ * End.DT6 (decapsulate and look up the inner packet, RFC 8986).
+ * Segments Left is decremented and the next SID copied into the destination
+ * address, the SID list itself is left untouched.
+ */
+class Ipv6ExtensionSegmentRouting : public Ipv6ExtensionRouting
+{
+  public:
+    /**
+     * \brief Routing type.
+     */
+    static const uint8_t TYPE_ROUTING = 4;
+
+    /**
+     * \enum Behaviour_e
+     * \brief SRv6 endpoint behaviours.
+     */
+    enum Behaviour_e
+    {
+        END = 0,  //!< Endpoint
+        END_X,    //!< Endpoint with L3 cross-connect
+        END_DT6,  //!< Endpoint with decapsulation and IPv6 table lookup
+    };
+
+    /**
+     * \brief Get the type identificator.
+     * \return type identificator
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * \brief Constructor.
+     */
+    Ipv6ExtensionSegmentRouting();
+
+    /**
+     * \brief Destructor.
+     */
+    ~Ipv6ExtensionSegmentRouting() override;
+
+    /**
+     * \brief Get the type of routing.
+     * \return type of routing
+     */
+    uint8_t GetTypeRouting() const override;
+
+    Ipv6ExtensionRoutingHeader* GetExtensionRoutingHeaderPtr() override;
+
+    uint8_t Process(Ptr<Packet>& packet,
+                    uint8_t offset,
+                    const Ipv6Header& ipv6Header,
+                    Ipv6Address dst,
+                    uint8_t* nextHeader,
+                    bool& stopProcessing,
+                    bool& isDropped,
+                    Ipv6L3Protocol::DropReason& dropReason) override;
+
+    /**
+     * \brief Bind a local SID to a behaviour.
+     * \param sid the SID
+     * \param behaviour the behaviour
+     * \param nextHop the End.X adjacency (ignored otherwise)
+     * \param interface the End.X outgoing interface (ignored otherwise)
+     */
+    void AddLocalSid(Segment sid,
+                     Behaviour_e behaviour,
+                     Ipv6Address nextHop = Ipv6Address::GetAny(),
+                     uint32_t interface = 0);
+
+    /**
+     * \brief Remove a local SID.
+     * \param sid the SID
+     */
+    void RemoveLocalSid(Segment sid);
+
+    /**
+     * \brief Check whether a SID has been bound with AddLocalSid.
+     *
+     * With C-SIDs enabled, a container whose active C-SID is local also matches.
+     * \param sid the SID
+     * \return true if the SID is a local SID
+     */
+    bool IsLocalSid(Segment sid) const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * \brief Local SID entry.
+     */
+    struct LocalSid
+    {
+        Behaviour_e behaviour; //!< the behaviour
+        Ipv6Address nextHop;   //!< End.X adjacency
+        uint32_t interface;    //!< End.X outgoing interface
+    };
+
+    /**
+     * \brief Find the local SID of a destination.
+     * \param dst the destination address
+     * \param nextCsid set to whether dst is a container with C-SIDs after the local one
+     * \return the local SID, or nullptr if dst is not a local SID
+     */
+    const LocalSid* LookupLocalSid(Ipv6Address dst, bool& nextCsid) const;
+
+    /**
+     * \brief Decapsulate the inner IPv6 packet and forward it (End.DT6).
+     * \param p the packet starting with the inner IPv6 header
+     * \return false if the inner packet is addressed to this node
+     */
+    bool DecapsulateAndForward(Ptr<Packet> p);
+
+    /**
+     * \brief The local SIDs, indexed by address.
+     */
+    std::map<Ipv6Address, LocalSid> m_localSids;
+
+    uint8_t m_csidBlockLength; //!< C-SID locator block length in bits, 0 without C-SIDs
+    uint8_t m_csidLength;      //!< C-SID length in bits
+};
+
 /**
  * \ingroup ipv6HeaderExt
  *
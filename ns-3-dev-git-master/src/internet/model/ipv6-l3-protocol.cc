@@ -1676,6 +1676,10 @@ Ipv6L3Protocol::RegisterExtensions()
         CreateObject<Ipv6ExtensionLooseRouting>();
     looseRoutingExtension->SetNode(m_node);
     routingExtensionDemux->Insert(looseRoutingExtension);
+    Ptr<Ipv6ExtensionSegmentRouting> segmentRoutingExtension =
+        CreateObject<Ipv6ExtensionSegmentRouting>();
+    segmentRoutingExtension->SetNode(m_node);
+    routingExtensionDemux->Insert(segmentRoutingExtension);
 
     m_node->AggregateObject(routingExtensionDemux);
     m_node->AggregateObject(ipv6ExtensionDemux);
@@ -542,6 +542,11 @@ class Ipv6L3Protocol : public Ipv6
      * \relates Ipv6ExtensionLooseRouting
      */
     friend class Ipv6ExtensionLooseRouting;
+    /**
+     * \brief Ipv6ExtensionSegmentRouting.
+     * \relates Ipv6ExtensionSegmentRouting
+     */
+    friend class Ipv6ExtensionSegmentRouting;
 
     /**
      * \brief Container of the IPv6 Interfaces.
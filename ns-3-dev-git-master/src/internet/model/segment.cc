@@ -1,34 +1,54 @@
 #include "segment.h"
 
-#include "ns3/mac16-address.h"
-#include "ns3/mac48-address.h"
-#include "ns3/mac64-address.h"
-
-#include "ns3/log.h"
 #include "ns3/assert.h"
+#include "ns3/log.h"
 
-#include <iomanip>
-#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("Segment");
 
-Segment::Segment() {
+ATTRIBUTE_HELPER_CPP(Segment);
+ATTRIBUTE_HELPER_CPP(SegmentList);
+
+namespace
+{
+
+/**
+ * \brief Check a C-SID format.
+ * \param blockLength length of the block in bits
+ * \param csidLength length of a C-SID in bits
+ */
+void
+CheckCsidFormat(uint8_t blockLength, uint8_t csidLength)
+{
+    NS_ASSERT_MSG(blockLength % 8 == 0 && blockLength < 128,
+                  "the block length must be a multiple of 8 bits");
+    NS_ASSERT_MSG(csidLength == 16 || csidLength == 32, "the C-SID length must be 16 or 32 bits");
+    NS_ASSERT_MSG(blockLength + csidLength <= 128, "no room for a C-SID after the block");
+}
+
+} // namespace
+
+Segment::Segment()
+{
     NS_LOG_FUNCTION(this);
     memset(m_address, 0x00, 16);
-    m_initialized = false;
 }
 
-Segment::Segment(const Segment& sid) {
+Segment::Segment(const Segment& sid)
+{
     memcpy(m_address, sid.m_address, 16);
-    m_initialized = true;
 }
 
-Segment::Segment(const Segment* sid) {
+Segment::Segment(const Segment* sid)
+{
     memcpy(m_address, sid->m_address, 16);
-    m_initialized = true;
 }
 
 Segment::Segment(uint8_t sid[16])
@@ -36,38 +56,184 @@ Segment::Segment(uint8_t sid[16])
     NS_LOG_FUNCTION(this << &sid);
     /* 128 bit => 16 bytes */
     memcpy(m_address, sid, 16);
-    m_initialized = true;
 }
 
-Segment::Segment(const char* sid) {
+Segment::Segment(const char* sid)
+{
     NS_LOG_FUNCTION(this << sid);
-    m_initialized = true;
+    Set(sid);
 }
 
-Segment::~Segment () {
+Segment::Segment(Ipv6Address addr)
+{
+    addr.GetBytes(m_address);
+}
+
+Ipv6Address
+Segment::GetAddress() const
+{
+    return Ipv6Address::Deserialize(m_address);
+}
 
+Segment::~Segment()
+{
 }
 
 void
-Segment::Set (const char* sid) {
+Segment::Set(const char* sid)
+{
     NS_LOG_FUNCTION(this << sid);
-    m_initialized = true;
+    Ipv6Address(sid).GetBytes(m_address);
 }
 
 void
-Segment::Serialize(uint8_t buf[16]) const {
+Segment::Serialize(uint8_t buf[16]) const
+{
     NS_LOG_FUNCTION(this << &buf);
-    memcpy(buf, m_address, 8);
+    memcpy(buf, m_address, 16);
 }
 
-Segment 
-Segment::Deserialize(const uint8_t buf[16]) {
+Segment
+Segment::Deserialize(const uint8_t buf[16])
+{
     NS_LOG_FUNCTION(&buf);
-    Segment sid((uint8_t*)buf);
-    sid.m_initialized = true;
+    return Segment((uint8_t*)buf);
+}
+
+Segment
+Segment::MakeContainer(Ipv6Address block,
+                       uint8_t blockLength,
+                       const std::vector<uint32_t>& csids,
+                       uint8_t csidLength)
+{
+    CheckCsidFormat(blockLength, csidLength);
+    NS_ASSERT_MSG(csids.size() <= GetCsidCapacity(blockLength, csidLength),
+                  "too many C-SIDs for a container");
+
+    Segment container;
+    uint8_t blockBytes[16];
+    block.GetBytes(blockBytes);
+    uint32_t offset = blockLength / 8;
+    memcpy(container.m_address, blockBytes, offset);
+    uint32_t csidBytes = csidLength / 8;
+    for (auto it = csids.begin(); it != csids.end(); it++)
+    {
+        NS_ASSERT_MSG(*it != 0, "a zero C-SID ends the container");
+        NS_ASSERT_MSG(csidLength == 32 || *it <= 0xffff, "C-SID too large");
+        for (uint32_t j = 0; j < csidBytes; j++)
+        {
+            container.m_address[offset + j] = *it >> (8 * (csidBytes - 1 - j));
+        }
+        offset += csidBytes;
+    }
+    return container;
+}
+
+uint32_t
+Segment::GetCsidCapacity(uint8_t blockLength, uint8_t csidLength)
+{
+    CheckCsidFormat(blockLength, csidLength);
+    return (128 - blockLength) / csidLength;
+}
+
+uint32_t
+Segment::GetNCsids(uint8_t blockLength, uint8_t csidLength) const
+{
+    uint32_t capacity = GetCsidCapacity(blockLength, csidLength);
+    uint32_t n = 0;
+    while (n < capacity && GetCsid(blockLength, csidLength, n) != 0)
+    {
+        n++;
+    }
+    return n;
+}
+
+uint32_t
+Segment::GetCsid(uint8_t blockLength, uint8_t csidLength, uint32_t index) const
+{
+    if (index >= GetCsidCapacity(blockLength, csidLength))
+    {
+        return 0;
+    }
+    uint32_t csidBytes = csidLength / 8;
+    uint32_t offset = blockLength / 8 + index * csidBytes;
+    uint32_t csid = 0;
+    for (uint32_t j = 0; j < csidBytes; j++)
+    {
+        csid = (csid << 8) | m_address[offset + j];
+    }
+    return csid;
+}
+
+Segment
+Segment::GetActiveSid(uint8_t blockLength, uint8_t csidLength) const
+{
+    CheckCsidFormat(blockLength, csidLength);
+    Segment sid(*this);
+    uint32_t end = (blockLength + csidLength) / 8;
+    memset(sid.m_address + end, 0, 16 - end);
+    return sid;
+}
+
+Segment
+Segment::ShiftCsids(uint8_t blockLength, uint8_t csidLength) const
+{
+    CheckCsidFormat(blockLength, csidLength);
+    Segment sid(*this);
+    uint32_t offset = blockLength / 8;
+    uint32_t csidBytes = csidLength / 8;
+    memmove(sid.m_address + offset, sid.m_address + offset + csidBytes, 16 - offset - csidBytes);
+    memset(sid.m_address + 16 - csidBytes, 0, csidBytes);
     return sid;
 }
 
+bool
+Segment::IsCompressible(const Segment& block, uint8_t blockLength, uint8_t csidLength) const
+{
+    CheckCsidFormat(blockLength, csidLength);
+    uint32_t offset = blockLength / 8;
+    uint32_t end = (blockLength + csidLength) / 8;
+    if (memcmp(m_address, block.m_address, offset) != 0 || GetCsid(blockLength, csidLength, 0) == 0)
+    {
+        return false;
+    }
+    return std::all_of(m_address + end, m_address + 16, [](uint8_t b) { return b == 0; });
+}
+
+bool
+operator==(const Segment& a, const Segment& b)
+{
+    return !memcmp(a.m_address, b.m_address, 16);
+}
+
+bool
+operator<(const Segment& a, const Segment& b)
+{
+    return memcmp(a.m_address, b.m_address, 16) < 0;
+}
+
+std::ostream&
+operator<<(std::ostream& os, const Segment& sid)
+{
+    os << sid.GetAddress();
+    return os;
+}
+
+std::istream&
+operator>>(std::istream& is, Segment& sid)
+{
+    Ipv6Address address;
+    is >> address;
+    sid = Segment(address);
+    return is;
+}
+
+size_t
+SegmentHash::operator()(const Segment& x) const
+{
+    return Ipv6AddressHash()(x.GetAddress());
+}
+
 uint8_t
 Segment::GetType()
 {
@@ -75,4 +241,188 @@ Segment::GetType()
     static uint8_t type = Address::Register();
     return type;
 }
-}
\ No newline at end of file
+
+SegmentList::SegmentList()
+    : m_size(0)
+{
+}
+
+SegmentList::SegmentList(uint32_t n, const Segment& sid)
+    : m_size(0)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        Add(sid);
+    }
+}
+
+SegmentList::SegmentList(const std::vector<Segment>& segments)
+    : m_size(0)
+{
+    for (auto it = segments.begin(); it != segments.end(); it++)
+    {
+        Add(*it);
+    }
+}
+
+uint32_t
+SegmentList::GetN() const
+{
+    return m_size;
+}
+
+bool
+SegmentList::IsEmpty() const
+{
+    return m_size == 0;
+}
+
+const Segment&
+SegmentList::Get(uint32_t i) const
+{
+    NS_ASSERT_MSG(i < m_size, "SID index " << i << " out of range");
+    return Begin()[i];
+}
+
+void
+SegmentList::Set(uint32_t i, const Segment& sid)
+{
+    NS_ASSERT_MSG(i < m_size, "SID index " << i << " out of range");
+    GetData()[i] = sid;
+}
+
+void
+SegmentList::Add(const Segment& sid)
+{
+    if (m_heap.empty() && m_size < INLINE_SEGMENTS)
+    {
+        m_inline[m_size++] = sid;
+        return;
+    }
+    if (m_heap.empty())
+    {
+        m_heap.assign(m_inline, m_inline + m_size);
+    }
+    m_heap.push_back(sid);
+    m_size++;
+}
+
+void
+SegmentList::Clear()
+{
+    m_heap.clear();
+    m_size = 0;
+}
+
+const Segment*
+SegmentList::Begin() const
+{
+    return m_heap.empty() ? m_inline : m_heap.data();
+}
+
+const Segment*
+SegmentList::End() const
+{
+    return Begin() + m_size;
+}
+
+Segment*
+SegmentList::GetData()
+{
+    return m_heap.empty() ? m_inline : m_heap.data();
+}
+
+std::vector<Segment>
+SegmentList::GetVector() const
+{
+    return std::vector<Segment>(Begin(), End());
+}
+
+SegmentList
+SegmentList::Compress(uint8_t blockLength, uint8_t csidLength) const
+{
+    if (blockLength == 0)
+    {
+        return *this;
+    }
+
+    uint32_t capacity = Segment::GetCsidCapacity(blockLength, csidLength);
+    SegmentList compressed;
+    std::vector<uint32_t> csids;
+    Segment block;
+    for (const Segment* it = Begin(); it != End(); it++)
+    {
+        if (!csids.empty() &&
+            (csids.size() == capacity || !it->IsCompressible(block, blockLength, csidLength)))
+        {
+            compressed.Add(
+                Segment::MakeContainer(block.GetAddress(), blockLength, csids, csidLength));
+            csids.clear();
+        }
+        if (csids.empty())
+        {
+            block = *it;
+            if (!it->IsCompressible(block, blockLength, csidLength))
+            {
+                compressed.Add(*it);
+                continue;
+            }
+        }
+        csids.push_back(it->GetCsid(blockLength, csidLength, 0));
+    }
+    if (!csids.empty())
+    {
+        compressed.Add(Segment::MakeContainer(block.GetAddress(), blockLength, csids, csidLength));
+    }
+    return compressed;
+}
+
+bool
+operator==(const SegmentList& a, const SegmentList& b)
+{
+    return a.GetN() == b.GetN() && std::equal(a.Begin(), a.End(), b.Begin());
+}
+
+bool
+operator<(const SegmentList& a, const SegmentList& b)
+{
+    return std::lexicographical_compare(a.Begin(), a.End(), b.Begin(), b.End());
+}
+
+std::ostream&
+operator<<(std::ostream& os, const SegmentList& list)
+{
+    for (const Segment* it = list.Begin(); it != list.End(); it++)
+    {
+        os << (it == list.Begin() ? "" : ",") << *it;
+    }
+    return os;
+}
+
+std::istream&
+operator>>(std::istream& is, SegmentList& list)
+{
+    list.Clear();
+    std::string text;
+    is >> text;
+    std::istringstream sids(text);
+    std::string sid;
+    while (std::getline(sids, sid, ','))
+    {
+        list.Add(Segment(sid.c_str()));
+    }
+    return is;
+}
+
+size_t
+SegmentListHash::operator()(const SegmentList& x) const
+{
+    size_t hash = x.GetN();
+    for (const Segment* it = x.Begin(); it != x.End(); it++)
+    {
+        hash = hash * 31 + SegmentHash()(*it);
+    }
+    return hash;
+}
+
+} // namespace ns3
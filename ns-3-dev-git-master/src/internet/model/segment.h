@@ -3,55 +3,395 @@
 
 #include "ns3/address.h"
 #include "ns3/attribute-helper.h"
+#include "ns3/ipv6-address.h"
 
+#include <istream>
 #include <ostream>
 #include <stdint.h>
+#include <vector>
 
 namespace ns3
 {
+
+/**
+ * \ingroup ipv6HeaderExt
+ *
+ * \brief An SRv6 segment identifier (SID).
+ *
+ * A SID is a 128 bits value, either a plain IPv6 address or a container of
+ * compressed SIDs (C-SIDs, RFC 9800): a locator block shared by the SIDs of
+ * a domain followed by 16 bits (uSID) or 32 bits C-SIDs, the first one being
+ * active and the rest of the container zero. The C-SID methods take the
+ * block and C-SID lengths in bits; the block length is a multiple of 8.
+ */
 class Segment
-  {
+{
   public:
     /**
-     * \brief Default constructor.
-    */
+     * \brief Default constructor, the SID ::.
+     */
     Segment();
-    /*
-    */
+    /**
+     * \brief Constructs a SID from its IPv6 textual form.
+     * \param sid the SID, e.g. "2001:db8::1"
+     */
     Segment(const char* sid);
-    /*
-    */
+    /**
+     * \brief Copy constructor.
+     * \param sid the SID
+     */
     Segment(const Segment& sid);
-    /*
-    */
+    /**
+     * \brief Constructs a copy of a SID.
+     * \param sid the SID
+     */
     Segment(const Segment* sid);
-    /*
-    */
+    /**
+     * \brief Destructor.
+     */
     ~Segment();
-    /*
-    */
+    /**
+     * \brief Assignment operator.
+     * \param sid the SID
+     * \return this SID
+     */
+    Segment& operator=(const Segment& sid) = default;
+    /**
+     * \brief Sets the SID from its IPv6 textual form.
+     * \param sid the SID, e.g. "2001:db8::1"
+     */
     void Set(const char* sid);
-    /*
-    */
+    /**
+     * \brief Constructs a SID from its bytes.
+     * \param sid the 16 bytes of the SID, in network order
+     */
     Segment(uint8_t sid[16]);
-    /*
-    */
+    /**
+     * \brief Constructs a SID from an IPv6 address.
+     * \param addr the address used as SID
+     */
+    Segment(Ipv6Address addr);
+    /**
+     * \brief Get the SID as an IPv6 address (e.g. to set it as destination).
+     * \return the address carried by this SID
+     */
+    Ipv6Address GetAddress() const;
+    /**
+     * \brief Serialize the SID.
+     * \param buf the 16 bytes to write, in network order
+     */
     void Serialize(uint8_t buf[16]) const;
-    /*
-    */
+    /**
+     * \brief Deserialize a SID.
+     * \param buf the 16 bytes of the SID, in network order
+     * \return the SID
+     */
     static Segment Deserialize(const uint8_t buf[16]);
-    private:
-      uint8_t m_address[16];
-      bool m_initialized;
+
+    /**
+     * \brief Build a container of C-SIDs.
+     * \param block the locator block, only its first blockLength bits are used
+     * \param blockLength length of the block in bits
+     * \param csids the C-SIDs, first one active, none of them zero
+     * \param csidLength length of a C-SID in bits, 16 or 32
+     * \return the container
+     */
+    static Segment MakeContainer(Ipv6Address block,
+                                 uint8_t blockLength,
+                                 const std::vector<uint32_t>& csids,
+                                 uint8_t csidLength);
+    /**
+     * \brief Get the number of C-SIDs a container holds.
+     * \param blockLength length of the block in bits
+     * \param csidLength length of a C-SID in bits
+     * \return the capacity of a container
+     */
+    static uint32_t GetCsidCapacity(uint8_t blockLength, uint8_t csidLength);
+    /**
+     * \brief Get the number of C-SIDs left in this container.
+     * \param blockLength length of the block in bits
+     * \param csidLength length of a C-SID in bits
+     * \return the C-SIDs before the first zero one
+     */
+    uint32_t GetNCsids(uint8_t blockLength, uint8_t csidLength) const;
+    /**
+     * \brief Get a C-SID of this container.
+     * \param blockLength length of the block in bits
+     * \param csidLength length of a C-SID in bits
+     * \param index index of the C-SID, 0 for the active one
+     * \return the C-SID, 0 past the last one
+     */
+    uint32_t GetCsid(uint8_t blockLength, uint8_t csidLength, uint32_t index) const;
+    /**
+     * \brief Get the SID of the active C-SID: the block, the C-SID and zeros.
+     *
+     * It is the SID bound on the node owning the C-SID.
+     * \param blockLength length of the block in bits
+     * \param csidLength length of a C-SID in bits
+     * \return the active SID
+     */
+    Segment GetActiveSid(uint8_t blockLength, uint8_t csidLength) const;
+    /**
+     * \brief Drop the active C-SID, the next one becomes active (NEXT-C-SID flavor).
+     * \param blockLength length of the block in bits
+     * \param csidLength length of a C-SID in bits
+     * \return the shifted container
+     */
+    Segment ShiftCsids(uint8_t blockLength, uint8_t csidLength) const;
+    /**
+     * \brief Whether this SID fits in a C-SID of a block: it starts with the
+     * block, its C-SID is not zero and the rest of it is zero.
+     * \param block the locator block
+     * \param blockLength length of the block in bits
+     * \param csidLength length of a C-SID in bits
+     * \return true if the SID can be compressed
+     */
+    bool IsCompressible(const Segment& block, uint8_t blockLength, uint8_t csidLength) const;
+
+    /**
+     * \brief Equal to operator.
+     *
+     * \param a the first operand
+     * \param b the second operand
+     * \returns true if the operands are equal
+     */
+    friend bool operator==(const Segment& a, const Segment& b);
+    /**
+     * \brief Less than operator.
+     *
+     * \param a the first operand
+     * \param b the second operand
+     * \returns true if a is less than b
+     */
+    friend bool operator<(const Segment& a, const Segment& b);
+
   private:
-    private:
     /**
      * \brief Return the Type of address.
      * \return type of address
      */
     static uint8_t GetType();
 
-  };
+    uint8_t m_address[16]; //!< the SID, in network order
+};
+
+/**
+ * \brief Not equal to operator.
+ *
+ * \param a the first operand
+ * \param b the second operand
+ * \returns true if the operands are not equal
+ */
+inline bool
+operator!=(const Segment& a, const Segment& b)
+{
+    return !(a == b);
+}
+
+/**
+ * \brief Stream insertion operator, the SID in IPv6 textual form.
+ *
+ * \param os the reference to the output stream
+ * \param sid the SID
+ * \returns the reference to the output stream
+ */
+std::ostream& operator<<(std::ostream& os, const Segment& sid);
+
+/**
+ * \brief Stream extraction operator, the SID in IPv6 textual form.
+ *
+ * \param is the reference to the input stream
+ * \param sid the SID
+ * \returns the reference to the input stream
+ */
+std::istream& operator>>(std::istream& is, Segment& sid);
+
+/**
+ * \class SegmentHash
+ * \brief Hash function class for SIDs.
+ */
+class SegmentHash
+{
+  public:
+    /**
+     * \brief Returns the hash of a SID.
+     * \param x SID to hash
+     * \returns the hash of the SID
+     */
+    size_t operator()(const Segment& x) const;
+};
+
+/**
+ * \ingroup ipv6HeaderExt
+ *
+ * \brief A SID list, first SID first, as a value.
+ *
+ * Up to INLINE_SEGMENTS SIDs are stored in the list itself, so a SID list
+ * of an SRH or of a policy is one object without allocation; longer lists
+ * are moved to the heap. The textual form, used by the attributes, is the
+ * comma separated SIDs.
+ */
+class SegmentList
+{
+  public:
+    /**
+     * \brief SIDs stored without allocation
+     */
+    static const uint32_t INLINE_SEGMENTS = 6;
+
+    /**
+     * \brief Constructor, an empty list.
+     */
+    SegmentList();
+    /**
+     * \brief Constructs a list of n copies of a SID.
+     * \param n the number of SIDs
+     * \param sid the SID
+     */
+    SegmentList(uint32_t n, const Segment& sid);
+    /**
+     * \brief Constructs a list from a vector of SIDs.
+     * \param segments the SIDs, first one first
+     */
+    SegmentList(const std::vector<Segment>& segments);
+
+    /**
+     * \brief Get the number of SIDs.
+     * \return the number of SIDs
+     */
+    uint32_t GetN() const;
+    /**
+     * \brief Whether the list is empty.
+     * \return true if there is no SID
+     */
+    bool IsEmpty() const;
+    /**
+     * \brief Get a SID.
+     * \param i the index of the SID
+     * \return the SID
+     */
+    const Segment& Get(uint32_t i) const;
+    /**
+     * \brief Replace a SID.
+     * \param i the index of the SID
+     * \param sid the new SID
+     */
+    void Set(uint32_t i, const Segment& sid);
+    /**
+     * \brief Append a SID.
+     * \param sid the SID
+     */
+    void Add(const Segment& sid);
+    /**
+     * \brief Remove all the SIDs.
+     */
+    void Clear();
+    /**
+     * \brief Get the first SID.
+     * \return the first SID
+     */
+    const Segment* Begin() const;
+    /**
+     * \brief Get past the last SID.
+     * \return past the last SID
+     */
+    const Segment* End() const;
+    /**
+     * \brief Get the SIDs as a vector.
+     * \return the SIDs, first one first
+     */
+    std::vector<Segment> GetVector() const;
+
+    /**
+     * \brief Pack the consecutive SIDs of a block into C-SID containers.
+     *
+     * The SIDs made of the block of the first of them and of one C-SID share
+     * a container as long as it has room; the other SIDs are kept as they are.
+     * \param blockLength length of the block in bits, 0 to leave the list as is
+     * \param csidLength length of a C-SID in bits, 16 or 32
+     * \return the compressed list
+     */
+    SegmentList Compress(uint8_t blockLength, uint8_t csidLength) const;
+
+  private:
+    /**
+     * \brief Get the SIDs.
+     * \return the first SID
+     */
+    Segment* GetData();
+
+    Segment m_inline[INLINE_SEGMENTS]; //!< the SIDs while they fit
+    std::vector<Segment> m_heap;       //!< the SIDs past INLINE_SEGMENTS, empty before
+    uint32_t m_size;                   //!< the number of SIDs
+};
+
+/**
+ * \brief Equal to operator.
+ *
+ * \param a the first operand
+ * \param b the second operand
+ * \returns true if the lists hold the same SIDs in the same order
+ */
+bool operator==(const SegmentList& a, const SegmentList& b);
+
+/**
+ * \brief Less than operator, lexicographic.
+ *
+ * \param a the first operand
+ * \param b the second operand
+ * \returns true if a is less than b
+ */
+bool operator<(const SegmentList& a, const SegmentList& b);
+
+/**
+ * \brief Not equal to operator.
+ *
+ * \param a the first operand
+ * \param b the second operand
+ * \returns true if the operands are not equal
+ */
+inline bool
+operator!=(const SegmentList& a, const SegmentList& b)
+{
+    return !(a == b);
 }
 
-#endif
\ No newline at end of file
+/**
+ * \brief Stream insertion operator, the comma separated SIDs.
+ *
+ * \param os the reference to the output stream
+ * \param list the SID list
+ * \returns the reference to the output stream
+ */
+std::ostream& operator<<(std::ostream& os, const SegmentList& list);
+
+/**
+ * \brief Stream extraction operator, the comma separated SIDs.
+ *
+ * \param is the reference to the input stream
+ * \param list the SID list
+ * \returns the reference to the input stream
+ */
+std::istream& operator>>(std::istream& is, SegmentList& list);
+
+/**
+ * \class SegmentListHash
+ * \brief Hash function class for SID lists.
+ */
+class SegmentListHash
+{
+  public:
+    /**
+     * \brief Returns the hash of a SID list.
+     * \param x SID list to hash
+     * \returns the hash of the SID list
+     */
+    size_t operator()(const SegmentList& x) const;
+};
+
+ATTRIBUTE_HELPER_HEADER(Segment);
+ATTRIBUTE_HELPER_HEADER(SegmentList);
+
+} // namespace ns3
+
+#endif /* SEGMENT_H */
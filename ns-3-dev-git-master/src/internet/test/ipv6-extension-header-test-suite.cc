@@ -270,6 +270,56 @@ class TestFulfilledAlignment : public TestCase
     }
 };
 
+/**
+ * \ingroup internet-test
+ *
+ * \brief IPv6 extensions Test: Segment Routing Header wire format.
+ */
+class TestSegmentRoutingHeader : public TestCase
+{
+  public:
+    TestSegmentRoutingHeader()
+        : TestCase("TestSegmentRoutingHeader")
+    {
+    }
+
+    void DoRun() override
+    {
+        Ipv6ExtensionSegmentRoutingHeader header;
+        header.SetNextHeader(17);
+        header.SetNumberSegments(2);
+        header.SetRouterSegment(0, Segment("2001:db8::1"));
+        header.SetRouterSegment(1, Segment(Ipv6Address("2001:db8::2")));
+        header.SetSegmentsLeft(1);
+        header.SetTag(0x1234);
+
+        NS_TEST_EXPECT_MSG_EQ(header.GetSerializedSize(), 40, "wrong SRH size");
+
+        Buffer buf;
+        buf.AddAtStart(header.GetSerializedSize());
+        header.Serialize(buf.Begin());
+
+        const uint8_t* data = buf.PeekData();
+        NS_TEST_EXPECT_MSG_EQ(*(data + 1), 4, "wrong Hdr Ext Len");
+        NS_TEST_EXPECT_MSG_EQ(*(data + 2), 4, "wrong routing type");
+        NS_TEST_EXPECT_MSG_EQ(*(data + 3), 1, "wrong Segments Left");
+        NS_TEST_EXPECT_MSG_EQ(*(data + 4), 1, "wrong Last Entry");
+        NS_TEST_EXPECT_MSG_EQ(*(data + 39), 2, "SID not fully serialized");
+
+        Ipv6ExtensionSegmentRoutingHeader copy;
+        NS_TEST_EXPECT_MSG_EQ(copy.Deserialize(buf.Begin()), 40, "wrong deserialized size");
+        NS_TEST_EXPECT_MSG_EQ(copy.GetNextHeader(), 17, "wrong next header");
+        NS_TEST_EXPECT_MSG_EQ(copy.GetSegmentsLeft(), 1, "wrong Segments Left");
+        NS_TEST_EXPECT_MSG_EQ(copy.GetTag(), 0x1234, "wrong tag");
+        NS_TEST_EXPECT_MSG_EQ(copy.GetRouterSegment(0).GetAddress(),
+                              Ipv6Address("2001:db8::1"),
+                              "wrong SID 0");
+        NS_TEST_EXPECT_MSG_EQ(copy.GetRouterSegment(1).GetAddress(),
+                              Ipv6Address("2001:db8::2"),
+                              "wrong SID 1");
+    }
+};
+
 /**
  * \ingroup internet-test
  *
@@ -285,6 +335,7 @@ class Ipv6ExtensionHeaderTestSuite : public TestSuite
         AddTestCase(new TestOptionWithoutAlignment, TestCase::QUICK);
         AddTestCase(new TestOptionWithAlignment, TestCase::QUICK);
         AddTestCase(new TestFulfilledAlignment, TestCase::QUICK);
+        AddTestCase(new TestSegmentRoutingHeader, TestCase::QUICK);
     }
 };
 
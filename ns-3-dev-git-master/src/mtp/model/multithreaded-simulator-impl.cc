@@ -0,0 +1,743 @@
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/channel-list.h"
+#include "ns3/fork-impl.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+
+/**
+ * \file
+ * \ingroup mtp
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3
+{
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and to the
+// threads running them
+NS_LOG_COMPONENT_DEFINE("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED(MultithreadedSimulatorImpl);
+
+namespace
+{
+
+/** Busy waits of a thread before it yields the processor. */
+const uint32_t SPIN_COUNT = 1000;
+
+} // namespace
+
+thread_local MultithreadedSimulatorImpl::Partition* MultithreadedSimulatorImpl::m_current =
+    nullptr;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::MultithreadedSimulatorImpl")
+            .SetParent<SimulatorImpl>()
+            .SetGroupName("Mtp")
+            .AddConstructor<MultithreadedSimulatorImpl>()
+            .AddAttribute("ThreadCount",
+                          "The number of threads running the partitions, "
+                          "0 for one per hardware thread.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&MultithreadedSimulatorImpl::m_threadCount),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl()
+{
+    NS_LOG_FUNCTION(this);
+    m_global.systemId = 0;
+    m_global.uid = EventId::UID::VALID;
+    m_global.currentUid = EventId::UID::INVALID;
+    m_global.currentTs = 0;
+    m_global.currentContext = Simulator::NO_CONTEXT;
+    m_global.eventCount = 0;
+    m_global.stop = false;
+    m_lookahead = GetMaximumSimulationTime();
+    m_threadCount = 0;
+    m_running = false;
+    m_stop = false;
+    m_windowEnd = 0;
+    m_nextActive = 0;
+    m_generation = 0;
+    m_done = 0;
+    m_quit = false;
+    m_mainThreadId = std::this_thread::get_id();
+    ForkImpl::RegisterThread(this, "MultithreadedSimulatorImpl");
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    ProcessEventsWithContext();
+
+    for (auto& partition : m_partitions)
+    {
+        while (!partition->events->IsEmpty())
+        {
+            Scheduler::Event next = partition->events->RemoveNext();
+            next.impl->Unref();
+        }
+    }
+    m_partitions.clear();
+    m_contexts.clear();
+    while (!m_global.events->IsEmpty())
+    {
+        Scheduler::Event next = m_global.events->RemoveNext();
+        next.impl->Unref();
+    }
+    m_global.events = nullptr;
+    ForkImpl::UnregisterThread(this);
+    SimulatorImpl::DoDispose();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy()
+{
+    NS_LOG_FUNCTION(this);
+    while (!m_destroyEvents.empty())
+    {
+        Ptr<EventImpl> ev = m_destroyEvents.front().PeekEventImpl();
+        m_destroyEvents.pop_front();
+        NS_LOG_LOGIC("handle destroy " << ev);
+        if (!ev->IsCancelled())
+        {
+            ev->Invoke();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler(ObjectFactory schedulerFactory)
+{
+    NS_LOG_FUNCTION(this << schedulerFactory);
+    NS_ASSERT_MSG(!m_running, "the scheduler cannot be changed while running");
+    m_schedulerFactory = schedulerFactory;
+
+    std::vector<Partition*> partitions;
+    partitions.push_back(&m_global);
+    for (auto& partition : m_partitions)
+    {
+        partitions.push_back(partition.get());
+    }
+    for (auto partition : partitions)
+    {
+        Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler>();
+        if (partition->events)
+        {
+            while (!partition->events->IsEmpty())
+            {
+                Scheduler::Event next = partition->events->RemoveNext();
+                scheduler->Insert(next);
+            }
+        }
+        partition->events = scheduler;
+    }
+}
+
+// All the partitions run in the same process
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId() const
+{
+    return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionId() const
+{
+    return GetCurrent()->systemId;
+}
+
+MultithreadedSimulatorImpl::Partition*
+MultithreadedSimulatorImpl::GetPartition(uint32_t context) const
+{
+    if (context < m_contexts.size() && m_contexts[context] != nullptr)
+    {
+        return m_contexts[context];
+    }
+    return const_cast<Partition*>(&m_global);
+}
+
+const MultithreadedSimulatorImpl::Partition*
+MultithreadedSimulatorImpl::GetCurrent() const
+{
+    return m_current != nullptr ? m_current : &m_global;
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert(Partition* partition,
+                                   uint64_t ts,
+                                   uint32_t context,
+                                   EventImpl* event)
+{
+    // Out of Run() all the unique ids come from the main thread, so that the
+    // events moved to a partition by the next Run() do not reuse an id.
+    Scheduler::Event ev;
+    ev.impl = event;
+    ev.key.m_ts = ts;
+    ev.key.m_context = context;
+    ev.key.m_uid = m_running ? partition->uid++ : m_global.uid++;
+    partition->events->Insert(ev);
+    return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::BuildPartitions()
+{
+    NS_LOG_FUNCTION(this);
+    std::map<uint32_t, Partition*> bySystemId;
+    for (auto& partition : m_partitions)
+    {
+        bySystemId[partition->systemId] = partition.get();
+    }
+    m_contexts.assign(NodeList::GetNNodes(), nullptr);
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
+    {
+        uint32_t systemId = NodeList::GetNode(i)->GetSystemId();
+        auto it = bySystemId.find(systemId);
+        if (it == bySystemId.end())
+        {
+            auto partition = std::make_unique<Partition>();
+            partition->systemId = systemId;
+            partition->events = m_schedulerFactory.Create<Scheduler>();
+            partition->uid = m_global.uid;
+            partition->currentUid = EventId::UID::INVALID;
+            partition->currentTs = m_global.currentTs;
+            partition->currentContext = Simulator::NO_CONTEXT;
+            partition->eventCount = 0;
+            partition->stop = false;
+            it = bySystemId.insert({systemId, partition.get()}).first;
+            m_partitions.push_back(std::move(partition));
+        }
+        m_contexts[i] = it->second;
+    }
+    NS_LOG_INFO(m_partitions.size() << " partitions");
+
+    // move the events scheduled on the nodes before they had a partition
+    std::vector<Scheduler::Event> events;
+    while (!m_global.events->IsEmpty())
+    {
+        events.push_back(m_global.events->RemoveNext());
+    }
+    for (const auto& ev : events)
+    {
+        GetPartition(ev.key.m_context)->events->Insert(ev);
+    }
+
+    m_lookahead = GetMaximumSimulationTime();
+    for (auto it = ChannelList::Begin(); it != ChannelList::End(); ++it)
+    {
+        Ptr<Channel> channel = *it;
+        std::set<Partition*> partitions;
+        for (std::size_t i = 0; i < channel->GetNDevices(); ++i)
+        {
+            Ptr<NetDevice> device = channel->GetDevice(i);
+            if (device && device->GetNode())
+            {
+                partitions.insert(GetPartition(device->GetNode()->GetId()));
+            }
+        }
+        if (partitions.size() < 2)
+        {
+            continue;
+        }
+        Ptr<PointToPointChannel> p2p = DynamicCast<PointToPointChannel>(channel);
+        NS_ABORT_MSG_UNLESS(p2p,
+                            "A " << channel->GetInstanceTypeId().GetName()
+                                 << " links nodes of different system ids; only the "
+                                    "point-to-point channels can link partitions");
+        TimeValue delay;
+        p2p->GetAttribute("Delay", delay);
+        NS_ABORT_MSG_UNLESS(delay.Get().IsStrictlyPositive(),
+                            "A point-to-point channel without delay links two partitions");
+        m_lookahead = std::min(m_lookahead, delay.Get());
+    }
+    NS_LOG_INFO("lookahead " << m_lookahead);
+}
+
+void
+MultithreadedSimulatorImpl::ProcessGlobalEvent()
+{
+    Scheduler::Event next = m_global.events->RemoveNext();
+
+    PreEventHook(EventId(next.impl, next.key.m_ts, next.key.m_context, next.key.m_uid));
+
+    NS_ASSERT(next.key.m_ts >= m_global.currentTs);
+    m_global.eventCount++;
+
+    NS_LOG_LOGIC("handle global " << next.key.m_ts);
+    m_global.currentTs = next.key.m_ts;
+    m_global.currentContext = next.key.m_context;
+    m_global.currentUid = next.key.m_uid;
+    next.impl->Invoke();
+    next.impl->Unref();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessPartition(Partition* partition)
+{
+    m_current = partition;
+    while (!partition->stop && !partition->events->IsEmpty() &&
+           partition->events->PeekNext().key.m_ts < m_windowEnd)
+    {
+        Scheduler::Event next = partition->events->RemoveNext();
+
+        PreEventHook(EventId(next.impl, next.key.m_ts, next.key.m_context, next.key.m_uid));
+
+        NS_ASSERT(next.key.m_ts >= partition->currentTs);
+        partition->eventCount++;
+
+        partition->currentTs = next.key.m_ts;
+        partition->currentContext = next.key.m_context;
+        partition->currentUid = next.key.m_uid;
+        next.impl->Invoke();
+        next.impl->Unref();
+    }
+    m_current = nullptr;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessActivePartitions()
+{
+    for (uint32_t i = m_nextActive.fetch_add(1, std::memory_order_relaxed); i < m_active.size();
+         i = m_nextActive.fetch_add(1, std::memory_order_relaxed))
+    {
+        ProcessPartition(m_active[i]);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow()
+{
+    m_active.clear();
+    for (auto& partition : m_partitions)
+    {
+        if (!partition->events->IsEmpty() &&
+            partition->events->PeekNext().key.m_ts < m_windowEnd)
+        {
+            m_active.push_back(partition.get());
+        }
+    }
+    if (m_active.size() == 1 || m_workers.empty())
+    {
+        // no need to wake up the workers
+        for (auto partition : m_active)
+        {
+            ProcessPartition(partition);
+        }
+        return;
+    }
+
+    m_nextActive.store(0, std::memory_order_relaxed);
+    m_done.store(0, std::memory_order_relaxed);
+    m_generation.fetch_add(1, std::memory_order_release);
+    ProcessActivePartitions();
+    for (uint32_t spin = 0; m_done.load(std::memory_order_acquire) < m_workers.size(); ++spin)
+    {
+        if (spin >= SPIN_COUNT)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Worker(uint64_t generation)
+{
+    while (true)
+    {
+        uint64_t current;
+        for (uint32_t spin = 0;
+             (current = m_generation.load(std::memory_order_acquire)) == generation;
+             ++spin)
+        {
+            if (spin >= SPIN_COUNT)
+            {
+                std::this_thread::yield();
+            }
+        }
+        generation = current;
+        if (m_quit.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        ProcessActivePartitions();
+        m_done.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessMessages()
+{
+    // in the order of the partitions and of the messages, so that the
+    // unique ids do not depend on the threads
+    for (auto& partition : m_partitions)
+    {
+        for (const auto& message : partition->outbox)
+        {
+            Insert(GetPartition(message.context), message.timestamp, message.context, message.event);
+        }
+        partition->outbox.clear();
+        if (partition->stop)
+        {
+            partition->stop = false;
+            m_stop = true;
+        }
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished() const
+{
+    if (m_stop)
+    {
+        return true;
+    }
+    if (!m_global.events->IsEmpty())
+    {
+        return false;
+    }
+    for (const auto& partition : m_partitions)
+    {
+        if (!partition->events->IsEmpty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessEventsWithContext()
+{
+    if (m_eventsWithContext.IsEmpty())
+    {
+        return;
+    }
+
+    // after the events already run by all the partitions
+    uint64_t now = m_global.currentTs;
+    for (const auto& partition : m_partitions)
+    {
+        now = std::max(now, partition->currentTs);
+    }
+    m_eventsWithContext.Drain([this, now](const Message& event) {
+        Insert(GetPartition(event.context), now + event.timestamp, event.context, event.event);
+    });
+}
+
+void
+MultithreadedSimulatorImpl::Run()
+{
+    NS_LOG_FUNCTION(this);
+    // Set the current threadId as the main threadId
+    m_mainThreadId = std::this_thread::get_id();
+    ProcessEventsWithContext();
+    BuildPartitions();
+    for (auto& partition : m_partitions)
+    {
+        partition->uid = m_global.uid;
+    }
+    m_stop = false;
+    m_running = true;
+
+    uint32_t threads =
+        m_threadCount > 0 ? m_threadCount : std::max(1U, std::thread::hardware_concurrency());
+    threads = std::min<uint32_t>(threads, m_partitions.size());
+    m_quit = false;
+    for (uint32_t i = 1; i < threads; ++i)
+    {
+        m_workers.emplace_back(&MultithreadedSimulatorImpl::Worker, this, m_generation.load());
+    }
+
+    const uint64_t end = std::numeric_limits<uint64_t>::max();
+    const uint64_t lookahead = m_lookahead.GetTimeStep();
+    while (!m_stop)
+    {
+        ProcessEventsWithContext();
+        uint64_t nextGlobal =
+            m_global.events->IsEmpty() ? end : m_global.events->PeekNext().key.m_ts;
+        uint64_t next = end;
+        for (auto& partition : m_partitions)
+        {
+            if (!partition->events->IsEmpty())
+            {
+                next = std::min(next, partition->events->PeekNext().key.m_ts);
+            }
+        }
+        if (nextGlobal == end && next == end)
+        {
+            break;
+        }
+        if (nextGlobal <= next)
+        {
+            ProcessGlobalEvent();
+            continue;
+        }
+        m_windowEnd = next > end - lookahead ? end : next + lookahead;
+        m_windowEnd = std::min(m_windowEnd, nextGlobal);
+        ProcessWindow();
+        ProcessMessages();
+    }
+
+    m_quit.store(true, std::memory_order_release);
+    m_generation.fetch_add(1, std::memory_order_release);
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+    m_running = false;
+
+    // the main thread goes on from the last event run by a partition
+    for (auto& partition : m_partitions)
+    {
+        m_global.uid = std::max(m_global.uid, partition->uid);
+        m_global.currentTs = std::max(m_global.currentTs, partition->currentTs);
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount() const
+{
+    return m_partitions.size();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead() const
+{
+    return m_lookahead;
+}
+
+void
+MultithreadedSimulatorImpl::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_current != nullptr)
+    {
+        m_current->stop = true;
+    }
+    else
+    {
+        m_stop = true;
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::Stop(const Time& delay)
+{
+    NS_LOG_FUNCTION(this << delay.GetTimeStep());
+    return Simulator::Schedule(delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    NS_ASSERT_MSG(m_current != nullptr || m_mainThreadId == std::this_thread::get_id(),
+                  "Simulator::Schedule Thread-unsafe invocation!");
+
+    NS_ASSERT_MSG(delay.IsPositive(), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+    const Partition* current = GetCurrent();
+    uint64_t ts = current->currentTs + delay.GetTimeStep();
+    if (m_current != nullptr)
+    {
+        return Insert(m_current, ts, current->currentContext, event);
+    }
+    return Insert(GetPartition(current->currentContext), ts, current->currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext(uint32_t context,
+                                                const Time& delay,
+                                                EventImpl* event)
+{
+    if (m_current != nullptr)
+    {
+        uint64_t ts = m_current->currentTs + delay.GetTimeStep();
+        Partition* partition = GetPartition(context);
+        if (partition == m_current)
+        {
+            Insert(partition, ts, context, event);
+            return;
+        }
+        // the other partitions may already be running this window
+        NS_ABORT_MSG_IF(ts < m_windowEnd,
+                        "Event on context " << context << " at " << TimeStep(ts)
+                                            << " within the lookahead " << m_lookahead);
+        m_current->outbox.push_back({context, ts, event});
+    }
+    else if (m_mainThreadId == std::this_thread::get_id())
+    {
+        Insert(GetPartition(context),
+               m_global.currentTs + delay.GetTimeStep(),
+               context,
+               event);
+    }
+    else
+    {
+        Message ev;
+        ev.context = context;
+        // Current time added in ProcessEventsWithContext()
+        ev.timestamp = delay.GetTimeStep();
+        ev.event = event;
+        m_eventsWithContext.Push(ev);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return Schedule(Time(0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy(EventImpl* event)
+{
+    NS_ASSERT_MSG(m_current == nullptr && m_mainThreadId == std::this_thread::get_id(),
+                  "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+
+    EventId id(Ptr<EventImpl>(event, false), m_global.currentTs, 0xffffffff, 2);
+    m_destroyEvents.push_back(id);
+    return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now() const
+{
+    // Do not add function logging here, to avoid stack overflow
+    return TimeStep(GetCurrent()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft(const EventId& id) const
+{
+    if (IsExpired(id))
+    {
+        return TimeStep(0);
+    }
+    else
+    {
+        return TimeStep(id.GetTs() - GetCurrent()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove(const EventId& id)
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        // destroy events.
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); i++)
+        {
+            if (*i == id)
+            {
+                m_destroyEvents.erase(i);
+                break;
+            }
+        }
+        return;
+    }
+    if (IsExpired(id))
+    {
+        return;
+    }
+    Partition* partition = GetPartition(id.GetContext());
+    NS_ASSERT_MSG(m_current == nullptr || m_current == partition,
+                  "Simulator::Remove of an event of another partition");
+    Scheduler::Event event;
+    event.impl = id.PeekEventImpl();
+    event.key.m_ts = id.GetTs();
+    event.key.m_context = id.GetContext();
+    event.key.m_uid = id.GetUid();
+    partition->events->Remove(event);
+    event.impl->Cancel();
+    // whenever we remove an event from the event list, we have to unref it.
+    event.impl->Unref();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel(const EventId& id)
+{
+    if (!IsExpired(id))
+    {
+        id.PeekEventImpl()->Cancel();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired(const EventId& id) const
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        if (id.PeekEventImpl() == nullptr || id.PeekEventImpl()->IsCancelled())
+        {
+            return true;
+        }
+        // destroy events.
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); i++)
+        {
+            if (*i == id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    const Partition* partition = GetPartition(id.GetContext());
+    return id.PeekEventImpl() == nullptr || id.GetTs() < partition->currentTs ||
+           (id.GetTs() == partition->currentTs && id.GetUid() <= partition->currentUid) ||
+           id.PeekEventImpl()->IsCancelled();
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime() const
+{
+    return TimeStep(0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext() const
+{
+    return GetCurrent()->currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount() const
+{
+    uint64_t count = m_global.eventCount;
+    for (const auto& partition : m_partitions)
+    {
+        count += partition->eventCount;
+    }
+    return count;
+}
+
+} // namespace ns3
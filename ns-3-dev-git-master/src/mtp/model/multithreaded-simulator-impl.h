@@ -0,0 +1,242 @@
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/mpsc-queue.h"
+#include "ns3/nstime.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/simulator-impl.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mtp
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * \defgroup mtp Multithreaded parallel simulation
+ *
+ * Conservative parallel simulation of node partitions on the threads of
+ * one process.
+ */
+
+/**
+ * \ingroup mtp
+ *
+ * \brief Simulator implementation running the node partitions on a pool
+ * of threads.
+ *
+ * The nodes of a system id form a partition with its own event list; a
+ * node is put in a partition by creating it with a system id, as for the
+ * distributed simulator. The events without a node context, and those of
+ * contexts which are not nodes, are global: they run alone, between the
+ * windows of the partitions.
+ *
+ * The partitions run in windows: the events of a window are earlier than
+ * the next global event and than the earliest event of all the partitions
+ * plus the lookahead, the smallest delay of the PointToPointChannel linking
+ * two partitions. So an event a partition schedules on another one is
+ * never in the window, and it is handed over, with its packet, at the end
+ * of the window. The packets are deep copied when they cross partitions
+ * (Packet::DeepCopy), so no packet data is shared by the threads. Any
+ * other channel, e.g., a CsmaChannel, must not link two partitions: its
+ * state is shared by all its devices.
+ *
+ * The events scheduled on a partition at the same time keep a
+ * deterministic order, whatever the number of threads, but the ties
+ * between partitions may be broken otherwise than by the default
+ * simulator. Stop() called by an event ends the run at the end of the
+ * window. Requires the NS3_MTP build option, which makes the reference
+ * counts atomic, disables the packet free lists and counts the packet
+ * Uids and the random streams per partition (GetPartitionId()).
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+  public:
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    /** Constructor. */
+    MultithreadedSimulatorImpl();
+    /** Destructor. */
+    ~MultithreadedSimulatorImpl() override;
+
+    // Inherited
+    void Destroy() override;
+    bool IsFinished() const override;
+    void Stop() override;
+    EventId Stop(const Time& delay) override;
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+    EventId ScheduleDestroy(EventImpl* event) override;
+    void Remove(const EventId& id) override;
+    void Cancel(const EventId& id) override;
+    bool IsExpired(const EventId& id) const override;
+    void Run() override;
+    Time Now() const override;
+    Time GetDelayLeft(const EventId& id) const override;
+    Time GetMaximumSimulationTime() const override;
+    void SetScheduler(ObjectFactory schedulerFactory) override;
+    uint32_t GetSystemId() const override;
+    uint32_t GetPartitionId() const override;
+    uint32_t GetContext() const override;
+    uint64_t GetEventCount() const override;
+
+    /**
+     * Get the number of partitions found by the last Run().
+     * \return The number of partitions.
+     */
+    uint32_t GetPartitionCount() const;
+    /**
+     * Get the lookahead computed by the last Run().
+     * \return The lookahead, the maximum simulation time if no channel
+     * links two partitions.
+     */
+    Time GetLookahead() const;
+
+  private:
+    void DoDispose() override;
+
+    /** An event scheduled on another partition during a window. */
+    struct Message
+    {
+        /** The event context. */
+        uint32_t context;
+        /** Event timestamp. */
+        uint64_t timestamp;
+        /** The event implementation. */
+        EventImpl* event;
+    };
+
+    /**
+     * The event list and the clock of a partition, or of the global events.
+     * Aligned so that the threads do not share cache lines.
+     */
+    struct alignas(64) Partition
+    {
+        /** The system id of the nodes. */
+        uint32_t systemId;
+        /** The event priority queue. */
+        Ptr<Scheduler> events;
+        /** Next event unique id. */
+        uint32_t uid;
+        /** Unique id of the current event. */
+        uint32_t currentUid;
+        /** Timestamp of the current event. */
+        uint64_t currentTs;
+        /** Execution context of the current event. */
+        uint32_t currentContext;
+        /** The event count. */
+        uint64_t eventCount;
+        /** Flag calling for the end of the simulation. */
+        bool stop;
+        /** The events scheduled on other partitions in this window. */
+        std::vector<Message> outbox;
+    };
+
+    /**
+     * Get the partition of the events of a context.
+     * \param [in] context The context.
+     * \return The partition, or the global events.
+     */
+    Partition* GetPartition(uint32_t context) const;
+    /**
+     * Get the partition of the calling thread.
+     * \return The partition running on this thread, or the global events.
+     */
+    const Partition* GetCurrent() const;
+    /**
+     * Insert an event in a partition.
+     * \param [in] partition The partition.
+     * \param [in] ts The event timestamp.
+     * \param [in] context The event context.
+     * \param [in] event The event implementation.
+     * \return The event id.
+     */
+    EventId Insert(Partition* partition, uint64_t ts, uint32_t context, EventImpl* event);
+    /** Put the nodes in partitions and compute the lookahead. */
+    void BuildPartitions();
+    /** Process the next global event. */
+    void ProcessGlobalEvent();
+    /** Process the events of the current window on the partitions. */
+    void ProcessWindow();
+    /**
+     * Process the events of the current window of a partition.
+     * \param [in] partition The partition.
+     */
+    void ProcessPartition(Partition* partition);
+    /** Process the partitions of the window not yet taken by a thread. */
+    void ProcessActivePartitions();
+    /** Move the events scheduled on other partitions in the window. */
+    void ProcessMessages();
+    /** Move events from a different thread into the event lists. */
+    void ProcessEventsWithContext();
+    /**
+     * Body of the worker threads.
+     * \param [in] generation The window count when the thread starts.
+     */
+    void Worker(uint64_t generation);
+
+    /** The global events, and the clock of the main thread. */
+    Partition m_global;
+    /** The partitions, in the order of their first node. */
+    std::vector<std::unique_ptr<Partition>> m_partitions;
+    /** The partitions by context, null for the global events. */
+    std::vector<Partition*> m_contexts;
+    /** The scheduler of the partitions. */
+    ObjectFactory m_schedulerFactory;
+
+    /** The smallest delay of the channels between partitions. */
+    Time m_lookahead;
+    /** The number of threads, 0 for one per hardware thread. */
+    uint32_t m_threadCount;
+    /** Whether Run() is running. */
+    bool m_running;
+    /** Flag calling for the end of the simulation. */
+    bool m_stop;
+
+    /** End of the current window, excluded. */
+    uint64_t m_windowEnd;
+    /** The partitions with events in the current window. */
+    std::vector<Partition*> m_active;
+    /** Next partition of m_active to take. */
+    std::atomic<uint32_t> m_nextActive;
+    /** Number of windows started, the worker threads wait for a new one. */
+    std::atomic<uint64_t> m_generation;
+    /** Number of worker threads done with the current window. */
+    std::atomic<uint32_t> m_done;
+    /** Flag asking the worker threads to exit. */
+    std::atomic<bool> m_quit;
+    /** The worker threads, the main thread takes part in the windows too. */
+    std::vector<std::thread> m_workers;
+
+    /** The events from a different thread, pushed without a lock. */
+    MpscQueue<Message> m_eventsWithContext;
+
+    /** Container type for the events to run at Simulator::Destroy() */
+    typedef std::list<EventId> DestroyEvents;
+    /** The container of events to run at Destroy. */
+    DestroyEvents m_destroyEvents;
+
+    /** Main execution thread. */
+    std::thread::id m_mainThreadId;
+    /** The partition run by this thread, null out of a window. */
+    static thread_local Partition* m_current;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
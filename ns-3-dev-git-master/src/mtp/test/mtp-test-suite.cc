@@ -0,0 +1,335 @@
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node.h"
+#include "ns3/object-factory.h"
+#include "ns3/packet.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mtp-tests
+ * Multithreaded simulator test suite.
+ */
+
+/**
+ * \ingroup mtp
+ * \defgroup mtp-tests Multithreaded simulator tests
+ */
+
+using namespace ns3;
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief A chain of point-to-point nodes forwarding packets hop by hop,
+ * without an internet stack. The first byte of a packet is the number of
+ * hops left; a node forwards a packet out of the device it did not come in.
+ */
+class MtpChain
+{
+  public:
+    /**
+     * Build the chain with a simulator implementation.
+     * \param [in] impl The TypeId name of the implementation.
+     * \param [in] threads The number of threads of the multithreaded simulator.
+     * \param [in] nodes The number of nodes.
+     * \param [in] perPartition The number of consecutive nodes of a system id.
+     */
+    MtpChain(std::string impl, uint32_t threads, uint32_t nodes, uint32_t perPartition);
+    /**
+     * Send packets both ways from every node.
+     * \param [in] count The number of packets per direction.
+     * \param [in] hops The number of hops of a packet.
+     */
+    void Start(uint32_t count, uint8_t hops);
+    /**
+     * Get the receptions, sorted.
+     * \return A line per reception: time, node, size and hops left.
+     */
+    std::vector<std::string> GetReceptions() const;
+
+    NodeContainer m_nodes; //!< The nodes.
+
+  private:
+    /**
+     * Send a packet.
+     * \param [in] device The device.
+     * \param [in] size The packet size.
+     * \param [in] hops The hops of the packet.
+     */
+    void Send(Ptr<NetDevice> device, uint32_t size, uint8_t hops);
+    /**
+     * Receive a packet and forward it.
+     * \param [in] device The device receiving the packet.
+     * \param [in] packet The packet.
+     * \param [in] protocol The protocol.
+     * \param [in] from The sender.
+     * \return true
+     */
+    bool Receive(Ptr<NetDevice> device,
+                 Ptr<const Packet> packet,
+                 uint16_t protocol,
+                 const Address& from);
+
+    /** The receptions of each node, each one written by the thread of its node. */
+    std::vector<std::vector<std::string>> m_receptions;
+};
+
+MtpChain::MtpChain(std::string impl, uint32_t threads, uint32_t nodes, uint32_t perPartition)
+{
+    Simulator::Destroy();
+    ObjectFactory factory;
+    factory.SetTypeId(impl);
+    if (threads > 0)
+    {
+        factory.Set("ThreadCount", UintegerValue(threads));
+    }
+    Simulator::SetImplementation(factory.Create<SimulatorImpl>());
+
+    for (uint32_t i = 0; i < nodes; ++i)
+    {
+        m_nodes.Add(CreateObject<Node>(i / perPartition));
+    }
+    m_receptions.resize(nodes);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("10Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+    for (uint32_t i = 0; i + 1 < nodes; ++i)
+    {
+        NetDeviceContainer devices = p2p.Install(m_nodes.Get(i), m_nodes.Get(i + 1));
+        for (uint32_t j = 0; j < devices.GetN(); ++j)
+        {
+            devices.Get(j)->SetReceiveCallback(MakeCallback(&MtpChain::Receive, this));
+        }
+    }
+}
+
+void
+MtpChain::Start(uint32_t count, uint8_t hops)
+{
+    for (uint32_t i = 0; i < m_nodes.GetN(); ++i)
+    {
+        Ptr<Node> node = m_nodes.Get(i);
+        for (uint32_t j = 0; j < node->GetNDevices(); ++j)
+        {
+            for (uint32_t k = 0; k < count; ++k)
+            {
+                Simulator::ScheduleWithContext(node->GetId(),
+                                               MicroSeconds(100 * i + 500 * k),
+                                               &MtpChain::Send,
+                                               this,
+                                               node->GetDevice(j),
+                                               100 + 10 * i + k,
+                                               hops);
+            }
+        }
+    }
+}
+
+void
+MtpChain::Send(Ptr<NetDevice> device, uint32_t size, uint8_t hops)
+{
+    std::vector<uint8_t> buffer(size, 0);
+    buffer[0] = hops;
+    device->Send(Create<Packet>(buffer.data(), size), device->GetBroadcast(), 0x0800);
+}
+
+bool
+MtpChain::Receive(Ptr<NetDevice> device,
+                  Ptr<const Packet> packet,
+                  uint16_t protocol,
+                  const Address& from)
+{
+    Ptr<Node> node = device->GetNode();
+    uint8_t hops;
+    packet->CopyData(&hops, 1);
+    std::ostringstream oss;
+    oss << Simulator::Now().GetNanoSeconds() << " " << node->GetId() << " " << packet->GetSize()
+        << " " << +hops;
+    m_receptions[node->GetId()].push_back(oss.str());
+
+    if (hops > 1 && node->GetNDevices() == 2)
+    {
+        Ptr<NetDevice> out = node->GetDevice(node->GetDevice(0) == device ? 1 : 0);
+        Send(out, packet->GetSize(), hops - 1);
+    }
+    return true;
+}
+
+std::vector<std::string>
+MtpChain::GetReceptions() const
+{
+    std::vector<std::string> receptions;
+    for (const auto& node : m_receptions)
+    {
+        receptions.insert(receptions.end(), node.begin(), node.end());
+    }
+    std::sort(receptions.begin(), receptions.end());
+    return receptions;
+}
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief The partitions of a point-to-point chain receive the same packets
+ * at the same times as with the default simulator, whatever the number of
+ * threads.
+ */
+class MtpChainTestCase : public TestCase
+{
+  public:
+    MtpChainTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+MtpChainTestCase::MtpChainTestCase()
+    : TestCase("Point-to-point chain on partitions")
+{
+}
+
+void
+MtpChainTestCase::DoRun()
+{
+    std::vector<std::string> reference;
+    uint64_t events;
+    {
+        MtpChain chain("ns3::DefaultSimulatorImpl", 0, 8, 2);
+        chain.Start(20, 4);
+        Simulator::Run();
+        reference = chain.GetReceptions();
+        events = Simulator::GetEventCount();
+    }
+    NS_TEST_ASSERT_MSG_EQ(reference.empty(), false, "no packet received");
+
+    for (uint32_t threads : {1, 2, 4})
+    {
+        MtpChain chain("ns3::MultithreadedSimulatorImpl", threads, 8, 2);
+        chain.Start(20, 4);
+        Simulator::Run();
+        Ptr<MultithreadedSimulatorImpl> impl =
+            DynamicCast<MultithreadedSimulatorImpl>(Simulator::GetImplementation());
+        NS_TEST_ASSERT_MSG_NE(impl, nullptr, "multithreaded simulator not used");
+        NS_TEST_EXPECT_MSG_EQ(impl->GetPartitionCount(), 4, "wrong number of partitions");
+        NS_TEST_EXPECT_MSG_EQ(impl->GetLookahead(), MilliSeconds(2), "wrong lookahead");
+        NS_TEST_EXPECT_MSG_EQ(Simulator::GetEventCount(), events, "wrong number of events");
+        std::vector<std::string> receptions = chain.GetReceptions();
+        NS_TEST_ASSERT_MSG_EQ(receptions.size(), reference.size(), "wrong number of receptions");
+        for (std::size_t i = 0; i < reference.size(); ++i)
+        {
+            NS_TEST_EXPECT_MSG_EQ(receptions[i], reference[i], "different reception");
+        }
+    }
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief The global events run between the windows of the partitions,
+ * at their time, and Stop ends the run.
+ */
+class MtpGlobalEventTestCase : public TestCase
+{
+  public:
+    MtpGlobalEventTestCase();
+
+  private:
+    void DoRun() override;
+    /** A global event, scheduling an event on the last node. */
+    void Global();
+    /** An event of the last node. */
+    void Local();
+
+    Time m_global;          //!< Time of the global event.
+    uint32_t m_globalContext; //!< Context of the global event.
+    Time m_local;           //!< Time of the event of the last node.
+    uint32_t m_localContext;  //!< Context of the event of the last node.
+    uint64_t m_globalUid;     //!< Uid of a packet created by the global event.
+    uint64_t m_localUid;      //!< Uid of a packet created by the last node.
+    uint64_t m_localStream;   //!< Stream index drawn by the last node.
+};
+
+MtpGlobalEventTestCase::MtpGlobalEventTestCase()
+    : TestCase("Global events and stop")
+{
+}
+
+void
+MtpGlobalEventTestCase::Global()
+{
+    m_global = Simulator::Now();
+    m_globalContext = Simulator::GetContext();
+    m_globalUid = Create<Packet>()->GetUid();
+    Simulator::ScheduleWithContext(3, MicroSeconds(10), &MtpGlobalEventTestCase::Local, this);
+}
+
+void
+MtpGlobalEventTestCase::Local()
+{
+    m_local = Simulator::Now();
+    m_localContext = Simulator::GetContext();
+    m_localUid = Create<Packet>()->GetUid();
+    m_localStream = RngSeedManager::GetNextStreamIndex();
+}
+
+void
+MtpGlobalEventTestCase::DoRun()
+{
+    MtpChain chain("ns3::MultithreadedSimulatorImpl", 2, 4, 1);
+    chain.Start(100, 2);
+    Simulator::Schedule(MilliSeconds(5), &MtpGlobalEventTestCase::Global, this);
+    Simulator::Stop(MilliSeconds(20));
+    Simulator::Run();
+
+    NS_TEST_EXPECT_MSG_EQ(m_global, MilliSeconds(5), "wrong time of the global event");
+    NS_TEST_EXPECT_MSG_EQ(m_globalContext, Simulator::NO_CONTEXT, "wrong global context");
+    NS_TEST_EXPECT_MSG_EQ(m_local, MilliSeconds(5) + MicroSeconds(10), "wrong time of the event");
+    NS_TEST_EXPECT_MSG_EQ(m_localContext, 3, "wrong context of the event");
+    // the packets and the streams are counted per partition
+    NS_TEST_EXPECT_MSG_EQ((m_globalUid >> 32), 0, "wrong partition of the global packet");
+    NS_TEST_EXPECT_MSG_EQ((m_localUid >> 32), 3, "wrong partition of the packet");
+    NS_TEST_EXPECT_MSG_EQ((m_localStream >> 32), 3, "wrong partition of the stream");
+    NS_TEST_EXPECT_MSG_EQ(Simulator::Now(), MilliSeconds(20), "wrong stop time");
+    NS_TEST_EXPECT_MSG_EQ(Simulator::IsFinished(), true, "not stopped");
+
+    std::vector<std::string> receptions = chain.GetReceptions();
+    NS_TEST_ASSERT_MSG_EQ(receptions.empty(), false, "no packet received");
+    for (const auto& reception : receptions)
+    {
+        std::istringstream iss(reception);
+        int64_t ns;
+        iss >> ns;
+        NS_TEST_EXPECT_MSG_LT(ns, MilliSeconds(20).GetNanoSeconds(), "packet received after stop");
+    }
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief Multithreaded simulator TestSuite
+ */
+class MtpTestSuite : public TestSuite
+{
+  public:
+    MtpTestSuite()
+        : TestSuite("mtp", UNIT)
+    {
+        AddTestCase(new MtpChainTestCase, TestCase::QUICK);
+        AddTestCase(new MtpGlobalEventTestCase, TestCase::QUICK);
+    }
+};
+
+static MtpTestSuite g_mtpTestSuite; //!< Static variable for test initialization
@@ -25,7 +25,12 @@
 #include <stdint.h>
 #include <vector>
 
+#ifndef NS3_MTP
+// The free lists of the buffers, of the byte tag lists and of the packet
+// metadata are not locked: a multithreaded simulation, which creates and
+// frees packets on all its threads, allocates them without the free lists.
 #define BUFFER_FREE_LIST 1
+#endif
 
 namespace ns3
 {
@@ -100,6 +105,17 @@ class Buffer
     {
       public:
         inline Iterator();
+        /**
+         * Constructor over bytes which are not owned by a Buffer, to
+         * serialize or deserialize a header to a fixed array without
+         * creating a Buffer.
+         *
+         * The bytes must outlive the iterator.
+         *
+         * \param data the first byte
+         * \param size the number of bytes
+         */
+        inline Iterator(uint8_t* data, uint32_t size);
         /**
          * go forward by one byte
          */
@@ -769,7 +785,11 @@ class Buffer
      * writing data. i.e., m_start should be initialized to this
      * value.
      */
+#ifdef NS3_MTP
+    static thread_local uint32_t g_recommendedStart;
+#else
     static uint32_t g_recommendedStart;
+#endif
 
     /**
      * offset to the start of the virtual zero area from the start
@@ -827,6 +847,16 @@ Buffer::Iterator::Iterator()
 {
 }
 
+Buffer::Iterator::Iterator(uint8_t* data, uint32_t size)
+    : m_zeroStart(size),
+      m_zeroEnd(size),
+      m_dataStart(0),
+      m_dataEnd(size),
+      m_current(0),
+      m_data(data)
+{
+}
+
 Buffer::Iterator::Iterator(const Buffer* buffer)
 {
     Construct(buffer);
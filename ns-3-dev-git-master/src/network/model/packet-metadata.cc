@@ -36,7 +36,11 @@ NS_LOG_COMPONENT_DEFINE("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+#ifdef NS3_MTP
+std::atomic<bool> PacketMetadata::m_metadataSkipped = false;
+#else
 bool PacketMetadata::m_metadataSkipped = false;
+#endif
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
 PacketMetadata::DataFreeList PacketMetadata::m_freeList;
@@ -567,6 +571,9 @@ PacketMetadata::Data*
 PacketMetadata::Create(uint32_t size)
 {
     NS_LOG_FUNCTION(size);
+#ifdef NS3_MTP
+    return PacketMetadata::Allocate(size);
+#else
     NS_LOG_LOGIC("create size=" << size << ", max=" << m_maxSize);
     if (size > m_maxSize)
     {
@@ -587,12 +594,16 @@ PacketMetadata::Create(uint32_t size)
     }
     NS_LOG_LOGIC("create alloc size=" << m_maxSize);
     return PacketMetadata::Allocate(m_maxSize);
+#endif
 }
 
 void
 PacketMetadata::Recycle(PacketMetadata::Data* data)
 {
     NS_LOG_FUNCTION(data);
+#ifdef NS3_MTP
+    PacketMetadata::Deallocate(data);
+#else
     if (!m_enable)
     {
         PacketMetadata::Deallocate(data);
@@ -608,6 +619,7 @@ PacketMetadata::Recycle(PacketMetadata::Data* data)
     {
         m_freeList.push_back(data);
     }
+#endif
 }
 
 PacketMetadata::Data*
@@ -24,13 +24,59 @@
 
 #include <cstdarg>
 #include <string>
+#include <vector>
+
+#ifdef NS3_MTP
+#include <map>
+#include <mutex>
+#endif
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("Packet");
 
+#ifdef NS3_MTP
+/**
+ * \ingroup packet
+ * Get the packet Uid counter of the partition running the current event.
+ *
+ * The partitions of a multithreaded simulation run concurrently: each one
+ * counts its own packets, so that the Uids do not depend on the threads
+ * and the counters are not shared. A partition only runs on one thread at
+ * a time, and a thread keeps the counter of its last partition.
+ *
+ * \returns The counter.
+ */
+static uint32_t&
+GetPartitionUid()
+{
+    static std::mutex mutex;
+    static std::map<uint32_t, uint32_t> counters;
+    thread_local uint32_t partition = 0;
+    thread_local uint32_t* counter = nullptr;
+    uint32_t current = Simulator::GetPartitionId();
+    if (counter == nullptr || current != partition)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        partition = current;
+        counter = &counters[current];
+    }
+    return *counter;
+}
+#else
 uint32_t Packet::m_globalUid = 0;
+#endif
+
+uint64_t
+Packet::GetNextUid()
+{
+#ifdef NS3_MTP
+    return static_cast<uint64_t>(Simulator::GetPartitionId()) << 32 | GetPartitionUid()++;
+#else
+    return static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid++;
+#endif
+}
 
 TypeId
 ByteTagIterator::Item::GetTypeId() const
@@ -136,20 +182,47 @@ Packet::Copy() const
     return Ptr<Packet>(new Packet(*this), false);
 }
 
+Ptr<Packet>
+Packet::DeepCopy() const
+{
+    NS_LOG_FUNCTION(this);
+    Buffer buffer;
+    buffer.AddAtStart(m_buffer.GetSize());
+    buffer.Begin().Write(m_buffer.Begin(), m_buffer.End());
+
+    ByteTagList byteTagList;
+    byteTagList.Add(m_byteTagList);
+
+    // the tag lists and the metadata are rebuilt from their serialized
+    // form, with the 4 bytes length prefix expected by Deserialize
+    PacketTagList packetTagList;
+    uint32_t packetTagSize = m_packetTagList.GetSerializedSize();
+    std::vector<uint32_t> packetTags((packetTagSize + 3) / 4);
+    m_packetTagList.Serialize(packetTags.data(), packetTagSize);
+    packetTagList.Deserialize(packetTags.data(), packetTagSize + 4);
+
+    PacketMetadata metadata(m_metadata.GetUid(), 0);
+    uint32_t metaSize = m_metadata.GetSerializedSize();
+    std::vector<uint8_t> meta(metaSize);
+    m_metadata.Serialize(meta.data(), metaSize);
+    metadata.Deserialize(meta.data(), metaSize + 4);
+
+    Ptr<Packet> p =
+        Ptr<Packet>(new Packet(buffer, byteTagList, packetTagList, metadata), false);
+    if (m_nixVector)
+    {
+        p->SetNixVector(m_nixVector->Copy());
+    }
+    return p;
+}
+
 Packet::Packet()
     : m_buffer(),
       m_byteTagList(),
       m_packetTagList(),
-      /* The upper 32 bits of the packet id in
-       * metadata is for the system id. For non-
-       * distributed simulations, this is simply
-       * zero.  The lower 32 bits are for the
-       * global UID
-       */
-      m_metadata(static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid, 0),
+      m_metadata(GetNextUid(), 0),
       m_nixVector(nullptr)
 {
-    m_globalUid++;
 }
 
 Packet::Packet(const Packet& o)
@@ -180,16 +253,9 @@ Packet::Packet(uint32_t size)
     : m_buffer(size),
       m_byteTagList(),
       m_packetTagList(),
-      /* The upper 32 bits of the packet id in
-       * metadata is for the system id. For non-
-       * distributed simulations, this is simply
-       * zero.  The lower 32 bits are for the
-       * global UID
-       */
-      m_metadata(static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid, size),
+      m_metadata(GetNextUid(), size),
       m_nixVector(nullptr)
 {
-    m_globalUid++;
 }
 
 Packet::Packet(const uint8_t* buffer, uint32_t size, bool magic)
@@ -207,16 +273,9 @@ Packet::Packet(const uint8_t* buffer, uint32_t size)
     : m_buffer(),
       m_byteTagList(),
       m_packetTagList(),
-      /* The upper 32 bits of the packet id in
-       * metadata is for the system id. For non-
-       * distributed simulations, this is simply
-       * zero.  The lower 32 bits are for the
-       * global UID
-       */
-      m_metadata(static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid, size),
+      m_metadata(GetNextUid(), size),
       m_nixVector(nullptr)
 {
-    m_globalUid++;
     m_buffer.AddAtStart(size);
     Buffer::Iterator i = m_buffer.Begin();
     i.Write(buffer, size);
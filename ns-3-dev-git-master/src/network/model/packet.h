@@ -459,6 +459,18 @@ class Packet : public SimpleRefCount<Packet>
      */
     Ptr<Packet> Copy() const;
 
+    /**
+     * \brief performs a deep copy of the packet.
+     *
+     * \returns a copy of the packet which shares no dataset with
+     * the original packet.
+     *
+     * The copy can be handed over to another thread while the original
+     * packet is still in use, e.g., between the partitions of a
+     * multithreaded simulation. It keeps the Uid of the original packet.
+     */
+    Ptr<Packet> DeepCopy() const;
+
     /**
      * \brief Returns the packet's Uid.
      *
@@ -787,6 +799,18 @@ class Packet : public SimpleRefCount<Packet>
      */
     uint32_t Deserialize(const uint8_t* buffer, uint32_t size);
 
+    /**
+     * \brief Get the Uid of a new packet.
+     *
+     * The upper 32 bits of the Uid are the system id of the partition
+     * creating the packet, the lower 32 bits count the packets of the
+     * partition. For non-distributed simulations the system id is simply
+     * zero.
+     *
+     * \returns the Uid.
+     */
+    static uint64_t GetNextUid();
+
     Buffer m_buffer;               //!< the packet buffer (it's actual contents)
     ByteTagList m_byteTagList;     //!< the ByteTag list
     PacketTagList m_packetTagList; //!< the packet's Tag list
@@ -795,7 +819,9 @@ class Packet : public SimpleRefCount<Packet>
     /* Please see comments above about nix-vector */
     mutable Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
+#ifndef NS3_MTP
     static uint32_t m_globalUid; //!< Global counter of packets Uid
+#endif
 };
 
 /**
@@ -393,6 +393,19 @@ BufferTest::DoRun()
     val2 <<= 8;
     val2 |= i.ReadU8();
     NS_TEST_ASSERT_MSG_EQ(val1, val2, "Bad ReadNtohU16()");
+
+    // iterator over bytes not owned by a Buffer
+    uint8_t bytes[6] = {0};
+    Buffer::Iterator raw(bytes, sizeof(bytes));
+    raw.WriteU8(0x11);
+    raw.WriteHtonU32(0x22334455);
+    raw.WriteU8(0x66);
+    NS_TEST_ASSERT_MSG_EQ(raw.IsEnd(), true, "Bad end of the bytes");
+    NS_TEST_ASSERT_MSG_EQ(bytes[4], 0x55, "Bad write to the bytes");
+    raw = Buffer::Iterator(bytes, sizeof(bytes));
+    raw.Next(1);
+    NS_TEST_ASSERT_MSG_EQ(raw.ReadNtohU32(), 0x22334455, "Bad read from the bytes");
+    NS_TEST_ASSERT_MSG_EQ(raw.GetRemainingSize(), 1, "Bad size of the bytes");
 }
 
 /**
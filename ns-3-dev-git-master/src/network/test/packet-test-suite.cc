@@ -956,6 +956,38 @@ PacketTest::DoRun()
         ALargeTestTag a;
         tmp->AddPacketTag(a);
     }
+
+    /* Test DeepCopy */
+    {
+        Ptr<Packet> tmp = Create<Packet>(reinterpret_cast<const uint8_t*>("hello world"), 11);
+        tmp->AddHeader(ATestHeader<10>());
+        tmp->AddByteTag(ATestTag<26>());
+        tmp->RemoveAtStart(5);
+        tmp->AddPacketTag(ATestTag<27>(27));
+        Ptr<Packet> deep = tmp->DeepCopy();
+        NS_TEST_EXPECT_MSG_EQ(deep->GetUid(), tmp->GetUid(), "uid of the deep copy");
+        NS_TEST_EXPECT_MSG_EQ(deep->GetSize(), tmp->GetSize(), "size of the deep copy");
+        CHECK(deep, 1, E(26, 0, 16));
+        ATestTag<27> tag;
+        NS_TEST_EXPECT_MSG_EQ(deep->PeekPacketTag(tag), true, "packet tag of the deep copy");
+        NS_TEST_EXPECT_MSG_EQ(tag.GetData(), 27, "packet tag data of the deep copy");
+
+        // the deep copy owns its data
+        deep->AddHeader(ATestHeader<5>());
+        deep->RemovePacketTag(tag);
+        CHECK(tmp, 1, E(26, 0, 16));
+        NS_TEST_EXPECT_MSG_EQ(tmp->PeekPacketTag(tag), true, "packet tag of the original");
+        uint8_t original[16];
+        uint8_t copied[21];
+        tmp->CopyData(original, 16);
+        deep->CopyData(copied, 21);
+        NS_TEST_EXPECT_MSG_EQ(std::string(reinterpret_cast<char*>(original) + 5, 11),
+                              "hello world",
+                              "data of the original");
+        NS_TEST_EXPECT_MSG_EQ(std::string(reinterpret_cast<char*>(copied) + 10, 11),
+                              "hello world",
+                              "data of the deep copy");
+    }
 }
 
 /**
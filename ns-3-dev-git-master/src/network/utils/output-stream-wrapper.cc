@@ -19,6 +19,7 @@
 
 #include "ns3/abort.h"
 #include "ns3/fatal-impl.h"
+#include "ns3/fork-impl.h"
 #include "ns3/log.h"
 
 #include <fstream>
@@ -39,6 +40,7 @@ OutputStreamWrapper::OutputStreamWrapper(std::string filename, std::ios::openmod
     NS_ABORT_MSG_UNLESS(os->is_open(),
                         "AsciiTraceHelper::CreateFileStream():  "
                             << "Unable to Open " << filename << " for mode " << filemode);
+    ForkImpl::RegisterFile(os->rdbuf(), filename, filemode);
 }
 
 OutputStreamWrapper::OutputStreamWrapper(std::ostream* os)
@@ -56,6 +58,7 @@ OutputStreamWrapper::~OutputStreamWrapper()
     FatalImpl::UnregisterStream(m_ostream);
     if (m_destroyable)
     {
+        ForkImpl::UnregisterFile(static_cast<std::ofstream*>(m_ostream)->rdbuf());
         delete m_ostream;
     }
     m_ostream = nullptr;
@@ -24,6 +24,7 @@
 #include "ns3/build-profile.h"
 #include "ns3/fatal-error.h"
 #include "ns3/fatal-impl.h"
+#include "ns3/fork-impl.h"
 #include "ns3/header.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
@@ -92,6 +93,7 @@ void
 PcapFile::Close()
 {
     NS_LOG_FUNCTION(this);
+    ForkImpl::UnregisterFile(m_file.rdbuf());
     m_file.close();
 }
 
@@ -340,6 +342,7 @@ PcapFile::Open(const std::string& filename, std::ios::openmode mode)
 
     m_filename = filename;
     m_file.open(filename, mode);
+    ForkImpl::RegisterFile(m_file.rdbuf(), filename, mode);
     if (mode & std::ios::in)
     {
         // will set the fail bit if file header is invalid.
@@ -96,11 +96,25 @@ PointToPointChannel::TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevic
 
     uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
+    Ptr<Packet> copy;
+#ifdef NS3_MTP
+    // the nodes of different systems run on different threads in a
+    // multithreaded simulation, they must not share the packet data
+    if (src->GetNode()->GetSystemId() != m_link[wire].m_dst->GetNode()->GetSystemId())
+    {
+        copy = p->DeepCopy();
+    }
+    else
+#endif
+    {
+        copy = p->Copy();
+    }
+
     Simulator::ScheduleWithContext(m_link[wire].m_dst->GetNode()->GetId(),
                                    txTime + m_delay,
                                    &PointToPointNetDevice::Receive,
                                    m_link[wire].m_dst,
-                                   p->Copy());
+                                   copy);
 
     // Call the tx anim callback on the net device
     m_txrxPointToPoint(p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
@@ -0,0 +1,377 @@
+// HA/CN/MR topology split over the ranks of a distributed simulation.
+//
+// The HA runs on rank 0, the CN on the last rank and the MRs round robin on
+// all the ranks. Each MR has a point-to-point link to the HA, which stands
+// for the two ARs of the link (one /64 prefix each); the CN has a link to the
+// HA. The MRs register from their first CoA, hand over to the second AR, then
+// the CN sends UDP packets to their home addresses: the BUs, the BAs and the
+// tunnelled packets cross the ranks through the remote point-to-point
+// channels.
+//
+// Each rank prints the results of the nodes it runs: with --test, the sorted
+// output does not depend on the number of ranks.
+//
+// Sample usage:  ./ns3 run sr-distributed --command-template="mpiexec -np 2 %s --mrs=8"
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/global-value.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/mac48-address.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/string.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/bcache.h"
+#include "ns3/ha.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-mn.h"
+#include "ns3/sr-tun-l4-protocol.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing
+ *
+ * \brief Counters of an MR.
+ */
+struct MrStats
+{
+  MrStats ()
+    : ba (0),
+      handovers (0),
+      rx (0)
+  {
+  }
+
+  uint32_t ba;          //!< BAs received
+  uint32_t handovers;   //!< handovers completed
+  Time interruption;    //!< interruption of the last handover
+  uint32_t rx;          //!< packets received on the HoA
+  Time lastRx;          //!< reception time of the last packet
+};
+
+static std::vector<MrStats> g_stats;     //!< counters of the MRs of this rank
+static uint32_t g_buRx = 0;              //!< BUs received by the HA
+
+/**
+ * \brief Get the address of an MR on a prefix.
+ *
+ * The address is taken from the MAC address of the access device, which is
+ * the same on all the ranks: it is known even if the MR runs on another rank.
+ *
+ * \param prefix the /64 prefix
+ * \param mr the MR
+ * \return the address with the interface identifier of the MR
+ */
+static Ipv6Address
+MakeAddress (Ipv6Address prefix, Ptr<Node> mr)
+{
+  //device 0 is the loopback
+  return Ipv6Address::MakeAutoconfiguredAddress (Mac48Address::ConvertFrom (mr->GetDevice (1)->GetAddress ()), prefix);
+}
+
+/**
+ * \brief Get the link-local address of a device.
+ * \param device the device
+ * \return the link-local address of the device
+ */
+static Ipv6Address
+MakeLinkLocal (Ptr<NetDevice> device)
+{
+  return Ipv6Address::MakeAutoconfiguredLinkLocalAddress (Mac48Address::ConvertFrom (device->GetAddress ()));
+}
+
+/**
+ * \brief Configure the CoA of an MR on a prefix of its link and attach.
+ * \param mr the MR
+ * \param oldPrefix the prefix of the former CoA, any if none
+ * \param prefix the prefix of the new CoA
+ * \param linkLocalHa the link-local address of the HA on the link
+ */
+static void
+Attach (Ptr<Node> mr, Ipv6Address oldPrefix, Ipv6Address prefix, Ipv6Address linkLocalHa)
+{
+  Ptr<Ipv6> ipv6 = mr->GetObject<Ipv6> ();
+  Ipv6StaticRoutingHelper routingHelper;
+  Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
+  if (!oldPrefix.IsAny ())
+    {
+      ipv6->RemoveAddress (1, MakeAddress (oldPrefix, mr));
+      routing->RemoveRoute (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), 1, oldPrefix);
+    }
+  Ipv6Address coa = MakeAddress (prefix, mr);
+  ipv6->AddAddress (1, Ipv6InterfaceAddress (coa, Ipv6Prefix (64)));
+
+  //default route learnt from the AR, the HA stands for it
+  routing->AddNetworkRouteTo (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), linkLocalHa, 1, prefix, 0);
+  Ptr<Mipv6Mn> mn = mr->GetObject<Mipv6Mn> ();
+  mn->SetDefaultRouterAddress (linkLocalHa, 1);
+  mn->NotifyAttachment (coa);
+}
+
+/**
+ * \brief Count a BU received by the HA.
+ * \param packet the BU
+ * \param src source address
+ * \param dst destination address
+ * \param interface the receiving interface
+ */
+static void
+RxBu (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
+{
+  g_buRx++;
+}
+
+/**
+ * \brief Count a BA received by an MR.
+ * \param mr index of the MR
+ * \param packet the BA
+ * \param src source address
+ * \param dst destination address
+ * \param interface the receiving interface
+ */
+static void
+RxBa (uint32_t mr, Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
+{
+  g_stats[mr].ba++;
+}
+
+/**
+ * \brief Record a handover of an MR.
+ * \param mr index of the MR
+ * \param interruption the interruption time
+ * \param predictive whether the handover was prepared
+ * \param oldCoa the CoA before the handover
+ * \param newCoa the CoA after the handover
+ */
+static void
+Handover (uint32_t mr, Time interruption, bool predictive, Ipv6Address oldCoa, Ipv6Address newCoa)
+{
+  g_stats[mr].handovers++;
+  g_stats[mr].interruption = interruption;
+}
+
+/**
+ * \brief Count the packets received by an MR on its HoA.
+ * \param mr index of the MR
+ * \param socket the socket
+ */
+static void
+Receive (uint32_t mr, Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      g_stats[mr].rx++;
+      g_stats[mr].lastRx = Simulator::Now ();
+    }
+}
+
+/**
+ * \brief Send a packet from the CN.
+ * \param socket the socket of the CN
+ * \param hoa the HoA of the MR
+ */
+static void
+Send (Ptr<Socket> socket, Ipv6Address hoa)
+{
+  socket->SendTo (Create<Packet> (512), 0, Inet6SocketAddress (hoa, 9));
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nMrs = 6;
+  uint32_t packets = 5;
+  bool nullmsg = false;
+  bool testing = false;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("mrs", "number of MRs", nMrs);
+  cmd.AddValue ("packets", "packets sent by the CN to each MR", packets);
+  cmd.AddValue ("nullmsg", "use the null-message synchronization", nullmsg);
+  cmd.AddValue ("test", "print the regression test output", testing);
+  cmd.Parse (argc, argv);
+
+  if (nullmsg)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::NullMessageSimulatorImpl"));
+    }
+  else
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+    }
+  MpiInterface::Enable (&argc, &argv);
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  uint32_t systemCount = MpiInterface::GetSize ();
+
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (false));
+
+  Ptr<Node> ha = CreateObject<Node> (0);
+  Ptr<Node> cn = CreateObject<Node> (systemCount - 1);
+  NodeContainer mrs;
+  for (uint32_t i = 0; i < nMrs; i++)
+    {
+      mrs.Add (CreateObject<Node> ((i + 1) % systemCount));
+    }
+
+  //every rank builds the whole topology, with the same devices and MAC
+  //addresses, but only sets up the interfaces of its nodes: the nodes of the
+  //other ranks would send their RSs into the remote channels
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.InstallAll ();
+  bool haLocal = ha->GetSystemId () == systemId;
+  bool cnLocal = cn->GetSystemId () == systemId;
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  Ipv6AddressHelper ipv6helper;
+  Ptr<Ipv6> haIpv6 = ha->GetObject<Ipv6> ();
+
+  //home link, the HA alone
+  SimpleNetDeviceHelper homeLink;
+  NetDeviceContainer homeDevice = homeLink.Install (ha);
+  Ipv6Address haAddress = Ipv6Address::MakeAutoconfiguredAddress (Mac48Address::ConvertFrom (homeDevice.Get (0)->GetAddress ()),
+                                                                  Ipv6Address ("2001:1::"));
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  if (haLocal)
+    {
+      ipv6helper.Assign (homeDevice);
+    }
+
+  NetDeviceContainer cnLink = p2p.Install (cn, ha);
+  ipv6helper.SetBase (Ipv6Address ("2001:cafe::"), Ipv6Prefix (64));
+  if (cnLocal)
+    {
+      ipv6helper.Assign (NetDeviceContainer (cnLink.Get (0)));
+      Ipv6StaticRoutingHelper routingHelper;
+      routingHelper.GetStaticRouting (cn->GetObject<Ipv6> ())->SetDefaultRoute (MakeLinkLocal (cnLink.Get (1)), 1);
+    }
+  if (haLocal)
+    {
+      ipv6helper.Assign (NetDeviceContainer (cnLink.Get (1)));
+    }
+
+  //one link per MR, the HA stands for its two ARs
+  std::vector<Ipv6Address> arPrefix;
+  std::vector<Ipv6Address> linkLocalHa;
+  for (uint32_t i = 0; i < nMrs; i++)
+    {
+      NetDeviceContainer link = p2p.Install (mrs.Get (i), ha);
+      for (uint8_t ar = 0; ar < 2; ar++)
+        {
+          uint8_t buf[16] = { 0x20, 0x01, 0x00, uint8_t (0x0a + ar), 0x00, 0x00, uint8_t (i >> 8), uint8_t (i) };
+          arPrefix.push_back (Ipv6Address (buf));
+          ipv6helper.SetBase (arPrefix.back (), Ipv6Prefix (64));
+          if (haLocal)
+            {
+              ipv6helper.Assign (NetDeviceContainer (link.Get (1)));
+            }
+        }
+      if (mrs.Get (i)->GetSystemId () == systemId)
+        {
+          ipv6helper.AssignWithoutAddress (NetDeviceContainer (link.Get (0)));
+        }
+      linkLocalHa.push_back (MakeLinkLocal (link.Get (1)));
+    }
+
+  //the helpers only install the stacks of the nodes of this rank
+  Mipv6HaHelper haHelper;
+  haHelper.Install (ha);
+  Mipv6MnHelper mnHelper (std::list<Ipv6Address> (1, haAddress), false, std::list<Ipv6Address> ());
+  mnHelper.Install (mrs);
+
+  if (haLocal)
+    {
+      haIpv6->SetAttribute ("IpForward", BooleanValue (true));
+      //the HA address is on the home link, the BUs arrive on the access links
+      haIpv6->SetAttribute ("StrongEndSystemModel", BooleanValue (false));
+      //the HoA routes of the HA go through its tunnel interface, which needs a global address
+      uint32_t tunnelIf = ha->GetObject<Ipv6TunnelL4Protocol> ()->CreateTunnelDevice ();
+      haIpv6->AddAddress (tunnelIf, Ipv6InterfaceAddress (Ipv6Address ("2001:1:0:1::1"), Ipv6Prefix (64)));
+      ha->GetObject<Mipv6Ha> ()->TraceConnectWithoutContext ("RxBU", MakeCallback (&RxBu));
+    }
+
+  g_stats.resize (nMrs);
+  TypeId udp = UdpSocketFactory::GetTypeId ();
+  for (uint32_t i = 0; i < nMrs; i++)
+    {
+      Ptr<Node> mr = mrs.Get (i);
+      if (mr->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      Ptr<Mipv6Mn> mn = mr->GetObject<Mipv6Mn> ();
+      mn->TraceConnectWithoutContext ("RxBA", MakeBoundCallback (&RxBa, i));
+      mn->TraceConnectWithoutContext ("Handover", MakeBoundCallback (&Handover, i));
+      Ptr<Socket> sink = Socket::CreateSocket (mr, udp);
+      sink->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 9));
+      sink->SetRecvCallback (MakeBoundCallback (&Receive, i));
+
+      Time offset = MilliSeconds (10 * i);
+      Simulator::ScheduleWithContext (mr->GetId (), Seconds (1) + offset, &Attach, mr,
+                                      Ipv6Address::GetAny (), arPrefix[2 * i], linkLocalHa[i]);
+      Simulator::ScheduleWithContext (mr->GetId (), Seconds (3) + offset, &Attach, mr,
+                                      arPrefix[2 * i], arPrefix[2 * i + 1], linkLocalHa[i]);
+    }
+
+  if (cnLocal)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (cn, udp);
+      socket->Bind6 ();
+      for (uint32_t i = 0; i < nMrs; i++)
+        {
+          Ipv6Address hoa = MakeAddress (haAddress, mrs.Get (i));
+          for (uint32_t k = 0; k < packets; k++)
+            {
+              Simulator::ScheduleWithContext (cn->GetId (), Seconds (5) + MilliSeconds (10 * k + i),
+                                              &Send, socket, hoa);
+            }
+        }
+    }
+
+  Simulator::Stop (Seconds (7));
+  Simulator::Run ();
+
+  if (haLocal)
+    {
+      PointerValue bcache;
+      ha->GetObject<Mipv6Ha> ()->GetAttribute ("BCache", bcache);
+      std::cout << (testing ? "TEST : " : "") << "HA : BUs " << g_buRx
+                << " : bindings " << bcache.Get<BCache> ()->GetSize () << std::endl;
+    }
+  for (uint32_t i = 0; i < nMrs; i++)
+    {
+      if (mrs.Get (i)->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      const MrStats &stats = g_stats[i];
+      std::cout << (testing ? "TEST : " : "") << "MR " << i << " : BAs " << stats.ba
+                << " : handovers " << stats.handovers << " interruption " << stats.interruption.As (Time::US)
+                << " : received " << stats.rx << " last " << stats.lastRx.As (Time::US) << std::endl;
+    }
+
+  Simulator::Destroy ();
+  MpiInterface::Disable ();
+  return 0;
+}
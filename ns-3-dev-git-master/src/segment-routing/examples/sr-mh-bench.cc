@@ -0,0 +1,292 @@
+// Rate of the mobility messages processed by the HA, the MN and the CN
+// agents, from Mipv6L4Protocol::Receive to the end of their handler.
+//
+// Each agent is installed by its helper on a node of its own link:
+// - the HA processes binding refreshes of a registered MN, sends the BA
+//   and sets the tunnel and the routes of the binding up again,
+// - the MN processes the BAs of its HA, as sent by the HA above,
+// - the CN processes authorized binding refreshes, then HoTI and CoTI
+//   answered in batches.
+// The messages are parsed once into a Mipv6MessageView, the handlers read
+// the fields, the options and the home address from it.
+//
+// Sample usage:  ./ns3 run 'sr-mh-bench --n=200000'
+
+#include "ns3/abort.h"
+#include "ns3/command-line.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-option-header.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/blist.h"
+#include "ns3/cn.h"
+#include "ns3/ha.h"
+#include "ns3/sr-header.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-l4-protocol.h"
+#include "ns3/sr-mn.h"
+#include "ns3/sr-option-header.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+/**
+ * \brief Create a node alone on its link, with a default route.
+ * \param base the prefix of the link
+ * \return the node
+ */
+static Ptr<Node>
+CreateLinkNode (Ipv6Address base)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (node);
+
+  SimpleNetDeviceHelper link;
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (base, Ipv6Prefix (64));
+  ipv6helper.Assign (link.Install (node));
+  Ipv6StaticRoutingHelper routingHelper;
+  routingHelper.GetStaticRouting (node->GetObject<Ipv6> ())->SetDefaultRoute (Ipv6Address ("fe80::2"), 1);
+  return node;
+}
+
+/**
+ * \brief Get the global address of a node created by CreateLinkNode.
+ * \param node the node
+ * \return the address
+ */
+static Ipv6Address
+GetGlobalAddress (Ptr<Node> node)
+{
+  return node->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+}
+
+/**
+ * \brief Build a message followed by the Home Address destination option.
+ * \param message the mobility header
+ * \param hoa the home address
+ * \return the packet
+ */
+static Ptr<Packet>
+BuildWithHomeAddress (const Header &message, Ipv6Address hoa)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  Ipv6ExtensionDestinationHeader dest;
+  Ipv6HomeAddressOptionHeader homeopt;
+  homeopt.SetHomeAddress (hoa);
+  dest.AddOption (homeopt);
+  dest.SetNextHeader (59);
+  p->AddHeader (dest);
+  p->AddHeader (message);
+  return p;
+}
+
+/**
+ * \brief Run the events queued at the current time, or up to a delay.
+ * \param delay the delay
+ */
+static void
+RunFor (Time delay)
+{
+  Simulator::Stop (delay);
+  Simulator::Run ();
+}
+
+/**
+ * \brief Count a message.
+ * \param count the counter
+ * \param packet the message
+ */
+static void
+Count (uint32_t *count, Ptr<const Packet> packet)
+{
+  (*count)++;
+}
+
+/**
+ * \brief Keep the last message sent.
+ * \param last the message
+ * \param packet the message sent
+ */
+static void
+Keep (Ptr<Packet> *last, Ptr<const Packet> packet)
+{
+  *last = packet->Copy ();
+}
+
+/**
+ * \brief Print the rate of a run.
+ * \param name the messages processed
+ * \param n the number of messages
+ * \param ms the wall-clock time
+ */
+static void
+Report (std::string name, uint32_t n, int64_t ms)
+{
+  double rate = ms ? 1000.0 * n / ms : 0;
+  std::cout << name << n << " in " << ms << " ms, " << rate << " msg/s" << std::endl;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t n = 100000;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("n", "number of messages processed by each agent", n);
+  cmd.Parse (argc, argv);
+
+  const uint32_t batch = 1000;
+  SystemWallClockMs clock;
+
+  /* the HA, the MN and the CN on their own link */
+  Ptr<Node> haNode = CreateLinkNode (Ipv6Address ("2001:db8::"));
+  Mipv6HaHelper haHelper;
+  haHelper.Install (haNode);
+  Ptr<Mipv6Ha> ha = haNode->GetObject<Mipv6Ha> ();
+  Ipv6Address haAddress = GetGlobalAddress (haNode);
+  Ptr<Ipv6Interface> haInterface = haNode->GetObject<Ipv6L3Protocol> ()->GetInterface (1);
+
+  Ptr<Node> mnNode = CreateLinkNode (Ipv6Address ("2001:db8:1::"));
+  Mipv6MnHelper mnHelper (std::list<Ipv6Address> (1, haAddress), false, std::list<Ipv6Address> ());
+  mnHelper.Install (mnNode);
+  Ptr<Mipv6Mn> mn = mnNode->GetObject<Mipv6Mn> ();
+  Ipv6Address mnAddress = GetGlobalAddress (mnNode);
+  Ptr<Ipv6Interface> mnInterface = mnNode->GetObject<Ipv6L3Protocol> ()->GetInterface (1);
+
+  Ptr<Node> cnNode = CreateLinkNode (Ipv6Address ("2001:db8:2::"));
+  Mipv6CnHelper cnHelper;
+  cnHelper.Install (cnNode);
+  Ptr<Mipv6CN> cn = cnNode->GetObject<Mipv6CN> ();
+  Ipv6Address cnAddress = GetGlobalAddress (cnNode);
+
+  RunFor (Seconds (5));
+  Ipv6Address hoa = mn->GetHomeAddress ();
+  Ipv6Address coa ("2001:db8:a::100");
+
+  /* the BUs of the MN, with the sequence its BAs are checked against */
+  PointerValue blist;
+  mn->GetAttribute ("BList", blist);
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (blist.Get<BList> ()->GetHomeLastBindingUpdateSequence ());
+  bu.SetFlagA (true);
+  bu.SetFlagH (true);
+  bu.SetLifetime (10);
+  Ptr<Packet> buPacket = BuildWithHomeAddress (bu, hoa);
+
+  /* home registration, then refreshes from the same CoA */
+  uint32_t haTx = 0;
+  Ptr<Packet> baPacket;
+  ha->TraceConnectWithoutContext ("AgentTx", MakeBoundCallback (&Count, &haTx));
+  ha->TraceConnectWithoutContext ("AgentTx", MakeBoundCallback (&Keep, &baPacket));
+  haNode->GetObject<Mipv6L4Protocol> ()->Receive (buPacket->Copy (), coa, haAddress, haInterface);
+  RunFor (Seconds (5));
+  NS_ABORT_MSG_UNLESS (haTx == 1 && baPacket, "home registration not acknowledged");
+
+  haTx = 0;
+  clock.Start ();
+  for (uint32_t i = 0; i < n; i += batch)
+    {
+      for (uint32_t j = i; j < n && j < i + batch; j++)
+        {
+          haNode->GetObject<Mipv6L4Protocol> ()->Receive (buPacket->Copy (), coa, haAddress, haInterface);
+        }
+      RunFor (Seconds (0));
+    }
+  int64_t haMs = clock.End ();
+  NS_ABORT_MSG_UNLESS (haTx == n, "HA lost BUs");
+
+  /* the BA of the HA, received by the MN */
+  uint32_t mnRx = 0;
+  mn->TraceConnectWithoutContext ("AgentRx", MakeBoundCallback (&Count, &mnRx));
+  clock.Start ();
+  for (uint32_t i = 0; i < n; i += batch)
+    {
+      for (uint32_t j = i; j < n && j < i + batch; j++)
+        {
+          mnNode->GetObject<Mipv6L4Protocol> ()->Receive (baPacket->Copy (), haAddress, mnAddress, mnInterface);
+        }
+      RunFor (Seconds (0));
+    }
+  int64_t mnMs = clock.End ();
+  NS_ABORT_MSG_UNLESS (mnRx == n, "MN lost BAs");
+
+  /* authorized binding refreshes to the CN */
+  uint16_t index = cn->GetNonceIndex ();
+  Ipv6MobilityBindingUpdateHeader cnBu;
+  cnBu.SetSequence (1);
+  cnBu.SetFlagA (true);
+  cnBu.SetFlagK (true);
+  cnBu.SetLifetime (10);
+  Ipv6MobilityOptionNonceIndicesHeader indices;
+  indices.SetHomeNonceIndex (index);
+  indices.SetCareOfNonceIndex (index);
+  cnBu.AddOption (indices);
+  Ipv6MobilityOptionBindingAuthorizationDataHeader authorization;
+  cnBu.AddOption (authorization);
+  Mipv6MessageTemplate cnBuTemplate;
+  cnBuTemplate.Set (BuildWithHomeAddress (cnBu, hoa));
+  Ptr<Packet> cnBuPacket = cnBuTemplate.Build (1, 10, MakeBoundCallback (&Mipv6CN::ComputeAuthenticator,
+                                                                         cn->GetHomeKeygenToken (hoa, index),
+                                                                         cn->GetCareOfKeygenToken (coa, index),
+                                                                         coa, cnAddress));
+
+  uint32_t cnTx = 0;
+  cn->TraceConnectWithoutContext ("AgentTx", MakeBoundCallback (&Count, &cnTx));
+  clock.Start ();
+  for (uint32_t i = 0; i < n; i += batch)
+    {
+      for (uint32_t j = i; j < n && j < i + batch; j++)
+        {
+          cnNode->GetObject<Mipv6L4Protocol> ()->Receive (cnBuPacket->Copy (), coa, cnAddress, 0);
+        }
+      RunFor (Seconds (0));
+    }
+  int64_t cnMs = clock.End ();
+  NS_ABORT_MSG_UNLESS (cnTx == n, "CN lost BUs");
+
+  /* return routability, the HoT and CoT leave at the end of each batch */
+  Ipv6HoTIHeader hoti;
+  hoti.SetHomeInitCookie (0x0123456789abcdefULL);
+  Ptr<Packet> hotiPacket = BuildWithHomeAddress (hoti, hoa);
+  Ipv6CoTIHeader coti;
+  coti.SetCareOfInitCookie (0xfedcba9876543210ULL);
+  Ptr<Packet> cotiPacket = BuildWithHomeAddress (coti, hoa);
+
+  cnTx = 0;
+  clock.Start ();
+  for (uint32_t i = 0; i < n; i += batch)
+    {
+      for (uint32_t j = i; j < n && j < i + batch; j++)
+        {
+          cnNode->GetObject<Mipv6L4Protocol> ()->Receive (hotiPacket->Copy (), hoa, cnAddress, 0);
+          cnNode->GetObject<Mipv6L4Protocol> ()->Receive (cotiPacket->Copy (), coa, cnAddress, 0);
+        }
+      RunFor (Seconds (1));
+    }
+  int64_t rrMs = clock.End ();
+  NS_ABORT_MSG_UNLESS (cnTx == 2 * n, "CN lost HoTI/CoTI");
+
+  Report ("HA BU:        ", n, haMs);
+  Report ("MN BA:        ", n, mnMs);
+  Report ("CN BU:        ", n, cnMs);
+  Report ("CN HoTI/CoTI: ", 2 * n, rrMs);
+
+  Simulator::Destroy ();
+  return 0;
+}
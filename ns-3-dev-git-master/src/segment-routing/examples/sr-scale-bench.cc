@@ -0,0 +1,594 @@
+// Scalability of the home agent with the number of mobile routers, the
+// handover rate and the number of correspondent nodes.
+//
+// One HA serves the MRs, placed in groups on shared access links on which the
+// HA stands for two ARs (one /64 prefix each). The MRs register from their
+// CoA on the first AR, then hand over between the two ARs at Poisson times.
+// The CNs send UDP packets, round robin, to the home addresses of the MRs:
+// the HA tunnels them to the CoAs.
+//
+// The MNs register either as hosts (mode "host": no MNP, the HA only binds
+// the HoA) or as mobile routers (mode "mr": NEMO, each MR registers a /64
+// MNP, advertised by the HA on the link of the BU and by the MR on a mobile
+// network link of its own). The mode is the first column of the results.
+//
+// Each point of the sweep (modes x MRs x CNs x handover rates) writes one CSV
+// line: wall-clock time and events/s, peak and per-MR resident memory, fixed
+// object size of a binding cache entry and of a binding update list, BUs
+// processed by the HA per wall-clock second and throughput of the tunnelled
+// packets. The object sizes are sizeof only: the members held on the heap
+// (Ptrs, vectors, packet templates) are in the per-MR memory, not in them.
+// The peak RSS is the one of the process: run the largest point last, or one
+// point per process. The per-MR memory is the growth of the RSS during the
+// setup, so a point reusing the memory freed by a larger previous one
+// reports less: one point per process for the memory figures.
+//
+// Sample usage:  ./ns3 run 'sr-scale-bench --mode=host,mr --mrs=1000,10000 --cns=1,10 --handoverRate=0,0.1'
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-generator.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/bcache.h"
+#include "ns3/blist.h"
+#include "ns3/ha.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-mn.h"
+#include "ns3/sr-tun-l4-protocol.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \brief Read a memory counter of this process.
+ * \param key the field of /proc/self/status, e.g. "VmRSS"
+ * \return the value in bytes, 0 if not available
+ */
+static uint64_t
+ReadMemory (const std::string &key)
+{
+  std::ifstream status ("/proc/self/status");
+  std::string line;
+  while (std::getline (status, line))
+    {
+      if (line.compare (0, key.size () + 1, key + ":") == 0)
+        {
+          std::istringstream value (line.substr (key.size () + 1));
+          uint64_t kb = 0;
+          value >> kb;
+          return kb * 1024;
+        }
+    }
+  return 0;
+}
+
+/**
+ * \brief Parse a comma separated list.
+ * \param list the list
+ * \return the values
+ */
+template <typename T>
+static std::vector<T>
+ParseList (const std::string &list)
+{
+  std::vector<T> values;
+  std::istringstream is (list);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      std::istringstream iv (item);
+      T value;
+      iv >> value;
+      NS_ABORT_MSG_UNLESS (!iv.fail (), "bad list item: " << item);
+      values.push_back (value);
+    }
+  return values;
+}
+
+/**
+ * \ingroup segment-routing
+ *
+ * \brief One point of the sweep: a topology, its traffic and its counters.
+ */
+class ScaleBench
+{
+public:
+  /**
+   * \brief constructor.
+   * \param mr whether the MNs register as mobile routers rather than hosts
+   * \param mrs number of MRs
+   * \param cns number of CNs
+   * \param handoverRate handovers per MR per second
+   * \param group MRs per access link
+   * \param pps packets per second sent by each CN
+   * \param packetSize size of the CN packets
+   */
+  ScaleBench (bool mr, uint32_t mrs, uint32_t cns, double handoverRate, uint32_t group, double pps, uint32_t packetSize);
+
+  /**
+   * \brief Build the topology and schedule the attachments and the traffic.
+   * \param stop end of the simulation
+   */
+  void Build (Time stop);
+
+  /**
+   * \brief Run the simulation, then write the results.
+   * \param stop end of the simulation
+   * \param os the CSV output
+   */
+  void Run (Time stop, std::ostream &os);
+
+  /**
+   * \brief Write the CSV header.
+   * \param os the CSV output
+   */
+  static void WriteHeader (std::ostream &os);
+
+private:
+  /**
+   * \brief Configure the CoA of an MR on one of the ARs of its link and attach.
+   * \param mr index of the MR
+   * \param second whether the CoA is on the second AR
+   */
+  void Attach (uint32_t mr, bool second);
+
+  /**
+   * \brief Move an MR to the other AR of its link, then schedule its next handover.
+   * \param mr index of the MR
+   */
+  void Handover (uint32_t mr);
+
+  /**
+   * \brief Send a packet from a CN to the next MR.
+   * \param cn index of the CN
+   */
+  void Send (uint32_t cn);
+
+  /**
+   * \brief Count a BU received by the HA.
+   * \param packet the BU
+   * \param src source address
+   * \param dst destination address
+   * \param interface the receiving interface
+   */
+  void RxBu (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
+
+  /**
+   * \brief Count a packet received through the tunnel by an MR.
+   * \param packet the inner packet
+   * \param innerHeader the inner IPv6 header
+   * \param header the outer IPv6 header
+   * \param interface the receiving interface
+   */
+  void RxMn (Ptr<Packet> packet, Ipv6Header innerHeader, Ipv6Header header, Ptr<Ipv6Interface> interface);
+
+  /**
+   * \brief Drain the socket of an MR.
+   * \param socket the socket
+   */
+  static void Drain (Ptr<Socket> socket);
+
+  /**
+   * \brief Get the address of an MR on a prefix.
+   * \param prefix the /64 prefix
+   * \param mr index of the MR
+   * \return the address
+   */
+  Ipv6Address MakeAddress (Ipv6Address prefix, uint32_t mr) const;
+
+  /**
+   * \brief Get the mobile network prefix of an MR.
+   * \param mr index of the MR
+   * \return the /64 prefix
+   */
+  static Ipv6Address MakeMnp (uint32_t mr);
+
+  bool m_mr;                              //!< whether the MNs are mobile routers
+  uint32_t m_nMrs;                        //!< number of MRs
+  uint32_t m_nCns;                        //!< number of CNs
+  double m_handoverRate;                  //!< handovers per MR per second
+  uint32_t m_group;                       //!< MRs per access link
+  double m_pps;                           //!< packets per second sent by each CN
+  uint32_t m_packetSize;                  //!< size of the CN packets
+  Time m_trafficStart;                    //!< start of the handovers and of the traffic
+  Time m_stop;                            //!< end of the simulation
+
+  Ptr<Node> m_ha;                         //!< the HA
+  NodeContainer m_mrs;                    //!< the MRs
+  NodeContainer m_cns;                    //!< the CNs
+  std::vector<Ptr<Mipv6Mn> > m_mn;        //!< the MN of each MR
+  std::vector<Ipv6Address> m_hoa;         //!< home address of each MR
+  std::vector<bool> m_second;             //!< whether each MR is on its second AR
+  std::vector<Ipv6Address> m_arPrefix;    //!< prefixes of the two ARs of each access link
+  std::vector<Ipv6Address> m_linkLocalHa; //!< link-local address of the HA on each access link
+  std::vector<Ptr<Socket> > m_sockets;    //!< socket of each CN
+  Ptr<ExponentialRandomVariable> m_dwell; //!< time between the handovers of an MR
+  uint32_t m_next;                        //!< next MR to send a packet to
+
+  double m_setupSeconds;                  //!< wall-clock time of Build
+  uint64_t m_rssPerMr;                    //!< resident memory per MR after Build
+  uint64_t m_buRx;                        //!< BUs received by the HA
+  uint64_t m_handovers;                   //!< handovers made
+  uint64_t m_tunnelRxPackets;             //!< packets received through the tunnels
+  uint64_t m_tunnelRxBytes;               //!< bytes received through the tunnels
+};
+
+ScaleBench::ScaleBench (bool mr, uint32_t mrs, uint32_t cns, double handoverRate, uint32_t group, double pps, uint32_t packetSize)
+  : m_mr (mr),
+    m_nMrs (mrs),
+    m_nCns (cns),
+    m_handoverRate (handoverRate),
+    m_group (group),
+    m_pps (pps),
+    m_packetSize (packetSize),
+    m_trafficStart (Seconds (4)),
+    m_next (0),
+    m_setupSeconds (0),
+    m_rssPerMr (0),
+    m_buRx (0),
+    m_handovers (0),
+    m_tunnelRxPackets (0),
+    m_tunnelRxBytes (0)
+{
+}
+
+void
+ScaleBench::WriteHeader (std::ostream &os)
+{
+  os << "mode,mrs,cns,handover_rate,sim_time_s,setup_s,wall_s,events,events_per_s,"
+     << "peak_rss_bytes,rss_per_mr_bytes,bce_object_bytes,blist_object_bytes,"
+     << "bu_rx,bu_per_s,bindings,handovers,"
+     << "tun_rx_packets,tun_rx_bytes,tun_packets_per_s,tun_sim_mbps" << std::endl;
+}
+
+Ipv6Address
+ScaleBench::MakeAddress (Ipv6Address prefix, uint32_t mr) const
+{
+  uint8_t iid[16], buf[16];
+  m_hoa[mr].GetBytes (iid);
+  prefix.GetBytes (buf);
+  std::copy (iid + 8, iid + 16, buf + 8);
+  return Ipv6Address (buf);
+}
+
+Ipv6Address
+ScaleBench::MakeMnp (uint32_t mr)
+{
+  uint8_t buf[16] = { 0x20, 0x01, 0x0d, 0xb8, uint8_t (mr >> 24), uint8_t (mr >> 16), uint8_t (mr >> 8), uint8_t (mr) };
+  return Ipv6Address (buf);
+}
+
+void
+ScaleBench::Build (Time stop)
+{
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint64_t rss = ReadMemory ("VmRSS");
+
+  m_stop = stop;
+  uint32_t nLinks = (m_nMrs + m_group - 1) / m_group;
+  NS_ABORT_MSG_UNLESS (nLinks <= 0xffff, "too many access links, raise --group");
+
+  m_ha = CreateObject<Node> ();
+  m_mrs.Create (m_nMrs);
+  m_cns.Create (m_nCns);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (m_ha);
+  internetv6.Install (m_mrs);
+  internetv6.Install (m_cns);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (1)));
+  Ipv6AddressHelper ipv6helper;
+  Ptr<Ipv6> haIpv6 = m_ha->GetObject<Ipv6> ();
+
+  //home link, the HA alone
+  NetDeviceContainer home = helperChannel.Install (m_ha);
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6helper.Assign (home);
+  Ipv6Address haAddress = haIpv6->GetAddress (1, 1).GetAddress ();
+
+  //CN link, the CNs reach the HoAs through the HA
+  NetDeviceContainer cnLink = helperChannel.Install (NodeContainer (NodeContainer (m_ha), m_cns));
+  ipv6helper.SetBase (Ipv6Address ("2001:cafe::"), Ipv6Prefix (64));
+  ipv6helper.Assign (cnLink);
+  Ipv6Address linkLocalHaCn = haIpv6->GetAddress (2, 0).GetAddress ();
+  Ipv6StaticRoutingHelper routingHelper;
+  for (uint32_t i = 0; i < m_nCns; i++)
+    {
+      routingHelper.GetStaticRouting (m_cns.Get (i)->GetObject<Ipv6> ())->SetDefaultRoute (linkLocalHaCn, 1);
+    }
+
+  //access links, the HA stands for the two ARs of each link
+  for (uint32_t l = 0; l < nLinks; l++)
+    {
+      NodeContainer link (m_ha);
+      for (uint32_t i = l * m_group; i < std::min (m_nMrs, (l + 1) * m_group); i++)
+        {
+          link.Add (m_mrs.Get (i));
+        }
+      NetDeviceContainer devices = helperChannel.Install (link);
+      NetDeviceContainer mrDevices;
+      for (uint32_t i = 1; i < devices.GetN (); i++)
+        {
+          mrDevices.Add (devices.Get (i));
+        }
+
+      for (uint8_t ar = 0; ar < 2; ar++)
+        {
+          uint8_t buf[16] = { 0x20, 0x01, 0x00, uint8_t (0x0a + ar), 0x00, 0x00, uint8_t (l >> 8), uint8_t (l) };
+          Ipv6Address prefix (buf);
+          m_arPrefix.push_back (prefix);
+          ipv6helper.SetBase (prefix, Ipv6Prefix (64));
+          ipv6helper.Assign (NetDeviceContainer (devices.Get (0)));
+        }
+      ipv6helper.AssignWithoutAddress (mrDevices);
+      m_linkLocalHa.push_back (haIpv6->GetAddress (haIpv6->GetInterfaceForDevice (devices.Get (0)), 0).GetAddress ());
+    }
+  haIpv6->SetAttribute ("IpForward", BooleanValue (true));
+  //the HA address is on the home link, the BUs arrive on the access links
+  haIpv6->SetAttribute ("StrongEndSystemModel", BooleanValue (false));
+
+  Mipv6HaHelper haHelper;
+  haHelper.SetHAAs (m_mr);
+  haHelper.Install (m_ha);
+  Ptr<Mipv6Ha> ha = m_ha->GetObject<Mipv6Ha> ();
+  ha->TraceConnectWithoutContext ("RxBU", MakeCallback (&ScaleBench::RxBu, this));
+  //the HoA routes of the HA go through its tunnel interface, which needs a global address
+  uint32_t tunnelIf = m_ha->GetObject<Ipv6TunnelL4Protocol> ()->CreateTunnelDevice ();
+  haIpv6->AddAddress (tunnelIf, Ipv6InterfaceAddress (Ipv6Address ("2001:1:0:1::1"), Ipv6Prefix (64)));
+
+  Mipv6MnHelper mnHelper (std::list<Ipv6Address> (1, haAddress), false, std::list<Ipv6Address> ());
+  if (m_mr)
+    {
+      //the MNP of each MR is advertised on its mobile network link, the interface 2
+      mnHelper.SetMNAs (true);
+      for (uint32_t i = 0; i < m_nMrs; i++)
+        {
+          ipv6helper.AssignWithoutAddress (helperChannel.Install (m_mrs.Get (i)));
+          mnHelper.SetMobileNetPref (MakeMnp (i));
+          mnHelper.Install (m_mrs.Get (i));
+        }
+    }
+  else
+    {
+      mnHelper.Install (m_mrs);
+    }
+
+  TypeId udp = UdpSocketFactory::GetTypeId ();
+  m_dwell = CreateObject<ExponentialRandomVariable> ();
+  if (m_handoverRate > 0)
+    {
+      m_dwell->SetAttribute ("Mean", DoubleValue (1 / m_handoverRate));
+    }
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < m_nMrs; i++)
+    {
+      Ptr<Node> mr = m_mrs.Get (i);
+      m_mn.push_back (mr->GetObject<Mipv6Mn> ());
+      m_hoa.push_back (m_mn.back ()->GetHomeAddress ());
+      m_second.push_back (false);
+      mr->GetObject<Ipv6TunnelL4Protocol> ()->TraceConnectWithoutContext ("RxMn", MakeCallback (&ScaleBench::RxMn, this));
+
+      Ptr<Socket> sink = Socket::CreateSocket (mr, udp);
+      sink->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), 9));
+      sink->SetRecvCallback (MakeCallback (&ScaleBench::Drain));
+
+      //registration on the first AR
+      Simulator::Schedule (Seconds (1 + jitter->GetValue ()), &ScaleBench::Attach, this, i, false);
+      if (m_handoverRate > 0)
+        {
+          Simulator::Schedule (m_trafficStart + Seconds (m_dwell->GetValue ()), &ScaleBench::Handover, this, i);
+        }
+    }
+
+  for (uint32_t i = 0; i < m_nCns; i++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (m_cns.Get (i), udp);
+      socket->Bind6 ();
+      m_sockets.push_back (socket);
+      if (m_pps > 0 && m_nMrs > 0)
+        {
+          Simulator::Schedule (m_trafficStart + Seconds (jitter->GetValue () / m_pps), &ScaleBench::Send, this, i);
+        }
+    }
+
+  m_setupSeconds = clock.End () / 1000.0;
+  uint64_t now = ReadMemory ("VmRSS");
+  uint64_t grown = now > rss ? now - rss : 0;
+  m_rssPerMr = m_nMrs ? grown / m_nMrs : 0;
+}
+
+void
+ScaleBench::Attach (uint32_t mr, bool second)
+{
+  uint32_t link = mr / m_group;
+  Ipv6Address prefix = m_arPrefix[2 * link + second];
+  Ipv6Address coa = MakeAddress (prefix, mr);
+  Ptr<Ipv6> ipv6 = m_mrs.Get (mr)->GetObject<Ipv6> ();
+  Ipv6StaticRoutingHelper routingHelper;
+  Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
+
+  if (m_second[mr] != second)
+    {
+      Ipv6Address oldPrefix = m_arPrefix[2 * link + m_second[mr]];
+      ipv6->RemoveAddress (1, MakeAddress (oldPrefix, mr));
+      routing->RemoveRoute (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), 1, oldPrefix);
+      m_second[mr] = second;
+    }
+  ipv6->AddAddress (1, Ipv6InterfaceAddress (coa, Ipv6Prefix (64)));
+
+  //default route learnt from the AR, the HA stands for it
+  routing->AddNetworkRouteTo (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), m_linkLocalHa[link], 1, prefix, 0);
+  m_mn[mr]->SetDefaultRouterAddress (m_linkLocalHa[link], 1);
+  m_mn[mr]->NotifyAttachment (coa);
+}
+
+void
+ScaleBench::Handover (uint32_t mr)
+{
+  m_handovers++;
+  Attach (mr, !m_second[mr]);
+
+  Time next = Seconds (m_dwell->GetValue ());
+  if (Simulator::Now () + next < m_stop)
+    {
+      Simulator::Schedule (next, &ScaleBench::Handover, this, mr);
+    }
+}
+
+void
+ScaleBench::Send (uint32_t cn)
+{
+  m_sockets[cn]->SendTo (Create<Packet> (m_packetSize), 0, Inet6SocketAddress (m_hoa[m_next], 9));
+  m_next = (m_next + 1) % m_nMrs;
+
+  Time next = Seconds (1 / m_pps);
+  if (Simulator::Now () + next < m_stop)
+    {
+      Simulator::Schedule (next, &ScaleBench::Send, this, cn);
+    }
+}
+
+void
+ScaleBench::RxBu (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
+{
+  m_buRx++;
+}
+
+void
+ScaleBench::RxMn (Ptr<Packet> packet, Ipv6Header innerHeader, Ipv6Header header, Ptr<Ipv6Interface> interface)
+{
+  m_tunnelRxPackets++;
+  m_tunnelRxBytes += packet->GetSize ();
+}
+
+void
+ScaleBench::Drain (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+    }
+}
+
+void
+ScaleBench::Run (Time stop, std::ostream &os)
+{
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Stop (stop);
+  Simulator::Run ();
+  double wall = clock.End () / 1000.0;
+  uint64_t events = Simulator::GetEventCount ();
+
+  PointerValue bcache;
+  m_ha->GetObject<Mipv6Ha> ()->GetAttribute ("BCache", bcache);
+  uint32_t bindings = bcache.Get<BCache> ()->GetSize ();
+
+  double traffic = (stop - m_trafficStart).GetSeconds ();
+  os << (m_mr ? "mr" : "host") << "," << m_nMrs << "," << m_nCns << "," << m_handoverRate << "," << stop.GetSeconds () << ","
+     << m_setupSeconds << "," << wall << "," << events << "," << (wall > 0 ? events / wall : 0) << ","
+     << ReadMemory ("VmHWM") << "," << m_rssPerMr << "," << sizeof (BCache::Entry) << "," << sizeof (BList) << ","
+     << m_buRx << "," << (wall > 0 ? m_buRx / wall : 0) << "," << bindings << "," << m_handovers << ","
+     << m_tunnelRxPackets << "," << m_tunnelRxBytes << "," << (wall > 0 ? m_tunnelRxPackets / wall : 0) << ","
+     << (traffic > 0 ? m_tunnelRxBytes * 8 / traffic / 1e6 : 0) << std::endl;
+
+  m_mn.clear ();
+  m_sockets.clear ();
+  m_ha = 0;
+  m_mrs = NodeContainer ();
+  m_cns = NodeContainer ();
+  Simulator::Destroy ();
+  Ipv6AddressGenerator::Reset ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string modes = "host,mr";
+  std::string mrs = "1000,10000,100000";
+  std::string cns = "1,10";
+  std::string handoverRates = "0,0.1";
+  uint32_t group = 100;
+  double pps = 1000;
+  uint32_t packetSize = 512;
+  double simTime = 10;
+  std::string output = "sr-scale-bench.csv";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("mode", "comma separated registrations of the MNs: host, mr (NEMO)", modes);
+  cmd.AddValue ("mrs", "comma separated numbers of MRs", mrs);
+  cmd.AddValue ("cns", "comma separated numbers of CNs", cns);
+  cmd.AddValue ("handoverRate", "comma separated handovers per MR per second", handoverRates);
+  cmd.AddValue ("group", "MRs per access link", group);
+  cmd.AddValue ("pps", "packets per second sent by each CN", pps);
+  cmd.AddValue ("packetSize", "size of the CN packets", packetSize);
+  cmd.AddValue ("time", "simulated seconds of each run", simTime);
+  cmd.AddValue ("output", "CSV output file, - for the standard output", output);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_UNLESS (group > 0, "--group must be positive");
+  NS_ABORT_MSG_UNLESS (simTime > 4, "--time must leave time for the traffic after the registrations");
+
+  Config::SetDefault ("ns3::Icmpv6L4Protocol::DAD", BooleanValue (false));
+
+  std::ofstream file;
+  if (output != "-")
+    {
+      file.open (output.c_str ());
+      NS_ABORT_MSG_UNLESS (file.is_open (), "cannot open " << output);
+    }
+  std::ostream &os = output != "-" ? file : std::cout;
+
+  ScaleBench::WriteHeader (os);
+  std::vector<std::string> modeList = ParseList<std::string> (modes);
+  for (std::vector<std::string>::const_iterator m = modeList.begin (); m != modeList.end (); m++)
+    {
+      NS_ABORT_MSG_UNLESS (*m == "host" || *m == "mr", "bad mode: " << *m);
+    }
+  std::vector<uint32_t> mrList = ParseList<uint32_t> (mrs);
+  std::vector<uint32_t> cnList = ParseList<uint32_t> (cns);
+  std::vector<double> rateList = ParseList<double> (handoverRates);
+  for (std::vector<std::string>::const_iterator mode = modeList.begin (); mode != modeList.end (); mode++)
+    {
+      for (std::vector<uint32_t>::const_iterator m = mrList.begin (); m != mrList.end (); m++)
+        {
+          for (std::vector<uint32_t>::const_iterator c = cnList.begin (); c != cnList.end (); c++)
+            {
+              for (std::vector<double>::const_iterator r = rateList.begin (); r != rateList.end (); r++)
+                {
+                  std::cerr << "mode=" << *mode << " mrs=" << *m << " cns=" << *c << " handoverRate=" << *r << std::endl;
+                  ScaleBench bench (*mode == "mr", *m, *c, *r, group, pps, packetSize);
+                  bench.Build (Seconds (simTime));
+                  bench.Run (Seconds (simTime), os);
+                }
+            }
+        }
+    }
+
+  return 0;
+}
@@ -2,6 +2,8 @@
 #include "ns3/log.h"
 #include "ns3/object.h"
 #include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/sr-l4-protocol.h"
 #include "ns3/sr-header.h"
 #include "ns3/sr-mobility.h"
@@ -16,11 +18,39 @@ NS_LOG_COMPONENT_DEFINE ("MIPv6Helper");
 
 namespace ns3 {
 
+/**
+ * \brief check that a node runs on this rank.
+ *
+ * In a distributed simulation, every rank builds the whole topology but the
+ * events of a node only run on the rank owning it. The multithreaded
+ * simulator runs the nodes of all the system ids in one process, whose
+ * system id is 0: every node is local.
+ * \param node the node
+ * \return true if the stack of the node has to be installed here
+ */
+static bool
+IsLocalNode (Ptr<Node> node)
+{
+#ifdef NS3_MTP
+  if (Simulator::GetImplementation ()->GetInstanceTypeId ().GetName () == "ns3::MultithreadedSimulatorImpl")
+    {
+      return true;
+    }
+#endif
+  if (node->GetSystemId () != Simulator::GetSystemId ())
+    {
+      NS_LOG_LOGIC ("Node " << node->GetId () << " runs on rank " << node->GetSystemId ());
+      return false;
+    }
+  return true;
+}
+
 //HA Helper
 
 Mipv6HaHelper::Mipv6HaHelper ()
 {
 m_haflag=false;
+m_bindings=0;
 }
 
 Mipv6HaHelper::~Mipv6HaHelper ()
@@ -37,9 +67,19 @@ bool Mipv6HaHelper::GetHAAs( ) const   //  NEMO
 return m_haflag;
 }
 
+void Mipv6HaHelper::SetBindingCacheSize (uint32_t n)
+{
+  m_bindings = n;
+}
+
 void
 Mipv6HaHelper::Install (Ptr<Node> node)
 {
+  if (!IsLocalNode (node))
+    {
+      return;
+    }
+
   m_node = node;
   Ptr<Mipv6L4Protocol> mipv6 = node->GetObject<Mipv6L4Protocol> ();
 
@@ -76,6 +116,20 @@ Mipv6HaHelper::Install (Ptr<Node> node)
   Ptr<Mipv6Ha> ha = CreateObject<Mipv6Ha> (m_haflag);  // adding the argument in constructor for NEMO
  	
   node->AggregateObject (ha);
+
+  if (m_bindings)
+    {
+      ha->ReserveBindings (m_bindings);
+    }
+}
+
+void
+Mipv6HaHelper::Install (NodeContainer c)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Install (*i);
+    }
 }
 
 std::list<Ipv6Address> Mipv6HaHelper::GetHomeAgentAddressList ()
@@ -121,9 +175,47 @@ Ipv6Address Mipv6MnHelper::GetMobileNetPref() const   //NEMO
 return m_mnp;
 }
 
+void Mipv6MnHelper::AddMobileNetPref (Ipv6Address mnp)   //NEMO
+{
+  m_moreMnps.push_back (mnp);
+}
+
+Ptr<const Mipv6MnConfig>
+Mipv6MnHelper::GetConfig () const
+{
+  if (m_mnflag && !m_moreMnps.empty ())
+    {
+      std::list<Ipv6Address> mnps (1, m_mnp);
+      mnps.insert (mnps.end (), m_moreMnps.begin (), m_moreMnps.end ());
+      return Create<Mipv6MnConfig> (m_Haalist, m_Aralist, mnps);
+    }
+  return Create<Mipv6MnConfig> (m_Haalist, m_Aralist, m_mnflag, m_mnp);
+}
+
 void
 Mipv6MnHelper::Install (Ptr<Node> node) const
 {
+  Install (node, GetConfig ());
+}
+
+void
+Mipv6MnHelper::Install (NodeContainer c) const
+{
+  Ptr<const Mipv6MnConfig> config = GetConfig ();
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Install (*i, config);
+    }
+}
+
+void
+Mipv6MnHelper::Install (Ptr<Node> node, Ptr<const Mipv6MnConfig> config) const
+{
+  if (!IsLocalNode (node))
+    {
+      return;
+    }
+
   Ptr<Mipv6L4Protocol> mipv6 = node->GetObject<Mipv6L4Protocol> ();
 
   if (!mipv6)
@@ -155,8 +247,7 @@ Mipv6MnHelper::Install (Ptr<Node> node) const
       NS_ASSERT_MSG ( !ha, "HA stack is installed on MN, not allowed");
 
     }
-  //(adding last2 argument in constructor for NEMO)
-  Ptr<Mipv6Mn> mn = CreateObject<Mipv6Mn> (m_Haalist,m_mnflag,m_mnp,m_Aralist);  // Pass Home Agent Address List as argument (adding last 2 arguments for NEMO in constructor)
+  Ptr<Mipv6Mn> mn = CreateObject<Mipv6Mn> (config);  // Home agent and AR lists, NEMO flag and prefix, shared by the MNs of the helper
 
   mn->SetRouteOptimizationReuiredField (m_rotopt);  //Set by default false as the current implementation does
                                                 //not support route optimization, otherwise set to m_rotopt
@@ -179,6 +270,11 @@ Mipv6CnHelper::~Mipv6CnHelper ()
 void
 Mipv6CnHelper::Install (Ptr<Node> node) const
 {
+  if (!IsLocalNode (node))
+    {
+      return;
+    }
+
   Ptr<Mipv6L4Protocol> mipv6 = node->GetObject<Mipv6L4Protocol> ();
 
   if (!mipv6)
@@ -201,5 +297,14 @@ Mipv6CnHelper::Install (Ptr<Node> node) const
   node->AggregateObject (cn);
 }
 
+void
+Mipv6CnHelper::Install (NodeContainer c) const
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Install (*i);
+    }
+}
+
 
 } // namespace ns3
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include "ns3/ptr.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/node-container.h"
+#include "ns3/sr-mn-config.h"
 
 
 namespace ns3 {
@@ -20,6 +22,11 @@ class Node;
  * over a node. It installs the MIPv6MobL4Protocol and MIPv6TunL4Protocol following the CreateObject() and
  * AggregateObject() functions, defined in the core part of ns-3. After that it registers the corresponding
  * mobility messages using MIPv6MobL4Protocol class
+ *
+ * In a distributed simulation, Install() skips the nodes of the other ranks:
+ * every rank builds the whole topology, the stack of a node only exists on the
+ * rank running it and the signalling between ranks goes through the remote
+ * point-to-point channels.
  */
 
 /**
@@ -35,6 +42,18 @@ public:
    * \param node The node on which to install the stack.
    */
   void Install (Ptr<Node> node);
+
+  /**
+   * \brief install the stack on each node of a container.
+   * \param c the nodes
+   */
+  void Install (NodeContainer c);
+
+  /**
+   * \brief set the number of MNs expected per HA, to pre-size the binding caches.
+   * \param n expected number of MNs, 0 to leave the caches unsized
+   */
+  void SetBindingCacheSize (uint32_t n);
 /**
    *
 
@@ -54,6 +73,11 @@ private:
   Ptr<Node> m_node;
 
   bool m_haflag;              //NEMO  
+
+  /**
+   * \brief expected number of MNs per HA.
+   */
+  uint32_t m_bindings;
 };
 
 /**
@@ -71,6 +95,12 @@ public:
    */
   void Install (Ptr<Node> node) const;
 
+  /**
+   * \brief install the stack on each node of a container.
+   * \param c the nodes
+   */
+  void Install (NodeContainer c) const;
+
 protected:
 private:
 };
@@ -94,6 +124,20 @@ public:
    */
   void Install (Ptr<Node> node) const;
 
+  /**
+   * \brief install the stack on each node of a container.
+   *
+   * All the MNs share one configuration, the lists are not copied per node.
+   * \param c the nodes
+   */
+  void Install (NodeContainer c) const;
+
+  /**
+   * \brief build the configuration given to the MNs.
+   * \returns a new configuration from the current settings
+   */
+  Ptr<const Mipv6MnConfig> GetConfig () const;
+
   void SetMNAs(bool RorH);                    // NEMO
   
   bool GetMNAs() const;                           // NEMO
@@ -102,9 +146,23 @@ public:
 
   Ipv6Address GetMobileNetPref() const;         //  NEMO
 
+  /**
+   * \brief add a mobile network prefix registered after the one of
+   * SetMobileNetPref, all of them are carried by the same BU.
+   * \param mnp the /64 mobile network prefix (NEMO)
+   */
+  void AddMobileNetPref (Ipv6Address mnp);
+
 
 protected:
 private:
+  /**
+   * \brief install the stack on a node.
+   * \param node The node on which to install the stack.
+   * \param config the configuration of the MN
+   */
+  void Install (Ptr<Node> node, Ptr<const Mipv6MnConfig> config) const;
+
 /**
  * \brief home agent address list
  */
@@ -124,6 +182,8 @@ private:
  
   Ipv6Address m_mnp; // mobile network prefix -  NEMO
 
+  std::list<Ipv6Address> m_moreMnps; // further mobile network prefixes - NEMO
+
 };
 
 } // namespace ns3
@@ -33,6 +33,8 @@ void BCache::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
   Flush ();
+  m_timingWheel = 0;
+  m_lifetimeExpiredCallback.Nullify ();
   Object::DoDispose ();
 }
 
@@ -51,30 +53,59 @@ BCache::Entry *BCache::Lookup (Ipv6Address mnhoa)
 
 bool BCache::LookupSHoa (Ipv6Address shoa)
 {
-  for (BCacheI i = m_bCache.begin (); i != m_bCache.end (); i++)
+  NS_LOG_FUNCTION (this << shoa);
+
+  return m_sHoaIndex.find (shoa) != m_sHoaIndex.end ();
+}
+
+BCache::Entry *BCache::LookupMobileNetworkPrefix (Ipv6Address addr)   //NEMO
+{
+  NS_LOG_FUNCTION (this << addr);
+
+  for (MnpIndex::iterator it = m_mnpIndex.begin (); it != m_mnpIndex.end (); it++)
     {
-      if (((*i).second->GetSolicitedHoA ()).IsMatchingType (shoa))
+      BCacheI entry = it->second.find (addr.CombinePrefix (Ipv6Prefix (it->first)));
+      if (entry != it->second.end ())
         {
-          return true;
+          return entry->second;
         }
     }
-  return false;
+  return 0;
+}
+
+bool BCache::IsHomePrefix (Ipv6Address prefix) const   //NEMO
+{
+  return m_homePrefixIndex.find (prefix) != m_homePrefixIndex.end ();
+}
+
+uint32_t BCache::GetSize () const
+{
+  return m_bCache.size ();
+}
+
+void BCache::Reserve (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+
+  m_bCache.resize (n);
+  m_sHoaIndex.resize (n);
 }
 
 void BCache::Add (BCache::Entry *bce)
 {
   NS_LOG_FUNCTION (this << bce );
 
-
-  if ( m_bCache.find (bce->GetHoa ()) != m_bCache.end ())
+  BCacheI it = m_bCache.find (bce->GetHoa ());
+  if (it != m_bCache.end ())
     {
-      BCache::Entry* entry2 = m_bCache[bce->GetHoa ()];
+      BCache::Entry* entry2 = it->second;
 
       bce->SetNext (entry2);
+      UnindexEntry (entry2);
     }
 
   m_bCache[bce->GetHoa ()] = bce;
-
+  IndexEntry (bce);
 }
 
 
@@ -83,13 +114,58 @@ void BCache::Remove (BCache::Entry* entry)
 {
   NS_LOG_FUNCTION (this << entry);
 
-  for (BCacheI i = m_bCache.begin (); i != m_bCache.end (); i++)
+  BCacheI i = m_bCache.find (entry->GetHoa ());
+  if (i != m_bCache.end () && (*i).second == entry)
     {
-      if ((*i).second == entry)
+      UnindexEntry (entry);
+      m_bCache.erase (i);
+      delete entry;
+    }
+}
+
+void BCache::IndexEntry (BCache::Entry *entry)
+{
+  m_sHoaIndex[entry->GetSolicitedHoA ()]++;
+
+  const Entry::PrefixList &mnps = entry->GetMobileNetworkPrefixes ();
+  for (Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+    {
+      if (!it->first.IsAny ())
         {
-          m_bCache.erase (i);
-          delete entry;
-          return;
+          m_mnpIndex[it->second][it->first.CombinePrefix (Ipv6Prefix (it->second))] = entry;
+        }
+    }
+}
+
+void BCache::UnindexEntry (BCache::Entry *entry)
+{
+  AddressCount::iterator shoa = m_sHoaIndex.find (entry->GetSolicitedHoA ());
+  if (shoa != m_sHoaIndex.end () && --shoa->second == 0)
+    {
+      m_sHoaIndex.erase (shoa);
+    }
+
+  /* an MNP registered again by another MR belongs to the latest one */
+  const Entry::PrefixList &mnps = entry->GetMobileNetworkPrefixes ();
+  for (Entry::PrefixList::const_iterator mnp = mnps.begin (); mnp != mnps.end (); mnp++)
+    {
+      if (mnp->first.IsAny ())
+        {
+          continue;
+        }
+      MnpIndex::iterator table = m_mnpIndex.find (mnp->second);
+      if (table == m_mnpIndex.end ())
+        {
+          continue;
+        }
+      BCacheI it = table->second.find (mnp->first.CombinePrefix (Ipv6Prefix (mnp->second)));
+      if (it != table->second.end () && it->second == entry)
+        {
+          table->second.erase (it);
+          if (table->second.empty ())
+            {
+              m_mnpIndex.erase (table);
+            }
         }
     }
 }
@@ -119,6 +195,7 @@ void BCache::SetHomePrefixes (std::list<Ipv6Address> halist)
         }
       Ipv6Address addr (buf2);
       m_HomePrefixList.push_back (addr);
+      m_homePrefixIndex[addr]++;
       hlist.pop_front ();
     }
 }
@@ -131,6 +208,23 @@ std::list<Ipv6Address> BCache::GetHomePrefixes ()   // NEMO
 
 
 
+void BCache::SetTimingWheel (Ptr<TimingWheel> wheel)
+{
+  NS_LOG_FUNCTION (this << wheel);
+
+  m_timingWheel = wheel;
+}
+
+Ptr<TimingWheel> BCache::GetTimingWheel () const
+{
+  return m_timingWheel;
+}
+
+void BCache::SetLifetimeExpiredCallback (Callback<void, BCache::Entry *> callback)
+{
+  m_lifetimeExpiredCallback = callback;
+}
+
 void BCache::Flush ()
 {
   NS_LOG_FUNCTION (this);
@@ -141,6 +235,8 @@ void BCache::Flush ()
     }
 
   m_bCache.erase (m_bCache.begin (), m_bCache.end ());
+  m_sHoaIndex.clear ();
+  m_mnpIndex.clear ();
 }
 
 
@@ -337,6 +433,18 @@ Ipv6Address BCache::Entry::GetOldCoa () const
   return m_oldCoa;
 }
 
+Ipv6Address BCache::Entry::GetAlternateCoa () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_alternateCoa;
+}
+
+void BCache::Entry::SetAlternateCoa (Ipv6Address coa)
+{
+  NS_LOG_FUNCTION (this << coa);
+  m_alternateCoa = coa;
+}
+
 uint64_t BCache::Entry::GetHomeInitCookie () const
 {
   NS_LOG_FUNCTION (this);
@@ -434,12 +542,95 @@ void BCache::Entry::SetFlagR (bool r)    // NEMO
 
 Ipv6Address BCache::Entry::GetMobileNetworkPrefix () const      //NEMO
 {
-   return m_mobilenetworkprefix;
+  if (m_mobilenetworkprefixes.empty ())
+    {
+      return Ipv6Address::GetAny ();
+    }
+  return m_mobilenetworkprefixes.front ().first;
 }
  
 void BCache::Entry::SetMobileNetworkPrefix (Ipv6Address prefix)   //NEMO
 { 
-   m_mobilenetworkprefix=prefix;
+  if (m_mobilenetworkprefixes.empty ())
+    {
+      m_mobilenetworkprefixes.push_back (Prefix (prefix, 64));
+      return;
+    }
+  m_mobilenetworkprefixes.front ().first = prefix;
+}
+
+uint8_t BCache::Entry::GetMobileNetworkPrefixLength () const      //NEMO
+{
+  if (m_mobilenetworkprefixes.empty ())
+    {
+      return 64;
+    }
+  return m_mobilenetworkprefixes.front ().second;
+}
+
+void BCache::Entry::SetMobileNetworkPrefixLength (uint8_t length)   //NEMO
+{
+  if (m_mobilenetworkprefixes.empty ())
+    {
+      m_mobilenetworkprefixes.push_back (Prefix (Ipv6Address::GetAny (), length));
+      return;
+    }
+  m_mobilenetworkprefixes.front ().second = length;
+}
+
+void BCache::Entry::AddMobileNetworkPrefix (Ipv6Address prefix, uint8_t length)   //NEMO
+{
+  NS_LOG_FUNCTION (this << prefix << (uint32_t)length);
+
+  m_mobilenetworkprefixes.push_back (Prefix (prefix, length));
+}
+
+const BCache::Entry::PrefixList &BCache::Entry::GetMobileNetworkPrefixes () const   //NEMO
+{
+  return m_mobilenetworkprefixes;
+}
+
+void BCache::Entry::AddCareOfAddress (Ipv6Address coa, uint16_t weight)
+{
+  NS_LOG_FUNCTION (this << coa << weight);
+
+  m_careOfAddresses.push_back (CareOf (coa, weight));
+}
+
+const BCache::Entry::CareOfList &BCache::Entry::GetCareOfAddresses () const
+{
+  return m_careOfAddresses;
+}
+
+void BCache::Entry::StartLifetimeTimer (Time lifetime)
+{
+  NS_LOG_FUNCTION (this << lifetime);
+
+  m_lifetimeTimer.SetTimingWheel (m_bCache->GetTimingWheel ());
+  m_lifetimeTimer.SetFunction (&BCache::Entry::FunctionLifetimeTimeout, this);
+  m_lifetimeTimer.Schedule (lifetime);
+}
+
+void BCache::Entry::StopLifetimeTimer ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_lifetimeTimer.Cancel ();
+}
+
+Time BCache::Entry::GetRemainingLifetime () const
+{
+  return m_lifetimeTimer.GetDelayLeft ();
+}
+
+void BCache::Entry::FunctionLifetimeTimeout ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_bCache->m_lifetimeExpiredCallback.IsNull ())
+    {
+      m_bCache->m_lifetimeExpiredCallback (this);
+    }
 }
 
 
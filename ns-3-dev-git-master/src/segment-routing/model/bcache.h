@@ -4,12 +4,17 @@
 
 
 #include <list>
+#include <map>
+#include <vector>
+#include <functional>
 #include "ns3/nstime.h"
 #include "ns3/node.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
 #include "ns3/timer.h"
+#include "ns3/callback.h"
 #include "ns3/sgi-hashmap.h"
+#include "timing-wheel.h"
 
 namespace ns3 {
 
@@ -67,6 +72,32 @@ public:
    */
   bool LookupSHoa (Ipv6Address shoa);
 
+  /**
+   * \brief Longest prefix match over the registered mobile network prefixes.
+   * \param addr address inside a mobile network
+   * \returns the entry of the MR serving the prefix, or 0
+   */
+  BCache::Entry * LookupMobileNetworkPrefix (Ipv6Address addr);
+
+  /**
+   * \brief whether a prefix is one of the home prefixes.
+   * \param prefix the prefix
+   * \returns status
+   */
+  bool IsHomePrefix (Ipv6Address prefix) const;
+
+  /**
+   * \brief get the number of cached MNs.
+   * \returns the number of entries
+   */
+  uint32_t GetSize () const;
+
+  /**
+   * \brief size the hashmaps for a number of MNs, to avoid rehashing as they register.
+   * \param n expected number of entries
+   */
+  void Reserve (uint32_t n);
+
   /**
    * \brief delete all entries in the cache
    */
@@ -93,6 +124,24 @@ public:
 
   std::list<Ipv6Address> GetHomePrefixes (); // NEMO
 
+  /**
+   * \brief run the lifetime timers of the entries on a timing wheel.
+   * \param wheel the timing wheel, or 0 for one scheduler event per entry
+   */
+  void SetTimingWheel (Ptr<TimingWheel> wheel);
+
+  /**
+   * \brief get the timing wheel of the lifetime timers.
+   * \returns the timing wheel, or 0
+   */
+  Ptr<TimingWheel> GetTimingWheel () const;
+
+  /**
+   * \brief set the callback invoked when the lifetime of an entry expires.
+   * \param callback the callback
+   */
+  void SetLifetimeExpiredCallback (Callback<void, BCache::Entry *> callback);
+
 
   /**
    * Entry for an MN
@@ -250,6 +299,18 @@ public:
      */
     Ipv6Address GetOldCoa () const;
 
+    /**
+     * \brief get the CoA pre-registered by the MN before a handover
+     * \returns the alternate CoA, any if none
+     */
+    Ipv6Address GetAlternateCoa () const;
+
+    /**
+     * \brief set the CoA pre-registered by the MN before a handover
+     * \param coa the alternate CoA, any to clear it
+     */
+    void SetAlternateCoa (Ipv6Address coa);
+
     /**
      * \brief get home init cookie of MN
      * \returns the home init cookie
@@ -365,7 +426,88 @@ public:
    */
   void SetMobileNetworkPrefix (Ipv6Address prefix);   //NEMO
 
+  /**
+   * \brief get mobile network prefix length.
+   * \return mobile network prefix length
+   */
+  uint8_t GetMobileNetworkPrefixLength () const;   //NEMO
+
+  /**
+   * \brief set mobile network prefix length.
+   * \param length mobile network prefix length.
+   */
+  void SetMobileNetworkPrefixLength (uint8_t length);   //NEMO
+
+  /**
+   * \brief A mobile network prefix and its length.
+   */
+  typedef std::pair<Ipv6Address, uint8_t> Prefix;
+
+  /**
+   * \brief The mobile network prefixes of an MR, the first one is the
+   * prefix of Get/SetMobileNetworkPrefix.
+   */
+  typedef std::vector<Prefix> PrefixList;
+
+  /**
+   * \brief add a mobile network prefix, for an MR registering several ones.
+   * \param prefix mobile network prefix
+   * \param length mobile network prefix length
+   */
+  void AddMobileNetworkPrefix (Ipv6Address prefix, uint8_t length);
+
+  /**
+   * \brief get all the mobile network prefixes.
+   * \return the prefixes, empty for a host
+   */
+  const PrefixList &GetMobileNetworkPrefixes () const;
+
+  /**
+   * \brief A CoA registered by a multihomed MN and its share of the traffic.
+   */
+  typedef std::pair<Ipv6Address, uint16_t> CareOf;
+
+  /**
+   * \brief The CoAs registered together with Binding Identifier options.
+   */
+  typedef std::vector<CareOf> CareOfList;
+
+  /**
+   * \brief add a CoA of a multihomed MN.
+   * \param coa the CoA
+   * \param weight share of the flows sent to the CoA
+   */
+  void AddCareOfAddress (Ipv6Address coa, uint16_t weight);
+
+  /**
+   * \brief get the CoAs of a multihomed MN.
+   * \return the CoAs and their weights, empty if the binding has the CoA of GetCoa only
+   */
+  const CareOfList &GetCareOfAddresses () const;
+
+  /**
+   * \brief start the binding lifetime timer.
+   * \param lifetime the binding lifetime
+   */
+  void StartLifetimeTimer (Time lifetime);
+
+  /**
+   * \brief stop the binding lifetime timer.
+   */
+  void StopLifetimeTimer ();
+
+  /**
+   * \brief get the remaining binding lifetime.
+   * \returns the remaining lifetime
+   */
+  Time GetRemainingLifetime () const;
+
   private:
+  /**
+   * \brief called when the binding lifetime expires.
+   */
+  void FunctionLifetimeTimeout ();
+
 
     /**
      * \brief The BCache object which holds this entry
@@ -435,6 +577,11 @@ public:
      */
     Ipv6Address m_oldCoa;
 
+    /**
+     * \brief The CoA pre-registered for the next handover of the MN
+     */
+    Ipv6Address m_alternateCoa;
+
     /**
      * \brief The home init cookie of the MN
      */
@@ -475,11 +622,20 @@ public:
      */
     bool m_FlagR;                           //NEMO
 
-     /**
-     * \brief Mobile Network Prefix Of MR
-     */   
+    /**
+     * \brief Mobile Network Prefixes Of MR, with their lengths
+     */
+    PrefixList m_mobilenetworkprefixes;     //NEMO
 
-    Ipv6Address m_mobilenetworkprefix;     //NEMO
+    /**
+     * \brief The CoAs of a multihomed MN, with their weights
+     */
+    CareOfList m_careOfAddresses;
+
+    /**
+     * \brief The binding lifetime timer
+     */
+    TimingWheelTimer m_lifetimeTimer;
 
   };
 
@@ -497,13 +653,60 @@ private:
    */
   typedef sgi::hash_map<Ipv6Address, BCache::Entry *, Ipv6AddressHash>::iterator BCacheI;
 
+  /**
+   * \brief Reference counts keyed by address
+   */
+  typedef sgi::hash_map<Ipv6Address, uint32_t, Ipv6AddressHash> AddressCount;
+
+  /**
+   * \brief Entries keyed by masked MNP, one hashmap per prefix length, longest first
+   */
+  typedef std::map<uint8_t, bCache, std::greater<uint8_t> > MnpIndex;
+
   void DoDispose ();
 
+  /**
+   * \brief add an entry to the secondary indexes.
+   * \param entry the entry, keyed by its HoA, solicited HoA and MNP
+   */
+  void IndexEntry (BCache::Entry *entry);
+
+  /**
+   * \brief remove an entry from the secondary indexes.
+   * \param entry the entry
+   */
+  void UnindexEntry (BCache::Entry *entry);
+
   /**
    * \brief The BCache 
    */
   bCache m_bCache;
 
+  /**
+   * \brief The solicited HoAs of the cached entries
+   */
+  AddressCount m_sHoaIndex;
+
+  /**
+   * \brief The MNPs of the cached entries
+   */
+  MnpIndex m_mnpIndex;
+
+  /**
+   * \brief The home prefixes
+   */
+  AddressCount m_homePrefixIndex;
+
+  /**
+   * \brief The timing wheel of the lifetime timers
+   */
+  Ptr<TimingWheel> m_timingWheel;
+
+  /**
+   * \brief The callback invoked when a binding expires
+   */
+  Callback<void, BCache::Entry *> m_lifetimeExpiredCallback;
+
     /**
      * \brief The home agent address list 
      */
@@ -51,21 +51,27 @@ void BList::SetNode (Ptr<Node> node)
   m_node = node;
 }
 
-BList::BList (std::list<Ipv6Address> haalist)
+void BList::SetTimingWheel (Ptr<TimingWheel> wheel)
+{
+  NS_LOG_FUNCTION (this << wheel);
+
+  m_hretransTimer.SetTimingWheel (wheel);
+  m_hreachableTimer.SetTimingWheel (wheel);
+  m_hrefreshTimer.SetTimingWheel (wheel);
+  m_cnretransTimer.SetTimingWheel (wheel);
+  m_cnreachableTimer.SetTimingWheel (wheel);
+  m_cnrefreshTimer.SetTimingWheel (wheel);
+  m_hotiretransTimer.SetTimingWheel (wheel);
+  m_cotiretransTimer.SetTimingWheel (wheel);
+}
+
+BList::BList (std::list<Ipv6Address> haalist, std::list<Ipv6Address> aralist)
   : m_hstate (UNREACHABLE),
   m_tunnelIfIndex (-1),
   m_hpktbu (0),
-  m_HaaList (haalist),
-  m_hretransTimer (Timer::CANCEL_ON_DESTROY),
-  m_hreachableTimer (Timer::CANCEL_ON_DESTROY),
-  m_hrefreshTimer (Timer::CANCEL_ON_DESTROY),
+  m_config (Create<Mipv6MnConfig> (haalist, aralist, false, Ipv6Address::GetAny ())),
   m_cnstate (UNREACHABLE),
   m_cnpktbu (0),
-  m_cnretransTimer (Timer::CANCEL_ON_DESTROY),
-  m_cnreachableTimer (Timer::CANCEL_ON_DESTROY),
-  m_cnrefreshTimer (Timer::CANCEL_ON_DESTROY),
-  m_hotiretransTimer (Timer::CANCEL_ON_DESTROY),
-  m_cotiretransTimer (Timer::CANCEL_ON_DESTROY),
   m_HomeAddressRegisteredFlag (false),
   m_ARAddressRegisteredFlag (false),
   m_FlagR(0)  //NEMO
@@ -74,6 +80,21 @@ BList::BList (std::list<Ipv6Address> haalist)
   NS_LOG_FUNCTION_NOARGS ();
 }
 
+BList::BList (Ptr<const Mipv6MnConfig> config)
+  : m_hstate (UNREACHABLE),
+  m_tunnelIfIndex (-1),
+  m_hpktbu (0),
+  m_config (config),
+  m_cnstate (UNREACHABLE),
+  m_cnpktbu (0),
+  m_HomeAddressRegisteredFlag (false),
+  m_ARAddressRegisteredFlag (false),
+  m_FlagR(0)  //NEMO
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (config);
+}
+
 void BList::SetHomeAddressRegistered (bool flag)
 {
   m_HomeAddressRegisteredFlag = flag;
@@ -105,7 +126,7 @@ void BList::FunctionHomeRefreshTimeout ()
 
   ResetHomeRetryCount ();
 
-  mn->SendMessage (p->Copy (), GetHA (), 64);
+  mn->SendMessage (p->Copy (), GetCoa (), GetHA (), 64);
 
   MarkHomeRefreshing ();
 
@@ -138,7 +159,7 @@ void BList::FunctionHomeReachableTimeout ()
 
 
   //delete routing && tunnel
-  if (m_tunnelIfIndex >= 0)
+  if (m_tunnelIfIndex >= 0 || mn->IsSegmentRoutingEnabled ())
     {
       mn->ClearTunnelAndRouting ();
     }
@@ -165,7 +186,7 @@ void BList::FunctionHomeRetransTimeout ()
       return;
     }
 
-  mn->SendMessage (GetHomeBUPacket ()->Copy (), GetHA (), 64);
+  mn->SendMessage (GetHomeBUPacket ()->Copy (), GetCoa (), GetHA (), 64);
 
   StartHomeRetransTimer ();
 }
@@ -425,12 +446,18 @@ void BList::SetHA (Ipv6Address ha)
 
 std::list<Ipv6Address> BList::GetHomeAgentList () const
 {
-  return m_HaaList;
+  return m_config->GetHomeAgentList ();
 }
 
 void BList::SetHomeAgentList (std::list<Ipv6Address> haalist)
 {
-  m_HaaList = haalist;
+  /* the configuration may be shared with other MNs */
+  m_config = m_config->WithHomeAgentList (haalist);
+}
+
+Ptr<const Mipv6MnConfig> BList::GetConfig () const
+{
+  return m_config;
 }
 
 bool BList::GetHomeBUFlag () const
@@ -1031,6 +1058,15 @@ void BList::ARConnectionTimeout ()
 {
   NS_LOG_FUNCTION (this);
 
+  Ptr<Mipv6Mn> mn = GetNode ()->GetObject<Mipv6Mn> ();
+
+  if (!mn)
+    {
+      NS_LOG_WARN ("No MN for Binding Update List");
+
+      return;
+    }
+
   if (IsHomeReachable ())
     {
       MarkHomeUnreachable ();
@@ -1042,7 +1078,7 @@ void BList::ARConnectionTimeout ()
 
 
   //delete routing && tunnel
-  if (m_tunnelIfIndex >= 0)
+  if (m_tunnelIfIndex >= 0 || mn->IsSegmentRoutingEnabled ())
     {
       mn->ClearTunnelAndRouting ();
     }
@@ -6,8 +6,9 @@
 #include "ns3/nstime.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
-#include "ns3/timer.h"
 #include "ns3/sgi-hashmap.h"
+#include "timing-wheel.h"
+#include "sr-mn-config.h"
 
 namespace ns3 {
 
@@ -24,7 +25,12 @@ public:
    * \param haalist home agent address list
    * \param aralist AR router address list
    */
-  BList (std::list<Ipv6Address> haalist);
+  BList (std::list<Ipv6Address> haalist, std::list<Ipv6Address> aralist);
+  /**
+   * \brief constructor.
+   * \param config shared configuration of the MN, not copied
+   */
+  BList (Ptr<const Mipv6MnConfig> config);
   /**
    * \brief destructor
    */
@@ -42,6 +48,12 @@ public:
    */
   void SetNode (Ptr<Node> node);
 
+  /**
+   * \brief run the binding timers on a timing wheel.
+   * \param wheel the timing wheel, or 0 for one scheduler event per timer
+   */
+  void SetTimingWheel (Ptr<TimingWheel> wheel);
+
 
 
   /**
@@ -135,6 +147,11 @@ public:
    */
   void FunctionHomeRefreshTimeout ();
 
+  /**
+   * \brief access router connection lost, drop the home binding.
+   */
+  void ARConnectionTimeout ();
+
   /**
    * \brief not used.
    */
@@ -279,6 +296,12 @@ public:
    */
   void SetHomeAgentList (std::list<Ipv6Address> haalist);
 
+  /**
+   * \brief get the shared configuration.
+   * \return the configuration
+   */
+  Ptr<const Mipv6MnConfig> GetConfig () const;
+
   /**
    * \brief get home BU flag.
    * \return home BU flag
@@ -763,14 +786,9 @@ private:
   Ipv6Address m_ha;
 
   /**
-   * \brief home agent address list
+   * \brief shared configuration: home agent and AR router address lists
    */
-  std::list<Ipv6Address> m_HaaList;
-
-  /**
-  * \brief AR router address list
-  */
-  std::list<Ipv6Address> m_Aralist;
+  Ptr<const Mipv6MnConfig> m_config;
 
   /**
    * \brief home reachable time
@@ -780,17 +798,17 @@ private:
   /**
    * \brief home retransmission timer
    */
-  Timer m_hretransTimer;
+  TimingWheelTimer m_hretransTimer;
 
   /**
    * \brief home reachable timer
    */
-  Timer m_hreachableTimer;
+  TimingWheelTimer m_hreachableTimer;
 
   /**
    * \brief home refresh timer
    */
-  Timer m_hrefreshTimer;
+  TimingWheelTimer m_hrefreshTimer;
 
   /**
    * \brief home bu retry count
@@ -842,27 +860,27 @@ private:
   /**
    * \brief cn retransmission timer
    */
-  Timer m_cnretransTimer;
+  TimingWheelTimer m_cnretransTimer;
 
   /**
    * \brief cn reachable timer
    */
-  Timer m_cnreachableTimer;
+  TimingWheelTimer m_cnreachableTimer;
 
   /**
    * \brief cn refresh timer
    */
-  Timer m_cnrefreshTimer;
+  TimingWheelTimer m_cnrefreshTimer;
 
   /**
    * \brief hoti retransmission timer
    */
-  Timer m_hotiretransTimer;
+  TimingWheelTimer m_hotiretransTimer;
 
   /**
    * \brief coti retransmission timer
    */
-  Timer m_cotiretransTimer;
+  TimingWheelTimer m_cotiretransTimer;
 
   /**
    * \brief cn bu retry count
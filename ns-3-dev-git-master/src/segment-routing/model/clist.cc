@@ -2,12 +2,13 @@
 #include "ns3/log.h"
 #include "ns3/node.h"
 #include "clist.h"
-#include "sr-l4-protocol.h"
-#include "sr-mn.h"
 
-namespace ns3 {
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("CList");
+
+namespace ns3 {
+
 NS_OBJECT_ENSURE_REGISTERED (CList);
 
 TypeId CList::GetTypeId ()
@@ -18,26 +19,30 @@ TypeId CList::GetTypeId ()
   return tid;
 }
 
+CList::CList (Ipv6Address ar)
+  : m_ar (ar),
+  m_signalstate (STRONG),
+  m_load (0),
+  m_congested (false),
+  m_tunnelIfIndex (-1),
+  m_preRegistrationSequence (0),
+  m_preRegistered (false)
+{
+  NS_LOG_FUNCTION (this << ar);
+}
 
 CList::~CList ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  Flush ();
 }
 
 void CList::DoDispose ()
 {
-  //Flush ();
+  m_node = 0;
+  m_signalChangeCallback = MakeNullCallback<void, Ptr<CList> > ();
   Object::DoDispose ();
 }
 
-
-void CList::Flush ()
-{
-  delete this;
-}
-
-
 Ptr<Node> CList::GetNode () const
 {
   NS_LOG_FUNCTION (this);
@@ -52,27 +57,9 @@ void CList::SetNode (Ptr<Node> node)
   m_node = node;
 }
 
-CList::BList (std::list<Ipv6Address> aralist)
-  : m_signalstate (STRONG),
-  m_tunnelIfIndex (-1),
-  //m_hpktbu (0),
-  m_Aralist (aralist),
-  //m_hretransTimer (Timer::CANCEL_ON_DESTROY),
-  //m_hreachableTimer (Timer::CANCEL_ON_DESTROY),
-  //m_hrefreshTimer (Timer::CANCEL_ON_DESTROY),
-  //m_cnstate (UNREACHABLE),
-  //m_cnpktbu (0),
-  //m_cnretransTimer (Timer::CANCEL_ON_DESTROY),
-  //m_cnreachableTimer (Timer::CANCEL_ON_DESTROY),
-  //m_cnrefreshTimer (Timer::CANCEL_ON_DESTROY),
-  //m_hotiretransTimer (Timer::CANCEL_ON_DESTROY),
-  //m_cotiretransTimer (Timer::CANCEL_ON_DESTROY),
-  //m_HomeAddressRegisteredFlag (false),
-  //m_ARAddressRegisteredFlag (false),
-  //m_FlagR(0)  //NEMO
-
+Ipv6Address CList::GetAccessRouter () const
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  return m_ar;
 }
 
 bool CList::IsConnectionStrong () const
@@ -82,42 +69,170 @@ bool CList::IsConnectionStrong () const
   return m_signalstate == STRONG;
 }
 
-void MarkSignalSrengthWeak ()
+bool CList::IsConnectionPoor () const
 {
-    NS_LOG_FUNCTION (this);
-    m_signalstate = WEAK;
+  NS_LOG_FUNCTION (this);
+
+  return m_signalstate == POOR;
 }
 
-void MarkSignalSrengthPoor ()
+void CList::MarkSignalSrengthStrong ()
 {
-    NS_LOG_FUNCTION (this);
-    m_signalstate = POOR;
+  NS_LOG_FUNCTION (this);
+  SetSignalStrength (STRONG);
 }
 
-int16_t GetTunnelIfIndex () const 
+void CList::MarkSignalSrengthWeak ()
+{
+  NS_LOG_FUNCTION (this);
+  SetSignalStrength (WEAK);
+}
+
+void CList::MarkSignalSrengthPoor ()
+{
+  NS_LOG_FUNCTION (this);
+  SetSignalStrength (POOR);
+}
+
+void CList::SetSignalStrength (SignalStrength state)
+{
+  if (m_signalstate == state)
+    {
+      return;
+    }
+  m_signalstate = state;
+  if (!m_signalChangeCallback.IsNull ())
+    {
+      m_signalChangeCallback (this);
+    }
+}
+
+uint8_t CList::GetLoad () const
+{
+  return m_load;
+}
+
+void CList::SetLoad (uint8_t load)
+{
+  SetLoad (load, m_congested);
+}
+
+void CList::SetLoad (uint8_t load, bool congested)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) load << congested);
+
+  load = std::min<uint8_t> (load, 100);
+  if (m_load == load && m_congested == congested)
+    {
+      return;
+    }
+  m_load = load;
+  m_congested = congested;
+  if (!m_signalChangeCallback.IsNull ())
+    {
+      m_signalChangeCallback (this);
+    }
+}
+
+bool CList::IsCongested () const
+{
+  return m_congested;
+}
+
+uint8_t CList::GetPathWeight () const
+{
+  if (m_signalstate == POOR)
+    {
+      return 0;
+    }
+  uint8_t weight = 100 - m_load;
+  if (m_signalstate == WEAK)
+    {
+      weight /= 2;
+    }
+  if (m_congested)
+    {
+      weight /= 2;
+    }
+  return std::max<uint8_t> (weight, 1);
+}
+
+void CList::SetSignalChangeCallback (Callback<void, Ptr<CList> > cb)
+{
+  m_signalChangeCallback = cb;
+}
+
+int16_t CList::GetTunnelIfIndex () const
 {
   NS_LOG_FUNCTION (this);
 
   return m_tunnelIfIndex;
 }
 
-void SetTunnelIfIndex (int16_t tunnelif)
+void CList::SetTunnelIfIndex (int16_t tunnelif)
 {
   NS_LOG_FUNCTION ( this << tunnelif );
 
   m_tunnelIfIndex = tunnelif;
 }
 
-void SetSID(Segment sid) 
+void CList::SetSIDRoute (Segment sid)
 {
   m_sid = sid;
 }
 
-Segment GetSID () const
+Segment CList::GetSID () const
 {
   return m_sid;
 }
 
+Ipv6Address CList::GetCareOfAddress () const
+{
+  return m_coa;
+}
+
+void CList::SetCareOfAddress (Ipv6Address coa)
+{
+  NS_LOG_FUNCTION (this << coa);
+
+  m_coa = coa;
+}
+
+uint16_t CList::GetPreRegistrationSequence () const
+{
+  return m_preRegistrationSequence;
+}
+
+void CList::SetPreRegistrationSequence (uint16_t sequence)
+{
+  m_preRegistrationSequence = sequence;
+}
+
+bool CList::IsPreRegistered () const
+{
+  return m_preRegistered;
+}
+
+void CList::SetPreRegistered (bool registered)
+{
+  NS_LOG_FUNCTION (this << registered);
+
+  m_preRegistered = registered;
+}
+
+bool CList::IsPrepared () const
+{
+  return !m_coa.IsAny ();
+}
 
+void CList::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_coa = Ipv6Address::GetAny ();
+  m_sid = Segment ();
+  m_preRegistrationSequence = 0;
+  m_preRegistered = false;
+}
 
-}
\ No newline at end of file
+} /* namespace ns3 */
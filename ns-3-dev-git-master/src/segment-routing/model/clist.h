@@ -2,105 +2,278 @@
 #ifndef C_LIST_H
 #define C_LIST_H
 
-#include <list>
-#include "ns3/packet.h"
-#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/node.h"
+#include "ns3/callback.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
-#include "ns3/timer.h"
-#include "ns3/sgi-hashmap.h"
 #include "ns3/segment.h"
 
 namespace ns3 {
-  class CList : public Object 
+
+/**
+ * \class CList
+ * \brief Candidate AR of an MN, for the make-before-break handover.
+ *
+ * Each AR of the MN configuration has an entry with the strength of its
+ * signal at the MN. When the signal of the serving AR weakens, the MN
+ * prepares the handover to a strong candidate: the CoA the MN will form on
+ * its link, the SID of this CoA and the BU pre-registering it with the HA.
+ * The load and the congestion of the AR, pushed by a NetworkMonitor, steer
+ * the MN away from the congested cells.
+ */
+class CList : public Object
+{
+public:
+  /**
+   * \brief Get the type identifier.
+   * \return type identifier
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief constructor.
+   * \param ar AR router address
+   */
+  CList (Ipv6Address ar);
+
+  /**
+   * \brief destructor
+   */
+  ~CList ();
+
+  /**
+   * \brief get the node pointer.
+   * \returns the node pointer
+   */
+  Ptr<Node> GetNode () const;
+
+  /**
+   * \brief set the node pointer.
+   * \param node the node pointer
+   */
+  void SetNode (Ptr<Node> node);
+
+  /**
+   * \brief get the AR router address.
+   * \returns the AR address
+   */
+  Ipv6Address GetAccessRouter () const;
+
+  /**
+   * \brief whether AR has a strong connection
+   * \returns true or false
+   */
+  bool IsConnectionStrong () const;
+
+  /**
+   * \brief whether AR has a poor connection, i.e. the link is about to be lost
+   * \returns true or false
+   */
+  bool IsConnectionPoor () const;
+
+  /**
+   * \brief sets signal strength to strong
+   */
+  void MarkSignalSrengthStrong ();
+
+  /**
+   * \brief sets signal strength to weak
+   */
+  void MarkSignalSrengthWeak ();
+
+  /**
+   * \brief sets signal strength to poor
+   */
+  void MarkSignalSrengthPoor ();
+
+  /**
+   * \brief get the load reported by the AR.
+   * \return the share of the capacity of the AR in use, in percent
+   */
+  uint8_t GetLoad () const;
+
+  /**
+   * \brief set the load reported by the AR, notified as a signal change.
+   * \param load the share of the capacity of the AR in use, in percent
+   */
+  void SetLoad (uint8_t load);
+
+  /**
+   * \brief set the load and the congestion of the AR, notified once as a signal change.
+   * \param load the share of the capacity of the AR in use, in percent
+   * \param congested whether the cell of the AR is congested
+   */
+  void SetLoad (uint8_t load, bool congested);
+
+  /**
+   * \brief whether the cell of the AR is congested, the MN steers away from it.
+   * \return true if congested
+   */
+  bool IsCongested () const;
+
+  /**
+   * \brief get the share of the flows of a multihomed MN to send through this AR.
+   *
+   * The spare capacity of the AR, halved on a weak signal and on a
+   * congestion; 0 on a poor signal, at least 1 otherwise.
+   * \return the weight, from 0 to 100
+   */
+  uint8_t GetPathWeight () const;
+
+  /**
+   * \brief set the callback invoked when the signal strength or the load changes.
+   * \param cb the callback
+   */
+  void SetSignalChangeCallback (Callback<void, Ptr<CList> > cb);
+
+  /**
+   * \brief get tunnel interface index.
+   * \return tunnel interface index
+   */
+  int16_t GetTunnelIfIndex () const;
+
+  /**
+   * \brief set tunnel interface index
+   * \param tunnelif tunnel interface index
+   */
+  void SetTunnelIfIndex (int16_t tunnelif);
+
+  /**
+   * \brief assign SID to this router
+   * \param sid the End SID of the MN behind this router
+   */
+  void SetSIDRoute (Segment sid);
+
+  /**
+   * \brief return SID
+   * \return the End SID of the MN behind this router
+   */
+  Segment GetSID () const;
+
+  /**
+   * \brief get the CoA the MN forms on the link of this AR.
+   * \return the CoA, any if the handover is not prepared
+   */
+  Ipv6Address GetCareOfAddress () const;
+
+  /**
+   * \brief set the CoA the MN forms on the link of this AR.
+   * \param coa the CoA
+   */
+  void SetCareOfAddress (Ipv6Address coa);
+
+  /**
+   * \brief get the sequence of the BU pre-registering the CoA.
+   * \return the sequence
+   */
+  uint16_t GetPreRegistrationSequence () const;
+
+  /**
+   * \brief set the sequence of the BU pre-registering the CoA.
+   * \param sequence the sequence
+   */
+  void SetPreRegistrationSequence (uint16_t sequence);
+
+  /**
+   * \brief whether the HA accepted the pre-registration of the CoA.
+   * \return true if pre-registered
+   */
+  bool IsPreRegistered () const;
+
+  /**
+   * \brief set whether the HA accepted the pre-registration of the CoA.
+   * \param registered true if pre-registered
+   */
+  void SetPreRegistered (bool registered);
+
+  /**
+   * \brief whether the handover to this AR is prepared.
+   * \return true if a CoA is predicted
+   */
+  bool IsPrepared () const;
+
+  /**
+   * \brief drop the preparation of the handover to this AR.
+   */
+  void Reset ();
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /**
+   * \brief signal strength of the AR at the MN
+   */
+  enum SignalStrength
   {
-   public:
-    /**
-        * \brief Get the type identifier.
-        * \return type identifier
-    */
-    static TypeId GetTypeId ();
-    /**
-        * \brief constructor.
-        * \param aralist AR router address list
-    */
-    CList (std::list<Ipv6Address> aralist);
-    /**
-        * \brief destructor
-        */
-    ~CList ();
-
-    /**
-        * \brief get the node pointer.
-        * \returns the node pointer 
-    */
-    Ptr<Node> GetNode () const;
-
-    /**
-        * \brief set the node pointer.
-        * \param node the node pointer 
-    */
-    void SetNode (Ptr<Node> node);
-
-    /**
-        * \brief whether AR has a strong connection
-        * \returns true or false
-    */
-    bool IsConnectionStrong() const;
-
-    /**
-     * \brief sets signal strength to weak
-    */
-    void MarkSignalSrengthWeak ();
-
-    /**
-    * \brief sets signal strength to poor
-    */
-    void MarkSignalSrengthPoor ();
-
-    /**
-        * \brief get tunnel interface index.
-        * \return tunnel interface index
-    */
-    int16_t GetTunnelIfIndex () const;
-
-    /**
-     * \brief set tunnel interface index
-    */
-    void SetTunnelIfIndex (int16_t tunnelif);
-
-    /**
-     * \brief assign SID to this router
-    */
-    void SetSIDRoute(Segment sid);
-
-    /**
-    * \brief return SID
-    */
-    Segment GetSID () const;
-
-   private:
-    enum SignalStrength {
-        POOR,
-        WEAK,
-        STRONG
-    }
-
-    SignalStrength m_signalstate;
-
-    /**
-    * \brief tunnel interface index
-    */
-    int16_t m_tunnelIfIndex;
-
-    /**
-    * \brief SID
-    */
-    Segment m_sid;
-
-
-
-
-
-  }
-}
\ No newline at end of file
+    POOR,
+    WEAK,
+    STRONG
+  };
+
+  /**
+   * \brief set the signal strength and notify a change.
+   * \param state the signal strength
+   */
+  void SetSignalStrength (SignalStrength state);
+
+  /**
+   * \brief the node
+   */
+  Ptr<Node> m_node;
+
+  /**
+   * \brief AR router address
+   */
+  Ipv6Address m_ar;
+
+  /**
+   * \brief signal strength
+   */
+  SignalStrength m_signalstate;
+
+  /**
+   * \brief load reported by the AR, in percent
+   */
+  uint8_t m_load;
+
+  /**
+   * \brief whether the cell of the AR is congested
+   */
+  bool m_congested;
+
+  /**
+   * \brief callback invoked on a change of the signal strength or of the load
+   */
+  Callback<void, Ptr<CList> > m_signalChangeCallback;
+
+  /**
+   * \brief tunnel interface index
+   */
+  int16_t m_tunnelIfIndex;
+
+  /**
+   * \brief SID
+   */
+  Segment m_sid;
+
+  /**
+   * \brief CoA predicted on the link of the AR
+   */
+  Ipv6Address m_coa;
+
+  /**
+   * \brief sequence of the pre-registration BU
+   */
+  uint16_t m_preRegistrationSequence;
+
+  /**
+   * \brief whether the HA accepted the pre-registration
+   */
+  bool m_preRegistered;
+};
+
+} /* namespace ns3 */
+
+#endif /* C_LIST_H */
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
@@ -12,6 +13,9 @@
 #include "cn.h"
 #include "ns3/object.h"
 #include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "ns3/hash-murmur3.h"
 
 using namespace std;
 
@@ -31,6 +35,21 @@ Mipv6CN::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&Mipv6CN::m_bCache),
                    MakePointerChecker<BCache> ())
+    .AddAttribute ("NonceCount",
+                   "Number of nonces accepted in a BU, the oldest one is replaced every NonceLifetime.",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&Mipv6CN::m_nonceCount),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("NonceLifetime",
+                   "Time before a new nonce replaces the oldest one.",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&Mipv6CN::m_nonceLifetime),
+                   MakeTimeChecker (Seconds (1)))
+    .AddAttribute ("TestBatchDelay",
+                   "Time waited to answer the HoTIs and CoTIs together, 0 to only group the ones received at the same time.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Mipv6CN::m_testBatchDelay),
+                   MakeTimeChecker ())
     .AddTraceSource ("RxBU",
                      "Receive BU packet from MN",
                      MakeTraceSourceAccessor (&Mipv6CN::m_rxbuTrace),
@@ -43,8 +62,13 @@ Mipv6CN::GetTypeId (void)
 
 
 Mipv6CN::Mipv6CN ()
-  : m_bCache (0)
+  : m_bCache (0),
+  m_key (0),
+  m_noncePeriod (0),
+  m_nonceCount (8),
+  m_hasher (Create<Hash::Function::Murmur3> ())
 {
+  m_random = CreateObject<UniformRandomVariable> ();
 }
 
 Mipv6CN::~Mipv6CN ()
@@ -62,16 +86,200 @@ void Mipv6CN::NotifyNewAggregate ()
 
       SetNode (node);
       m_bCache->SetNode (node);
+      m_bCache->SetLifetimeExpiredCallback (MakeCallback (&Mipv6CN::BindingLifetimeExpired, this));
+    }
 
+  Mipv6Agent::NotifyNewAggregate ();
+}
 
+void Mipv6CN::DoInitialize ()
+{
+  NS_LOG_FUNCTION (this);
 
+  if (IsTimingWheelEnabled () && m_bCache)
+    {
+      m_bCache->SetTimingWheel (TimingWheel::GetTimingWheel (GetNode ()));
     }
+  Mipv6Agent::DoInitialize ();
+}
 
-  Mipv6Agent::NotifyNewAggregate ();
+void Mipv6CN::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flushEvent.Cancel ();
+  m_pendingTests.clear ();
+  Mipv6Agent::DoDispose ();
+}
+
+void Mipv6CN::ReserveBindings (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT_MSG (m_bCache, "binding cache not created, aggregate the CN first");
+  m_bCache->Reserve (n);
+}
+
+int64_t Mipv6CN::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_random->SetStream (stream);
+  return 1;
+}
+
+uint64_t Mipv6CN::DrawRandom ()
+{
+  uint64_t high = m_random->GetInteger (0, 0xffffffff);
+  return (high << 32) | m_random->GetInteger (0, 0xffffffff);
+}
+
+void Mipv6CN::RotateNonces ()
+{
+  uint64_t period = Simulator::Now ().GetTimeStep () / m_nonceLifetime.GetTimeStep ();
+
+  if (m_nonces.empty ())
+    {
+      //no nonce before the first one: the other slots hold an index they cannot match
+      m_key = DrawRandom ();
+      Nonce nonce = { uint16_t (period), 0 };
+      m_nonces.assign (m_nonceCount, nonce);
+      m_nonces[uint16_t (period) % m_nonceCount].value = DrawRandom ();
+      m_noncePeriod = period;
+      return;
+    }
+
+  if (period <= m_noncePeriod)
+    {
+      return;
+    }
+  uint64_t first = m_noncePeriod + 1;
+  if (period - m_noncePeriod > m_nonces.size ())
+    {
+      first = period - m_nonces.size () + 1;
+    }
+  for (uint64_t p = first; p <= period; p++)
+    {
+      Nonce &nonce = m_nonces[uint16_t (p) % m_nonces.size ()];
+      nonce.index = uint16_t (p);
+      nonce.value = DrawRandom ();
+    }
+  m_noncePeriod = period;
+}
+
+uint16_t Mipv6CN::GetNonceIndex ()
+{
+  RotateNonces ();
+  return uint16_t (m_noncePeriod);
+}
+
+bool Mipv6CN::IsNonceIndexValid (uint16_t index)
+{
+  RotateNonces ();
+  uint16_t age = uint16_t (m_noncePeriod) - index;
+  return age < m_nonces.size () && m_nonces[index % m_nonces.size ()].index == index;
+}
+
+uint64_t Mipv6CN::ComputeKeygenToken (Ipv6Address addr, uint16_t index, uint8_t kind)
+{
+  if (!IsNonceIndexValid (index))
+    {
+      return 0;
+    }
+
+  //RFC 6275 5.2.5 with a keyed Murmur3 instead of HMAC_SHA1: key | address | nonce | kind
+  uint8_t buf[33];
+  uint64_t nonce = m_nonces[index % m_nonces.size ()].value;
+  for (uint8_t i = 0; i < 8; i++)
+    {
+      buf[i] = m_key >> (56 - 8 * i);
+      buf[24 + i] = nonce >> (56 - 8 * i);
+    }
+  addr.GetBytes (buf + 8);
+  buf[32] = kind;
+  return m_hasher.clear ().GetHash64 ((const char *) buf, sizeof (buf));
+}
+
+uint64_t Mipv6CN::GetHomeKeygenToken (Ipv6Address hoa, uint16_t index)
+{
+  return ComputeKeygenToken (hoa, index, 0);
+}
+
+uint64_t Mipv6CN::GetCareOfKeygenToken (Ipv6Address coa, uint16_t index)
+{
+  return ComputeKeygenToken (coa, index, 1);
+}
+
+uint64_t Mipv6CN::ComputeAuthenticator (uint64_t homeToken, uint64_t careOfToken, Ipv6Address coa, Ipv6Address cn,
+                                        const uint8_t *mh, uint32_t size)
+{
+  NS_ASSERT (size >= 12 && size <= Mipv6MessageView::MAX_SIZE);
+
+  uint8_t buf[40 + Mipv6MessageView::MAX_SIZE];
+  for (uint8_t i = 0; i < 8; i++)
+    {
+      buf[i] = homeToken >> (56 - 8 * i);
+      buf[8 + i] = careOfToken >> (56 - 8 * i);
+    }
+  uint64_t kbm = Hash64 ((const char *) buf, 16);
+  for (uint8_t i = 0; i < 8; i++)
+    {
+      buf[i] = kbm >> (56 - 8 * i);
+    }
+  coa.GetBytes (buf + 8);
+  cn.GetBytes (buf + 24);
+
+  //the mobility header, with the authenticator zeroed
+  uint8_t *data = buf + 40;
+  std::copy (mh, mh + size, data);
+  Mipv6OptionIterator options (data + 12, size - 12);
+  while (options.Next ())
+    {
+      if (options.GetType () == Mipv6Header::IPV6_MOBILITY_OPT_BINDING_AUTHORIZATION_DATA && options.GetSize () == 10)
+        {
+          std::fill_n (data + 12 + options.GetOffset () + 2, 8, 0);
+          break;
+        }
+    }
+  return Hash64 ((const char *) buf, 40 + size);
+}
+
+bool Mipv6CN::GetAuthorization (Mipv6OptionIterator options, uint16_t &homeIndex, uint16_t &careOfIndex, uint64_t &authenticator)
+{
+  bool indices = false;
+  bool authorization = false;
+  while (options.Next ())
+    {
+      if (options.GetType () == Mipv6Header::IPV6_MOBILITY_OPT_NONCE_INDICES)
+        {
+          Ipv6MobilityOptionNonceIndicesHeader nonces;
+          if (!indices && options.Read (nonces))
+            {
+              homeIndex = nonces.GetHomeNonceIndex ();
+              careOfIndex = nonces.GetCareOfNonceIndex ();
+              indices = true;
+            }
+        }
+      else if (options.GetType () == Mipv6Header::IPV6_MOBILITY_OPT_BINDING_AUTHORIZATION_DATA)
+        {
+          Ipv6MobilityOptionBindingAuthorizationDataHeader authorizationData;
+          if (!authorization && options.Read (authorizationData))
+            {
+              authenticator = authorizationData.GetAuthenticator ();
+              authorization = true;
+            }
+        }
+    }
+  return indices && authorization;
+}
+
+void Mipv6CN::BindingLifetimeExpired (BCache::Entry *bce)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa ());
+
+  m_bCache->Remove (bce);
 }
 
 
-Ptr<Packet> Mipv6CN::BuildBA (Ipv6MobilityBindingUpdateHeader bu, Ipv6Address hoa, uint8_t status)
+Ptr<Packet> Mipv6CN::BuildBA (const Mipv6MessageView &bu, Ipv6Address hoa, uint8_t status)
 {
   NS_LOG_FUNCTION (this << status << "BUILD BACK");
 
@@ -92,239 +300,220 @@ Ptr<Packet> Mipv6CN::BuildBA (Ipv6MobilityBindingUpdateHeader bu, Ipv6Address ho
   return p;
 }
 
-Ptr<Packet> Mipv6CN::BuildHoT (Ipv6HoTIHeader hoti, Ipv6Address hoa)
+Ptr<Packet> Mipv6CN::BuildHoT (uint64_t cookie, Ipv6Address hoa, uint16_t index)
 {
-
   Ptr<Packet> p = Create<Packet> ();
-  BCache::Entry *bce;
-  bce = m_bCache->Lookup (hoa);
 
   Ipv6HoTHeader hot;
 
   hot.SetReserved (0);
-  hot.SetHomeInitCookie (hoti.GetHomeInitCookie ());
-  hot.SetHomeNonceIndex (bce->GetHomeNonceIndex ());
-  hot.SetHomeKeygenToken (bce->GetHomeKeygenToken ());
+  hot.SetHomeInitCookie (cookie);
+  hot.SetHomeNonceIndex (index);
+  hot.SetHomeKeygenToken (GetHomeKeygenToken (hoa, index));
   Ipv6ExtensionType2RoutingHeader type2extn;
   type2extn.SetReserved (0);
   type2extn.SetHomeAddress (hoa);
 
-
-
   p->AddHeader (type2extn);
   p->AddHeader (hot);
 
   return p;
 }
 
-Ptr<Packet> Mipv6CN::BuildCoT (Ipv6CoTIHeader coti, Ipv6Address hoa)
+Ptr<Packet> Mipv6CN::BuildCoT (uint64_t cookie, Ipv6Address coa, Ipv6Address hoa, uint16_t index)
 {
-
   Ptr<Packet> p = Create<Packet> ();
-  BCache::Entry *bce;
-  bce = m_bCache->Lookup (hoa);
 
   Ipv6CoTHeader cot;
 
-
-
   cot.SetReserved (0);
-  cot.SetCareOfInitCookie (coti.GetCareOfInitCookie ());
-  cot.SetCareOfNonceIndex (bce->GetCareOfNonceIndex ());
-  cot.SetCareOfKeygenToken (bce->GetCareOfKeygenToken ());
+  cot.SetCareOfInitCookie (cookie);
+  cot.SetCareOfNonceIndex (index);
+  cot.SetCareOfKeygenToken (GetCareOfKeygenToken (coa, index));
   Ipv6ExtensionType2RoutingHeader type2extn;
   type2extn.SetReserved (0);
   type2extn.SetHomeAddress (hoa);
 
-
-
   p->AddHeader (type2extn);
-
-
   p->AddHeader (cot);
 
   return p;
 }
 
-
-uint8_t Mipv6CN::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+void Mipv6CN::QueueTest (Ipv6Address peer, Ipv6Address hoa, uint64_t cookie, bool home)
 {
-  NS_LOG_FUNCTION (this << packet << src << dst << interface);
+  NS_LOG_FUNCTION (this << peer << hoa << home);
 
-  Ptr<Packet> p = packet->Copy ();
-  m_rxbuTrace (p, src, dst, interface);
+  PendingTest test = { peer, hoa, cookie, home };
+  m_pendingTests.push_back (test);
+  if (!m_flushEvent.IsRunning ())
+    {
+      m_flushEvent = Simulator::Schedule (m_testBatchDelay, &Mipv6CN::FlushTests, this);
+    }
+}
 
-  Ipv6MobilityBindingUpdateHeader bu;
-  p->RemoveHeader (bu);
+void Mipv6CN::FlushTests ()
+{
+  NS_LOG_FUNCTION (this << m_pendingTests.size ());
 
-  Ipv6ExtensionDestinationHeader dest;
-  p->RemoveHeader (dest);
+  std::vector<PendingTest> tests;
+  tests.swap (m_pendingTests);
+  uint16_t index = GetNonceIndex ();
+  for (std::vector<PendingTest>::const_iterator it = tests.begin (); it != tests.end (); it++)
+    {
+      Ptr<Packet> reply;
+      if (it->home)
+        {
+          reply = BuildHoT (it->cookie, it->hoa, index);
+        }
+      else
+        {
+          reply = BuildCoT (it->cookie, it->peer, it->hoa, index);
+        }
+      SendMessage (reply, it->peer, 64);
+    }
+}
+
+uint8_t Mipv6CN::HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+{
+  NS_LOG_FUNCTION (this << packet << src << dst << interface);
 
-  Buffer buf;
+  m_rxbuTrace (packet, src, dst, interface);
 
-  Buffer::Iterator start;
-  buf = dest.GetOptionBuffer ();
-  start = buf.Begin ();
-  Ipv6HomeAddressOptionHeader homopt;
-  homopt.Deserialize (start);
   Ipv6Address homeaddr;
-  homeaddr = homopt.GetHomeAddress ();
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("BU without home address option, ignored");
+      return 0;
+    }
 
   Ptr<Mipv6Demux> ipv6MobilityDemux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (ipv6MobilityDemux);
 
-  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (bu.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
 
-  uint8_t errStatus = 0;
-  BCache::Entry *bce = 0;
-  BCache::Entry *bce2 = 0;
+  uint16_t homeIndex = 0;
+  uint16_t careOfIndex = 0;
+  uint64_t authenticator = 0;
+  if (!GetAuthorization (view.GetOptions (), homeIndex, careOfIndex, authenticator))
+    {
+      NS_LOG_LOGIC ("BU without nonce indices or authorization data, ignored");
+      return 0;
+    }
 
+  //a deregistration is only authorized by the home token
+  bool deregistration = src == homeaddr || view.GetLifetime () == 0;
+  bool homeValid = IsNonceIndexValid (homeIndex);
+  bool careOfValid = deregistration || IsNonceIndexValid (careOfIndex);
 
-  bce = m_bCache->Lookup (homeaddr);
-  if (bce)
+  uint8_t errStatus = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
+  if (!homeValid && !careOfValid)
     {
-      bce->SetCoa (src);
-      bce->SetHoa (homeaddr);
-      bce->SetHA (dst);
-      bce->SetLastBindingUpdateSequence (bu.GetSequence ());
-      bce->SetLastBindingUpdateTime (Time (bu.GetLifetime ()));
-      errStatus = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
-      bce->MarkReachable ();
+      errStatus = Mipv6Header::BA_STATUS_EXPIRED_NONCES;
+    }
+  else if (!homeValid)
+    {
+      errStatus = Mipv6Header::BA_STATUS_EXPIRED_HOME_NONCE_INDEX;
+    }
+  else if (!careOfValid)
+    {
+      errStatus = Mipv6Header::BA_STATUS_EXPIRED_CARE_OF_NONCE_INDEX;
     }
-
   else
     {
-      bce2->SetCoa (src);
-      bce2->SetHoa (homeaddr);
-      bce2->SetHA (dst);
-      bce2->SetLastBindingUpdateSequence (bu.GetSequence ());
-      bce2->SetLastBindingUpdateTime (Time (bu.GetLifetime ()));
-      errStatus = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
-      bce2->MarkReachable ();
-
-      m_bCache->Add (bce2);
+      uint64_t careOfToken = deregistration ? 0 : GetCareOfKeygenToken (src, careOfIndex);
+      if (ComputeAuthenticator (GetHomeKeygenToken (homeaddr, homeIndex), careOfToken, src, dst,
+                                view.GetData (), view.GetSize ()) != authenticator)
+        {
+          NS_LOG_LOGIC ("Authenticator mismatch, BU ignored");
+          return 0;
+        }
+
+      BCache::Entry *bce = m_bCache->Lookup (homeaddr);
+      if (deregistration)
+        {
+          if (bce)
+            {
+              m_bCache->Remove (bce);
+            }
+        }
+      else
+        {
+          if (!bce)
+            {
+              bce = new BCache::Entry (m_bCache);
+              bce->SetHoa (homeaddr);
+              bce->SetSolicitedHoA (Ipv6Address::MakeSolicitedAddress (homeaddr));
+              m_bCache->Add (bce);
+            }
+          bce->SetCoa (src);
+          bce->SetHA (dst);
+          bce->SetLastBindingUpdateSequence (view.GetSequence ());
+          bce->SetLastBindingUpdateTime (Time (view.GetLifetime ()));
+          bce->SetHomeNonceIndex (homeIndex);
+          bce->SetCareOfNonceIndex (careOfIndex);
+          bce->MarkReachable ();
+          bce->StartLifetimeTimer (Seconds (view.GetLifetime () * 4.0));
+        }
     }
 
-  if (bu.GetFlagA ())
+  //the MN is told its nonces expired even if it asked for no BA
+  if (view.GetFlagA () || errStatus != Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED)
     {
       Ptr<Packet> ba;
-      ba = BuildBA (bu, homeaddr, errStatus);
+      ba = BuildBA (view, homeaddr, errStatus);
 
       SendMessage (ba, src, 64);
     }
   return 0;
 }
-uint8_t Mipv6CN::HandleHoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+
+uint8_t Mipv6CN::HandleHoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << packet << src << dst << interface);
 
-  Ptr<Packet> p = packet->Copy ();
-
-  Ipv6HoTIHeader hoti;
-  p->RemoveHeader (hoti);
-
-  Ipv6ExtensionDestinationHeader dest;
-  p->RemoveHeader (dest);
-
-  Buffer buf;
-
-  Buffer::Iterator start;
-  buf = dest.GetOptionBuffer ();
-  start = buf.Begin ();
-  Ipv6HomeAddressOptionHeader homopt;
-  homopt.Deserialize (start);
   Ipv6Address homeaddr;
-  homeaddr = homopt.GetHomeAddress ();
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("HoTI without home address option, ignored");
+      return 0;
+    }
 
   Ptr<Mipv6Demux> ipv6MobilityDemux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (ipv6MobilityDemux);
 
-  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (hoti.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
 
 
-  BCache::Entry *bce = 0;
-
-
-  bce = m_bCache->Lookup (homeaddr);
-
-
-  if (bce)
-    {
-      bce->SetHomeInitCookie (hoti.GetHomeInitCookie ());
-    }
-  else
-    {
-      BCache::Entry *bce2 = 0;
-      bce2->SetHoa (homeaddr);
-      bce2->SetHomeInitCookie (hoti.GetHomeInitCookie ());
-      m_bCache->Add (bce2);
-    }
-
-
-  Ptr<Packet> hot;
-  hot = BuildHoT (hoti, homeaddr);
-
-  SendMessage (hot, src, 64);
+  //no state is kept until the BU: the answer only depends on the current nonce
+  QueueTest (src, homeaddr, view.GetInitCookie (), true);
   return 0;
 }
 
-uint8_t Mipv6CN::HandleCoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6CN::HandleCoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << packet << src << dst << interface);
 
-  Ptr<Packet> p = packet->Copy ();
-
-  Ipv6CoTIHeader coti;
-  p->RemoveHeader (coti);
-
-  Ipv6ExtensionDestinationHeader dest;
-  p->RemoveHeader (dest);
-
-  Buffer buf;
-
-  Buffer::Iterator start;
-  buf = dest.GetOptionBuffer ();
-  start = buf.Begin ();
-  Ipv6HomeAddressOptionHeader homopt;
-  homopt.Deserialize (start);
   Ipv6Address homeaddr;
-  homeaddr = homopt.GetHomeAddress ();
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("CoTI without home address option, ignored");
+      return 0;
+    }
 
   Ptr<Mipv6Demux> ipv6MobilityDemux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (ipv6MobilityDemux);
 
-  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (coti.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
 
 
-  BCache::Entry *bce = 0;
-
-
-  bce = m_bCache->Lookup (homeaddr);
-
-
-  if (bce)
-    {
-      bce->SetCareOfInitCookie (coti.GetCareOfInitCookie ());
-    }
-  else
-    {
-      BCache::Entry *bce2 = 0;
-      bce2->SetHoa (homeaddr);
-      bce2->SetCareOfInitCookie (coti.GetCareOfInitCookie ());
-      m_bCache->Add (bce2);
-    }
-
-
-  Ptr<Packet> cot;
-  cot = BuildCoT (coti, homeaddr);
-
-  SendMessage (cot, src, 64);
+  QueueTest (src, homeaddr, view.GetInitCookie (), false);
   return 0;
 }
 
@@ -4,10 +4,26 @@
 #include "sr-agent.h"
 #include "bcache.h"
 #include "sr-header.h"
+#include "ns3/hash.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+
+#include <vector>
 
 namespace ns3 {
 class Packet;
 
+/**
+ * \brief Correspondent node of the return routability procedure.
+ *
+ * The CN keeps no state for the HoTIs and CoTIs, as in RFC 6275 5.2: the
+ * keygen tokens are keyed Murmur3 hashes of the address and of a nonce taken
+ * from a small array, which is rotated when it is used instead of on a timer.
+ * The tests received at the same time are answered together by one event, and
+ * the BCache only holds the bindings whose BU carried valid nonce indices and
+ * authenticator.
+ */
 class Mipv6CN : public Mipv6Agent
 {
 public:
@@ -36,71 +52,263 @@ public:
   typedef void (* RxBuTracedCallback)
     (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
 
+  /**
+   * \brief size the binding cache for a number of MNs.
+   * \param n expected number of MNs
+   */
+  void ReserveBindings (uint32_t n);
+
+  /**
+   * \brief Assign a fixed random variable stream number to the nonces.
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \brief get the index of the nonce given in the tests answered now.
+   * \return the nonce index
+   */
+  uint16_t GetNonceIndex ();
+
+  /**
+   * \brief whether a nonce index is still in the nonce array.
+   * \param index the nonce index
+   * \return true if the tokens made with the nonce are still accepted
+   */
+  bool IsNonceIndexValid (uint16_t index);
+
+  /**
+   * \brief compute the home keygen token of an MN.
+   * \param hoa home address
+   * \param index nonce index
+   * \return the home keygen token
+   */
+  uint64_t GetHomeKeygenToken (Ipv6Address hoa, uint16_t index);
+
+  /**
+   * \brief compute the care-of keygen token of an MN.
+   * \param coa care-of address
+   * \param index nonce index
+   * \return the care-of keygen token
+   */
+  uint64_t GetCareOfKeygenToken (Ipv6Address coa, uint16_t index);
+
+  /**
+   * \brief compute the authenticator of a BU sent to a CN.
+   *
+   * The binding management key is the hash of the two tokens, the care-of
+   * token is 0 for a deregistration. As in RFC 6275 section 5.2.6, it
+   * authenticates the CoA, the address of the CN and the whole mobility
+   * header, sequence and lifetime included, hashed with the authenticator
+   * field zeroed.
+   *
+   * \param homeToken home keygen token
+   * \param careOfToken care-of keygen token
+   * \param coa care-of address
+   * \param cn address of the CN
+   * \param mh bytes of the mobility header of the BU
+   * \param size length of the mobility header
+   * \return the authenticator
+   */
+  static uint64_t ComputeAuthenticator (uint64_t homeToken, uint64_t careOfToken, Ipv6Address coa, Ipv6Address cn,
+                                        const uint8_t *mh, uint32_t size);
+
 protected:
   virtual void NotifyNewAggregate ();
+  virtual void DoInitialize ();
+  virtual void DoDispose ();
 
   /**
    * \brief build BA.
-   * \param bu the received bu header
+   * \param bu the received BU
    * \param hoa home address
    * \param status staus of BU reception
    * \return the built BA 
    */
-  Ptr<Packet> BuildBA (Ipv6MobilityBindingUpdateHeader bu, Ipv6Address hoa, uint8_t status);
+  Ptr<Packet> BuildBA (const Mipv6MessageView &bu, Ipv6Address hoa, uint8_t status);
 
   /**
    * \brief build HoT.
-   * \param hoti the received hoti header
+   * \param cookie the home init cookie of the HoTI
    * \param hoa home address
+   * \param index nonce index
    * \return the built HoT 
    */
-  Ptr<Packet> BuildHoT (Ipv6HoTIHeader hoti, Ipv6Address hoa);
+  Ptr<Packet> BuildHoT (uint64_t cookie, Ipv6Address hoa, uint16_t index);
 
   /**
    * \brief build CoT.
-   * \param coti the received coti header
+   * \param cookie the care-of init cookie of the CoTI
+   * \param coa care-of address
    * \param hoa home address
+   * \param index nonce index
    * \return the built CoT 
    */
-  Ptr<Packet> BuildCoT (Ipv6CoTIHeader coti, Ipv6Address hoa);
+  Ptr<Packet> BuildCoT (uint64_t cookie, Ipv6Address coa, Ipv6Address hoa, uint16_t index);
 
   /**
    * \brief Handle BU.
    * \param packet the received BU packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst destination address
    * \param interface where it is received
    * \return BU handling status
    */
-  virtual uint8_t HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief Handle HoTI.
    * \param packet the received HoTI packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst destination address
    * \param interface where it is received
    * \return status 
    */
-  virtual uint8_t HandleHoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleHoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief Handle CoTI.
    * \param packet the received CoTI packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst destination address
    * \param interface where it is received 
    * \return status 
    */
-  virtual uint8_t HandleCoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleCoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
 private:
+  /**
+   * \brief A HoTI or CoTI waiting for its answer.
+   */
+  struct PendingTest
+  {
+    Ipv6Address peer;  //!< address the test came from, HoA or CoA
+    Ipv6Address hoa;   //!< home address of the MN
+    uint64_t cookie;   //!< init cookie of the test
+    bool home;         //!< HoTI if true, CoTI otherwise
+  };
+
+  /**
+   * \brief queue a test, the answers are sent together.
+   * \param peer address the test came from
+   * \param hoa home address of the MN
+   * \param cookie init cookie of the test
+   * \param home whether it is a HoTI
+   */
+  void QueueTest (Ipv6Address peer, Ipv6Address hoa, uint64_t cookie, bool home);
+
+  /**
+   * \brief answer the queued tests with the current nonce.
+   */
+  void FlushTests ();
+
+  /**
+   * \brief draw the key and the nonces which were not drawn yet.
+   *
+   * A new nonce replaces the oldest one every NonceLifetime; the nonces of the
+   * periods nobody asked for are drawn on the next request.
+   */
+  void RotateNonces ();
+
+  /**
+   * \brief draw a 64 bits random number.
+   * \return the number
+   */
+  uint64_t DrawRandom ();
+
+  /**
+   * \brief compute a keygen token.
+   * \param addr the HoA or the CoA
+   * \param index nonce index
+   * \param kind 0 for a home token, 1 for a care-of token
+   * \return the token, 0 if the nonce index is not valid
+   */
+  uint64_t ComputeKeygenToken (Ipv6Address addr, uint16_t index, uint8_t kind);
+
+  /**
+   * \brief read the nonce indices and authorization options of a BU in one walk.
+   * \param options the BU options
+   * \param homeIndex the home nonce index
+   * \param careOfIndex the care-of nonce index
+   * \param authenticator the authenticator
+   * \return false if one of the options is missing
+   */
+  bool GetAuthorization (Mipv6OptionIterator options, uint16_t &homeIndex, uint16_t &careOfIndex, uint64_t &authenticator);
+
+  /**
+   * \brief remove a binding whose lifetime expired.
+   * \param bce the binding
+   */
+  void BindingLifetimeExpired (BCache::Entry *bce);
+
+  /**
+   * \brief A nonce and its index.
+   */
+  struct Nonce
+  {
+    uint16_t index;  //!< nonce index
+    uint64_t value;  //!< nonce
+  };
 
   /**
    * \brief the binding cache associated with this CN 
    */
   Ptr<BCache> m_bCache;
 
+  /**
+   * \brief the secret key of the CN, 0 until drawn
+   */
+  uint64_t m_key;
+
+  /**
+   * \brief the nonces, the one of index i in slot i % NonceCount
+   */
+  std::vector<Nonce> m_nonces;
+
+  /**
+   * \brief the period of the current nonce
+   */
+  uint64_t m_noncePeriod;
+
+  /**
+   * \brief number of nonces accepted in a BU
+   */
+  uint16_t m_nonceCount;
+
+  /**
+   * \brief time before a new nonce replaces the oldest one
+   */
+  Time m_nonceLifetime;
+
+  /**
+   * \brief random variable for the key and the nonces
+   */
+  Ptr<UniformRandomVariable> m_random;
+
+  /**
+   * \brief Murmur3 hasher of the keygen tokens
+   */
+  Hasher m_hasher;
+
+  /**
+   * \brief the tests waiting for their answer
+   */
+  std::vector<PendingTest> m_pendingTests;
+
+  /**
+   * \brief time waited to answer the tests together
+   */
+  Time m_testBatchDelay;
+
+  /**
+   * \brief event sending the answers of the queued tests
+   */
+  EventId m_flushEvent;
+
   /**
    * \brief Callback to trace RX (reception) bu packets.
    */ 
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
@@ -20,8 +21,11 @@
 #include "sr-option.h" //NEMO
 #include "sr-l4-protocol.h"
 #include "sr-tun-l4-protocol.h"
+#include "sr-routing.h"
 #include "ha.h"
 #include "ns3/pointer.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
 #include "ns3/radvd.h"
 #include "ns3/radvd-interface.h"
 #include "ns3/radvd-prefix.h"
@@ -34,6 +38,10 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (Mipv6Ha);
 
+//lifetimes of the MNPs advertised by the HA, in seconds (NEMO)
+static const uint32_t g_mnpPreferredLifetime = 1;
+static const uint32_t g_mnpValidLifetime = 2;
+
 TypeId
 Mipv6Ha::GetTypeId (void)
 {
@@ -44,6 +52,11 @@ Mipv6Ha::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&Mipv6Ha::m_bCache),
                    MakePointerChecker<BCache> ())
+    .AddAttribute ("DadTimeout", "Time waited for an answer to the DAD probe of a new HoA, "
+                   "the BUs received during a DAD are acknowledged when their own DAD ends.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&Mipv6Ha::m_dadTimeout),
+                   MakeTimeChecker (Seconds (0)))
     .AddTraceSource ("RxBU",
                      "Receive BU packet from MN",
                      MakeTraceSourceAccessor (&Mipv6Ha::m_rxbuTrace),
@@ -54,7 +67,8 @@ Mipv6Ha::GetTypeId (void)
 }
 
 Mipv6Ha::Mipv6Ha (bool haflag)  // adding arg for NEMO        
-  : m_bCache (0)
+  : m_bCache (0),
+    m_unprobedBindings (0)
 {
 m_haflag=haflag;
 }
@@ -75,6 +89,7 @@ void Mipv6Ha::NotifyNewAggregate ()
       m_bCache->SetNode (node);
       Ptr<Icmpv6L4Protocol> icmpv6l4 = node->GetObject<Icmpv6L4Protocol> ();
       Ptr<Ipv6L3Protocol> ipv6 = node->GetObject<Ipv6L3Protocol> ();
+      m_bCache->SetLifetimeExpiredCallback (MakeCallback (&Mipv6Ha::BindingLifetimeExpired, this));
       icmpv6l4->SetDADCallback (MakeCallback (&Mipv6Ha::DADFailureIndication, this));
       icmpv6l4->SetNSCallback (MakeCallback (&Mipv6Ha::IsAddress, this));
       icmpv6l4->SetHandleNSCallback (MakeCallback (&Mipv6Ha::HandleNS, this));
@@ -84,6 +99,46 @@ void Mipv6Ha::NotifyNewAggregate ()
   Mipv6Agent::NotifyNewAggregate ();
 }
 
+void Mipv6Ha::DoInitialize ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (IsTimingWheelEnabled () && m_bCache)
+    {
+      m_bCache->SetTimingWheel (TimingWheel::GetTimingWheel (GetNode ()));
+    }
+  //the tunnels to the CoAs are set up when their BUs are received
+  if (!IsSegmentRoutingEnabled ())
+    {
+      GetNode ()->GetObject<Ipv6TunnelL4Protocol> ()->CreateTunnelDevice ();
+    }
+  Mipv6Agent::DoInitialize ();
+}
+
+void Mipv6Ha::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_probeEvent.Cancel ();
+  m_dadEvent.Cancel ();
+  m_pendingBindings.clear ();
+  m_unprobedBindings = 0;
+  m_baTemplates.clear ();
+  m_advertisers.clear ();
+  Mipv6Agent::DoDispose ();
+}
+
+void Mipv6Ha::BindingLifetimeExpired (BCache::Entry *bce)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa ());
+
+  m_baTemplates.erase (bce->GetHoa ());
+  ClearTunnelAndRouting (bce);
+  ClearPreRegistration (bce, bce->GetAlternateCoa ());
+  WithdrawPrefixes (bce);
+  m_bCache->Remove (bce);
+}
+
 void Mipv6Ha::DADFailureIndication (Ipv6Address addr)
 {
   BCache::Entry *bce = m_bCache->Lookup (addr);
@@ -108,9 +163,22 @@ bool Mipv6Ha::IsAddress2 (Ipv6Address addr)
   return m_bCache->LookupSHoa (addr);
 }
 
-Ptr<Packet> Mipv6Ha::BuildBA (Ipv6MobilityBindingUpdateHeader bu,Ipv6Address hoa, uint8_t status)
+Ptr<Packet> Mipv6Ha::BuildBA (const Mipv6MessageView &bu, Ipv6Address hoa, uint8_t status)
 {
-  NS_LOG_FUNCTION (this << status << "BUILD BACK");
+  return BuildBA (bu.GetSequence (), m_haflag && bu.GetFlagR (), hoa, status);
+}
+
+Ptr<Packet> Mipv6Ha::BuildBA (uint16_t sequence, bool flagR, Ipv6Address hoa, uint8_t status)
+{
+  NS_LOG_FUNCTION (this << sequence << status << "BUILD BACK");
+
+  //only the BAs of accepted bindings are kept, a rejected HoA leaves nothing behind
+  bool accepted = status < Mipv6Header::BA_STATUS_REASON_UNSPECIFIED;
+  BATemplates::iterator it = accepted ? m_baTemplates.find (hoa) : m_baTemplates.end ();
+  if (it != m_baTemplates.end () && it->second.status == status && it->second.flagR == flagR)
+    {
+      return it->second.message.Build (sequence, (uint16_t)Mipv6L4Protocol::MAX_BINDING_LIFETIME);
+    }
 
   Ptr<Packet> p = Create<Packet> ();
 
@@ -119,10 +187,10 @@ Ptr<Packet> Mipv6Ha::BuildBA (Ipv6MobilityBindingUpdateHeader bu,Ipv6Address hoa
 
   type2extn.SetReserved (0);
   type2extn.SetHomeAddress (hoa);
-  ba.SetSequence (bu.GetSequence ());
+  ba.SetSequence (sequence);
   ba.SetFlagK (true);
 
-   if(m_haflag==true && bu.GetFlagR ()==true)            // adding Flag-R field to BA message for NEMO
+   if(flagR)            // adding Flag-R field to BA message for NEMO
         ba.SetFlagR (true);
 
   ba.SetStatus (status);
@@ -130,6 +198,13 @@ Ptr<Packet> Mipv6Ha::BuildBA (Ipv6MobilityBindingUpdateHeader bu,Ipv6Address hoa
   p->AddHeader (type2extn);
   p->AddHeader (ba);
 
+  if (accepted)
+    {
+      BATemplate &tmpl = m_baTemplates[hoa];
+      tmpl.message.Set (p);
+      tmpl.status = status;
+      tmpl.flagR = flagR;
+    }
   return p;
 }
 
@@ -137,23 +212,10 @@ Ptr<Packet> Mipv6Ha::BuildBA (Ipv6MobilityBindingUpdateHeader bu,Ipv6Address hoa
 
 bool Mipv6Ha::CheckInvalidPrefix(Ipv6Address mnp)  //NEMO
 {
-std::list<Ipv6Address> haalist=m_bCache->GetHomePrefixes ();
-
-std::list<Ipv6Address> ::iterator it;  //NEMO
-
-for(it=haalist.begin();it!=haalist.end();it++)
-{
-        if(*it == mnp)
-           {
-                return true;
-           }
+  return m_bCache->IsHomePrefix (mnp);
 }
 
-return false;
-
-}
-
-uint8_t Mipv6Ha::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Ha::HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << packet << src << dst << interface);
   uint32_t r = interface->GetNAddresses ();
@@ -163,52 +225,31 @@ uint8_t Mipv6Ha::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
       NS_LOG_FUNCTION ("Interface" << s << addr);
     }
 
-  Ptr<Packet> p = packet->Copy ();
-  m_rxbuTrace (p, src, dst, interface);
-
-  std::cout<<"Packet Size Init :" << p->GetSize()<< std::endl; //add
-
-  Ipv6MobilityBindingUpdateHeader bu;
-  p->RemoveHeader (bu);
-
-  std::cout<<"Packet Size after bu remove :" << p->GetSize()<< std::endl;//add
+  m_rxbuTrace (packet, src, dst, interface);
 
-  Ipv6ExtensionDestinationHeader dest;
-  p->RemoveHeader (dest);
-
-  std::cout<<"Packet Size after bu & dest remove :" << p->GetSize()<< std::endl;//add  
-
-  Buffer buf;
-
-  Buffer::Iterator start;
-  buf = dest.GetOptionBuffer ();
-  start = buf.Begin ();
-  Ipv6HomeAddressOptionHeader homopt;
-  homopt.Deserialize (start);
   Ipv6Address homeaddr;
-  homeaddr = homopt.GetHomeAddress ();
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("BU without home address option, ignored");
+      return 0;
+    }
+
+  Ipv6Address alternate = GetAlternateCoa (view.GetOptions ());
+  if (!alternate.IsAny () && alternate != src && src != homeaddr)
+    {
+      return HandlePreRegistration (view, homeaddr, src, dst, alternate);
+    }
 
   
 
   Ptr<Mipv6Demux> ipv6MobilityDemux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (ipv6MobilityDemux);
 
-  
-  Ptr<Mipv6OptionDemux> ipv6MobilityOptDemux = GetNode ()->GetObject<Mipv6OptionDemux> ();
-  NS_ASSERT (ipv6MobilityOptDemux);
-
-   Ipv6MobilityOptionMobileNetworkPrefixHeader mnph; //NEMO
-           Buffer buf2=bu.GetOptionBuffer ();
-           Buffer::Iterator start2; 
-           start2 = buf2.Begin ();
-           mnph.Deserialize (start2);
-
-  Ptr<Mipv6Option> ipv6MobilityOpt = ipv6MobilityOptDemux->GetOption (mnph.GetType ());
-  NS_ASSERT (ipv6MobilityOpt);
 
+  //the MNP option is only parsed for a mobile router, a host BU may carry no option
   NS_LOG_FUNCTION("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
 
-  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (bu.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
 
@@ -222,47 +263,54 @@ uint8_t Mipv6Ha::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
   bce2->SetState (BCache::Entry::PREFERRED);
   bce2->SetHA (dst);
   bce2->SetSolicitedHoA (Ipv6Address::MakeSolicitedAddress (homeaddr));
-  bce2->SetLastBindingUpdateSequence (bu.GetSequence ());
-  bce2->SetLastBindingUpdateTime (Time (bu.GetLifetime ()));
+  bce2->SetLastBindingUpdateSequence (view.GetSequence ());
+  bce2->SetLastBindingUpdateTime (Time (view.GetLifetime ()));
   
   
   
-  if(m_haflag==true && bu.GetFlagR ()==true)    // if condition for NEMO
+  //a multihomed MN registers all its CoAs at once, its flows are spread over them
+  BCache::Entry::CareOfList coas = GetCareOfAddresses (view.GetOptions (), src);
+  for (BCache::Entry::CareOfList::const_iterator it = coas.begin (); it != coas.end (); it++)
+    {
+      bce2->AddCareOfAddress (it->first, it->second);
+    }
+
+  if(m_haflag==true && view.GetFlagR ()==true)    // if condition for NEMO
   {
 
-  bce2->SetFlagR (bu.GetFlagR ());  // adding R Flag to BCache Entry
+  bce2->SetFlagR (view.GetFlagR ());  // adding R Flag to BCache Entry
   }
 
 
-   if(bu.GetFlagR ()==true)   //NEMO
+   if(view.GetFlagR ()==true)   //NEMO
         {
                 if(m_haflag == false)
                   errStatus = Mipv6Header::BA_STATUS_MOBILE_ROUTER_OPERATION_NOT_PERMITTED;
                 else
                  {
-                        if(bu.GetFlagH() == false)
+                        if(view.GetFlagH() == false)
                            {
                               errStatus = Mipv6Header::BA_STATUS_MOBILE_ROUTER_OPERATION_NOT_PERMITTED;
                            }
                         else
                            {
-                             Ipv6MobilityOptionMobileNetworkPrefixHeader mnph; //NEMO
-                              Buffer buf2=bu.GetOptionBuffer ();
-                              Buffer::Iterator start2; 
-                              start2 = buf2.Begin ();
-                              mnph.Deserialize (start2);
-                              
-                              Ipv6Address mnp=mnph.GetMobileNetworkPrefix ();
-                              
-                              if(CheckInvalidPrefix(mnp)==true)
-                                errStatus = Mipv6Header::BA_STATUS_INVALID_PREFIX;
-                              else
-                                {
-                                bce2->SetMobileNetworkPrefix (mnp);
-                                errStatus = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
-                                
-                                
-                                }
+                             //an MR may register several prefixes, one option each
+                             BCache::Entry::PrefixList mnps = GetMobileNetworkPrefixes (view.GetOptions ());
+                             errStatus = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
+                             for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+                               {
+                                 if (CheckInvalidPrefix (it->first))
+                                   {
+                                     errStatus = Mipv6Header::BA_STATUS_INVALID_PREFIX;
+                                   }
+                               }
+                             if (errStatus == Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED)
+                               {
+                                 for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+                                   {
+                                     bce2->AddMobileNetworkPrefix (it->first, it->second);
+                                   }
+                               }
 
                            }
 
@@ -274,43 +322,27 @@ uint8_t Mipv6Ha::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
           errStatus = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
         }
 
-  // adding HA prefix advertisement in NEMO
-if(bu.GetFlagR ()==true)
-{
-  Ptr<NetDevice> dev =interface->GetDevice();
-  Ptr<Ipv6> ipv6 = GetObject<Ipv6> ();   
-  uint32_t ifindex = ipv6->GetInterfaceForDevice (dev);  
-
-  Ptr<Radvd> radvd=CreateObject<Radvd> (); 
-  Ptr<RadvdInterface> HaInterface= Create<RadvdInterface> (ifindex, 1500, 50);
-  Ptr<RadvdPrefix> routerPrefix = Create<RadvdPrefix> (bce2->GetMobileNetworkPrefix (), 64, 1.5, 2.0);
-  HaInterface->AddPrefix(routerPrefix);
-  radvd->AddConfiguration (HaInterface);
-  GetNode ()->AddApplication (radvd);
-
-  radvd->SetStartTime (Seconds (1.0));
-  radvd->SetStopTime (Seconds (100.0));
-
-}
-
   bce2->MarkReachable ();
 
   Ptr<Packet> ba;
-  ba = BuildBA (bu, homeaddr, errStatus);
+  ba = BuildBA (view, homeaddr, errStatus);
 
   bce = m_bCache->Lookup (homeaddr);
 
-  if (src.IsMatchingType (homeaddr))
+  if (src == homeaddr)
     {
       if (bce)
         {
           ClearTunnelAndRouting (bce);
+          ClearPreRegistration (bce, bce->GetAlternateCoa ());
+          WithdrawPrefixes (bce);
           m_bCache->Remove (bce);
         }
-      free (bce2);
-      if (bu.GetFlagA ())
+      m_baTemplates.erase (homeaddr);
+      delete bce2;
+      if (view.GetFlagA ())
         {
-          SendMessage (ba, src, 64);
+          SendMessage (ba, dst, src, 64);
         }
       return 0;
     }
@@ -318,19 +350,33 @@ if(bu.GetFlagR ()==true)
 
   if (bce)
     {
+      //the pre-registered tunnel or SID is released after the switch, so that it is not rebuilt
+      Ipv6Address alternate = bce->GetAlternateCoa ();
+      bool refresh = bce->GetCoa () == src;
       ClearTunnelAndRouting (bce);
+      WithdrawPrefixes (bce);
       m_bCache->Remove (bce);
 
 
 
 
       m_bCache->Add (bce2);
+      bce2->StartLifetimeTimer (Seconds (view.GetLifetime () * 4.0));
+      AdvertisePrefixes (bce2, interface);
 
-      if (bu.GetFlagA ())
+      if (view.GetFlagA ())
         {
-          SendMessage (ba, src, 64);
+          SendMessage (ba, dst, src, 64);
           SetupTunnelAndRouting (bce2);
         }
+      if (refresh)
+        {
+          bce2->SetAlternateCoa (alternate);
+        }
+      else
+        {
+          ClearPreRegistration (bce2, alternate);
+        }
 
       return 0;
 
@@ -339,17 +385,155 @@ if(bu.GetFlagR ()==true)
 
   else
     {
-      if (bu.GetFlagA ())
+      if (view.GetFlagA ())
         {
           m_bCache->Add (bce2);
-          Simulator::Schedule (Seconds (0.), &Mipv6Ha::DoDADForOffLinkAddress, this, homeaddr, interface);
-          Simulator::Schedule (Seconds (1.), &Mipv6Ha::FunctionDadTimeoutForOffLinkAddress, this, interface, ba, homeaddr);
+          bce2->StartLifetimeTimer (Seconds (view.GetLifetime () * 4.0));
+          AdvertisePrefixes (bce2, interface);
+          QueueBinding (bce2, interface, ba);
         }
       return 0;
     }
 
 }
 
+uint8_t Mipv6Ha::HandlePreRegistration (const Mipv6MessageView &bu, Ipv6Address hoa, Ipv6Address src, Ipv6Address dst, Ipv6Address alternate)
+{
+  NS_LOG_FUNCTION (this << hoa << src << alternate);
+
+  //only a bound MN can pre-register, from the CoA of its binding
+  BCache::Entry *bce = m_bCache->Lookup (hoa);
+  uint8_t status = Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED;
+  if (!bce || bce->GetCoa () != src)
+    {
+      status = Mipv6Header::BA_STATUS_INVALID_COA;
+    }
+  else if (bce->GetAlternateCoa () != alternate)
+    {
+      ClearPreRegistration (bce, bce->GetAlternateCoa ());
+      bce->SetAlternateCoa (alternate);
+      SetupPreRegistration (bce);
+    }
+
+  if (bu.GetFlagA ())
+    {
+      SendMessage (BuildBA (bu, hoa, status), dst, src, 64);
+    }
+  return 0;
+}
+
+void Mipv6Ha::SetupPreRegistration (BCache::Entry *bce)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa () << bce->GetAlternateCoa ());
+
+  Ptr<Ipv6SrRouting> sr = IsSegmentRoutingEnabled () ? Ipv6SrRouting::GetSrRouting (GetNode ()) : 0;
+  if (sr)
+    {
+      //the policy moves to the new End SID with the BU from the new CoA
+      sr->AddSid (Segment (bce->GetAlternateCoa ()));
+      return;
+    }
+
+  //the tunnel to the new CoA also accepts the traffic of the MN before the switch
+  Ptr<Ipv6TunnelL4Protocol> th = GetNode ()->GetObject<Ipv6TunnelL4Protocol> ();
+  NS_ASSERT (th);
+
+  th->AddTunnel (bce->GetAlternateCoa (), bce->GetHA ());
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (bce->GetAlternateCoa ());
+  tunnel->AddBicast (bce->GetHoa (), Ipv6Prefix (128), bce->GetAlternateCoa ());
+  const BCache::Entry::PrefixList &mnps = bce->GetMobileNetworkPrefixes ();
+  for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+    {
+      if (!it->first.IsAny ())
+        {
+          tunnel->AddBicast (it->first, Ipv6Prefix (it->second), bce->GetAlternateCoa ());
+        }
+    }
+}
+
+void Mipv6Ha::ClearPreRegistration (BCache::Entry *bce, Ipv6Address alternate)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa () << alternate);
+
+  if (alternate.IsAny ())
+    {
+      return;
+    }
+  bce->SetAlternateCoa (Ipv6Address::GetAny ());
+
+  Ptr<Ipv6SrRouting> sr = IsSegmentRoutingEnabled () ? Ipv6SrRouting::GetSrRouting (GetNode ()) : 0;
+  if (sr)
+    {
+      sr->RemoveSid (Segment (alternate));
+      return;
+    }
+
+  Ptr<Ipv6TunnelL4Protocol> th = GetNode ()->GetObject<Ipv6TunnelL4Protocol> ();
+  NS_ASSERT (th);
+
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (alternate);
+  if (tunnel)
+    {
+      tunnel->RemoveBicast (bce->GetHoa (), Ipv6Prefix (128));
+      const BCache::Entry::PrefixList &mnps = bce->GetMobileNetworkPrefixes ();
+      for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+        {
+          if (!it->first.IsAny ())
+            {
+              tunnel->RemoveBicast (it->first, Ipv6Prefix (it->second));
+            }
+        }
+    }
+  th->RemoveTunnel (alternate);
+}
+
+Ipv6Address Mipv6Ha::GetAlternateCoa (Mipv6OptionIterator options)
+{
+  Ipv6MobilityOptionAlternateCareofAddressHeader acoa;
+  if (options.Find (Mipv6Header::IPV6_MOBILITY_OPT_ALTERNATE_CARE_OF_ADDRESS, acoa))
+    {
+      return acoa.GetAlternateCareofAddress ();
+    }
+  return Ipv6Address::GetAny ();
+}
+
+BCache::Entry::PrefixList Mipv6Ha::GetMobileNetworkPrefixes (Mipv6OptionIterator options)
+{
+  BCache::Entry::PrefixList mnps;
+  Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
+  while (options.Find (Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX, mnph))
+    {
+      mnps.push_back (BCache::Entry::Prefix (mnph.GetMobileNetworkPrefix (), std::min<uint8_t> (mnph.GetPrefixLength (), 128)));
+    }
+  return mnps;
+}
+
+BCache::Entry::CareOfList Mipv6Ha::GetCareOfAddresses (Mipv6OptionIterator options, Ipv6Address src)
+{
+  BCache::Entry::CareOfList coas;
+  Ipv6MobilityOptionBindingIdentifierHeader bid;
+  while (options.Find (Mipv6Header::IPV6_MOBILITY_OPT_BINDING_IDENTIFIER, bid))
+    {
+      Ipv6Address coa = bid.GetCareofAddress ().IsAny () ? src : bid.GetCareofAddress ();
+      BCache::Entry::CareOfList::iterator it;
+      for (it = coas.begin (); it != coas.end () && it->first != coa; it++)
+        {
+        }
+      if (it == coas.end ())
+        {
+          coas.push_back (BCache::Entry::CareOf (coa, bid.GetPriority ()));
+        }
+    }
+  return coas;
+}
+
+void Mipv6Ha::ReserveBindings (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  NS_ASSERT_MSG (m_bCache, "binding cache not created, aggregate the HA first");
+  m_bCache->Reserve (n);
+}
+
 std::list<Ipv6Address> Mipv6Ha::HomeAgentAddressList ()
 {
   NS_LOG_FUNCTION (this);
@@ -377,25 +561,135 @@ std::list<Ipv6Address> Mipv6Ha::HomeAgentAddressList ()
 
 bool Mipv6Ha::SetupTunnelAndRouting (BCache::Entry *bce)
 {
-  NS_LOG_FUNCTION (this << bce);
+  return SetupTunnelAndRouting (std::vector<BCache::Entry *> (1, bce));
+}
+
+bool Mipv6Ha::SetupTunnelAndRouting (const std::vector<BCache::Entry *> &bces)
+{
+  NS_LOG_FUNCTION (this << bces.size ());
+
+  if (bces.empty ())
+    {
+      return true;
+    }
+
+  Ptr<Ipv6SrRouting> sr = IsSegmentRoutingEnabled () ? Ipv6SrRouting::GetSrRouting (GetNode ()) : 0;
+  if (sr)
+    {
+      //steer HoA and MNP traffic to the CoA, which acts as End SID
+      for (std::vector<BCache::Entry *>::const_iterator bce = bces.begin (); bce != bces.end (); bce++)
+        {
+          std::vector<Segment> segments (1, Segment ((*bce)->GetCoa ()));
+          sr->AddSid (Segment ((*bce)->GetCoa ()));
+          sr->AddPolicy ((*bce)->GetHoa (), Ipv6Prefix (128), segments);
+          const BCache::Entry::PrefixList &mnps = (*bce)->GetMobileNetworkPrefixes ();
+          for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+            {
+              if (!it->first.IsAny ())
+                {
+                  sr->AddPolicy (it->first, Ipv6Prefix (it->second), segments);
+                }
+            }
+
+          //a multihomed MN has one SID list per CoA, the flows are hashed on them
+          const BCache::Entry::CareOfList &coas = (*bce)->GetCareOfAddresses ();
+          for (BCache::Entry::CareOfList::const_iterator coa = coas.begin (); coa != coas.end (); coa++)
+            {
+              if (coa->second == 0)
+                {
+                  continue;
+                }
+              std::vector<Segment> path (1, Segment (coa->first));
+              if (coa->first != (*bce)->GetCoa ())
+                {
+                  sr->AddSid (Segment (coa->first));
+                }
+              sr->AddPolicyPath ((*bce)->GetHoa (), Ipv6Prefix (128), path, coa->second);
+              for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+                {
+                  if (!it->first.IsAny ())
+                    {
+                      sr->AddPolicyPath (it->first, Ipv6Prefix (it->second), path, coa->second);
+                    }
+                }
+            }
+        }
+      return true;
+    }
 
   //create tunnel
   Ptr<Ipv6TunnelL4Protocol> th = GetNode ()->GetObject<Ipv6TunnelL4Protocol> ();
   NS_ASSERT (th);
 
-  uint16_t tunnelIf = th->AddTunnel (bce->GetCoa ());
-
-  bce->SetTunnelIfIndex (tunnelIf);
-
-  //routing setup by static routing protocol
+  //routing setup by the SR routing tries when the node has a list routing, else by static routing
   Ipv6StaticRoutingHelper staticRoutingHelper;
   Ptr<Ipv6> ipv6 = GetNode ()->GetObject<Ipv6> ();
 
   Ptr<Ipv6StaticRouting> staticRouting = staticRoutingHelper.GetStaticRouting (ipv6);
+  sr = Ipv6SrRouting::GetSrRouting (GetNode ());
+
+  int16_t tunnelIf = -1;
+  for (std::vector<BCache::Entry *>::const_iterator bce = bces.begin (); bce != bces.end (); bce++)
+    {
+      //the MN accepts the tunnelled packets from its HA address only
+      tunnelIf = th->AddTunnel ((*bce)->GetCoa (), (*bce)->GetHA ());
+
+      (*bce)->SetTunnelIfIndex (tunnelIf);
+
+      //the tunnel interface is shared by the bindings, map HoA and MNP to the CoA
+      Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice ((*bce)->GetCoa ());
+      tunnel->AddDestination ((*bce)->GetHoa (), Ipv6Prefix (128), (*bce)->GetCoa ());
+      if (sr)
+        {
+          sr->AddRoute ((*bce)->GetHoa (), Ipv6Prefix (128), tunnelIf);
+        }
+      else
+        {
+          staticRouting->AddHostRouteTo ((*bce)->GetHoa (), tunnelIf, 10);
+        }
+
+      const BCache::Entry::PrefixList &mnps = (*bce)->GetMobileNetworkPrefixes ();
+      for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+        {
+          if (it->first.IsAny ())
+            {
+              continue;
+            }
+          tunnel->AddDestination (it->first, Ipv6Prefix (it->second), (*bce)->GetCoa ());
+          if (sr)
+            {
+              sr->AddRoute (it->first, Ipv6Prefix (it->second), tunnelIf);
+            }
+          else
+            {
+              staticRouting->AddNetworkRouteTo (it->first, Ipv6Prefix (it->second), tunnelIf, 10);
+            }
+        }
 
-  staticRouting->AddHostRouteTo (bce->GetHoa (), bce->GetTunnelIfIndex (),10);
-  staticRouting->AddNetworkRouteTo (Ipv6Address ("7777:db80::"),Ipv6Prefix (64),bce->GetTunnelIfIndex (),10);
-  staticRouting->RemoveRoute ("fe80::", Ipv6Prefix (64), bce->GetTunnelIfIndex (), "fe80::");
+      //a multihomed MN has one tunnel per CoA, the flows are hashed on them
+      const BCache::Entry::CareOfList &coas = (*bce)->GetCareOfAddresses ();
+      for (BCache::Entry::CareOfList::const_iterator coa = coas.begin (); coa != coas.end (); coa++)
+        {
+          if (coa->second == 0)
+            {
+              continue;
+            }
+          if (coa->first != (*bce)->GetCoa ())
+            {
+              th->AddTunnel (coa->first, (*bce)->GetHA ());
+            }
+          tunnel->AddPath ((*bce)->GetHoa (), Ipv6Prefix (128), coa->first, coa->second);
+          for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+            {
+              if (!it->first.IsAny ())
+                {
+                  tunnel->AddPath (it->first, Ipv6Prefix (it->second), coa->first, coa->second);
+                }
+            }
+        }
+    }
+  //the interface is shared, its link-local route is removed once for the batch
+  staticRouting->RemoveRoute ("fe80::", Ipv6Prefix (64), tunnelIf, "fe80::");
 
   return true;
 }
@@ -405,25 +699,240 @@ bool Mipv6Ha::ClearTunnelAndRouting (BCache::Entry *bce)
 {
   NS_LOG_FUNCTION (this << bce);
 
-  //routing setup by static routing protocol
-  Ipv6StaticRoutingHelper staticRoutingHelper;
-  Ptr<Ipv6> ipv6 = GetNode ()->GetObject<Ipv6> ();
+  const BCache::Entry::PrefixList &mnps = bce->GetMobileNetworkPrefixes ();
+  BCache::Entry::PrefixList::const_iterator it;
+  const BCache::Entry::CareOfList &coas = bce->GetCareOfAddresses ();
+  BCache::Entry::CareOfList::const_iterator coa;
 
+  Ptr<Ipv6SrRouting> sr = IsSegmentRoutingEnabled () ? Ipv6SrRouting::GetSrRouting (GetNode ()) : 0;
+  if (sr)
+    {
+      //also removes the SID lists of a multihomed MN
+      sr->RemovePolicy (bce->GetHoa (), Ipv6Prefix (128));
+      for (it = mnps.begin (); it != mnps.end (); it++)
+        {
+          if (!it->first.IsAny ())
+            {
+              sr->RemovePolicy (it->first, Ipv6Prefix (it->second));
+            }
+        }
+      sr->RemoveSid (Segment (bce->GetCoa ()));
+      for (coa = coas.begin (); coa != coas.end (); coa++)
+        {
+          if (coa->second != 0 && coa->first != bce->GetCoa ())
+            {
+              sr->RemoveSid (Segment (coa->first));
+            }
+        }
+      return true;
+    }
 
-  Ptr<Ipv6StaticRouting> staticRouting = staticRoutingHelper.GetStaticRouting (ipv6);
+  sr = Ipv6SrRouting::GetSrRouting (GetNode ());
+  if (sr)
+    {
+      sr->RemoveRoute (bce->GetHoa (), Ipv6Prefix (128));
+      for (it = mnps.begin (); it != mnps.end (); it++)
+        {
+          if (!it->first.IsAny ())
+            {
+              sr->RemoveRoute (it->first, Ipv6Prefix (it->second));
+            }
+        }
+    }
+  else
+    {
+      //routing setup by static routing protocol
+      Ipv6StaticRoutingHelper staticRoutingHelper;
+      Ptr<Ipv6> ipv6 = GetNode ()->GetObject<Ipv6> ();
 
-  staticRouting->RemoveRoute (bce->GetHoa (), Ipv6Prefix (64), bce->GetTunnelIfIndex (), bce->GetHoa ());
+      Ptr<Ipv6StaticRouting> staticRouting = staticRoutingHelper.GetStaticRouting (ipv6);
 
-  //create tunnel
+      //the routes added without a next hop use their destination as prefix to use
+      staticRouting->RemoveRoute (bce->GetHoa (), Ipv6Prefix (128), bce->GetTunnelIfIndex (), bce->GetHoa ());
+      for (it = mnps.begin (); it != mnps.end (); it++)
+        {
+          if (!it->first.IsAny ())
+            {
+              staticRouting->RemoveRoute (it->first, Ipv6Prefix (it->second), bce->GetTunnelIfIndex (), it->first);
+            }
+        }
+    }
+
+  //release the tunnel, its last reference drops the HoA and MNP destinations
   Ptr<Ipv6TunnelL4Protocol> th = GetNode ()->GetObject<Ipv6TunnelL4Protocol> ();
   NS_ASSERT (th);
 
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (bce->GetCoa ());
+  if (tunnel)
+    {
+      tunnel->RemoveDestination (bce->GetHoa (), Ipv6Prefix (128));
+      tunnel->RemovePaths (bce->GetHoa (), Ipv6Prefix (128));
+      for (it = mnps.begin (); it != mnps.end (); it++)
+        {
+          if (!it->first.IsAny ())
+            {
+              tunnel->RemoveDestination (it->first, Ipv6Prefix (it->second));
+              tunnel->RemovePaths (it->first, Ipv6Prefix (it->second));
+            }
+        }
+    }
+  for (coa = coas.begin (); coa != coas.end (); coa++)
+    {
+      if (coa->second != 0 && coa->first != bce->GetCoa ())
+        {
+          th->RemoveTunnel (coa->first);
+        }
+    }
   th->RemoveTunnel (bce->GetCoa ());
 
   bce->SetTunnelIfIndex (-1);
   return true;
 }
 
+void Mipv6Ha::AdvertisePrefixes (BCache::Entry *bce, Ptr<Ipv6Interface> interface)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa ());
+
+  const BCache::Entry::PrefixList &mnps = bce->GetMobileNetworkPrefixes ();
+  if (mnps.empty ())
+    {
+      return;
+    }
+
+  Ptr<Ipv6> ipv6 = GetObject<Ipv6> ();
+  uint32_t ifindex = ipv6->GetInterfaceForDevice (interface->GetDevice ());
+  PrefixAdvertiser &advertiser = m_advertisers[ifindex];
+  if (!advertiser.config)
+    {
+      //the prefixes are read at each advertisement, they are added to the running Radvd
+      advertiser.config = Create<RadvdInterface> (ifindex, 1500, 50);
+      Ptr<Radvd> radvd = CreateObject<Radvd> ();
+      radvd->AddConfiguration (advertiser.config);
+      GetNode ()->AddApplication (radvd);
+    }
+
+  for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+    {
+      Ptr<RadvdPrefix> &prefix = advertiser.prefixes[it->first];
+      if (!prefix)
+        {
+          prefix = Create<RadvdPrefix> (it->first, it->second, g_mnpPreferredLifetime, g_mnpValidLifetime);
+          advertiser.config->AddPrefix (prefix);
+        }
+      prefix->SetPreferredLifeTime (g_mnpPreferredLifetime);
+      prefix->SetValidLifeTime (g_mnpValidLifetime);
+    }
+}
+
+void Mipv6Ha::WithdrawPrefixes (BCache::Entry *bce)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa ());
+
+  const BCache::Entry::PrefixList &mnps = bce->GetMobileNetworkPrefixes ();
+  for (BCache::Entry::PrefixList::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+    {
+      for (std::map<uint32_t, PrefixAdvertiser>::iterator adv = m_advertisers.begin (); adv != m_advertisers.end (); adv++)
+        {
+          std::map<Ipv6Address, Ptr<RadvdPrefix> >::iterator prefix = adv->second.prefixes.find (it->first);
+          if (prefix != adv->second.prefixes.end ())
+            {
+              prefix->second->SetPreferredLifeTime (0);
+              prefix->second->SetValidLifeTime (0);
+            }
+        }
+    }
+}
+
+uint32_t Mipv6Ha::GetNPendingBindings () const
+{
+  return m_pendingBindings.size ();
+}
+
+uint32_t Mipv6Ha::GetNBATemplates () const
+{
+  return m_baTemplates.size ();
+}
+
+void Mipv6Ha::QueueBinding (BCache::Entry *bce, Ptr<Ipv6Interface> interface, Ptr<Packet> ba)
+{
+  NS_LOG_FUNCTION (this << bce->GetHoa ());
+
+  //the DADs are as long as each other, the queue is sorted by end of DAD
+  PendingBinding pending;
+  pending.bce = bce;
+  pending.hoa = bce->GetHoa ();
+  pending.sequence = bce->GetLastBindingUpdateSequence ();
+  pending.interface = interface;
+  pending.ba = ba;
+  pending.deadline = Simulator::Now () + m_dadTimeout;
+  m_pendingBindings.push_back (pending);
+  m_unprobedBindings++;
+
+  if (!m_probeEvent.IsRunning ())
+    {
+      m_probeEvent = Simulator::ScheduleNow (&Mipv6Ha::SendDadProbes, this);
+    }
+  if (!m_dadEvent.IsRunning ())
+    {
+      m_dadEvent = Simulator::Schedule (m_dadTimeout, &Mipv6Ha::CompleteBindings, this);
+    }
+}
+
+void Mipv6Ha::SendDadProbes ()
+{
+  NS_LOG_FUNCTION (this << m_unprobedBindings);
+
+  std::deque<PendingBinding>::iterator it = m_pendingBindings.end () - m_unprobedBindings;
+  for (; it != m_pendingBindings.end (); it++)
+    {
+      DoDADForOffLinkAddress (it->hoa, it->interface);
+    }
+  m_unprobedBindings = 0;
+}
+
+void Mipv6Ha::CompleteBindings ()
+{
+  NS_LOG_FUNCTION (this << m_pendingBindings.size ());
+
+  std::vector<BCache::Entry *> done;
+  while (!m_pendingBindings.empty () && m_pendingBindings.front ().deadline <= Simulator::Now ())
+    {
+      PendingBinding &pending = m_pendingBindings.front ();
+      //a binding replaced or removed during its DAD was handled by its BU
+      BCache::Entry *bce = m_bCache->Lookup (pending.hoa);
+      if (bce && bce == pending.bce && bce->GetLastBindingUpdateSequence () == pending.sequence)
+        {
+          if (bce->GetState () == BCache::Entry::INVALID)
+            {
+              //the HoA is used on the home link, the binding is refused
+              NS_LOG_LOGIC ("DAD failed for " << pending.hoa);
+              SendMessage (BuildBA (pending.sequence, bce->GetFlagR (), pending.hoa, Mipv6Header::BA_STATUS_DAD_FAILED),
+                           bce->GetHA (), bce->GetCoa (), 64);
+              m_baTemplates.erase (pending.hoa);
+              WithdrawPrefixes (bce);
+              m_bCache->Remove (bce);
+            }
+          else
+            {
+              SendMessage (pending.ba, bce->GetHA (), bce->GetCoa (), 64);
+              done.push_back (bce);
+            }
+        }
+      m_pendingBindings.pop_front ();
+    }
+  if (m_unprobedBindings > m_pendingBindings.size ())
+    {
+      m_unprobedBindings = m_pendingBindings.size ();
+    }
+
+  SetupTunnelAndRouting (done);
+
+  if (!m_pendingBindings.empty ())
+    {
+      m_dadEvent = Simulator::Schedule (m_pendingBindings.front ().deadline - Simulator::Now (), &Mipv6Ha::CompleteBindings, this);
+    }
+}
+
 void Mipv6Ha::DoDADForOffLinkAddress (Ipv6Address target, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << target << interface);
@@ -440,16 +949,7 @@ void Mipv6Ha::DoDADForOffLinkAddress (Ipv6Address target, Ptr<Ipv6Interface> int
 
   /* update last packet UID */
   interface->SetNsDadUid (target, p.first->GetUid ());
-  Simulator::Schedule (Time (0), &Ipv6Interface::Send, interface, p.first, p.second, Ipv6Address::MakeSolicitedAddress (target));
-}
-
-void Mipv6Ha::FunctionDadTimeoutForOffLinkAddress (Ptr<Ipv6Interface> interface, Ptr<Packet> ba, Ipv6Address homeaddr)
-{
-  if (m_bCache->Lookup (homeaddr)->GetState () != BCache::Entry::INVALID)
-    {
-      SendMessage (ba, m_bCache->Lookup (homeaddr)->GetCoa (), 64);
-    }
-  SetupTunnelAndRouting (m_bCache->Lookup (homeaddr));
+  interface->Send (p.first, p.second, Ipv6Address::MakeSolicitedAddress (target));
 }
 
 void Mipv6Ha::HandleNS (Ptr<Packet> packet, Ptr<Ipv6Interface> interface, Ipv6Address src, Ipv6Address target)
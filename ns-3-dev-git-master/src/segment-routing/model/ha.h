@@ -4,9 +4,17 @@
 #include "sr-agent.h"
 #include "bcache.h"
 #include "sr-header.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+#include <deque>
+#include <map>
+#include <vector>
 
 namespace ns3 {
 class Packet;
+class RadvdInterface;
+class RadvdPrefix;
 
 class Mipv6Ha : public Mipv6Agent
 {
@@ -31,6 +39,24 @@ public:
    */
   std::list<Ipv6Address> HomeAgentAddressList ();
 
+  /**
+   * \brief size the binding cache for a number of MNs.
+   * \param n expected number of MNs
+   */
+  void ReserveBindings (uint32_t n);
+
+  /**
+   * \brief get the number of new bindings waiting for the end of their DAD.
+   * \return the number of bindings
+   */
+  uint32_t GetNPendingBindings () const;
+
+  /**
+   * \brief get the number of BAs kept for the accepted bindings.
+   * \return the number of BAs
+   */
+  uint32_t GetNBATemplates () const;
+
   /**
    * \brief perform DAD on behalf of MN for its HoA in home network.
    * \param target target address
@@ -38,14 +64,6 @@ public:
    */
   void DoDADForOffLinkAddress (Ipv6Address target, Ptr<Ipv6Interface> interface);
 
-  /**
-   * \brief performing binding process after DAD completion.
-   * \param interface interface at which BU is received
-   * \param ba formed BA
-   * \param homeaddr home address of the MN
-   */
-  void FunctionDadTimeoutForOffLinkAddress (Ptr<Ipv6Interface> interface, Ptr<Packet> ba, Ipv6Address homeaddr);
-
   /**
    * \brief Indication from the ICMPv6L4Protocol, if any corresponding NA is received and DAD fails.
    * \param addr the target address
@@ -90,23 +108,48 @@ protected:
   virtual void NotifyNewAggregate ();
 
   /**
-   * \brief build BA in response of BU
-   * \param bu the BU packet
+   * \brief Initialize this object, moving the binding lifetimes to the timing wheel if enabled.
+   */
+  virtual void DoInitialize ();
+  virtual void DoDispose ();
+
+  /**
+   * \brief remove a binding whose lifetime expired.
+   * \param bce the binding cache entry
+   */
+  void BindingLifetimeExpired (BCache::Entry *bce);
+
+  /**
+   * \brief build BA in response of BU, patching the previous BA to the same HoA if any.
+   *
+   * The BAs accepting a binding are kept until the binding is removed.
+   * \param bu the BU
+   * \param hoa the home address
+   * \param status the staus of BU reception
+   * \return a ba packet
+   */
+  Ptr<Packet> BuildBA (const Mipv6MessageView &bu, Ipv6Address hoa, uint8_t status);
+
+  /**
+   * \brief build BA for a BU no longer at hand, e.g. at the end of its DAD
+   * \param sequence the sequence number of the BU
+   * \param flagR whether the BA has the R flag (NEMO)
    * \param hoa the home address
    * \param status the staus of BU reception
    * \return a ba packet
    */
-  Ptr<Packet> BuildBA (Ipv6MobilityBindingUpdateHeader bu, Ipv6Address hoa, uint8_t status);
+  Ptr<Packet> BuildBA (uint16_t sequence, bool flagR, Ipv6Address hoa, uint8_t status);
 
   /**
    * \brief handle BU
    * \param packet the BU packet
+   * \param view the mobility header parsed from the packet
    * \param src the source address
    * \param dst the destination address
    * \param interface the interface at which BU is received
    * \return status
    */
-  virtual uint8_t HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief setup tunnel for a bcache entry
@@ -115,6 +158,16 @@ protected:
    */
   bool SetupTunnelAndRouting (BCache::Entry *bce);
 
+  /**
+   * \brief setup the tunnel and the routes of several bcache entries at once.
+   *
+   * The tunnel, the routing protocol and the tunnel interface are looked up
+   * once for all the entries.
+   * \param bces BCache entries
+   * \return status whether tunnels are set up or not
+   */
+  bool SetupTunnelAndRouting (const std::vector<BCache::Entry *> &bces);
+
   /**
    * \brief clear tunnel for a bcache entry
    * \param bce BCache entry
@@ -122,10 +175,111 @@ protected:
    */
   bool ClearTunnelAndRouting (BCache::Entry *bce);
 
+  /**
+   * \brief handle a BU pre-registering the next CoA of a bound MN.
+   *
+   * The BU is sent from the current CoA with the next CoA in an Alternate
+   * CoA option. The binding keeps the current CoA and the HA starts sending
+   * the traffic of the MN to both CoAs, so the MN receives it as soon as it
+   * attaches to the next AR.
+   * \param bu the BU
+   * \param hoa the home address
+   * \param src the current CoA
+   * \param dst the HA address
+   * \param alternate the pre-registered CoA
+   * \return status
+   */
+  uint8_t HandlePreRegistration (const Mipv6MessageView &bu, Ipv6Address hoa, Ipv6Address src, Ipv6Address dst, Ipv6Address alternate);
+
+  /**
+   * \brief start sending the traffic of a binding to its alternate CoA too
+   * \param bce BCache entry
+   */
+  void SetupPreRegistration (BCache::Entry *bce);
+
+  /**
+   * \brief stop sending the traffic of a binding to a pre-registered CoA
+   * \param bce BCache entry
+   * \param alternate the pre-registered CoA
+   */
+  void ClearPreRegistration (BCache::Entry *bce, Ipv6Address alternate);
+
 
   bool CheckInvalidPrefix(Ipv6Address mnp);   //NEMO
 
 private:
+  /**
+   * \brief A new binding waiting for the end of the DAD of its HoA.
+   */
+  struct PendingBinding
+  {
+    BCache::Entry *bce;              //!< the binding, valid while it is bound to hoa
+    Ipv6Address hoa;                 //!< home address of the binding
+    uint16_t sequence;               //!< sequence number of the BU
+    Ptr<Ipv6Interface> interface;    //!< interface the BU was received on
+    Ptr<Packet> ba;                  //!< the BA sent when the DAD ends
+    Time deadline;                   //!< end of the DAD
+  };
+
+  /**
+   * \brief queue a new binding, its DAD probe and BA are sent with the other
+   * bindings received at the same time.
+   * \param bce the binding
+   * \param interface interface the BU was received on
+   * \param ba the BA
+   */
+  void QueueBinding (BCache::Entry *bce, Ptr<Ipv6Interface> interface, Ptr<Packet> ba);
+
+  /**
+   * \brief send the DAD probes of the bindings queued since the last call.
+   */
+  void SendDadProbes ();
+
+  /**
+   * \brief acknowledge the bindings whose DAD ended and install their routes
+   * together, then wait for the next DAD to end. The bindings whose DAD
+   * failed are refused and removed.
+   */
+  void CompleteBindings ();
+
+  /**
+   * \brief advertise the MNPs of a binding on the interface its BU was received on (NEMO).
+   *
+   * All the MNPs of an interface are advertised by a single Radvd, created
+   * with the first binding.
+   * \param bce the binding
+   * \param interface the interface
+   */
+  void AdvertisePrefixes (BCache::Entry *bce, Ptr<Ipv6Interface> interface);
+
+  /**
+   * \brief advertise the MNPs of a removed binding with a zero lifetime (NEMO).
+   * \param bce the binding
+   */
+  void WithdrawPrefixes (BCache::Entry *bce);
+
+  /**
+   * \brief get the Mobile Network Prefix options of a BU.
+   * \param options the options of the BU
+   * \return the prefixes with their lengths, in the order of the options
+   */
+  static BCache::Entry::PrefixList GetMobileNetworkPrefixes (Mipv6OptionIterator options);
+
+  /**
+   * \brief get the Binding Identifier options of a BU (RFC 5648).
+   * \param options the options of the BU
+   * \param src source of the BU, the CoA of the options without one
+   * \return the CoAs with the priorities of their options as weights
+   */
+  static BCache::Entry::CareOfList GetCareOfAddresses (Mipv6OptionIterator options, Ipv6Address src);
+
+  /**
+   * \brief get the Alternate CoA option of a BU.
+   * \param options the options of the BU
+   * \return the alternate CoA, any if the BU has none
+   */
+  static Ipv6Address GetAlternateCoa (Mipv6OptionIterator options);
+
   /**
    * \brief the binding cache associated with this HA.
    */
@@ -133,6 +287,65 @@ private:
 
   bool m_haflag;   //NEMO
 
+  /**
+   * \brief BA sent last to a home address, refreshed in place.
+   */
+  struct BATemplate
+  {
+    Mipv6MessageTemplate message; //!< the serialized BA
+    uint8_t status;               //!< status of the BA
+    bool flagR;                   //!< R flag of the BA (NEMO)
+  };
+
+  /**
+   * \brief BA templates of the accepted bindings, keyed by home address
+   */
+  typedef sgi::hash_map<Ipv6Address, BATemplate, Ipv6AddressHash> BATemplates;
+
+  /**
+   * \brief the BA templates
+   */
+  BATemplates m_baTemplates;
+
+  /**
+   * \brief prefix advertisement of an interface (NEMO)
+   */
+  struct PrefixAdvertiser
+  {
+    Ptr<RadvdInterface> config;   //!< the configuration of the Radvd of the interface
+    std::map<Ipv6Address, Ptr<RadvdPrefix> > prefixes; //!< the MNPs advertised, withdrawn ones included
+  };
+
+  /**
+   * \brief the prefix advertisements, by interface index
+   */
+  std::map<uint32_t, PrefixAdvertiser> m_advertisers;
+
+  /**
+   * \brief new bindings in DAD, by end of DAD
+   */
+  std::deque<PendingBinding> m_pendingBindings;
+
+  /**
+   * \brief number of bindings at the end of the queue not probed yet
+   */
+  uint32_t m_unprobedBindings;
+
+  /**
+   * \brief time waited for an answer to the DAD probe of a HoA
+   */
+  Time m_dadTimeout;
+
+  /**
+   * \brief event sending the queued DAD probes
+   */
+  EventId m_probeEvent;
+
+  /**
+   * \brief event ending the DAD of the first pending binding
+   */
+  EventId m_dadEvent;
+
   /**
    * \brief Callback to trace RX (reception) bu packets.
    */ 
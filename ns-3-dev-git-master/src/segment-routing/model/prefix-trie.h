@@ -0,0 +1,460 @@
+#ifndef PREFIX_TRIE_H
+#define PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+#include "ns3/assert.h"
+#include "ns3/ipv6-address.h"
+
+namespace ns3 {
+
+/**
+ * \class PrefixTrie
+ * \brief Path-compressed binary trie of IPv6 prefixes, for longest prefix match.
+ *
+ * Each node stores a prefix and the bit length it covers, so a lookup
+ * visits at most one node per distinct prefix length on the path of the
+ * address instead of one per bit. Insert and remove are incremental: they
+ * only split, add or merge the nodes on the path of the prefix.
+ */
+template <typename T>
+class PrefixTrie
+{
+public:
+  /**
+   * \brief an entry of the trie
+   */
+  struct Entry
+  {
+    Ipv6Address prefix; //!< the prefix
+    uint8_t length;     //!< the prefix length
+    T value;            //!< the value
+  };
+
+  /**
+   * \brief constructor.
+   */
+  PrefixTrie ();
+
+  /**
+   * \brief destructor.
+   */
+  ~PrefixTrie ();
+
+  /**
+   * \brief add or replace a prefix.
+   * \param prefix the prefix, bits past the length are ignored
+   * \param length the prefix length
+   * \param value the value
+   * \returns false if the prefix was replaced
+   */
+  bool Insert (Ipv6Address prefix, uint8_t length, const T &value);
+
+  /**
+   * \brief remove a prefix.
+   * \param prefix the prefix
+   * \param length the prefix length
+   * \returns false if the prefix was not in the trie
+   */
+  bool Remove (Ipv6Address prefix, uint8_t length);
+
+  /**
+   * \brief get the value of a prefix.
+   * \param prefix the prefix
+   * \param length the prefix length
+   * \returns the value, 0 if the prefix is not in the trie
+   */
+  T *Find (Ipv6Address prefix, uint8_t length);
+
+  /**
+   * \brief longest prefix match.
+   * \param address the address
+   * \returns the value of the longest prefix containing the address, 0 if none
+   */
+  const T *Lookup (Ipv6Address address) const;
+
+  /**
+   * \brief longest prefix match.
+   * \param address the address
+   * \param length the length of the matching prefix
+   * \returns the value of the longest prefix containing the address, 0 if none
+   */
+  const T *Lookup (Ipv6Address address, uint8_t &length) const;
+
+  /**
+   * \brief get the number of prefixes.
+   * \returns the number of prefixes
+   */
+  uint32_t GetSize () const;
+
+  /**
+   * \brief get the entries, shorter prefixes first along each path.
+   * \returns the entries
+   */
+  std::vector<Entry> GetEntries () const;
+
+  /**
+   * \brief remove all the prefixes.
+   */
+  void Clear ();
+
+private:
+  /**
+   * \brief a node, holding a value or branching
+   */
+  struct Node
+  {
+    uint8_t key[16];   //!< prefix bits, zero past the length
+    uint8_t length;    //!< prefix length
+    bool hasValue;     //!< whether the node holds a prefix
+    T value;           //!< value of the prefix
+    Node *child[2];    //!< children by the bit following the prefix
+  };
+
+  /**
+   * \brief no copy, the trie owns its nodes
+   */
+  PrefixTrie (const PrefixTrie &);
+
+  /**
+   * \brief no copy, the trie owns its nodes
+   * \returns this
+   */
+  PrefixTrie &operator = (const PrefixTrie &);
+
+  /**
+   * \brief create a node.
+   * \param key the prefix bits
+   * \param length the prefix length
+   * \returns the node
+   */
+  static Node *NewNode (const uint8_t key[16], uint8_t length);
+
+  /**
+   * \brief get a bit of a key.
+   * \param key the key
+   * \param bit the bit index, 0 is the most significant
+   * \returns the bit
+   */
+  static uint32_t GetBit (const uint8_t key[16], uint8_t bit);
+
+  /**
+   * \brief length of the common prefix of two keys.
+   * \param a first key
+   * \param b second key
+   * \param max maximum length to compare
+   * \returns the common length, at most max
+   */
+  static uint8_t CommonLength (const uint8_t a[16], const uint8_t b[16], uint8_t max);
+
+  /**
+   * \brief remove a prefix below a link and merge the nodes left without value.
+   * \param link the link to the subtree
+   * \param key the prefix bits
+   * \param length the prefix length
+   * \returns false if the prefix was not in the subtree
+   */
+  bool Remove (Node **link, const uint8_t key[16], uint8_t length);
+
+  /**
+   * \brief delete a subtree.
+   * \param node the root of the subtree
+   */
+  static void Delete (Node *node);
+
+  /**
+   * \brief append the entries of a subtree.
+   * \param node the root of the subtree
+   * \param entries the entries
+   */
+  static void GetEntries (const Node *node, std::vector<Entry> &entries);
+
+  /**
+   * \brief the root node
+   */
+  Node *m_root;
+
+  /**
+   * \brief number of prefixes
+   */
+  uint32_t m_size;
+};
+
+template <typename T>
+PrefixTrie<T>::PrefixTrie ()
+  : m_root (0),
+  m_size (0)
+{
+}
+
+template <typename T>
+PrefixTrie<T>::~PrefixTrie ()
+{
+  Clear ();
+}
+
+template <typename T>
+typename PrefixTrie<T>::Node *
+PrefixTrie<T>::NewNode (const uint8_t key[16], uint8_t length)
+{
+  Node *node = new Node ();
+  std::memset (node->key, 0, 16);
+  std::memcpy (node->key, key, (length + 7) / 8);
+  if (length % 8)
+    {
+      node->key[length / 8] &= 0xff << (8 - length % 8);
+    }
+  node->length = length;
+  node->hasValue = false;
+  node->child[0] = 0;
+  node->child[1] = 0;
+  return node;
+}
+
+template <typename T>
+uint32_t
+PrefixTrie<T>::GetBit (const uint8_t key[16], uint8_t bit)
+{
+  return (key[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+template <typename T>
+uint8_t
+PrefixTrie<T>::CommonLength (const uint8_t a[16], const uint8_t b[16], uint8_t max)
+{
+  uint8_t length = 0;
+  for (uint32_t i = 0; i < 16 && length < max; i++)
+    {
+      uint8_t diff = a[i] ^ b[i];
+      if (diff)
+        {
+          while (!(diff & 0x80))
+            {
+              diff <<= 1;
+              length++;
+            }
+          break;
+        }
+      length += 8;
+    }
+  return length < max ? length : max;
+}
+
+template <typename T>
+bool
+PrefixTrie<T>::Insert (Ipv6Address prefix, uint8_t length, const T &value)
+{
+  NS_ASSERT (length <= 128);
+
+  uint8_t key[16];
+  prefix.GetBytes (key);
+
+  Node **link = &m_root;
+  while (*link)
+    {
+      Node *node = *link;
+      uint8_t common = CommonLength (key, node->key, length < node->length ? length : node->length);
+      if (common < node->length)
+        {
+          Node *leaf = NewNode (key, length);
+          leaf->hasValue = true;
+          leaf->value = value;
+          m_size++;
+          if (common == length)
+            {
+              /* the new prefix contains the node */
+              leaf->child[GetBit (node->key, length)] = node;
+              *link = leaf;
+              return true;
+            }
+          Node *branch = NewNode (key, common);
+          branch->child[GetBit (node->key, common)] = node;
+          branch->child[GetBit (key, common)] = leaf;
+          *link = branch;
+          return true;
+        }
+      if (node->length == length)
+        {
+          bool added = !node->hasValue;
+          if (added)
+            {
+              m_size++;
+            }
+          node->hasValue = true;
+          node->value = value;
+          return added;
+        }
+      link = &node->child[GetBit (key, node->length)];
+    }
+
+  *link = NewNode (key, length);
+  (*link)->hasValue = true;
+  (*link)->value = value;
+  m_size++;
+  return true;
+}
+
+template <typename T>
+bool
+PrefixTrie<T>::Remove (Ipv6Address prefix, uint8_t length)
+{
+  uint8_t key[16];
+  prefix.GetBytes (key);
+  return Remove (&m_root, key, length);
+}
+
+template <typename T>
+bool
+PrefixTrie<T>::Remove (Node **link, const uint8_t key[16], uint8_t length)
+{
+  Node *node = *link;
+  if (!node || node->length > length || CommonLength (key, node->key, node->length) < node->length)
+    {
+      return false;
+    }
+
+  if (node->length == length)
+    {
+      if (!node->hasValue)
+        {
+          return false;
+        }
+      node->hasValue = false;
+      node->value = T ();
+      m_size--;
+    }
+  else if (!Remove (&node->child[GetBit (key, node->length)], key, length))
+    {
+      return false;
+    }
+
+  /* a node without value is only kept to branch */
+  if (!node->hasValue && !(node->child[0] && node->child[1]))
+    {
+      *link = node->child[0] ? node->child[0] : node->child[1];
+      delete node;
+    }
+  return true;
+}
+
+template <typename T>
+T *
+PrefixTrie<T>::Find (Ipv6Address prefix, uint8_t length)
+{
+  uint8_t key[16];
+  prefix.GetBytes (key);
+
+  Node *node = m_root;
+  while (node && node->length <= length)
+    {
+      if (CommonLength (key, node->key, node->length) < node->length)
+        {
+          return 0;
+        }
+      if (node->length == length)
+        {
+          return node->hasValue ? &node->value : 0;
+        }
+      node = node->child[GetBit (key, node->length)];
+    }
+  return 0;
+}
+
+template <typename T>
+const T *
+PrefixTrie<T>::Lookup (Ipv6Address address) const
+{
+  uint8_t length;
+  return Lookup (address, length);
+}
+
+template <typename T>
+const T *
+PrefixTrie<T>::Lookup (Ipv6Address address, uint8_t &length) const
+{
+  uint8_t key[16];
+  address.GetBytes (key);
+
+  const T *best = 0;
+  const Node *node = m_root;
+  while (node)
+    {
+      if (CommonLength (key, node->key, node->length) < node->length)
+        {
+          break;
+        }
+      if (node->hasValue)
+        {
+          best = &node->value;
+          length = node->length;
+        }
+      if (node->length == 128)
+        {
+          break;
+        }
+      node = node->child[GetBit (key, node->length)];
+    }
+  return best;
+}
+
+template <typename T>
+uint32_t
+PrefixTrie<T>::GetSize () const
+{
+  return m_size;
+}
+
+template <typename T>
+std::vector<typename PrefixTrie<T>::Entry>
+PrefixTrie<T>::GetEntries () const
+{
+  std::vector<Entry> entries;
+  GetEntries (m_root, entries);
+  return entries;
+}
+
+template <typename T>
+void
+PrefixTrie<T>::GetEntries (const Node *node, std::vector<Entry> &entries)
+{
+  if (!node)
+    {
+      return;
+    }
+  if (node->hasValue)
+    {
+      Entry entry;
+      entry.prefix = Ipv6Address (const_cast<uint8_t *> (node->key));
+      entry.length = node->length;
+      entry.value = node->value;
+      entries.push_back (entry);
+    }
+  GetEntries (node->child[0], entries);
+  GetEntries (node->child[1], entries);
+}
+
+template <typename T>
+void
+PrefixTrie<T>::Clear ()
+{
+  Delete (m_root);
+  m_root = 0;
+  m_size = 0;
+}
+
+template <typename T>
+void
+PrefixTrie<T>::Delete (Node *node)
+{
+  if (node)
+    {
+      Delete (node->child[0]);
+      Delete (node->child[1]);
+      delete node;
+    }
+}
+
+} /* namespace ns3 */
+
+#endif /* PREFIX_TRIE_H */
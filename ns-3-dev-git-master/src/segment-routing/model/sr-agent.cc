@@ -13,6 +13,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/traced-value.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/ipv6-header.h"
 
 using namespace std;
@@ -28,6 +29,17 @@ TypeId Mipv6Agent::GetTypeId ()
   static TypeId tid = TypeId ("ns3::Mipv6Agent")
     .SetParent<Object> ()
     .AddConstructor<Mipv6Agent> ()
+    .AddAttribute ("SegmentRouting",
+                   "Steer binding traffic with an SRv6 Segment Routing Header instead of IPv6-in-IPv6 tunnels. "
+                   "Needs Ipv6ListRouting on the node, tunnels are used otherwise.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Mipv6Agent::m_segmentRouting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TimingWheel",
+                   "Run the binding timers on a per-node TimingWheel instead of one scheduler event per timer.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Mipv6Agent::m_timingWheel),
+                   MakeBooleanChecker ())
     .AddTraceSource ("AgentTx",
                      "Trace source indicating a transmitted mobility handling packets by this agent",
                      MakeTraceSourceAccessor (&Mipv6Agent::m_agentTxTrace),
@@ -40,12 +52,22 @@ TypeId Mipv6Agent::GetTypeId ()
                      "Trace source indicating a received mobility handling packets by this agent. This is a non-promiscuous trace",
                      MakeTraceSourceAccessor (&Mipv6Agent::m_agentRxTrace),
                      "ns3::Packet::TracedCallback")
+    .AddTraceSource ("AgentTxWithAddresses",
+                     "A mobility handling packet transmitted by this agent, with its addresses",
+                     MakeTraceSourceAccessor (&Mipv6Agent::m_agentTxWithAddressesTrace),
+                     "ns3::Mipv6Agent::AddressesTracedCallback")
+    .AddTraceSource ("AgentRxWithAddresses",
+                     "A mobility handling packet received by this agent, with its addresses. This is a non-promiscuous trace",
+                     MakeTraceSourceAccessor (&Mipv6Agent::m_agentRxWithAddressesTrace),
+                     "ns3::Mipv6Agent::AddressesTracedCallback")
   ;
   return tid;
 }
 
 Mipv6Agent::Mipv6Agent ()
-  : m_node (0)
+  : m_node (0),
+  m_segmentRouting (false),
+  m_timingWheel (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -72,73 +94,80 @@ Ptr<Node> Mipv6Agent::GetNode (void)
   NS_LOG_FUNCTION (this);
   return m_node;
 }
+
+bool Mipv6Agent::IsSegmentRoutingEnabled (void) const
+{
+  return m_segmentRouting;
+}
+
+bool Mipv6Agent::IsTimingWheelEnabled (void) const
+{
+  return m_timingWheel;
+}
+const Mipv6Agent::Handler Mipv6Agent::m_handlers[] = {
+  0,
+  &Mipv6Agent::HandleHoTI,
+  &Mipv6Agent::HandleCoTI,
+  &Mipv6Agent::HandleHoT,
+  &Mipv6Agent::HandleCoT,
+  &Mipv6Agent::HandleBU,
+  &Mipv6Agent::HandleBA
+};
+
 uint8_t Mipv6Agent::Receive (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << packet << src << dst << interface );
 
-  m_agentPromiscRxTrace (packet);
+  Mipv6MessageView view;
 
-  Ptr<Packet> p = packet->Copy ();
-
-  Mipv6Header mh;
+  if (!view.Parse (packet))
+    {
+      NS_LOG_ERROR ("Malformed mobility header");
+      return 0;
+    }
 
-  p->PeekHeader (mh);
+  return Receive (packet, view, src, dst, interface);
+}
 
-  uint8_t mhType = mh.GetMhType ();
+uint8_t Mipv6Agent::Receive (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+{
+  NS_LOG_FUNCTION ( this << packet << src << dst << interface << (uint32_t)view.GetMhType () );
 
-  if (mhType == Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE)
-    {
-      NS_LOG_FUNCTION (this << packet << src << "BU" << "recieve BU");
-      m_agentRxTrace (packet);
-      HandleBU (packet, src, dst, interface);
-    }
-  else if (mhType == Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT)
-    {
-      NS_LOG_FUNCTION (this << packet << src << "receive BACK");
-      m_agentRxTrace (packet);
-      HandleBA (packet, src, dst, interface);
-    }
+  m_agentPromiscRxTrace (packet);
 
+  uint8_t mhType = view.GetMhType ();
+  Handler handler = 0;
 
-  else if (mhType == Mipv6Header::HOME_TEST_INIT)
-    {
-      NS_LOG_FUNCTION (this << packet << src << "HoTI" << "recieve HoTI");
-      m_agentRxTrace (packet);
-      HandleHoTI (packet, src, dst, interface);
-    }
-  else if (mhType == Mipv6Header::HOME_TEST)
-    {
-      NS_LOG_FUNCTION (this << packet << src << "HoT" << "recieve HoT");
-      m_agentRxTrace (packet);
-      HandleHoT (packet, src, dst, interface);
-    }
-  else if (mhType == Mipv6Header::CARE_OF_TEST_INIT)
+  if (mhType < sizeof (m_handlers) / sizeof (m_handlers[0]))
     {
-      NS_LOG_FUNCTION (this << packet << src << "CoTI" << "recieve CoTI");
-      m_agentRxTrace (packet);
-      HandleCoTI (packet, src, dst, interface);
+      handler = m_handlers[mhType];
     }
-  else if (mhType == Mipv6Header::CARE_OF_TEST)
-    {
-      NS_LOG_FUNCTION (this << packet << src << "CoT" << "recieve CoT");
-      m_agentRxTrace (packet);
-      HandleCoT (packet, src, dst, interface);
-    }
-  else
+
+  if (!handler)
     {
       NS_LOG_ERROR ("Unknown MHType (" << (uint32_t)mhType << ")");
+      return 0;
     }
 
+  m_agentRxTrace (packet);
+  m_agentRxWithAddressesTrace (packet, src, dst);
+  (this->*handler)(packet, view, src, dst, interface);
+
   return 0;
 }
 
 void Mipv6Agent::SendMessage (Ptr<Packet> packet, Ipv6Address dst, uint32_t ttl)
 {
-  NS_LOG_FUNCTION (this << packet << dst << (uint32_t)ttl << "send");
+  SendMessage (packet, Ipv6Address::GetAny (), dst, ttl);
+}
+
+void Mipv6Agent::SendMessage (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint32_t ttl)
+{
+  NS_LOG_FUNCTION (this << packet << src << dst << (uint32_t)ttl << "send");
 
   Ptr<Ipv6L3Protocol> ipv6 = m_node->GetObject<Ipv6L3Protocol> ();
 
-  NS_ASSERT (!ipv6 && !ipv6->GetRoutingProtocol ());
+  NS_ASSERT (ipv6 && ipv6->GetRoutingProtocol ());
 
   Ipv6Header header;
   SocketIpTtlTag tag;
@@ -149,14 +178,18 @@ void Mipv6Agent::SendMessage (Ptr<Packet> packet, Ipv6Address dst, uint32_t ttl)
   header.SetDestination (dst);
   route = ipv6->GetRoutingProtocol ()->RouteOutput (packet, header, oif, err);
 
-  if (!route)
+  if (route)
     {
       tag.SetTtl (ttl);
       packet->AddPacketTag (tag);
-      Ipv6Address src = route->GetSource ();
+      if (src.IsAny ())
+        {
+          src = route->GetSource ();
+        }
       NS_LOG_FUNCTION ("Lura1" << src << "    " << dst);
 
       m_agentTxTrace (packet);
+      m_agentTxWithAddressesTrace (packet, src, dst);
       ipv6->Send (packet, src, dst, 135, route);
       NS_LOG_LOGIC ("route found and send hmipv6 message");
     }
@@ -166,7 +199,7 @@ void Mipv6Agent::SendMessage (Ptr<Packet> packet, Ipv6Address dst, uint32_t ttl)
     }
 }
 
-uint8_t Mipv6Agent::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Agent::HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << src << dst );
 
@@ -175,7 +208,7 @@ uint8_t Mipv6Agent::HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const
   return 0;
 }
 
-uint8_t Mipv6Agent::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Agent::HandleBA (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << src << dst );
 
@@ -186,7 +219,7 @@ uint8_t Mipv6Agent::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const
 
 
 
-uint8_t Mipv6Agent::HandleHoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Agent::HandleHoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << src << dst );
 
@@ -195,7 +228,7 @@ uint8_t Mipv6Agent::HandleHoTI (Ptr<Packet> packet, const Ipv6Address &src, cons
   return 0;
 }
 
-uint8_t Mipv6Agent::HandleCoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Agent::HandleCoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << src << dst );
 
@@ -203,7 +236,7 @@ uint8_t Mipv6Agent::HandleCoTI (Ptr<Packet> packet, const Ipv6Address &src, cons
 
   return 0;
 }
-uint8_t Mipv6Agent::HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Agent::HandleHoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << src << dst );
 
@@ -212,7 +245,7 @@ uint8_t Mipv6Agent::HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const
   return 0;
 }
 
-uint8_t Mipv6Agent::HandleCoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Agent::HandleCoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION ( this << src << dst );
 
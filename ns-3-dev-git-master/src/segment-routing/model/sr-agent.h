@@ -4,6 +4,7 @@
 #include "ns3/object.h"
 #include "ns3/ipv6-address.h"
 #include "bcache.h"
+#include "ns3/traced-callback.h"
 #include "ns3/traced-value.h"
 
 namespace ns3 {
@@ -11,6 +12,7 @@ namespace ns3 {
 class Node;
 class Packet;
 class Ipv6Interface;
+class Mipv6MessageView;
 class Mipv6Agent : public Object
 {
 public:
@@ -51,6 +53,19 @@ public:
    */
   virtual uint8_t Receive (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
+  /**
+   * \brief receive a mobility handling packet already parsed by the L4 protocol.
+   *
+   * Dispatches to the handler of the MH type without copying the packet.
+   * \param packet the packet
+   * \param view the mobility header parsed from the packet
+   * \param src source address
+   * \param dst the destination address
+   * \param interface the interface where the packet is received
+   * \return status
+   */
+  uint8_t Receive (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+
   /**
    * \brief send a mobility handling packets (BU/BA).
    * \param packet the packet
@@ -59,67 +74,107 @@ public:
    */
   void SendMessage (Ptr<Packet> packet, Ipv6Address dst, uint32_t ttl);
 
+  /**
+   * \brief send a mobility handling packets (BU/BA) from a given address.
+   *
+   * A BA leaves from the HA address the BU was sent to, and a BU from the
+   * CoA, whatever the source of the route towards the peer.
+   * \param packet the packet
+   * \param src the source address
+   * \param dst the destination address
+   * \param ttl time to live field
+   */
+  void SendMessage (Ptr<Packet> packet, Ipv6Address src, Ipv6Address dst, uint32_t ttl);
+
+  /**
+   * TracedCallback signature for the mobility messages sent or received, with their addresses.
+   *
+   * \param [in] packet the message, starting with its mobility header
+   * \param [in] src the source address
+   * \param [in] dst the destination address
+   */
+  typedef void (* AddressesTracedCallback)
+    (Ptr<const Packet> packet, Ipv6Address src, Ipv6Address dst);
+
+  /**
+   * \brief whether binding traffic is steered with SRv6 instead of tunnels.
+   * \return true if segment routing is used
+   */
+  bool IsSegmentRoutingEnabled (void) const;
+
+  /**
+   * \brief whether the binding timers run on a timing wheel.
+   * \return true if the timing wheel is used
+   */
+  bool IsTimingWheelEnabled (void) const;
+
 protected:
 
   /**
    * \brief hanling packets if BU is received and calls the corresponding function inherited from this class.
    * \param packet the packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst the destination address
    * \param interface the interface where the packet is received
    * \return status
    */
-  virtual uint8_t HandleBU (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief hanling packets if BA is received and calls the corresponding function inherited from this class.
    * \param packet the packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst the destination address
    * \param interface the interface where the packet is received
    * \return status
    */
-  virtual uint8_t HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleBA (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief hanling packets if HoTI is received and calls the corresponding function inherited from this class.
    * \param packet the packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst the destination address
    * \param interface the interface where the packet is received
    * \return status
    */
-  virtual uint8_t HandleHoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleHoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief hanling packets if HoT is received and calls the corresponding function inherited from this class.
    * \param packet the packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst the destination address
    * \param interface the interface where the packet is received
    * \return status
    */
-  virtual uint8_t HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleHoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief hanling packets if CoTI is received and calls the corresponding function inherited from this class.
    * \param packet the packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst the destination address
    * \param interface the interface where the packet is received
    * \return status
    */
-  virtual uint8_t HandleCoTI (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleCoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief hanling packets if CoT is received and calls the corresponding function inherited from this class.
    * \param packet the packet
+   * \param view the mobility header parsed from the packet
    * \param src source address
    * \param dst the destination address
    * \param interface the interface where the packet is received
    * \return status
    */
-  virtual uint8_t HandleCoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleCoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief Dispose this object.
@@ -127,11 +182,31 @@ protected:
   virtual void DoDispose ();
 
 private:
+  /**
+   * \brief handler of a MH type.
+   */
+  typedef uint8_t (Mipv6Agent::*Handler)(Ptr<Packet>, const Mipv6MessageView &, const Ipv6Address &, const Ipv6Address &, Ptr<Ipv6Interface>);
+
+  /**
+   * \brief handlers indexed by MH type, 0 for unhandled types.
+   */
+  static const Handler m_handlers[];
+
   /**
    * \brief The node.
    */
   Ptr<Node> m_node;
 
+  /**
+   * \brief steer binding traffic with SRv6 instead of tunnels.
+   */
+  bool m_segmentRouting;
+
+  /**
+   * \brief run the binding timers on a timing wheel.
+   */
+  bool m_timingWheel;
+
   /**
    * \brief Trace source indicating a transmitted mobility handling packets by this agent 
    */
@@ -147,6 +222,16 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_agentPromiscRxTrace;
 
+  /**
+   * \brief Trace source indicating a transmitted mobility handling packet, with its addresses
+   */
+  TracedCallback<Ptr<const Packet>, Ipv6Address, Ipv6Address> m_agentTxWithAddressesTrace;
+
+  /**
+   * \brief Trace source indicating a received mobility handling packet, with its addresses. This is a non-promiscuous trace
+   */
+  TracedCallback<Ptr<const Packet>, Ipv6Address, Ipv6Address> m_agentRxWithAddressesTrace;
+
 };
 
 } /* namespace ns3 */
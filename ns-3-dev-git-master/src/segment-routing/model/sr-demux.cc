@@ -22,6 +22,7 @@ TypeId Mipv6Demux::GetTypeId ()
 }
 
 Mipv6Demux::Mipv6Demux ()
+  : m_table (256)
 {
 }
 
@@ -37,6 +38,7 @@ void Mipv6Demux::DoDispose ()
       *it = 0;
     }
   m_mobilities.clear ();
+  m_table.clear ();
   m_node = 0;
   Object::DoDispose ();
 }
@@ -49,27 +51,39 @@ void Mipv6Demux::SetNode (Ptr<Node> node)
 void Mipv6Demux::Insert (Ptr<Mipv6Mobility> mobility)
 {
   m_mobilities.push_back (mobility);
+  if (!m_table[mobility->GetMobilityNumber ()])
+    {
+      m_table[mobility->GetMobilityNumber ()] = mobility;
+    }
 }
 
 Ptr<Mipv6Mobility> Mipv6Demux::GetMobility (int mobilityNumber)
 {
-  
-  for (Ipv6MobilityList_t::iterator i = m_mobilities.begin (); i != m_mobilities.end (); ++i)
+  if (mobilityNumber < 0 || mobilityNumber >= (int)m_table.size ())
     {
-      
-      if ((*i)->GetMobilityNumber () == mobilityNumber)
-        {
-          //std::cout<<(*i)->GetMobilityNumber () << mobilityNumber ;
-          return *i;
-        }
+      return 0;
     }
-  
-  return 0;
+  return m_table[mobilityNumber];
 }
 
 void Mipv6Demux::Remove (Ptr<Mipv6Mobility> mobility)
 {
   m_mobilities.remove (mobility);
+
+  uint8_t mobilityNumber = mobility->GetMobilityNumber ();
+  if (!m_table.empty () && m_table[mobilityNumber] == mobility)
+    {
+      /* the first mobility left with this number takes over */
+      m_table[mobilityNumber] = 0;
+      for (Ipv6MobilityList_t::iterator i = m_mobilities.begin (); i != m_mobilities.end (); ++i)
+        {
+          if ((*i)->GetMobilityNumber () == mobilityNumber)
+            {
+              m_table[mobilityNumber] = *i;
+              break;
+            }
+        }
+    }
 }
 
 } /* namespace ns3 */
\ No newline at end of file
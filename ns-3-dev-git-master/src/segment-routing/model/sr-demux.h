@@ -2,6 +2,7 @@
 #define SR_DEMUX_H
 
 #include <list>
+#include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 
@@ -75,6 +76,11 @@ private:
    */
   Ipv6MobilityList_t m_mobilities;
 
+  /**
+   * \brief IPv6 Mobility indexed by mobility number.
+   */
+  std::vector<Ptr<Mipv6Mobility> > m_table;
+
   /**
    * \brief The node.
    */
@@ -0,0 +1,587 @@
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/fork-impl.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "sr-event-log.h"
+#include "sr-header.h"
+#include "sr-tun-l4-protocol.h"
+#include "ha.h"
+#include "cn.h"
+#include "sr-mn.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("Mipv6EventLog");
+
+namespace ns3 {
+
+namespace {
+
+/**
+ * \brief header of a log file, 64 bytes
+ */
+struct FileHeader
+{
+  char magic[8];          //!< "SREVTLOG"
+  uint32_t version;       //!< format version
+  uint32_t recordSize;    //!< bytes of a record
+  uint64_t records;       //!< number of records, 0 if the log was not closed
+  uint8_t reserved[40];   //!< zero
+};
+
+/**
+ * \brief magic of a log file
+ */
+const char LOG_MAGIC[8] = { 'S', 'R', 'E', 'V', 'T', 'L', 'O', 'G' };
+
+/**
+ * \brief version of the log format
+ */
+const uint32_t LOG_VERSION = 1;
+
+/**
+ * \brief write a field of the records as a raw array.
+ * \param records the records
+ * \param path the file
+ * \param offset offset of the field in a record
+ * \param size size of the field
+ * \return false if the file cannot be written
+ */
+bool
+WriteColumn (const std::vector<Mipv6EventLog::Record> &records, std::string path, size_t offset, size_t size)
+{
+  std::ofstream os (path.c_str (), std::ios::binary);
+  for (std::vector<Mipv6EventLog::Record>::const_iterator it = records.begin (); os && it != records.end (); it++)
+    {
+      os.write (reinterpret_cast<const char *> (&*it) + offset, size);
+    }
+  return bool (os);
+}
+
+} // anonymous namespace
+
+NS_OBJECT_ENSURE_REGISTERED (Mipv6EventLog);
+
+TypeId
+Mipv6EventLog::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Mipv6EventLog")
+    .SetParent<Object> ()
+    .AddConstructor<Mipv6EventLog> ()
+    .AddAttribute ("Capacity", "Records kept in memory, a multiple of Segments.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&Mipv6EventLog::m_capacity),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Segments", "Parts of the ring handed to the writer thread one at a time.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&Mipv6EventLog::m_segments),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ChunkSize", "Bytes of the file mapped at a time, rounded down to pages.",
+                   UintegerValue (16 << 20),
+                   MakeUintegerAccessor (&Mipv6EventLog::m_chunkSize),
+                   MakeUintegerChecker<uint64_t> (1))
+    .AddAttribute ("EncapInterval", "Period of the records of the encapsulated bytes, 0 for one record per packet.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&Mipv6EventLog::m_encapInterval),
+                   MakeTimeChecker (Seconds (0)))
+  ;
+  return tid;
+}
+
+Mipv6EventLog::Mipv6EventLog ()
+  : m_capacity (65536),
+    m_segments (4),
+    m_chunkSize (16 << 20),
+    m_encapInterval (Seconds (1)),
+    m_written (0),
+    m_flushedSeen (0),
+    m_stalls (0),
+    m_ready (0),
+    m_flushed (0),
+    m_stop (false),
+    m_error (false),
+    m_fd (-1),
+    m_map (0),
+    m_mapOffset (0)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (sizeof (Record) == 64 && sizeof (FileHeader) == 64);
+}
+
+Mipv6EventLog::~Mipv6EventLog ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+}
+
+void Mipv6EventLog::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+  Object::DoDispose ();
+}
+
+bool Mipv6EventLog::Open (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+  NS_ASSERT_MSG (!IsOpen (), "event log already open");
+  NS_ASSERT_MSG (m_capacity % m_segments == 0, "the capacity is not a multiple of the segments");
+
+  m_fd = open (path.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (m_fd < 0)
+    {
+      NS_LOG_ERROR ("Cannot create " << path);
+      return false;
+    }
+
+  uint64_t page = sysconf (_SC_PAGESIZE);
+  m_chunkSize = std::max (page, m_chunkSize - m_chunkSize % page);
+  m_ring.assign (m_capacity, Record ());
+  m_written = 0;
+  m_flushedSeen = 0;
+  m_stalls = 0;
+  m_ready = 0;
+  m_flushed = 0;
+  m_stop = false;
+  m_error = false;
+  m_map = 0;
+  m_mapOffset = 0;
+  m_writer = std::thread (&Mipv6EventLog::Write, this);
+  ForkImpl::RegisterThread (this, "Mipv6EventLog writer");
+  return true;
+}
+
+bool Mipv6EventLog::IsOpen () const
+{
+  return m_fd >= 0;
+}
+
+void Mipv6EventLog::Close ()
+{
+  if (!IsOpen ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+
+  if (!m_encapSums.empty ())
+    {
+      FlushEncap ();
+    }
+  m_encapEvent.Cancel ();
+
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_ready = m_written;
+    m_stop = true;
+  }
+  m_readyCv.notify_one ();
+  m_writer.join ();
+  ForkImpl::UnregisterThread (this);
+
+  if (m_map)
+    {
+      munmap (m_map, m_chunkSize);
+      m_map = 0;
+    }
+  FileHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, LOG_MAGIC, sizeof (LOG_MAGIC));
+  header.version = LOG_VERSION;
+  header.recordSize = sizeof (Record);
+  header.records = m_flushed;
+  if (ftruncate (m_fd, sizeof (FileHeader) + m_flushed * sizeof (Record)) != 0
+      || pwrite (m_fd, &header, sizeof (header), 0) != sizeof (header))
+    {
+      m_error = true;
+    }
+  if (m_error)
+    {
+      NS_LOG_ERROR ("Event log incomplete, " << m_flushed << " of " << m_written << " records written");
+    }
+  close (m_fd);
+  m_fd = -1;
+  m_ring.clear ();
+}
+
+void Mipv6EventLog::Connect (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+
+  uint32_t id = node->GetId ();
+  std::vector<Ptr<Mipv6Agent> > agents;
+  agents.push_back (node->GetObject<Mipv6Ha> ());
+  agents.push_back (node->GetObject<Mipv6CN> ());
+  agents.push_back (node->GetObject<Mipv6Mn> ());
+  for (std::vector<Ptr<Mipv6Agent> >::const_iterator it = agents.begin (); it != agents.end (); it++)
+    {
+      if (*it)
+        {
+          (*it)->TraceConnectWithoutContext ("AgentTxWithAddresses", MakeCallback (&Mipv6EventLog::Message, this, id, true));
+          (*it)->TraceConnectWithoutContext ("AgentRxWithAddresses", MakeCallback (&Mipv6EventLog::Message, this, id, false));
+        }
+    }
+
+  Ptr<Mipv6Mn> mn = node->GetObject<Mipv6Mn> ();
+  if (mn)
+    {
+      mn->TraceConnectWithoutContext ("HandoverStart", MakeCallback (&Mipv6EventLog::HandoverStart, this, id));
+      mn->TraceConnectWithoutContext ("Handover", MakeCallback (&Mipv6EventLog::HandoverEnd, this, id));
+    }
+
+  Ptr<Ipv6TunnelL4Protocol> tunnel = node->GetObject<Ipv6TunnelL4Protocol> ();
+  if (tunnel)
+    {
+      tunnel->TraceConnectWithoutContext ("TunnelAdd", MakeCallback (&Mipv6EventLog::Tunnel, this, id, (uint8_t) TUNNEL_ADD));
+      tunnel->TraceConnectWithoutContext ("TunnelRemove", MakeCallback (&Mipv6EventLog::Tunnel, this, id, (uint8_t) TUNNEL_REMOVE));
+      tunnel->TraceConnectWithoutContext ("Tx", MakeCallback (&Mipv6EventLog::Encap, this, id));
+    }
+}
+
+void Mipv6EventLog::Connect (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); it++)
+    {
+      Connect (*it);
+    }
+}
+
+void Mipv6EventLog::Log (Record record)
+{
+  if (!IsOpen ())
+    {
+      return;
+    }
+
+  //the slot to fill was not written yet: wait for the writer
+  if (m_written - m_flushedSeen == m_capacity)
+    {
+      std::unique_lock<std::mutex> lock (m_mutex);
+      if (m_flushed + m_capacity == m_written && !m_error)
+        {
+          m_stalls++;
+          m_flushedCv.wait (lock, [this] { return m_flushed + m_capacity > m_written || m_error; });
+        }
+      m_flushedSeen = m_flushed;
+      if (m_error)
+        {
+          return;
+        }
+    }
+
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  m_ring[m_written % m_capacity] = record;
+  m_written++;
+  if (m_written % (m_capacity / m_segments) == 0)
+    {
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_ready = m_written;
+      }
+      m_readyCv.notify_one ();
+    }
+}
+
+uint64_t Mipv6EventLog::GetNRecords () const
+{
+  return m_written;
+}
+
+uint64_t Mipv6EventLog::GetNStalls () const
+{
+  return m_stalls;
+}
+
+void Mipv6EventLog::Write ()
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      m_readyCv.wait (lock, [this] { return m_ready > m_flushed || m_stop; });
+      if (m_ready == m_flushed)
+        {
+          break;
+        }
+
+      //the simulation does not touch the records handed over until they are written
+      uint64_t first = m_flushed;
+      uint64_t last = m_ready;
+      lock.unlock ();
+      bool written = true;
+      for (uint64_t i = first; written && i < last; )
+        {
+          uint64_t slot = i % m_capacity;
+          uint64_t n = std::min<uint64_t> (last - i, m_capacity - slot);
+          written = WriteRecords (i, &m_ring[slot], n);
+          i += n;
+        }
+      lock.lock ();
+
+      if (!written)
+        {
+          m_error = true;
+          m_flushedCv.notify_all ();
+          break;
+        }
+      m_flushed = last;
+      m_flushedCv.notify_all ();
+    }
+}
+
+bool Mipv6EventLog::WriteRecords (uint64_t first, const Record *records, uint64_t n)
+{
+  const uint8_t *src = reinterpret_cast<const uint8_t *> (records);
+  uint64_t offset = sizeof (FileHeader) + first * sizeof (Record);
+  uint64_t size = n * sizeof (Record);
+  while (size > 0)
+    {
+      if (!m_map || offset >= m_mapOffset + m_chunkSize)
+        {
+          if (!MapChunk (offset))
+            {
+              return false;
+            }
+        }
+      uint64_t copied = std::min (size, m_mapOffset + m_chunkSize - offset);
+      std::memcpy (m_map + (offset - m_mapOffset), src, copied);
+      src += copied;
+      offset += copied;
+      size -= copied;
+    }
+  return true;
+}
+
+bool Mipv6EventLog::MapChunk (uint64_t offset)
+{
+  if (m_map)
+    {
+      munmap (m_map, m_chunkSize);
+      m_map = 0;
+    }
+  uint64_t base = offset - offset % m_chunkSize;
+  if (ftruncate (m_fd, base + m_chunkSize) != 0)
+    {
+      return false;
+    }
+  void *map = mmap (0, m_chunkSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, base);
+  if (map == MAP_FAILED)
+    {
+      return false;
+    }
+  m_map = static_cast<uint8_t *> (map);
+  m_mapOffset = base;
+  return true;
+}
+
+void Mipv6EventLog::Message (uint32_t node, bool sent, Ptr<const Packet> packet, Ipv6Address src, Ipv6Address dst)
+{
+  Mipv6MessageView view;
+  if (!view.Parse (packet))
+    {
+      return;
+    }
+
+  Record record;
+  std::memset (&record, 0, sizeof (record));
+  switch (view.GetMhType ())
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+      record.type = sent ? BU_SENT : BU_RECEIVED;
+      break;
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+      record.type = sent ? BA_SENT : BA_RECEIVED;
+      record.status = view.GetStatus ();
+      break;
+    default:
+      return;
+    }
+  record.node = node;
+  record.sequence = view.GetSequence ();
+  record.aux = view.GetLifetime ();
+  src.GetBytes (record.address1);
+  dst.GetBytes (record.address2);
+  Log (record);
+}
+
+void Mipv6EventLog::HandoverStart (uint32_t node, Ipv6Address oldCoa, Ipv6Address newCoa)
+{
+  Record record;
+  std::memset (&record, 0, sizeof (record));
+  record.type = HANDOVER_START;
+  record.node = node;
+  oldCoa.GetBytes (record.address1);
+  newCoa.GetBytes (record.address2);
+  Log (record);
+}
+
+void Mipv6EventLog::HandoverEnd (uint32_t node, Time interruption, bool predictive, Ipv6Address oldCoa, Ipv6Address newCoa)
+{
+  Record record;
+  std::memset (&record, 0, sizeof (record));
+  record.type = HANDOVER_END;
+  record.node = node;
+  record.value = interruption.GetNanoSeconds ();
+  record.aux = predictive;
+  oldCoa.GetBytes (record.address1);
+  newCoa.GetBytes (record.address2);
+  Log (record);
+}
+
+void Mipv6EventLog::Tunnel (uint32_t node, uint8_t type, Ipv6Address remote)
+{
+  Record record;
+  std::memset (&record, 0, sizeof (record));
+  record.type = type;
+  record.node = node;
+  remote.GetBytes (record.address1);
+  Log (record);
+}
+
+void Mipv6EventLog::Encap (uint32_t node, Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh)
+{
+  if (m_encapInterval.IsZero ())
+    {
+      Record record;
+      std::memset (&record, 0, sizeof (record));
+      record.type = ENCAP;
+      record.node = node;
+      record.value = packet->GetSize () + oh.GetSerializedSize ();
+      record.aux = 1;
+      oh.GetDestination ().GetBytes (record.address1);
+      Log (record);
+      return;
+    }
+
+  std::pair<uint64_t, uint32_t> &sum = m_encapSums[std::make_pair (node, oh.GetDestination ())];
+  sum.first += packet->GetSize () + oh.GetSerializedSize ();
+  sum.second++;
+  if (!m_encapEvent.IsRunning ())
+    {
+      m_encapEvent = Simulator::Schedule (m_encapInterval, &Mipv6EventLog::FlushEncap, this);
+    }
+}
+
+void Mipv6EventLog::FlushEncap ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (EncapSums::const_iterator it = m_encapSums.begin (); it != m_encapSums.end (); it++)
+    {
+      Record record;
+      std::memset (&record, 0, sizeof (record));
+      record.type = ENCAP;
+      record.node = it->first.first;
+      record.value = it->second.first;
+      record.aux = it->second.second;
+      it->first.second.GetBytes (record.address1);
+      Log (record);
+    }
+  m_encapSums.clear ();
+}
+
+bool Mipv6EventLog::Read (std::string path, std::vector<Record> &records)
+{
+  std::ifstream is (path.c_str (), std::ios::binary);
+  FileHeader header;
+  if (!is.read (reinterpret_cast<char *> (&header), sizeof (header))
+      || std::memcmp (header.magic, LOG_MAGIC, sizeof (LOG_MAGIC)) != 0
+      || header.version != LOG_VERSION || header.recordSize != sizeof (Record))
+    {
+      return false;
+    }
+
+  //a log which was not closed ends with the zeroed tail of its last chunk
+  Record record;
+  records.clear ();
+  while ((header.records == 0 || records.size () < header.records)
+         && is.read (reinterpret_cast<char *> (&record), sizeof (record)))
+    {
+      if (header.records == 0 && record.type == 0)
+        {
+          break;
+        }
+      records.push_back (record);
+    }
+  return header.records == 0 || records.size () == header.records;
+}
+
+void Mipv6EventLog::WriteCsv (const std::vector<Record> &records, std::ostream &os)
+{
+  os << "time,node,type,sequence,status,aux,value,address1,address2" << std::endl;
+  for (std::vector<Record>::const_iterator it = records.begin (); it != records.end (); it++)
+    {
+      os << it->time << ',' << it->node << ',' << GetTypeName (it->type) << ','
+         << it->sequence << ',' << (uint32_t) it->status << ',' << it->aux << ',' << it->value << ','
+         << Ipv6Address::Deserialize (it->address1) << ',' << Ipv6Address::Deserialize (it->address2) << std::endl;
+    }
+}
+
+bool Mipv6EventLog::WriteColumns (const std::vector<Record> &records, std::string prefix)
+{
+  bool written = WriteColumn (records, prefix + ".time", offsetof (Record, time), sizeof (int64_t))
+    && WriteColumn (records, prefix + ".node", offsetof (Record, node), sizeof (uint32_t))
+    && WriteColumn (records, prefix + ".type", offsetof (Record, type), sizeof (uint8_t))
+    && WriteColumn (records, prefix + ".sequence", offsetof (Record, sequence), sizeof (uint16_t))
+    && WriteColumn (records, prefix + ".status", offsetof (Record, status), sizeof (uint8_t))
+    && WriteColumn (records, prefix + ".aux", offsetof (Record, aux), sizeof (uint32_t))
+    && WriteColumn (records, prefix + ".value", offsetof (Record, value), sizeof (uint64_t))
+    && WriteColumn (records, prefix + ".address1", offsetof (Record, address1), 16)
+    && WriteColumn (records, prefix + ".address2", offsetof (Record, address2), 16);
+
+  std::ofstream schema ((prefix + ".schema").c_str ());
+  schema << "records " << records.size () << std::endl
+         << "time int64" << std::endl
+         << "node uint32" << std::endl
+         << "type uint8";
+  for (uint8_t type = BU_SENT; type < EVENT_TYPES; type++)
+    {
+      schema << ' ' << (uint32_t) type << '=' << GetTypeName (type);
+    }
+  schema << std::endl
+         << "sequence uint16" << std::endl
+         << "status uint8" << std::endl
+         << "aux uint32" << std::endl
+         << "value uint64" << std::endl
+         << "address1 ipv6" << std::endl
+         << "address2 ipv6" << std::endl;
+  return written && bool (schema);
+}
+
+std::string Mipv6EventLog::GetTypeName (uint8_t type)
+{
+  switch (type)
+    {
+    case BU_SENT:
+      return "BU_SENT";
+    case BU_RECEIVED:
+      return "BU_RECEIVED";
+    case BA_SENT:
+      return "BA_SENT";
+    case BA_RECEIVED:
+      return "BA_RECEIVED";
+    case HANDOVER_START:
+      return "HANDOVER_START";
+    case HANDOVER_END:
+      return "HANDOVER_END";
+    case TUNNEL_ADD:
+      return "TUNNEL_ADD";
+    case TUNNEL_REMOVE:
+      return "TUNNEL_REMOVE";
+    case ENCAP:
+      return "ENCAP";
+    default:
+      return "UNKNOWN";
+    }
+}
+
+} /* namespace ns3 */
@@ -0,0 +1,280 @@
+#ifndef SR_EVENT_LOG_H
+#define SR_EVENT_LOG_H
+
+#include "ns3/object.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \class Mipv6EventLog
+ * \brief Binary log of the binding and tunnel events of the nodes.
+ *
+ * The events are stored in fixed-size records in a ring in memory. Each time
+ * a segment of the ring fills up, a writer thread copies it to a file mapped
+ * in memory a chunk at a time, so the simulation does not format text or wait
+ * for the disk; it only waits when the writer falls a whole ring behind.
+ * The encapsulated bytes are summed per node and tunnel remote over
+ * EncapInterval instead of recorded per packet.
+ *
+ * The file is a 64 bytes header followed by the records, in host byte order.
+ * Read loads it back, and WriteCsv and WriteColumns convert the records, as
+ * the sr-event-log-reader example does.
+ */
+class Mipv6EventLog : public Object
+{
+public:
+  /**
+   * \brief Get the type identifier.
+   * \return type identifier
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief the recorded events
+   */
+  enum EventType
+  {
+    BU_SENT = 1,     //!< BU sent, sequence and lifetime
+    BU_RECEIVED,     //!< BU received, sequence and lifetime
+    BA_SENT,         //!< BA sent, sequence, status and lifetime
+    BA_RECEIVED,     //!< BA received, sequence, status and lifetime
+    HANDOVER_START,  //!< attachment of an MN to a new AR, old and new CoA
+    HANDOVER_END,    //!< registered path after a handover, interruption in ns and whether predictive
+    TUNNEL_ADD,      //!< first reference to a tunnel
+    TUNNEL_REMOVE,   //!< release of the last reference to a tunnel
+    ENCAP,           //!< bytes and packets encapsulated towards a remote
+    EVENT_TYPES      //!< number of event types
+  };
+
+  /**
+   * \brief an event, 64 bytes.
+   */
+  struct Record
+  {
+    int64_t time;       //!< simulation time in ns
+    uint64_t value;     //!< bytes of ENCAP, interruption of HANDOVER_END
+    uint32_t node;      //!< node id
+    uint32_t aux;       //!< lifetime of BU/BA, packets of ENCAP, predictive flag of HANDOVER_END
+    uint16_t sequence;  //!< sequence of BU/BA
+    uint8_t type;       //!< the EventType
+    uint8_t status;     //!< status of BA
+    uint8_t reserved[4]; //!< zero
+    uint8_t address1[16]; //!< source of BU/BA, old CoA, tunnel remote
+    uint8_t address2[16]; //!< destination of BU/BA, new CoA
+  };
+
+  Mipv6EventLog ();
+
+  virtual ~Mipv6EventLog ();
+
+  /**
+   * \brief create the log file and start the writer thread.
+   * \param path the file, truncated if it exists
+   * \return false if the file cannot be created
+   */
+  bool Open (std::string path);
+
+  /**
+   * \brief write the events recorded so far and close the file.
+   *
+   * Called on dispose if the log is still open.
+   */
+  void Close ();
+
+  /**
+   * \brief whether the log is open.
+   * \return true if open
+   */
+  bool IsOpen () const;
+
+  /**
+   * \brief record the events of the mobility agents and of the tunnels of a node.
+   * \param node the node
+   */
+  void Connect (Ptr<Node> node);
+
+  /**
+   * \brief record the events of the mobility agents and of the tunnels of nodes.
+   * \param nodes the nodes
+   */
+  void Connect (NodeContainer nodes);
+
+  /**
+   * \brief record an event at the current time.
+   * \param record the event, its time is set
+   */
+  void Log (Record record);
+
+  /**
+   * \brief get the number of events recorded.
+   * \return the number of events
+   */
+  uint64_t GetNRecords () const;
+
+  /**
+   * \brief get the number of times the simulation waited for the writer.
+   * \return the number of stalls
+   */
+  uint64_t GetNStalls () const;
+
+  /**
+   * \brief read the records of a log file.
+   * \param path the file
+   * \param records the records read
+   * \return false if the file is not a log
+   */
+  static bool Read (std::string path, std::vector<Record> &records);
+
+  /**
+   * \brief write records as CSV, with a header line.
+   * \param records the records
+   * \param os the output
+   */
+  static void WriteCsv (const std::vector<Record> &records, std::ostream &os);
+
+  /**
+   * \brief write records by column, one raw array file per field.
+   *
+   * Each field goes to prefix.field, the addresses as 16 bytes each, and
+   * prefix.schema lists the fields, their type and the number of records.
+   * \param records the records
+   * \param prefix the path prefix of the files
+   * \return false if a file cannot be written
+   */
+  static bool WriteColumns (const std::vector<Record> &records, std::string prefix);
+
+  /**
+   * \brief get the name of an event type.
+   * \param type the EventType
+   * \return the name
+   */
+  static std::string GetTypeName (uint8_t type);
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /**
+   * \brief record a mobility message sent or received.
+   * \param node the node id
+   * \param sent whether the message is sent
+   * \param packet the message
+   * \param src the source address
+   * \param dst the destination address
+   */
+  void Message (uint32_t node, bool sent, Ptr<const Packet> packet, Ipv6Address src, Ipv6Address dst);
+
+  /**
+   * \brief record the start of a handover.
+   * \param node the node id
+   * \param oldCoa the CoA before the handover
+   * \param newCoa the CoA after the handover
+   */
+  void HandoverStart (uint32_t node, Ipv6Address oldCoa, Ipv6Address newCoa);
+
+  /**
+   * \brief record the end of a handover.
+   * \param node the node id
+   * \param interruption the interruption time
+   * \param predictive whether the handover was prepared
+   * \param oldCoa the CoA before the handover
+   * \param newCoa the CoA after the handover
+   */
+  void HandoverEnd (uint32_t node, Time interruption, bool predictive, Ipv6Address oldCoa, Ipv6Address newCoa);
+
+  /**
+   * \brief record a tunnel added or removed.
+   * \param node the node id
+   * \param type TUNNEL_ADD or TUNNEL_REMOVE
+   * \param remote the remote address of the tunnel
+   */
+  void Tunnel (uint32_t node, uint8_t type, Ipv6Address remote);
+
+  /**
+   * \brief sum an encapsulated packet.
+   * \param node the node id
+   * \param packet the encapsulated packet
+   * \param ih IPv6 inner header
+   * \param oh IPv6 outer header
+   */
+  void Encap (uint32_t node, Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh);
+
+  /**
+   * \brief record the encapsulated bytes summed since the last flush.
+   */
+  void FlushEncap ();
+
+  /**
+   * \brief body of the writer thread.
+   */
+  void Write ();
+
+  /**
+   * \brief copy records to the file.
+   * \param first index of the first record in the file
+   * \param records the records
+   * \param n the number of records
+   * \return false on a file error
+   */
+  bool WriteRecords (uint64_t first, const Record *records, uint64_t n);
+
+  /**
+   * \brief map the chunk of the file holding an offset.
+   * \param offset the offset in the file
+   * \return false on a file error
+   */
+  bool MapChunk (uint64_t offset);
+
+  /**
+   * \brief encapsulated bytes and packets, keyed by node and remote
+   */
+  typedef std::map<std::pair<uint32_t, Ipv6Address>, std::pair<uint64_t, uint32_t> > EncapSums;
+
+  uint32_t m_capacity;       //!< records in the ring
+  uint32_t m_segments;       //!< segments of the ring handed to the writer
+  uint64_t m_chunkSize;      //!< bytes of the file mapped at a time
+  Time m_encapInterval;      //!< period of the ENCAP records, 0 for one per packet
+
+  std::vector<Record> m_ring; //!< the ring
+  uint64_t m_written;        //!< records put in the ring
+  uint64_t m_flushedSeen;    //!< records known to be in the file, read without the lock
+  uint64_t m_stalls;         //!< waits for the writer
+
+  std::mutex m_mutex;        //!< protects the fields below
+  std::condition_variable m_readyCv;   //!< signals records to write
+  std::condition_variable m_flushedCv; //!< signals records written
+  uint64_t m_ready;          //!< records handed to the writer
+  uint64_t m_flushed;        //!< records in the file
+  bool m_stop;               //!< whether the writer ends once up to date
+  bool m_error;              //!< whether the writer hit a file error
+  std::thread m_writer;      //!< the writer thread
+
+  int m_fd;                  //!< the file
+  uint8_t *m_map;            //!< the mapped chunk
+  uint64_t m_mapOffset;      //!< file offset of the mapped chunk
+
+  EncapSums m_encapSums;     //!< encapsulation since the last flush
+  EventId m_encapEvent;      //!< next flush of the encapsulation
+};
+
+} /* namespace ns3 */
+
+#endif /* SR_EVENT_LOG_H */
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/packet.h"
 #include "sr-header.h"
 
 namespace ns3 {
@@ -120,10 +122,96 @@ void Mipv6Header::Serialize (Buffer::Iterator start) const
 }
 
 
+Mipv6OptionIterator::Mipv6OptionIterator (const uint8_t *data, uint32_t size, uint32_t offset)
+  : m_data (data),
+  m_size (size),
+  m_offset (offset),
+  m_next (offset),
+  m_malformed (false)
+{
+}
+
+bool Mipv6OptionIterator::Next ()
+{
+  while (m_next < m_size)
+    {
+      m_offset = m_next;
+      if (m_data[m_offset] == Mipv6Header::IPV6_MOBILITY_OPT_PAD1)
+        {
+          m_next++;
+          continue;
+        }
+      if (m_offset + 2 > m_size || m_offset + 2 + m_data[m_offset + 1] > m_size)
+        {
+          m_malformed = true;
+          m_next = m_size;
+          return false;
+        }
+      m_next = m_offset + 2 + m_data[m_offset + 1];
+      if (m_data[m_offset] != Mipv6Header::IPV6_MOBILITY_OPT_PADN)
+        {
+          return true;
+        }
+    }
+  m_offset = m_size;
+  return false;
+}
+
+bool Mipv6OptionIterator::Find (uint8_t type, Mipv6OptionHeader &option)
+{
+  while (Next ())
+    {
+      if (GetType () == type && Read (option))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool Mipv6OptionIterator::Read (Mipv6OptionHeader &option) const
+{
+  if (GetSize () != option.GetSerializedSize ())
+    {
+      return false;
+    }
+  //the iterator is only read from
+  option.Deserialize (Buffer::Iterator (const_cast<uint8_t *> (GetData ()), GetSize ()));
+  return true;
+}
+
+bool Mipv6OptionIterator::IsMalformed () const
+{
+  return m_malformed;
+}
+
+uint8_t Mipv6OptionIterator::GetType () const
+{
+  return m_data[m_offset];
+}
+
+uint32_t Mipv6OptionIterator::GetOffset () const
+{
+  return m_offset;
+}
+
+uint32_t Mipv6OptionIterator::GetSize () const
+{
+  return m_next - m_offset;
+}
+
+const uint8_t *Mipv6OptionIterator::GetData () const
+{
+  return m_data + m_offset;
+}
+
+
 Mipv6OptionField::Mipv6OptionField (uint32_t optionsOffset)
-  : m_optionData (0),
+  : m_size (0),
+  m_pad (0),
   m_optionsOffset (optionsOffset)
 {
+  m_pad = CalculatePad ((Mipv6OptionHeader::Alignment) {8,0});
 }
 
 Mipv6OptionField::~Mipv6OptionField ()
@@ -132,35 +220,35 @@ Mipv6OptionField::~Mipv6OptionField ()
 
 uint32_t Mipv6OptionField::GetSerializedSize () const
 {
-  return m_optionData.GetSize () + CalculatePad ((Mipv6OptionHeader::Alignment) {8,0});
+  return m_size + m_pad;
 }
 
 void Mipv6OptionField::Serialize (Buffer::Iterator start) const
 {
-  start.Write (m_optionData.Begin (), m_optionData.End ());
-  uint32_t fill = CalculatePad ((Mipv6OptionHeader::Alignment) {8,0});
+  start.Write (GetOptionData (), m_size);
 
-  NS_LOG_LOGIC ("fill with " << fill << " bytes padding");
-  switch (fill)
+  NS_LOG_LOGIC ("fill with " << m_pad << " bytes padding");
+  switch (m_pad)
     {
     case 0:
       return;
     case 1:
-      Ipv6MobilityOptionPad1Header ().Serialize (start);
+      start.WriteU8 (Mipv6Header::IPV6_MOBILITY_OPT_PAD1);
       return;
     default:
-      Ipv6MobilityOptionPadnHeader (fill).Serialize (start);
+      start.WriteU8 (Mipv6Header::IPV6_MOBILITY_OPT_PADN);
+      start.WriteU8 (m_pad - 2);
+      start.WriteU8 (0, m_pad - 2);
       return;
     }
 }
 
 uint32_t Mipv6OptionField::Deserialize (Buffer::Iterator start, uint32_t length)
 {
-  uint8_t buf[length];
-  start.Read (buf, length);
-  m_optionData = Buffer ();
-  m_optionData.AddAtEnd (length);
-  m_optionData.Begin ().Write (buf, length);
+  m_size = 0;
+  m_heap.clear ();
+  start.Read (Extend (length), length);
+  m_pad = CalculatePad ((Mipv6OptionHeader::Alignment) {8,0});
   return length;
 }
 
@@ -169,32 +257,50 @@ void Mipv6OptionField::AddOption (Mipv6OptionHeader const& option)
   NS_LOG_FUNCTION (this << option);
 
   uint32_t pad = CalculatePad (option.GetAlignment ());
-
-  
+  uint32_t size = option.GetSerializedSize ();
 
   NS_LOG_LOGIC ("need " << pad << " bytes padding");
+  uint8_t *data = Extend (pad + size);
   switch (pad)
     {
     case 0:
       break;       //no padding needed
     case 1:
-      AddOption (Ipv6MobilityOptionPad1Header ());
+      data[0] = Mipv6Header::IPV6_MOBILITY_OPT_PAD1;
       break;
     default:
-      AddOption (Ipv6MobilityOptionPadnHeader (pad));
+      data[0] = Mipv6Header::IPV6_MOBILITY_OPT_PADN;
+      data[1] = pad - 2;
+      std::fill (data + 2, data + pad, 0);
       break;
     }
 
-  m_optionData.AddAtEnd (option.GetSerializedSize ());
-  Buffer::Iterator it = m_optionData.End ();
-  it.Prev (option.GetSerializedSize ());
-  option.Serialize (it);
- 
+  option.Serialize (Buffer::Iterator (data + pad, size));
+  m_pad = CalculatePad ((Mipv6OptionHeader::Alignment) {8,0});
 }
 
 uint32_t Mipv6OptionField::CalculatePad (Mipv6OptionHeader::Alignment alignment) const
 {
-  return (alignment.offset - (m_optionData.GetSize () + m_optionsOffset)) % alignment.factor;
+  return (alignment.offset - (m_size + m_optionsOffset)) % alignment.factor;
+}
+
+uint8_t *Mipv6OptionField::Extend (uint32_t size)
+{
+  //header_len covers at most 256 units of 8 octets
+  NS_ASSERT_MSG (m_optionsOffset + m_size + size <= (256 << 3), "options overflow the mobility header");
+
+  uint32_t offset = m_size;
+  m_size += size;
+  if (m_heap.empty () && m_size <= INLINE_SIZE)
+    {
+      return m_inline + offset;
+    }
+  if (m_heap.empty ())
+    {
+      m_heap.assign (m_inline, m_inline + offset);
+    }
+  m_heap.resize (m_size);
+  return &m_heap[offset];
 }
 
 uint32_t Mipv6OptionField::GetOptionsOffset ()
@@ -204,7 +310,37 @@ uint32_t Mipv6OptionField::GetOptionsOffset ()
 
 Buffer Mipv6OptionField::GetOptionBuffer ()
 {
-  return m_optionData;
+  Buffer buffer;
+  buffer.AddAtStart (m_size);
+  buffer.Begin ().Write (GetOptionData (), m_size);
+  return buffer;
+}
+
+const uint8_t *Mipv6OptionField::GetOptionData () const
+{
+  return m_heap.empty () ? m_inline : &m_heap[0];
+}
+
+uint32_t Mipv6OptionField::GetOptionLength () const
+{
+  return m_size;
+}
+
+bool Mipv6OptionField::GetNextOption (uint8_t type, Mipv6OptionHeader &option, uint32_t &offset) const
+{
+  Mipv6OptionIterator it (GetOptionData (), m_size, offset);
+  if (it.Find (type, option))
+    {
+      offset = it.GetOffset () + it.GetSize ();
+      return true;
+    }
+  offset = m_size;
+  return false;
+}
+
+Mipv6OptionIterator Mipv6OptionField::GetOptions () const
+{
+  return Mipv6OptionIterator (GetOptionData (), m_size);
 }
 
 
@@ -334,7 +470,7 @@ void Ipv6MobilityBindingUpdateHeader::Print (std::ostream& os) const
 
 uint32_t Ipv6MobilityBindingUpdateHeader::GetSerializedSize () const
 {
-  return 12;
+  return 12 + Mipv6OptionField::GetSerializedSize ();
 }
 
 void Ipv6MobilityBindingUpdateHeader::Serialize (Buffer::Iterator start) const
@@ -379,6 +515,7 @@ void Ipv6MobilityBindingUpdateHeader::Serialize (Buffer::Iterator start) const
   i.WriteHtonU16 (reserved2);
   i.WriteHtonU16 (m_lifetime);
 
+  Mipv6OptionField::Serialize (i);
 }
 
 uint32_t Ipv6MobilityBindingUpdateHeader::Deserialize (Buffer::Iterator start)
@@ -429,7 +566,9 @@ uint32_t Ipv6MobilityBindingUpdateHeader::Deserialize (Buffer::Iterator start)
 
   m_lifetime = i.ReadNtohU16 ();
 
-  return GetSerializedSize ();
+  /* header_len covers the options and their padding */
+  uint32_t length = (GetHeaderLen () + 1) << 3;
+  return 12 + Mipv6OptionField::Deserialize (i, length > 12 ? length - 12 : 0);
 }
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityBindingAckHeader);
@@ -536,7 +675,7 @@ void Ipv6MobilityBindingAckHeader::Print (std::ostream& os) const
 
 uint32_t Ipv6MobilityBindingAckHeader::GetSerializedSize () const
 {
-  return 12;
+  return 12 + Mipv6OptionField::GetSerializedSize ();
 }
 
 void Ipv6MobilityBindingAckHeader::Serialize (Buffer::Iterator start) const
@@ -566,7 +705,7 @@ void Ipv6MobilityBindingAckHeader::Serialize (Buffer::Iterator start) const
   i.WriteHtonU16 (m_sequence);
   i.WriteHtonU16 (m_lifetime);
 
-
+  Mipv6OptionField::Serialize (i);
 }
 
 uint32_t Ipv6MobilityBindingAckHeader::Deserialize (Buffer::Iterator start)
@@ -596,7 +735,10 @@ uint32_t Ipv6MobilityBindingAckHeader::Deserialize (Buffer::Iterator start)
 
   m_sequence = i.ReadNtohU16 ();
   m_lifetime = i.ReadNtohU16 ();
-  return GetSerializedSize ();
+
+  /* header_len covers the options and their padding */
+  uint32_t length = (GetHeaderLen () + 1) << 3;
+  return 12 + Mipv6OptionField::Deserialize (i, length > 12 ? length - 12 : 0);
 }
 
 
@@ -1181,7 +1323,441 @@ uint32_t Ipv6BindingRefreshRequestHeader::Deserialize (Buffer::Iterator start)
 
 }
 
+/* options offset of each mobility header type, 0 for unknown types */
+static const uint8_t g_mhOptionsOffset[] = {
+  0,
+  16,   /* HoTI */
+  16,   /* CoTI */
+  24,   /* HoT */
+  24,   /* CoT */
+  12,   /* BU */
+  12,   /* BA */
+  8,    /* BRR */
+  24    /* BE */
+};
+
+/* type of the Home Address destination option */
+static const uint8_t g_homeAddressOption = 0xC9;
+
+const uint32_t Mipv6MessageView::MAX_SIZE;
+const uint32_t Mipv6MessageView::MAX_OPTIONS;
+const uint32_t Mipv6MessageView::EXTENSION_SIZE;
+
+Mipv6MessageView::Mipv6MessageView ()
+  : m_size (0),
+  m_copied (0),
+  m_optionsOffset (0),
+  m_nOptions (0)
+{
+}
+
+bool Mipv6MessageView::Parse (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  m_size = 0;
+  m_copied = 0;
+  m_optionsOffset = 0;
+  m_nOptions = 0;
+
+  uint32_t copied = packet->CopyData (m_data, std::min (packet->GetSize (), MAX_SIZE + EXTENSION_SIZE));
+  if (copied < 6)
+    {
+      NS_LOG_LOGIC ("Mobility header truncated");
+      return false;
+    }
+
+  uint32_t size = (m_data[1] + 1) << 3;
+  uint8_t mhType = m_data[2];
+  uint32_t optionsOffset = size;
+  if (mhType < sizeof (g_mhOptionsOffset) && g_mhOptionsOffset[mhType])
+    {
+      optionsOffset = g_mhOptionsOffset[mhType];
+    }
+  if (size > copied || optionsOffset > size)
+    {
+      NS_LOG_LOGIC ("Mobility header length " << size << " does not fit type " << (uint32_t)mhType);
+      return false;
+    }
+
+  Mipv6OptionIterator it (m_data + optionsOffset, size - optionsOffset);
+  while (it.Next ())
+    {
+      if (m_nOptions == MAX_OPTIONS)
+        {
+          NS_LOG_WARN ("Too many mobility options, option " << (uint32_t)it.GetType () << " ignored");
+        }
+      else
+        {
+          m_options[m_nOptions++] = optionsOffset + it.GetOffset ();
+        }
+    }
+  if (it.IsMalformed ())
+    {
+      NS_LOG_LOGIC ("Mobility option overflows the header");
+      m_nOptions = 0;
+      return false;
+    }
+
+  m_size = size;
+  m_copied = copied;
+  m_optionsOffset = optionsOffset;
+  return true;
+}
+
+uint16_t Mipv6MessageView::ReadU16 (uint32_t offset) const
+{
+  return (m_data[offset] << 8) | m_data[offset + 1];
+}
+
+uint16_t Mipv6MessageView::ReadLsbU16 (uint32_t offset) const
+{
+  return m_data[offset] | (m_data[offset + 1] << 8);
+}
+
+uint64_t Mipv6MessageView::ReadLsbU64 (uint32_t offset) const
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      value |= (uint64_t) m_data[offset + i] << (8 * i);
+    }
+  return value;
+}
+
+uint8_t Mipv6MessageView::GetPayloadProto () const
+{
+  return m_data[0];
+}
+
+uint8_t Mipv6MessageView::GetHeaderLen () const
+{
+  return m_data[1];
+}
+
+uint8_t Mipv6MessageView::GetMhType () const
+{
+  return m_data[2];
+}
+
+uint32_t Mipv6MessageView::GetSize () const
+{
+  return m_size;
+}
 
+const uint8_t *Mipv6MessageView::GetData () const
+{
+  return m_data;
+}
 
+uint16_t Mipv6MessageView::GetSequence () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+      return ReadU16 (6);
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+      return ReadU16 (8);
+    default:
+      return 0;
+    }
+}
+
+uint16_t Mipv6MessageView::GetLifetime () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+      return ReadU16 (10);
+    default:
+      return 0;
+    }
+}
+
+bool Mipv6MessageView::GetFlagA () const
+{
+  return GetMhType () == Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE && (ReadU16 (8) & (1 << 15));
+}
+
+bool Mipv6MessageView::GetFlagH () const
+{
+  return GetMhType () == Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE && (ReadU16 (8) & (1 << 14));
+}
+
+bool Mipv6MessageView::GetFlagL () const
+{
+  return GetMhType () == Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE && (ReadU16 (8) & (1 << 13));
+}
+
+bool Mipv6MessageView::GetFlagK () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+      return ReadU16 (8) & (1 << 12);
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+      return m_data[7] & (1 << 7);
+    default:
+      return false;
+    }
+}
+
+bool Mipv6MessageView::GetFlagR () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+      return ReadU16 (8) & (1 << 11);
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+      return m_data[7] & (1 << 6);
+    default:
+      return false;
+    }
+}
+
+uint8_t Mipv6MessageView::GetStatus () const
+{
+  return GetMhType () == Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT ? m_data[6] : 0;
+}
+
+uint64_t Mipv6MessageView::GetInitCookie () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::HOME_TEST_INIT:
+    case Mipv6Header::CARE_OF_TEST_INIT:
+    case Mipv6Header::HOME_TEST:
+    case Mipv6Header::CARE_OF_TEST:
+      return ReadLsbU64 (8);
+    default:
+      return 0;
+    }
+}
+
+uint16_t Mipv6MessageView::GetNonceIndex () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::HOME_TEST:
+    case Mipv6Header::CARE_OF_TEST:
+      return ReadLsbU16 (6);
+    default:
+      return 0;
+    }
+}
+
+uint64_t Mipv6MessageView::GetKeygenToken () const
+{
+  switch (GetMhType ())
+    {
+    case Mipv6Header::HOME_TEST:
+    case Mipv6Header::CARE_OF_TEST:
+      return ReadLsbU64 (16);
+    default:
+      return 0;
+    }
+}
+
+bool Mipv6MessageView::GetHomeAddress (Ipv6Address &hoa) const
+{
+  if (m_size == 0 || m_copied < m_size + 2)
+    {
+      return false;
+    }
+
+  const uint8_t *extension = m_data + m_size;
+  uint32_t available = m_copied - m_size;
+  switch (GetMhType ())
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+    case Mipv6Header::HOME_TEST_INIT:
+    case Mipv6Header::CARE_OF_TEST_INIT:
+      {
+        //destination options share the TLV encoding of the mobility options
+        Mipv6OptionIterator it (extension, std::min ((uint32_t)(extension[1] + 1) << 3, available), 2);
+        while (it.Next ())
+          {
+            if (it.GetType () == g_homeAddressOption && it.GetSize () == 18)
+              {
+                hoa = Ipv6Address::Deserialize (it.GetData () + 2);
+                return true;
+              }
+          }
+        return false;
+      }
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+    case Mipv6Header::HOME_TEST:
+    case Mipv6Header::CARE_OF_TEST:
+      //the header has a fixed size, its length field is not checked
+      if (available < EXTENSION_SIZE || extension[2] != 2)
+        {
+          return false;
+        }
+      hoa = Ipv6Address::Deserialize (extension + 8);
+      return true;
+    default:
+      return false;
+    }
+}
+
+uint32_t Mipv6MessageView::GetOptionsOffset () const
+{
+  return m_optionsOffset;
+}
+
+uint32_t Mipv6MessageView::GetNOptions () const
+{
+  return m_nOptions;
+}
+
+uint8_t Mipv6MessageView::GetOptionType (uint32_t i) const
+{
+  NS_ASSERT (i < m_nOptions);
+  return m_data[m_options[i]];
+}
+
+uint32_t Mipv6MessageView::GetOptionOffset (uint32_t i) const
+{
+  NS_ASSERT (i < m_nOptions);
+  return m_options[i];
+}
+
+uint32_t Mipv6MessageView::GetOptionSize (uint32_t i) const
+{
+  NS_ASSERT (i < m_nOptions);
+  return 2 + m_data[m_options[i] + 1];
+}
+
+uint32_t Mipv6MessageView::FindOption (uint8_t type) const
+{
+  for (uint32_t i = 0; i < m_nOptions; i++)
+    {
+      if (m_data[m_options[i]] == type)
+        {
+          return i;
+        }
+    }
+  return m_nOptions;
+}
+
+bool Mipv6MessageView::GetOption (uint8_t type, Mipv6OptionHeader &option) const
+{
+  Mipv6OptionIterator it = GetOptions ();
+  return it.Find (type, option);
+}
+
+Mipv6OptionIterator Mipv6MessageView::GetOptions () const
+{
+  return Mipv6OptionIterator (m_data + m_optionsOffset, m_size - m_optionsOffset);
+}
+
+Mipv6MessageTemplate::Mipv6MessageTemplate ()
+  : m_sequenceOffset (0),
+  m_lifetimeOffset (0),
+  m_authenticatorOffset (0),
+  m_size (0)
+{
+}
+
+bool Mipv6MessageTemplate::Set (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  Clear ();
+  if (packet->GetSize () < 12)
+    {
+      return false;
+    }
+
+  m_data.resize (packet->GetSize ());
+  packet->CopyData (&m_data[0], m_data.size ());
+
+  switch (m_data[2])
+    {
+    case Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE:
+      m_sequenceOffset = 6;
+      m_lifetimeOffset = 10;
+      break;
+    case Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT:
+      m_sequenceOffset = 8;
+      m_lifetimeOffset = 10;
+      break;
+    default:
+      NS_LOG_LOGIC ("Mobility header type " << (uint32_t)m_data[2] << " has no template");
+      m_data.clear ();
+      return false;
+    }
+
+  m_size = (m_data[1] + 1) << 3;
+  if (m_size > m_data.size ())
+    {
+      NS_LOG_LOGIC ("Mobility header truncated");
+      Clear ();
+      return false;
+    }
+  uint32_t optionsOffset = g_mhOptionsOffset[m_data[2]];
+  Mipv6OptionIterator it (&m_data[optionsOffset], m_size - optionsOffset);
+  while (it.Next ())
+    {
+      if (it.GetType () == Mipv6Header::IPV6_MOBILITY_OPT_BINDING_AUTHORIZATION_DATA && it.GetSize () == 10)
+        {
+          m_authenticatorOffset = optionsOffset + it.GetOffset () + 2;
+          break;
+        }
+    }
+  return true;
+}
+
+void Mipv6MessageTemplate::Clear ()
+{
+  m_data.clear ();
+  m_sequenceOffset = 0;
+  m_lifetimeOffset = 0;
+  m_authenticatorOffset = 0;
+  m_size = 0;
+}
+
+bool Mipv6MessageTemplate::IsSet () const
+{
+  return !m_data.empty ();
+}
+
+void Mipv6MessageTemplate::WriteU16 (uint32_t offset, uint16_t value)
+{
+  m_data[offset] = value >> 8;
+  m_data[offset + 1] = value & 0xff;
+}
+
+Ptr<Packet> Mipv6MessageTemplate::Build (uint16_t sequence, uint16_t lifetime)
+{
+  NS_LOG_FUNCTION (this << sequence << lifetime);
+  NS_ASSERT (IsSet ());
+
+  WriteU16 (m_sequenceOffset, sequence);
+  WriteU16 (m_lifetimeOffset, lifetime);
+  /* the mobility headers are sent with a zero checksum, nothing to update */
+  return Create<Packet> (&m_data[0], m_data.size ());
+}
+
+Ptr<Packet> Mipv6MessageTemplate::Build (uint16_t sequence, uint16_t lifetime, Callback<uint64_t, const uint8_t *, uint32_t> authenticate)
+{
+  NS_LOG_FUNCTION (this << sequence << lifetime);
+  NS_ASSERT (IsSet ());
+
+  WriteU16 (m_sequenceOffset, sequence);
+  WriteU16 (m_lifetimeOffset, lifetime);
+  if (m_authenticatorOffset)
+    {
+      /* hashed with the authenticator zeroed, then written LSB first as by Buffer::Iterator::WriteU64 */
+      std::fill_n (&m_data[m_authenticatorOffset], 8, 0);
+      uint64_t authenticator = authenticate (&m_data[0], m_size);
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          m_data[m_authenticatorOffset + i] = authenticator >> (8 * i);
+        }
+    }
+  return Create<Packet> (&m_data[0], m_data.size ());
+}
 
-} /* namespace ns3 */
\ No newline at end of file
+} /* namespace ns3 */
@@ -1,8 +1,11 @@
 #ifndef SR_HEADER_H
 #define SR_HEADER_H
 
+#include <vector>
+#include "ns3/callback.h"
 #include "ns3/header.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/ptr.h"
 #include "sr-option-header.h"
 
 
@@ -71,7 +74,8 @@ public:
     IPV6_MOBILITY_OPT_ALTERNATE_CARE_OF_ADDRESS,
     IPV6_MOBILITY_OPT_NONCE_INDICES,
     IPV6_MOBILITY_OPT_BINDING_AUTHORIZATION_DATA,
-    IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX  //NEMO
+    IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX,  //NEMO
+    IPV6_MOBILITY_OPT_BINDING_IDENTIFIER = 35  //multiple CoA registration, RFC 5648
 
   };
   /**
@@ -209,6 +213,106 @@ private:
 
 };
 
+/**
+ * \class Mipv6OptionIterator
+ * \brief Walk over serialized option TLVs, the padding skipped.
+ *
+ * Shared by the option field of the mobility headers and by the messages
+ * parsed on reception, so the options are walked and checked in one place.
+ * The TLVs of a destination options header share the encoding, Pad1 and
+ * PadN included. The walk stops on an option overflowing the bytes.
+ */
+class Mipv6OptionIterator
+{
+public:
+  /**
+   * \brief constructor, before the first option.
+   * \param data the first byte of the options
+   * \param size the length of the options
+   * \param offset where to start the walk
+   */
+  Mipv6OptionIterator (const uint8_t *data, uint32_t size, uint32_t offset = 0);
+
+  /**
+   * \brief move to the next option.
+   * \return false past the last option or on a malformed one
+   */
+  bool Next ();
+
+  /**
+   * \brief move to the next option of a type and deserialize it.
+   *
+   * An option whose length does not match the header is skipped.
+   * \param type the option type
+   * \param option the option header to fill
+   * \return false if there is no more such option
+   */
+  bool Find (uint8_t type, Mipv6OptionHeader &option);
+
+  /**
+   * \brief deserialize the current option.
+   * \param option the option header to fill
+   * \return false if the length of the option does not match the header
+   */
+  bool Read (Mipv6OptionHeader &option) const;
+
+  /**
+   * \brief whether the walk stopped on an option overflowing the bytes.
+   * \return true if the options are malformed
+   */
+  bool IsMalformed () const;
+
+  /**
+   * \brief Get the type of the current option.
+   * \return the option type
+   */
+  uint8_t GetType () const;
+
+  /**
+   * \brief Get the offset of the current option.
+   * \return offset of the type byte from the start of the options
+   */
+  uint32_t GetOffset () const;
+
+  /**
+   * \brief Get the size of the current option.
+   * \return size of the option, type and length bytes included
+   */
+  uint32_t GetSize () const;
+
+  /**
+   * \brief Get the data of the current option.
+   * \return the type byte of the option, GetSize () bytes long
+   */
+  const uint8_t *GetData () const;
+
+private:
+  /**
+   * \brief the options
+   */
+  const uint8_t *m_data;
+
+  /**
+   * \brief length of the options
+   */
+  uint32_t m_size;
+
+  /**
+   * \brief offset of the current option
+   */
+  uint32_t m_offset;
+
+  /**
+   * \brief offset past the current option
+   */
+  uint32_t m_next;
+
+  /**
+   * \brief whether an option overflows the bytes
+   */
+  bool m_malformed;
+};
+
 /**
  * \brief Option field for an IPv6MobilityHeader
  * Enables adding options to an IPv6MobilityHeader
@@ -216,10 +320,21 @@ private:
  * MobilityOptionField::GetSerializedSize () to your IPv6MobilityHeader::GetSerializedSize ()
  * return value. Call MobilityOptionField::Serialize and MobilityOptionField::Deserialize at the
  * end of your corresponding IPv6MobilityHeader methods.
+ *
+ * The options are kept serialized in a flat array, inside the field up to
+ * INLINE_SIZE bytes so that the BUs and BAs of a few options do not allocate.
+ * The alignment padding is written when an option is added and the padding of
+ * the end of the field is computed there too, so GetSerializedSize is a
+ * read of a cached size.
  */
 class Mipv6OptionField
 {
 public:
+  /**
+   * \brief bytes of options stored without allocation
+   */
+  static const uint32_t INLINE_SIZE = 64;
+
   /**
    * \brief Constructor.
    * \param optionsOffset option offset
@@ -270,6 +385,36 @@ public:
    */
   Buffer GetOptionBuffer ();
 
+  /**
+   * \brief Get the serialized options.
+   * \return the first byte of the options, GetOptionLength () bytes long
+   */
+  const uint8_t *GetOptionData () const;
+
+  /**
+   * \brief Get the length of the serialized options.
+   * \return the length, the padding of the end excluded
+   */
+  uint32_t GetOptionLength () const;
+
+  /**
+   * \brief Deserialize the next option of a type.
+   *
+   * An option whose length does not match the header is skipped, the walk
+   * stops on an option overflowing the field.
+   * \param type the option type
+   * \param option the option header to fill
+   * \param offset where to search from, set past the option found
+   * \return false if there is no more such option
+   */
+  bool GetNextOption (uint8_t type, Mipv6OptionHeader &option, uint32_t &offset) const;
+
+  /**
+   * \brief Get an iterator over the options.
+   * \return the iterator, before the first option
+   */
+  Mipv6OptionIterator GetOptions () const;
+
 private:
 
   /**
@@ -280,9 +425,31 @@ private:
   uint32_t CalculatePad (Mipv6OptionHeader::Alignment alignment) const;
 
   /**
-   * \brief Data payload.
+   * \brief extend the options, moving them to the heap past INLINE_SIZE.
+   * \param size bytes to add
+   * \return the first byte added
    */
-  Buffer m_optionData;
+  uint8_t *Extend (uint32_t size);
+
+  /**
+   * \brief options while they fit in INLINE_SIZE bytes
+   */
+  uint8_t m_inline[INLINE_SIZE];
+
+  /**
+   * \brief options once larger than INLINE_SIZE bytes, empty before
+   */
+  std::vector<uint8_t> m_heap;
+
+  /**
+   * \brief length of the options
+   */
+  uint32_t m_size;
+
+  /**
+   * \brief padding of the end of the options to 8 octets
+   */
+  uint32_t m_pad;
 
   /**
    * \brief Offset.
@@ -1182,9 +1349,348 @@ private:
 
 };
 
+class Packet;
+
+/**
+ * \class Mipv6MessageView
+ * \brief Mobility header parsed once on reception.
+ *
+ * The bytes of the mobility header are copied once out of the packet, then
+ * the fixed fields and the option TLVs are read in place. The demux, the
+ * mobility and the agent share the view instead of copying the packet and
+ * deserializing the header at each step.
+ */
+class Mipv6MessageView
+{
+public:
+  /**
+   * \brief largest mobility header, header_len is 8 bits of 8 octets
+   */
+  static const uint32_t MAX_SIZE = 256 << 3;
+
+  /**
+   * \brief options indexed per message, padding excluded
+   */
+  static const uint32_t MAX_OPTIONS = 32;
+
+  /**
+   * \brief size of the extension header carrying the home address after the message
+   */
+  static const uint32_t EXTENSION_SIZE = 24;
+
+  /**
+   * \brief constructor.
+   */
+  Mipv6MessageView ();
 
+  /**
+   * \brief parse the mobility header at the start of a packet.
+   * \param packet the packet, left untouched
+   * \return false if the header is truncated or its options are malformed
+   */
+  bool Parse (Ptr<const Packet> packet);
 
+  /**
+   * \brief Get the payload proto field.
+   * \return payload proto
+   */
+  uint8_t GetPayloadProto () const;
+
+  /**
+   * \brief Get the header len field.
+   * \return the unit of 8 octets
+   */
+  uint8_t GetHeaderLen () const;
+
+  /**
+   * \brief Get the mh type field.
+   * \return the mh type
+   */
+  uint8_t GetMhType () const;
+
+  /**
+   * \brief Get the length of the mobility header.
+   * \return bytes covered by header_len
+   */
+  uint32_t GetSize () const;
+
+  /**
+   * \brief Get the bytes of the mobility header.
+   * \return the first byte, GetSize () bytes long
+   */
+  const uint8_t *GetData () const;
+
+  /**
+   * \brief Get the sequence of a BU or a BA.
+   * \return the sequence, 0 for other messages
+   */
+  uint16_t GetSequence () const;
+
+  /**
+   * \brief Get the lifetime of a BU or a BA.
+   * \return the lifetime in units of 4 seconds, 0 for other messages
+   */
+  uint16_t GetLifetime () const;
+
+  /**
+   * \brief Get the A flag of a BU.
+   * \return the A flag
+   */
+  bool GetFlagA () const;
 
+  /**
+   * \brief Get the H flag of a BU.
+   * \return the H flag
+   */
+  bool GetFlagH () const;
+
+  /**
+   * \brief Get the L flag of a BU.
+   * \return the L flag
+   */
+  bool GetFlagL () const;
+
+  /**
+   * \brief Get the K flag of a BU or a BA.
+   * \return the K flag
+   */
+  bool GetFlagK () const;
+
+  /**
+   * \brief Get the R flag (NEMO) of a BU or a BA.
+   * \return the R flag
+   */
+  bool GetFlagR () const;
+
+  /**
+   * \brief Get the status of a BA.
+   * \return the status, 0 for other messages
+   */
+  uint8_t GetStatus () const;
+
+  /**
+   * \brief Get the init cookie of a HoTI, a CoTI, a HoT or a CoT.
+   * \return the cookie, 0 for other messages
+   */
+  uint64_t GetInitCookie () const;
+
+  /**
+   * \brief Get the nonce index of a HoT or a CoT.
+   * \return the nonce index, 0 for other messages
+   */
+  uint16_t GetNonceIndex () const;
+
+  /**
+   * \brief Get the keygen token of a HoT or a CoT.
+   * \return the keygen token, 0 for other messages
+   */
+  uint64_t GetKeygenToken () const;
+
+  /**
+   * \brief Get the home address in the extension header following the message.
+   *
+   * A BU, a HoTI or a CoTI carries it in a Home Address destination option,
+   * a BA, a HoT or a CoT in a type 2 routing header.
+   * \param hoa the home address to fill
+   * \return false if the message carries no home address
+   */
+  bool GetHomeAddress (Ipv6Address &hoa) const;
+
+  /**
+   * \brief Get the offset of the options.
+   * \return options offset from the start of the header
+   */
+  uint32_t GetOptionsOffset () const;
+
+  /**
+   * \brief Get the number of options, padding excluded.
+   * \return number of options
+   */
+  uint32_t GetNOptions () const;
+
+  /**
+   * \brief Get the type of an option.
+   * \param i option index
+   * \return the option type
+   */
+  uint8_t GetOptionType (uint32_t i) const;
+
+  /**
+   * \brief Get the offset of an option.
+   * \param i option index
+   * \return offset of the type byte from the start of the header
+   */
+  uint32_t GetOptionOffset (uint32_t i) const;
+
+  /**
+   * \brief Get the size of an option.
+   * \param i option index
+   * \return size of the option, type and length bytes included
+   */
+  uint32_t GetOptionSize (uint32_t i) const;
+
+  /**
+   * \brief Find the first option of a type.
+   * \param type the option type
+   * \return the option index, GetNOptions () if not found
+   */
+  uint32_t FindOption (uint8_t type) const;
+
+  /**
+   * \brief Deserialize the first option of a type.
+   * \param type the option type
+   * \param option the option header to fill
+   * \return false if the message has no such option
+   */
+  bool GetOption (uint8_t type, Mipv6OptionHeader &option) const;
+
+  /**
+   * \brief Get an iterator over the options.
+   * \return the iterator, before the first option
+   */
+  Mipv6OptionIterator GetOptions () const;
+
+private:
+  /**
+   * \brief read a 16 bits field.
+   * \param offset offset of the field
+   * \return the field in host order
+   */
+  uint16_t ReadU16 (uint32_t offset) const;
+
+  /**
+   * \brief read a field written LSB first by Buffer::Iterator::WriteU16.
+   * \param offset offset of the field
+   * \return the field
+   */
+  uint16_t ReadLsbU16 (uint32_t offset) const;
+
+  /**
+   * \brief read a field written LSB first by Buffer::Iterator::WriteU64.
+   * \param offset offset of the field
+   * \return the field
+   */
+  uint64_t ReadLsbU64 (uint32_t offset) const;
+
+  /**
+   * \brief bytes of the mobility header and of the extension header following it
+   */
+  uint8_t m_data[MAX_SIZE + EXTENSION_SIZE];
+
+  /**
+   * \brief length of the mobility header
+   */
+  uint32_t m_size;
+
+  /**
+   * \brief bytes copied out of the packet
+   */
+  uint32_t m_copied;
+
+  /**
+   * \brief options offset of the message type
+   */
+  uint32_t m_optionsOffset;
+
+  /**
+   * \brief number of options
+   */
+  uint32_t m_nOptions;
+
+  /**
+   * \brief offset of each option
+   */
+  uint16_t m_options[MAX_OPTIONS];
+};
+
+/**
+ * \class Mipv6MessageTemplate
+ * \brief Serialized BU or BA, patched in place for each refresh.
+ *
+ * A refresh only changes the sequence and the lifetime of the message, so
+ * the bytes of the first one are kept, with the extension header following
+ * the mobility header, and the two fields are rewritten before each send
+ * instead of building and serializing the headers and options again.
+ */
+class Mipv6MessageTemplate
+{
+public:
+  /**
+   * \brief constructor.
+   */
+  Mipv6MessageTemplate ();
+
+  /**
+   * \brief keep the bytes of a message.
+   * \param packet the packet, starting with a BU or a BA, left untouched
+   * \return false if the packet does not start with a BU or a BA
+   */
+  bool Set (Ptr<const Packet> packet);
+
+  /**
+   * \brief drop the message.
+   */
+  void Clear ();
+
+  /**
+   * \brief whether a message is kept.
+   * \return true if Set succeeded since the last Clear
+   */
+  bool IsSet () const;
+
+  /**
+   * \brief patch the message and copy it in a new packet.
+   * \param sequence the sequence
+   * \param lifetime the lifetime in units of 4 seconds
+   * \return the packet
+   */
+  Ptr<Packet> Build (uint16_t sequence, uint16_t lifetime);
+
+  /**
+   * \brief patch the message, authenticate it and copy it in a new packet.
+   *
+   * The authenticator covers the sequence and the lifetime, it is computed
+   * again after they are patched.
+   * \param sequence the sequence
+   * \param lifetime the lifetime in units of 4 seconds
+   * \param authenticate computes the authenticator of the bytes of the mobility header
+   * \return the packet
+   */
+  Ptr<Packet> Build (uint16_t sequence, uint16_t lifetime, Callback<uint64_t, const uint8_t *, uint32_t> authenticate);
+
+private:
+  /**
+   * \brief write a 16 bits field.
+   * \param offset offset of the field
+   * \param value the field in host order
+   */
+  void WriteU16 (uint32_t offset, uint16_t value);
+
+  /**
+   * \brief bytes of the message
+   */
+  std::vector<uint8_t> m_data;
+
+  /**
+   * \brief offset of the sequence
+   */
+  uint32_t m_sequenceOffset;
+
+  /**
+   * \brief offset of the lifetime
+   */
+  uint32_t m_lifetimeOffset;
+
+  /**
+   * \brief offset of the authenticator, 0 if the message has none
+   */
+  uint32_t m_authenticatorOffset;
+
+  /**
+   * \brief length of the mobility header
+   */
+  uint32_t m_size;
+};
 
 } /* namespace ns3 */
 
@@ -73,13 +73,13 @@ void Mipv6L4Protocol::DoDispose ()
 void Mipv6L4Protocol::NotifyNewAggregate ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_node)
+  if (!m_node)
     {
       Ptr<Node> node = this->GetObject<Node> ();
-      if (!node)
+      if (node)
         {
           Ptr<Ipv6L3Protocol> ipv6 = this->GetObject<Ipv6L3Protocol> ();
-          if (!ipv6)
+          if (ipv6)
             {
               this->SetNode (node);
               ipv6->Insert (this);
@@ -128,54 +128,35 @@ void Mipv6L4Protocol::SendMessage (Ptr<Packet> packet, Ipv6Address src, Ipv6Addr
 enum IpL4Protocol::RxStatus Mipv6L4Protocol::Receive (Ptr<Packet> packet, Ipv6Address const &src, Ipv6Address const &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << packet << src << dst << interface << "VANCH");
-  Ptr<Packet> p = packet->Copy ();
-  Ptr<Mipv6Demux> ipv6MobilityDemux = GetObject<Mipv6Demux>();
-  Ptr<Mipv6Mobility> ipv6Mobility = 0;
-  Mipv6Header mh;
+  Mipv6MessageView view;
 
-  p->PeekHeader (mh);
+  if (!view.Parse (packet))
+    {
+      NS_LOG_FUNCTION ( "Malformed Mobility Packet" );
+      return IpL4Protocol::RX_OK;
+    }
 
-  ipv6Mobility = ipv6MobilityDemux->GetMobility ( mh.GetMhType () );
+  Ptr<Mipv6Mobility> ipv6Mobility = GetObject<Mipv6Demux> ()->GetMobility (view.GetMhType ());
 
   if (ipv6Mobility)
     {
-      ipv6Mobility->Process (p, src, dst, interface);
+      ipv6Mobility->Process (packet, view, src, dst, interface);
     }
   else
     {
-      NS_LOG_FUNCTION ( "Mobility Packet with Unknown MhType (" << (uint32_t)mh.GetMhType () << ")" );
+      NS_LOG_FUNCTION ( "Mobility Packet with Unknown MhType (" << (uint32_t)view.GetMhType () << ")" );
     }
 
   return IpL4Protocol::RX_OK;
 }
-
 enum IpL4Protocol::RxStatus Mipv6L4Protocol::Receive (Ptr<Packet> p, Ipv6Header const &header, Ptr<Ipv6Interface> incomingInterface)
 {
 
   NS_LOG_FUNCTION (this << p << header << incomingInterface << "VAMCH");
-  Ptr<Packet> packet = p->Copy ();
-  Ptr<Mipv6Demux> ipv6MobilityDemux = GetObject<Mipv6Demux>();
-  Ptr<Mipv6Mobility> ipv6Mobility = 0;
-  Mipv6Header mh;
 
-  packet->PeekHeader (mh);
-  ipv6Mobility = ipv6MobilityDemux->GetMobility ( mh.GetMhType () );
-  if (ipv6Mobility)
-    {
-      Ipv6Address src = header.GetSource ();
-      Ipv6Address dst = header.GetDestination ();
-
-      ipv6Mobility->Process (packet, src, dst, incomingInterface);
-    }
-  else
-    {
-      NS_LOG_FUNCTION ( "Mobility Packet with Unknown MhType (" << (uint32_t)mh.GetMhType () << ")" );
-    }
-
-  return IpL4Protocol::RX_OK;
+  return Receive (p, header.GetSource (), header.GetDestination (), incomingInterface);
 
 }
-
 enum IpL4Protocol::RxStatus Mipv6L4Protocol::Receive (Ptr<Packet> p, Ipv4Header const &header, Ptr<Ipv4Interface> incomingInterface)
 {
 
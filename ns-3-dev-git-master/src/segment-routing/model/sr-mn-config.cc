@@ -0,0 +1,69 @@
+#include <algorithm>
+#include "ns3/log.h"
+#include "sr-mn-config.h"
+
+NS_LOG_COMPONENT_DEFINE ("Mipv6MnConfig");
+
+namespace ns3 {
+
+Mipv6MnConfig::Mipv6MnConfig (const std::list<Ipv6Address> &haalist, const std::list<Ipv6Address> &aralist,
+                              bool mobileRouter, Ipv6Address mnp)
+  : m_haalist (haalist),
+  m_aralist (aralist),
+  m_mobileRouter (mobileRouter),
+  m_mnps (mnp.IsAny () ? std::list<Ipv6Address> () : std::list<Ipv6Address> (1, mnp))
+{
+  NS_LOG_FUNCTION (this << mobileRouter << mnp);
+}
+
+Mipv6MnConfig::Mipv6MnConfig (const std::list<Ipv6Address> &haalist, const std::list<Ipv6Address> &aralist,
+                              const std::list<Ipv6Address> &mnps)
+  : m_haalist (haalist),
+  m_aralist (aralist),
+  m_mobileRouter (true),
+  m_mnps (mnps)
+{
+  NS_LOG_FUNCTION (this << mnps.size ());
+}
+
+const std::list<Ipv6Address> &Mipv6MnConfig::GetHomeAgentList () const
+{
+  return m_haalist;
+}
+
+const std::list<Ipv6Address> &Mipv6MnConfig::GetAccessRouterList () const
+{
+  return m_aralist;
+}
+
+bool Mipv6MnConfig::IsMobileRouter () const
+{
+  return m_mobileRouter;
+}
+
+Ipv6Address Mipv6MnConfig::GetMobileNetworkPrefix () const
+{
+  return m_mnps.empty () ? Ipv6Address::GetAny () : m_mnps.front ();
+}
+
+const std::list<Ipv6Address> &Mipv6MnConfig::GetMobileNetworkPrefixes () const
+{
+  return m_mnps;
+}
+
+bool Mipv6MnConfig::IsHomeAgent (Ipv6Address addr) const
+{
+  return std::find (m_haalist.begin (), m_haalist.end (), addr) != m_haalist.end ();
+}
+
+Ptr<const Mipv6MnConfig> Mipv6MnConfig::WithHomeAgentList (const std::list<Ipv6Address> &haalist) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_mobileRouter && m_mnps.size () > 1)
+    {
+      return Create<Mipv6MnConfig> (haalist, m_aralist, m_mnps);
+    }
+  return Create<Mipv6MnConfig> (haalist, m_aralist, m_mobileRouter, GetMobileNetworkPrefix ());
+}
+
+} /* namespace ns3 */
@@ -0,0 +1,110 @@
+#ifndef SR_MN_CONFIG_H
+#define SR_MN_CONFIG_H
+
+#include <list>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/ipv6-address.h"
+
+namespace ns3 {
+
+/**
+ * \class Mipv6MnConfig
+ * \brief Immutable configuration of a mobile node or mobile router.
+ *
+ * The home agent list, the AR list and the mobile network prefixes are set
+ * once, then shared by reference between the MN agent and its binding update
+ * list, and between all the MNs installed by a helper. A change builds a new
+ * configuration instead of modifying the shared one.
+ */
+class Mipv6MnConfig : public SimpleRefCount<Mipv6MnConfig>
+{
+public:
+  /**
+   * \brief constructor.
+   * \param haalist home agent address list
+   * \param aralist AR router address list
+   * \param mobileRouter true for a mobile router (NEMO), false for a host
+   * \param mnp mobile network prefix (NEMO)
+   */
+  Mipv6MnConfig (const std::list<Ipv6Address> &haalist, const std::list<Ipv6Address> &aralist,
+                 bool mobileRouter, Ipv6Address mnp);
+
+  /**
+   * \brief constructor of a mobile router with several mobile network prefixes.
+   * \param haalist home agent address list
+   * \param aralist AR router address list
+   * \param mnps the /64 mobile network prefixes, registered in one BU (NEMO)
+   */
+  Mipv6MnConfig (const std::list<Ipv6Address> &haalist, const std::list<Ipv6Address> &aralist,
+                 const std::list<Ipv6Address> &mnps);
+
+  /**
+   * \brief get the home agent address list.
+   * \return home agent address list
+   */
+  const std::list<Ipv6Address> &GetHomeAgentList () const;
+
+  /**
+   * \brief get the AR router address list.
+   * \return AR router address list
+   */
+  const std::list<Ipv6Address> &GetAccessRouterList () const;
+
+  /**
+   * \brief whether the MN is a mobile router.
+   * \return true for a mobile router (NEMO)
+   */
+  bool IsMobileRouter () const;
+
+  /**
+   * \brief get the mobile network prefix.
+   * \return mobile network prefix (NEMO)
+   */
+  Ipv6Address GetMobileNetworkPrefix () const;
+
+  /**
+   * \brief get all the mobile network prefixes.
+   * \return the mobile network prefixes, the first one is GetMobileNetworkPrefix (NEMO)
+   */
+  const std::list<Ipv6Address> &GetMobileNetworkPrefixes () const;
+
+  /**
+   * \brief whether an address is one of the home agents.
+   * \param addr the address
+   * \return true if addr is in the home agent list
+   */
+  bool IsHomeAgent (Ipv6Address addr) const;
+
+  /**
+   * \brief build a configuration with another home agent list.
+   * \param haalist home agent address list
+   * \return the new configuration
+   */
+  Ptr<const Mipv6MnConfig> WithHomeAgentList (const std::list<Ipv6Address> &haalist) const;
+
+private:
+  /**
+   * \brief home agent address list.
+   */
+  const std::list<Ipv6Address> m_haalist;
+
+  /**
+   * \brief AR router address list.
+   */
+  const std::list<Ipv6Address> m_aralist;
+
+  /**
+   * \brief flag for MN as router or host (NEMO).
+   */
+  const bool m_mobileRouter;
+
+  /**
+   * \brief mobile network prefixes (NEMO).
+   */
+  const std::list<Ipv6Address> m_mnps;
+};
+
+} /* namespace ns3 */
+
+#endif /* SR_MN_CONFIG_H */
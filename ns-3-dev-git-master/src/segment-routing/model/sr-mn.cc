@@ -19,9 +19,13 @@
 #include "sr-l4-protocol.h"
 #include "sr-mn.h"
 #include "sr-tun-l4-protocol.h"
+#include "sr-routing.h"
+#include "cn.h"
 #include "ns3/udp-l4-protocol.h"
 #include "ns3/tcp-l4-protocol.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/radvd-prefix.h"
 #include "ns3/radvd.h"
@@ -46,6 +50,23 @@ Mipv6Mn::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&Mipv6Mn::m_buinf),
                    MakePointerChecker<BList> ())
+    .AddAttribute ("PredictiveHandover",
+                   "Prepare the handover to a strong AR when the serving AR weakens, "
+                   "and switch to it on attachment without waiting for the BA.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Mipv6Mn::m_predictive),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MultiHoming",
+                   "Register the CoAs on the links of several ARs together, the HA "
+                   "spreads the flows over them by the signal and the load of the ARs.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Mipv6Mn::m_multiHoming),
+                   MakeBooleanChecker ())
+    .AddAttribute ("NetworkMonitor",
+                   "The monitor of the cells of the ARs, steering the MN away from the congested ones.",
+                   PointerValue (),
+                   MakePointerAccessor (&Mipv6Mn::m_monitor),
+                   MakePointerChecker<NetworkMonitor> ())
     .AddTraceSource ("RxBA",
                      "Received BA packet from HA",
                      MakeTraceSourceAccessor (&Mipv6Mn::m_rxbaTrace),
@@ -54,6 +75,14 @@ Mipv6Mn::GetTypeId (void)
                      "Sent BU packet from MN",
                      MakeTraceSourceAccessor (&Mipv6Mn::m_txbuTrace),
                      "ns3::Mipv6Mn::TxBuTracedCallback")
+    .AddTraceSource ("Handover",
+                     "Interruption time of a handover, once the MN has a registered path again",
+                     MakeTraceSourceAccessor (&Mipv6Mn::m_handoverTrace),
+                     "ns3::Mipv6Mn::HandoverTracedCallback")
+    .AddTraceSource ("HandoverStart",
+                     "A handover starts, on the attachment to the new AR",
+                     MakeTraceSourceAccessor (&Mipv6Mn::m_handoverStartTrace),
+                     "ns3::Mipv6Mn::HandoverStartTracedCallback")
 
 
     ;
@@ -62,22 +91,71 @@ Mipv6Mn::GetTypeId (void)
 
 Mipv6Mn::Mipv6Mn (std::list<Ipv6Address> haalist,bool RorH,Ipv6Address mnp, std::list<Ipv6Address> aralist)      //adding last2 arg
 {
-  m_Haalist = haalist;
-  m_Aralist = aralist;
+  m_config = Create<Mipv6MnConfig> (haalist, aralist, RorH, mnp);
   m_hsequence = 0;
   m_cnsequence = 0;
   m_roflag = false;
+  m_predictive = false;
+  m_multiHoming = false;
+  m_linkLost = false;
+  m_handoverPending = false;
   
   m_mnflag=RorH; //NEMO
   m_mnp=mnp;   //NEMO
+  m_mnps = m_config->GetMobileNetworkPrefixes ();
   
 }
 
+Mipv6Mn::Mipv6Mn (Ptr<const Mipv6MnConfig> config)
+  : m_config (config)
+{
+  NS_ASSERT (config);
+  m_hsequence = 0;
+  m_cnsequence = 0;
+  m_roflag = false;
+  m_predictive = false;
+  m_multiHoming = false;
+  m_linkLost = false;
+  m_handoverPending = false;
+
+  m_mnflag = config->IsMobileRouter ();
+  m_mnp = config->GetMobileNetworkPrefix ();
+  m_mnps = config->GetMobileNetworkPrefixes ();
+}
+
+Ptr<const Mipv6MnConfig> Mipv6Mn::GetConfig () const
+{
+  return m_config;
+}
+
 Mipv6Mn::~Mipv6Mn ()
 {
   delete this;
 }
 
+void Mipv6Mn::DoInitialize ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (IsTimingWheelEnabled () && m_buinf)
+    {
+      m_buinf->SetTimingWheel (TimingWheel::GetTimingWheel (GetNode ()));
+    }
+  //the tunnel to the HA is set up when its BA is received
+  if (!IsSegmentRoutingEnabled ())
+    {
+      GetNode ()->GetObject<Ipv6TunnelL4Protocol> ()->CreateTunnelDevice ();
+    }
+  if (m_monitor)
+    {
+      for (std::vector<Ptr<CList> >::const_iterator it = m_candidates.begin (); it != m_candidates.end (); it++)
+        {
+          m_monitor->Subscribe (*it);
+        }
+    }
+  Mipv6Agent::DoInitialize ();
+}
+
 void Mipv6Mn::NotifyNewAggregate ()
 {
   NS_LOG_FUNCTION (this);
@@ -89,9 +167,18 @@ void Mipv6Mn::NotifyNewAggregate ()
     {
       Ptr<Node> node = this->GetObject<Node> ();
       SetNode (node);
-      m_buinf = CreateObject<BList> (m_Haalist, m_Aralist);
+      m_buinf = CreateObject<BList> (m_config);
       m_buinf->SetNode (node);
 
+      const std::list<Ipv6Address> &aralist = m_config->GetAccessRouterList ();
+      for (std::list<Ipv6Address>::const_iterator it = aralist.begin (); it != aralist.end (); it++)
+        {
+          Ptr<CList> candidate = CreateObject<CList> (*it);
+          candidate->SetNode (node);
+          candidate->SetSignalChangeCallback (MakeCallback (&Mipv6Mn::HandleSignalChange, this));
+          m_candidates.push_back (candidate);
+        }
+
 
       //Fetch any link-local address of the node
       Ptr<Ipv6> ip = GetNode ()->GetObject<Ipv6> ();
@@ -100,9 +187,10 @@ void Mipv6Mn::NotifyNewAggregate ()
 
 //Set HAA and Forming HoA from HAA Prefix
 
-      if (m_Haalist.size ())
+      const std::list<Ipv6Address> &haalist = m_config->GetHomeAgentList ();
+      if (haalist.size ())
         {
-          m_buinf->SetHA (m_Haalist.front ()); // The first address
+          m_buinf->SetHA (haalist.front ()); // The first address
           (m_buinf->GetHA ()).GetBytes (buf1); //Fetching Prefix
           (ads.GetAddress ()).GetBytes (buf2); //Fetching interface identifier
           for (i = 0; i < 8; i++)
@@ -144,7 +232,7 @@ void Mipv6Mn::NotifyNewAggregate ()
       tcpl4->SetMipv6Callback (MakeCallback (&BList::GetHoa, m_buinf));
 
       Ptr<Ipv6TunnelL4Protocol> tunnell4 = GetNode ()->GetObject<Ipv6TunnelL4Protocol> ();
-      tunnell4->SetCacheAddressList (m_Haalist);
+      tunnell4->SetCacheAddressList (m_config->GetHomeAgentList ());
       tunnell4->SetHA (m_buinf->GetHA ());
     }
   Mipv6Agent::NotifyNewAggregate ();
@@ -166,8 +254,23 @@ uint16_t Mipv6Mn::GetCNBUSequence ()
 }
 
 
+void Mipv6Mn::ClearStaleTemplates ()
+{
+  if (m_templateHoa != m_buinf->GetHoa ())
+    {
+      m_homeBUTemplate.Clear ();
+      m_cnBUTemplate.Clear ();
+      m_templateHoa = m_buinf->GetHoa ();
+    }
+}
+
 Ptr<Packet> Mipv6Mn::BuildHomeBU ()
 {
+  ClearStaleTemplates ();
+  if (m_homeBUTemplate.IsSet ())
+    {
+      return m_homeBUTemplate.Build (m_buinf->GetHomeLastBindingUpdateSequence (), (uint16_t)Mipv6L4Protocol::MAX_BINDING_LIFETIME);
+    }
 
   Ptr<Packet> p = Create<Packet> ();
 
@@ -205,24 +308,56 @@ Ptr<Packet> Mipv6Mn::BuildHomeBU ()
   if(m_mnflag==true)    //adding if condition for NEMO
   {
 
-  Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
-
   m_buinf->SetMobileNetworkPrefix (m_mnp);
 
-  mnph.SetMobileNetworkPrefix(m_buinf->GetMobileNetworkPrefix ());
-
-  bu.AddOption(mnph);  
+  //one option per prefix, the HA registers them together
+  for (std::list<Ipv6Address>::const_iterator it = m_mnps.begin (); it != m_mnps.end (); it++)
+    {
+      Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
+      mnph.SetMobileNetworkPrefix (*it);
+      mnph.SetPrefixLength (64);
+      bu.AddOption (mnph);
+    }
   }
 
+  //a multihomed MN registers all its CoAs, the one of the binding first
+  if (!m_extraCoas.empty ())
+    {
+      Ipv6MobilityOptionBindingIdentifierHeader bid;
+      bid.SetBindingId (1);
+      bid.SetCareofAddress (m_buinf->GetCoa ());
+      //without a candidate entry, the AR is taken as strong and idle
+      bid.SetPriority (m_servingAr ? m_servingAr->GetPathWeight () : 100);
+      bu.AddOption (bid);
+      for (uint32_t i = 0; i < m_extraCoas.size (); i++)
+        {
+          bid.SetBindingId (i + 2);
+          bid.SetCareofAddress (m_extraCoas[i].second);
+          bid.SetPriority (m_extraCoas[i].first->GetPathWeight ());
+          bu.AddOption (bid);
+        }
+    }
+
   bu.SetPayloadProto(6);
 
   p->AddHeader (bu);
 
+  m_homeBUTemplate.Set (p);
   return p;
 }
 
 Ptr<Packet> Mipv6Mn::BuildCNBU ()
 {
+  ClearStaleTemplates ();
+  //authorized by the tokens of the last return routability
+  Callback<uint64_t, const uint8_t *, uint32_t> authenticate = MakeBoundCallback (&Mipv6CN::ComputeAuthenticator,
+                                                                                 m_buinf->GetHomeKeygenToken (),
+                                                                                 m_buinf->GetCareOfKeygenToken (),
+                                                                                 m_buinf->GetCoa (), m_buinf->GetCN ());
+  if (m_cnBUTemplate.IsSet ())
+    {
+      return m_cnBUTemplate.Build (m_buinf->GetCNLastBindingUpdateSequence (), (uint16_t)Mipv6L4Protocol::MAX_BINDING_LIFETIME, authenticate);
+    }
 
   Ptr<Packet> p = Create<Packet> ();
 
@@ -248,9 +383,18 @@ Ptr<Packet> Mipv6Mn::BuildCNBU ()
 
   bu.SetLifetime ((uint16_t)Mipv6L4Protocol::MAX_BINDING_LIFETIME);
 
+  Ipv6MobilityOptionNonceIndicesHeader indices;
+  indices.SetHomeNonceIndex (m_buinf->GetHomeNonceIndex ());
+  indices.SetCareOfNonceIndex (m_buinf->GetCareOfNonceIndex ());
+  bu.AddOption (indices);
+  //the authenticator covers the whole header, it is filled by the template
+  Ipv6MobilityOptionBindingAuthorizationDataHeader authorization;
+  bu.AddOption (authorization);
+
   p->AddHeader (bu);
 
-  return p;
+  m_cnBUTemplate.Set (p);
+  return m_cnBUTemplate.Build (m_buinf->GetCNLastBindingUpdateSequence (), (uint16_t)Mipv6L4Protocol::MAX_BINDING_LIFETIME, authenticate);
 }
 
 
@@ -314,47 +458,323 @@ void Mipv6Mn::HandleNewAttachment (Ipv6Address ipr)
  uint32_t ifindex = ipv6->GetInterfaceForAddress (ipr);
  NS_LOG_FUNCTION (this << ifindex);
 
-  if (!ipr.IsLinkLocal () && ifindex!=2 && !ipr.IsMatchingType(m_buinf->GetHoa()))
+  if (!ipr.IsLinkLocal () && ifindex!=2 && ipr != m_buinf->GetHoa ())
     {
+      Ipv6Address oldCoa = m_buinf->GetCoa ();
       Ipv6Address coa = ipr;
+      Ptr<CList> ar = LookupCandidate (coa);
+
+      //the link of the serving AR is still up on the other radio
+      int32_t oldIf = oldCoa.IsAny () ? -1 : ipv6->GetInterfaceForAddress (oldCoa);
+      bool otherRadio = oldIf >= 0 && (uint32_t) oldIf != ifindex
+        && ar && ar != m_servingAr && m_servingAr && !m_servingAr->IsConnectionPoor ();
+      //the binding moves off a congested AR, and not onto one
+      bool steered = otherRadio && m_servingAr->IsCongested () && !ar->IsCongested ();
+      if (otherRadio && !steered && !m_multiHoming && ar->IsCongested () && !m_servingAr->IsCongested ())
+        {
+          NS_LOG_LOGIC ("Staying on the serving AR, " << ar->GetAccessRouter () << " is congested");
+          return;
+        }
+      //a multihomed MN keeps the CoA of its other radio while the link of its AR is up
+      if (otherRadio && !steered && m_multiHoming)
+        {
+          AddCareOfAddress (ar, coa);
+          return;
+        }
+
       m_buinf->SetCoa (coa);
+      //the home BU template carries a Binding Identifier option per CoA
+      bool extraCoasChanged = false;
+      for (uint32_t i = 0; i < m_extraCoas.size (); i++)
+        {
+          if (m_extraCoas[i].first == ar || m_extraCoas[i].second == coa)
+            {
+              m_extraCoas.erase (m_extraCoas.begin () + i);
+              extraCoasChanged = true;
+              break;
+            }
+        }
+      if (steered && m_multiHoming)
+        {
+          //the congested AR keeps a share of the flows
+          m_extraCoas.push_back (std::make_pair (m_servingAr, oldCoa));
+          extraCoasChanged = true;
+        }
+      if (extraCoasChanged)
+        {
+          m_homeBUTemplate.Clear ();
+        }
+
+      //the handover is prepared if the HA accepted this CoA before the attachment
+      bool predictive = m_nextAr && m_nextAr->IsPreRegistered () && m_nextAr->GetCareOfAddress () == coa;
+      if (!oldCoa.IsAny () && oldCoa != coa)
+        {
+          m_handoverPending = true;
+          m_handoverStart = m_linkLost ? m_linkLossTime : Simulator::Now ();
+          m_handoverOldCoa = oldCoa;
+          m_handoverStartTrace (oldCoa, coa);
+        }
+      m_linkLost = false;
+      if (m_nextAr)
+        {
+          m_nextAr->Reset ();
+          m_nextAr = 0;
+        }
+      m_servingAr = ar;
 
       ClearTunnelAndRouting ();
-      Ptr<Ipv6> ipv6 = GetNode ()->GetObject<Ipv6> ();
-      NS_ASSERT (ipv6);
+      if (predictive)
+        {
+          //make before break: the HA already takes the new CoA, switch without waiting for the BA
+          SetupTunnelAndRouting ();
+        }
+      SendHomeBU ();
+
+      if (predictive && m_handoverPending)
+        {
+          NotifyHandoverComplete (true);
+        }
+    }
+}
+
+void Mipv6Mn::SendHomeBU ()
+{
+  NS_LOG_FUNCTION (this);
 
+  //preset header information
+  m_buinf->SetHomeLastBindingUpdateSequence (GetHomeBUSequence ());
+  //Cut to micro-seconds
+  m_buinf->SetHomeLastBindingUpdateTime (MicroSeconds (Simulator::Now ().GetMicroSeconds ()));
+  //reset (for the first registration), the BU for the former CoA is superseded
+  m_buinf->StopHomeRetransTimer ();
+  m_buinf->ResetHomeRetryCount ();
 
-      //preset header information
-      m_buinf->SetHomeLastBindingUpdateSequence (GetHomeBUSequence ());
-      //Cut to micro-seconds
-      m_buinf->SetHomeLastBindingUpdateTime (MicroSeconds (Simulator::Now ().GetMicroSeconds ()));
-      //reset (for the first registration)
-      m_buinf->ResetHomeRetryCount ();
+  Ptr<Packet> p = BuildHomeBU ();
 
-      Ptr<Packet> p = BuildHomeBU ();
+  //save packet
+  m_buinf->SetHomeBUPacket (p);
 
-      //save packet
-      m_buinf->SetHomeBUPacket (p);
 
+  //send BU
+  NS_LOG_FUNCTION (this << p->GetSize ());
+  SendMessage (p->Copy (), m_buinf->GetCoa (), m_buinf->GetHA (), 64);
+  Ptr<Packet> pkt = p->Copy ();
+  m_txbuTrace (pkt, m_buinf->GetCoa (), m_buinf->GetHA ());
 
-      //send BU
-      NS_LOG_FUNCTION (this << p->GetSize ());
-      SendMessage (p->Copy (), m_buinf->GetHA (), 64);
-      Ptr<Packet> pkt = p->Copy ();
-      m_txbuTrace (pkt, m_buinf->GetCoa (), m_buinf->GetHA ());
 
+  m_buinf->StartHomeRetransTimer ();
 
-      m_buinf->StartHomeRetransTimer ();
+  if (m_buinf->IsHomeReachable ())
+    {
+      m_buinf->MarkHomeRefreshing ();
+    }
+  else
+    {
+      m_buinf->MarkHomeUpdating ();
+    }
+}
+
+void Mipv6Mn::AddCareOfAddress (Ptr<CList> ar, Ipv6Address coa)
+{
+  NS_LOG_FUNCTION (this << ar->GetAccessRouter () << coa);
+
+  std::vector<std::pair<Ptr<CList>, Ipv6Address> >::iterator it;
+  for (it = m_extraCoas.begin (); it != m_extraCoas.end () && it->first != ar; it++)
+    {
+    }
+  if (it == m_extraCoas.end ())
+    {
+      m_extraCoas.push_back (std::make_pair (ar, coa));
+    }
+  else
+    {
+      it->second = coa;
+    }
 
-      if (m_buinf->IsHomeReachable ())
+  //the options of the BU change with the CoAs
+  m_homeBUTemplate.Clear ();
+  SendHomeBU ();
+}
+
+uint32_t Mipv6Mn::GetNCareOfAddresses () const
+{
+  if (m_buinf->GetCoa ().IsAny () || m_buinf->GetCoa () == m_buinf->GetHoa ())
+    {
+      return 0;
+    }
+  return m_extraCoas.size () + 1;
+}
+
+Ptr<CList> Mipv6Mn::GetCandidate (Ipv6Address ar) const
+{
+  for (std::vector<Ptr<CList> >::const_iterator it = m_candidates.begin (); it != m_candidates.end (); it++)
+    {
+      if ((*it)->GetAccessRouter () == ar)
         {
-          m_buinf->MarkHomeRefreshing ();
+          return *it;
         }
-      else
+    }
+  return 0;
+}
+
+uint32_t Mipv6Mn::GetNCandidates () const
+{
+  return m_candidates.size ();
+}
+
+Ptr<CList> Mipv6Mn::LookupCandidate (Ipv6Address addr) const
+{
+  Ipv6Prefix prefix (64);
+  for (std::vector<Ptr<CList> >::const_iterator it = m_candidates.begin (); it != m_candidates.end (); it++)
+    {
+      if ((*it)->GetAccessRouter ().CombinePrefix (prefix) == addr.CombinePrefix (prefix))
         {
-          m_buinf->MarkHomeUpdating ();
+          return *it;
         }
     }
+  return 0;
+}
+
+void Mipv6Mn::HandleSignalChange (Ptr<CList> ar)
+{
+  NS_LOG_FUNCTION (this << ar->GetAccessRouter ());
+
+  //the weights of the CoAs of a multihomed MN follow the signal and the load of their AR
+  bool registered = ar == m_servingAr;
+  for (uint32_t i = 0; i < m_extraCoas.size (); i++)
+    {
+      registered = registered || m_extraCoas[i].first == ar;
+    }
+  if (registered && !m_extraCoas.empty ())
+    {
+      m_homeBUTemplate.Clear ();
+      SendHomeBU ();
+    }
+
+  if (ar == m_servingAr)
+    {
+      if (ar->IsConnectionPoor () && !m_linkLost)
+        {
+          m_linkLost = true;
+          m_linkLossTime = Simulator::Now ();
+        }
+      if (m_predictive && !m_nextAr && (!ar->IsConnectionStrong () || ar->IsCongested ()))
+        {
+          PrepareHandover ();
+        }
+    }
+  else if (m_predictive && !m_nextAr && ar->IsConnectionStrong () && !ar->IsCongested ()
+           && m_servingAr && (!m_servingAr->IsConnectionStrong () || m_servingAr->IsCongested ()))
+    {
+      //a candidate came up, or cleared, after the serving AR weakened or congested
+      PrepareHandover ();
+    }
+}
+
+bool Mipv6Mn::PrepareHandover ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Ipv6Address coa = m_buinf->GetCoa ();
+  if (coa.IsAny () || m_routedCoa != coa)
+    {
+      NS_LOG_LOGIC ("No binding away from home to pre-register with");
+      return false;
+    }
+
+  //the first strong candidate, the first uncongested one if any
+  Ptr<CList> next = 0;
+  for (std::vector<Ptr<CList> >::const_iterator it = m_candidates.begin (); it != m_candidates.end (); it++)
+    {
+      if (*it != m_servingAr && (*it)->IsConnectionStrong ()
+          && (!next || (next->IsCongested () && !(*it)->IsCongested ())))
+        {
+          next = *it;
+        }
+    }
+  if (!next)
+    {
+      NS_LOG_LOGIC ("No strong candidate AR");
+      return false;
+    }
+  if (next->IsCongested () && m_servingAr && m_servingAr->IsConnectionStrong ())
+    {
+      NS_LOG_LOGIC ("No uncongested candidate AR to steer to");
+      return false;
+    }
+
+  //the CoA on the next link: prefix of the AR and interface identifier of the MN
+  uint8_t buf1[16], buf2[16], buf[16];
+  next->GetAccessRouter ().GetBytes (buf1);
+  GetNode ()->GetObject<Ipv6> ()->GetAddress (1, 0).GetAddress ().GetBytes (buf2);
+  for (uint8_t i = 0; i < 8; i++)
+    {
+      buf[i] = buf1[i];
+      buf[i + 8] = buf2[i + 8];
+    }
+  Ipv6Address nextCoa (buf);
+
+  next->SetCareOfAddress (nextCoa);
+  next->SetSIDRoute (Segment (nextCoa));
+  next->SetPreRegistrationSequence (GetHomeBUSequence ());
+  next->SetPreRegistered (false);
+  m_nextAr = next;
+
+  Ptr<Packet> p = BuildPreRegistrationBU (nextCoa, next->GetPreRegistrationSequence ());
+  SendMessage (p->Copy (), coa, m_buinf->GetHA (), 64);
+  m_txbuTrace (p, coa, m_buinf->GetHA ());
+  return true;
+}
+
+Ptr<Packet> Mipv6Mn::BuildPreRegistrationBU (Ipv6Address coa, uint16_t sequence)
+{
+  NS_LOG_FUNCTION (this << coa << sequence);
+
+  Ptr<Packet> p = Create<Packet> ();
+
+  Ipv6ExtensionDestinationHeader destextnhdr;
+  Ipv6HomeAddressOptionHeader homeopt;
+  homeopt.SetHomeAddress (m_buinf->GetHoa ());
+  destextnhdr.AddOption (homeopt);
+  destextnhdr.SetNextHeader (59);
+  p->AddHeader (destextnhdr);
+
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (sequence);
+  bu.SetFlagA (true);
+  bu.SetFlagH (true);
+  bu.SetFlagL (true);
+  bu.SetFlagK (true);
+  bu.SetLifetime ((uint16_t)Mipv6L4Protocol::MAX_BINDING_LIFETIME);
+
+  //the prefixes are carried as in the home BU (NEMO)
+  if (m_mnflag)
+    {
+      bu.SetFlagR (true);
+      for (std::list<Ipv6Address>::const_iterator it = m_mnps.begin (); it != m_mnps.end (); it++)
+        {
+          Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
+          mnph.SetMobileNetworkPrefix (*it);
+          mnph.SetPrefixLength (64);
+          bu.AddOption (mnph);
+        }
+    }
+
+  Ipv6MobilityOptionAlternateCareofAddressHeader acoa;
+  acoa.SetAlternateCareofAddress (coa);
+  bu.AddOption (acoa);
+
+  bu.SetPayloadProto (6);
+  p->AddHeader (bu);
+  return p;
+}
+
+void Mipv6Mn::NotifyHandoverComplete (bool predictive)
+{
+  NS_LOG_FUNCTION (this << predictive);
+
+  m_handoverPending = false;
+  m_handoverTrace (Simulator::Now () - m_handoverStart, predictive, m_handoverOldCoa, m_buinf->GetCoa ());
 }
 
 
@@ -362,82 +782,111 @@ void Mipv6Mn::HandleNewAttachment (Ipv6Address ipr)
 
 void Mipv6Mn::MobNetPrefAdvd(Ipv6Address prefix,uint32_t indexRouter)
 {
+  MobNetPrefAdvd (std::list<Ipv6Address> (1, prefix), indexRouter);
+}
+
+void Mipv6Mn::MobNetPrefAdvd (const std::list<Ipv6Address> &prefixes, uint32_t indexRouter)
+{
+       //the prefixes of the MR do not change, the advertiser of the first BA keeps running
+       if (m_mnpAdvertiser)
+         {
+           return;
+         }
        Ptr<Radvd> radvd=CreateObject<Radvd> ();
        Ptr<RadvdInterface> routerInterface= Create<RadvdInterface> (indexRouter, 1500, 50);
-       Ptr<RadvdPrefix> routerPrefix = Create<RadvdPrefix> (prefix, 64, 1.5, 2.0);
-       routerInterface->AddPrefix (routerPrefix);
+       for (std::list<Ipv6Address>::const_iterator it = prefixes.begin (); it != prefixes.end (); it++)
+         {
+           routerInterface->AddPrefix (Create<RadvdPrefix> (*it, 64, 1.5, 2.0));
+         }
        radvd->AddConfiguration (routerInterface);
 
        GetNode()->AddApplication (radvd);
-       radvd->SetStartTime (Simulator::Now ());
-       radvd->SetStopTime (Seconds (100.0));
+       m_mnpAdvertiser = radvd;
 }
 
 
-uint8_t Mipv6Mn::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Mn::HandleBA (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
 
   // Options are not implemented yet!!
 
   NS_LOG_FUNCTION (this << packet << src << dst << interface << "HANDLE BACK");
 
-  Ptr<Packet> p = packet->Copy ();
-  Ptr<Packet> pkt = packet->Copy ();
-  m_rxbaTrace (pkt, src, dst, interface);
+  m_rxbaTrace (packet, src, dst, interface);
 
-  Ipv6MobilityBindingAckHeader ba;
-  Ipv6ExtensionType2RoutingHeader exttype2;
-
-  p->RemoveHeader (ba);
-  p->RemoveHeader (exttype2);
+  Ipv6Address homeaddr;
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("BA without type 2 routing header, ignored");
+      return 0;
+    }
 
   Ptr<Mipv6Demux> mipv6Demux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (mipv6Demux);
 
-  Ptr<Mipv6Mobility> ipv6Mobility = mipv6Demux->GetMobility (ba.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = mipv6Demux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
   //check for sequence
-  if (IsHomeMatch (src) && (m_buinf->GetHoa ()).IsMatchingType (exttype2.GetHomeAddress ()))
+  if (IsHomeMatch (src) && m_buinf->GetHoa () == homeaddr)
     {
-      if (m_buinf->GetHomeLastBindingUpdateSequence () != ba.GetSequence ())
+      //BA of the pre-registration of the next CoA, the binding is unchanged
+      if (m_nextAr && !m_nextAr->IsPreRegistered () && m_nextAr->GetPreRegistrationSequence () == view.GetSequence ())
+        {
+          m_nextAr->SetPreRegistered (view.GetStatus () == Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED);
+          return 0;
+        }
+
+      if (m_buinf->GetHomeLastBindingUpdateSequence () != view.GetSequence ())
         {
           NS_LOG_LOGIC ("Sequence mismatch. Ignored. this: "
                         << m_buinf->GetHomeLastBindingUpdateSequence ()
                         << ", from: "
-                        << ba.GetSequence ());
+                        << view.GetSequence ());
 
           return 0;
         }
 
       //check status code
-      switch (ba.GetStatus ())
+      switch (view.GetStatus ())
         {
         case Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED:
           {
             m_buinf->StopHomeRetransTimer ();
             m_buinf->SetHomeAddressRegistered (true);
             m_buinf->SetHomeBUPacket (0);
-            m_buinf->SetHomeReachableTime (Seconds (ba.GetLifetime ()));
+            m_buinf->SetHomeReachableTime (Seconds (view.GetLifetime ()));
 
           //adding a function call for advertising Mobile_Network_Prefix in MN (NEMO)
 
-                if(ba.GetFlagR()==true)
+                if(view.GetFlagR()==true)
                 {
                 Ipv6Address prefix (m_buinf->GetMobileNetworkPrefix ());
                 uint32_t indexRouter=2; //i.e. interface no 2
 
-                MobNetPrefAdvd(prefix,indexRouter); //NEMO
+                if (m_mnps.size () > 1)
+                  {
+                    MobNetPrefAdvd (m_mnps, indexRouter);
+                  }
+                else
+                  {
+                    MobNetPrefAdvd(prefix,indexRouter); //NEMO
+                  }
 
                 }
 
 
-            if (ba.GetLifetime () > 0)
+            if (view.GetLifetime () > 0)
               {
-                if (!(m_buinf->GetHoa ()).IsMatchingType (m_buinf->GetCoa ()))
+                //already set up by a predictive handover or a previous BA
+                if (m_buinf->GetHoa () != m_buinf->GetCoa () && m_routedCoa != m_buinf->GetCoa ())
                   {
                     SetupTunnelAndRouting ();
                   }
+                if (m_handoverPending)
+                  {
+                    NotifyHandoverComplete (false);
+                  }
 
                 m_buinf->MarkHomeReachable ();
 
@@ -446,7 +895,7 @@ uint8_t Mipv6Mn::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
                 m_buinf->StartHomeRefreshTimer ();
                 m_buinf->StopHomeReachableTimer ();
                 m_buinf->StartHomeReachableTimer ();
-                if (IsRouteOptimizationRequired () && !(m_buinf->GetHoa ()).IsMatchingType (m_buinf->GetCoa ()))
+                if (IsRouteOptimizationRequired () && m_buinf->GetHoa () != m_buinf->GetCoa ())
                   {
                     Ptr<Packet> p = BuildHoTI ();
                     m_buinf->SetHoTIPacket (p);
@@ -466,35 +915,35 @@ uint8_t Mipv6Mn::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
           }
 
         default:
-          NS_LOG_LOGIC ("Error occurred code=" << ba.GetStatus ());
+          NS_LOG_LOGIC ("Error occurred code=" << view.GetStatus ());
 
         }
 
       return 0;
     }
-  else if (src.IsMatchingType (m_buinf->GetCN ()) && (m_buinf->GetHoa ()).IsMatchingType (exttype2.GetHomeAddress ()))
+  else if (src == m_buinf->GetCN () && m_buinf->GetHoa () == homeaddr)
     {
-      if (m_buinf->GetCNLastBindingUpdateSequence () != ba.GetSequence ())
+      if (m_buinf->GetCNLastBindingUpdateSequence () != view.GetSequence ())
         {
           NS_LOG_LOGIC ("Sequence mismatch. Ignored. this: "
                         << m_buinf->GetCNLastBindingUpdateSequence ()
                         << ", from: "
-                        << ba.GetSequence ());
+                        << view.GetSequence ());
 
           return 0;
         }
 
       //check status code
-      switch (ba.GetStatus ())
+      switch (view.GetStatus ())
         {
         case Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED:
           {
             m_buinf->StopCNRetransTimer ();
             m_buinf->SetCNBUPacket (0);
-            m_buinf->SetCNReachableTime (Seconds (ba.GetLifetime ()));
+            m_buinf->SetCNReachableTime (Seconds (view.GetLifetime ()));
 
 
-            if (ba.GetLifetime () > 0)
+            if (view.GetLifetime () > 0)
               {
 
                 m_buinf->MarkCNReachable ();
@@ -510,7 +959,7 @@ uint8_t Mipv6Mn::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
           }
 
         default:
-          NS_LOG_LOGIC ("Error occurred code=" << ba.GetStatus ());
+          NS_LOG_LOGIC ("Error occurred code=" << view.GetStatus ());
         }
 
       return 0;
@@ -528,15 +977,7 @@ uint8_t Mipv6Mn::HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv
 
 bool Mipv6Mn::IsHomeMatch (Ipv6Address addr)
 {
-  std::list<Ipv6Address>::iterator iter = std::find (m_Haalist.begin (), m_Haalist.end (), addr);
-  if ( m_Haalist.end () == iter )
-    {
-      return false;
-    }
-  else
-    {
-      return true;
-    }
+  return m_config->IsHomeAgent (addr);
 }
 
 Ipv6Address Mipv6Mn::GetCoA ()
@@ -545,34 +986,33 @@ return m_buinf->GetCoa ();
 }
 
 
-uint8_t Mipv6Mn::HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Mn::HandleHoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << packet << src << dst << interface << "HANDLE HoT");
 
-  Ptr<Packet> p = packet->Copy ();
-
-  Ipv6HoTHeader hot;
-  Ipv6ExtensionType2RoutingHeader exttype2;
-
-  p->RemoveHeader (hot);
-  p->RemoveHeader (exttype2);
+  Ipv6Address homeaddr;
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("HoT without type 2 routing header, ignored");
+      return 0;
+    }
 
   Ptr<Mipv6Demux> mipv6Demux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (mipv6Demux);
 
-  Ptr<Mipv6Mobility> ipv6Mobility = mipv6Demux->GetMobility (hot.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = mipv6Demux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
   //check for timestamp and sequence
-  if (m_buinf->GetHomeInitCookie () != hot.GetHomeInitCookie () )
+  if (m_buinf->GetHomeInitCookie () != view.GetInitCookie () )
     {
       NS_LOG_LOGIC ("Home Init Cookie mismatch. Ignored. this: "
                     << m_buinf->GetHomeInitCookie ()
                     << ", from: "
-                    << hot.GetHomeInitCookie ());
+                    << view.GetInitCookie ());
 
     }
-  if (!((m_buinf->GetHoa ()).IsMatchingType (exttype2.GetHomeAddress ())))
+  if (m_buinf->GetHoa () != homeaddr)
     {
       NS_LOG_LOGIC ("Home Address mismatch. Ignored. this: ");
       return 0;
@@ -580,8 +1020,8 @@ uint8_t Mipv6Mn::HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const Ip
 
   m_buinf->StopHoTIRetransTimer ();
   m_buinf->SetHoTIPacket (0);
-  m_buinf->SetHomeNonceIndex (hot.GetHomeNonceIndex ());
-  m_buinf->SetHomeKeygenToken (hot.GetHomeKeygenToken ());
+  m_buinf->SetHomeNonceIndex (view.GetNonceIndex ());
+  m_buinf->SetHomeKeygenToken (view.GetKeygenToken ());
 
   Ptr<Packet> pc = BuildCoTI ();
   m_buinf->SetCoTIPacket (pc);
@@ -593,47 +1033,47 @@ uint8_t Mipv6Mn::HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const Ip
   return 0;
 }
 
-uint8_t Mipv6Mn::HandleCoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+uint8_t Mipv6Mn::HandleCoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
 {
   NS_LOG_FUNCTION (this << packet << src << dst << interface << "HANDLE CoT");
 
-  Ptr<Packet> p = packet->Copy ();
-
-  Ipv6CoTHeader cot;
-  Ipv6ExtensionType2RoutingHeader exttype2;
-
-  p->RemoveHeader (cot);
-  p->RemoveHeader (exttype2);
+  Ipv6Address homeaddr;
+  if (!view.GetHomeAddress (homeaddr))
+    {
+      NS_LOG_LOGIC ("CoT without type 2 routing header, ignored");
+      return 0;
+    }
 
   Ptr<Mipv6Demux> mipv6Demux = GetNode ()->GetObject<Mipv6Demux> ();
   NS_ASSERT (mipv6Demux);
 
-  Ptr<Mipv6Mobility> ipv6Mobility = mipv6Demux->GetMobility (cot.GetMhType ());
+  Ptr<Mipv6Mobility> ipv6Mobility = mipv6Demux->GetMobility (view.GetMhType ());
   NS_ASSERT (ipv6Mobility);
 
   //check for sequence
-  if (m_buinf->GetCareOfInitCookie () != cot.GetCareOfInitCookie () )
+  if (m_buinf->GetCareOfInitCookie () != view.GetInitCookie () )
     {
       NS_LOG_LOGIC ("Care of Init Cookie mismatch. Ignored. this: "
                     << m_buinf->GetCareOfInitCookie ()
                     << ", from: "
-                    << cot.GetCareOfInitCookie ());
+                    << view.GetInitCookie ());
 
     }
 
   m_buinf->StopCoTIRetransTimer ();
   m_buinf->SetCoTIPacket (0);
-  m_buinf->SetCareOfNonceIndex (cot.GetCareOfNonceIndex ());
-  m_buinf->SetCareOfKeygenToken (cot.GetCareOfKeygenToken ());
+  m_buinf->SetCareOfNonceIndex (view.GetNonceIndex ());
+  m_buinf->SetCareOfKeygenToken (view.GetKeygenToken ());
 
-  if (!((m_buinf->GetHoa ()).IsMatchingType (exttype2.GetHomeAddress ())))
+  if (m_buinf->GetHoa () != homeaddr)
     {
       NS_LOG_LOGIC ("Home Address mismatch. Ignored. this: ");
       return 0;
     }
 
 
-  //preset header information
+  //preset header information, the options change with the tokens
+  m_cnBUTemplate.Clear ();
   m_buinf->SetCNLastBindingUpdateSequence (GetCNBUSequence ());
   //Cut to micro-seconds
   m_buinf->SetCNLastBindingUpdateTime (MicroSeconds (Simulator::Now ().GetMicroSeconds ()));
@@ -659,6 +1099,22 @@ uint8_t Mipv6Mn::HandleCoT (Ptr<Packet> packet, const Ipv6Address &src, const Ip
 
 bool Mipv6Mn::SetupTunnelAndRouting ()
 {
+  Ptr<Ipv6SrRouting> sr = IsSegmentRoutingEnabled () ? Ipv6SrRouting::GetSrRouting (GetNode ()) : 0;
+  if (sr)
+    {
+      //reverse direction: mobile network traffic goes through the HA (End SID)
+      if (m_mnp != Ipv6Address::GetAny ())
+        {
+          sr->AddSid (Segment (m_buinf->GetHA ()));
+          for (std::list<Ipv6Address>::const_iterator it = m_mnps.begin (); it != m_mnps.end (); it++)
+            {
+              sr->AddSourcePolicy (*it, Ipv6Prefix (64), std::vector<Segment> (1, Segment (m_buinf->GetHA ())));
+            }
+        }
+      m_routedCoa = m_buinf->GetCoa ();
+      return true;
+    }
+
   Ptr<Ipv6TunnelL4Protocol> th = GetNode ()->GetObject<Ipv6TunnelL4Protocol> ();
   NS_ASSERT (th);
 
@@ -698,6 +1154,10 @@ bool Mipv6Mn::SetupTunnelAndRouting ()
   staticRouting->AddNetworkRouteTo (routeentry.GetDest (), routeentry.GetDestNetworkPrefix (), m_defaultrouteraddress, m_buinf->GetTunnelIfIndex (), routeentry.GetPrefixToUse (), 0);
   staticRouting->RemoveRoute (Ipv6Address ("fe80::"), Ipv6Prefix (64), m_buinf->GetTunnelIfIndex (), Ipv6Address ("fe80::"));
 
+  //the route to the HA moved to the host route above
+  th->GetTunnelDevice (m_buinf->GetHA ())->InvalidateRoutes ();
+  m_routedCoa = m_buinf->GetCoa ();
+
 
 
   return true;
@@ -709,6 +1169,22 @@ void Mipv6Mn::ClearTunnelAndRouting ()
 {
   NS_LOG_FUNCTION (this);
 
+  m_routedCoa = Ipv6Address::GetAny ();
+
+  Ptr<Ipv6SrRouting> sr = IsSegmentRoutingEnabled () ? Ipv6SrRouting::GetSrRouting (GetNode ()) : 0;
+  if (sr)
+    {
+      if (m_mnp != Ipv6Address::GetAny ())
+        {
+          for (std::list<Ipv6Address>::const_iterator it = m_mnps.begin (); it != m_mnps.end (); it++)
+            {
+              sr->RemoveSourcePolicy (*it, Ipv6Prefix (64));
+            }
+          sr->RemoveSid (Segment (m_buinf->GetHA ()));
+        }
+      return;
+    }
+
   Ipv6StaticRoutingHelper staticRoutingHelper;
   Ptr<Ipv6> ipv6 = GetNode ()->GetObject<Ipv6> ();
 
@@ -745,9 +1221,16 @@ void Mipv6Mn::SetDefaultRouterAddress (Ipv6Address addr,  uint32_t index)
   m_IfIndex = index;
 }
 
+void Mipv6Mn::NotifyAttachment (Ipv6Address coa)
+{
+  NS_LOG_FUNCTION (this << coa);
+
+  HandleNewAttachment (coa);
+}
+
 bool Mipv6Mn::CheckAddresses (Ipv6Address ha, Ipv6Address hoa)
 {
-  if (ha.IsMatchingType (m_buinf->GetHA ()) && hoa.IsMatchingType (m_buinf->GetHoa ()))
+  if (ha == m_buinf->GetHA () && hoa == m_buinf->GetHoa ())
     {
       return true;
     }
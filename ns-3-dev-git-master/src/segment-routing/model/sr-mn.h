@@ -3,13 +3,22 @@
 
 #include "sr-agent.h"
 #include "blist.h"
+#include "clist.h"
+#include "sr-mn-config.h"
+#include "sr-header.h"
+#include "sr-network.h"
 #include "ns3/traced-callback.h"
 
 #include "ns3/net-device-container.h"
 #include "ns3/node-container.h"
 
+#include <utility>
+#include <vector>
+
 namespace ns3 {
 
+class Radvd;
+
 class Mipv6Mn : public Mipv6Agent
 {
 public:
@@ -24,6 +33,18 @@ public:
    */
   Mipv6Mn (std::list<Ipv6Address> haalist,bool RorH,Ipv6Address mnp, std::list<Ipv6Address> aralist);//adding last2 argument in constructor for NEMO
 
+  /**
+   * \brief constructor.
+   * \param config shared configuration (home agents, ARs, mobile network prefix)
+   */
+  Mipv6Mn (Ptr<const Mipv6MnConfig> config);
+
+  /**
+   * \brief get the shared configuration.
+   * \return the configuration
+   */
+  Ptr<const Mipv6MnConfig> GetConfig () const;
+
   virtual ~Mipv6Mn ();
 
   /**
@@ -40,13 +61,13 @@ public:
   uint16_t GetCNBUSequence ();
 
   /**
-   * \brief build Home BU
+   * \brief build Home BU, patching the template of the previous one if any
    * \return home BU packet
    */
   Ptr<Packet> BuildHomeBU ();
 
   /**
-   * \brief build CN BU
+   * \brief build CN BU, patching the template of the previous one if any
    * \return CN BU packet
    */
   Ptr<Packet> BuildCNBU ();
@@ -106,6 +127,15 @@ public:
    */
   void SetDefaultRouterAddress (Ipv6Address addr, uint32_t index);
 
+  /**
+   * \brief attach with a CoA configured outside of the ICMPv6 layer.
+   *
+   * For a CoA set up by a script, as done by ICMPv6 after the address
+   * autoconfiguration on the link of a new AR.
+   * \param coa the CoA
+   */
+  void NotifyAttachment (Ipv6Address coa);
+
   /**
    * \brief check for match
    * \param ha the home agent address
@@ -124,6 +154,46 @@ public:
    */
   Ipv6Address GetCoA ();
 
+  /**
+   * \brief get the candidate entry of an AR.
+   * \param ar AR router address
+   * \return the candidate, 0 if the AR is not in the configuration
+   */
+  Ptr<CList> GetCandidate (Ipv6Address ar) const;
+
+  /**
+   * \brief get the number of candidate ARs.
+   * \return the number of candidates
+   */
+  uint32_t GetNCandidates () const;
+
+  /**
+   * \brief get the number of CoAs registered with the HA.
+   * \return the CoA of the binding and the ones of the other ARs of a multihomed MN
+   */
+  uint32_t GetNCareOfAddresses () const;
+
+  /**
+   * TracedCallback signature for the end of a handover.
+   *
+   * \param [in] interruption time without a registered path, from the loss
+   *              of the old link (or the attachment if it was not signaled)
+   * \param [in] predictive true if the handover was prepared before the attachment
+   * \param [in] oldCoa the CoA before the handover
+   * \param [in] newCoa the CoA after the handover
+   */
+  typedef void (* HandoverTracedCallback)
+    (Time interruption, bool predictive, Ipv6Address oldCoa, Ipv6Address newCoa);
+
+  /**
+   * TracedCallback signature for the start of a handover.
+   *
+   * \param [in] oldCoa the CoA before the handover
+   * \param [in] newCoa the CoA after the handover
+   */
+  typedef void (* HandoverStartTracedCallback)
+    (Ipv6Address oldCoa, Ipv6Address newCoa);
+
   /**
    * TracedCallback signature for BA reception event.
    *
@@ -152,8 +222,17 @@ public:
 protected:
   virtual void NotifyNewAggregate ();
 
+  /**
+   * \brief Initialize this object, moving the binding timers to the timing wheel if enabled,
+   * and subscribing the candidate ARs to the network monitor if any.
+   */
+  virtual void DoInitialize ();
+
   /**
    * \brief handle attachment with a network, called from ICMPv6L4Protocol
+   *
+   * While the link of an uncongested serving AR is up, an attachment to a
+   * congested AR on another interface does not move the binding.
    * \param ipr the CoA currently configured at ICMPv6 layer
    */
   virtual void HandleNewAttachment (Ipv6Address ipr);
@@ -161,38 +240,110 @@ protected:
   /**
    * \brief Handle recieved BA from HA/CN.
    * \param packet BA packet
+   * \param view the mobility header parsed from the packet
    * \param src address of HA/CN
    * \param dst CoA of MN
    * \param interface IPv6 interface which recieves the BA
    * \return status
    */
-  virtual uint8_t HandleBA (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleBA (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief Handle recieved HoT from CN.
    * \param packet HoT packet
+   * \param view the mobility header parsed from the packet
    * \param src address of CN
    * \param dst CoA of MN
    * \param interface IPv6 interface which recieves the HoT
    * \return status
    */
-  virtual uint8_t HandleHoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleHoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
   /**
    * \brief Handle recieved CoT from CN.
    * \param packet CoT packet
+   * \param view the mobility header parsed from the packet
    * \param src address of CN
    * \param dst CoA of MN
    * \param interface IPv6 interface which recieves the CoT
    * \return status
    */
-  virtual uint8_t HandleCoT (Ptr<Packet> packet, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleCoT (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
 
 
 
 void MobNetPrefAdvd(Ipv6Address prefix,uint32_t indexRouter); // adding for Radvd in NEMO
 
+  /**
+   * \brief advertise several mobile network prefixes with one Radvd (NEMO).
+   *
+   * The Radvd is created by the first accepted BA, the next BAs keep it.
+   * \param prefixes the /64 prefixes
+   * \param indexRouter interface of the mobile network
+   */
+  void MobNetPrefAdvd (const std::list<Ipv6Address> &prefixes, uint32_t indexRouter);
+
+  /**
+   * \brief handle a change of the signal of an AR.
+   *
+   * A weak, poor or congested serving AR starts the preparation of the
+   * handover in predictive mode, a poor one marks the loss of the link.
+   * \param ar the candidate entry of the AR
+   */
+  void HandleSignalChange (Ptr<CList> ar);
+
+  /**
+   * \brief prepare the handover to a strong candidate AR, uncongested if any.
+   *
+   * The CoA on the link of the AR is predicted from its prefix and the
+   * interface identifier of the MN, then pre-registered with the HA by a BU
+   * sent from the current CoA with an Alternate CoA option.
+   * \return true if a pre-registration was sent
+   */
+  bool PrepareHandover ();
+
+  /**
+   * \brief register a CoA on the link of another AR besides the CoA of the binding.
+   *
+   * In multihoming mode, the home BU carries a Binding Identifier option
+   * per CoA, weighted by the signal and the load of its AR, and the HA
+   * spreads the flows of the MN over the CoAs.
+   * \param ar the candidate entry of the AR
+   * \param coa the CoA on the link of the AR
+   */
+  void AddCareOfAddress (Ptr<CList> ar, Ipv6Address coa);
+
+  /**
+   * \brief send a home BU from the CoA of the binding.
+   */
+  void SendHomeBU ();
+
+  /**
+   * \brief build the BU pre-registering the CoA of the next AR.
+   * \param coa the predicted CoA
+   * \param sequence the sequence of the BU
+   * \return the BU packet
+   */
+  Ptr<Packet> BuildPreRegistrationBU (Ipv6Address coa, uint16_t sequence);
+
 private:
+  /**
+   * \brief get the candidate AR whose prefix matches an address.
+   * \param addr the address
+   * \return the candidate, 0 if none
+   */
+  Ptr<CList> LookupCandidate (Ipv6Address addr) const;
+
+  /**
+   * \brief report the end of the handover in progress.
+   * \param predictive true if the handover was prepared
+   */
+  void NotifyHandoverComplete (bool predictive);
+
+  /**
+   * \brief drop the BU templates built with another home address.
+   */
+  void ClearStaleTemplates ();
 
   /**
    * \brief Binding information list of the MN.
@@ -210,14 +361,9 @@ private:
   uint16_t m_cnsequence;
 
   /**
-   * \brief home agent address list.
+   * \brief shared configuration: home agent and AR router address lists.
    */
-  std::list<Ipv6Address> m_Haalist;
-
-  /**
-    * \brief AR router address list
-  */
-  std::list<Ipv6Address> m_Aralist;
+  Ptr<const Mipv6MnConfig> m_config;
 
   /**
    * \brief route optimization flag.
@@ -250,6 +396,103 @@ private:
  
   Ipv6Address m_mnp; // mobile network prefix ,adding for NEMO
 
+  std::list<Ipv6Address> m_mnps; // all the mobile network prefixes, m_mnp first (NEMO)
+
+  /**
+   * \brief advertiser of the mobile network prefixes, started by the first BA (NEMO).
+   */
+  Ptr<Radvd> m_mnpAdvertiser;
+
+  /**
+   * \brief home BU sent last, refreshed in place.
+   */
+  Mipv6MessageTemplate m_homeBUTemplate;
+
+  /**
+   * \brief CN BU sent last, refreshed in place.
+   */
+  Mipv6MessageTemplate m_cnBUTemplate;
+
+  /**
+   * \brief home address in the home option of the templates.
+   */
+  Ipv6Address m_templateHoa;
+
+
+  /**
+   * \brief candidate ARs, in the order of the configuration.
+   */
+  std::vector<Ptr<CList> > m_candidates;
+
+  /**
+   * \brief candidate entry of the AR the MN is attached to.
+   */
+  Ptr<CList> m_servingAr;
+
+  /**
+   * \brief candidate entry of the AR the handover is prepared to.
+   */
+  Ptr<CList> m_nextAr;
+
+  /**
+   * \brief whether the handover is prepared when the serving AR weakens.
+   */
+  bool m_predictive;
+
+  /**
+   * \brief whether the CoAs on the links of several ARs are registered together.
+   */
+  bool m_multiHoming;
+
+  /**
+   * \brief CoAs registered besides the one of the binding, with their AR.
+   */
+  std::vector<std::pair<Ptr<CList>, Ipv6Address> > m_extraCoas;
+
+  /**
+   * \brief monitor pushing the load and the congestion of the ARs, if any.
+   */
+  Ptr<NetworkMonitor> m_monitor;
+
+  /**
+   * \brief CoA the tunnel and routing are set up for.
+   */
+  Ipv6Address m_routedCoa;
+
+  /**
+   * \brief whether the serving AR link was signaled lost.
+   */
+  bool m_linkLost;
+
+  /**
+   * \brief time the serving AR link was signaled lost.
+   */
+  Time m_linkLossTime;
+
+  /**
+   * \brief whether a handover waits for its registration.
+   */
+  bool m_handoverPending;
+
+  /**
+   * \brief start of the interruption of the handover in progress.
+   */
+  Time m_handoverStart;
+
+  /**
+   * \brief CoA before the handover in progress.
+   */
+  Ipv6Address m_handoverOldCoa;
+
+  /**
+   * \brief Callback to trace the interruption time of the handovers.
+   */
+  TracedCallback<Time, bool, Ipv6Address, Ipv6Address> m_handoverTrace;
+
+  /**
+   * \brief Callback to trace the start of the handovers, on the attachment to the new AR.
+   */
+  TracedCallback<Ipv6Address, Ipv6Address> m_handoverStartTrace;
 
   /**
    * \brief Callback to trace RX (reception) ba packets.
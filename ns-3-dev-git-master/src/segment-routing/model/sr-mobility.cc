@@ -1,7 +1,6 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
-#include "ns3/simulator.h"
 #include "sr-mobility.h"
 #include "sr-option.h"
 #include "sr-demux.h"
@@ -45,6 +44,35 @@ Ptr<Node> Mipv6Mobility::GetNode () const
   return m_node;
 }
 
+uint8_t Mipv6Mobility::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
+{
+  NS_LOG_FUNCTION (this << p << src << dst << interface);
+
+  Mipv6MessageView view;
+  if (!view.Parse (p))
+    {
+      NS_LOG_LOGIC ("Malformed mobility header, dropped");
+      return 0;
+    }
+  return Process (p, view, src, dst, interface);
+}
+
+uint8_t Mipv6Mobility::Process (Ptr<Packet> p, const Mipv6MessageView &view, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
+{
+  NS_LOG_FUNCTION (this << p << src << dst << interface << (uint32_t)view.GetMhType ());
+
+  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent> ();
+
+  if (mip6)
+    {
+      return mip6->Receive (p, view, src, dst, interface);
+    }
+
+  NS_LOG_LOGIC (" No Handler for MH type " << (uint32_t)view.GetMhType ());
+
+  return 0;
+}
+
 uint8_t Mipv6Mobility::ProcessOptions (Ptr<Packet> packet, uint8_t offset, uint8_t length, Mipv6OptionBundle &bundle)
 {
   NS_LOG_FUNCTION (this << packet << length);
@@ -120,44 +148,6 @@ uint8_t Ipv6MobilityBindingUpdate::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6MobilityBindingUpdate::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-  Ipv6MobilityBindingUpdateHeader buh;
-  Mipv6OptionBundle bundle;
-  /*  Mobile Ipv6 process routine */
-  packet->RemoveHeader (buh);
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS BU" );
-      return 0;
-    }
-
-
-  Ptr<Mipv6Demux> ipv6MobilityDemux = GetNode ()->GetObject<Mipv6Demux>();
-  NS_ASSERT ( ipv6MobilityDemux );
-
-  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (buh.GetMhType ());
-  NS_ASSERT ( ipv6Mobility );
-
-  uint8_t length = ((buh.GetHeaderLen () + 1 ) << 3) - buh.GetOptionsOffset ();
-
-  ipv6Mobility->ProcessOptions ( packet, buh.GetOptionsOffset (), length, bundle);
-
-
-  NS_LOG_LOGIC (" No Handler for Binding Update");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityBindingAck);
 
 TypeId Ipv6MobilityBindingAck::GetTypeId ()
@@ -179,42 +169,6 @@ uint8_t Ipv6MobilityBindingAck::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6MobilityBindingAck::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-  Ipv6MobilityBindingAckHeader bah;
-  Mipv6OptionBundle bundle;
-  /* Mobile Ipv6 process routine */
-  packet->PeekHeader (bah);
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS BACK" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-  Ptr<Mipv6Demux> ipv6MobilityDemux = GetNode ()->GetObject<Mipv6Demux>();
-  NS_ASSERT ( ipv6MobilityDemux );
-
-  Ptr<Mipv6Mobility> ipv6Mobility = ipv6MobilityDemux->GetMobility (bah.GetMhType ());
-  NS_ASSERT ( ipv6Mobility );
-
-  uint8_t length = ((bah.GetHeaderLen () + 1 ) << 3) - bah.GetOptionsOffset ();
-  ipv6Mobility->ProcessOptions ( packet, bah.GetOptionsOffset (), length, bundle);
-
-  NS_LOG_LOGIC (" No Handler for Binding Ack");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityHoTI);
 
 TypeId Ipv6MobilityHoTI::GetTypeId ()
@@ -236,30 +190,6 @@ uint8_t Ipv6MobilityHoTI::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6MobilityHoTI::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS HoTI" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-
-  NS_LOG_LOGIC (" No Handler for HoTI");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityCoTI);
 
 TypeId Ipv6MobilityCoTI::GetTypeId ()
@@ -281,30 +211,6 @@ uint8_t Ipv6MobilityCoTI::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6MobilityCoTI::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS CoTI" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-
-  NS_LOG_LOGIC (" No Handler for CoTI");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityHoT);
 
 TypeId Ipv6MobilityHoT::GetTypeId ()
@@ -326,30 +232,6 @@ uint8_t Ipv6MobilityHoT::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6MobilityHoT::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS HoT" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-
-  NS_LOG_LOGIC (" No Handler for HoT");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityCoT);
 
 TypeId Ipv6MobilityCoT::GetTypeId ()
@@ -371,30 +253,6 @@ uint8_t Ipv6MobilityCoT::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6MobilityCoT::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS CoTI" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-
-  NS_LOG_LOGIC (" No Handler for CoT");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6BindingRefreshRequest);
 
 TypeId Ipv6BindingRefreshRequest::GetTypeId ()
@@ -416,30 +274,6 @@ uint8_t Ipv6BindingRefreshRequest::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6BindingRefreshRequest::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS BRR" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-
-  NS_LOG_LOGIC (" No Handler for BRR");
-
-  return 0;
-}
-
 NS_OBJECT_ENSURE_REGISTERED (Ipv6BindingError);
 
 TypeId Ipv6BindingError::GetTypeId ()
@@ -461,29 +295,5 @@ uint8_t Ipv6BindingError::GetMobilityNumber () const
   return MOB_NUMBER;
 }
 
-uint8_t Ipv6BindingError::Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface)
-{
-  NS_LOG_FUNCTION (this << p << src << dst << interface);
-
-  Ptr<Packet> packet = p->Copy ();
-
-
-  Ptr<Mipv6Agent> mip6 = GetNode ()->GetObject<Mipv6Agent>();
-
-  if ( mip6 )
-    {
-      NS_LOG_FUNCTION ( this << packet << src << dst << interface << "PROCESS BE" );
-      Simulator::ScheduleNow ( &Mipv6Agent::Receive, mip6, p, src, dst, interface);
-
-      return 0;
-    }
-
-
-
-  NS_LOG_LOGIC (" No Handler for Binding Error");
-
-  return 0;
-}
-
 
 } /* namespace ns3 */
\ No newline at end of file
@@ -10,6 +10,7 @@
 namespace ns3 {
 
 class Mipv6OptionBundle;
+class Mipv6MessageView;
 /**
  * \class Ipv6Mobility
  * \brief Ipv6 Mobility base
@@ -51,14 +52,27 @@ public:
   virtual uint8_t GetMobilityNumber () const = 0;
 
   /**
-   * \brief Process method, Called from Ipv6MobilityL4Protocol::Receive.
+   * \brief Process method, parses the mobility header and processes its view.
    * \param p the packet
    * \param src the source address
    * \param dst the destination address
    * \param interface IPv6 interface
    * \return the processed size
    */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface) = 0;
+  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
+
+  /**
+   * \brief Process method, Called from Ipv6MobilityL4Protocol::Receive.
+   *
+   * Hands the message to the Mipv6Agent of the node, if any.
+   * \param p the packet, starting with the mobility header
+   * \param view the mobility header parsed from the packet
+   * \param src the source address
+   * \param dst the destination address
+   * \param interface IPv6 interface
+   * \return the processed size
+   */
+  virtual uint8_t Process (Ptr<Packet> p, const Mipv6MessageView &view, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
 
 
   /**
@@ -108,18 +122,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -155,18 +157,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -195,18 +185,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -235,18 +213,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -275,17 +241,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -314,18 +269,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -357,19 +300,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
@@ -398,18 +328,6 @@ public:
    */
   virtual uint8_t GetMobilityNumber () const;
 
-  /**
-   * \brief Process method
-   *
-   * Called from Ipv6MobilityL4Protocol::Receive.
-   * \param p the packet
-   * \param src the source address
-   * \param dst the destination address
-   * \param interface the interface
-   * \return the processed size
-   */
-  virtual uint8_t Process (Ptr<Packet> p, Ipv6Address src, Ipv6Address dst, Ptr<Ipv6Interface> interface);
-
 private:
 };
 
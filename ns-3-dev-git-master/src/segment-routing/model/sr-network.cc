@@ -1,14 +1,24 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include "ns3/assert.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/uinteger.h"
 #include "sr-network.h"
-#include "ns3/position-allocator.h"
-#include "ns3/mobility-helper.h"
 
 namespace ns3 {
 
-NS_LOG_COMPONENT_DEFINE ("LteConfig");
+NS_LOG_COMPONENT_DEFINE ("SrNetwork");
 NS_OBJECT_ENSURE_REGISTERED (LteConfig);
 
-static TypeId
-GetTypeId (void)
+TypeId
+LteConfig::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::LteConfig")
     .SetParent<Object> ()
@@ -16,16 +26,26 @@ GetTypeId (void)
   return tid;
 }
 
-TypeId
-GetInstanceTypeId (void) const{
-  return GetTypeId ();
+LteConfig::LteConfig ()
+  : RSRP (-114),
+    powerloss (0.25),
+    power (6800),
+    p_usage (0.0068),
+    m_load (0)
+{
+    m_pos.x = 0;
+    m_pos.y = 0;
 }
 
 LteConfig::LteConfig (double x, double y)
-{ 
+  : RSRP (-114),
+    powerloss (0.25),
+    power (6800),
+    p_usage (0.0068),
+    m_load (0)
+{
     m_pos.x = x;
     m_pos.y = y;
-    congested = false;
 }
 
 LteConfig::~LteConfig ()
@@ -47,48 +67,68 @@ void LteConfig::SetNode (Ptr<Node> node)
   m_node = node;
 }
 
-double LteConfig::CalculateRSSI(Position& pos)
+Position LteConfig::GetPosition () const
+{
+    return m_pos;
+}
+
+void LteConfig::SetPosition (const Position& pos)
+{
+    m_pos = pos;
+}
+
+double LteConfig::CalculateRSSI(const Position& pos) const
 {
     double p_received = powerloss * CalculateDistance(m_pos, pos);
     return p_received - RSRP;
 }
 
-double LteConfig::CalculateDistance(Position& pos1, Position& pos2)
+double LteConfig::CalculateDistance(const Position& pos1, const Position& pos2) const
 {
     return std::sqrt(std::pow(pos2.x - pos1.x, 2) + std::pow(pos2.y - pos1.y, 2));
 }
 
-void LteConfig::SetLoad (uint16_t load) 
+double LteConfig::GetRsrp () const
+{
+    return RSRP;
+}
+
+double LteConfig::GetPowerLoss () const
+{
+    return powerloss;
+}
+
+void LteConfig::SetLoad (uint16_t load)
 {
     m_load = load;
 }
 
-uint16_t LteConfig::GetLoad () const 
+uint16_t LteConfig::GetLoad () const
 {
     return m_load;
 }
 
-double LteConfig::calculatePowerUsage ()
+double LteConfig::calculatePowerUsage () const
 {
-    double usage = GetLoad () * p_usage;
+    /* p_usage is the share of the cell power drawn by each connection */
+    double usage = GetLoad () * p_usage * power;
     return usage;
 }
 
-bool IsCongested () const
+double LteConfig::GetPowerShare () const
 {
-    if (calculatePowerUsage () / power > 0.63)
-    {
-        congested = True;
-        return congested;
-    }
-    return congested;
+    return calculatePowerUsage () / power;
+}
+
+bool LteConfig::IsCongested () const
+{
+    return GetPowerShare () > 0.63;
 }
 
-NS_LOG_COMPONENT_DEFINE ("NrMicro");
 NS_OBJECT_ENSURE_REGISTERED (NrMicro);
 
-static TypeId
-GetTypeId (void)
+TypeId
+NrMicro::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::NrMicro")
     .SetParent<LteConfig> ()
@@ -96,15 +136,15 @@ GetTypeId (void)
   return tid;
 }
 
-TypeId
-GetInstanceTypeId (void) const{
-  return GetTypeId ();
+NrMicro::NrMicro ()
+{
+    RSRP = -120;
 }
 
 NrMicro::NrMicro (double x, double y)
-{ 
-    m_pos.x = x;
-    m_pos.y = y;  
+  : LteConfig (x, y)
+{
+    RSRP = -120;
 }
 
 NrMicro::~NrMicro ()
@@ -112,79 +152,465 @@ NrMicro::~NrMicro ()
 
 }
 
-Ptr<Node> NrMicro::GetNode () const
+NS_OBJECT_ENSURE_REGISTERED (NrMacro);
+
+TypeId
+NrMacro::GetTypeId (void)
 {
-  NS_LOG_FUNCTION (this);
+  static TypeId tid = TypeId ("ns3::NrMacro")
+    .SetParent<NrMicro> ()
+    .AddConstructor<NrMacro> ();
+  return tid;
+}
 
-  return m_node;
+NrMacro::NrMacro ()
+{
+    power = 11500;
+    p_usage = 0.0115;
 }
 
-void NrMicro::SetNode (Ptr<Node> node)
+NrMacro::NrMacro (double x, double y)
+  : NrMicro (x, y)
+{
+    power = 11500;
+    p_usage = 0.0115;
+}
+
+NrMacro::~NrMacro ()
 {
-  NS_LOG_FUNCTION ( this << node );
 
-  m_node = node;
 }
 
-NS_LOG_COMPONENT_DEFINE ("NrMacro");
-NS_OBJECT_ENSURE_REGISTERED (NrMacro);
+NS_OBJECT_ENSURE_REGISTERED (CellGrid);
 
-static TypeId
-GetTypeId (void)
+TypeId
+CellGrid::GetTypeId (void)
 {
-  static TypeId tid = TypeId ("ns3::NrMacro")
-    .SetParent<NrMicro> ()
-    .AddConstructor<NrMacro> ();
+  static TypeId tid = TypeId ("ns3::CellGrid")
+    .SetParent<Object> ()
+    .AddConstructor<CellGrid> ()
+    .AddAttribute ("BucketSize", "Side of a bucket of the grid, in meters.",
+                   DoubleValue (200),
+                   MakeDoubleAccessor (&CellGrid::m_size),
+                   MakeDoubleChecker<double> (1))
+  ;
   return tid;
 }
 
-TypeId
-GetInstanceTypeId (void) const{
-  return GetTypeId ();
+CellGrid::CellGrid ()
+  : m_size (200),
+    m_minX (std::numeric_limits<int32_t>::max ()),
+    m_maxX (std::numeric_limits<int32_t>::min ()),
+    m_minY (std::numeric_limits<int32_t>::max ()),
+    m_maxY (std::numeric_limits<int32_t>::min ()),
+    m_maxRsrp (-std::numeric_limits<double>::infinity ()),
+    m_minLoss (std::numeric_limits<double>::infinity ())
+{
+  NS_LOG_FUNCTION (this);
 }
 
-NrMacro::NrMacro (double x, double y)
-{ 
-    m_pos.x = x;
-    m_pos.y = y;
-    congested = false;
+CellGrid::~CellGrid ()
+{
+  NS_LOG_FUNCTION (this);
 }
 
-NrMacro::~NrMacro ()
+void CellGrid::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (Trackers::iterator it = m_trackers.begin (); it != m_trackers.end (); it++)
+    {
+      Ptr<MobilityModel> mobility = const_cast<MobilityModel *> (it->first);
+      mobility->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&CellGrid::CourseChange, this));
+    }
+  m_trackers.clear ();
+  m_cells.clear ();
+  m_buckets.clear ();
+  Object::DoDispose ();
+}
+
+size_t CellGrid::BucketHash::operator () (uint64_t key) const
 {
+  return (size_t)(key ^ (key >> 32) * 0x9e3779b1);
+}
 
+int32_t CellGrid::GetBucket (double v) const
+{
+  return (int32_t)std::floor (v / m_size);
+}
+
+uint64_t CellGrid::GetKey (int32_t bx, int32_t by)
+{
+  return ((uint64_t)(uint32_t)bx << 32) | (uint32_t)by;
+}
+
+void CellGrid::Insert (Ptr<LteConfig> cell)
+{
+  Position pos = cell->GetPosition ();
+  int32_t bx = GetBucket (pos.x);
+  int32_t by = GetBucket (pos.y);
+  uint64_t key = GetKey (bx, by);
+
+  m_buckets[key].push_back (cell);
+  m_cells[PeekPointer (cell)] = key;
+
+  m_minX = std::min (m_minX, bx);
+  m_maxX = std::max (m_maxX, bx);
+  m_minY = std::min (m_minY, by);
+  m_maxY = std::max (m_maxY, by);
+}
+
+void CellGrid::Erase (Ptr<LteConfig> cell, uint64_t key)
+{
+  Buckets::iterator bucket = m_buckets.find (key);
+  NS_ASSERT (bucket != m_buckets.end ());
+
+  std::vector<Ptr<LteConfig> > &cells = bucket->second;
+  std::vector<Ptr<LteConfig> >::iterator it = std::find (cells.begin (), cells.end (), cell);
+  NS_ASSERT (it != cells.end ());
+  *it = cells.back ();
+  cells.pop_back ();
+  if (cells.empty ())
+    {
+      m_buckets.erase (bucket);
+    }
+}
+
+void CellGrid::AddCell (Ptr<LteConfig> cell)
+{
+  NS_LOG_FUNCTION (this << cell);
+  NS_ASSERT_MSG (m_cells.find (PeekPointer (cell)) == m_cells.end (), "cell added twice");
+
+  Ptr<Node> node = cell->GetNode ();
+  Ptr<MobilityModel> mobility = node ? node->GetObject<MobilityModel> () : 0;
+  if (mobility)
+    {
+      Vector v = mobility->GetPosition ();
+      Position pos;
+      pos.x = v.x;
+      pos.y = v.y;
+      cell->SetPosition (pos);
+      if (m_trackers.find (PeekPointer (mobility)) == m_trackers.end ())
+        {
+          m_trackers[PeekPointer (mobility)] = cell;
+          mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&CellGrid::CourseChange, this));
+        }
+    }
+
+  /* bounds of the received power, never lowered so they stay safe after a removal */
+  m_maxRsrp = std::max (m_maxRsrp, cell->GetRsrp ());
+  m_minLoss = std::min (m_minLoss, cell->GetPowerLoss ());
+  Insert (cell);
+}
+
+bool CellGrid::RemoveCell (Ptr<LteConfig> cell)
+{
+  NS_LOG_FUNCTION (this << cell);
+
+  CellBuckets::iterator it = m_cells.find (PeekPointer (cell));
+  if (it == m_cells.end ())
+    {
+      return false;
+    }
+  Erase (cell, it->second);
+  m_cells.erase (it);
+
+  for (Trackers::iterator tracker = m_trackers.begin (); tracker != m_trackers.end (); tracker++)
+    {
+      if (tracker->second == cell)
+        {
+          Ptr<MobilityModel> mobility = const_cast<MobilityModel *> (tracker->first);
+          mobility->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&CellGrid::CourseChange, this));
+          m_trackers.erase (tracker);
+          break;
+        }
+    }
+  return true;
+}
+
+uint32_t CellGrid::GetNCells () const
+{
+  return m_cells.size ();
+}
+
+void CellGrid::UpdateCell (Ptr<LteConfig> cell)
+{
+  NS_LOG_FUNCTION (this << cell);
+
+  CellBuckets::iterator it = m_cells.find (PeekPointer (cell));
+  NS_ASSERT_MSG (it != m_cells.end (), "cell not in the grid");
+
+  Position pos = cell->GetPosition ();
+  if (it->second == GetKey (GetBucket (pos.x), GetBucket (pos.y)))
+    {
+      return;
+    }
+  Erase (cell, it->second);
+  Insert (cell);
+}
+
+void CellGrid::CourseChange (Ptr<const MobilityModel> mobility)
+{
+  Trackers::iterator it = m_trackers.find (PeekPointer (mobility));
+  if (it == m_trackers.end ())
+    {
+      return;
+    }
+
+  Vector v = mobility->GetPosition ();
+  Position pos;
+  pos.x = v.x;
+  pos.y = v.y;
+  it->second->SetPosition (pos);
+  UpdateCell (it->second);
+}
+
+namespace {
+
+/**
+ * \brief orders the candidates by received power, the worst first in a priority queue
+ */
+struct CandidateGreater
+{
+  /**
+   * \brief compare two candidates.
+   * \param a first candidate
+   * \param b second candidate
+   * \return true if a receives more power than b
+   */
+  bool operator () (const CellGrid::Candidate &a, const CellGrid::Candidate &b) const
+  {
+    return a.rsrp > b.rsrp;
+  }
+};
+
+} // anonymous namespace
+
+std::vector<CellGrid::Candidate>
+CellGrid::GetCandidates (const Position &pos, uint32_t k, bool skipCongested) const
+{
+  NS_LOG_FUNCTION (this << pos.x << pos.y << k);
+
+  std::priority_queue<Candidate, std::vector<Candidate>, CandidateGreater> best;
+  if (k == 0 || m_cells.empty ())
+    {
+      return std::vector<Candidate> ();
+    }
+
+  int32_t bx = GetBucket (pos.x);
+  int32_t by = GetBucket (pos.y);
+  int32_t rings = std::max (std::max (bx - m_minX, m_maxX - bx), std::max (by - m_minY, m_maxY - by));
+
+  for (int32_t r = 0; r <= rings; r++)
+    {
+      /* any cell of ring r is more than r - 1 buckets away */
+      if (best.size () == k && r > 0
+          && best.top ().rsrp >= m_maxRsrp - m_minLoss * (r - 1) * m_size)
+        {
+          break;
+        }
+
+      for (int32_t x = bx - r; x <= bx + r; x++)
+        {
+          /* the inner rows of the ring only have their two ends */
+          int32_t step = (x == bx - r || x == bx + r) ? 1 : std::max (2 * r, 1);
+          for (int32_t y = by - r; y <= by + r; y += step)
+            {
+              Buckets::const_iterator bucket = m_buckets.find (GetKey (x, y));
+              if (bucket == m_buckets.end ())
+                {
+                  continue;
+                }
+              for (std::vector<Ptr<LteConfig> >::const_iterator it = bucket->second.begin (); it != bucket->second.end (); it++)
+                {
+                  if (skipCongested && (*it)->IsCongested ())
+                    {
+                      continue;
+                    }
+                  Candidate candidate;
+                  candidate.rsrp = -(*it)->CalculateRSSI (pos);
+                  if (best.size () == k && candidate.rsrp <= best.top ().rsrp)
+                    {
+                      continue;
+                    }
+                  candidate.cell = *it;
+                  candidate.load = (*it)->GetLoad ();
+                  candidate.congested = (*it)->IsCongested ();
+                  best.push (candidate);
+                  if (best.size () > k)
+                    {
+                      best.pop ();
+                    }
+                }
+            }
+        }
+    }
+
+  std::vector<Candidate> candidates (best.size ());
+  for (uint32_t i = candidates.size (); i > 0; i--)
+    {
+      candidates[i - 1] = best.top ();
+      best.pop ();
+    }
+  return candidates;
+}
+
+std::vector<CellGrid::Candidate>
+CellGrid::GetCandidates (Ptr<const MobilityModel> mobility, uint32_t k, bool skipCongested) const
+{
+  Vector v = mobility->GetPosition ();
+  Position pos;
+  pos.x = v.x;
+  pos.y = v.y;
+  return GetCandidates (pos, k, skipCongested);
 }
 
-NS_LOG_COMPONENT_DEFINE ("NetworkMonitor");
 NS_OBJECT_ENSURE_REGISTERED (NetworkMonitor);
 
-static TypeId
-GetTypeId (void)
+TypeId
+NetworkMonitor::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::NetworkMonitor")
     .SetParent<Object> ()
-    .AddConstructor<NetworkMonitor> ();
+    .AddConstructor<NetworkMonitor> ()
+    .AddAttribute ("Interval", "Time between two samples of the load of the cells.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&NetworkMonitor::m_interval),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("Alpha", "Weight of a new sample in the congestion score.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&NetworkMonitor::m_alpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("CongestedScore", "Score from which a cell is congested.",
+                   DoubleValue (0.63),
+                   MakeDoubleAccessor (&NetworkMonitor::m_congestedScore),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("ClearedScore", "Score under which a congested cell is no longer, "
+                   "at most CongestedScore; the gap is the hysteresis.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&NetworkMonitor::m_clearedScore),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LoadStep", "Granularity of the load pushed to the MNs, in percent.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&NetworkMonitor::m_loadStep),
+                   MakeUintegerChecker<uint8_t> (1, 100))
+    .AddTraceSource ("Congestion",
+                     "The cell of an AR became congested or cleared",
+                     MakeTraceSourceAccessor (&NetworkMonitor::m_congestionTrace),
+                     "ns3::NetworkMonitor::CongestionTracedCallback")
+  ;
   return tid;
 }
 
-TypeId
-GetInstanceTypeId (void) const{
-  return GetTypeId ();
+NetworkMonitor::NetworkMonitor ()
+  : m_interval (MilliSeconds (100)),
+    m_alpha (0.25),
+    m_congestedScore (0.63),
+    m_clearedScore (0.5),
+    m_loadStep (10)
+{
+  NS_LOG_FUNCTION (this);
 }
 
-Ptr<Node> NrMacro::GetNode () const
+NetworkMonitor::~NetworkMonitor ()
 {
   NS_LOG_FUNCTION (this);
+}
 
-  return m_node;
+void NetworkMonitor::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_sampleEvent.Cancel ();
+  m_cells.clear ();
+  Object::DoDispose ();
 }
 
-void NrMacro::SetNode (Ptr<Node> node)
+void NetworkMonitor::AddCell (Ipv6Address ar, Ptr<LteConfig> cell)
 {
-  NS_LOG_FUNCTION ( this << node );
+  NS_LOG_FUNCTION (this << ar << cell);
+  NS_ASSERT_MSG (m_cells.find (ar) == m_cells.end (), "AR monitored twice");
+  NS_ASSERT_MSG (m_clearedScore <= m_congestedScore, "cleared score above the congested score");
 
-  m_node = node;
+  Cell &entry = m_cells[ar];
+  entry.cell = cell;
+  entry.score = cell->GetPowerShare ();
+  entry.congested = entry.score >= m_congestedScore;
+  entry.load = GetLoad (entry.score);
+
+  if (!m_sampleEvent.IsRunning ())
+    {
+      m_sampleEvent = Simulator::Schedule (m_interval, &NetworkMonitor::Sample, this);
+    }
+}
+
+uint32_t NetworkMonitor::GetNCells () const
+{
+  return m_cells.size ();
+}
+
+bool NetworkMonitor::Subscribe (Ptr<CList> candidate)
+{
+  NS_LOG_FUNCTION (this << candidate->GetAccessRouter ());
+
+  Cells::iterator it = m_cells.find (candidate->GetAccessRouter ());
+  if (it == m_cells.end ())
+    {
+      return false;
+    }
+  it->second.candidates.push_back (candidate);
+  candidate->SetLoad (it->second.load, it->second.congested);
+  return true;
 }
 
+double NetworkMonitor::GetScore (Ipv6Address ar) const
+{
+  Cells::const_iterator it = m_cells.find (ar);
+  return it == m_cells.end () ? 0 : it->second.score;
+}
 
-}
\ No newline at end of file
+bool NetworkMonitor::IsCongested (Ipv6Address ar) const
+{
+  Cells::const_iterator it = m_cells.find (ar);
+  return it != m_cells.end () && it->second.congested;
+}
+
+uint8_t NetworkMonitor::GetLoad (double score) const
+{
+  double load = std::floor (score * 100 / m_loadStep + 0.5) * m_loadStep;
+  return (uint8_t) std::min (load, 100.0);
+}
+
+void NetworkMonitor::Sample ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (Cells::iterator it = m_cells.begin (); it != m_cells.end (); it++)
+    {
+      Cell &entry = it->second;
+      entry.score = m_alpha * entry.cell->GetPowerShare () + (1 - m_alpha) * entry.score;
+
+      bool congested = entry.congested ? entry.score >= m_clearedScore : entry.score >= m_congestedScore;
+      uint8_t load = GetLoad (entry.score);
+      if (congested == entry.congested && load == entry.load)
+        {
+          continue;
+        }
+
+      NS_LOG_LOGIC ("AR " << it->first << " score " << entry.score << " congested " << congested);
+      entry.load = load;
+      if (congested != entry.congested)
+        {
+          entry.congested = congested;
+          m_congestionTrace (it->first, congested);
+        }
+      for (std::vector<Ptr<CList> >::iterator candidate = entry.candidates.begin (); candidate != entry.candidates.end (); candidate++)
+        {
+          (*candidate)->SetLoad (load, congested);
+        }
+    }
+
+  m_sampleEvent = Simulator::Schedule (m_interval, &NetworkMonitor::Sample, this);
+}
+
+}
@@ -1,17 +1,36 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
-
-#include "ns3/object-factory.h"
-#include "ns3/log.h"
-#include "ns3/names.h"
-#include <fstream>
+#ifndef SR_NETWORK_H
+#define SR_NETWORK_H
+
+#include <map>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/node.h"
+#include "ns3/vector.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "clist.h"
 
 namespace ns3 {
 
+class MobilityModel;
+
+/**
+ * \brief planar position of a cell or an MN, in meters
+ */
 struct Position {
-    double x;
-    double y;
-}
+    double x; //!< x coordinate
+    double y; //!< y coordinate
+};
 
+/**
+ * \class LteConfig
+ * \brief Radio cell of an access router, with its load.
+ */
 class LteConfig : public Object {
   public:
       /**
@@ -20,47 +39,98 @@ class LteConfig : public Object {
       */
       static TypeId GetTypeId ();
 
-      TypeId GetInstanceTypeId (void) const;
+      LteConfig ();
 
+      /**
+       * \brief constructor.
+       * \param x x coordinate of the cell
+       * \param y y coordinate of the cell
+       */
       LteConfig (double x, double y);
 
-      ~LteConfig ();
+      virtual ~LteConfig ();
 
       Ptr<Node> GetNode () const;
 
       void SetNode (Ptr<Node> node);
 
-      double CalculateRSSI(Position& pos);
+      /**
+       * \brief get the position of the cell.
+       * \return the position
+       */
+      Position GetPosition () const;
+
+      /**
+       * \brief set the position of the cell.
+       * \param pos the position
+       */
+      void SetPosition (const Position& pos);
+
+      /**
+       * \brief path loss from the cell to a position.
+       * \param pos the position
+       * \return the loss in dB, the received power is its opposite in dBm
+       */
+      double CalculateRSSI(const Position& pos) const;
+
+      double CalculateDistance(const Position& pos1, const Position& pos2) const;
 
-      double CalculateDistance(Position& pos1, Position& pos2);
+      /**
+       * \brief get the reference signal received power at the cell.
+       * \return the power in dBm
+       */
+      double GetRsrp () const;
+
+      /**
+       * \brief get the loss per meter.
+       * \return the loss in dB per meter
+       */
+      double GetPowerLoss () const;
 
       uint16_t GetLoad () const;
 
       void SetLoad (uint16_t load);
 
-      double calculatePowerUsage ();
+      /**
+       * \brief power drawn by the connections of the cell.
+       * \return the power in watts
+       */
+      double calculatePowerUsage () const;
+
+      /**
+       * \brief share of the cell power drawn by the connections.
+       * \return the share, above 1 when the cell is overbooked
+       */
+      double GetPowerShare () const;
 
+      /**
+       * \brief whether the connections draw more than 63% of the cell power.
+       * \return true if the cell is congested
+       */
       bool IsCongested () const;
 
-    private:
-      double RSRP = -114;   // in dBm
-      
-      double powerloss = 0.25;  // rate loss
+    protected:
+      double RSRP;   // in dBm
+
+      double powerloss;  // rate loss
 
-      double power = 6800; // watts
+      double power; // watts
 
-      double p_usage = 0.0068; // approximately 10 watts per device/ connection
+      double p_usage; // share of the power per device/ connection
 
+    private:
       Position m_pos;
 
       uint16_t m_load;
 
-      bool congested;
-
       Ptr<Node> m_node;
 };
 
-class NrMicro : LteConfig {
+/**
+ * \class NrMicro
+ * \brief NR small cell.
+ */
+class NrMicro : public LteConfig {
   public:
     /**
         * \brief Get the type identifier.
@@ -68,59 +138,210 @@ class NrMicro : LteConfig {
     */
     static TypeId GetTypeId ();
 
-    TypeId GetInstanceTypeId (void) const;
+    NrMicro ();
 
+    /**
+     * \brief constructor.
+     * \param x x coordinate of the cell
+     * \param y y coordinate of the cell
+     */
     NrMicro (double x, double y);
 
-    ~NrMicro ();
-   private:
-    double RSRP = -120   // in dBm
-    
-    double powerloss = 0.25;  // rate loss
-
-    double power = 6800; // watts
+    virtual ~NrMicro ();
+};
 
-    double p_usage = 0.0068; // approximately 10 watts per device/ connection
 
-    Position m_pos;
+/**
+ * \class NrMacro
+ * \brief NR macro cell.
+ */
+class NrMacro : public NrMicro {
+  public:
+    /**
+     * \brief Get the type identifier.
+     * \return type identifier
+    */
+    static TypeId GetTypeId ();
 
-    uint16_t load;
+    NrMacro ();
 
-    bool congested;
+    /**
+     * \brief constructor.
+     * \param x x coordinate of the cell
+     * \param y y coordinate of the cell
+     */
+    NrMacro (double x, double y);
 
-    Ptr<Node> m_node;
+    virtual ~NrMacro ();
 };
 
-
-class NrMacro : NrMicro {
+/**
+ * \class CellGrid
+ * \brief Uniform grid of the cells, to rank the candidate ARs of an MN.
+ *
+ * Cells are kept in square buckets of the grid. A query visits the buckets
+ * in rings around the MN and stops as soon as no cell of the next ring can
+ * beat the k best found, so it touches the cells near the MN instead of all
+ * of them. Cells whose node has a MobilityModel are moved between buckets
+ * from its CourseChange trace.
+ */
+class CellGrid : public Object {
   public:
     /**
      * \brief Get the type identifier.
      * \return type identifier
-    */
+     */
     static TypeId GetTypeId ();
 
-    TypeId GetInstanceTypeId (void) const;
+    /**
+     * \brief a candidate AR of an MN
+     */
+    struct Candidate
+    {
+      Ptr<LteConfig> cell; //!< the cell
+      double rsrp;         //!< power received by the MN, in dBm
+      uint16_t load;       //!< load of the cell
+      bool congested;      //!< whether the cell is congested
+    };
 
-    NrMacro (double x, double y);
+    CellGrid ();
+
+    virtual ~CellGrid ();
+
+    /**
+     * \brief add a cell.
+     *
+     * The cell position is read from the MobilityModel of its node if any.
+     * \param cell the cell
+     */
+    void AddCell (Ptr<LteConfig> cell);
+
+    /**
+     * \brief remove a cell.
+     * \param cell the cell
+     * \return false if the cell is not in the grid
+     */
+    bool RemoveCell (Ptr<LteConfig> cell);
+
+    /**
+     * \brief get the number of cells.
+     * \return the number of cells
+     */
+    uint32_t GetNCells () const;
+
+    /**
+     * \brief move a cell after a change of its position.
+     * \param cell the cell
+     */
+    void UpdateCell (Ptr<LteConfig> cell);
+
+    /**
+     * \brief get the k best cells at a position.
+     * \param pos the position of the MN
+     * \param k the number of candidates
+     * \param skipCongested whether to leave congested cells out
+     * \return the candidates, best received power first
+     */
+    std::vector<Candidate> GetCandidates (const Position &pos, uint32_t k, bool skipCongested = false) const;
+
+    /**
+     * \brief get the k best cells at the position of an MN.
+     * \param mobility the mobility model of the MN
+     * \param k the number of candidates
+     * \param skipCongested whether to leave congested cells out
+     * \return the candidates, best received power first
+     */
+    std::vector<Candidate> GetCandidates (Ptr<const MobilityModel> mobility, uint32_t k, bool skipCongested = false) const;
+
+  protected:
+    virtual void DoDispose ();
+
+  private:
+    /**
+     * \brief hash of a bucket key
+     */
+    struct BucketHash
+    {
+      /**
+       * \brief hash a bucket key.
+       * \param key the key
+       * \return the hash
+       */
+      size_t operator () (uint64_t key) const;
+    };
+
+    /**
+     * \brief cells of each bucket, keyed by the packed bucket coordinates
+     */
+    typedef sgi::hash_map<uint64_t, std::vector<Ptr<LteConfig> >, BucketHash> Buckets;
 
-    ~NrMacro ();
-   private:
-    double RSRP = -120;   // in dBm
-    
-    double powerloss = 0.25;  // rate loss
+    /**
+     * \brief bucket of each cell
+     */
+    typedef std::map<LteConfig *, uint64_t> CellBuckets;
 
-    double power = 11500; // watts
+    /**
+     * \brief cell of each tracked mobility model
+     */
+    typedef std::map<const MobilityModel *, Ptr<LteConfig> > Trackers;
 
-    double p_usage = 0.0115; // approximately 10 watts per device/ connection
+    /**
+     * \brief get the bucket coordinate of a position coordinate.
+     * \param v the coordinate
+     * \return the bucket coordinate
+     */
+    int32_t GetBucket (double v) const;
 
-    Position m_pos;
+    /**
+     * \brief pack bucket coordinates.
+     * \param bx x bucket coordinate
+     * \param by y bucket coordinate
+     * \return the key
+     */
+    static uint64_t GetKey (int32_t bx, int32_t by);
 
-    uint16_t load;
+    /**
+     * \brief insert a cell in its bucket.
+     * \param cell the cell
+     */
+    void Insert (Ptr<LteConfig> cell);
 
-    Ptr<Node> m_node;
+    /**
+     * \brief remove a cell from its bucket.
+     * \param cell the cell
+     * \param key the bucket of the cell
+     */
+    void Erase (Ptr<LteConfig> cell, uint64_t key);
+
+    /**
+     * \brief CourseChange trace of the node of a cell.
+     * \param mobility the mobility model
+     */
+    void CourseChange (Ptr<const MobilityModel> mobility);
+
+    double m_size;         //!< side of a bucket in meters
+    Buckets m_buckets;     //!< the buckets
+    CellBuckets m_cells;   //!< bucket of each cell
+    Trackers m_trackers;   //!< cells following a mobility model
+    int32_t m_minX;        //!< lowest x bucket ever occupied
+    int32_t m_maxX;        //!< highest x bucket ever occupied
+    int32_t m_minY;        //!< lowest y bucket ever occupied
+    int32_t m_maxY;        //!< highest y bucket ever occupied
+    double m_maxRsrp;      //!< highest reference power of the cells
+    double m_minLoss;      //!< lowest loss per meter of the cells
 };
 
+/**
+ * \class NetworkMonitor
+ * \brief Steering of the MNs away from the congested cells.
+ *
+ * The monitor samples the power share of the cell of each AR every Interval
+ * and keeps an exponentially weighted score of it. A cell is congested once
+ * its score reaches CongestedScore, and until it falls under ClearedScore so
+ * that a cell around the threshold does not flap. The load and the congestion
+ * are pushed to the candidate AR entries of the MNs, which weigh their CoAs
+ * and choose their handover target by them.
+ */
 class NetworkMonitor : public Object {
   public:
   /**
@@ -129,9 +350,100 @@ class NetworkMonitor : public Object {
   */
   static TypeId GetTypeId ();
 
-  TypeId GetInstanceTypeId (void) const;
-}
+  NetworkMonitor ();
+
+  virtual ~NetworkMonitor ();
+
+  /**
+   * TracedCallback signature for the congestion changes of the cells.
+   *
+   * \param [in] ar the address of the AR
+   * \param [in] congested whether the cell of the AR is congested
+   */
+  typedef void (* CongestionTracedCallback) (Ipv6Address ar, bool congested);
+
+  /**
+   * \brief monitor the cell of an AR.
+   *
+   * The score starts from the current power share of the cell; the sampling
+   * starts with the first cell and lasts until the monitor is disposed.
+   * \param ar the address of the AR
+   * \param cell the cell
+   */
+  void AddCell (Ipv6Address ar, Ptr<LteConfig> cell);
+
+  /**
+   * \brief get the number of monitored cells.
+   * \return the number of cells
+   */
+  uint32_t GetNCells () const;
+
+  /**
+   * \brief push the load and the congestion of an AR to a candidate entry.
+   *
+   * The candidate is updated at once, and then on each change.
+   * \param candidate the candidate entry of an MN, matched by its AR address
+   * \return false if the AR is not monitored
+   */
+  bool Subscribe (Ptr<CList> candidate);
+
+  /**
+   * \brief get the congestion score of the cell of an AR.
+   * \param ar the address of the AR
+   * \return the score, 0 if the AR is not monitored
+   */
+  double GetScore (Ipv6Address ar) const;
+
+  /**
+   * \brief whether the cell of an AR is congested.
+   * \param ar the address of the AR
+   * \return true if congested
+   */
+  bool IsCongested (Ipv6Address ar) const;
+
+  protected:
+    virtual void DoDispose ();
+
+  private:
+    /**
+     * \brief a monitored cell
+     */
+    struct Cell
+    {
+      Ptr<LteConfig> cell;                 //!< the cell
+      double score;                        //!< weighted power share
+      bool congested;                      //!< whether the cell is congested
+      uint8_t load;                        //!< load pushed to the candidates, in percent
+      std::vector<Ptr<CList> > candidates; //!< candidate entries of the MNs for the AR
+    };
+
+    /**
+     * \brief cells keyed by the address of their AR
+     */
+    typedef std::map<Ipv6Address, Cell> Cells;
+
+    /**
+     * \brief sample the cells and update their candidates.
+     */
+    void Sample ();
+
+    /**
+     * \brief get the load pushed to the candidates for a score.
+     * \param score the score
+     * \return the load in percent, rounded to LoadStep
+     */
+    uint8_t GetLoad (double score) const;
+
+    Cells m_cells;           //!< the monitored cells
+    Time m_interval;         //!< time between two samples
+    double m_alpha;          //!< weight of a new sample in the score
+    double m_congestedScore; //!< score from which a cell is congested
+    double m_clearedScore;   //!< score under which a congested cell is no longer
+    uint8_t m_loadStep;      //!< granularity of the pushed load, in percent
+    EventId m_sampleEvent;   //!< next sample
+    TracedCallback<Ipv6Address, bool> m_congestionTrace; //!< congestion changes
+};
 
 }
 
-#endif
\ No newline at end of file
+#endif /* SR_NETWORK_H */
@@ -652,4 +652,137 @@ Mipv6OptionHeader::Alignment Ipv6MobilityOptionMobileNetworkPrefixHeader::GetAli
 
 
 
+NS_OBJECT_ENSURE_REGISTERED (Ipv6MobilityOptionBindingIdentifierHeader);
+
+TypeId Ipv6MobilityOptionBindingIdentifierHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::Ipv6MobilityOptionBindingIdentifierHeader")
+    .SetParent<Mipv6OptionHeader> ()
+    .AddConstructor<Ipv6MobilityOptionBindingIdentifierHeader> ()
+  ;
+  return tid;
+}
+
+TypeId Ipv6MobilityOptionBindingIdentifierHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+Ipv6MobilityOptionBindingIdentifierHeader::Ipv6MobilityOptionBindingIdentifierHeader ()
+  : m_bid (0),
+  m_status (0),
+  m_flagH (false),
+  m_priority (0)
+{
+  SetType (Mipv6Header::IPV6_MOBILITY_OPT_BINDING_IDENTIFIER);
+  SetLength (20);
+  m_coa.Set ("::");
+}
+
+Ipv6MobilityOptionBindingIdentifierHeader::~Ipv6MobilityOptionBindingIdentifierHeader ()
+{
+}
+
+uint16_t Ipv6MobilityOptionBindingIdentifierHeader::GetBindingId () const
+{
+  return m_bid;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::SetBindingId (uint16_t bid)
+{
+  m_bid = bid;
+}
+
+uint8_t Ipv6MobilityOptionBindingIdentifierHeader::GetStatus () const
+{
+  return m_status;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::SetStatus (uint8_t status)
+{
+  m_status = status;
+}
+
+bool Ipv6MobilityOptionBindingIdentifierHeader::GetFlagH () const
+{
+  return m_flagH;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::SetFlagH (bool h)
+{
+  m_flagH = h;
+}
+
+uint8_t Ipv6MobilityOptionBindingIdentifierHeader::GetPriority () const
+{
+  return m_priority;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::SetPriority (uint8_t priority)
+{
+  m_priority = priority & 0x7f;
+}
+
+Ipv6Address Ipv6MobilityOptionBindingIdentifierHeader::GetCareofAddress () const
+{
+  return m_coa;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::SetCareofAddress (Ipv6Address coa)
+{
+  m_coa = coa;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::Print (std::ostream& os) const
+{
+  os << "( type=" << GetType () << ", length(excluding TL)=" << GetLength () << ", bid=" << GetBindingId ()
+     << ", status=" << (uint32_t) GetStatus () << ", priority=" << (uint32_t) GetPriority () << ", coa=" << GetCareofAddress () << ")";
+}
+
+uint32_t Ipv6MobilityOptionBindingIdentifierHeader::GetSerializedSize () const
+{
+  return GetLength () + 2;
+}
+
+void Ipv6MobilityOptionBindingIdentifierHeader::Serialize (Buffer::Iterator start) const
+{
+  uint8_t buff_coa[16];
+  Buffer::Iterator i = start;
+
+  i.WriteU8 (GetType ());
+  i.WriteU8 (GetLength ());
+  i.WriteU16 (m_bid);
+  i.WriteU8 (m_status);
+  i.WriteU8 ((m_flagH ? 0x80 : 0) | m_priority);
+
+  m_coa.Serialize (buff_coa);
+  i.Write (buff_coa, 16);
+}
+
+uint32_t Ipv6MobilityOptionBindingIdentifierHeader::Deserialize (Buffer::Iterator start)
+{
+  uint8_t buff[16];
+  Buffer::Iterator i = start;
+
+  SetType (i.ReadU8 ());
+  SetLength (i.ReadU8 ());
+  m_bid = i.ReadU16 ();
+  m_status = i.ReadU8 ();
+  uint8_t flags = i.ReadU8 ();
+  m_flagH = flags & 0x80;
+  m_priority = flags & 0x7f;
+
+  i.Read (buff, 16);
+  m_coa.Set (buff);
+
+  return GetSerializedSize ();
+}
+
+Mipv6OptionHeader::Alignment Ipv6MobilityOptionBindingIdentifierHeader::GetAlignment () const
+{
+  return (Alignment){
+           8,2
+  };                       //8n+2
+}
+
 } /* namespace ns3 */
\ No newline at end of file
@@ -625,6 +625,145 @@ private:
 
 
 
+/**
+ * \class Ipv6MobilityOptionBindingIdentifierHeader
+ * \brief Ipv6 Mobility Option Binding Identifier Header (RFC 5648).
+ *
+ * Registers one of several CoAs of a binding. The BID-PRI field carries the
+ * share of the traffic of the binding the MN wants on this CoA, 0 to
+ * register the CoA without traffic.
+ */
+class Ipv6MobilityOptionBindingIdentifierHeader : public Mipv6OptionHeader
+{
+public:
+  /**
+   * \brief Get the type identifier.
+   * \return type identifier
+   */
+  static TypeId GetTypeId ();
+  /**
+   * \brief Return the instance type identifier.
+   * \return instance type ID
+   */
+  virtual TypeId GetInstanceTypeId () const;
+  /**
+   * \brief constructor
+   */
+  Ipv6MobilityOptionBindingIdentifierHeader ();
+  /**
+   * \brief destructor
+   */
+  virtual ~Ipv6MobilityOptionBindingIdentifierHeader ();
+
+  /**
+   * \brief get the binding identifier.
+   * \return binding identifier
+   */
+  uint16_t GetBindingId () const;
+  /**
+   * \brief set the binding identifier.
+   * \param bid binding identifier
+   */
+  void SetBindingId (uint16_t bid);
+
+  /**
+   * \brief get the status, only used in a BA.
+   * \return status
+   */
+  uint8_t GetStatus () const;
+  /**
+   * \brief set the status, only used in a BA.
+   * \param status status
+   */
+  void SetStatus (uint8_t status);
+
+  /**
+   * \brief get the H flag (simultaneous home and foreign binding).
+   * \return H flag
+   */
+  bool GetFlagH () const;
+  /**
+   * \brief set the H flag (simultaneous home and foreign binding).
+   * \param h H flag
+   */
+  void SetFlagH (bool h);
+
+  /**
+   * \brief get the BID priority, the weight of the CoA.
+   * \return priority, 7 bits
+   */
+  uint8_t GetPriority () const;
+  /**
+   * \brief set the BID priority, the weight of the CoA.
+   * \param priority priority, 7 bits
+   */
+  void SetPriority (uint8_t priority);
+
+  /**
+   * \brief get the CoA.
+   * \return CoA
+   */
+  Ipv6Address GetCareofAddress () const;
+  /**
+   * \brief set the CoA.
+   * \param coa CoA
+   */
+  void SetCareofAddress (Ipv6Address coa);
+
+  /**
+   * \brief Print informations.
+   * \param os output stream
+   */
+  virtual void Print (std::ostream& os) const;
+  /**
+   * \brief Get the serialized size.
+   * \return serialized size
+   */
+  virtual uint32_t GetSerializedSize () const;
+  /**
+   * \brief Serialize the packet.
+   * \param start start offset
+   */
+  virtual void Serialize (Buffer::Iterator start) const;
+  /**
+   * \brief Deserialize the packet.
+   * \param start start offset
+   * \return length of packet
+   */
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  /**
+   * \brief Get the Alignment requirement of this option header
+   * \return the required alignment
+   */
+  virtual Alignment GetAlignment () const;
+protected:
+private:
+  /**
+   * \brief binding identifier
+   */
+  uint16_t m_bid;
+
+  /**
+   * \brief status
+   */
+  uint8_t m_status;
+
+  /**
+   * \brief H flag
+   */
+  bool m_flagH;
+
+  /**
+   * \brief BID priority
+   */
+  uint8_t m_priority;
+
+  /**
+   * \brief CoA
+   */
+  Ipv6Address m_coa;
+};
+
 } /* namespace ns3 */
 
 #endif /* IPV6_MOBILITY_OPTION_HEADER_H */
\ No newline at end of file
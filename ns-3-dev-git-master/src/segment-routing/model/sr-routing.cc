@@ -0,0 +1,538 @@
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/net-device.h"
+#include "ns3/ipv6.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/ipv6-list-routing.h"
+#include "ns3/ipv6-extension.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "sr-routing.h"
+#include "tunnel-net-device.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ipv6SrRouting");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (Ipv6SrRouting);
+
+TypeId Ipv6SrRouting::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::Ipv6SrRouting")
+    .SetParent<Ipv6RoutingProtocol> ()
+    .AddConstructor<Ipv6SrRouting> ()
+    .AddAttribute ("CsidBlockLength",
+                   "Length in bits of the locator block of the compressed SIDs, "
+                   "0 to keep the SID lists uncompressed. A multiple of 8.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv6SrRouting::m_csidBlockLength),
+                   MakeUintegerChecker<uint8_t> (0, 112))
+    .AddAttribute ("CsidLength",
+                   "Length in bits of a compressed SID, 16 or 32.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&Ipv6SrRouting::m_csidLength),
+                   MakeUintegerChecker<uint8_t> (16, 32))
+  ;
+  return tid;
+}
+
+Ipv6SrRouting::Ipv6SrRouting ()
+  : m_ipv6 (0),
+    m_csidBlockLength (0),
+    m_csidLength (16)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+Ipv6SrRouting::~Ipv6SrRouting ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void Ipv6SrRouting::DoDispose ()
+{
+  m_policies.Clear ();
+  m_policyPaths.Clear ();
+  m_sourcePolicies.Clear ();
+  m_routes.Clear ();
+  m_sids.clear ();
+  m_srExtension = 0;
+  m_ipv6 = 0;
+  Ipv6RoutingProtocol::DoDispose ();
+}
+
+Ptr<Ipv6SrRouting> Ipv6SrRouting::GetSrRouting (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (node);
+
+  Ptr<Ipv6> ipv6 = node->GetObject<Ipv6> ();
+  NS_ASSERT (ipv6);
+
+  Ptr<Ipv6ListRouting> list = DynamicCast<Ipv6ListRouting> (ipv6->GetRoutingProtocol ());
+  if (!list)
+    {
+      NS_LOG_WARN ("Node " << node->GetId () << " does not use Ipv6ListRouting");
+      return 0;
+    }
+
+  int16_t priority;
+  for (uint32_t i = 0; i < list->GetNRoutingProtocols (); i++)
+    {
+      Ptr<Ipv6SrRouting> sr = DynamicCast<Ipv6SrRouting> (list->GetRoutingProtocol (i, priority));
+      if (sr)
+        {
+          return sr;
+        }
+    }
+
+  Ptr<Ipv6SrRouting> sr = CreateObject<Ipv6SrRouting> ();
+  list->AddRoutingProtocol (sr, 10);
+  return sr;
+}
+
+void Ipv6SrRouting::AddPolicy (Ipv6Address dst, Ipv6Prefix mask, SegmentList segments)
+{
+  NS_LOG_FUNCTION (this << dst << mask << segments);
+  Insert (m_policies, dst, mask, segments);
+}
+
+void Ipv6SrRouting::RemovePolicy (Ipv6Address dst, Ipv6Prefix mask)
+{
+  NS_LOG_FUNCTION (this << dst << mask);
+  m_policies.Remove (dst, mask.GetPrefixLength ());
+  m_policyPaths.Remove (dst, mask.GetPrefixLength ());
+}
+
+void Ipv6SrRouting::AddPolicyPath (Ipv6Address dst, Ipv6Prefix mask, SegmentList segments, uint16_t weight)
+{
+  NS_LOG_FUNCTION (this << dst << mask << segments << weight);
+  NS_ASSERT (!segments.IsEmpty ());
+  segments = segments.Compress (m_csidBlockLength, m_csidLength);
+
+  uint8_t length = mask.GetPrefixLength ();
+  std::vector<PolicyPath> *paths = m_policyPaths.Find (dst, length);
+  if (!paths)
+    {
+      if (weight == 0)
+        {
+          return;
+        }
+      m_policyPaths.Insert (dst, length, std::vector<PolicyPath> ());
+      paths = m_policyPaths.Find (dst, length);
+    }
+
+  std::vector<PolicyPath>::iterator it;
+  for (it = paths->begin (); it != paths->end () && it->segments != segments; it++)
+    {
+    }
+  if (weight == 0)
+    {
+      if (it != paths->end ())
+        {
+          paths->erase (it);
+        }
+      if (paths->empty ())
+        {
+          m_policyPaths.Remove (dst, length);
+        }
+      return;
+    }
+  if (it == paths->end ())
+    {
+      PolicyPath path;
+      path.segments = segments;
+      paths->push_back (path);
+      it = paths->end () - 1;
+    }
+  it->weight = weight;
+}
+
+const SegmentList &Ipv6SrRouting::SelectPath (const std::vector<PolicyPath> &paths, uint32_t flowHash)
+{
+  uint32_t total = 0;
+  for (std::vector<PolicyPath>::const_iterator it = paths.begin (); it != paths.end (); it++)
+    {
+      total += it->weight;
+    }
+  uint32_t share = flowHash % total;
+  std::vector<PolicyPath>::const_iterator it = paths.begin ();
+  while (share >= it->weight)
+    {
+      share -= it->weight;
+      it++;
+    }
+  return it->segments;
+}
+
+void Ipv6SrRouting::AddSourcePolicy (Ipv6Address src, Ipv6Prefix mask, SegmentList segments)
+{
+  NS_LOG_FUNCTION (this << src << mask << segments);
+  Insert (m_sourcePolicies, src, mask, segments);
+}
+
+void Ipv6SrRouting::RemoveSourcePolicy (Ipv6Address src, Ipv6Prefix mask)
+{
+  NS_LOG_FUNCTION (this << src << mask);
+  m_sourcePolicies.Remove (src, mask.GetPrefixLength ());
+}
+
+uint32_t Ipv6SrRouting::GetNPolicies (void) const
+{
+  return m_policies.GetSize () + m_policyPaths.GetSize () + m_sourcePolicies.GetSize ();
+}
+
+void Ipv6SrRouting::Insert (PolicyTrie &policies, Ipv6Address prefix, Ipv6Prefix mask, const SegmentList &segments)
+{
+  NS_ASSERT (!segments.IsEmpty ());
+  policies.Insert (prefix, mask.GetPrefixLength (), segments.Compress (m_csidBlockLength, m_csidLength));
+}
+
+void Ipv6SrRouting::AddRoute (Ipv6Address dst, Ipv6Prefix mask, uint32_t interface, Ipv6Address nextHop)
+{
+  NS_LOG_FUNCTION (this << dst << mask << interface << nextHop);
+  NS_ASSERT (m_ipv6);
+
+  RouteEntry entry;
+  entry.interface = interface;
+  entry.nextHop = nextHop;
+  entry.route = BuildRoute (dst.CombinePrefix (mask), interface, nextHop);
+  m_routes.Insert (dst, mask.GetPrefixLength (), entry);
+}
+
+void Ipv6SrRouting::RemoveRoute (Ipv6Address dst, Ipv6Prefix mask)
+{
+  NS_LOG_FUNCTION (this << dst << mask);
+  m_routes.Remove (dst, mask.GetPrefixLength ());
+}
+
+uint32_t Ipv6SrRouting::GetNRoutes (void) const
+{
+  return m_routes.GetSize ();
+}
+
+void Ipv6SrRouting::AddSid (Segment sid)
+{
+  NS_LOG_FUNCTION (this << sid.GetAddress ());
+
+  SidFib::iterator it = m_sids.find (sid);
+  if (it != m_sids.end ())
+    {
+      it->second.refCount++;
+      return;
+    }
+
+  SidEntry &entry = m_sids[sid];
+  entry.refCount = 1;
+  entry.adjacency = false;
+  entry.interface = 0;
+}
+
+void Ipv6SrRouting::AddSid (Segment sid, uint32_t interface, Ipv6Address nextHop)
+{
+  NS_LOG_FUNCTION (this << sid.GetAddress () << interface << nextHop);
+  NS_ASSERT (m_ipv6);
+
+  AddSid (sid);
+  SidEntry &entry = m_sids[sid];
+  entry.adjacency = true;
+  entry.interface = interface;
+  entry.nextHop = nextHop;
+  entry.route = BuildRoute (sid.GetAddress (), interface, nextHop);
+}
+
+void Ipv6SrRouting::RemoveSid (Segment sid)
+{
+  NS_LOG_FUNCTION (this << sid.GetAddress ());
+
+  SidFib::iterator it = m_sids.find (sid);
+  if (it != m_sids.end () && --it->second.refCount == 0)
+    {
+      m_sids.erase (it);
+    }
+}
+
+uint32_t Ipv6SrRouting::GetNSids (void) const
+{
+  return m_sids.size ();
+}
+
+Ptr<Ipv6Route> Ipv6SrRouting::BuildRoute (Ipv6Address dst, uint32_t interface, Ipv6Address nextHop) const
+{
+  Ptr<Ipv6Route> route = Create<Ipv6Route> ();
+  route->SetDestination (dst);
+  route->SetGateway (nextHop);
+  route->SetOutputDevice (m_ipv6->GetNetDevice (interface));
+  route->SetSource (m_ipv6->SourceAddressSelection (interface, nextHop.IsAny () ? dst : nextHop));
+  return route;
+}
+
+Ptr<Ipv6Route> Ipv6SrRouting::LookupSid (const Segment &sid, Ptr<Packet> packet)
+{
+  SidFib::iterator it = m_sids.find (sid);
+  if (it == m_sids.end () && m_csidBlockLength)
+    {
+      it = m_sids.find (sid.GetActiveSid (m_csidBlockLength, m_csidLength));
+    }
+  if (it == m_sids.end ())
+    {
+      return 0;
+    }
+
+  SidEntry &entry = it->second;
+  if (entry.adjacency)
+    {
+      return m_ipv6->IsUp (entry.interface) ? entry.route : 0;
+    }
+  if (!entry.route)
+    {
+      Ipv6Header header;
+      Socket::SocketErrno err;
+      header.SetDestination (it->first.GetAddress ());
+      entry.route = m_ipv6->GetRoutingProtocol ()->RouteOutput (packet, header, 0, err);
+    }
+  return entry.route;
+}
+
+void Ipv6SrRouting::InvalidateSids (void)
+{
+  for (SidFib::iterator it = m_sids.begin (); it != m_sids.end (); it++)
+    {
+      if (!it->second.adjacency)
+        {
+          it->second.route = 0;
+        }
+    }
+}
+
+void Ipv6SrRouting::InsertSrh (Ptr<Packet> packet, Ipv6Header &header, const SegmentList &segments)
+{
+  NS_LOG_FUNCTION (packet << header << segments);
+
+  /* SRH order: the final destination is entry 0, the first SID the last entry */
+  SegmentList srhSegments;
+  srhSegments.Add (Segment (header.GetDestination ()));
+  for (uint32_t i = segments.GetN (); i > 0; i--)
+    {
+      srhSegments.Add (segments.Get (i - 1));
+    }
+  Ipv6ExtensionSegmentRoutingHeader srh;
+  srh.SetSegmentList (srhSegments);
+  srh.SetSegmentsLeft (segments.GetN ());
+  srh.SetNextHeader (header.GetNextHeader ());
+
+  packet->AddHeader (srh);
+
+  header.SetNextHeader (Ipv6Header::IPV6_EXT_ROUTING);
+  header.SetDestination (segments.Get (0).GetAddress ());
+  header.SetPayloadLength (packet->GetSize ());
+}
+
+Ptr<Ipv6Route> Ipv6SrRouting::RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
+{
+  NS_LOG_FUNCTION (this << header << oif);
+
+  /* policies only steer forwarded packets, routes apply to all of them */
+  Ipv6Address dst = header.GetDestination ();
+  const RouteEntry *entry = dst.IsMulticast () ? 0 : m_routes.Lookup (dst);
+  if (entry && m_ipv6->IsUp (entry->interface)
+      && (!oif || oif == entry->route->GetOutputDevice ()))
+    {
+      sockerr = Socket::ERROR_NOTERROR;
+      return BuildRoute (dst, entry->interface, entry->nextHop);
+    }
+
+  sockerr = Socket::ERROR_NOROUTETOHOST;
+  return 0;
+}
+
+bool Ipv6SrRouting::RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev,
+                                const UnicastForwardCallback &ucb, const MulticastForwardCallback &mcb,
+                                const LocalDeliverCallback &lcb, const ErrorCallback &ecb)
+{
+  NS_LOG_FUNCTION (this << p << header << idev);
+  NS_ASSERT (m_ipv6);
+
+  Ipv6Address dst = header.GetDestination ();
+  Ipv6Address src = header.GetSource ();
+
+  if (dst.IsMulticast () || dst.IsLinkLocal () || src.IsLinkLocal ())
+    {
+      return false;
+    }
+
+  /* SIDs bound with AddLocalSid need not be interface addresses */
+  if (header.GetNextHeader () == Ipv6Header::IPV6_EXT_ROUTING)
+    {
+      if (!m_srExtension)
+        {
+          Ptr<Ipv6ExtensionRoutingDemux> demux = m_ipv6->GetObject<Ipv6ExtensionRoutingDemux> ();
+          if (demux)
+            {
+              m_srExtension = DynamicCast<Ipv6ExtensionSegmentRouting> (demux->GetExtensionRouting (Ipv6ExtensionSegmentRouting::TYPE_ROUTING));
+            }
+        }
+      if (m_srExtension && m_srExtension->IsLocalSid (Segment (dst)))
+        {
+          lcb (p, header, m_ipv6->GetInterfaceForDevice (idev));
+          return true;
+        }
+    }
+
+  const SegmentList *segments = 0;
+  if (m_policyPaths.GetSize ())
+    {
+      const std::vector<PolicyPath> *paths = m_policyPaths.Lookup (dst);
+      if (paths)
+        {
+          segments = &SelectPath (*paths, TunnelNetDevice::GetFlowHash (header, p));
+        }
+    }
+  if (!segments)
+    {
+      segments = m_policies.Lookup (dst);
+    }
+  if (!segments)
+    {
+      uint8_t length;
+      segments = m_sourcePolicies.Lookup (src, length);
+      if (segments && dst.CombinePrefix (Ipv6Prefix (length)) == src.CombinePrefix (Ipv6Prefix (length)))
+        {
+          /* traffic inside the mobile network itself */
+          segments = 0;
+        }
+    }
+
+  if (segments)
+    {
+      Ptr<Packet> packet = p->Copy ();
+      Ipv6Header srHeader = header;
+      InsertSrh (packet, srHeader, *segments);
+
+      Ptr<Ipv6Route> route = LookupSid (segments->Get (0), packet);
+      if (!route)
+        {
+          Socket::SocketErrno err;
+          route = m_ipv6->GetRoutingProtocol ()->RouteOutput (packet, srHeader, 0, err);
+        }
+      if (!route)
+        {
+          NS_LOG_LOGIC ("No route to the first segment " << srHeader.GetDestination ());
+          return false;
+        }
+
+      NS_LOG_LOGIC ("Steering " << dst << " through " << srHeader.GetDestination ());
+      ucb (idev, route, packet, srHeader);
+      return true;
+    }
+
+  /* transit traffic to a SID of the table */
+  Ptr<Ipv6Route> route = m_sids.empty () ? 0 : LookupSid (Segment (dst), 0);
+  if (!route)
+    {
+      const RouteEntry *entry = m_routes.Lookup (dst);
+      if (entry && m_ipv6->IsUp (entry->interface))
+        {
+          route = entry->route;
+        }
+    }
+  if (!route)
+    {
+      return false;
+    }
+
+  NS_LOG_LOGIC ("Forwarding " << dst << " through interface " << m_ipv6->GetInterfaceForDevice (route->GetOutputDevice ()));
+  ucb (idev, route, p, header);
+  return true;
+}
+
+void Ipv6SrRouting::NotifyInterfaceUp (uint32_t interface)
+{
+  InvalidateSids ();
+}
+
+void Ipv6SrRouting::NotifyInterfaceDown (uint32_t interface)
+{
+  InvalidateSids ();
+}
+
+void Ipv6SrRouting::NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address)
+{
+  InvalidateSids ();
+}
+
+void Ipv6SrRouting::NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address)
+{
+  InvalidateSids ();
+}
+
+void Ipv6SrRouting::NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                                    Ipv6Address prefixToUse)
+{
+  InvalidateSids ();
+}
+
+void Ipv6SrRouting::NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                                       Ipv6Address prefixToUse)
+{
+  InvalidateSids ();
+}
+
+void Ipv6SrRouting::SetIpv6 (Ptr<Ipv6> ipv6)
+{
+  NS_LOG_FUNCTION (this << ipv6);
+  NS_ASSERT (!m_ipv6 && ipv6);
+  m_ipv6 = ipv6;
+}
+
+void Ipv6SrRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+  std::ostream* os = stream->GetStream ();
+
+  *os << "Node: " << m_ipv6->GetObject<Node> ()->GetId ()
+      << ", Time: " << Now ().As (unit)
+      << ", Local time: " << m_ipv6->GetObject<Node> ()->GetLocalTime ().As (unit)
+      << ", Ipv6SrRouting table" << std::endl;
+
+  PrintPolicies (*os, "dst", m_policies);
+  std::vector<PathTrie::Entry> paths = m_policyPaths.GetEntries ();
+  for (uint32_t i = 0; i < paths.size (); i++)
+    {
+      for (uint32_t j = 0; j < paths[i].value.size (); j++)
+        {
+          *os << "path " << paths[i].prefix << "/" << (uint32_t) paths[i].length << " weight " << paths[i].value[j].weight
+              << " via " << paths[i].value[j].segments << std::endl;
+        }
+    }
+  PrintPolicies (*os, "src", m_sourcePolicies);
+
+  std::vector<PrefixTrie<RouteEntry>::Entry> routes = m_routes.GetEntries ();
+  for (uint32_t i = 0; i < routes.size (); i++)
+    {
+      *os << "route " << routes[i].prefix << "/" << (uint32_t) routes[i].length
+          << " if " << routes[i].value.interface << " via " << routes[i].value.nextHop << std::endl;
+    }
+  for (SidFib::const_iterator it = m_sids.begin (); it != m_sids.end (); it++)
+    {
+      *os << "sid " << it->first.GetAddress ();
+      if (it->second.adjacency)
+        {
+          *os << " if " << it->second.interface << " via " << it->second.nextHop;
+        }
+      *os << std::endl;
+    }
+}
+
+void Ipv6SrRouting::PrintPolicies (std::ostream &os, const char *name, const PolicyTrie &policies)
+{
+  std::vector<PolicyTrie::Entry> entries = policies.GetEntries ();
+  for (uint32_t i = 0; i < entries.size (); i++)
+    {
+      os << name << " " << entries[i].prefix << "/" << (uint32_t) entries[i].length << " via " << entries[i].value << std::endl;
+    }
+}
+
+} /* namespace ns3 */
@@ -0,0 +1,335 @@
+#ifndef SR_ROUTING_H
+#define SR_ROUTING_H
+
+#include "ns3/ipv6-address.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6-routing-protocol.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/segment.h"
+#include "ns3/sgi-hashmap.h"
+#include "prefix-trie.h"
+
+#include <vector>
+
+namespace ns3 {
+
+class Node;
+class Packet;
+class Ipv6ExtensionSegmentRouting;
+
+/**
+ * \class Ipv6SrRouting
+ * \brief SRv6 head-end for binding traffic.
+ *
+ * Replaces the IPv6-in-IPv6 tunnels of the HA and the MR: packets matching
+ * a policy get a Segment Routing Header inserted and their destination set
+ * to the first SID, the rest of the path is handled by
+ * Ipv6ExtensionSegmentRouting on the SID owners. Policies only act on
+ * forwarded packets.
+ *
+ * It also holds the routes of the bindings (HoA and MNP towards the tunnel
+ * interface), and a SID forwarding table resolving the SIDs used by the
+ * policies. Policies and routes are kept in path-compressed tries, so the
+ * lookup cost depends on the prefix lengths and not on the number of
+ * bindings. It must be installed in an Ipv6ListRouting with a priority
+ * higher than the static routing.
+ *
+ * With CsidBlockLength set, the SID lists are compressed when the policies
+ * are added: consecutive SIDs of one locator block are packed in C-SID
+ * containers, so the SRH carries fewer entries. The SID owners need the
+ * same format on their Ipv6ExtensionSegmentRouting.
+ */
+class Ipv6SrRouting : public Ipv6RoutingProtocol
+{
+public:
+  /**
+   * \brief Interface ID
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief Constructor.
+   */
+  Ipv6SrRouting ();
+
+  /**
+   * \brief Destructor.
+   */
+  virtual ~Ipv6SrRouting ();
+
+  /**
+   * \brief Get the SR routing of a node, adding it to its Ipv6ListRouting if needed.
+   * \param node the node
+   * \return the SR routing, or 0 if the node does not use Ipv6ListRouting
+   */
+  static Ptr<Ipv6SrRouting> GetSrRouting (Ptr<Node> node);
+
+  /**
+   * \brief Steer the packets sent to a prefix through a SID list.
+   * \param dst destination prefix
+   * \param mask prefix mask
+   * \param segments the SIDs to traverse, first one first
+   */
+  void AddPolicy (Ipv6Address dst, Ipv6Prefix mask, SegmentList segments);
+
+  /**
+   * \brief Remove a destination policy.
+   * \param dst destination prefix
+   * \param mask prefix mask
+   */
+  void RemovePolicy (Ipv6Address dst, Ipv6Prefix mask);
+
+  /**
+   * \brief Spread the flows sent to a prefix over several SID lists.
+   *
+   * The flows are hashed on their 5-tuple and shared among the SID lists of
+   * the prefix in proportion to their weights. The paths take precedence
+   * over the policy of AddPolicy, RemovePolicy removes both. Adding a SID
+   * list again updates its weight, a weight of 0 removes it.
+   * \param dst destination prefix
+   * \param mask prefix mask
+   * \param segments the SIDs to traverse, first one first
+   * \param weight share of the flows
+   */
+  void AddPolicyPath (Ipv6Address dst, Ipv6Prefix mask, SegmentList segments, uint16_t weight);
+
+  /**
+   * \brief Steer the packets sourced from a prefix through a SID list (reverse tunnelling).
+   * \param src source prefix
+   * \param mask prefix mask
+   * \param segments the SIDs to traverse, first one first
+   */
+  void AddSourcePolicy (Ipv6Address src, Ipv6Prefix mask, SegmentList segments);
+
+  /**
+   * \brief Remove a source policy.
+   * \param src source prefix
+   * \param mask prefix mask
+   */
+  void RemoveSourcePolicy (Ipv6Address src, Ipv6Prefix mask);
+
+  /**
+   * \brief Get the number of policies.
+   * \return number of destination and source policies
+   */
+  uint32_t GetNPolicies (void) const;
+
+  /**
+   * \brief Add or replace a route.
+   * \param dst destination prefix
+   * \param mask prefix mask
+   * \param interface outgoing interface
+   * \param nextHop next hop, any for an on-link destination
+   */
+  void AddRoute (Ipv6Address dst, Ipv6Prefix mask, uint32_t interface, Ipv6Address nextHop = Ipv6Address::GetAny ());
+
+  /**
+   * \brief Remove a route.
+   * \param dst destination prefix
+   * \param mask prefix mask
+   */
+  void RemoveRoute (Ipv6Address dst, Ipv6Prefix mask);
+
+  /**
+   * \brief Get the number of routes.
+   * \return number of routes
+   */
+  uint32_t GetNRoutes (void) const;
+
+  /**
+   * \brief Add a reference to a SID, resolved through the other routing protocols.
+   *
+   * The route to the SID is cached until an interface, address or route
+   * change is notified.
+   * \param sid the SID
+   */
+  void AddSid (Segment sid);
+
+  /**
+   * \brief Add a reference to a SID reached through a given adjacency.
+   * \param sid the SID
+   * \param interface outgoing interface
+   * \param nextHop next hop, any for an on-link SID
+   */
+  void AddSid (Segment sid, uint32_t interface, Ipv6Address nextHop);
+
+  /**
+   * \brief Remove a reference to a SID.
+   * \param sid the SID
+   */
+  void RemoveSid (Segment sid);
+
+  /**
+   * \brief Get the number of SIDs.
+   * \return number of SIDs in the forwarding table
+   */
+  uint32_t GetNSids (void) const;
+
+  /**
+   * \brief Insert the SRH for a SID list in front of a packet payload.
+   * \param packet the packet (without IPv6 header)
+   * \param header the IPv6 header, updated in place
+   * \param segments the SIDs to traverse, first one first
+   */
+  static void InsertSrh (Ptr<Packet> packet, Ipv6Header &header, const SegmentList &segments);
+
+  // Inherited from Ipv6RoutingProtocol
+  virtual Ptr<Ipv6Route> RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
+  virtual bool RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev,
+                           const UnicastForwardCallback &ucb, const MulticastForwardCallback &mcb,
+                           const LocalDeliverCallback &lcb, const ErrorCallback &ecb);
+  virtual void NotifyInterfaceUp (uint32_t interface);
+  virtual void NotifyInterfaceDown (uint32_t interface);
+  virtual void NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address);
+  virtual void NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address);
+  virtual void NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                               Ipv6Address prefixToUse = Ipv6Address::GetZero ());
+  virtual void NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                                  Ipv6Address prefixToUse = Ipv6Address::GetZero ());
+  virtual void SetIpv6 (Ptr<Ipv6> ipv6);
+  virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+
+protected:
+  /**
+   * \brief Dispose this object.
+   */
+  virtual void DoDispose ();
+
+private:
+  /**
+   * \brief Policies keyed by prefix, the value is the SID list, first SID first.
+   */
+  typedef PrefixTrie<SegmentList> PolicyTrie;
+
+  /**
+   * \brief A SID list sharing the flows of a prefix.
+   */
+  struct PolicyPath
+  {
+    SegmentList segments;          //!< the SIDs to traverse, first one first
+    uint16_t weight;               //!< share of the flows
+  };
+
+  /**
+   * \brief Weighted SID lists keyed by prefix.
+   */
+  typedef PrefixTrie<std::vector<PolicyPath> > PathTrie;
+
+  /**
+   * \brief Route of a binding.
+   */
+  struct RouteEntry
+  {
+    uint32_t interface;     //!< outgoing interface
+    Ipv6Address nextHop;    //!< next hop, any if on-link
+    Ptr<Ipv6Route> route;   //!< route used to forward
+  };
+
+  /**
+   * \brief SID forwarding entry.
+   */
+  struct SidEntry
+  {
+    uint32_t refCount;      //!< references to the SID
+    bool adjacency;         //!< whether interface and next hop are given
+    uint32_t interface;     //!< outgoing interface of an adjacency
+    Ipv6Address nextHop;    //!< next hop of an adjacency
+    Ptr<Ipv6Route> route;   //!< resolved route, 0 if not resolved
+  };
+
+  /**
+   * \brief SID forwarding table.
+   */
+  typedef sgi::hash_map<Segment, SidEntry, SegmentHash> SidFib;
+
+  /**
+   * \brief Add or replace a policy, compressing its SID list.
+   * \param policies the policies
+   * \param prefix prefix
+   * \param mask prefix mask
+   * \param segments the SID list
+   */
+  void Insert (PolicyTrie &policies, Ipv6Address prefix, Ipv6Prefix mask, const SegmentList &segments);
+
+  /**
+   * \brief Pick the SID list of a flow.
+   * \param paths the weighted SID lists of the destination
+   * \param flowHash hash of the flow
+   * \return the SID list
+   */
+  static const SegmentList &SelectPath (const std::vector<PolicyPath> &paths, uint32_t flowHash);
+
+  /**
+   * \brief Build a route through an interface.
+   * \param dst the destination
+   * \param interface outgoing interface
+   * \param nextHop next hop, any if on-link
+   * \return the route
+   */
+  Ptr<Ipv6Route> BuildRoute (Ipv6Address dst, uint32_t interface, Ipv6Address nextHop) const;
+
+  /**
+   * \brief Get the route to a SID of the forwarding table.
+   *
+   * A C-SID container is looked up by its active SID.
+   * \param sid the SID
+   * \param packet the packet to route
+   * \return the route, or 0 if the SID is not in the table or has no route
+   */
+  Ptr<Ipv6Route> LookupSid (const Segment &sid, Ptr<Packet> packet);
+
+  /**
+   * \brief Drop the resolved routes of the SIDs.
+   */
+  void InvalidateSids (void);
+
+  /**
+   * \brief Print a policy trie.
+   * \param os the output stream
+   * \param name name of the table
+   * \param policies the policies
+   */
+  static void PrintPolicies (std::ostream &os, const char *name, const PolicyTrie &policies);
+
+  /**
+   * \brief The IPv6 stack.
+   */
+  Ptr<Ipv6> m_ipv6;
+
+  /**
+   * \brief The SRv6 extension, for the local SIDs.
+   */
+  Ptr<Ipv6ExtensionSegmentRouting> m_srExtension;
+
+  /**
+   * \brief Policies keyed by destination prefix.
+   */
+  PolicyTrie m_policies;
+
+  /**
+   * \brief Weighted SID lists keyed by destination prefix.
+   */
+  PathTrie m_policyPaths;
+
+  /**
+   * \brief Policies keyed by source prefix.
+   */
+  PolicyTrie m_sourcePolicies;
+
+  /**
+   * \brief Routes keyed by destination prefix.
+   */
+  PrefixTrie<RouteEntry> m_routes;
+
+  /**
+   * \brief SID forwarding table.
+   */
+  SidFib m_sids;
+
+  uint8_t m_csidBlockLength; //!< C-SID locator block length in bits, 0 without compression
+  uint8_t m_csidLength;      //!< C-SID length in bits
+};
+
+} /* namespace ns3 */
+
+#endif /* SR_ROUTING_H */
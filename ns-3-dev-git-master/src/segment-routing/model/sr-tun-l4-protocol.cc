@@ -33,12 +33,25 @@ TypeId Ipv6TunnelL4Protocol::GetTypeId ()
                      "Receive tunneled data packets from HA",
                      MakeTraceSourceAccessor (&Ipv6TunnelL4Protocol::m_rxMnPktTrace),
                      "ns3::Ipv6TunnelL4Protocol::RxTracedCallback")
+    .AddTraceSource ("Tx",
+                     "Data packets encapsulated by the tunnel device, the device may be created later",
+                     MakeTraceSourceAccessor (&Ipv6TunnelL4Protocol::m_txPktTrace),
+                     "ns3::TunnelNetDevice::TracedCallback2")
+    .AddTraceSource ("TunnelAdd",
+                     "A tunnel is added, on its first reference",
+                     MakeTraceSourceAccessor (&Ipv6TunnelL4Protocol::m_tunnelAddTrace),
+                     "ns3::Ipv6TunnelL4Protocol::TunnelTracedCallback")
+    .AddTraceSource ("TunnelRemove",
+                     "A tunnel is removed, with its last reference",
+                     MakeTraceSourceAccessor (&Ipv6TunnelL4Protocol::m_tunnelRemoveTrace),
+                     "ns3::Ipv6TunnelL4Protocol::TunnelTracedCallback")
     ;
   return tid;
 }
 
 Ipv6TunnelL4Protocol::Ipv6TunnelL4Protocol ()
-  : m_node (0)
+  : m_node (0),
+  m_tunnelIfIndex (-1)
 {
   SetHomeAddress("::");
 }
@@ -51,13 +64,8 @@ Ipv6TunnelL4Protocol::~Ipv6TunnelL4Protocol ()
 void Ipv6TunnelL4Protocol::DoDispose ()
 {
   m_node = 0;
-  
-  for ( TunnelMapI i = m_tunnelMap.begin(); i != m_tunnelMap.end(); i++ )
-    {
-	  i->second = 0;
-	}
-	
-  m_tunnelMap.clear();
+  m_tunnel = 0;
+  m_tunnelIfIndex = -1;
   IpL4Protocol::DoDispose ();
 }
 
@@ -68,10 +76,10 @@ void Ipv6TunnelL4Protocol::NotifyNewAggregate ()
   if (!m_node)
     {
       Ptr<Node> node = this->GetObject<Node> ();
-      if (!node)
+      if (node)
         {
           Ptr<Ipv6L3Protocol> ipv6 = this->GetObject<Ipv6L3Protocol> ();
-          if (!ipv6)
+          if (ipv6)
             {
               this->SetNode (node);
               ipv6->Insert (this);
@@ -104,7 +112,7 @@ void Ipv6TunnelL4Protocol::SendMessage (Ptr<Packet> packet, Ipv6Address src, Ipv
   NS_LOG_FUNCTION (this << packet << src << dst << (uint32_t)ttl);
   Ptr<Ipv6L3Protocol> ipv6 = m_node->GetObject<Ipv6L3Protocol> ();
   SocketIpTtlTag tag;
-  NS_ASSERT (!ipv6);
+  NS_ASSERT (ipv6);
 
   tag.SetTtl (ttl);
   packet->AddPacketTag (tag);
@@ -114,7 +122,7 @@ void Ipv6TunnelL4Protocol::SendMessage (Ptr<Packet> packet, Ipv6Address src, Ipv
 enum IpL4Protocol::RxStatus Ipv6TunnelL4Protocol::Receive(Ptr<Packet> p, Ipv6Header const &header, Ptr<Ipv6Interface> incomingInterface)
 {
   Ptr<Ipv6L3Protocol> ipv6 = GetNode()->GetObject<Ipv6L3Protocol>();
-  NS_ASSERT (!ipv6);
+  NS_ASSERT (ipv6);
   Ipv6Address src=header.GetSource ();
   /**
    * Check whether the packet belongs to one of tunnels
@@ -123,10 +131,10 @@ enum IpL4Protocol::RxStatus Ipv6TunnelL4Protocol::Receive(Ptr<Packet> p, Ipv6Hea
 
   Ptr<TunnelNetDevice> tdev = GetTunnelDevice (src);
 
-  if (!tdev && GetCacheAddressList().size())
+  if (!tdev && m_Cachelist.size())
   {
-    std::list<Ipv6Address>::iterator iter = std::find (GetCacheAddressList().begin(), GetCacheAddressList().end(), src);
-    if ( GetCacheAddressList().end() != iter )
+    std::list<Ipv6Address>::const_iterator iter = std::find (m_Cachelist.begin(), m_Cachelist.end(), src);
+    if ( m_Cachelist.end() != iter )
       tdev = GetTunnelDevice (GetHA());
   }
 
@@ -154,21 +162,7 @@ enum IpL4Protocol::RxStatus Ipv6TunnelL4Protocol::Receive(Ptr<Packet> p, Ipv6Hea
 	}
   
   NS_LOG_FUNCTION (source << destination);
-  //Prevent infinite loop
-  Ptr<Ipv6Route> route;
-  Socket::SocketErrno err;
-  Ptr<NetDevice> oif (0); //specify non-zero if bound to a source address
-  
-  Ipv6StaticRoutingHelper routingHelper;
-  
-  Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
-  
-  NS_ASSERT (routing);
-  
-  route = routing->RouteOutput (packet, innerHeader, oif, err);
-  NS_LOG_FUNCTION (source << destination);
-
-  if (destination.IsMatchingType(GetHomeAddress()))
+  if (destination == GetHomeAddress ())
 
   {
   NS_LOG_FUNCTION ("QQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQQ");
@@ -183,6 +177,20 @@ enum IpL4Protocol::RxStatus Ipv6TunnelL4Protocol::Receive(Ptr<Packet> p, Ipv6Hea
       }
   }
   NS_LOG_FUNCTION ("SSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSSS");
+  //Prevent infinite loop, only forwarded packets need a route: the tunnel
+  //interface of an MN has no global address to select a source from
+  Ptr<Ipv6Route> route;
+  Socket::SocketErrno err;
+  Ptr<NetDevice> oif (0); //specify non-zero if bound to a source address
+  
+  Ipv6StaticRoutingHelper routingHelper;
+  
+  Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
+  
+  NS_ASSERT (routing);
+  
+  route = routing->RouteOutput (packet, innerHeader, oif, err);
+
   m_rxHaPktTrace (packet, innerHeader, header, incomingInterface);
   ipv6->Send (packet, source, destination, innerHeader.GetNextHeader(), route);
   return IpL4Protocol::RX_OK;
@@ -190,82 +198,75 @@ enum IpL4Protocol::RxStatus Ipv6TunnelL4Protocol::Receive(Ptr<Packet> p, Ipv6Hea
 
 
 
-uint16_t Ipv6TunnelL4Protocol::AddTunnel(Ipv6Address remote, Ipv6Address local)
+uint16_t Ipv6TunnelL4Protocol::CreateTunnelDevice ()
 {
-  NS_LOG_FUNCTION (this << "In Addtunnel");
-  NS_LOG_FUNCTION (this << remote << local);
-  
-  //Search existing tunnel device
-  TunnelMapI it = m_tunnelMap.find (remote);
-  Ptr<TunnelNetDevice> dev = m_node->GetObject<TunnelNetDevice> ();
-  if (it == m_tunnelMap.end ())
+  NS_LOG_FUNCTION (this);
+
+  if (!m_tunnel)
     {
-  if(!dev)
-  {
-     dev = CreateObject<TunnelNetDevice> ();
-     
-     if (!TxTracedCallback.IsNull())
-       {
-         dev->TraceConnectWithoutContext ("MacTx2", TxTracedCallback);
-       }
-
-      dev->SetAddress (Mac48Address::Allocate ());
-      m_node->AddDevice (dev);
-      m_tunnelMap.insert (std::pair<Ipv6Address, Ptr<TunnelNetDevice> > (remote, dev));
- }     
-	  dev->SetRemoteAddress(remote);
-	  dev->SetLocalAddress(local);
+      m_tunnel = CreateObject<TunnelNetDevice> ();
+
+      if (!TxTracedCallback.IsNull())
+        {
+          m_tunnel->TraceConnectWithoutContext ("MacTx2", TxTracedCallback);
+        }
+      m_tunnel->TraceConnectWithoutContext ("MacTx2", MakeCallback (&Ipv6TunnelL4Protocol::NotifyTx, this));
+
+      //locally administered and taken from the node id: the address does not
+      //depend on the devices created by the other ranks
+      uint32_t id = m_node->GetId ();
+      uint8_t mac[6] = { 0x02, 0x00, uint8_t (id >> 24), uint8_t (id >> 16), uint8_t (id >> 8), uint8_t (id) };
+      Mac48Address address;
+      address.CopyFrom (mac);
+      m_tunnel->SetAddress (address);
+      m_node->AddDevice (m_tunnel);
+
+      Ptr<Ipv6> ipv6 = m_node->GetObject<Ipv6> ();
+      m_tunnelIfIndex = ipv6->AddInterface (m_tunnel);
+      NS_ASSERT_MSG (m_tunnelIfIndex >= 0, "Cannot add an IPv6 interface");
+
+      ipv6->SetMetric (m_tunnelIfIndex, 1);
+      ipv6->SetUp (m_tunnelIfIndex);
     }
 
-  else
+  return m_tunnelIfIndex;
+}
+
+uint16_t Ipv6TunnelL4Protocol::AddTunnel(Ipv6Address remote, Ipv6Address local)
+{
+  NS_LOG_FUNCTION (this << remote << local);
+
+  CreateTunnelDevice ();
+  bool added = !m_tunnel->HasRemote (remote);
+  m_tunnel->AddRemote (remote, local);
+  if (added)
     {
-      dev = it->second;
+      m_tunnelAddTrace (remote);
     }
-    
-  dev->IncreaseRefCount ();
-  Ptr<Ipv6> ipv6 = m_node->GetObject<Ipv6> ();
-  int32_t ifIndex = -1;
-  ifIndex = ipv6->GetInterfaceForDevice (dev);
-  
-  if (ifIndex == -1)
-    {
-	  ifIndex = ipv6->AddInterface (dev);
-	  NS_ASSERT_MSG (ifIndex >= 0, "Cannot add an IPv6 interface");
-	  
-	  ipv6->SetMetric (ifIndex, 1);
-	  ipv6->SetUp (ifIndex);
-	}
-  return ifIndex;
+  return m_tunnelIfIndex;
 }
 
 void Ipv6TunnelL4Protocol::RemoveTunnel(Ipv6Address remote)
 {
   NS_LOG_FUNCTION ( "Remove tunnel" << remote);
-  
-  Ptr<TunnelNetDevice> dev = GetTunnelDevice(remote);
 
-  if (dev)
+  if (m_tunnel && m_tunnel->RemoveRemote (remote))
     {
-	  dev->DecreaseRefCount ();
-	  
-	  if (dev->GetRefCount() == 0)
-	    {
-		  TunnelMapI it = m_tunnelMap.find (remote);
-          it->second = 0;
-          
-          m_tunnelMap.erase (it);
-		}
-	}    
+      m_tunnelRemoveTrace (remote);
+    }
+}
+
+void Ipv6TunnelL4Protocol::NotifyTx (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh)
+{
+  m_txPktTrace (packet, ih, oh);
 }
 
 uint16_t  Ipv6TunnelL4Protocol::ModifyTunnel(Ipv6Address remote, Ipv6Address newRemote, Ipv6Address local)
 {
   NS_LOG_FUNCTION ( this << remote << newRemote << local );
-  
-  Ptr<TunnelNetDevice> dev = GetTunnelDevice(remote);
-  NS_ASSERT (!dev);
-  NS_ASSERT (dev->GetRefCount() > 0);
-	  
+
+  NS_ASSERT (GetTunnelDevice (remote));
+
   RemoveTunnel (remote);
   return AddTunnel (newRemote, local);
 }
@@ -273,12 +274,10 @@ uint16_t  Ipv6TunnelL4Protocol::ModifyTunnel(Ipv6Address remote, Ipv6Address new
 Ptr<TunnelNetDevice> Ipv6TunnelL4Protocol::GetTunnelDevice(Ipv6Address remote)
 {
   NS_LOG_FUNCTION ( this << remote );
-  
-  TunnelMapI it = m_tunnelMap.find (remote);
-  
-  if (it != m_tunnelMap.end ())
+
+  if (m_tunnel && m_tunnel->HasRemote (remote))
     {
-      return it->second;
+      return m_tunnel;
     }
 
   return 0;
@@ -308,12 +307,12 @@ Ipv6Address Ipv6TunnelL4Protocol::GetHomeAddress()
 return m_hoa;
 }
 
-void Ipv6TunnelL4Protocol::SetCacheAddressList(std::list<Ipv6Address> list)
+void Ipv6TunnelL4Protocol::SetCacheAddressList(const std::list<Ipv6Address> &list)
 {
 m_Cachelist= list;
 }
 
-std::list<Ipv6Address> Ipv6TunnelL4Protocol::GetCacheAddressList()
+const std::list<Ipv6Address> &Ipv6TunnelL4Protocol::GetCacheAddressList() const
 {
 return m_Cachelist;
 }
@@ -6,6 +6,8 @@
 #include "ns3/tunnel-net-device.h"
 #include "ns3/traced-callback.h"
 
+#include <list>
+
 namespace ns3 {
 
 class Node;
@@ -97,16 +99,30 @@ public:
                                                Ipv4Header const &header,
                                                Ptr<Ipv4Interface> incomingInterface);
 
+  /**
+   * \brief Create the TunnelNetDevice and its IPv6 interface if needed
+   *
+   * The interface must not be added while a packet is being received, as
+   * this registers a protocol handler; an agent which adds tunnels from its
+   * message handlers creates the device beforehand.
+   * \returns the interface index of the tunnel device
+   */
+  uint16_t CreateTunnelDevice ();
+
   /**
    * \brief Add a tunnel
+   *
+   * All the tunnels share a single multipoint TunnelNetDevice and IPv6
+   * interface, created with the first tunnel. Adding an existing tunnel
+   * increases its ref count.
    * \param remote remote address
    * \param local local address
-   * \returns the status of tunnel add
+   * \returns the interface index of the tunnel device
    */
   uint16_t AddTunnel (Ipv6Address remote, Ipv6Address local = Ipv6Address::GetZero ());
 
   /**
-   * \brief Remove a tunnel
+   * \brief Remove a reference to a tunnel
    * \param remote remote address
    */
   void RemoveTunnel (Ipv6Address remote);
@@ -123,7 +139,7 @@ public:
   /**
    * \brief get tunnel net device
    * \param remote remote address
-   * \returns the associated net device
+   * \returns the tunnel device if it has the remote, 0 otherwise
    */
   Ptr<TunnelNetDevice> GetTunnelDevice (Ipv6Address remote);
 
@@ -143,13 +159,13 @@ public:
    * \brief set home agent address list
    * \param list IPv6 address list
    */
-  void SetCacheAddressList (std::list<Ipv6Address> list);
+  void SetCacheAddressList (const std::list<Ipv6Address> &list);
 
   /**
    * \brief get home agent address list
    * \returns IPv6 address list
    */
-  std::list<Ipv6Address> GetCacheAddressList ();
+  const std::list<Ipv6Address> &GetCacheAddressList () const;
 
   /**
    * \brief set home agent address which is chosen by an MN
@@ -186,6 +202,13 @@ public:
   typedef void (* RxTracedCallback)
     (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh, Ptr<Ipv6Interface> interface);
 
+  /**
+   * TracedCallback signature for the tunnels added and removed.
+   *
+   * \param [in] remote the remote address of the tunnel
+   */
+  typedef void (* TunnelTracedCallback) (Ipv6Address remote);
+
 protected:
   /**
    * \brief Dispose this object.
@@ -194,25 +217,20 @@ protected:
 
 private:
 
-  /**
-   * \brief mapping of tunnelnetdevice with remote address.
-  */
-  typedef std::map<Ipv6Address, Ptr<TunnelNetDevice> > TunnelMap;
-
-  /**
-   * \brief iterator of the mapping of tunnelnetdevice with remote address.
-  */
-  typedef std::map<Ipv6Address, Ptr<TunnelNetDevice> >::iterator TunnelMapI;
-
   /**
    * \brief The node.
    */
   Ptr<Node> m_node;
 
   /**
-   * \brief create a tunnel map.
+   * \brief multipoint tunnel device.
   */
-  TunnelMap m_tunnelMap;
+  Ptr<TunnelNetDevice> m_tunnel;
+
+  /**
+   * \brief interface index of the tunnel device.
+  */
+  int32_t m_tunnelIfIndex;
 
   /**
    * \brief home address.
@@ -238,6 +256,29 @@ private:
    * \brief Callback to trace RX (reception) data packets at MN.
    */ 
   TracedCallback<Ptr<Packet>, Ipv6Header, Ipv6Header, Ptr<Ipv6Interface> > m_rxMnPktTrace;
+
+  /**
+   * \brief forward the MacTx2 trace of the tunnel device.
+   * \param packet the encapsulated packet
+   * \param ih IPv6 inner header
+   * \param oh IPv6 outer header
+   */
+  void NotifyTx (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh);
+
+  /**
+   * \brief Callback to trace the packets encapsulated by the tunnel device.
+   */
+  TracedCallback<Ptr<Packet>, Ipv6Header, Ipv6Header> m_txPktTrace;
+
+  /**
+   * \brief Callback to trace the first reference to a tunnel.
+   */
+  TracedCallback<Ipv6Address> m_tunnelAddTrace;
+
+  /**
+   * \brief Callback to trace the release of the last reference to a tunnel.
+   */
+  TracedCallback<Ipv6Address> m_tunnelRemoveTrace;
 };
 
 } /* namespace ns3 */
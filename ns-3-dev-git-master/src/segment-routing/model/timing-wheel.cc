@@ -0,0 +1,367 @@
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "timing-wheel.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimingWheel");
+NS_OBJECT_ENSURE_REGISTERED (TimingWheel);
+
+/* each level has 256 slots */
+static const uint32_t WHEEL_BITS = 8;
+static const uint32_t WHEEL_SLOTS = 1 << WHEEL_BITS;
+static const uint32_t WHEEL_MASK = WHEEL_SLOTS - 1;
+static const uint32_t WHEEL_LEVELS = 4;
+
+TypeId TimingWheel::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::TimingWheel")
+    .SetParent<Object> ()
+    .AddConstructor<TimingWheel> ()
+    .AddAttribute ("Granularity",
+                   "Tick of the wheel, timers expire on the first tick after their delay.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&TimingWheel::m_granularity),
+                   MakeTimeChecker (TimeStep (1)))
+  ;
+  return tid;
+}
+
+TimingWheel::TimingWheel ()
+  : m_currentTick (0),
+  m_nextTick (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+      m_nTimers[level] = 0;
+    }
+}
+
+TimingWheel::~TimingWheel ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+void TimingWheel::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  /* the timers may outlive the wheel, leave them stopped */
+  for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+      for (uint32_t i = 0; i < m_slots[level].size (); i++)
+        {
+          for (Slot::iterator it = m_slots[level][i].begin (); it != m_slots[level][i].end (); it++)
+            {
+              (*it)->m_slot = 0;
+            }
+        }
+      m_slots[level].clear ();
+      m_nTimers[level] = 0;
+    }
+  for (Slot::iterator it = m_expiring.begin (); it != m_expiring.end (); it++)
+    {
+      (*it)->m_slot = 0;
+    }
+  m_expiring.clear ();
+  m_event.Cancel ();
+  Object::DoDispose ();
+}
+
+Ptr<TimingWheel> TimingWheel::GetTimingWheel (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (node);
+
+  Ptr<TimingWheel> wheel = node->GetObject<TimingWheel> ();
+  if (!wheel)
+    {
+      wheel = CreateObject<TimingWheel> ();
+      node->AggregateObject (wheel);
+    }
+  return wheel;
+}
+
+uint32_t TimingWheel::GetNTimers () const
+{
+  uint32_t n = 0;
+  for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+    {
+      n += m_nTimers[level];
+    }
+  return n;
+}
+
+void TimingWheel::Add (TimingWheelTimer *timer, Time delay)
+{
+  NS_LOG_FUNCTION (this << timer << delay);
+  NS_ASSERT (!timer->m_slot);
+
+  if (m_slots[0].empty ())
+    {
+      for (uint32_t level = 0; level < WHEEL_LEVELS; level++)
+        {
+          m_slots[level].resize (WHEEL_SLOTS);
+        }
+    }
+
+  uint64_t granularity = m_granularity.GetTimeStep ();
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  uint64_t nowTick = now / granularity;
+  if (GetNTimers () == 0 && m_expiring.empty ())
+    {
+      /* idle wheel, no cascade pending */
+      m_currentTick = nowTick;
+    }
+  else
+    {
+      /* nothing expires nor cascades before the pending tick: catch up with
+         the clock so the timer is placed, and its cascade scheduled, from now */
+      uint64_t tick = nowTick;
+      if (m_event.IsRunning () && m_nextTick <= tick)
+        {
+          tick = m_nextTick - 1;
+        }
+      if (tick > m_currentTick)
+        {
+          m_currentTick = tick;
+        }
+    }
+
+  uint64_t expiry = (now + delay.GetTimeStep () + granularity - 1) / granularity;
+  if (expiry <= m_currentTick)
+    {
+      expiry = m_currentTick + 1;
+    }
+  timer->m_expiry = expiry;
+  Insert (timer);
+
+  /* upper levels need the event at the cascade of their slot */
+  uint64_t tick = (expiry >> (WHEEL_BITS * timer->m_level)) << (WHEEL_BITS * timer->m_level);
+  if (!m_event.IsRunning () || tick < m_nextTick)
+    {
+      m_event.Cancel ();
+      m_nextTick = tick;
+      m_event = Simulator::Schedule (TimeStep (tick * granularity) - Simulator::Now (), &TimingWheel::Tick, this);
+    }
+}
+
+void TimingWheel::Remove (TimingWheelTimer *timer)
+{
+  NS_LOG_FUNCTION (this << timer);
+  NS_ASSERT (timer->m_slot);
+
+  timer->m_slot->erase (timer->m_position);
+  timer->m_slot = 0;
+  m_nTimers[timer->m_level]--;
+
+  if (GetNTimers () == 0)
+    {
+      m_event.Cancel ();
+    }
+}
+
+void TimingWheel::Insert (TimingWheelTimer *timer)
+{
+  uint64_t delta = timer->m_expiry - m_currentTick;
+  uint32_t level = 0;
+  while (level < WHEEL_LEVELS - 1 && delta >> (WHEEL_BITS * (level + 1)))
+    {
+      level++;
+    }
+
+  Slot &slot = m_slots[level][(timer->m_expiry >> (WHEEL_BITS * level)) & WHEEL_MASK];
+  timer->m_position = slot.insert (slot.end (), timer);
+  timer->m_slot = &slot;
+  timer->m_level = level;
+  m_nTimers[level]++;
+}
+
+void TimingWheel::Cascade (uint32_t level)
+{
+  Slot cascading;
+  cascading.splice (cascading.end (), m_slots[level][(m_currentTick >> (WHEEL_BITS * level)) & WHEEL_MASK]);
+  m_nTimers[level] -= cascading.size ();
+
+  while (!cascading.empty ())
+    {
+      TimingWheelTimer *timer = cascading.front ();
+      cascading.pop_front ();
+      Insert (timer);
+    }
+}
+
+void TimingWheel::Tick ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_currentTick = m_nextTick;
+
+  if ((m_currentTick & WHEEL_MASK) == 0)
+    {
+      for (uint32_t level = 1; level < WHEEL_LEVELS; level++)
+        {
+          Cascade (level);
+          if ((m_currentTick >> (WHEEL_BITS * level)) & WHEEL_MASK)
+            {
+              break;
+            }
+        }
+    }
+
+  /* the callbacks may start or stop any timer, including the expiring ones */
+  m_expiring.splice (m_expiring.end (), m_slots[0][m_currentTick & WHEEL_MASK]);
+  for (Slot::iterator it = m_expiring.begin (); it != m_expiring.end (); it++)
+    {
+      (*it)->m_slot = &m_expiring;
+    }
+
+  while (!m_expiring.empty ())
+    {
+      TimingWheelTimer *timer = m_expiring.front ();
+      m_expiring.pop_front ();
+      timer->m_slot = 0;
+      m_nTimers[0]--;
+      timer->Expire ();
+    }
+
+  ScheduleTick ();
+}
+
+void TimingWheel::ScheduleTick ()
+{
+  if (GetNTimers () == 0)
+    {
+      m_event.Cancel ();
+      return;
+    }
+
+  uint64_t next = 0;
+  if (m_nTimers[0] > 0)
+    {
+      for (uint64_t tick = m_currentTick + 1; tick < m_currentTick + WHEEL_SLOTS; tick++)
+        {
+          if (!m_slots[0][tick & WHEEL_MASK].empty ())
+            {
+              next = tick;
+              break;
+            }
+        }
+    }
+  for (uint32_t level = 1; level < WHEEL_LEVELS; level++)
+    {
+      if (m_nTimers[level] == 0)
+        {
+          continue;
+        }
+      /* every slot of a level is cascaded once per turn */
+      uint64_t block = (m_currentTick >> (WHEEL_BITS * level)) + 1;
+      for (uint32_t i = 0; i < WHEEL_SLOTS; i++, block++)
+        {
+          if (!m_slots[level][block & WHEEL_MASK].empty ())
+            {
+              uint64_t cascade = block << (WHEEL_BITS * level);
+              if (next == 0 || cascade < next)
+                {
+                  next = cascade;
+                }
+              break;
+            }
+        }
+    }
+
+  if (m_event.IsRunning () && m_nextTick == next)
+    {
+      return;
+    }
+  m_event.Cancel ();
+  m_nextTick = next;
+  m_event = Simulator::Schedule (TimeStep (next * m_granularity.GetTimeStep ()) - Simulator::Now (), &TimingWheel::Tick, this);
+}
+
+
+TimingWheelTimer::TimingWheelTimer ()
+  : m_timer (Timer::CANCEL_ON_DESTROY),
+  m_slot (0),
+  m_level (0),
+  m_expiry (0)
+{
+  m_timer.SetFunction (&TimingWheelTimer::Expire, this);
+}
+
+TimingWheelTimer::~TimingWheelTimer ()
+{
+  Cancel ();
+}
+
+void TimingWheelTimer::SetTimingWheel (Ptr<TimingWheel> wheel)
+{
+  Cancel ();
+  m_wheel = wheel;
+}
+
+void TimingWheelTimer::SetFunction (Callback<void> callback)
+{
+  m_callback = callback;
+}
+
+void TimingWheelTimer::SetDelay (const Time &delay)
+{
+  m_delay = delay;
+}
+
+void TimingWheelTimer::Schedule ()
+{
+  Schedule (m_delay);
+}
+
+void TimingWheelTimer::Schedule (Time delay)
+{
+  if (IsRunning ())
+    {
+      NS_FATAL_ERROR ("Timer is still running while re-scheduling.");
+    }
+
+  if (m_wheel)
+    {
+      m_wheel->Add (this, delay);
+    }
+  else
+    {
+      m_timer.Schedule (delay);
+    }
+}
+
+void TimingWheelTimer::Cancel ()
+{
+  if (m_slot)
+    {
+      m_wheel->Remove (this);
+    }
+  m_timer.Cancel ();
+}
+
+bool TimingWheelTimer::IsRunning () const
+{
+  return m_slot != 0 || m_timer.IsRunning ();
+}
+
+Time TimingWheelTimer::GetDelayLeft () const
+{
+  if (m_slot)
+    {
+      Time left = TimeStep (m_expiry * m_wheel->m_granularity.GetTimeStep ()) - Simulator::Now ();
+      return left.IsStrictlyPositive () ? left : Time (0);
+    }
+  return m_timer.GetDelayLeft ();
+}
+
+void TimingWheelTimer::Expire ()
+{
+  m_callback ();
+}
+
+} /* namespace ns3 */
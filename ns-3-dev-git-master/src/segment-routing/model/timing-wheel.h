@@ -0,0 +1,287 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <list>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include "ns3/timer.h"
+
+namespace ns3 {
+
+class Node;
+class TimingWheelTimer;
+
+/**
+ * \class TimingWheel
+ * \brief Per-node hierarchical timing wheel for binding timers.
+ *
+ * Timers are rounded up to the wheel granularity and kept in four levels of
+ * 256 slots. The wheel posts a single scheduler event for the next occupied
+ * tick (or the next cascade of an upper level), so starting, stopping and
+ * restarting timers does not touch the global event queue.
+ */
+class TimingWheel : public Object
+{
+public:
+  /**
+   * \brief Get the type identifier.
+   * \return type identifier
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief constructor.
+   */
+  TimingWheel ();
+
+  /**
+   * \brief destructor.
+   */
+  virtual ~TimingWheel ();
+
+  /**
+   * \brief get the timing wheel of a node, aggregating one if needed.
+   * \param node the node
+   * \return the timing wheel
+   */
+  static Ptr<TimingWheel> GetTimingWheel (Ptr<Node> node);
+
+  /**
+   * \brief get the number of running timers.
+   * \return number of timers
+   */
+  uint32_t GetNTimers () const;
+
+protected:
+  /**
+   * \brief Dispose this object.
+   */
+  virtual void DoDispose ();
+
+private:
+  friend class TimingWheelTimer;
+
+  /**
+   * \brief timers expiring in the same slot
+   */
+  typedef std::list<TimingWheelTimer *> Slot;
+
+  /**
+   * \brief start a timer.
+   * \param timer the timer
+   * \param delay delay from now
+   */
+  void Add (TimingWheelTimer *timer, Time delay);
+
+  /**
+   * \brief stop a timer.
+   * \param timer the timer
+   */
+  void Remove (TimingWheelTimer *timer);
+
+  /**
+   * \brief put a timer in the slot of its expiry tick, relative to the current tick.
+   * \param timer the timer
+   */
+  void Insert (TimingWheelTimer *timer);
+
+  /**
+   * \brief move the timers of an upper level slot to the lower levels.
+   * \param level the level
+   */
+  void Cascade (uint32_t level);
+
+  /**
+   * \brief expire the timers of the current tick.
+   */
+  void Tick ();
+
+  /**
+   * \brief schedule the event of the next occupied tick.
+   */
+  void ScheduleTick ();
+
+  /**
+   * \brief slots of each level
+   */
+  std::vector<Slot> m_slots[4];
+
+  /**
+   * \brief timers in each level
+   */
+  uint32_t m_nTimers[4];
+
+  /**
+   * \brief timers being expired
+   */
+  Slot m_expiring;
+
+  /**
+   * \brief tick duration
+   */
+  Time m_granularity;
+
+  /**
+   * \brief last processed tick, or the tick timers are placed from
+   */
+  uint64_t m_currentTick;
+
+  /**
+   * \brief tick of the pending event
+   */
+  uint64_t m_nextTick;
+
+  /**
+   * \brief the pending event
+   */
+  EventId m_event;
+};
+
+/**
+ * \class TimingWheelTimer
+ * \brief Timer running either on a TimingWheel or on its own ns3::Timer.
+ *
+ * Mirrors the ns3::Timer calls used by BList, so the binding timers can be
+ * moved to a timing wheel by calling SetTimingWheel. The timer is cancelled
+ * when destroyed.
+ */
+class TimingWheelTimer
+{
+public:
+  /**
+   * \brief constructor.
+   */
+  TimingWheelTimer ();
+
+  /**
+   * \brief destructor.
+   */
+  ~TimingWheelTimer ();
+
+  /**
+   * \brief run the timer on a timing wheel, cancelling it if running.
+   * \param wheel the timing wheel, or 0 for a plain ns3::Timer
+   */
+  void SetTimingWheel (Ptr<TimingWheel> wheel);
+
+  /**
+   * \brief set the function to call on expiry.
+   * \param memPtr the member function
+   * \param objPtr the object
+   */
+  template <typename MEM_PTR, typename OBJ_PTR>
+  void SetFunction (MEM_PTR memPtr, OBJ_PTR objPtr);
+
+  /**
+   * \brief set the callback to call on expiry.
+   * \param callback the callback
+   */
+  void SetFunction (Callback<void> callback);
+
+  /**
+   * \brief set the delay used by Schedule ().
+   * \param delay the delay
+   */
+  void SetDelay (const Time &delay);
+
+  /**
+   * \brief start the timer with the configured delay.
+   */
+  void Schedule ();
+
+  /**
+   * \brief start the timer.
+   * \param delay the delay
+   */
+  void Schedule (Time delay);
+
+  /**
+   * \brief stop the timer.
+   */
+  void Cancel ();
+
+  /**
+   * \brief whether the timer is running.
+   * \return status
+   */
+  bool IsRunning () const;
+
+  /**
+   * \brief get the time left before the expiry.
+   * \return the delay left, zero if not running
+   */
+  Time GetDelayLeft () const;
+
+private:
+  friend class TimingWheel;
+
+  /**
+   * \brief no copy, the wheel keeps pointers to the timer
+   */
+  TimingWheelTimer (const TimingWheelTimer &);
+
+  /**
+   * \brief no copy, the wheel keeps pointers to the timer
+   * \return this
+   */
+  TimingWheelTimer &operator = (const TimingWheelTimer &);
+
+  /**
+   * \brief call the expiry callback.
+   */
+  void Expire ();
+
+  /**
+   * \brief the timer used without a wheel
+   */
+  Timer m_timer;
+
+  /**
+   * \brief the timing wheel
+   */
+  Ptr<TimingWheel> m_wheel;
+
+  /**
+   * \brief expiry callback
+   */
+  Callback<void> m_callback;
+
+  /**
+   * \brief delay used by Schedule ()
+   */
+  Time m_delay;
+
+  /**
+   * \brief wheel slot holding the timer, 0 if not on the wheel
+   */
+  TimingWheel::Slot *m_slot;
+
+  /**
+   * \brief position in the wheel slot
+   */
+  TimingWheel::Slot::iterator m_position;
+
+  /**
+   * \brief wheel level of the slot
+   */
+  uint32_t m_level;
+
+  /**
+   * \brief expiry tick on the wheel
+   */
+  uint64_t m_expiry;
+};
+
+template <typename MEM_PTR, typename OBJ_PTR>
+void
+TimingWheelTimer::SetFunction (MEM_PTR memPtr, OBJ_PTR objPtr)
+{
+  SetFunction (MakeCallback (memPtr, objPtr));
+}
+
+} /* namespace ns3 */
+
+#endif /* TIMING_WHEEL_H */
@@ -6,16 +6,22 @@
 #include "ns3/uinteger.h"
 #include "ns3/llc-snap-header.h"
 #include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-list-routing.h"
 #include "ns3/ipv6-routing-protocol.h"
 #include "ns3/ipv6-route.h"
 #include "ns3/ipv6-header.h"
+#include "ns3/hash.h"
 #include "tunnel-net-device.h"
 
+#include <algorithm>
+#include <cstring>
+
 NS_LOG_COMPONENT_DEFINE ("TunnelNetDevice");
 
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (TunnelNetDevice);
+NS_OBJECT_ENSURE_REGISTERED (TunnelRouteWatcher);
 
 TypeId
 TunnelNetDevice::GetTypeId (void)
@@ -63,9 +69,9 @@ TunnelNetDevice::GetTypeId (void)
 
 TunnelNetDevice::TunnelNetDevice ()
   : m_localAddress ("::"),
-  m_remoteAddress ("::"),
-  m_refCount (1)
+  m_remoteAddress ("::")
 {
+  InitEncap (m_default, m_remoteAddress, m_localAddress);
   m_needsArp = false;
   m_supportsSendFrom = true;
   m_isPointToPoint = true;
@@ -109,6 +115,12 @@ TunnelNetDevice::~TunnelNetDevice ()
 
 void TunnelNetDevice::DoDispose ()
 {
+  m_encaps.clear ();
+  m_destinations.clear ();
+  m_bicasts.clear ();
+  m_paths.clear ();
+  m_default.route = 0;
+  m_ipv6 = 0;
   m_node = 0;
   NetDevice::DoDispose ();
 }
@@ -125,6 +137,7 @@ void TunnelNetDevice::SetLocalAddress (Ipv6Address laddr)
   NS_LOG_FUNCTION ( this << laddr );
 
   m_localAddress = laddr;
+  InitEncap (m_default, m_remoteAddress, m_localAddress);
 }
 
 Ipv6Address TunnelNetDevice::GetRemoteAddress () const
@@ -139,24 +152,445 @@ void TunnelNetDevice::SetRemoteAddress (Ipv6Address raddr)
   NS_LOG_FUNCTION ( this << raddr );
 
   m_remoteAddress = raddr;
+  InitEncap (m_default, m_remoteAddress, m_localAddress);
 }
 
-void TunnelNetDevice::IncreaseRefCount ()
+void TunnelNetDevice::AddRemote (Ipv6Address remote, Ipv6Address local)
 {
-  NS_LOG_FUNCTION (this);
-  m_refCount++;
+  NS_LOG_FUNCTION (this << remote << local);
+
+  EncapTable::iterator it = m_encaps.find (remote);
+  if (it != m_encaps.end ())
+    {
+      it->second.refCount++;
+      return;
+    }
+
+  Encap &encap = m_encaps[remote];
+  InitEncap (encap, remote, local);
+  encap.refCount = 1;
 }
 
-void TunnelNetDevice::DecreaseRefCount ()
+bool TunnelNetDevice::RemoveRemote (Ipv6Address remote)
 {
-  NS_LOG_FUNCTION (this);
-  m_refCount--;
+  NS_LOG_FUNCTION (this << remote);
+
+  EncapTable::iterator it = m_encaps.find (remote);
+  if (it == m_encaps.end ())
+    {
+      return false;
+    }
+  if (--it->second.refCount > 0)
+    {
+      return false;
+    }
+
+  std::vector<std::pair<Ipv6Address, uint8_t> > destinations;
+  destinations.swap (it->second.destinations);
+  m_encaps.erase (it);
+  for (uint32_t i = 0; i < destinations.size (); i++)
+    {
+      RemoveDestination (destinations[i].first, Ipv6Prefix (destinations[i].second));
+    }
+  for (DestinationTable::iterator table = m_bicasts.begin (); table != m_bicasts.end (); )
+    {
+      for (RemoteMap::iterator it = table->second.begin (); it != table->second.end (); )
+        {
+          if (it->second == remote)
+            {
+              table->second.erase (it++);
+            }
+          else
+            {
+              it++;
+            }
+        }
+      if (table->second.empty ())
+        {
+          m_bicasts.erase (table++);
+        }
+      else
+        {
+          table++;
+        }
+    }
+  for (PathTable::iterator table = m_paths.begin (); table != m_paths.end (); )
+    {
+      for (PathMap::iterator it = table->second.begin (); it != table->second.end (); )
+        {
+          std::vector<Path> &paths = it->second;
+          for (std::vector<Path>::iterator path = paths.begin (); path != paths.end (); )
+            {
+              path = path->remote == remote ? paths.erase (path) : path + 1;
+            }
+          if (paths.empty ())
+            {
+              table->second.erase (it++);
+            }
+          else
+            {
+              it++;
+            }
+        }
+      if (table->second.empty ())
+        {
+          m_paths.erase (table++);
+        }
+      else
+        {
+          table++;
+        }
+    }
+  return true;
+}
+
+bool TunnelNetDevice::HasRemote (Ipv6Address remote) const
+{
+  return m_encaps.find (remote) != m_encaps.end ();
+}
+
+uint32_t TunnelNetDevice::GetRemoteRefCount (Ipv6Address remote) const
+{
+  EncapTable::const_iterator it = m_encaps.find (remote);
+  return it != m_encaps.end () ? it->second.refCount : 0;
+}
+
+uint32_t TunnelNetDevice::GetNRemotes () const
+{
+  return m_encaps.size ();
+}
+
+void TunnelNetDevice::AddDestination (Ipv6Address destination, Ipv6Prefix prefix, Ipv6Address remote)
+{
+  NS_LOG_FUNCTION (this << destination << prefix << remote);
+
+  EncapTable::iterator it = m_encaps.find (remote);
+  NS_ASSERT_MSG (it != m_encaps.end (), "No tunnel to " << remote);
+
+  uint8_t length = prefix.GetPrefixLength ();
+  Ipv6Address masked = destination.CombinePrefix (prefix);
+  RemoveDestination (masked, prefix);
+  m_destinations[length][masked] = remote;
+  it->second.destinations.push_back (std::make_pair (masked, length));
+}
+
+void TunnelNetDevice::RemoveDestination (Ipv6Address destination, Ipv6Prefix prefix)
+{
+  NS_LOG_FUNCTION (this << destination << prefix);
+
+  uint8_t length = prefix.GetPrefixLength ();
+  DestinationTable::iterator table = m_destinations.find (length);
+  if (table == m_destinations.end ())
+    {
+      return;
+    }
+  Ipv6Address masked = destination.CombinePrefix (prefix);
+  RemoteMap::iterator dit = table->second.find (masked);
+  if (dit == table->second.end ())
+    {
+      return;
+    }
+
+  EncapTable::iterator it = m_encaps.find (dit->second);
+  if (it != m_encaps.end ())
+    {
+      std::vector<std::pair<Ipv6Address, uint8_t> > &destinations = it->second.destinations;
+      destinations.erase (std::find (destinations.begin (), destinations.end (), std::make_pair (masked, length)));
+    }
+  table->second.erase (dit);
+  if (table->second.empty ())
+    {
+      m_destinations.erase (table);
+    }
+}
+
+void TunnelNetDevice::AddBicast (Ipv6Address destination, Ipv6Prefix prefix, Ipv6Address remote)
+{
+  NS_LOG_FUNCTION (this << destination << prefix << remote);
+  NS_ASSERT_MSG (m_encaps.find (remote) != m_encaps.end (), "No tunnel to " << remote);
+
+  m_bicasts[prefix.GetPrefixLength ()][destination.CombinePrefix (prefix)] = remote;
+}
+
+void TunnelNetDevice::RemoveBicast (Ipv6Address destination, Ipv6Prefix prefix)
+{
+  NS_LOG_FUNCTION (this << destination << prefix);
+
+  DestinationTable::iterator table = m_bicasts.find (prefix.GetPrefixLength ());
+  if (table == m_bicasts.end ())
+    {
+      return;
+    }
+  table->second.erase (destination.CombinePrefix (prefix));
+  if (table->second.empty ())
+    {
+      m_bicasts.erase (table);
+    }
 }
 
-uint32_t TunnelNetDevice::GetRefCount () const
+Ipv6Address TunnelNetDevice::LookupBicast (Ipv6Address destination) const
+{
+  return Lookup (m_bicasts, destination);
+}
+
+void TunnelNetDevice::AddPath (Ipv6Address destination, Ipv6Prefix prefix, Ipv6Address remote, uint16_t weight)
+{
+  NS_LOG_FUNCTION (this << destination << prefix << remote << weight);
+  NS_ASSERT_MSG (m_encaps.find (remote) != m_encaps.end (), "No tunnel to " << remote);
+
+  uint8_t length = prefix.GetPrefixLength ();
+  PathMap &table = m_paths[length];
+  std::vector<Path> &paths = table[destination.CombinePrefix (prefix)];
+  std::vector<Path>::iterator it;
+  for (it = paths.begin (); it != paths.end () && it->remote != remote; it++)
+    {
+    }
+  if (weight == 0)
+    {
+      if (it != paths.end ())
+        {
+          paths.erase (it);
+        }
+      if (paths.empty ())
+        {
+          RemovePaths (destination, prefix);
+        }
+      return;
+    }
+  if (it == paths.end ())
+    {
+      Path path;
+      path.remote = remote;
+      paths.push_back (path);
+      it = paths.end () - 1;
+    }
+  it->weight = weight;
+}
+
+void TunnelNetDevice::RemovePaths (Ipv6Address destination, Ipv6Prefix prefix)
+{
+  NS_LOG_FUNCTION (this << destination << prefix);
+
+  PathTable::iterator table = m_paths.find (prefix.GetPrefixLength ());
+  if (table == m_paths.end ())
+    {
+      return;
+    }
+  table->second.erase (destination.CombinePrefix (prefix));
+  if (table->second.empty ())
+    {
+      m_paths.erase (table);
+    }
+}
+
+uint32_t TunnelNetDevice::GetNPaths (Ipv6Address destination) const
+{
+  const std::vector<Path> *paths = LookupPaths (destination);
+  return paths ? paths->size () : 0;
+}
+
+const std::vector<TunnelNetDevice::Path> *TunnelNetDevice::LookupPaths (Ipv6Address destination) const
+{
+  for (PathTable::const_iterator it = m_paths.begin (); it != m_paths.end (); it++)
+    {
+      PathMap::const_iterator pit = it->second.find (destination.CombinePrefix (Ipv6Prefix (it->first)));
+      if (pit != it->second.end ())
+        {
+          return &pit->second;
+        }
+    }
+  return 0;
+}
+
+Ipv6Address TunnelNetDevice::LookupPath (Ipv6Address destination, uint32_t flowHash) const
+{
+  const std::vector<Path> *paths = LookupPaths (destination);
+  if (!paths)
+    {
+      return Ipv6Address::GetAny ();
+    }
+
+  uint32_t total = 0;
+  for (std::vector<Path>::const_iterator it = paths->begin (); it != paths->end (); it++)
+    {
+      total += it->weight;
+    }
+  uint32_t share = flowHash % total;
+  std::vector<Path>::const_iterator it = paths->begin ();
+  while (share >= it->weight)
+    {
+      share -= it->weight;
+      it++;
+    }
+  return it->remote;
+}
+
+uint32_t TunnelNetDevice::HashFlow (const Ipv6Header &header, const uint8_t ports[4])
+{
+  uint8_t key[37];
+  header.GetSource ().Serialize (key);
+  header.GetDestination ().Serialize (key + 16);
+  key[32] = header.GetNextHeader ();
+  std::memcpy (key + 33, ports, 4);
+  return Hash32 (reinterpret_cast<const char *> (key), sizeof (key));
+}
+
+uint32_t TunnelNetDevice::GetFlowHash (const Ipv6Header &header, Ptr<const Packet> payload)
+{
+  uint8_t ports[4] = { 0, 0, 0, 0 };
+  uint8_t protocol = header.GetNextHeader ();
+  if ((protocol == 6 /* TCP */ || protocol == 17 /* UDP */) && payload->GetSize () >= 4)
+    {
+      payload->CopyData (ports, 4);
+    }
+  return HashFlow (header, ports);
+}
+
+TunnelNetDevice::Encap *TunnelNetDevice::LookupFlowEncap (Ptr<const Packet> packet, const Ipv6Header &inner)
+{
+  if (!m_paths.empty () && LookupPaths (inner.GetDestination ()))
+    {
+      //the ports follow the inner header, which is not removed to read them
+      uint8_t buf[44];
+      uint8_t ports[4] = { 0, 0, 0, 0 };
+      uint8_t protocol = inner.GetNextHeader ();
+      if ((protocol == 6 /* TCP */ || protocol == 17 /* UDP */) && packet->GetSize () >= sizeof (buf))
+        {
+          packet->CopyData (buf, sizeof (buf));
+          std::memcpy (ports, buf + 40, 4);
+        }
+      EncapTable::iterator it = m_encaps.find (LookupPath (inner.GetDestination (), HashFlow (inner, ports)));
+      if (it != m_encaps.end ())
+        {
+          return &it->second;
+        }
+    }
+  return LookupEncap (inner.GetDestination ());
+}
+
+Ipv6Address TunnelNetDevice::Lookup (const DestinationTable &table, Ipv6Address destination)
+{
+  for (DestinationTable::const_iterator it = table.begin (); it != table.end (); it++)
+    {
+      RemoteMap::const_iterator rit = it->second.find (destination.CombinePrefix (Ipv6Prefix (it->first)));
+      if (rit != it->second.end ())
+        {
+          return rit->second;
+        }
+    }
+  return Ipv6Address::GetAny ();
+}
+
+Ipv6Address TunnelNetDevice::LookupRemote (Ipv6Address destination) const
+{
+  Ipv6Address remote = Lookup (m_destinations, destination);
+  if (!remote.IsAny ())
+    {
+      return remote;
+    }
+  if (!m_remoteAddress.IsAny ())
+    {
+      return m_remoteAddress;
+    }
+  if (m_encaps.size () == 1)
+    {
+      return m_encaps.begin ()->first;
+    }
+  return Ipv6Address::GetAny ();
+}
+
+void TunnelNetDevice::InvalidateRoutes ()
 {
   NS_LOG_FUNCTION (this);
-  return m_refCount;
+
+  for (EncapTable::iterator it = m_encaps.begin (); it != m_encaps.end (); it++)
+    {
+      it->second.route = 0;
+    }
+  m_default.route = 0;
+}
+
+void TunnelNetDevice::InitEncap (Encap &encap, Ipv6Address remote, Ipv6Address local)
+{
+  encap.local = local;
+  encap.route = 0;
+  encap.interface = 0;
+  encap.outer = Ipv6Header ();
+  encap.outer.SetDestination (remote);
+  encap.outer.SetNextHeader (41 /* IPv6-in-IPv6 */);
+  encap.outer.SetHopLimit (64);
+}
+
+TunnelNetDevice::Encap *TunnelNetDevice::LookupEncap (Ipv6Address destination)
+{
+  if (m_destinations.empty () && m_remoteAddress.IsAny () && m_encaps.size () == 1)
+    {
+      return &m_encaps.begin ()->second;
+    }
+
+  Ipv6Address remote = LookupRemote (destination);
+  if (remote.IsAny ())
+    {
+      return 0;
+    }
+
+  EncapTable::iterator it = m_encaps.find (remote);
+  return it != m_encaps.end () ? &it->second : &m_default;
+}
+
+bool TunnelNetDevice::ResolveRoute (Encap &encap, Ptr<Packet> packet)
+{
+  if (!m_ipv6)
+    {
+      m_ipv6 = GetNode ()->GetObject<Ipv6L3Protocol> ();
+      NS_ASSERT (m_ipv6 && m_ipv6->GetRoutingProtocol ());
+
+      Ptr<TunnelRouteWatcher> watcher = TunnelRouteWatcher::GetRouteWatcher (GetNode ());
+      if (watcher)
+        {
+          watcher->Watch (this);
+        }
+    }
+
+  if (encap.route && m_ipv6->IsUp (encap.interface))
+    {
+      return true;
+    }
+
+  Ipv6Header header;
+  Socket::SocketErrno err;
+  Ptr<NetDevice> oif (0);     //specify non-zero if bound to a source address
+
+  header.SetDestination (encap.outer.GetDestination ());
+  encap.route = m_ipv6->GetRoutingProtocol ()->RouteOutput (packet, header, oif, err);
+
+  if (!encap.route)
+    {
+      NS_LOG_LOGIC ("No route for tunnel remote address " << encap.outer.GetDestination ());
+
+      return false;
+    }
+
+  Ptr<NetDevice> device = encap.route->GetOutputDevice ();
+  encap.interface = m_ipv6->GetInterfaceForDevice (device);
+  encap.outer.SetSource (encap.local.IsAny () ? encap.route->GetSource () : encap.local);
+
+  if (m_watchedDevices.insert (device->GetIfIndex ()).second)
+    {
+      device->AddLinkChangeCallback (MakeCallback (&TunnelNetDevice::InvalidateRoutes, this));
+    }
+  return true;
+}
+
+bool TunnelNetDevice::Encapsulate (Ptr<Packet> packet, Encap &encap)
+{
+  if (!ResolveRoute (encap, packet))
+    {
+      return false;
+    }
+
+  m_ipv6->Send (packet, encap.outer.GetSource (), encap.outer.GetDestination (), 41 /* IPv6-in-IPv6 */, encap.route);
+  return true;
 }
 
 bool
@@ -311,48 +745,39 @@ TunnelNetDevice::Send (Ptr<Packet> packet, const Address& dest, uint16_t protoco
       return true;
 
     }
-  Ptr<Ipv6L3Protocol> ipv6 = GetNode ()->GetObject<Ipv6L3Protocol>();
-  NS_ASSERT (!ipv6 && !ipv6->GetRoutingProtocol ());
-  NS_ASSERT ( !m_remoteAddress.IsAny () );
-
-  Ipv6Address src = m_localAddress;
-  Ipv6Address dst = m_remoteAddress;
-  SocketIpTtlTag tag;
-  uint8_t ttl = 64;
-  m_macTxTrace (packet);
-  if ( m_localAddress.IsAny () )
+  Encap *encap = LookupFlowEncap (packet, iph);
+  if (!encap)
     {
-      Ipv6Header header;
+      NS_LOG_LOGIC ("No tunnel remote address for " << b);
 
-      Socket::SocketErrno err;
-      Ptr<Ipv6Route> route;
-      Ptr<NetDevice> oif (0);     //specify non-zero if bound to a source address
-      header.SetDestination (dst);
-      route = ipv6->GetRoutingProtocol ()->RouteOutput (packet, header, oif, err);
+      return false;
+    }
 
-      if (route)
+  //a copy to the pre-registered CoA, if any, before the packet gets its outer header
+  Encap *bicast = 0;
+  Ptr<Packet> copy;
+  if (!m_bicasts.empty ())
+    {
+      EncapTable::iterator it = m_encaps.find (LookupBicast (b));
+      if (it != m_encaps.end () && &it->second != encap)
         {
-          NS_LOG_LOGIC ("No route for tunnel remote address");
-
-          return false;
+          bicast = &it->second;
+          copy = packet->Copy ();
         }
+    }
 
-      src = route->GetSource ();
-      tag.SetTtl (ttl);
-      ipv6->Send (packet, src, dst, 41 /* IPv6-in-IPv6 */, route);
+  m_macTxTrace (packet);
+  bool sent = Encapsulate (packet, *encap);
+  if (sent)
+    {
+      m_macTxTrace2 (packet, iph, encap->outer);
     }
-  else
+  if (bicast && Encapsulate (copy, *bicast))
     {
-      tag.SetTtl (ttl);
-      packet->AddPacketTag (tag);
-
-      ipv6->Send (packet, src, dst, 41 /* IPv6-in-IPv6 */, 0);
+      m_macTxTrace2 (copy, iph, bicast->outer);
+      sent = true;
     }
-  Ipv6Header oph;
-  oph.SetSource (src);
-  oph.SetDestination (dst);
-  m_macTxTrace2 (packet, iph, oph);
-  return true;
+  return sent;
 }
 
 bool
@@ -363,15 +788,6 @@ TunnelNetDevice::SendFrom (Ptr<Packet> packet, const Address& source, const Addr
 
   NS_ASSERT (m_supportsSendFrom);
 
-  Ptr<Ipv6L3Protocol> ipv6 = GetNode ()->GetObject<Ipv6L3Protocol>();
-  NS_ASSERT (!ipv6 && !ipv6->GetRoutingProtocol ());
-  NS_ASSERT ( !m_remoteAddress.IsAny () );
-
-  Ipv6Address src = m_localAddress;
-  Ipv6Address dst = m_remoteAddress;
-  SocketIpTtlTag tag;
-  uint8_t ttl = 64;
-
   m_macTxTrace (packet);
 
   Mac48Address dest2 = Mac48Address::ConvertFrom (dest);
@@ -381,40 +797,18 @@ TunnelNetDevice::SendFrom (Ptr<Packet> packet, const Address& source, const Addr
       return true;
     }
 
-  if ( m_localAddress.IsAny () )
-    {
-
-      Ipv6Header header;
-      Socket::SocketErrno err;
-      Ptr<Ipv6Route> route;
-      Ptr<NetDevice> oif (0);     //specify non-zero if bound to a source address
-
-      header.SetDestination (dst);
-      route = ipv6->GetRoutingProtocol ()->RouteOutput (packet, header, oif, err);
-
-      if (route)
-        {
-          NS_LOG_LOGIC ("No route for tunnel remote address");
-
-          return false;
-        }
-
-      src = route->GetSource ();
-
-      tag.SetTtl (ttl);
-      packet->AddPacketTag (tag);
+  Ipv6Header iph;
+  packet->PeekHeader (iph);
 
-      ipv6->Send (packet, src, dst, 41 /* IPv6-in-IPv6 */, route);
-    }
-  else
+  Encap *encap = LookupFlowEncap (packet, iph);
+  if (!encap)
     {
-      tag.SetTtl (ttl);
-      packet->AddPacketTag (tag);
+      NS_LOG_LOGIC ("No tunnel remote address for " << iph.GetDestination ());
 
-      ipv6->Send (packet, src, dst, 41 /* IPv6-in-IPv6 */, 0);
+      return false;
     }
 
-  return true;
+  return Encapsulate (packet, *encap);
 }
 
 Ptr<Node>
@@ -463,4 +857,120 @@ bool TunnelNetDevice::IsBridge (void) const
 }
 
 
-} // namespace ns3
\ No newline at end of file
+TypeId
+TunnelRouteWatcher::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TunnelRouteWatcher")
+    .SetParent<Ipv6RoutingProtocol> ()
+    .AddConstructor<TunnelRouteWatcher> ()
+  ;
+  return tid;
+}
+
+Ptr<TunnelRouteWatcher> TunnelRouteWatcher::GetRouteWatcher (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (node);
+
+  Ptr<Ipv6> ipv6 = node->GetObject<Ipv6> ();
+  NS_ASSERT (ipv6);
+
+  Ptr<Ipv6ListRouting> list = DynamicCast<Ipv6ListRouting> (ipv6->GetRoutingProtocol ());
+  if (!list)
+    {
+      NS_LOG_WARN ("Node " << node->GetId () << " does not use Ipv6ListRouting");
+      return 0;
+    }
+
+  int16_t priority;
+  for (uint32_t i = 0; i < list->GetNRoutingProtocols (); i++)
+    {
+      Ptr<TunnelRouteWatcher> watcher = DynamicCast<TunnelRouteWatcher> (list->GetRoutingProtocol (i, priority));
+      if (watcher)
+        {
+          return watcher;
+        }
+    }
+
+  Ptr<TunnelRouteWatcher> watcher = CreateObject<TunnelRouteWatcher> ();
+  list->AddRoutingProtocol (watcher, -32768);
+  return watcher;
+}
+
+void TunnelRouteWatcher::Watch (Ptr<TunnelNetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+
+  if (std::find (m_devices.begin (), m_devices.end (), device) == m_devices.end ())
+    {
+      m_devices.push_back (device);
+    }
+}
+
+void TunnelRouteWatcher::InvalidateRoutes ()
+{
+  for (std::vector<Ptr<TunnelNetDevice> >::iterator it = m_devices.begin (); it != m_devices.end (); it++)
+    {
+      (*it)->InvalidateRoutes ();
+    }
+}
+
+Ptr<Ipv6Route> TunnelRouteWatcher::RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
+{
+  sockerr = Socket::ERROR_NOROUTETOHOST;
+  return 0;
+}
+
+bool TunnelRouteWatcher::RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev,
+                                     const UnicastForwardCallback &ucb, const MulticastForwardCallback &mcb,
+                                     const LocalDeliverCallback &lcb, const ErrorCallback &ecb)
+{
+  return false;
+}
+
+void TunnelRouteWatcher::NotifyInterfaceUp (uint32_t interface)
+{
+  InvalidateRoutes ();
+}
+
+void TunnelRouteWatcher::NotifyInterfaceDown (uint32_t interface)
+{
+  InvalidateRoutes ();
+}
+
+void TunnelRouteWatcher::NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address)
+{
+  InvalidateRoutes ();
+}
+
+void TunnelRouteWatcher::NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address)
+{
+  InvalidateRoutes ();
+}
+
+void TunnelRouteWatcher::NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                                         Ipv6Address prefixToUse)
+{
+  InvalidateRoutes ();
+}
+
+void TunnelRouteWatcher::NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                                            Ipv6Address prefixToUse)
+{
+  InvalidateRoutes ();
+}
+
+void TunnelRouteWatcher::SetIpv6 (Ptr<Ipv6> ipv6)
+{
+}
+
+void TunnelRouteWatcher::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+}
+
+void TunnelRouteWatcher::DoDispose ()
+{
+  m_devices.clear ();
+  Ipv6RoutingProtocol::DoDispose ();
+}
+
+} // namespace ns3
@@ -8,14 +8,36 @@
 #include "ns3/packet.h"
 #include "ns3/ptr.h"
 #include "ns3/traced-callback.h"
+#include "ns3/ipv6-address.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/ipv6-routing-protocol.h"
+#include "ns3/sgi-hashmap.h"
 
-namespace ns3 {
+#include <functional>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
 
+namespace ns3 {
 
 /**
  * \class TunnelNetDevice
  * \brief A tunnel device, similar to Linux TUN/TAP interfaces.
  *
+ * The device is multipoint: it keeps a table of remote end points (e.g. the
+ * CoAs of the bindings of an HA), each with its local address and a reference
+ * count, and the inner destinations (HoA, MNP) reached through each of them.
+ * A packet is encapsulated towards the remote of its inner destination, the
+ * remote address set by SetRemoteAddress, or the only remote of the table.
+ *
+ * Each remote caches its route and outer header. The cache is dropped when
+ * the output interface goes down, the link of its device changes, the
+ * routing protocol of the node is notified of a route or address change
+ * (see TunnelRouteWatcher), or InvalidateRoutes is called after a change
+ * made directly in a routing table.
  */
 class TunnelNetDevice : public NetDevice
 {
@@ -84,19 +106,146 @@ public:
   void SetRemoteAddress (Ipv6Address raddr);
 
   /**
-   * \brief increase ref count.
-  */
-  void IncreaseRefCount ();
+   * \brief add a remote end point, or a reference to an existing one.
+   * \param remote remote address
+   * \param local local address, any to use the source of the route
+   */
+  void AddRemote (Ipv6Address remote, Ipv6Address local);
 
   /**
-   * \brief decrease ref count.
-  */
-  void DecreaseRefCount ();
+   * \brief remove a reference to a remote end point.
+   *
+   * The last reference removes the remote and its destinations.
+   * \param remote remote address
+   * \returns true if the remote was removed from the table
+   */
+  bool RemoveRemote (Ipv6Address remote);
 
   /**
-   * \brief get the ref count.
-  */
-  uint32_t GetRefCount () const;
+   * \brief whether a remote end point is in the table.
+   * \param remote remote address
+   * \returns true if the remote has references
+   */
+  bool HasRemote (Ipv6Address remote) const;
+
+  /**
+   * \brief get the ref count of a remote end point.
+   * \param remote remote address
+   * \returns the ref count, 0 if not in the table
+   */
+  uint32_t GetRemoteRefCount (Ipv6Address remote) const;
+
+  /**
+   * \brief get the number of remote end points.
+   * \returns the number of remotes
+   */
+  uint32_t GetNRemotes () const;
+
+  /**
+   * \brief reach inner destinations through a remote end point.
+   * \param destination destination address or prefix
+   * \param prefix destination prefix
+   * \param remote remote address, which must be in the table
+   */
+  void AddDestination (Ipv6Address destination, Ipv6Prefix prefix, Ipv6Address remote);
+
+  /**
+   * \brief remove inner destinations.
+   * \param destination destination address or prefix
+   * \param prefix destination prefix
+   */
+  void RemoveDestination (Ipv6Address destination, Ipv6Prefix prefix);
+
+  /**
+   * \brief get the remote end point of an inner destination.
+   *
+   * The longest destination prefix wins, then the remote address set by
+   * SetRemoteAddress, then the only remote of the table.
+   * \param destination inner destination address
+   * \returns the remote address, any if none
+   */
+  Ipv6Address LookupRemote (Ipv6Address destination) const;
+
+  /**
+   * \brief also send the packets of inner destinations to a second remote end point.
+   *
+   * Used by an HA to reach a pre-registered CoA of the MN while its current
+   * CoA is still bound.
+   * \param destination destination address or prefix
+   * \param prefix destination prefix
+   * \param remote remote address, which must be in the table
+   */
+  void AddBicast (Ipv6Address destination, Ipv6Prefix prefix, Ipv6Address remote);
+
+  /**
+   * \brief stop sending inner destinations to a second remote end point.
+   * \param destination destination address or prefix
+   * \param prefix destination prefix
+   */
+  void RemoveBicast (Ipv6Address destination, Ipv6Prefix prefix);
+
+  /**
+   * \brief get the second remote end point of an inner destination.
+   * \param destination inner destination address
+   * \returns the remote address, any if none
+   */
+  Ipv6Address LookupBicast (Ipv6Address destination) const;
+
+  /**
+   * \brief spread the flows of inner destinations over a remote end point.
+   *
+   * Used by an HA to reach a multihomed MN through several CoAs at once.
+   * The flows are hashed on their 5-tuple and shared among the remotes of
+   * the destination in proportion to their weights, so that the packets of
+   * a flow keep the same path. The paths take precedence over the remote of
+   * AddDestination. Adding a remote again updates its weight, a weight of 0
+   * removes it.
+   * \param destination destination address or prefix
+   * \param prefix destination prefix
+   * \param remote remote address, which must be in the table
+   * \param weight share of the flows
+   */
+  void AddPath (Ipv6Address destination, Ipv6Prefix prefix, Ipv6Address remote, uint16_t weight);
+
+  /**
+   * \brief remove all the paths of inner destinations.
+   * \param destination destination address or prefix
+   * \param prefix destination prefix
+   */
+  void RemovePaths (Ipv6Address destination, Ipv6Prefix prefix);
+
+  /**
+   * \brief get the number of paths of an inner destination.
+   * \param destination inner destination address
+   * \returns the number of remotes the flows are spread over
+   */
+  uint32_t GetNPaths (Ipv6Address destination) const;
+
+  /**
+   * \brief get the remote end point of a flow.
+   * \param destination inner destination address
+   * \param flowHash hash of the flow, see GetFlowHash
+   * \returns the remote address of the path of the flow, any if the destination has no path
+   */
+  Ipv6Address LookupPath (Ipv6Address destination, uint32_t flowHash) const;
+
+  /**
+   * \brief hash the 5-tuple of a flow.
+   *
+   * The ports are only read for TCP and UDP, other protocols are hashed on
+   * their addresses and protocol number.
+   * \param header the IPv6 header of the packet
+   * \param payload the payload following the header
+   * \returns the hash of the flow
+   */
+  static uint32_t GetFlowHash (const Ipv6Header &header, Ptr<const Packet> payload);
+
+  /**
+   * \brief drop the cached routes to the remote end points.
+   *
+   * To be called when the routes towards the remotes change.
+   */
+  void InvalidateRoutes ();
 
   /**
    * \param packet packet sent from below up to Network Device
@@ -154,6 +303,115 @@ protected:
 
 private:
 
+  /**
+   * \brief encapsulation state of a remote end point.
+   */
+  struct Encap
+  {
+    Ipv6Address local;  //!< local address, any to use the source of the route
+    uint32_t refCount;  //!< references to the remote
+    std::vector<std::pair<Ipv6Address, uint8_t> > destinations; //!< destinations reached through the remote
+    Ptr<Ipv6Route> route; //!< cached route to the remote, 0 if not resolved
+    uint32_t interface; //!< IPv6 interface of the cached route
+    Ipv6Header outer;   //!< outer header, the source is set with the route
+  };
+
+  /**
+   * \brief encapsulation state keyed by remote address
+   */
+  typedef sgi::hash_map<Ipv6Address, Encap, Ipv6AddressHash> EncapTable;
+
+  /**
+   * \brief remote addresses keyed by masked destination
+   */
+  typedef sgi::hash_map<Ipv6Address, Ipv6Address, Ipv6AddressHash> RemoteMap;
+
+  /**
+   * \brief remote addresses keyed by masked destination, one hashmap per prefix length, longest first
+   */
+  typedef std::map<uint8_t, RemoteMap, std::greater<uint8_t> > DestinationTable;
+
+  /**
+   * \brief a remote end point sharing the flows of a destination.
+   */
+  struct Path
+  {
+    Ipv6Address remote; //!< remote address
+    uint16_t weight;    //!< share of the flows
+  };
+
+  /**
+   * \brief paths keyed by masked destination
+   */
+  typedef sgi::hash_map<Ipv6Address, std::vector<Path>, Ipv6AddressHash> PathMap;
+
+  /**
+   * \brief paths keyed by masked destination, one hashmap per prefix length, longest first
+   */
+  typedef std::map<uint8_t, PathMap, std::greater<uint8_t> > PathTable;
+
+  /**
+   * \brief initialize the encapsulation state of a remote end point.
+   * \param encap the encapsulation state
+   * \param remote the remote address
+   * \param local the local address
+   */
+  static void InitEncap (Encap &encap, Ipv6Address remote, Ipv6Address local);
+
+  /**
+   * \brief longest prefix match of an inner destination.
+   * \param table the destination table
+   * \param destination the inner destination address
+   * \returns the remote address, any if none
+   */
+  static Ipv6Address Lookup (const DestinationTable &table, Ipv6Address destination);
+
+  /**
+   * \brief get the encapsulation state of an inner destination.
+   * \param destination the inner destination address
+   * \returns the encapsulation state, 0 if no remote is found
+   */
+  Encap *LookupEncap (Ipv6Address destination);
+
+  /**
+   * \brief longest prefix match of the paths of an inner destination.
+   * \param destination the inner destination address
+   * \returns the paths, 0 if none
+   */
+  const std::vector<Path> *LookupPaths (Ipv6Address destination) const;
+
+  /**
+   * \brief hash a flow on its addresses, protocol and ports.
+   * \param header the IPv6 header of the packet
+   * \param ports the source and destination ports, in network order
+   * \returns the hash of the flow
+   */
+  static uint32_t HashFlow (const Ipv6Header &header, const uint8_t ports[4]);
+
+  /**
+   * \brief get the encapsulation state of a packet, following the paths of its flow if any.
+   * \param packet the packet, starting with the inner IPv6 header
+   * \param inner the inner IPv6 header
+   * \returns the encapsulation state, 0 if no remote is found
+   */
+  Encap *LookupFlowEncap (Ptr<const Packet> packet, const Ipv6Header &inner);
+
+  /**
+   * \brief resolve and cache the route and outer source towards a remote end point.
+   * \param encap the encapsulation state
+   * \param packet the packet to route
+   * \returns false if there is no route to the remote
+   */
+  bool ResolveRoute (Encap &encap, Ptr<Packet> packet);
+
+  /**
+   * \brief encapsulate a packet and send it to a remote end point.
+   * \param packet the packet, starting with the inner IPv6 header
+   * \param encap the encapsulation state of the remote
+   * \returns false if there is no route to the remote
+   */
+  bool Encapsulate (Ptr<Packet> packet, Encap &encap);
+
   /**
    * \brief mac address.
    */
@@ -229,9 +487,100 @@ private:
   */
   Ipv6Address m_remoteAddress;
   /**
-   * \brief ref count.
+   * \brief remote end points.
   */
-  uint32_t m_refCount;
+  EncapTable m_encaps;
+  /**
+   * \brief inner destinations.
+  */
+  DestinationTable m_destinations;
+  /**
+   * \brief inner destinations duplicated to a second remote.
+  */
+  DestinationTable m_bicasts;
+  /**
+   * \brief inner destinations whose flows are spread over several remotes.
+  */
+  PathTable m_paths;
+  /**
+   * \brief encapsulation state of the remote address set by SetRemoteAddress.
+  */
+  Encap m_default;
+  /**
+   * \brief IPv6 stack of the node.
+  */
+  Ptr<Ipv6L3Protocol> m_ipv6;
+  /**
+   * \brief devices whose link changes invalidate the routes.
+  */
+  std::set<uint32_t> m_watchedDevices;
+};
+
+/**
+ * \class TunnelRouteWatcher
+ * \brief Drops the cached routes of the tunnel devices of a node when its
+ * routes or addresses change.
+ *
+ * It is installed in the Ipv6ListRouting of the node with the lowest
+ * priority and does not route anything: it only receives the interface,
+ * address and route notifications forwarded by the list to each protocol.
+ * A node routed by a single protocol (the InternetStackHelper default) has
+ * no list to sit in; its tunnel devices only drop their routes on interface
+ * and link changes. Routes added directly in a routing table (e.g. with
+ * Ipv6StaticRouting::AddHostRouteTo) are not notified either, their owner
+ * calls TunnelNetDevice::InvalidateRoutes.
+ */
+class TunnelRouteWatcher : public Ipv6RoutingProtocol
+{
+public:
+  /**
+   * \brief get typeid
+   * \return typeid
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief get the watcher of a node, installing it if needed.
+   * \param node the node
+   * \return the watcher, 0 if the node does not use Ipv6ListRouting
+   */
+  static Ptr<TunnelRouteWatcher> GetRouteWatcher (Ptr<Node> node);
+
+  /**
+   * \brief drop the cached routes of a tunnel device on each change.
+   * \param device the tunnel device
+   */
+  void Watch (Ptr<TunnelNetDevice> device);
+
+  // Inherited from Ipv6RoutingProtocol
+  virtual Ptr<Ipv6Route> RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
+  virtual bool RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev,
+                           const UnicastForwardCallback &ucb, const MulticastForwardCallback &mcb,
+                           const LocalDeliverCallback &lcb, const ErrorCallback &ecb);
+  virtual void NotifyInterfaceUp (uint32_t interface);
+  virtual void NotifyInterfaceDown (uint32_t interface);
+  virtual void NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address);
+  virtual void NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address);
+  virtual void NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                               Ipv6Address prefixToUse = Ipv6Address::GetZero ());
+  virtual void NotifyRemoveRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface,
+                                  Ipv6Address prefixToUse = Ipv6Address::GetZero ());
+  virtual void SetIpv6 (Ptr<Ipv6> ipv6);
+  virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+
+protected:
+  virtual void DoDispose ();
+
+private:
+  /**
+   * \brief drop the cached routes of the watched devices.
+   */
+  void InvalidateRoutes ();
+
+  /**
+   * \brief the watched tunnel devices.
+   */
+  std::vector<Ptr<TunnelNetDevice> > m_devices;
 };
 
 }  // namespace ns3
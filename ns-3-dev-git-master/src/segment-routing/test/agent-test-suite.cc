@@ -0,0 +1,608 @@
+#include "ns3/boolean.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-option-header.h"
+#include "ns3/ipv6-route.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/udp-header.h"
+#include "ns3/bcache.h"
+#include "ns3/ha.h"
+#include "ns3/sr-header.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-l4-protocol.h"
+#include "ns3/sr-mn.h"
+#include "ns3/sr-mn-config.h"
+#include "ns3/sr-option-header.h"
+#include "ns3/sr-tun-l4-protocol.h"
+
+#include <algorithm>
+#include <list>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The MIPv6 and tunnel protocols register with the IPv6 stack of their node.
+ */
+class AgentProtocolTestCase : public TestCase
+{
+public:
+  AgentProtocolTestCase ();
+  virtual void DoRun (void);
+};
+
+AgentProtocolTestCase::AgentProtocolTestCase ()
+  : TestCase ("Protocols aggregated to a node")
+{
+}
+
+void
+AgentProtocolTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (node);
+
+  Ptr<Mipv6L4Protocol> mipv6 = CreateObject<Mipv6L4Protocol> ();
+  node->AggregateObject (mipv6);
+  Ptr<Ipv6TunnelL4Protocol> tunnel = CreateObject<Ipv6TunnelL4Protocol> ();
+  node->AggregateObject (tunnel);
+
+  Ptr<Ipv6L3Protocol> ipv6 = node->GetObject<Ipv6L3Protocol> ();
+  Ptr<IpL4Protocol> expected = mipv6;
+  NS_TEST_EXPECT_MSG_EQ (ipv6->GetProtocol (Mipv6L4Protocol::PROT_NUMBER), expected, "MIPv6 protocol not registered");
+  expected = tunnel;
+  NS_TEST_EXPECT_MSG_EQ (ipv6->GetProtocol (Ipv6TunnelL4Protocol::PROT_NUMBER), expected, "tunnel protocol not registered");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNode (), node, "tunnel protocol without node");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief HA of hosts on its home link, with a default route.
+ */
+class AgentTestHa
+{
+public:
+  AgentTestHa ()
+  {
+    m_node = CreateObject<Node> ();
+    InternetStackHelper internetv6;
+    internetv6.SetIpv4StackInstall (false);
+    internetv6.Install (m_node);
+
+    SimpleNetDeviceHelper link;
+    Ipv6AddressHelper ipv6helper;
+    ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+    ipv6helper.Assign (link.Install (m_node));
+    Ipv6StaticRoutingHelper routingHelper;
+    routingHelper.GetStaticRouting (m_node->GetObject<Ipv6> ())->SetDefaultRoute (Ipv6Address ("fe80::2"), 1);
+
+    Mipv6HaHelper haHelper;
+    haHelper.Install (m_node);
+    m_ha = m_node->GetObject<Mipv6Ha> ();
+    m_address = m_node->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  }
+
+  /**
+   * \brief get the binding cache of the HA.
+   * \return the binding cache
+   */
+  Ptr<BCache> GetBCache (void) const
+  {
+    PointerValue bcache;
+    m_ha->GetAttribute ("BCache", bcache);
+    return bcache.Get<BCache> ();
+  }
+
+  /**
+   * \brief give the BU of a host to the HA.
+   * \param hoa home address of the host
+   * \param coa care-of address of the host
+   * \param mnp a prefix to carry in a Mobile Network Prefix option, any for a BU without option
+   */
+  void ReceiveBu (Ipv6Address hoa, Ipv6Address coa, Ipv6Address mnp)
+  {
+    Ptr<Packet> p = Create<Packet> ();
+    Ipv6ExtensionDestinationHeader dest;
+    Ipv6HomeAddressOptionHeader homeopt;
+    homeopt.SetHomeAddress (hoa);
+    dest.AddOption (homeopt);
+    dest.SetNextHeader (59);
+    p->AddHeader (dest);
+
+    Ipv6MobilityBindingUpdateHeader bu;
+    bu.SetSequence (1);
+    bu.SetFlagA (true);
+    bu.SetFlagH (true);
+    bu.SetLifetime (10);
+    if (!mnp.IsAny ())
+      {
+        Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
+        mnph.SetMobileNetworkPrefix (mnp);
+        mnph.SetPrefixLength (64);
+        bu.AddOption (mnph);
+      }
+    p->AddHeader (bu);
+
+    Ptr<Ipv6Interface> interface = m_node->GetObject<Ipv6L3Protocol> ()->GetInterface (1);
+    m_node->GetObject<Mipv6L4Protocol> ()->Receive (p, coa, m_address, interface);
+  }
+
+  Ptr<Node> m_node;       //!< the node
+  Ptr<Mipv6Ha> m_ha;      //!< the HA
+  Ipv6Address m_address;  //!< global address of the HA
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief An agent sends its messages on the route to their destination.
+ */
+class AgentSendTestCase : public TestCase
+{
+public:
+  AgentSendTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief count a message sent by the agent.
+   * \param packet the message
+   */
+  void Tx (Ptr<const Packet> packet);
+
+  uint32_t m_tx;  //!< messages sent
+};
+
+AgentSendTestCase::AgentSendTestCase ()
+  : TestCase ("Agent message sent"),
+    m_tx (0)
+{
+}
+
+void
+AgentSendTestCase::Tx (Ptr<const Packet> packet)
+{
+  m_tx++;
+}
+
+void
+AgentSendTestCase::DoRun (void)
+{
+  AgentTestHa node;
+  node.m_ha->TraceConnectWithoutContext ("AgentTx", MakeCallback (&AgentSendTestCase::Tx, this));
+
+  node.m_ha->SendMessage (Create<Packet> (8), Ipv6Address ("2001:1::10"), 64);
+  NS_TEST_EXPECT_MSG_EQ (m_tx, 1, "on-link message not sent");
+  node.m_ha->SendMessage (Create<Packet> (8), Ipv6Address ("2001:a::10"), 64);
+  NS_TEST_EXPECT_MSG_EQ (m_tx, 2, "message on the default route not sent");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The HA binds the CoA of a host BU.
+ */
+class HaBindingTestCase : public TestCase
+{
+public:
+  /**
+   * \brief constructor.
+   * \param options whether the BU carries an option
+   */
+  HaBindingTestCase (bool options);
+  virtual void DoRun (void);
+
+private:
+  bool m_options;  //!< whether the BU carries an option
+};
+
+HaBindingTestCase::HaBindingTestCase (bool options)
+  : TestCase (options ? "HA binding of a host" : "HA binding of a host BU without options"),
+    m_options (options)
+{
+}
+
+void
+HaBindingTestCase::DoRun (void)
+{
+  AgentTestHa node;
+  Ipv6Address hoa ("2001:1::10");
+  Ipv6Address coa ("2001:a::10");
+
+  /* a host ignores the MNP option, the HA does not read it without the R flag */
+  node.ReceiveBu (hoa, coa, m_options ? Ipv6Address ("2002:0:0:1::") : Ipv6Address::GetAny ());
+  BCache::Entry *bce = node.GetBCache ()->Lookup (hoa);
+  NS_TEST_ASSERT_MSG_EQ (bool (bce), true, "BU from a CoA not bound");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetCoa (), coa, "wrong CoA");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief HA and MN on a shared link, where the HA also stands for two ARs.
+ */
+class AgentTestLink
+{
+public:
+  AgentTestLink ()
+  {
+    m_haNode = CreateObject<Node> ();
+    m_mnNode = CreateObject<Node> ();
+    NodeContainer nodes (m_haNode, m_mnNode);
+
+    SimpleNetDeviceHelper helperChannel;
+    helperChannel.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (5)));
+    NetDeviceContainer net = helperChannel.Install (nodes);
+
+    InternetStackHelper internetv6;
+    internetv6.SetIpv4StackInstall (false);
+    internetv6.Install (nodes);
+    m_haNode->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+    m_mnNode->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+    Ipv6Address ar1 ("2001:1::1");
+    Ipv6Address ar2 ("2001:2::1");
+    Ipv6AddressHelper ipv6helper;
+    ipv6helper.SetBase (Ipv6Address ("2001:db8::"), Ipv6Prefix (64));
+    ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+    ipv6helper.SetBase (ar1.CombinePrefix (Ipv6Prefix (64)), Ipv6Prefix (64));
+    ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+    ipv6helper.SetBase (ar2.CombinePrefix (Ipv6Prefix (64)), Ipv6Prefix (64));
+    ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+    ipv6helper.AssignWithoutAddress (NetDeviceContainer (net.Get (1)));
+
+    Ptr<Ipv6> haIpv6 = m_haNode->GetObject<Ipv6> ();
+    m_haAddress = haIpv6->GetAddress (1, 1).GetAddress ();
+    m_linkLocalHa = haIpv6->GetAddress (1, 0).GetAddress ();
+
+    Mipv6HaHelper haHelper;
+    haHelper.Install (m_haNode);
+
+    std::list<Ipv6Address> haalist (1, m_haAddress);
+    std::list<Ipv6Address> aralist;
+    aralist.push_back (ar1);
+    aralist.push_back (ar2);
+
+    Ptr<Mipv6L4Protocol> mipv6 = CreateObject<Mipv6L4Protocol> ();
+    m_mnNode->AggregateObject (mipv6);
+    mipv6->RegisterMobility ();
+    mipv6->RegisterMobilityOptions ();
+    m_mnNode->AggregateObject (CreateObject<Ipv6TunnelL4Protocol> ());
+    m_mn = CreateObject<Mipv6Mn> (Create<Mipv6MnConfig> (haalist, aralist, false, Ipv6Address::GetAny ()));
+    m_mnNode->AggregateObject (m_mn);
+
+    m_hoa = m_mn->GetHomeAddress ();
+    m_coa1 = MakeCoa (ar1);
+    m_coa2 = MakeCoa (ar2);
+  }
+
+  ~AgentTestLink ()
+  {
+    m_mn = 0;
+    m_haNode = 0;
+    m_mnNode = 0;
+    Simulator::Destroy ();
+  }
+
+  /**
+   * \brief Configure a CoA on the MN, as a script would, and attach with it.
+   * \param oldCoa the CoA to remove, any if none
+   * \param coa the CoA
+   */
+  void Move (Ipv6Address oldCoa, Ipv6Address coa)
+  {
+    Ptr<Ipv6> ipv6 = m_mnNode->GetObject<Ipv6> ();
+    if (!oldCoa.IsAny ())
+      {
+        ipv6->RemoveAddress (1, oldCoa);
+      }
+    ipv6->AddAddress (1, Ipv6InterfaceAddress (coa, Ipv6Prefix (64)));
+
+    //default route learnt from the AR, the HA stands for it on the shared link
+    Ipv6StaticRoutingHelper routingHelper;
+    Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
+    routing->AddNetworkRouteTo (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), m_linkLocalHa, 1, coa.CombinePrefix (Ipv6Prefix (64)), 0);
+    m_mn->SetDefaultRouterAddress (m_linkLocalHa, 1);
+
+    m_mn->NotifyAttachment (coa);
+  }
+
+  /**
+   * \brief get the binding of the MN at the HA.
+   * \return the binding, 0 if none
+   */
+  BCache::Entry *GetBinding () const
+  {
+    PointerValue bcache;
+    m_haNode->GetObject<Mipv6Ha> ()->GetAttribute ("BCache", bcache);
+    return bcache.Get<BCache> ()->Lookup (m_hoa);
+  }
+
+  /**
+   * \brief send a UDP packet from the HA to the HoA of the MN.
+   *
+   * The packet is routed on the tunnel of the binding: the tunnel interface
+   * has no address for the static routing to select a source from.
+   */
+  void SendToHoa ()
+  {
+    Ptr<Packet> p = Create<Packet> (100);
+    UdpHeader udp;
+    udp.SetSourcePort (1000);
+    udp.SetDestinationPort (1000);
+    p->AddHeader (udp);
+
+    Ptr<Ipv6L3Protocol> ipv6 = m_haNode->GetObject<Ipv6L3Protocol> ();
+    Ptr<Ipv6Route> route = Create<Ipv6Route> ();
+    route->SetDestination (m_hoa);
+    route->SetSource (m_haAddress);
+    route->SetGateway (Ipv6Address::GetAny ());
+    route->SetOutputDevice (ipv6->GetNetDevice (GetBinding ()->GetTunnelIfIndex ()));
+    ipv6->Send (p, m_haAddress, m_hoa, 17, route);
+  }
+
+  Ptr<Node> m_haNode;         //!< the HA
+  Ptr<Node> m_mnNode;         //!< the MN node
+  Ptr<Mipv6Mn> m_mn;          //!< the MN
+  Ipv6Address m_haAddress;    //!< address of the HA
+  Ipv6Address m_linkLocalHa;  //!< link-local address of the HA
+  Ipv6Address m_hoa;          //!< home address of the MN
+  Ipv6Address m_coa1;         //!< CoA of the MN on the first AR
+  Ipv6Address m_coa2;         //!< CoA of the MN on the second AR
+
+private:
+  /**
+   * \brief build the CoA of the MN on the link of an AR.
+   * \param ar address of the AR
+   * \return the prefix of the AR with the interface identifier of the HoA
+   */
+  Ipv6Address MakeCoa (Ipv6Address ar) const
+  {
+    uint8_t iid[16], buf[16];
+    m_hoa.GetBytes (iid);
+    ar.GetBytes (buf);
+    std::copy (iid + 8, iid + 16, buf + 8);
+    return Ipv6Address (buf);
+  }
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief An MN registers a CoA configured outside of the ICMPv6 layer.
+ */
+class MnAttachmentTestCase : public TestCase
+{
+public:
+  MnAttachmentTestCase ();
+  virtual void DoRun (void);
+};
+
+MnAttachmentTestCase::MnAttachmentTestCase ()
+  : TestCase ("MN attachment notified by a script")
+{
+}
+
+void
+MnAttachmentTestCase::DoRun (void)
+{
+  AgentTestLink link;
+  Simulator::Schedule (Seconds (1), &AgentTestLink::Move, &link, Ipv6Address::GetAny (), link.m_coa1);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  BCache::Entry *bce = link.GetBinding ();
+  NS_TEST_ASSERT_MSG_EQ (bool (bce), true, "CoA not registered");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetCoa (), link.m_coa1, "wrong CoA");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief An MN moving again before the BA supersedes its pending BU.
+ */
+class MnReattachmentTestCase : public TestCase
+{
+public:
+  MnReattachmentTestCase ();
+  virtual void DoRun (void);
+};
+
+MnReattachmentTestCase::MnReattachmentTestCase ()
+  : TestCase ("MN attachment before the BA of the previous one")
+{
+}
+
+void
+MnReattachmentTestCase::DoRun (void)
+{
+  AgentTestLink link;
+  //the HA answers the first BU after the DAD of the HoA, one second later
+  Simulator::Schedule (Seconds (1), &AgentTestLink::Move, &link, Ipv6Address::GetAny (), link.m_coa1);
+  Simulator::Schedule (Seconds (1.2), &AgentTestLink::Move, &link, link.m_coa1, link.m_coa2);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  BCache::Entry *bce = link.GetBinding ();
+  NS_TEST_ASSERT_MSG_EQ (bool (bce), true, "CoA not registered");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetCoa (), link.m_coa2, "binding not moved");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The HA tunnels the traffic of the HoA from its own address.
+ *
+ * The HA also holds an address in the prefix of the CoA, the one the route
+ * to the CoA would select as source.
+ */
+class HaTunnelSourceTestCase : public TestCase
+{
+public:
+  HaTunnelSourceTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief record the source of the packets tunnelled by the HA.
+   * \param packet the packet, IPv6 header included
+   * \param ipv6 the IPv6 stack
+   * \param interface the outgoing interface
+   */
+  void Tx (Ptr<const Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface);
+
+  /**
+   * \brief record the interfaces of the HA before any binding.
+   * \param ipv6 the IPv6 stack of the HA
+   */
+  void CheckInterfaces (Ptr<Ipv6> ipv6);
+
+  uint32_t m_tunnelled;     //!< packets tunnelled by the HA
+  Ipv6Address m_source;     //!< outer source of the last tunnelled packet
+  uint32_t m_nInterfaces;   //!< interfaces of the HA before any binding
+};
+
+HaTunnelSourceTestCase::HaTunnelSourceTestCase ()
+  : TestCase ("HA tunnel source address"),
+    m_tunnelled (0),
+    m_nInterfaces (0)
+{
+}
+
+void
+HaTunnelSourceTestCase::Tx (Ptr<const Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface)
+{
+  Ipv6Header outer;
+  packet->PeekHeader (outer);
+  if (outer.GetNextHeader () == Ipv6TunnelL4Protocol::PROT_NUMBER)
+    {
+      m_tunnelled++;
+      m_source = outer.GetSource ();
+      //the packet is checked when it leaves the HA, not at the MN
+      Simulator::Stop ();
+    }
+}
+
+void
+HaTunnelSourceTestCase::CheckInterfaces (Ptr<Ipv6> ipv6)
+{
+  m_nInterfaces = ipv6->GetNInterfaces ();
+}
+
+void
+HaTunnelSourceTestCase::DoRun (void)
+{
+  AgentTestLink link;
+  Ptr<Ipv6> haIpv6 = link.m_haNode->GetObject<Ipv6> ();
+  haIpv6->TraceConnectWithoutContext ("Tx", MakeCallback (&HaTunnelSourceTestCase::Tx, this));
+
+  Simulator::Schedule (Seconds (0.5), &HaTunnelSourceTestCase::CheckInterfaces, this, haIpv6);
+  Simulator::Schedule (Seconds (1), &AgentTestLink::Move, &link, Ipv6Address::GetAny (), link.m_coa1);
+  Simulator::Schedule (Seconds (3), &AgentTestLink::SendToHoa, &link);
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  //loopback, link and tunnel
+  NS_TEST_EXPECT_MSG_EQ (m_nInterfaces, 3, "tunnel interface not created at initialization");
+  NS_TEST_ASSERT_MSG_EQ (m_tunnelled, 1, "packet to the HoA not tunnelled");
+  NS_TEST_EXPECT_MSG_EQ (m_source, link.m_haAddress, "wrong tunnel source");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The MN takes the packets tunnelled to its HoA.
+ */
+class MnTunnelReceiveTestCase : public TestCase
+{
+public:
+  MnTunnelReceiveTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief count a packet received through the tunnel of the MN.
+   * \param packet the inner packet
+   * \param inner the inner header
+   * \param outer the outer header
+   * \param interface the incoming interface
+   */
+  void Rx (Ptr<Packet> packet, Ipv6Header inner, Ipv6Header outer, Ptr<Ipv6Interface> interface);
+
+  uint32_t m_received;    //!< packets received through the tunnel
+  Ipv6Address m_inner;    //!< inner destination of the last packet
+};
+
+MnTunnelReceiveTestCase::MnTunnelReceiveTestCase ()
+  : TestCase ("MN tunnel reception"),
+    m_received (0)
+{
+}
+
+void
+MnTunnelReceiveTestCase::Rx (Ptr<Packet> packet, Ipv6Header inner, Ipv6Header outer, Ptr<Ipv6Interface> interface)
+{
+  m_received++;
+  m_inner = inner.GetDestination ();
+}
+
+void
+MnTunnelReceiveTestCase::DoRun (void)
+{
+  AgentTestLink link;
+  link.m_mnNode->GetObject<Ipv6TunnelL4Protocol> ()->TraceConnectWithoutContext ("RxMn", MakeCallback (&MnTunnelReceiveTestCase::Rx, this));
+
+  Simulator::Schedule (Seconds (1), &AgentTestLink::Move, &link, Ipv6Address::GetAny (), link.m_coa1);
+  Simulator::Schedule (Seconds (3), &AgentTestLink::SendToHoa, &link);
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 1, "tunnelled packet not delivered");
+  NS_TEST_EXPECT_MSG_EQ (m_inner, link.m_hoa, "wrong inner destination");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Agent TestSuite
+ */
+class AgentTestSuite : public TestSuite
+{
+public:
+  AgentTestSuite ()
+    : TestSuite ("segment-routing-agent", UNIT)
+  {
+    AddTestCase (new AgentProtocolTestCase, TestCase::QUICK);
+    AddTestCase (new AgentSendTestCase, TestCase::QUICK);
+    AddTestCase (new HaBindingTestCase (true), TestCase::QUICK);
+    AddTestCase (new HaBindingTestCase (false), TestCase::QUICK);
+    AddTestCase (new MnAttachmentTestCase, TestCase::QUICK);
+    AddTestCase (new MnReattachmentTestCase, TestCase::QUICK);
+    AddTestCase (new HaTunnelSourceTestCase, TestCase::QUICK);
+    AddTestCase (new MnTunnelReceiveTestCase, TestCase::QUICK);
+  }
+};
+
+static AgentTestSuite g_agentTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,226 @@
+#include "ns3/test.h"
+#include "ns3/bcache.h"
+
+#include <chrono>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Helper building the addresses of the i-th MN.
+ */
+class BCacheTestAddresses
+{
+public:
+  /**
+   * \brief Home address of a MN.
+   * \param index MN index
+   * \return 2001:db8::<index>
+   */
+  static Ipv6Address GetHoa (uint32_t index)
+  {
+    uint8_t buf[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+    buf[12] = index >> 24;
+    buf[13] = index >> 16;
+    buf[14] = index >> 8;
+    buf[15] = index;
+    return Ipv6Address (buf);
+  }
+
+  /**
+   * \brief Mobile network prefix of a MR.
+   * \param index MN index
+   * \return 2001:<index>::/64 written in the third and fourth bytes pairs
+   */
+  static Ipv6Address GetMnp (uint32_t index)
+  {
+    uint8_t buf[16] = { 0x20, 0x02 };
+    buf[4] = index >> 24;
+    buf[5] = index >> 16;
+    buf[6] = index >> 8;
+    buf[7] = index;
+    return Ipv6Address (buf);
+  }
+
+  /**
+   * \brief Add a MR to a binding cache.
+   * \param bcache the binding cache
+   * \param index MN index
+   * \return the new entry
+   */
+  static BCache::Entry * AddMn (Ptr<BCache> bcache, uint32_t index)
+  {
+    BCache::Entry *bce = new BCache::Entry (bcache);
+    Ipv6Address hoa = GetHoa (index);
+    bce->SetHoa (hoa);
+    bce->SetSolicitedHoA (Ipv6Address::MakeSolicitedAddress (hoa));
+    bce->SetMobileNetworkPrefix (GetMnp (index));
+    bcache->Add (bce);
+    return bce;
+  }
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief BCache secondary indexes.
+ */
+class BCacheIndexTestCase : public TestCase
+{
+public:
+  BCacheIndexTestCase ();
+  virtual void DoRun (void);
+};
+
+BCacheIndexTestCase::BCacheIndexTestCase ()
+  : TestCase ("BCache solicited HoA, MNP and home prefix indexes")
+{
+}
+
+void
+BCacheIndexTestCase::DoRun (void)
+{
+  Ptr<BCache> bcache = CreateObject<BCache> ();
+
+  std::list<Ipv6Address> haList;
+  haList.push_back (Ipv6Address ("2001:db8::1"));
+  bcache->SetHomePrefixes (haList);
+  NS_TEST_EXPECT_MSG_EQ (bcache->IsHomePrefix (Ipv6Address ("2001:db8::")), true, "home prefix not found");
+  NS_TEST_EXPECT_MSG_EQ (bcache->IsHomePrefix (Ipv6Address ("2001:db9::")), false, "unexpected home prefix");
+
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupSHoa (Ipv6Address::MakeSolicitedAddress (BCacheTestAddresses::GetHoa (1))),
+                         false, "solicited HoA found in an empty cache");
+
+  BCache::Entry *first = BCacheTestAddresses::AddMn (bcache, 1);
+  BCacheTestAddresses::AddMn (bcache, 2);
+  NS_TEST_EXPECT_MSG_EQ (bcache->GetSize (), 2, "wrong cache size");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupSHoa (Ipv6Address::MakeSolicitedAddress (BCacheTestAddresses::GetHoa (1))),
+                         true, "solicited HoA not found");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupSHoa (Ipv6Address::MakeSolicitedAddress (BCacheTestAddresses::GetHoa (3))),
+                         false, "unknown solicited HoA found");
+
+  /* any address of the MNP hits, the longest prefix wins */
+  Ipv6Address host ("2002:0:0:1::5");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (host), first, "MNP lookup failed");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (Ipv6Address ("2002:0:0:3::5")), 0, "unknown MNP found");
+
+  BCache::Entry *sub = new BCache::Entry (bcache);
+  sub->SetHoa (Ipv6Address ("2001:db8::ff"));
+  sub->SetMobileNetworkPrefix (Ipv6Address ("2002:0:0:1::"));
+  sub->SetMobileNetworkPrefixLength (80);
+  bcache->Add (sub);
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (host), sub, "longest prefix not preferred");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (Ipv6Address ("2002:0:0:1:1::5")), first, "shorter prefix not matched");
+  bcache->Remove (sub);
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (host), first, "removed prefix still matched");
+
+  /* a new binding for the same HoA replaces the cached one */
+  BCache::Entry *update = BCacheTestAddresses::AddMn (bcache, 1);
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (BCacheTestAddresses::GetHoa (1)), update, "binding not updated");
+  NS_TEST_EXPECT_MSG_EQ (update->GetNext (), first, "previous binding not chained");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (host), update, "MNP not moved to the new binding");
+
+  bcache->Remove (update);
+  delete first;
+  NS_TEST_EXPECT_MSG_EQ (bcache->GetSize (), 1, "entry not removed");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupSHoa (Ipv6Address::MakeSolicitedAddress (BCacheTestAddresses::GetHoa (1))),
+                         false, "removed solicited HoA found");
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (host), 0, "removed MNP found");
+
+  bcache->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (bcache->LookupSHoa (Ipv6Address::MakeSolicitedAddress (BCacheTestAddresses::GetHoa (2))),
+                         false, "flushed solicited HoA found");
+  bcache->Dispose ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief BCache lookups must not depend on the number of MNs.
+ */
+class BCacheScaleTestCase : public TestCase
+{
+public:
+  BCacheScaleTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Time the lookups of every kind.
+   * \param bcache the binding cache
+   * \param mns the number of cached MNs
+   * \return nanoseconds per lookup
+   */
+  double TimeLookups (Ptr<BCache> bcache, uint32_t mns);
+};
+
+BCacheScaleTestCase::BCacheScaleTestCase ()
+  : TestCase ("BCache lookup latency with 100k MNs")
+{
+}
+
+double
+BCacheScaleTestCase::TimeLookups (Ptr<BCache> bcache, uint32_t mns)
+{
+  const uint32_t lookups = 20000;
+  uint32_t hits = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < lookups; i++)
+    {
+      uint32_t index = (i * 7919) % mns;
+      Ipv6Address hoa = BCacheTestAddresses::GetHoa (index);
+      hits += bcache->Lookup (hoa) != 0;
+      hits += bcache->LookupSHoa (Ipv6Address::MakeSolicitedAddress (hoa));
+      hits += bcache->LookupMobileNetworkPrefix (BCacheTestAddresses::GetMnp (index)) != 0;
+    }
+  std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now ();
+
+  NS_TEST_EXPECT_MSG_EQ (hits, 3 * lookups, "lookups missed");
+  return std::chrono::duration<double, std::nano> (stop - start).count () / lookups;
+}
+
+void
+BCacheScaleTestCase::DoRun (void)
+{
+  const uint32_t small = 1000;
+  const uint32_t large = 100000;
+
+  Ptr<BCache> bcache = CreateObject<BCache> ();
+  for (uint32_t i = 0; i < small; i++)
+    {
+      BCacheTestAddresses::AddMn (bcache, i);
+    }
+  double smallTime = TimeLookups (bcache, small);
+
+  for (uint32_t i = small; i < large; i++)
+    {
+      BCacheTestAddresses::AddMn (bcache, i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (bcache->GetSize (), large, "wrong cache size");
+  double largeTime = TimeLookups (bcache, large);
+
+  /* a linear scan would be 100 times slower, leave room for cache misses */
+  NS_TEST_EXPECT_MSG_LT (largeTime, 10 * smallTime, "lookup latency grows with the number of MNs");
+
+  bcache->Dispose ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief BCache TestSuite
+ */
+class BCacheTestSuite : public TestSuite
+{
+public:
+  BCacheTestSuite ()
+    : TestSuite ("segment-routing-bcache", UNIT)
+  {
+    AddTestCase (new BCacheIndexTestCase, TestCase::QUICK);
+    AddTestCase (new BCacheScaleTestCase, TestCase::EXTENSIVE);
+  }
+};
+
+static BCacheTestSuite g_bCacheTestSuite; //!< Static variable for test initialization
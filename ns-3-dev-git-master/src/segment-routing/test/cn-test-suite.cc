@@ -0,0 +1,459 @@
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-option-header.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/bcache.h"
+#include "ns3/cn.h"
+#include "ns3/sr-header.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-l4-protocol.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief CN of the return routability tests, on a link with a default route.
+ */
+class CnTestNode
+{
+public:
+  CnTestNode ()
+  {
+    m_node = CreateObject<Node> ();
+    InternetStackHelper internetv6;
+    internetv6.SetIpv4StackInstall (false);
+    internetv6.Install (m_node);
+
+    SimpleNetDeviceHelper link;
+    Ipv6AddressHelper ipv6helper;
+    ipv6helper.SetBase (Ipv6Address ("2001:cafe::"), Ipv6Prefix (64));
+    ipv6helper.Assign (link.Install (m_node));
+    Ipv6StaticRoutingHelper routingHelper;
+    routingHelper.GetStaticRouting (m_node->GetObject<Ipv6> ())->SetDefaultRoute (Ipv6Address ("fe80::2"), 1);
+
+    Mipv6CnHelper cnHelper;
+    cnHelper.Install (m_node);
+    m_cn = m_node->GetObject<Mipv6CN> ();
+    m_cn->SetAttribute ("NonceCount", UintegerValue (4));
+    m_cn->SetAttribute ("NonceLifetime", TimeValue (Seconds (10)));
+    m_cn->AssignStreams (1);
+    m_address = m_node->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  }
+
+  /**
+   * \brief get the binding cache of the CN.
+   * \return the binding cache
+   */
+  Ptr<BCache> GetBCache (void) const
+  {
+    PointerValue bcache;
+    m_cn->GetAttribute ("BCache", bcache);
+    return bcache.Get<BCache> ();
+  }
+
+  Ptr<Node> m_node;       //!< the node
+  Ptr<Mipv6CN> m_cn;      //!< the CN
+  Ipv6Address m_address;  //!< global address of the CN
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Keygen tokens and rotation of the nonces.
+ */
+class CnNonceTestCase : public TestCase
+{
+public:
+  CnNonceTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief check the tokens of the first nonce.
+   * \param cn the CN
+   */
+  void CheckFirstNonce (Ptr<Mipv6CN> cn);
+
+  /**
+   * \brief check the nonces after some rotations.
+   * \param cn the CN
+   * \param age number of nonces given since the first one
+   */
+  void CheckRotation (Ptr<Mipv6CN> cn, uint16_t age);
+
+  uint16_t m_first;  //!< the first nonce index
+  uint64_t m_token;  //!< home token of the first nonce
+};
+
+CnNonceTestCase::CnNonceTestCase ()
+  : TestCase ("CN keygen tokens and nonce rotation"),
+    m_first (0),
+    m_token (0)
+{
+}
+
+void
+CnNonceTestCase::CheckFirstNonce (Ptr<Mipv6CN> cn)
+{
+  Ipv6Address hoa ("2001:1::10");
+  m_first = cn->GetNonceIndex ();
+  m_token = cn->GetHomeKeygenToken (hoa, m_first);
+  NS_TEST_EXPECT_MSG_EQ (cn->IsNonceIndexValid (m_first), true, "current nonce not valid");
+  NS_TEST_EXPECT_MSG_EQ (cn->IsNonceIndexValid (m_first - 1), false, "nonce before the first one valid");
+  NS_TEST_EXPECT_MSG_NE (m_token, 0, "no home token");
+  NS_TEST_EXPECT_MSG_EQ (cn->GetHomeKeygenToken (hoa, m_first), m_token, "token not stable");
+  NS_TEST_EXPECT_MSG_NE (cn->GetHomeKeygenToken (Ipv6Address ("2001:1::11"), m_first), m_token, "same token for two HoAs");
+  NS_TEST_EXPECT_MSG_NE (cn->GetCareOfKeygenToken (hoa, m_first), m_token, "same home and care-of tokens");
+}
+
+void
+CnNonceTestCase::CheckRotation (Ptr<Mipv6CN> cn, uint16_t age)
+{
+  Ipv6Address hoa ("2001:1::10");
+  uint16_t index = cn->GetNonceIndex ();
+  NS_TEST_EXPECT_MSG_EQ (index, uint16_t (m_first + age), "nonce not rotated");
+  NS_TEST_EXPECT_MSG_EQ (cn->IsNonceIndexValid (index), true, "current nonce not valid");
+  NS_TEST_EXPECT_MSG_NE (cn->GetHomeKeygenToken (hoa, index), m_token, "new nonce gives the same token");
+  if (age < 4)
+    {
+      NS_TEST_EXPECT_MSG_EQ (cn->IsNonceIndexValid (m_first), true, "nonce expired too early");
+      NS_TEST_EXPECT_MSG_EQ (cn->GetHomeKeygenToken (hoa, m_first), m_token, "token of a kept nonce changed");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (cn->IsNonceIndexValid (m_first), false, "nonce not expired");
+      NS_TEST_EXPECT_MSG_EQ (cn->GetHomeKeygenToken (hoa, m_first), 0, "token of an expired nonce");
+    }
+}
+
+void
+CnNonceTestCase::DoRun (void)
+{
+  CnTestNode node;
+
+  Simulator::Schedule (Seconds (1), &CnNonceTestCase::CheckFirstNonce, this, node.m_cn);
+  Simulator::Schedule (Seconds (35), &CnNonceTestCase::CheckRotation, this, node.m_cn, 3);
+  Simulator::Schedule (Seconds (45), &CnNonceTestCase::CheckRotation, this, node.m_cn, 4);
+  //the periods nobody asked for are caught up at once
+  Simulator::Schedule (Seconds (1000), &CnNonceTestCase::CheckRotation, this, node.m_cn, 100);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief BUs checked against the nonce indices and the authenticator.
+ */
+class CnBindingTestCase : public TestCase
+{
+public:
+  CnBindingTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief build a BU as the MN does after the return routability.
+   * \param hoa home address
+   * \param homeIndex home nonce index
+   * \param careOfIndex care-of nonce index
+   * \param authenticate computes the authenticator of the mobility header
+   * \param lifetime the lifetime in units of 4 seconds
+   * \return the BU packet
+   */
+  static Ptr<Packet> BuildBu (Ipv6Address hoa, uint16_t homeIndex, uint16_t careOfIndex,
+                              Callback<uint64_t, const uint8_t *, uint32_t> authenticate, uint16_t lifetime);
+
+  /**
+   * \brief copy a BU with a field rewritten and the authenticator kept.
+   * \param bu the BU packet
+   * \param offset offset of the 16 bits field in the mobility header
+   * \param value the new value
+   * \return the modified BU packet
+   */
+  static Ptr<Packet> Tamper (Ptr<const Packet> bu, uint32_t offset, uint16_t value);
+
+  /**
+   * \brief register, then check the rejected BUs.
+   * \param node the CN
+   */
+  void Register (CnTestNode *node);
+
+  /**
+   * \brief check a BU made with expired nonces, then deregister.
+   * \param node the CN
+   */
+  void Deregister (CnTestNode *node);
+
+  uint16_t m_index;  //!< the nonce index of the registration
+};
+
+CnBindingTestCase::CnBindingTestCase ()
+  : TestCase ("CN BU authorization"),
+    m_index (0)
+{
+}
+
+Ptr<Packet>
+CnBindingTestCase::BuildBu (Ipv6Address hoa, uint16_t homeIndex, uint16_t careOfIndex,
+                            Callback<uint64_t, const uint8_t *, uint32_t> authenticate, uint16_t lifetime)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  Ipv6ExtensionDestinationHeader dest;
+  Ipv6HomeAddressOptionHeader homeopt;
+  homeopt.SetHomeAddress (hoa);
+  dest.AddOption (homeopt);
+  dest.SetNextHeader (59);
+  p->AddHeader (dest);
+
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (1);
+  bu.SetFlagA (true);
+  bu.SetFlagK (true);
+  bu.SetLifetime (lifetime);
+  Ipv6MobilityOptionNonceIndicesHeader indices;
+  indices.SetHomeNonceIndex (homeIndex);
+  indices.SetCareOfNonceIndex (careOfIndex);
+  bu.AddOption (indices);
+  Ipv6MobilityOptionBindingAuthorizationDataHeader authorization;
+  bu.AddOption (authorization);
+  p->AddHeader (bu);
+
+  Mipv6MessageTemplate message;
+  message.Set (p);
+  return message.Build (1, lifetime, authenticate);
+}
+
+Ptr<Packet>
+CnBindingTestCase::Tamper (Ptr<const Packet> bu, uint32_t offset, uint16_t value)
+{
+  std::vector<uint8_t> data (bu->GetSize ());
+  bu->CopyData (&data[0], data.size ());
+  data[offset] = value >> 8;
+  data[offset + 1] = value & 0xff;
+  return Create<Packet> (&data[0], data.size ());
+}
+
+void
+CnBindingTestCase::Register (CnTestNode *node)
+{
+  Ptr<Mipv6CN> cn = node->m_cn;
+  Ptr<Mipv6L4Protocol> l4 = node->m_node->GetObject<Mipv6L4Protocol> ();
+  Ptr<BCache> bcache = node->GetBCache ();
+  Ipv6Address hoa ("2001:1::10");
+  Ipv6Address coa ("2001:a::10");
+
+  m_index = cn->GetNonceIndex ();
+  Callback<uint64_t, const uint8_t *, uint32_t> authenticate = MakeBoundCallback (&Mipv6CN::ComputeAuthenticator,
+                                                                                 cn->GetHomeKeygenToken (hoa, m_index),
+                                                                                 cn->GetCareOfKeygenToken (coa, m_index),
+                                                                                 coa, node->m_address);
+  Ptr<Packet> registration = BuildBu (hoa, m_index, m_index, authenticate, 10);
+  l4->Receive (registration->Copy (), coa, node->m_address, 0);
+  NS_TEST_ASSERT_MSG_EQ (bcache->GetSize (), 1, "authorized BU not bound");
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (hoa)->GetCoa (), coa, "wrong CoA");
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (hoa)->GetRemainingLifetime (), Seconds (40), "wrong lifetime");
+
+  /* the tokens are bound to the addresses of the MN and to the CN */
+  Ipv6Address other ("2001:1::11");
+  l4->Receive (BuildBu (other, m_index, m_index, authenticate, 10), coa, node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bool (bcache->Lookup (other)), false, "BU of another HoA bound");
+  l4->Receive (registration->Copy (), Ipv6Address ("2001:b::10"), node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (hoa)->GetCoa (), coa, "BU from another CoA bound");
+
+  /* the authenticator covers the sequence and the lifetime of the BU */
+  l4->Receive (Tamper (registration, 6, 2), coa, node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (hoa)->GetLastBindingUpdateSequence (), 1, "BU with a modified sequence bound");
+  l4->Receive (Tamper (registration, 10, 100), coa, node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (hoa)->GetRemainingLifetime (), Seconds (40), "BU with a modified lifetime bound");
+
+  /* a BU without authorization is ignored */
+  Ptr<Packet> bare = Create<Packet> ();
+  Ipv6ExtensionDestinationHeader dest;
+  Ipv6HomeAddressOptionHeader homeopt;
+  homeopt.SetHomeAddress (other);
+  dest.AddOption (homeopt);
+  dest.SetNextHeader (59);
+  bare->AddHeader (dest);
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetLifetime (10);
+  bare->AddHeader (bu);
+  l4->Receive (bare, coa, node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bcache->GetSize (), 1, "BU without authorization bound");
+}
+
+void
+CnBindingTestCase::Deregister (CnTestNode *node)
+{
+  Ptr<Mipv6CN> cn = node->m_cn;
+  Ptr<Mipv6L4Protocol> l4 = node->m_node->GetObject<Mipv6L4Protocol> ();
+  Ptr<BCache> bcache = node->GetBCache ();
+  Ipv6Address hoa ("2001:1::10");
+  Ipv6Address coa ("2001:a::12");
+
+  /* the nonces of the registration are gone, the tokens are no longer accepted */
+  NS_TEST_ASSERT_MSG_EQ (cn->IsNonceIndexValid (m_index), false, "nonce not expired");
+  NS_TEST_ASSERT_MSG_EQ (bool (bcache->Lookup (hoa)), true, "binding expired too early");
+  l4->Receive (BuildBu (hoa, m_index, m_index, MakeBoundCallback (&Mipv6CN::ComputeAuthenticator, uint64_t (0), uint64_t (0),
+                                                                  coa, node->m_address), 10),
+               coa, node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bcache->Lookup (hoa)->GetCoa (), Ipv6Address ("2001:a::10"), "BU with expired nonces bound");
+
+  /* a deregistration from the home link only needs the home token */
+  uint16_t index = cn->GetNonceIndex ();
+  l4->Receive (BuildBu (hoa, index, 0, MakeBoundCallback (&Mipv6CN::ComputeAuthenticator, cn->GetHomeKeygenToken (hoa, index),
+                                                          uint64_t (0), hoa, node->m_address), 0),
+               hoa, node->m_address, 0);
+  NS_TEST_EXPECT_MSG_EQ (bcache->GetSize (), 0, "binding not removed");
+}
+
+void
+CnBindingTestCase::DoRun (void)
+{
+  CnTestNode node;
+  //the binding lives until 41 seconds, its nonces until 40 seconds
+  Simulator::Schedule (Seconds (1), &CnBindingTestCase::Register, this, &node);
+  Simulator::Schedule (Seconds (40.5), &CnBindingTestCase::Deregister, this, &node);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Bursts of HoTIs and CoTIs answered together.
+ */
+class CnBatchTestCase : public TestCase
+{
+public:
+  CnBatchTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief send a HoTI or a CoTI to the CN.
+   * \param node the CN
+   * \param hoa home address of the MN
+   * \param src source of the test
+   * \param home whether it is a HoTI
+   */
+  static void SendTest (CnTestNode *node, Ipv6Address hoa, Ipv6Address src, bool home);
+
+  /**
+   * \brief record an answer of the CN.
+   * \param packet the answer
+   */
+  void Tx (Ptr<const Packet> packet);
+
+  std::vector<Time> m_times;        //!< transmission times of the answers
+  std::vector<uint16_t> m_indices;  //!< nonce indices of the answers
+};
+
+CnBatchTestCase::CnBatchTestCase ()
+  : TestCase ("CN answers HoTI and CoTI bursts together")
+{
+}
+
+void
+CnBatchTestCase::SendTest (CnTestNode *node, Ipv6Address hoa, Ipv6Address src, bool home)
+{
+  Ptr<Packet> p = Create<Packet> ();
+  Ipv6ExtensionDestinationHeader dest;
+  Ipv6HomeAddressOptionHeader homeopt;
+  homeopt.SetHomeAddress (hoa);
+  dest.AddOption (homeopt);
+  dest.SetNextHeader (59);
+  p->AddHeader (dest);
+  if (home)
+    {
+      p->AddHeader (Ipv6HoTIHeader ());
+    }
+  else
+    {
+      p->AddHeader (Ipv6CoTIHeader ());
+    }
+  node->m_node->GetObject<Mipv6L4Protocol> ()->Receive (p, src, node->m_address, 0);
+}
+
+void
+CnBatchTestCase::Tx (Ptr<const Packet> packet)
+{
+  m_times.push_back (Simulator::Now ());
+  Mipv6MessageView view;
+  Ptr<Packet> p = packet->Copy ();
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (p), true, "malformed answer");
+  if (view.GetMhType () == Mipv6Header::HOME_TEST)
+    {
+      Ipv6HoTHeader hot;
+      p->RemoveHeader (hot);
+      m_indices.push_back (hot.GetHomeNonceIndex ());
+    }
+  else
+    {
+      Ipv6CoTHeader cot;
+      p->RemoveHeader (cot);
+      m_indices.push_back (cot.GetCareOfNonceIndex ());
+    }
+}
+
+void
+CnBatchTestCase::DoRun (void)
+{
+  CnTestNode node;
+  node.m_cn->SetAttribute ("TestBatchDelay", TimeValue (MilliSeconds (5)));
+  node.m_cn->TraceConnectWithoutContext ("AgentTx", MakeCallback (&CnBatchTestCase::Tx, this));
+
+  for (uint8_t i = 0; i < 3; i++)
+    {
+      uint8_t hoa[16] = { 0x20, 0x01, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, uint8_t (0x10 + i) };
+      uint8_t coa[16] = { 0x20, 0x01, 0, 0x0a, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, uint8_t (0x10 + i) };
+      Simulator::Schedule (Seconds (9.997) + MilliSeconds (i), &CnBatchTestCase::SendTest, &node, Ipv6Address (hoa), Ipv6Address (hoa), true);
+      Simulator::Schedule (Seconds (9.997) + MilliSeconds (i), &CnBatchTestCase::SendTest, &node, Ipv6Address (hoa), Ipv6Address (coa), false);
+    }
+  Simulator::Schedule (Seconds (20), &CnBatchTestCase::SendTest, &node, Ipv6Address ("2001:1::10"), Ipv6Address ("2001:1::10"), true);
+  Simulator::Run ();
+
+  /* the burst crosses a nonce rotation, it is answered with the nonce of the answer time */
+  NS_TEST_ASSERT_MSG_EQ (m_times.size (), 7, "wrong number of answers");
+  for (uint8_t i = 0; i < 6; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], Seconds (10.002), "burst not answered together");
+      NS_TEST_EXPECT_MSG_EQ (m_indices[i], m_indices[0], "burst answered with several nonces");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_times[6], Seconds (20.005), "single test not answered");
+  NS_TEST_EXPECT_MSG_EQ (m_indices[6], uint16_t (m_indices[0] + 1), "nonce not rotated");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief CN TestSuite
+ */
+class CnTestSuite : public TestSuite
+{
+public:
+  CnTestSuite ()
+    : TestSuite ("segment-routing-cn", UNIT)
+  {
+    AddTestCase (new CnNonceTestCase (), TestCase::QUICK);
+    AddTestCase (new CnBindingTestCase (), TestCase::QUICK);
+    AddTestCase (new CnBatchTestCase (), TestCase::QUICK);
+  }
+};
+
+static CnTestSuite g_cnTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,207 @@
+#include "ns3/boolean.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/sr-event-log.h"
+#include "ns3/sr-tun-l4-protocol.h"
+#include "ns3/tunnel-net-device.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Records go through a ring smaller than the log and several file chunks.
+ */
+class EventLogRingTestCase : public TestCase
+{
+public:
+  EventLogRingTestCase ();
+  virtual void DoRun (void);
+};
+
+EventLogRingTestCase::EventLogRingTestCase ()
+  : TestCase ("Event log ring and file chunks")
+{
+}
+
+void
+EventLogRingTestCase::DoRun (void)
+{
+  std::string path = CreateTempDirFilename ("events.bin");
+  Ptr<Mipv6EventLog> log = CreateObject<Mipv6EventLog> ();
+  log->SetAttribute ("Capacity", UintegerValue (64));
+  log->SetAttribute ("Segments", UintegerValue (4));
+  log->SetAttribute ("ChunkSize", UintegerValue (4096));
+  NS_TEST_ASSERT_MSG_EQ (log->Open (path), true, "log not created");
+
+  const uint32_t n = 1000;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Mipv6EventLog::Record record;
+      std::memset (&record, 0, sizeof (record));
+      record.type = Mipv6EventLog::BU_SENT + i % 4;
+      record.node = i;
+      record.sequence = i * 7;
+      record.value = uint64_t (i) << 32;
+      Ipv6Address ("2001:db8::1").GetBytes (record.address1);
+      log->Log (record);
+    }
+  NS_TEST_EXPECT_MSG_EQ (log->GetNRecords (), n, "records lost");
+  log->Close ();
+  NS_TEST_EXPECT_MSG_EQ (log->IsOpen (), false, "log still open");
+
+  std::vector<Mipv6EventLog::Record> records;
+  NS_TEST_ASSERT_MSG_EQ (Mipv6EventLog::Read (path, records), true, "log not read");
+  NS_TEST_ASSERT_MSG_EQ (records.size (), n, "wrong number of records");
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (records[i].node, i, "records out of order");
+      NS_TEST_EXPECT_MSG_EQ (records[i].sequence, uint16_t (i * 7), "wrong sequence");
+      NS_TEST_EXPECT_MSG_EQ (records[i].value, uint64_t (i) << 32, "wrong value");
+      NS_TEST_EXPECT_MSG_EQ (Ipv6Address (records[i].address1), Ipv6Address ("2001:db8::1"), "wrong address");
+    }
+
+  std::ostringstream csv;
+  Mipv6EventLog::WriteCsv (records, csv);
+  std::istringstream lines (csv.str ());
+  std::string line;
+  uint32_t nLines = 0;
+  while (std::getline (lines, line))
+    {
+      nLines++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (nLines, n + 1, "wrong number of CSV lines");
+
+  std::string prefix = CreateTempDirFilename ("events");
+  NS_TEST_ASSERT_MSG_EQ (Mipv6EventLog::WriteColumns (records, prefix), true, "columns not written");
+  std::ifstream node ((prefix + ".node").c_str (), std::ios::binary | std::ios::ate);
+  NS_TEST_EXPECT_MSG_EQ (uint64_t (node.tellg ()), n * sizeof (uint32_t), "wrong size of a column");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Tunnel references and encapsulated traffic are logged.
+ */
+class EventLogTunnelTestCase : public TestCase
+{
+public:
+  EventLogTunnelTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a packet through the tunnel device.
+   * \param tunnel the tunnel device
+   */
+  void Send (Ptr<TunnelNetDevice> tunnel);
+};
+
+EventLogTunnelTestCase::EventLogTunnelTestCase ()
+  : TestCase ("Event log of tunnels")
+{
+}
+
+void
+EventLogTunnelTestCase::Send (Ptr<TunnelNetDevice> tunnel)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  Ipv6Header inner;
+  inner.SetSource (Ipv6Address ("2001:2::1"));
+  inner.SetDestination (Ipv6Address ("2001:db8::1"));
+  inner.SetNextHeader (59);
+  inner.SetPayloadLength (packet->GetSize ());
+  packet->AddHeader (inner);
+  tunnel->Send (packet, tunnel->GetBroadcast (), 0x86DD);
+}
+
+void
+EventLogTunnelTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (nodes);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  nodes.Get (0)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net);
+
+  Ptr<Ipv6TunnelL4Protocol> th = CreateObject<Ipv6TunnelL4Protocol> ();
+  nodes.Get (0)->AggregateObject (th);
+  th->SetNode (nodes.Get (0));
+
+  std::string path = CreateTempDirFilename ("tunnel.bin");
+  Ptr<Mipv6EventLog> log = CreateObject<Mipv6EventLog> ();
+  NS_TEST_ASSERT_MSG_EQ (log->Open (path), true, "log not created");
+  log->Connect (nodes);
+
+  // only the first and the last reference of a remote are logged
+  Ipv6Address coa ("2001:1::100");
+  th->AddTunnel (coa);
+  th->AddTunnel (coa);
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (coa);
+  Send (tunnel);
+  Send (tunnel);
+  Send (tunnel);
+  th->RemoveTunnel (coa);
+  th->RemoveTunnel (coa);
+  log->Close ();
+
+  std::vector<Mipv6EventLog::Record> records;
+  NS_TEST_ASSERT_MSG_EQ (Mipv6EventLog::Read (path, records), true, "log not read");
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 3, "wrong number of records");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) records[0].type, Mipv6EventLog::TUNNEL_ADD, "tunnel add not logged");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) records[1].type, Mipv6EventLog::TUNNEL_REMOVE, "tunnel remove not logged");
+  NS_TEST_EXPECT_MSG_EQ (Ipv6Address (records[1].address1), coa, "wrong remote");
+  NS_TEST_EXPECT_MSG_EQ (records[1].node, nodes.Get (0)->GetId (), "wrong node");
+
+  // the encapsulated packets are summed until the log is closed
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) records[2].type, Mipv6EventLog::ENCAP, "encapsulation not logged");
+  NS_TEST_EXPECT_MSG_EQ (records[2].aux, 3, "wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (records[2].value, 3 * (100 + 2 * 40), "wrong number of bytes");
+  NS_TEST_EXPECT_MSG_EQ (Ipv6Address (records[2].address1), coa, "wrong remote");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Event log TestSuite
+ */
+class EventLogTestSuite : public TestSuite
+{
+public:
+  EventLogTestSuite ()
+    : TestSuite ("segment-routing-event-log", UNIT)
+  {
+    AddTestCase (new EventLogRingTestCase, TestCase::QUICK);
+    AddTestCase (new EventLogTunnelTestCase, TestCase::QUICK);
+  }
+};
+
+static EventLogTestSuite g_eventLogTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,623 @@
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-option-header.h"
+#include "ns3/ipv6-routing-table-entry.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/bcache.h"
+#include "ns3/ha.h"
+#include "ns3/sr-event-log.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-l4-protocol.h"
+#include "ns3/sr-option-header.h"
+#include "ns3/sr-tun-l4-protocol.h"
+#include "ns3/tunnel-net-device.h"
+
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief HA of mobile routers on its home link, with a default route.
+ */
+class HaTestNode
+{
+public:
+  HaTestNode ()
+  {
+    m_node = CreateObject<Node> ();
+    InternetStackHelper internetv6;
+    internetv6.SetIpv4StackInstall (false);
+    internetv6.Install (m_node);
+
+    SimpleNetDeviceHelper link;
+    Ipv6AddressHelper ipv6helper;
+    ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+    ipv6helper.Assign (link.Install (m_node));
+    Ipv6StaticRoutingHelper routingHelper;
+    routingHelper.GetStaticRouting (m_node->GetObject<Ipv6> ())->SetDefaultRoute (Ipv6Address ("fe80::2"), 1);
+
+    Mipv6HaHelper haHelper;
+    haHelper.SetHAAs (true);
+    haHelper.Install (m_node);
+    m_ha = m_node->GetObject<Mipv6Ha> ();
+    m_address = m_node->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  }
+
+  /**
+   * \brief get the binding cache of the HA.
+   * \return the binding cache
+   */
+  Ptr<BCache> GetBCache (void) const
+  {
+    PointerValue bcache;
+    m_ha->GetAttribute ("BCache", bcache);
+    return bcache.Get<BCache> ();
+  }
+
+  /**
+   * \brief give a BU of a mobile router to the HA.
+   * \param hoa home address of the MR
+   * \param coa care-of address of the MR, the HoA for a deregistration
+   * \param sequence sequence number
+   * \param mnps the mobile network prefixes
+   */
+  void ReceiveBu (Ipv6Address hoa, Ipv6Address coa, uint16_t sequence, std::vector<Ipv6Address> mnps)
+  {
+    ReceiveMultiHomedBu (hoa, coa, sequence, mnps, std::vector<std::pair<Ipv6Address, uint8_t> > ());
+  }
+
+  /**
+   * \brief give a BU of a multihomed mobile router to the HA.
+   * \param hoa home address of the MR
+   * \param coa care-of address of the MR, the HoA for a deregistration
+   * \param sequence sequence number
+   * \param mnps the mobile network prefixes
+   * \param coas the CoAs of the MR and their weights, in Binding Identifier options
+   */
+  void ReceiveMultiHomedBu (Ipv6Address hoa, Ipv6Address coa, uint16_t sequence, std::vector<Ipv6Address> mnps,
+                            std::vector<std::pair<Ipv6Address, uint8_t> > coas)
+  {
+    Ptr<Packet> p = Create<Packet> ();
+    Ipv6ExtensionDestinationHeader dest;
+    Ipv6HomeAddressOptionHeader homeopt;
+    homeopt.SetHomeAddress (hoa);
+    dest.AddOption (homeopt);
+    dest.SetNextHeader (59);
+    p->AddHeader (dest);
+
+    Ipv6MobilityBindingUpdateHeader bu;
+    bu.SetSequence (sequence);
+    bu.SetFlagA (true);
+    bu.SetFlagH (true);
+    bu.SetFlagR (true);
+    bu.SetLifetime (coa == hoa ? 0 : 10);
+    for (std::vector<Ipv6Address>::const_iterator it = mnps.begin (); it != mnps.end (); it++)
+      {
+        Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
+        mnph.SetMobileNetworkPrefix (*it);
+        mnph.SetPrefixLength (64);
+        bu.AddOption (mnph);
+      }
+    for (uint16_t i = 0; i < coas.size (); i++)
+      {
+        Ipv6MobilityOptionBindingIdentifierHeader bid;
+        bid.SetBindingId (i + 1);
+        bid.SetCareofAddress (coas[i].first);
+        bid.SetPriority (coas[i].second);
+        bu.AddOption (bid);
+      }
+    p->AddHeader (bu);
+
+    Ptr<Ipv6Interface> interface = m_node->GetObject<Ipv6L3Protocol> ()->GetInterface (1);
+    m_node->GetObject<Mipv6L4Protocol> ()->Receive (p, coa, m_address, interface);
+  }
+
+  /**
+   * \brief get the interface of the route of the HA to a prefix.
+   * \param network the prefix
+   * \param length the prefix length
+   * \return the interface, -1 if there is no route
+   */
+  int32_t GetRouteInterface (Ipv6Address network, uint8_t length) const
+  {
+    Ipv6StaticRoutingHelper routingHelper;
+    Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (m_node->GetObject<Ipv6> ());
+    for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+      {
+        Ipv6RoutingTableEntry route = routing->GetRoute (i);
+        if (route.GetDestNetwork () == network && route.GetDestNetworkPrefix ().GetPrefixLength () == length)
+          {
+            return route.GetInterface ();
+          }
+      }
+    return -1;
+  }
+
+  Ptr<Node> m_node;       //!< the node
+  Ptr<Mipv6Ha> m_ha;      //!< the HA
+  Ipv6Address m_address;  //!< global address of the HA
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Make an address from a prefix and a number.
+ * \param prefix the first 16 bits
+ * \param subnet the second 16 bits
+ * \param host the last 16 bits
+ * \return the address
+ */
+static Ipv6Address
+MakeHaTestAddress (uint16_t prefix, uint16_t subnet, uint16_t host)
+{
+  uint8_t buf[16] = { 0x20, 0x01, uint8_t (prefix >> 8), uint8_t (prefix), uint8_t (subnet >> 8), uint8_t (subnet),
+                      0, 0, 0, 0, 0, 0, 0, 0, uint8_t (host >> 8), uint8_t (host) };
+  return Ipv6Address (buf);
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief A burst of MR registrations with several prefixes each,
+ * acknowledged and routed together at the end of their DAD.
+ */
+class HaBatchTestCase : public TestCase
+{
+public:
+  HaBatchTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief send the BU of an MR.
+   * \param node the HA
+   * \param index index of the MR
+   */
+  static void Register (HaTestNode *node, uint16_t index);
+
+  /**
+   * \brief check the bindings in DAD while the burst waits.
+   * \param node the HA
+   */
+  void CheckPending (HaTestNode *node);
+
+  /**
+   * \brief record a BA of the HA.
+   * \param packet the BA
+   */
+  void Tx (Ptr<const Packet> packet);
+
+  std::vector<Time> m_times;  //!< transmission times of the BAs
+};
+
+HaBatchTestCase::HaBatchTestCase ()
+  : TestCase ("HA registers MR bursts with several prefixes together")
+{
+}
+
+void
+HaBatchTestCase::Register (HaTestNode *node, uint16_t index)
+{
+  std::vector<Ipv6Address> mnps;
+  mnps.push_back (MakeHaTestAddress (0x100, index, 0));
+  mnps.push_back (MakeHaTestAddress (0x200, index, 0));
+  node->ReceiveBu (MakeHaTestAddress (1, 0, 0x100 + index), MakeHaTestAddress (0xa, 0, 0x100 + index), 1, mnps);
+}
+
+void
+HaBatchTestCase::CheckPending (HaTestNode *node)
+{
+  NS_TEST_EXPECT_MSG_EQ (node->m_ha->GetNPendingBindings (), 50, "burst not in DAD");
+  NS_TEST_EXPECT_MSG_EQ (m_times.size (), 0, "BA sent before the end of the DAD");
+  NS_TEST_EXPECT_MSG_EQ (node->GetRouteInterface (MakeHaTestAddress (0x100, 7, 0), 64), -1, "MNP routed before the end of the DAD");
+}
+
+void
+HaBatchTestCase::Tx (Ptr<const Packet> packet)
+{
+  Mipv6MessageView view;
+  Ptr<Packet> p = packet->Copy ();
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (p), true, "malformed message");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)view.GetMhType (), (uint32_t)Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT, "not a BA");
+  m_times.push_back (Simulator::Now ());
+}
+
+void
+HaBatchTestCase::DoRun (void)
+{
+  HaTestNode node;
+  node.m_ha->TraceConnectWithoutContext ("AgentTx", MakeCallback (&HaBatchTestCase::Tx, this));
+
+  for (uint16_t i = 0; i < 50; i++)
+    {
+      Simulator::Schedule (Seconds (1), &HaBatchTestCase::Register, &node, i);
+    }
+  Simulator::Schedule (Seconds (1.5), &HaBatchTestCase::CheckPending, this, &node);
+  //a BU received during the DAD of the burst waits for its own DAD
+  Simulator::Schedule (Seconds (1.5), &HaBatchTestCase::Register, &node, 50);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_times.size (), 51, "wrong number of BAs");
+  for (uint16_t i = 0; i < 50; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_times[i], Seconds (2), "burst not acknowledged together");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_times[50], Seconds (2.5), "late BU not acknowledged after its DAD");
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNPendingBindings (), 0, "bindings left in DAD");
+
+  Ptr<BCache> bcache = node.GetBCache ();
+  NS_TEST_EXPECT_MSG_EQ (bcache->GetSize (), 51, "wrong number of bindings");
+  int32_t tunnelIf = node.m_node->GetObject<Ipv6TunnelL4Protocol> ()->CreateTunnelDevice ();
+  for (uint16_t i = 0; i <= 50; i++)
+    {
+      Ipv6Address hoa = MakeHaTestAddress (1, 0, 0x100 + i);
+      BCache::Entry *bce = bcache->Lookup (hoa);
+      NS_TEST_ASSERT_MSG_EQ (bool (bce), true, "MR not bound");
+      NS_TEST_EXPECT_MSG_EQ (bce->GetMobileNetworkPrefixes ().size (), 2, "prefixes not registered");
+      NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (MakeHaTestAddress (0x100, i, 5)), bce, "first MNP not indexed");
+      NS_TEST_EXPECT_MSG_EQ (bcache->LookupMobileNetworkPrefix (MakeHaTestAddress (0x200, i, 5)), bce, "second MNP not indexed");
+      NS_TEST_EXPECT_MSG_EQ (node.GetRouteInterface (hoa, 128), tunnelIf, "HoA not routed to the tunnel");
+      NS_TEST_EXPECT_MSG_EQ (node.GetRouteInterface (MakeHaTestAddress (0x100, i, 0), 64), tunnelIf, "first MNP not routed to the tunnel");
+      NS_TEST_EXPECT_MSG_EQ (node.GetRouteInterface (MakeHaTestAddress (0x200, i, 0), 64), tunnelIf, "second MNP not routed to the tunnel");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief A registration withdrawn during its DAD is neither acknowledged
+ * nor routed.
+ */
+class HaWithdrawTestCase : public TestCase
+{
+public:
+  HaWithdrawTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief record a message of the HA.
+   * \param packet the message
+   */
+  void Tx (Ptr<const Packet> packet);
+
+  std::vector<Time> m_times;  //!< transmission times of the BAs
+};
+
+HaWithdrawTestCase::HaWithdrawTestCase ()
+  : TestCase ("HA drops registrations withdrawn during their DAD")
+{
+}
+
+void
+HaWithdrawTestCase::Tx (Ptr<const Packet> packet)
+{
+  m_times.push_back (Simulator::Now ());
+}
+
+void
+HaWithdrawTestCase::DoRun (void)
+{
+  HaTestNode node;
+  node.m_ha->TraceConnectWithoutContext ("AgentTx", MakeCallback (&HaWithdrawTestCase::Tx, this));
+  std::string path = CreateTempDirFilename ("ha.bin");
+  Ptr<Mipv6EventLog> log = CreateObject<Mipv6EventLog> ();
+  NS_TEST_ASSERT_MSG_EQ (log->Open (path), true, "log not created");
+  log->Connect (node.m_node);
+
+  Ipv6Address hoa = MakeHaTestAddress (1, 0, 0x100);
+  Ipv6Address coa = MakeHaTestAddress (0xa, 0, 0x100);
+  std::vector<Ipv6Address> mnps (1, MakeHaTestAddress (0x100, 0, 0));
+  Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveBu, &node, hoa, coa, 1, mnps);
+  Simulator::Schedule (Seconds (1.2), &HaTestNode::ReceiveBu, &node, hoa, hoa, 2, mnps);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  //only the BA of the deregistration is sent
+  NS_TEST_ASSERT_MSG_EQ (m_times.size (), 1, "wrong number of BAs");
+  NS_TEST_EXPECT_MSG_EQ (m_times[0], Seconds (1.2), "deregistration not acknowledged at once");
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNPendingBindings (), 0, "binding left in DAD");
+  NS_TEST_EXPECT_MSG_EQ (node.GetBCache ()->GetSize (), 0, "withdrawn binding kept");
+  NS_TEST_EXPECT_MSG_EQ (node.GetRouteInterface (MakeHaTestAddress (0x100, 0, 0), 64), -1, "withdrawn MNP routed");
+
+  //the event log holds both BUs and the BA
+  log->Close ();
+  std::vector<Mipv6EventLog::Record> records;
+  NS_TEST_ASSERT_MSG_EQ (Mipv6EventLog::Read (path, records), true, "log not read");
+  std::vector<Mipv6EventLog::Record> messages;
+  for (std::vector<Mipv6EventLog::Record>::const_iterator it = records.begin (); it != records.end (); it++)
+    {
+      if (it->type >= Mipv6EventLog::BU_SENT && it->type <= Mipv6EventLog::BA_RECEIVED)
+        {
+          messages.push_back (*it);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (messages.size (), 3, "wrong number of logged messages");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) messages[0].type, Mipv6EventLog::BU_RECEIVED, "BU not logged");
+  NS_TEST_EXPECT_MSG_EQ (messages[0].sequence, 1, "wrong BU sequence");
+  NS_TEST_EXPECT_MSG_EQ (Ipv6Address (messages[0].address1), coa, "wrong BU source");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) messages[2].type, Mipv6EventLog::BA_SENT, "BA not logged");
+  NS_TEST_EXPECT_MSG_EQ (messages[2].sequence, 2, "wrong BA sequence");
+  NS_TEST_EXPECT_MSG_EQ (messages[2].time, Seconds (1.2).GetNanoSeconds (), "wrong BA time");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief A registration whose HoA is found on the home link during its DAD is refused.
+ */
+class HaDadFailureTestCase : public TestCase
+{
+public:
+  HaDadFailureTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief record a message of the HA.
+   * \param packet the message
+   */
+  void Tx (Ptr<const Packet> packet);
+
+  std::vector<Ipv6MobilityBindingAckHeader> m_bas;  //!< the BAs sent
+};
+
+HaDadFailureTestCase::HaDadFailureTestCase ()
+  : TestCase ("HA refuses registrations whose DAD failed")
+{
+}
+
+void
+HaDadFailureTestCase::Tx (Ptr<const Packet> packet)
+{
+  Ipv6MobilityBindingAckHeader ba;
+  packet->PeekHeader (ba);
+  m_bas.push_back (ba);
+}
+
+void
+HaDadFailureTestCase::DoRun (void)
+{
+  HaTestNode node;
+  node.m_ha->TraceConnectWithoutContext ("AgentTx", MakeCallback (&HaDadFailureTestCase::Tx, this));
+
+  Ipv6Address duplicate = MakeHaTestAddress (1, 0, 0x100);
+  Ipv6Address hoa = MakeHaTestAddress (1, 0, 0x200);
+  std::vector<Ipv6Address> mnps (1, MakeHaTestAddress (0x100, 0, 0));
+  Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveBu, &node, duplicate, MakeHaTestAddress (0xa, 0, 0x100), 1, mnps);
+  Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveBu, &node, hoa, MakeHaTestAddress (0xa, 0, 0x200), 1,
+                       std::vector<Ipv6Address> (1, MakeHaTestAddress (0x200, 0, 0)));
+  Simulator::Schedule (Seconds (1.1), &Mipv6Ha::DADFailureIndication, node.m_ha, duplicate);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_bas.size (), 2, "wrong number of BAs");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) m_bas[0].GetStatus (), Mipv6Header::BA_STATUS_DAD_FAILED, "duplicate HoA accepted");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) m_bas[1].GetStatus (), Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED, "HoA refused");
+  NS_TEST_EXPECT_MSG_EQ (bool (node.GetBCache ()->Lookup (duplicate)), false, "duplicate binding kept");
+  NS_TEST_EXPECT_MSG_EQ (bool (node.GetBCache ()->Lookup (hoa)), true, "binding not kept");
+  NS_TEST_EXPECT_MSG_EQ (node.GetRouteInterface (MakeHaTestAddress (0x100, 0, 0), 64), -1, "duplicate MNP routed");
+  NS_TEST_EXPECT_MSG_NE (node.GetRouteInterface (MakeHaTestAddress (0x200, 0, 0), 64), -1, "MNP not routed");
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNBATemplates (), 1, "BA of the refused binding kept");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The BAs of the accepted bindings only are kept, until their binding is removed.
+ */
+class HaBaTemplateTestCase : public TestCase
+{
+public:
+  HaBaTemplateTestCase ();
+  virtual void DoRun (void);
+};
+
+HaBaTemplateTestCase::HaBaTemplateTestCase ()
+  : TestCase ("HA keeps the BAs of the accepted bindings")
+{
+}
+
+void
+HaBaTemplateTestCase::DoRun (void)
+{
+  HaTestNode node;
+  node.m_ha->HomeAgentAddressList ();
+
+  //a prefix of the home link is rejected
+  Ipv6Address rejected = MakeHaTestAddress (1, 0, 0x100);
+  Ipv6Address hoa = MakeHaTestAddress (1, 0, 0x200);
+  Ipv6Address coa = MakeHaTestAddress (0xa, 0, 0x200);
+  std::vector<Ipv6Address> mnps (1, MakeHaTestAddress (0x200, 0, 0));
+  Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveBu, &node, rejected, MakeHaTestAddress (0xa, 0, 0x100), 1,
+                       std::vector<Ipv6Address> (1, MakeHaTestAddress (1, 0, 0)));
+  Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveBu, &node, hoa, coa, 1, mnps);
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNBATemplates (), 1, "rejected BA kept");
+
+  //the BA is dropped with its binding, on a deregistration or at the end of its lifetime
+  Simulator::Schedule (Seconds (4), &HaTestNode::ReceiveBu, &node, hoa, hoa, 2, mnps);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNBATemplates (), 0, "BA kept after the deregistration");
+
+  Simulator::Schedule (Seconds (6), &HaTestNode::ReceiveBu, &node, hoa, coa, 3, mnps);
+  Simulator::Stop (Seconds (8));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNBATemplates (), 1, "accepted BA not kept");
+  Simulator::Stop (Seconds (60));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (bool (node.GetBCache ()->Lookup (hoa)), false, "binding not expired");
+  NS_TEST_EXPECT_MSG_EQ (node.m_ha->GetNBATemplates (), 0, "BA kept after the lifetime");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The MNPs of all the MRs and of their refreshes are advertised by one Radvd.
+ */
+class HaPrefixAdvertisementTestCase : public TestCase
+{
+public:
+  HaPrefixAdvertisementTestCase ();
+  virtual void DoRun (void);
+};
+
+HaPrefixAdvertisementTestCase::HaPrefixAdvertisementTestCase ()
+  : TestCase ("HA advertises the MNPs with one Radvd per interface")
+{
+}
+
+void
+HaPrefixAdvertisementTestCase::DoRun (void)
+{
+  HaTestNode node;
+  uint32_t applications = node.m_node->GetNApplications ();
+
+  for (uint16_t i = 0; i < 10; i++)
+    {
+      Ipv6Address hoa = MakeHaTestAddress (1, 0, 0x100 + i);
+      Ipv6Address coa = MakeHaTestAddress (0xa, 0, 0x100 + i);
+      std::vector<Ipv6Address> mnps (1, MakeHaTestAddress (0x100 + i, 0, 0));
+      Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveBu, &node, hoa, coa, 1, mnps);
+      Simulator::Schedule (Seconds (3), &HaTestNode::ReceiveBu, &node, hoa, coa, 2, mnps);
+      Simulator::Schedule (Seconds (5), &HaTestNode::ReceiveBu, &node, hoa, hoa, 3, mnps);
+    }
+  Simulator::Stop (Seconds (6));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (node.GetBCache ()->GetSize (), 0, "binding kept");
+  NS_TEST_EXPECT_MSG_EQ (node.m_node->GetNApplications (), applications + 1, "one Radvd expected");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The CoAs of a multihomed MR registered together share its flows.
+ */
+class HaMultiHomingTestCase : public TestCase
+{
+public:
+  HaMultiHomingTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief check the paths of the HoA and of the MNP.
+   * \param node the HA
+   * \param paths the expected number of paths
+   */
+  void CheckPaths (HaTestNode *node, uint32_t paths);
+  /**
+   * \brief check the CoAs of the binding once the NR link is lost.
+   * \param node the HA
+   */
+  void CheckCareOfAddresses (HaTestNode *node);
+};
+
+HaMultiHomingTestCase::HaMultiHomingTestCase ()
+  : TestCase ("HA spreads the flows of a multihomed MR over its CoAs")
+{
+}
+
+void
+HaMultiHomingTestCase::CheckPaths (HaTestNode *node, uint32_t paths)
+{
+  Ptr<Ipv6TunnelL4Protocol> th = node->m_node->GetObject<Ipv6TunnelL4Protocol> ();
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (MakeHaTestAddress (0xa, 0, 0x100));
+  NS_TEST_ASSERT_MSG_EQ (bool (tunnel), true, "no tunnel to the CoA of the binding");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNPaths (MakeHaTestAddress (1, 0, 0x100)), paths, "wrong number of paths to the HoA");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNPaths (MakeHaTestAddress (0x100, 0, 5)), paths, "wrong number of paths to the MNP");
+}
+
+void
+HaMultiHomingTestCase::CheckCareOfAddresses (HaTestNode *node)
+{
+  BCache::Entry *bce = node->GetBCache ()->Lookup (MakeHaTestAddress (1, 0, 0x100));
+  NS_TEST_ASSERT_MSG_EQ (bool (bce), true, "MR not bound");
+  NS_TEST_ASSERT_MSG_EQ (bce->GetCareOfAddresses ().size (), 2, "CoAs not registered");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetCareOfAddresses ()[1].first, MakeHaTestAddress (0xb, 0, 0x100), "wrong second CoA");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetCareOfAddresses ()[1].second, 0, "wrong weight of the second CoA");
+  Ptr<Ipv6TunnelL4Protocol> th = node->m_node->GetObject<Ipv6TunnelL4Protocol> ();
+  NS_TEST_EXPECT_MSG_EQ (bool (th->GetTunnelDevice (MakeHaTestAddress (0xb, 0, 0x100))), false, "tunnel to a CoA without traffic");
+}
+
+void
+HaMultiHomingTestCase::DoRun (void)
+{
+  HaTestNode node;
+
+  Ipv6Address hoa = MakeHaTestAddress (1, 0, 0x100);
+  Ipv6Address lte = MakeHaTestAddress (0xa, 0, 0x100);
+  Ipv6Address nr = MakeHaTestAddress (0xb, 0, 0x100);
+  std::vector<Ipv6Address> mnps (1, MakeHaTestAddress (0x100, 0, 0));
+  std::vector<std::pair<Ipv6Address, uint8_t> > coas;
+  coas.push_back (std::make_pair (lte, 30));
+  coas.push_back (std::make_pair (nr, 70));
+  Simulator::Schedule (Seconds (1), &HaTestNode::ReceiveMultiHomedBu, &node, hoa, lte, 1, mnps, coas);
+  Simulator::Schedule (Seconds (2.5), &HaMultiHomingTestCase::CheckPaths, this, &node, 2);
+
+  //the NR link is lost, it is registered without traffic
+  coas[1].second = 0;
+  Simulator::Schedule (Seconds (3), &HaTestNode::ReceiveMultiHomedBu, &node, hoa, lte, 2, mnps, coas);
+  Simulator::Schedule (Seconds (3.5), &HaMultiHomingTestCase::CheckPaths, this, &node, 1);
+  Simulator::Schedule (Seconds (3.6), &HaMultiHomingTestCase::CheckCareOfAddresses, this, &node);
+
+  //the deregistration releases all the tunnels
+  Simulator::Schedule (Seconds (4), &HaTestNode::ReceiveBu, &node, hoa, hoa, 3, mnps);
+  Simulator::Stop (Seconds (6));
+  Simulator::Run ();
+
+  Ptr<Ipv6TunnelL4Protocol> th = node.m_node->GetObject<Ipv6TunnelL4Protocol> ();
+  NS_TEST_EXPECT_MSG_EQ (node.GetBCache ()->GetSize (), 0, "binding kept");
+  NS_TEST_EXPECT_MSG_EQ (bool (th->GetTunnelDevice (lte)), false, "tunnel kept");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief HA TestSuite
+ */
+class HaTestSuite : public TestSuite
+{
+public:
+  HaTestSuite ()
+    : TestSuite ("segment-routing-ha", UNIT)
+  {
+    AddTestCase (new HaBatchTestCase (), TestCase::QUICK);
+    AddTestCase (new HaWithdrawTestCase (), TestCase::QUICK);
+    AddTestCase (new HaDadFailureTestCase (), TestCase::QUICK);
+    AddTestCase (new HaBaTemplateTestCase (), TestCase::QUICK);
+    AddTestCase (new HaPrefixAdvertisementTestCase (), TestCase::QUICK);
+    AddTestCase (new HaMultiHomingTestCase (), TestCase::QUICK);
+  }
+};
+
+static HaTestSuite g_haTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,471 @@
+#include "ns3/boolean.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/node.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/bcache.h"
+#include "ns3/clist.h"
+#include "ns3/ha.h"
+#include "ns3/sr-header.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-l4-protocol.h"
+#include "ns3/sr-mn.h"
+#include "ns3/sr-tun-l4-protocol.h"
+#include "ns3/tunnel-net-device.h"
+
+#include <algorithm>
+#include <list>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief MN whose attachments are driven by the test.
+ */
+class HandoverTestMn : public Mipv6Mn
+{
+public:
+  /**
+   * \brief constructor.
+   * \param config the MN configuration
+   */
+  HandoverTestMn (Ptr<const Mipv6MnConfig> config)
+    : Mipv6Mn (config)
+  {
+  }
+
+  /**
+   * \brief attach with a CoA, as done when the CoA is configured.
+   * \param coa the CoA
+   */
+  void Attach (Ipv6Address coa)
+  {
+    HandleNewAttachment (coa);
+  }
+
+  /**
+   * \brief register a CoA on the link of another AR, as a multihomed MN.
+   * \param ar the candidate entry of the AR
+   * \param coa the CoA
+   */
+  void AddCoa (Ptr<CList> ar, Ipv6Address coa)
+  {
+    AddCareOfAddress (ar, coa);
+  }
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Handover of an MN between two ARs, prepared or not.
+ *
+ * The HA and the MN share a link, on which the prefixes of the two ARs are
+ * on-link. The test moves the CoA of the MN from the first AR prefix to the
+ * second one, as router discovery and address configuration would.
+ */
+class HandoverTestCase : public TestCase
+{
+public:
+  /**
+   * \brief constructor.
+   * \param predictive whether the MN prepares its handovers
+   * \param steered whether the first AR congests instead of weakening
+   */
+  HandoverTestCase (bool predictive, bool steered = false);
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record a handover.
+   * \param interruption the interruption time
+   * \param predictive whether the handover was prepared
+   * \param oldCoa the CoA before the handover
+   * \param newCoa the CoA after the handover
+   */
+  void HandoverTrace (Time interruption, bool predictive, Ipv6Address oldCoa, Ipv6Address newCoa);
+
+  /**
+   * \brief Configure a CoA on the MN and attach with it.
+   * \param oldCoa the CoA to remove, any if none
+   * \param coa the CoA
+   */
+  void Move (Ipv6Address oldCoa, Ipv6Address coa);
+
+  /**
+   * \brief Check the state of the HA after the pre-registration.
+   */
+  void CheckPreRegistration ();
+
+  bool m_predictive;          //!< whether the MN prepares its handovers
+  bool m_steered;             //!< whether the first AR congests instead of weakening
+  Ptr<Node> m_haNode;         //!< the HA
+  Ptr<HandoverTestMn> m_mn;   //!< the MN
+  Ipv6Address m_haAddress;    //!< address of the HA
+  Ipv6Address m_linkLocalHa;  //!< link-local address of the HA
+  Ipv6Address m_hoa;          //!< home address of the MN
+  Ipv6Address m_coa2;         //!< CoA of the MN on the second AR
+  uint32_t m_handovers;       //!< handovers reported
+  Time m_interruption;        //!< interruption of the last handover
+  bool m_prepared;            //!< whether the last handover was prepared
+  Ipv6Address m_oldCoa;       //!< CoA before the last handover
+  Ipv6Address m_newCoa;       //!< CoA after the last handover
+  bool m_preRegistered;       //!< whether the HA pre-registered the second CoA
+  bool m_bicast;              //!< whether the HA sent the HoA traffic to the second CoA
+};
+
+HandoverTestCase::HandoverTestCase (bool predictive, bool steered)
+  : TestCase (steered ? "Predictive handover off a congested AR" : predictive ? "Predictive handover" : "Reactive handover"),
+    m_predictive (predictive),
+    m_steered (steered),
+    m_handovers (0),
+    m_prepared (false),
+    m_preRegistered (false),
+    m_bicast (false)
+{
+}
+
+void
+HandoverTestCase::HandoverTrace (Time interruption, bool predictive, Ipv6Address oldCoa, Ipv6Address newCoa)
+{
+  m_handovers++;
+  m_interruption = interruption;
+  m_prepared = predictive;
+  m_oldCoa = oldCoa;
+  m_newCoa = newCoa;
+}
+
+void
+HandoverTestCase::Move (Ipv6Address oldCoa, Ipv6Address coa)
+{
+  Ptr<Ipv6> ipv6 = m_mn->GetNode ()->GetObject<Ipv6> ();
+  if (!oldCoa.IsAny ())
+    {
+      ipv6->RemoveAddress (1, oldCoa);
+    }
+  ipv6->AddAddress (1, Ipv6InterfaceAddress (coa, Ipv6Prefix (64)));
+
+  //default route learnt from the new AR, the HA stands for it on the shared link
+  Ipv6StaticRoutingHelper routingHelper;
+  Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
+  routing->AddNetworkRouteTo (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), m_linkLocalHa, 1, coa.CombinePrefix (Ipv6Prefix (64)), 0);
+  m_mn->SetDefaultRouterAddress (m_linkLocalHa, 1);
+
+  m_mn->Attach (coa);
+}
+
+void
+HandoverTestCase::CheckPreRegistration ()
+{
+  PointerValue bcache;
+  m_haNode->GetObject<Mipv6Ha> ()->GetAttribute ("BCache", bcache);
+  BCache::Entry *bce = bcache.Get<BCache> ()->Lookup (m_hoa);
+  m_preRegistered = bce && bce->GetAlternateCoa () == m_coa2;
+
+  Ptr<TunnelNetDevice> tunnel = m_haNode->GetObject<Ipv6TunnelL4Protocol> ()->GetTunnelDevice (m_coa2);
+  m_bicast = tunnel && tunnel->LookupBicast (m_hoa) == m_coa2;
+}
+
+void
+HandoverTestCase::DoRun (void)
+{
+  m_haNode = CreateObject<Node> ();
+  Ptr<Node> mnNode = CreateObject<Node> ();
+  NodeContainer nodes (m_haNode, mnNode);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (5)));
+  NetDeviceContainer net = helperChannel.Install (nodes);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  m_haNode->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+  mnNode->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  //the HA stands for both ARs, their prefixes are on the shared link
+  Ipv6Address ar1 ("2001:1::1");
+  Ipv6Address ar2 ("2001:2::1");
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:db8::"), Ipv6Prefix (64));
+  ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+  ipv6helper.SetBase (ar1.CombinePrefix (Ipv6Prefix (64)), Ipv6Prefix (64));
+  ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+  ipv6helper.SetBase (ar2.CombinePrefix (Ipv6Prefix (64)), Ipv6Prefix (64));
+  ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+  ipv6helper.AssignWithoutAddress (NetDeviceContainer (net.Get (1)));
+
+  Ptr<Ipv6> haIpv6 = m_haNode->GetObject<Ipv6> ();
+  m_haAddress = haIpv6->GetAddress (1, 1).GetAddress ();
+  m_linkLocalHa = haIpv6->GetAddress (1, 0).GetAddress ();
+
+  Mipv6HaHelper haHelper;
+  haHelper.Install (m_haNode);
+
+  std::list<Ipv6Address> haalist (1, m_haAddress);
+  std::list<Ipv6Address> aralist;
+  aralist.push_back (ar1);
+  aralist.push_back (ar2);
+
+  Ptr<Mipv6L4Protocol> mipv6 = CreateObject<Mipv6L4Protocol> ();
+  mnNode->AggregateObject (mipv6);
+  mipv6->RegisterMobility ();
+  mipv6->RegisterMobilityOptions ();
+  mnNode->AggregateObject (CreateObject<Ipv6TunnelL4Protocol> ());
+  m_mn = CreateObject<HandoverTestMn> (Create<Mipv6MnConfig> (haalist, aralist, false, Ipv6Address::GetAny ()));
+  m_mn->SetAttribute ("PredictiveHandover", BooleanValue (m_predictive));
+  mnNode->AggregateObject (m_mn);
+  m_mn->TraceConnectWithoutContext ("Handover", MakeCallback (&HandoverTestCase::HandoverTrace, this));
+
+  NS_TEST_ASSERT_MSG_EQ (m_mn->GetNCandidates (), 2, "wrong number of candidate ARs");
+  Ptr<CList> serving = m_mn->GetCandidate (ar1);
+  Ptr<CList> next = m_mn->GetCandidate (ar2);
+  NS_TEST_ASSERT_MSG_EQ (bool (serving && next), true, "candidate AR not found");
+
+  m_hoa = m_mn->GetHomeAddress ();
+  uint8_t iid[16], buf[16];
+  m_hoa.GetBytes (iid);
+  ar1.GetBytes (buf);
+  std::copy (iid + 8, iid + 16, buf + 8);
+  Ipv6Address coa1 (buf);
+  ar2.GetBytes (buf);
+  std::copy (iid + 8, iid + 16, buf + 8);
+  m_coa2 = Ipv6Address (buf);
+
+  //registration on the first AR, the HA answers after the DAD of the HoA
+  Simulator::Schedule (Seconds (1), &HandoverTestCase::Move, this, Ipv6Address::GetAny (), coa1);
+  //the first AR weakens or congests, then the MN loses its link and attaches to the second AR
+  if (m_steered)
+    {
+      Simulator::Schedule (Seconds (3), (void (CList::*) (uint8_t, bool)) &CList::SetLoad, serving, 90, true);
+    }
+  else
+    {
+      Simulator::Schedule (Seconds (3), &CList::MarkSignalSrengthWeak, serving);
+    }
+  Simulator::Schedule (Seconds (3.5), &HandoverTestCase::CheckPreRegistration, this);
+  Simulator::Schedule (Seconds (4), &CList::MarkSignalSrengthPoor, serving);
+  Simulator::Schedule (Seconds (4.05), &HandoverTestCase::Move, this, coa1, m_coa2);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_handovers, 1, "handover not reported");
+  NS_TEST_EXPECT_MSG_EQ (m_prepared, m_predictive, "wrong handover mode");
+  NS_TEST_EXPECT_MSG_EQ (m_oldCoa, coa1, "wrong old CoA");
+  NS_TEST_EXPECT_MSG_EQ (m_newCoa, m_coa2, "wrong new CoA");
+  NS_TEST_EXPECT_MSG_EQ (m_preRegistered, m_predictive, "wrong pre-registration at the HA");
+  NS_TEST_EXPECT_MSG_EQ (m_bicast, m_predictive, "wrong bicast at the HA");
+  if (m_predictive)
+    {
+      //the path is back as soon as the MN attaches
+      NS_TEST_EXPECT_MSG_EQ (m_interruption, MilliSeconds (50), "wrong interruption time");
+    }
+  else
+    {
+      //the MN waits for the BA
+      NS_TEST_EXPECT_MSG_GT (m_interruption, MilliSeconds (50), "wrong interruption time");
+    }
+
+  //after the switch, the binding holds the new CoA only
+  PointerValue bcache;
+  m_haNode->GetObject<Mipv6Ha> ()->GetAttribute ("BCache", bcache);
+  BCache::Entry *bce = bcache.Get<BCache> ()->Lookup (m_hoa);
+  NS_TEST_ASSERT_MSG_EQ (bool (bce), true, "binding lost");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetCoa (), m_coa2, "binding not moved");
+  NS_TEST_EXPECT_MSG_EQ (bce->GetAlternateCoa (), Ipv6Address::GetAny (), "pre-registration not cleared");
+  Ptr<Ipv6TunnelL4Protocol> th = m_haNode->GetObject<Ipv6TunnelL4Protocol> ();
+  NS_TEST_EXPECT_MSG_EQ (bool (th->GetTunnelDevice (coa1)), false, "tunnel to the old CoA not removed");
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (m_coa2);
+  NS_TEST_ASSERT_MSG_EQ (bool (tunnel), true, "no tunnel to the new CoA");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetRemoteRefCount (m_coa2), 1, "pre-registration reference not released");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (m_hoa), m_coa2, "HoA not sent to the new CoA");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupBicast (m_hoa), Ipv6Address::GetAny (), "bicast not stopped");
+
+  m_mn = 0;
+  m_haNode = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Handover of a multihomed MN from two CoAs to one.
+ *
+ * The MN registers a second CoA on the link of the second AR, then loses
+ * the first AR and moves the binding to the second CoA. The home BUs after
+ * the handover register the CoA of the binding only.
+ */
+class HandoverMultiHomingTestCase : public TestCase
+{
+public:
+  HandoverMultiHomingTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the Binding Identifier options of a home BU.
+   * \param packet the message sent by the MN
+   */
+  void TxTrace (Ptr<const Packet> packet);
+
+  /**
+   * \brief Configure a CoA on the MN and attach with it.
+   * \param oldCoa the CoA to remove, any if none
+   * \param coa the CoA
+   */
+  void Move (Ipv6Address oldCoa, Ipv6Address coa);
+
+  Ptr<HandoverTestMn> m_mn;   //!< the MN
+  Ipv6Address m_linkLocalHa;  //!< link-local address of the HA
+  std::vector<uint32_t> m_bids; //!< Binding Identifier options of each home BU
+};
+
+HandoverMultiHomingTestCase::HandoverMultiHomingTestCase ()
+  : TestCase ("Handover of a multihomed MN from two CoAs to one")
+{
+}
+
+void
+HandoverMultiHomingTestCase::TxTrace (Ptr<const Packet> packet)
+{
+  Mipv6MessageView view;
+  if (!view.Parse (packet) || view.GetMhType () != Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE)
+    {
+      return;
+    }
+  uint32_t bids = 0;
+  Mipv6OptionIterator it = view.GetOptions ();
+  while (it.Next ())
+    {
+      bids += it.GetType () == Mipv6Header::IPV6_MOBILITY_OPT_BINDING_IDENTIFIER;
+    }
+  m_bids.push_back (bids);
+}
+
+void
+HandoverMultiHomingTestCase::Move (Ipv6Address oldCoa, Ipv6Address coa)
+{
+  Ptr<Ipv6> ipv6 = m_mn->GetNode ()->GetObject<Ipv6> ();
+  if (!oldCoa.IsAny ())
+    {
+      ipv6->RemoveAddress (1, oldCoa);
+    }
+  ipv6->AddAddress (1, Ipv6InterfaceAddress (coa, Ipv6Prefix (64)));
+
+  Ipv6StaticRoutingHelper routingHelper;
+  Ptr<Ipv6StaticRouting> routing = routingHelper.GetStaticRouting (ipv6);
+  routing->AddNetworkRouteTo (Ipv6Address::GetAny (), Ipv6Prefix::GetZero (), m_linkLocalHa, 1, coa.CombinePrefix (Ipv6Prefix (64)), 0);
+  m_mn->SetDefaultRouterAddress (m_linkLocalHa, 1);
+
+  m_mn->Attach (coa);
+}
+
+void
+HandoverMultiHomingTestCase::DoRun (void)
+{
+  Ptr<Node> haNode = CreateObject<Node> ();
+  Ptr<Node> mnNode = CreateObject<Node> ();
+  NodeContainer nodes (haNode, mnNode);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (5)));
+  NetDeviceContainer net = helperChannel.Install (nodes);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  haNode->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+  mnNode->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  //the HA stands for both ARs, their prefixes are on the shared link
+  Ipv6Address ar1 ("2001:1::1");
+  Ipv6Address ar2 ("2001:2::1");
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:db8::"), Ipv6Prefix (64));
+  ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+  ipv6helper.SetBase (ar1.CombinePrefix (Ipv6Prefix (64)), Ipv6Prefix (64));
+  ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+  ipv6helper.SetBase (ar2.CombinePrefix (Ipv6Prefix (64)), Ipv6Prefix (64));
+  ipv6helper.Assign (NetDeviceContainer (net.Get (0)));
+  ipv6helper.AssignWithoutAddress (NetDeviceContainer (net.Get (1)));
+
+  Ptr<Ipv6> haIpv6 = haNode->GetObject<Ipv6> ();
+  Ipv6Address haAddress = haIpv6->GetAddress (1, 1).GetAddress ();
+  m_linkLocalHa = haIpv6->GetAddress (1, 0).GetAddress ();
+
+  Mipv6HaHelper haHelper;
+  haHelper.Install (haNode);
+
+  std::list<Ipv6Address> haalist (1, haAddress);
+  std::list<Ipv6Address> aralist;
+  aralist.push_back (ar1);
+  aralist.push_back (ar2);
+
+  Ptr<Mipv6L4Protocol> mipv6 = CreateObject<Mipv6L4Protocol> ();
+  mnNode->AggregateObject (mipv6);
+  mipv6->RegisterMobility ();
+  mipv6->RegisterMobilityOptions ();
+  mnNode->AggregateObject (CreateObject<Ipv6TunnelL4Protocol> ());
+  m_mn = CreateObject<HandoverTestMn> (Create<Mipv6MnConfig> (haalist, aralist, false, Ipv6Address::GetAny ()));
+  m_mn->SetAttribute ("MultiHoming", BooleanValue (true));
+  mnNode->AggregateObject (m_mn);
+  m_mn->TraceConnectWithoutContext ("AgentTx", MakeCallback (&HandoverMultiHomingTestCase::TxTrace, this));
+
+  Ptr<CList> serving = m_mn->GetCandidate (ar1);
+  Ptr<CList> next = m_mn->GetCandidate (ar2);
+  NS_TEST_ASSERT_MSG_EQ (bool (serving && next), true, "candidate AR not found");
+
+  Ipv6Address hoa = m_mn->GetHomeAddress ();
+  uint8_t iid[16], buf[16];
+  hoa.GetBytes (iid);
+  ar1.GetBytes (buf);
+  std::copy (iid + 8, iid + 16, buf + 8);
+  Ipv6Address coa1 (buf);
+  ar2.GetBytes (buf);
+  std::copy (iid + 8, iid + 16, buf + 8);
+  Ipv6Address coa2 (buf);
+
+  //registration on the first AR, then of a second CoA on the second AR
+  Simulator::Schedule (Seconds (1), &HandoverMultiHomingTestCase::Move, this, Ipv6Address::GetAny (), coa1);
+  Simulator::Schedule (Seconds (3), &HandoverTestMn::AddCoa, m_mn, next, coa2);
+  //the first AR is lost, the binding moves to the second CoA
+  Simulator::Schedule (Seconds (4), &CList::MarkSignalSrengthPoor, serving);
+  Simulator::Schedule (Seconds (4.05), &HandoverMultiHomingTestCase::Move, this, coa1, coa2);
+  Simulator::Stop (Seconds (6));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_GT (m_bids.size (), 2, "home BUs not sent");
+  NS_TEST_EXPECT_MSG_EQ (*std::max_element (m_bids.begin (), m_bids.end ()), 2, "second CoA not registered");
+  NS_TEST_EXPECT_MSG_EQ (m_bids.back (), 0, "BU registers the CoA left by the MN");
+
+  m_mn = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Handover TestSuite
+ */
+class HandoverTestSuite : public TestSuite
+{
+public:
+  HandoverTestSuite ()
+    : TestSuite ("segment-routing-handover", UNIT)
+  {
+    AddTestCase (new HandoverTestCase (false), TestCase::QUICK);
+    AddTestCase (new HandoverTestCase (true), TestCase::QUICK);
+    AddTestCase (new HandoverTestCase (true, true), TestCase::QUICK);
+    AddTestCase (new HandoverMultiHomingTestCase (), TestCase::QUICK);
+  }
+};
+
+static HandoverTestSuite g_handoverTestSuite; //!< Static variable for test initialization
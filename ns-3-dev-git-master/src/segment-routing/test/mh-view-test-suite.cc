@@ -0,0 +1,583 @@
+#include "ns3/test.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/ipv6-option-header.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/sr-agent.h"
+#include "ns3/sr-demux.h"
+#include "ns3/sr-header.h"
+#include "ns3/sr-l4-protocol.h"
+#include "ns3/sr-mobility.h"
+#include "ns3/sr-option-header.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Mipv6MessageView fields and options of BU and BA.
+ */
+class Mipv6MessageViewTestCase : public TestCase
+{
+public:
+  Mipv6MessageViewTestCase ();
+  virtual void DoRun (void);
+};
+
+Mipv6MessageViewTestCase::Mipv6MessageViewTestCase ()
+  : TestCase ("Mipv6MessageView BU and BA parsing")
+{
+}
+
+void
+Mipv6MessageViewTestCase::DoRun (void)
+{
+  Ipv6MobilityOptionMobileNetworkPrefixHeader mnp;
+  mnp.SetPrefixLength (64);
+  mnp.SetMobileNetworkPrefix (Ipv6Address ("2002:0:0:1::"));
+
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (1234);
+  bu.SetFlagA (true);
+  bu.SetFlagH (true);
+  bu.SetFlagR (true);
+  bu.SetLifetime (60);
+  bu.AddOption (mnp);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (bu);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize () % 8, 0, "BU not padded to 8 octets");
+
+  /* the typed header gets its options back */
+  Ipv6MobilityBindingUpdateHeader bu2;
+  packet->PeekHeader (bu2);
+  Buffer options = bu2.GetOptionBuffer ();
+  Ipv6MobilityOptionMobileNetworkPrefixHeader mnp2;
+  NS_TEST_ASSERT_MSG_EQ ((options.GetSize () >= mnp.GetSerializedSize ()), true, "BU options not serialized");
+  mnp2.Deserialize (options.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (mnp2.GetMobileNetworkPrefix (), Ipv6Address ("2002:0:0:1::"), "BU option lost");
+
+  Mipv6MessageView view;
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "BU not parsed");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)view.GetMhType (), (uint32_t)Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE, "wrong MH type");
+  NS_TEST_EXPECT_MSG_EQ (view.GetSize (), packet->GetSize (), "wrong MH size");
+  NS_TEST_EXPECT_MSG_EQ (view.GetSequence (), 1234, "wrong sequence");
+  NS_TEST_EXPECT_MSG_EQ (view.GetLifetime (), 60, "wrong lifetime");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagA (), true, "wrong A flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagH (), true, "wrong H flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagL (), false, "wrong L flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagK (), false, "wrong K flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagR (), true, "wrong R flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetOptionsOffset (), 12, "wrong options offset");
+  NS_TEST_EXPECT_MSG_EQ (view.GetNOptions (), 1, "padding indexed as an option");
+
+  Ipv6MobilityOptionMobileNetworkPrefixHeader mnp3;
+  NS_TEST_ASSERT_MSG_EQ (view.GetOption (Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX, mnp3), true, "MNP option not found");
+  NS_TEST_EXPECT_MSG_EQ (mnp3.GetMobileNetworkPrefix (), Ipv6Address ("2002:0:0:1::"), "wrong MNP");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)mnp3.GetPrefixLength (), 64, "wrong MNP length");
+  NS_TEST_EXPECT_MSG_EQ (view.FindOption (Mipv6Header::IPV6_MOBILITY_OPT_NONCE_INDICES), view.GetNOptions (), "unexpected option");
+
+  Ipv6MobilityBindingAckHeader ba;
+  ba.SetStatus (Mipv6Header::BA_STATUS_INVALID_PREFIX);
+  ba.SetSequence (1234);
+  ba.SetFlagK (true);
+  ba.SetLifetime (30);
+  packet = Create<Packet> ();
+  packet->AddHeader (ba);
+
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "BA not parsed");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)view.GetMhType (), (uint32_t)Mipv6Header::IPV6_MOBILITY_BINDING_ACKNOWLEDGEMENT, "wrong MH type");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)view.GetStatus (), (uint32_t)Mipv6Header::BA_STATUS_INVALID_PREFIX, "wrong status");
+  NS_TEST_EXPECT_MSG_EQ (view.GetSequence (), 1234, "wrong sequence");
+  NS_TEST_EXPECT_MSG_EQ (view.GetLifetime (), 30, "wrong lifetime");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagK (), true, "wrong K flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetFlagR (), false, "wrong R flag");
+  NS_TEST_EXPECT_MSG_EQ (view.GetNOptions (), 0, "unexpected options");
+
+  /* header_len past the end of the packet */
+  uint8_t truncated[8] = { 59, 3, Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE };
+  NS_TEST_EXPECT_MSG_EQ (view.Parse (Create<Packet> (truncated, 8)), false, "truncated BU parsed");
+
+  /* option length past the end of the header */
+  uint8_t overflow[16] = { 59, 1, Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE };
+  overflow[12] = Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX;
+  overflow[13] = 18;
+  NS_TEST_EXPECT_MSG_EQ (view.Parse (Create<Packet> (overflow, 16)), false, "overflowing option parsed");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Mipv6MessageView return routability fields and home address.
+ */
+class Mipv6MessageViewHomeAddressTestCase : public TestCase
+{
+public:
+  Mipv6MessageViewHomeAddressTestCase ();
+  virtual void DoRun (void);
+};
+
+Mipv6MessageViewHomeAddressTestCase::Mipv6MessageViewHomeAddressTestCase ()
+  : TestCase ("Mipv6MessageView return routability and home address")
+{
+}
+
+void
+Mipv6MessageViewHomeAddressTestCase::DoRun (void)
+{
+  Ipv6Address hoa ("2001:db8::100");
+  Mipv6MessageView view;
+
+  /* a BU carries the HoA in a destination option */
+  Ipv6HomeAddressOptionHeader homeOption;
+  homeOption.SetHomeAddress (hoa);
+  Ipv6ExtensionDestinationHeader destination;
+  destination.AddOption (homeOption);
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (7);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (destination);
+  packet->AddHeader (bu);
+  Ipv6Address read;
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "BU not parsed");
+  NS_TEST_EXPECT_MSG_EQ (view.GetHomeAddress (read), true, "BU home address not found");
+  NS_TEST_EXPECT_MSG_EQ (read, hoa, "wrong BU home address");
+  NS_TEST_EXPECT_MSG_EQ (view.GetSequence (), 7, "home address option read as the BU");
+
+  /* a HoTI carries it the same way, with its cookie */
+  Ipv6HoTIHeader hoti;
+  hoti.SetHomeInitCookie (0x0123456789abcdefULL);
+  packet = Create<Packet> ();
+  packet->AddHeader (destination);
+  packet->AddHeader (hoti);
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "HoTI not parsed");
+  NS_TEST_EXPECT_MSG_EQ (view.GetInitCookie (), 0x0123456789abcdefULL, "wrong HoTI cookie");
+  NS_TEST_EXPECT_MSG_EQ (view.GetHomeAddress (read), true, "HoTI home address not found");
+  NS_TEST_EXPECT_MSG_EQ (read, hoa, "wrong HoTI home address");
+
+  /* a HoT or a CoT carries it in a type 2 routing header, Ipv6HoTHeader keeps 16 bits of the cookie and token */
+  Ipv6ExtensionType2RoutingHeader type2;
+  type2.SetHomeAddress (hoa);
+  Ipv6HoTHeader hot;
+  hot.SetHomeNonceIndex (513);
+  hot.SetHomeInitCookie (0xcdef);
+  hot.SetHomeKeygenToken (0x3210);
+  packet = Create<Packet> ();
+  packet->AddHeader (type2);
+  packet->AddHeader (hot);
+  read = Ipv6Address::GetAny ();
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "HoT not parsed");
+  NS_TEST_EXPECT_MSG_EQ (view.GetNonceIndex (), 513, "wrong HoT nonce index");
+  NS_TEST_EXPECT_MSG_EQ (view.GetInitCookie (), 0xcdef, "wrong HoT cookie");
+  NS_TEST_EXPECT_MSG_EQ (view.GetKeygenToken (), 0x3210, "wrong HoT keygen token");
+  NS_TEST_EXPECT_MSG_EQ (view.GetHomeAddress (read), true, "HoT home address not found");
+  NS_TEST_EXPECT_MSG_EQ (read, hoa, "wrong HoT home address");
+
+  Ipv6CoTHeader cot;
+  cot.SetCareOfNonceIndex (3);
+  cot.SetCareOfKeygenToken (42);
+  packet = Create<Packet> ();
+  packet->AddHeader (type2);
+  packet->AddHeader (cot);
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "CoT not parsed");
+  NS_TEST_EXPECT_MSG_EQ (view.GetNonceIndex (), 3, "wrong CoT nonce index");
+  NS_TEST_EXPECT_MSG_EQ (view.GetKeygenToken (), 42, "wrong CoT keygen token");
+
+  /* a BA without its routing header has no home address */
+  packet = Create<Packet> ();
+  packet->AddHeader (Ipv6MobilityBindingAckHeader ());
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "BA not parsed");
+  NS_TEST_EXPECT_MSG_EQ (view.GetHomeAddress (read), false, "home address read past the BA");
+  NS_TEST_EXPECT_MSG_EQ (view.GetNonceIndex (), 0, "nonce index read from a BA");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Mipv6OptionField inline and heap storage, padding and option walk.
+ */
+class Mipv6OptionFieldTestCase : public TestCase
+{
+public:
+  Mipv6OptionFieldTestCase ();
+  virtual void DoRun (void);
+};
+
+Mipv6OptionFieldTestCase::Mipv6OptionFieldTestCase ()
+  : TestCase ("Mipv6OptionField storage and padding")
+{
+}
+
+void
+Mipv6OptionFieldTestCase::DoRun (void)
+{
+  /* the nonce indices and the authorization data are aligned in place */
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (7);
+  Ipv6MobilityOptionNonceIndicesHeader indices;
+  indices.SetHomeNonceIndex (3);
+  indices.SetCareOfNonceIndex (4);
+  bu.AddOption (indices);
+  Ipv6MobilityOptionBindingAuthorizationDataHeader authorization;
+  authorization.SetAuthenticator (0x0123456789abcdefULL);
+  bu.AddOption (authorization);
+  NS_TEST_EXPECT_MSG_EQ (bu.GetSerializedSize () % 8, 0, "BU not padded to 8 octets");
+  NS_TEST_EXPECT_MSG_EQ ((12 + bu.GetOptionLength () - 10) % 8, 2, "authorization data not aligned to 8n+2");
+
+  /* enough prefixes to leave the inline storage */
+  const uint32_t nPrefixes = 10;
+  for (uint32_t i = 0; i < nPrefixes; i++)
+    {
+      Ipv6MobilityOptionMobileNetworkPrefixHeader mnp;
+      mnp.SetPrefixLength (48 + i);
+      uint8_t prefix[16] = { 0x20, 0x02, 0, uint8_t (i) };
+      mnp.SetMobileNetworkPrefix (Ipv6Address (prefix));
+      bu.AddOption (mnp);
+    }
+  NS_TEST_ASSERT_MSG_GT (bu.GetOptionLength (), Mipv6OptionField::INLINE_SIZE, "options still inline");
+
+  Ipv6MobilityBindingUpdateHeader copy = bu;
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (copy);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), bu.GetSerializedSize (), "cached size does not match the bytes written");
+
+  Mipv6MessageView view;
+  NS_TEST_ASSERT_MSG_EQ (view.Parse (packet), true, "BU not parsed");
+  NS_TEST_EXPECT_MSG_EQ (view.GetNOptions (), nPrefixes + 2, "padding indexed as an option");
+
+  Ipv6MobilityBindingUpdateHeader received;
+  packet->PeekHeader (received);
+  NS_TEST_EXPECT_MSG_EQ (received.GetSerializedSize (), packet->GetSize (), "wrong size of a received BU");
+
+  Ipv6MobilityOptionMobileNetworkPrefixHeader mnp;
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < nPrefixes; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (received.GetNextOption (Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX, mnp, offset), true, "prefix lost");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) mnp.GetPrefixLength (), 48 + i, "prefixes out of order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (received.GetNextOption (Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX, mnp, offset), false, "extra prefix");
+
+  Ipv6MobilityOptionBindingAuthorizationDataHeader authorization2;
+  offset = 0;
+  NS_TEST_ASSERT_MSG_EQ (received.GetNextOption (Mipv6Header::IPV6_MOBILITY_OPT_BINDING_AUTHORIZATION_DATA, authorization2, offset), true, "authorization data lost");
+  NS_TEST_EXPECT_MSG_EQ (authorization2.GetAuthenticator (), 0x0123456789abcdefULL, "wrong authenticator");
+
+  /* the field and the view walk the same options, the padding skipped */
+  Mipv6OptionIterator fieldOptions = received.GetOptions ();
+  Mipv6OptionIterator viewOptions = view.GetOptions ();
+  uint32_t n = 0;
+  while (fieldOptions.Next ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (viewOptions.Next (), true, "option missing from the view");
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) viewOptions.GetType (), (uint32_t) fieldOptions.GetType (), "options out of order");
+      NS_TEST_EXPECT_MSG_EQ (view.GetOptionOffset (n), view.GetOptionsOffset () + viewOptions.GetOffset (), "option not indexed");
+      n++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (viewOptions.Next (), false, "extra option in the view");
+  NS_TEST_EXPECT_MSG_EQ (n, nPrefixes + 2, "padding walked as an option");
+  NS_TEST_EXPECT_MSG_EQ (fieldOptions.IsMalformed (), false, "options malformed");
+
+  /* an option overflowing the field ends the walk */
+  uint8_t overflow[16] = { 59, 1, Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE };
+  overflow[12] = Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX;
+  overflow[13] = 18;
+  Create<Packet> (overflow, 16)->PeekHeader (received);
+  offset = 0;
+  NS_TEST_EXPECT_MSG_EQ (received.GetNextOption (Mipv6Header::IPV6_MOBILITY_OPT_MOBILE_NETWORK_PREFIX, mnp, offset), false, "overflowing option read");
+  Mipv6OptionIterator overflowing = received.GetOptions ();
+  NS_TEST_EXPECT_MSG_EQ (overflowing.Next (), false, "overflowing option walked");
+  NS_TEST_EXPECT_MSG_EQ (overflowing.IsMalformed (), true, "overflowing option not reported");
+  NS_TEST_EXPECT_MSG_EQ (view.Parse (Create<Packet> (overflow, 16)), false, "overflowing option parsed");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Mipv6MessageTemplate gives the bytes of a BU or a BA built from scratch.
+ */
+class Mipv6MessageTemplateTestCase : public TestCase
+{
+public:
+  Mipv6MessageTemplateTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Build a home BU of a mobile router, as Mipv6Mn::BuildHomeBU.
+   * \param sequence the sequence
+   * \param lifetime the lifetime
+   * \return the packet
+   */
+  static Ptr<Packet> BuildBU (uint16_t sequence, uint16_t lifetime);
+
+  /**
+   * \brief Build a BA, as Mipv6Ha::BuildBA.
+   * \param sequence the sequence
+   * \param lifetime the lifetime
+   * \return the packet
+   */
+  static Ptr<Packet> BuildBA (uint16_t sequence, uint16_t lifetime);
+
+  /**
+   * \brief Get the bytes of a packet.
+   * \param packet the packet
+   * \return the bytes
+   */
+  static std::vector<uint8_t> GetBytes (Ptr<const Packet> packet);
+};
+
+Mipv6MessageTemplateTestCase::Mipv6MessageTemplateTestCase ()
+  : TestCase ("Mipv6MessageTemplate BU and BA refresh")
+{
+}
+
+Ptr<Packet>
+Mipv6MessageTemplateTestCase::BuildBU (uint16_t sequence, uint16_t lifetime)
+{
+  Ptr<Packet> p = Create<Packet> ();
+
+  Ipv6ExtensionDestinationHeader destextnhdr;
+  Ipv6HomeAddressOptionHeader homeopt;
+  homeopt.SetHomeAddress (Ipv6Address ("2001:db8::200:ff:fe00:5"));
+  destextnhdr.AddOption (homeopt);
+  destextnhdr.SetNextHeader (59);
+  p->AddHeader (destextnhdr);
+
+  Ipv6MobilityOptionMobileNetworkPrefixHeader mnph;
+  mnph.SetMobileNetworkPrefix (Ipv6Address ("2002:0:0:1::"));
+
+  Ipv6MobilityBindingUpdateHeader bu;
+  bu.SetSequence (sequence);
+  bu.SetFlagA (true);
+  bu.SetFlagH (true);
+  bu.SetFlagL (true);
+  bu.SetFlagK (true);
+  bu.SetFlagR (true);
+  bu.SetLifetime (lifetime);
+  bu.AddOption (mnph);
+  bu.SetPayloadProto (6);
+  p->AddHeader (bu);
+  return p;
+}
+
+Ptr<Packet>
+Mipv6MessageTemplateTestCase::BuildBA (uint16_t sequence, uint16_t lifetime)
+{
+  Ptr<Packet> p = Create<Packet> ();
+
+  Ipv6ExtensionType2RoutingHeader type2extn;
+  type2extn.SetReserved (0);
+  type2extn.SetHomeAddress (Ipv6Address ("2001:db8::200:ff:fe00:5"));
+
+  Ipv6MobilityBindingAckHeader ba;
+  ba.SetSequence (sequence);
+  ba.SetFlagK (true);
+  ba.SetFlagR (true);
+  ba.SetStatus (Mipv6Header::BA_STATUS_BINDING_UPDATE_ACCEPTED);
+  ba.SetLifetime (lifetime);
+  p->AddHeader (type2extn);
+  p->AddHeader (ba);
+  return p;
+}
+
+std::vector<uint8_t>
+Mipv6MessageTemplateTestCase::GetBytes (Ptr<const Packet> packet)
+{
+  std::vector<uint8_t> bytes (packet->GetSize ());
+  packet->CopyData (&bytes[0], bytes.size ());
+  return bytes;
+}
+
+void
+Mipv6MessageTemplateTestCase::DoRun (void)
+{
+  Mipv6MessageTemplate tmpl;
+  NS_TEST_EXPECT_MSG_EQ (tmpl.IsSet (), false, "empty template set");
+
+  NS_TEST_ASSERT_MSG_EQ (tmpl.Set (BuildBU (1, 60)), true, "BU template not set");
+  for (uint16_t sequence = 2; sequence < 5; sequence++)
+    {
+      Ptr<Packet> refresh = tmpl.Build (sequence, 1000 + sequence);
+      NS_TEST_EXPECT_MSG_EQ ((GetBytes (refresh) == GetBytes (BuildBU (sequence, 1000 + sequence))), true, "BU " << sequence << " differs");
+
+      Mipv6MessageView view;
+      NS_TEST_ASSERT_MSG_EQ (view.Parse (refresh), true, "refreshed BU not parsed");
+      NS_TEST_EXPECT_MSG_EQ (view.GetSequence (), sequence, "wrong sequence");
+      NS_TEST_EXPECT_MSG_EQ (view.GetLifetime (), 1000 + sequence, "wrong lifetime");
+      NS_TEST_EXPECT_MSG_EQ (view.GetFlagR (), true, "wrong R flag");
+      NS_TEST_EXPECT_MSG_EQ (view.GetNOptions (), 1, "MNP option lost");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (tmpl.Set (BuildBA (1, 60)), true, "BA template not set");
+  Ptr<Packet> refresh = tmpl.Build (0xabcd, 0x1234);
+  NS_TEST_EXPECT_MSG_EQ ((GetBytes (refresh) == GetBytes (BuildBA (0xabcd, 0x1234))), true, "BA differs");
+  Ipv6MobilityBindingAckHeader ba;
+  refresh->RemoveHeader (ba);
+  NS_TEST_EXPECT_MSG_EQ (ba.GetSequence (), 0xabcd, "wrong BA sequence");
+  NS_TEST_EXPECT_MSG_EQ (ba.GetLifetime (), 0x1234, "wrong BA lifetime");
+  Ipv6ExtensionType2RoutingHeader type2extn;
+  refresh->RemoveHeader (type2extn);
+  NS_TEST_EXPECT_MSG_EQ (type2extn.GetHomeAddress (), Ipv6Address ("2001:db8::200:ff:fe00:5"), "wrong home address");
+
+  Ipv6HoTIHeader hoti;
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (hoti);
+  NS_TEST_EXPECT_MSG_EQ (tmpl.Set (p), false, "HoTI template set");
+  NS_TEST_EXPECT_MSG_EQ (tmpl.IsSet (), false, "template kept after a failed set");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Agent counting the messages of each MH type.
+ */
+class MhViewTestAgent : public Mipv6Agent
+{
+public:
+  /**
+   * \brief Get the type identifier.
+   * \return type identifier
+   */
+  static TypeId GetTypeId (void);
+
+  MhViewTestAgent ();
+
+  uint32_t m_bu;   //!< BU received
+  uint32_t m_ba;   //!< BA received
+  uint32_t m_hoti; //!< HoTI received
+
+protected:
+  virtual uint8_t HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleBA (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+  virtual uint8_t HandleHoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface);
+};
+
+NS_OBJECT_ENSURE_REGISTERED (MhViewTestAgent);
+
+TypeId
+MhViewTestAgent::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MhViewTestAgent")
+    .SetParent<Mipv6Agent> ()
+    .AddConstructor<MhViewTestAgent> ()
+  ;
+  return tid;
+}
+
+MhViewTestAgent::MhViewTestAgent ()
+  : m_bu (0),
+    m_ba (0),
+    m_hoti (0)
+{
+}
+
+uint8_t
+MhViewTestAgent::HandleBU (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+{
+  m_bu++;
+  return 0;
+}
+
+uint8_t
+MhViewTestAgent::HandleBA (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+{
+  m_ba++;
+  return 0;
+}
+
+uint8_t
+MhViewTestAgent::HandleHoTI (Ptr<Packet> packet, const Mipv6MessageView &view, const Ipv6Address &src, const Ipv6Address &dst, Ptr<Ipv6Interface> interface)
+{
+  m_hoti++;
+  return 0;
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Mipv6L4Protocol dispatch through the MH type table.
+ */
+class MhDispatchTestCase : public TestCase
+{
+public:
+  MhDispatchTestCase ();
+  virtual void DoRun (void);
+};
+
+MhDispatchTestCase::MhDispatchTestCase ()
+  : TestCase ("Mipv6L4Protocol dispatch by MH type")
+{
+}
+
+void
+MhDispatchTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<Mipv6L4Protocol> l4 = CreateObject<Mipv6L4Protocol> ();
+  node->AggregateObject (l4);
+  l4->SetNode (node);
+  l4->RegisterMobility ();
+  Ptr<MhViewTestAgent> agent = CreateObject<MhViewTestAgent> ();
+  agent->SetNode (node);
+  node->AggregateObject (agent);
+
+  Ptr<Mipv6Demux> demux = node->GetObject<Mipv6Demux> ();
+  Ptr<Mipv6Mobility> buMobility = demux->GetMobility (Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE);
+  NS_TEST_ASSERT_MSG_EQ (bool (buMobility), true, "BU mobility not registered");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)buMobility->GetMobilityNumber (), (uint32_t)Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE, "wrong mobility");
+  NS_TEST_EXPECT_MSG_EQ (bool (demux->GetMobility (200)), false, "unregistered mobility found");
+  NS_TEST_EXPECT_MSG_EQ (bool (demux->GetMobility (-1)), false, "negative mobility number found");
+
+  Ipv6Address mn ("2001:db8::100");
+  Ipv6Address ha ("2001:db8::1");
+
+  Ptr<Packet> buPacket = Create<Packet> ();
+  buPacket->AddHeader (Ipv6MobilityBindingUpdateHeader ());
+  Ptr<Packet> baPacket = Create<Packet> ();
+  baPacket->AddHeader (Ipv6MobilityBindingAckHeader ());
+  Ptr<Packet> hotiPacket = Create<Packet> ();
+  hotiPacket->AddHeader (Ipv6HoTIHeader ());
+  uint32_t buSize = buPacket->GetSize ();
+
+  l4->Receive (buPacket, mn, ha, 0);
+  l4->Receive (buPacket, mn, ha, 0);
+  l4->Receive (baPacket, ha, mn, 0);
+  l4->Receive (hotiPacket, mn, ha, 0);
+  NS_TEST_EXPECT_MSG_EQ (agent->m_bu, 2, "BU not dispatched");
+  NS_TEST_EXPECT_MSG_EQ (agent->m_ba, 1, "BA not dispatched");
+  NS_TEST_EXPECT_MSG_EQ (agent->m_hoti, 1, "HoTI not dispatched");
+  NS_TEST_EXPECT_MSG_EQ (buPacket->GetSize (), buSize, "received packet modified");
+
+  /* a mobility removed from the demux no longer receives */
+  demux->Remove (buMobility);
+  NS_TEST_EXPECT_MSG_EQ (bool (demux->GetMobility (Mipv6Header::IPV6_MOBILITY_BINDING_UPDATE)), false, "removed mobility found");
+  l4->Receive (buPacket, mn, ha, 0);
+  NS_TEST_EXPECT_MSG_EQ (agent->m_bu, 2, "BU dispatched to a removed mobility");
+
+  Simulator::Destroy ();
+  node->Dispose ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Mobility header view TestSuite
+ */
+class MhViewTestSuite : public TestSuite
+{
+public:
+  MhViewTestSuite ()
+    : TestSuite ("segment-routing-mh-view", UNIT)
+  {
+    AddTestCase (new Mipv6MessageViewTestCase, TestCase::QUICK);
+    AddTestCase (new Mipv6MessageViewHomeAddressTestCase, TestCase::QUICK);
+    AddTestCase (new Mipv6OptionFieldTestCase, TestCase::QUICK);
+    AddTestCase (new Mipv6MessageTemplateTestCase, TestCase::QUICK);
+    AddTestCase (new MhDispatchTestCase, TestCase::QUICK);
+  }
+};
+
+static MhViewTestSuite g_mhViewTestSuite; //!< Static variable for test initialization
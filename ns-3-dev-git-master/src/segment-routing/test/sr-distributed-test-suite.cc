@@ -0,0 +1,66 @@
+#include "ns3/example-as-test.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Run sr-distributed on some ranks and check its output.
+ *
+ * The reference output is the same for all the numbers of ranks: the BUs,
+ * BAs and tunnelled packets crossing the ranks give the results of a
+ * sequential run.
+ */
+class SrDistributedTestCase : public ExampleAsTestCase
+{
+public:
+  /**
+   * \brief constructor.
+   * \param name the test name, and the name of the reference output
+   * \param ranks the number of ranks
+   * \param args the arguments of sr-distributed
+   */
+  SrDistributedTestCase (const std::string &name, int ranks, const std::string &args = "")
+    : ExampleAsTestCase (name, "sr-distributed", NS_TEST_SOURCEDIR, args),
+      m_ranks (ranks)
+  {
+  }
+
+  virtual std::string GetCommandTemplate (void) const
+  {
+    std::stringstream ss;
+    ss << "mpiexec -n " << m_ranks << " %s --test " << m_args;
+    return ss.str ();
+  }
+
+  virtual std::string GetPostProcessingCommand (void) const
+  {
+    //the ranks print their nodes in any order
+    return "| grep TEST | sort ";
+  }
+
+private:
+  int m_ranks; //!< number of ranks
+};
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Distributed execution TestSuite
+ */
+class SrDistributedTestSuite : public TestSuite
+{
+public:
+  SrDistributedTestSuite ()
+    : TestSuite ("segment-routing-distributed", EXAMPLE)
+  {
+    AddTestCase (new SrDistributedTestCase ("segment-routing-distributed-1", 1), TestCase::QUICK);
+    AddTestCase (new SrDistributedTestCase ("segment-routing-distributed-2", 2), TestCase::QUICK);
+    AddTestCase (new SrDistributedTestCase ("segment-routing-distributed-3", 3), TestCase::QUICK);
+    AddTestCase (new SrDistributedTestCase ("segment-routing-distributed-2-nullmsg", 2, "--nullmsg"), TestCase::QUICK);
+  }
+};
+
+static SrDistributedTestSuite g_srDistributedTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,200 @@
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/node.h"
+#include "ns3/object-factory.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/bcache.h"
+#include "ns3/blist.h"
+#include "ns3/ha.h"
+#include "ns3/sr-helper.h"
+#include "ns3/sr-mn.h"
+
+#include <list>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Helpers installing on a NodeContainer share one MN configuration.
+ */
+class HelperBulkInstallTestCase : public TestCase
+{
+public:
+  HelperBulkInstallTestCase ();
+  virtual void DoRun (void);
+};
+
+HelperBulkInstallTestCase::HelperBulkInstallTestCase ()
+  : TestCase ("Bulk install with a shared MN configuration")
+{
+}
+
+void
+HelperBulkInstallTestCase::DoRun (void)
+{
+  const uint32_t nMn = 50;
+
+  NodeContainer has;
+  has.Create (2);
+  NodeContainer mns;
+  mns.Create (nMn);
+  NodeContainer all (has, mns);
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (all);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (all);
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:db8::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net);
+
+  Mipv6HaHelper haHelper;
+  haHelper.SetHAAs (true);
+  haHelper.SetBindingCacheSize (nMn);
+  haHelper.Install (has);
+
+  std::list<Ipv6Address> haalist;
+  haalist.push_back (Ipv6Address ("2001:db8::200:ff:fe00:1"));
+  haalist.push_back (Ipv6Address ("2001:db8::200:ff:fe00:2"));
+  std::list<Ipv6Address> aralist;
+  aralist.push_back (Ipv6Address ("2001:db8:1::1"));
+
+  Mipv6MnHelper mnHelper (haalist, false, aralist);
+  mnHelper.SetMNAs (true);
+  mnHelper.SetMobileNetPref (Ipv6Address ("2002:0:0:1::"));
+  mnHelper.Install (mns);
+
+  Ptr<const Mipv6MnConfig> config = mns.Get (0)->GetObject<Mipv6Mn> ()->GetConfig ();
+  NS_TEST_ASSERT_MSG_EQ (bool (config), true, "no configuration");
+  NS_TEST_EXPECT_MSG_EQ (config->GetHomeAgentList ().size (), 2, "wrong home agent list");
+  NS_TEST_EXPECT_MSG_EQ (config->GetAccessRouterList ().size (), 1, "wrong AR list");
+  NS_TEST_EXPECT_MSG_EQ (config->IsMobileRouter (), true, "wrong NEMO flag");
+  NS_TEST_EXPECT_MSG_EQ (config->GetMobileNetworkPrefix (), Ipv6Address ("2002:0:0:1::"), "wrong prefix");
+  NS_TEST_EXPECT_MSG_EQ (config->IsHomeAgent (haalist.back ()), true, "home agent not found");
+  NS_TEST_EXPECT_MSG_EQ (config->IsHomeAgent (aralist.front ()), false, "AR taken for a home agent");
+
+  for (uint32_t i = 0; i < nMn; i++)
+    {
+      Ptr<Mipv6Mn> mn = mns.Get (i)->GetObject<Mipv6Mn> ();
+      NS_TEST_ASSERT_MSG_EQ (bool (mn), true, "MN " << i << " not installed");
+      NS_TEST_EXPECT_MSG_EQ (PeekPointer (mn->GetConfig ()), PeekPointer (config), "MN " << i << " copies the configuration");
+      NS_TEST_EXPECT_MSG_EQ (mn->IsHomeMatch (haalist.front ()), true, "MN " << i << " home agent not found");
+
+      PointerValue blist;
+      mn->GetAttribute ("BList", blist);
+      Ptr<BList> bl = blist.Get<BList> ();
+      NS_TEST_EXPECT_MSG_EQ (PeekPointer (bl->GetConfig ()), PeekPointer (config), "BList " << i << " copies the configuration");
+      NS_TEST_EXPECT_MSG_EQ (bl->GetHA (), haalist.front (), "BList " << i << " wrong home agent");
+    }
+
+  /* copy on write: one binding list changing its home agents does not affect the others */
+  PointerValue blist;
+  mns.Get (0)->GetObject<Mipv6Mn> ()->GetAttribute ("BList", blist);
+  blist.Get<BList> ()->SetHomeAgentList (std::list<Ipv6Address> (1, haalist.back ()));
+  NS_TEST_EXPECT_MSG_EQ (blist.Get<BList> ()->GetHomeAgentList ().size (), 1, "home agent list not changed");
+  NS_TEST_EXPECT_MSG_EQ (config->GetHomeAgentList ().size (), 2, "shared configuration modified");
+
+  /* each single-node install builds its own configuration */
+  Ptr<Node> single = CreateObject<Node> ();
+  NetDeviceContainer singleNet = helperChannel.Install (single);
+  internetv6.Install (single);
+  ipv6helper.Assign (singleNet);
+  mnHelper.Install (single);
+  NS_TEST_EXPECT_MSG_NE (PeekPointer (single->GetObject<Mipv6Mn> ()->GetConfig ()), PeekPointer (config), "single install shares the configuration");
+
+  for (uint32_t i = 0; i < has.GetN (); i++)
+    {
+      Ptr<Mipv6Ha> ha = has.Get (i)->GetObject<Mipv6Ha> ();
+      NS_TEST_ASSERT_MSG_EQ (bool (ha), true, "HA " << i << " not installed");
+      PointerValue bcache;
+      ha->GetAttribute ("BCache", bcache);
+      NS_TEST_EXPECT_MSG_EQ (bcache.Get<BCache> ()->GetSize (), 0, "HA " << i << " binding cache not empty");
+    }
+
+  Simulator::Destroy ();
+}
+
+#ifdef NS3_MTP
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Helpers installing on the nodes of another partition of the multithreaded simulator.
+ */
+class HelperMtpInstallTestCase : public TestCase
+{
+public:
+  HelperMtpInstallTestCase ();
+  virtual void DoRun (void);
+};
+
+HelperMtpInstallTestCase::HelperMtpInstallTestCase ()
+  : TestCase ("Install on partition 1 of the multithreaded simulator")
+{
+}
+
+void
+HelperMtpInstallTestCase::DoRun (void)
+{
+  Simulator::Destroy ();
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::MultithreadedSimulatorImpl");
+  factory.Set ("ThreadCount", UintegerValue (2));
+  Simulator::SetImplementation (factory.Create<SimulatorImpl> ());
+
+  /* the process has system id 0, the nodes run on partition 1 */
+  NodeContainer nodes;
+  nodes.Add (CreateObject<Node> (1));
+  nodes.Add (CreateObject<Node> (1));
+  NS_TEST_ASSERT_MSG_EQ (Simulator::GetSystemId (), 0, "wrong system id");
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (nodes);
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:db8::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net);
+
+  Mipv6HaHelper haHelper;
+  haHelper.Install (nodes.Get (0));
+  std::list<Ipv6Address> haalist;
+  haalist.push_back (Ipv6Address ("2001:db8::200:ff:fe00:1"));
+  Mipv6MnHelper mnHelper (haalist, false, std::list<Ipv6Address> ());
+  mnHelper.Install (nodes.Get (1));
+
+  NS_TEST_EXPECT_MSG_EQ (bool (nodes.Get (0)->GetObject<Mipv6Ha> ()), true, "HA of partition 1 not installed");
+  NS_TEST_EXPECT_MSG_EQ (bool (nodes.Get (1)->GetObject<Mipv6Mn> ()), true, "MN of partition 1 not installed");
+
+  Simulator::Destroy ();
+}
+#endif
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Helper TestSuite
+ */
+class HelperTestSuite : public TestSuite
+{
+public:
+  HelperTestSuite ()
+    : TestSuite ("segment-routing-helper", UNIT)
+  {
+    AddTestCase (new HelperBulkInstallTestCase, TestCase::QUICK);
+#ifdef NS3_MTP
+    AddTestCase (new HelperMtpInstallTestCase, TestCase::QUICK);
+#endif
+  }
+};
+
+static HelperTestSuite g_helperTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,277 @@
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/node.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/clist.h"
+#include "ns3/sr-network.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief CellGrid candidates against a sweep of all the cells.
+ */
+class CellGridCandidatesTestCase : public TestCase
+{
+public:
+  CellGridCandidatesTestCase ();
+  virtual void DoRun (void);
+};
+
+CellGridCandidatesTestCase::CellGridCandidatesTestCase ()
+  : TestCase ("CellGrid k best cells")
+{
+}
+
+void
+CellGridCandidatesTestCase::DoRun (void)
+{
+  const uint32_t nCells = 1000;
+  const uint32_t k = 4;
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  Ptr<CellGrid> grid = CreateObject<CellGrid> ();
+  std::vector<Ptr<LteConfig> > cells;
+  for (uint32_t i = 0; i < nCells; i++)
+    {
+      double x = rng->GetValue (-5000, 5000);
+      double y = rng->GetValue (-5000, 5000);
+      Ptr<LteConfig> cell;
+      switch (i % 3)
+        {
+        case 0:
+          cell = CreateObject<LteConfig> (x, y);
+          break;
+        case 1:
+          cell = CreateObject<NrMicro> (x, y);
+          break;
+        default:
+          cell = CreateObject<NrMacro> (x, y);
+          break;
+        }
+      cell->SetLoad (rng->GetInteger (0, 120));
+      grid->AddCell (cell);
+      cells.push_back (cell);
+    }
+  NS_TEST_ASSERT_MSG_EQ (grid->GetNCells (), nCells, "cells not added");
+
+  for (uint32_t q = 0; q < 200; q++)
+    {
+      Position pos;
+      /* some MNs outside the area of the cells */
+      pos.x = rng->GetValue (-6000, 6000);
+      pos.y = rng->GetValue (-6000, 6000);
+      bool skipCongested = q % 2;
+
+      std::vector<double> sweep;
+      for (uint32_t i = 0; i < nCells; i++)
+        {
+          if (!skipCongested || !cells[i]->IsCongested ())
+            {
+              sweep.push_back (-cells[i]->CalculateRSSI (pos));
+            }
+        }
+      std::sort (sweep.begin (), sweep.end (), std::greater<double> ());
+
+      std::vector<CellGrid::Candidate> candidates = grid->GetCandidates (pos, k, skipCongested);
+      NS_TEST_ASSERT_MSG_EQ (candidates.size (), k, "wrong number of candidates");
+      for (uint32_t i = 0; i < k; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ_TOL (candidates[i].rsrp, sweep[i], 1e-9, "query " << q << " candidate " << i);
+          NS_TEST_EXPECT_MSG_EQ (candidates[i].load, candidates[i].cell->GetLoad (), "wrong load");
+          NS_TEST_EXPECT_MSG_EQ (candidates[i].congested, candidates[i].cell->IsCongested (), "wrong congestion");
+          if (skipCongested)
+            {
+              NS_TEST_EXPECT_MSG_EQ (candidates[i].congested, false, "congested cell returned");
+            }
+        }
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (grid->RemoveCell (cells[0]), true, "cell not removed");
+  NS_TEST_EXPECT_MSG_EQ (grid->RemoveCell (cells[0]), false, "cell removed twice");
+  NS_TEST_EXPECT_MSG_EQ (grid->GetNCells (), nCells - 1, "wrong number of cells");
+  NS_TEST_EXPECT_MSG_NE (PeekPointer (grid->GetCandidates (cells[0]->GetPosition (), 1)[0].cell), PeekPointer (cells[0]), "removed cell returned");
+
+  grid->Dispose ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief CellGrid follows the CourseChange of the cells.
+ */
+class CellGridMobilityTestCase : public TestCase
+{
+public:
+  CellGridMobilityTestCase ();
+  virtual void DoRun (void);
+};
+
+CellGridMobilityTestCase::CellGridMobilityTestCase ()
+  : TestCase ("CellGrid cell moves")
+{
+}
+
+void
+CellGridMobilityTestCase::DoRun (void)
+{
+  Ptr<CellGrid> grid = CreateObject<CellGrid> ();
+
+  Ptr<LteConfig> fixed = CreateObject<LteConfig> (0, 0);
+  grid->AddCell (fixed);
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (Vector (10000, 10000, 0));
+  node->AggregateObject (mobility);
+  Ptr<NrMicro> moving = CreateObject<NrMicro> ();
+  moving->SetNode (node);
+  grid->AddCell (moving);
+  NS_TEST_EXPECT_MSG_EQ (moving->GetPosition ().x, 10000, "position not read from the mobility model");
+
+  Position mn;
+  mn.x = 5000;
+  mn.y = 5000;
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (grid->GetCandidates (mn, 1)[0].cell), PeekPointer (fixed), "wrong best cell");
+
+  mobility->SetPosition (Vector (5010, 5000, 0));
+  NS_TEST_EXPECT_MSG_EQ (moving->GetPosition ().x, 5010, "CourseChange not followed");
+  std::vector<CellGrid::Candidate> candidates = grid->GetCandidates (mn, 2);
+  NS_TEST_ASSERT_MSG_EQ (candidates.size (), 2, "wrong number of candidates");
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (candidates[0].cell), PeekPointer (moving), "moved cell not found");
+  NS_TEST_EXPECT_MSG_EQ_TOL (candidates[0].rsrp, -120 - 0.25 * 10, 1e-9, "wrong received power");
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (candidates[1].cell), PeekPointer (fixed), "wrong second cell");
+
+  moving->SetLoad (100);
+  NS_TEST_EXPECT_MSG_EQ (moving->IsCongested (), true, "cell not congested");
+  NS_TEST_EXPECT_MSG_EQ (PeekPointer (grid->GetCandidates (mn, 1, true)[0].cell), PeekPointer (fixed), "congested cell returned");
+
+  NS_TEST_EXPECT_MSG_EQ (grid->RemoveCell (moving), true, "cell not removed");
+  mobility->SetPosition (Vector (0, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (moving->GetPosition ().x, 5010, "removed cell still followed");
+
+  grid->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief NetworkMonitor scores the load of a cell, with hysteresis.
+ */
+class NetworkMonitorTestCase : public TestCase
+{
+public:
+  NetworkMonitorTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record a congestion change.
+   * \param ar the AR
+   * \param congested whether the cell of the AR is congested
+   */
+  void Congestion (Ipv6Address ar, bool congested);
+
+  /**
+   * \brief Check the state pushed to a candidate entry.
+   * \param candidate the candidate entry
+   * \param congested whether it should be congested
+   * \param load the load it should have
+   */
+  void CheckCandidate (Ptr<CList> candidate, bool congested, uint8_t load);
+
+  std::vector<Time> m_changes;   //!< times of the congestion changes
+  std::vector<bool> m_congested; //!< the congestion changes
+};
+
+NetworkMonitorTestCase::NetworkMonitorTestCase ()
+  : TestCase ("NetworkMonitor congestion score")
+{
+}
+
+void
+NetworkMonitorTestCase::Congestion (Ipv6Address ar, bool congested)
+{
+  m_changes.push_back (Simulator::Now ());
+  m_congested.push_back (congested);
+}
+
+void
+NetworkMonitorTestCase::CheckCandidate (Ptr<CList> candidate, bool congested, uint8_t load)
+{
+  NS_TEST_EXPECT_MSG_EQ (candidate->IsCongested (), congested, "wrong congestion at " << Simulator::Now ().As (Time::S));
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) candidate->GetLoad (), (uint32_t) load, "wrong load at " << Simulator::Now ().As (Time::S));
+}
+
+void
+NetworkMonitorTestCase::DoRun (void)
+{
+  Ipv6Address ar ("2001:1::1");
+  Ptr<NetworkMonitor> monitor = CreateObject<NetworkMonitor> ();
+  monitor->SetAttribute ("Alpha", DoubleValue (0.5));
+  monitor->TraceConnectWithoutContext ("Congestion", MakeCallback (&NetworkMonitorTestCase::Congestion, this));
+
+  //a connection draws 0.68% of the power of the cell
+  Ptr<LteConfig> cell = CreateObject<LteConfig> (0, 0);
+  monitor->AddCell (ar, cell);
+  NS_TEST_EXPECT_MSG_EQ (monitor->GetNCells (), 1, "cell not added");
+  Ptr<CList> candidate = CreateObject<CList> (ar);
+  NS_TEST_EXPECT_MSG_EQ (monitor->Subscribe (candidate), true, "candidate not subscribed");
+  NS_TEST_EXPECT_MSG_EQ (monitor->Subscribe (CreateObject<CList> (Ipv6Address ("2001:2::1"))), false, "unknown AR subscribed");
+
+  //a full cell is congested after four samples, 0.6375
+  Simulator::Schedule (MilliSeconds (50), &LteConfig::SetLoad, cell, 100);
+  Simulator::Schedule (MilliSeconds (350), &NetworkMonitorTestCase::CheckCandidate, this, candidate, false, 60);
+  Simulator::Schedule (MilliSeconds (450), &NetworkMonitorTestCase::CheckCandidate, this, candidate, true, 60);
+  //at 0.544, between the two thresholds, it stays congested
+  Simulator::Schedule (MilliSeconds (450), &LteConfig::SetLoad, cell, 80);
+  Simulator::Schedule (MilliSeconds (1050), &NetworkMonitorTestCase::CheckCandidate, this, candidate, true, 50);
+  //it clears at the first sample under 0.5
+  Simulator::Schedule (MilliSeconds (1050), &LteConfig::SetLoad, cell, 50);
+  Simulator::Schedule (MilliSeconds (1150), &NetworkMonitorTestCase::CheckCandidate, this, candidate, false, 40);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_changes.size (), 2, "wrong number of congestion changes");
+  NS_TEST_EXPECT_MSG_EQ (m_changes[0], MilliSeconds (400), "congestion not detected on time");
+  NS_TEST_EXPECT_MSG_EQ (m_congested[0], true, "wrong first change");
+  NS_TEST_EXPECT_MSG_EQ (m_changes[1], MilliSeconds (1100), "congestion not cleared on time");
+  NS_TEST_EXPECT_MSG_EQ (m_congested[1], false, "wrong second change");
+  NS_TEST_EXPECT_MSG_EQ_TOL (monitor->GetScore (ar), 0.34, 0.01, "score not converged");
+  NS_TEST_EXPECT_MSG_EQ (monitor->IsCongested (ar), false, "cell still congested");
+
+  //the spare capacity of the AR, halved by the congestion
+  candidate->SetLoad (60, true);
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) candidate->GetPathWeight (), 20, "wrong weight of a congested AR");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Access network TestSuite
+ */
+class SrNetworkTestSuite : public TestSuite
+{
+public:
+  SrNetworkTestSuite ()
+    : TestSuite ("segment-routing-network", UNIT)
+  {
+    AddTestCase (new CellGridCandidatesTestCase, TestCase::QUICK);
+    AddTestCase (new CellGridMobilityTestCase, TestCase::QUICK);
+    AddTestCase (new NetworkMonitorTestCase, TestCase::QUICK);
+  }
+};
+
+static SrNetworkTestSuite g_srNetworkTestSuite; //!< Static variable for test initialization
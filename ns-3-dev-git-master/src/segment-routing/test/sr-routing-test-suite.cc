@@ -0,0 +1,725 @@
+#include "ns3/boolean.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/ipv6-extension.h"
+#include "ns3/ipv6-extension-demux.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-l3-protocol.h"
+#include "ns3/ipv6-list-routing-helper.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/ipv6-routing-helper.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/test.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+#include "ns3/sr-routing.h"
+#include "ns3/prefix-trie.h"
+#include "ns3/random-variable-stream.h"
+
+#include <limits>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief SRv6 steering test: tx - headend - sid - rx.
+ *
+ * The head-end has no route towards the receiver network, so the packet
+ * can only get there through the SRH inserted by Ipv6SrRouting and the
+ * End behaviour of the SID node.
+ */
+class SrSteeringTestCase : public TestCase
+{
+public:
+  SrSteeringTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+
+  /**
+   * \brief Packet received by the IPv6 layer of the receiver.
+   * \param packet the packet
+   * \param ipv6 the IPv6 protocol
+   * \param interface the interface index
+   */
+  void RxTrace (Ptr<const Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface);
+
+  /**
+   * \brief Send data.
+   * \param socket The sending socket.
+   * \param to Destination address.
+   */
+  void SendData (Ptr<Socket> socket, Ipv6Address to);
+
+  /**
+   * \brief Add an address to the interface of a device.
+   * \param device the device
+   * \param addr the address
+   */
+  static void AddAddress (Ptr<NetDevice> device, Ipv6Address addr);
+
+  uint32_t m_receivedBytes; //!< Received bytes
+  uint8_t m_rxNextHeader;   //!< Next header seen by the receiver
+};
+
+SrSteeringTestCase::SrSteeringTestCase ()
+  : TestCase ("SRv6 End steering"),
+    m_receivedBytes (0),
+    m_rxNextHeader (0)
+{
+}
+
+void
+SrSteeringTestCase::ReceivePkt (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet = socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_receivedBytes += packet->GetSize ();
+}
+
+void
+SrSteeringTestCase::RxTrace (Ptr<const Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface)
+{
+  Ipv6Header header;
+  packet->PeekHeader (header);
+  m_rxNextHeader = header.GetNextHeader ();
+}
+
+void
+SrSteeringTestCase::SendData (Ptr<Socket> socket, Ipv6Address to)
+{
+  socket->SendTo (Create<Packet> (123), 0, Inet6SocketAddress (to, 1234));
+}
+
+void
+SrSteeringTestCase::AddAddress (Ptr<NetDevice> device, Ipv6Address addr)
+{
+  Ptr<Ipv6> ipv6 = device->GetNode ()->GetObject<Ipv6> ();
+  int32_t ifIndex = ipv6->GetInterfaceForDevice (device);
+  ipv6->AddAddress (ifIndex, Ipv6InterfaceAddress (addr, Ipv6Prefix (64)));
+}
+
+void
+SrSteeringTestCase::DoRun (void)
+{
+  Ptr<Node> txNode = CreateObject<Node> ();
+  Ptr<Node> headNode = CreateObject<Node> ();
+  Ptr<Node> sidNode = CreateObject<Node> ();
+  Ptr<Node> rxNode = CreateObject<Node> ();
+  NodeContainer nodes (txNode, headNode, sidNode, rxNode);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net3 = helperChannel.Install (NodeContainer (txNode, headNode));
+  NetDeviceContainer net2 = helperChannel.Install (NodeContainer (headNode, sidNode));
+  NetDeviceContainer net1 = helperChannel.Install (NodeContainer (sidNode, rxNode));
+
+  // the SR routing needs a list routing to sit in front of the static one
+  Ipv6ListRoutingHelper listRouting;
+  listRouting.Add (Ipv6StaticRoutingHelper (), 0);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.SetRoutingHelper (listRouting);
+  internetv6.Install (nodes);
+
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); it++)
+    {
+      (*it)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+    }
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.AssignWithoutAddress (net3);
+  ipv6helper.AssignWithoutAddress (net2);
+  ipv6helper.AssignWithoutAddress (net1);
+
+  AddAddress (net3.Get (0), Ipv6Address ("2001:3::2"));
+  AddAddress (net3.Get (1), Ipv6Address ("2001:3::1"));
+  AddAddress (net2.Get (0), Ipv6Address ("2001:2::1"));
+  AddAddress (net2.Get (1), Ipv6Address ("2001:2::2"));
+  AddAddress (net1.Get (0), Ipv6Address ("2001:1::1"));
+  AddAddress (net1.Get (1), Ipv6Address ("2001:1::2"));
+
+  headNode->GetObject<Ipv6> ()->SetAttribute ("IpForward", BooleanValue (true));
+  sidNode->GetObject<Ipv6> ()->SetAttribute ("IpForward", BooleanValue (true));
+
+  Ptr<Ipv6StaticRouting> txRouting = Ipv6RoutingHelper::GetRouting<Ipv6StaticRouting> (txNode->GetObject<Ipv6> ()->GetRoutingProtocol ());
+  txRouting->SetDefaultRoute (Ipv6Address ("2001:3::1"), 1);
+
+  Ptr<Ipv6SrRouting> sr = Ipv6SrRouting::GetSrRouting (headNode);
+  NS_TEST_ASSERT_MSG_EQ (bool (sr), true, "head-end has no Ipv6ListRouting");
+  NS_TEST_ASSERT_MSG_EQ (Ipv6SrRouting::GetSrRouting (headNode), sr, "SR routing installed twice");
+
+  rxNode->GetObject<Ipv6L3Protocol> ()->TraceConnectWithoutContext ("Rx", MakeCallback (&SrSteeringTestCase::RxTrace, this));
+
+  Ptr<Socket> rxSocket = rxNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  rxSocket->Bind (Inet6SocketAddress (Ipv6Address ("2001:1::2"), 1234));
+  rxSocket->SetRecvCallback (MakeCallback (&SrSteeringTestCase::ReceivePkt, this));
+
+  Ptr<Socket> txSocket = txNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+
+  // no policy: the head-end has no route to 2001:1::/64
+  Simulator::Schedule (Seconds (1), &SrSteeringTestCase::SendData, this, txSocket, Ipv6Address ("2001:1::2"));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 0, "packet delivered without a route");
+
+  // steer through the SID node
+  sr->AddPolicy (Ipv6Address ("2001:1::"), Ipv6Prefix (64), std::vector<Segment> (1, Segment ("2001:2::2")));
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNPolicies (), 1, "policy not added");
+  Simulator::Schedule (Seconds (2), &SrSteeringTestCase::SendData, this, txSocket, Ipv6Address ("2001:1::2"));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 123, "packet not steered through the SID");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) m_rxNextHeader, (uint32_t) Ipv6Header::IPV6_EXT_ROUTING, "SRH missing at the receiver");
+
+  // removing the policy restores plain routing
+  sr->RemovePolicy (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNPolicies (), 0, "policy not removed");
+  Simulator::Schedule (Seconds (3), &SrSteeringTestCase::SendData, this, txSocket, Ipv6Address ("2001:1::2"));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 123, "packet delivered after the policy removal");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief PrefixTrie against a linear longest prefix match.
+ */
+class PrefixTrieTestCase : public TestCase
+{
+public:
+  PrefixTrieTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief a prefix of the reference table
+   */
+  struct Prefix
+  {
+    Ipv6Address prefix; //!< the prefix
+    uint8_t length;     //!< the prefix length
+    uint32_t value;     //!< the value
+  };
+
+  /**
+   * \brief Linear longest prefix match.
+   * \param prefixes the reference table
+   * \param address the address
+   * \return the value of the longest match, 0 if none
+   */
+  static uint32_t Lookup (const std::vector<Prefix> &prefixes, Ipv6Address address);
+};
+
+PrefixTrieTestCase::PrefixTrieTestCase ()
+  : TestCase ("PrefixTrie longest prefix match")
+{
+}
+
+uint32_t
+PrefixTrieTestCase::Lookup (const std::vector<Prefix> &prefixes, Ipv6Address address)
+{
+  uint32_t value = 0;
+  int32_t best = -1;
+  for (uint32_t i = 0; i < prefixes.size (); i++)
+    {
+      Ipv6Prefix mask (prefixes[i].length);
+      if (mask.IsMatch (prefixes[i].prefix, address) && prefixes[i].length > best)
+        {
+          best = prefixes[i].length;
+          value = prefixes[i].value;
+        }
+    }
+  return value;
+}
+
+void
+PrefixTrieTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  /* few top bits so that the prefixes nest */
+  const uint8_t lengths[] = { 0, 3, 16, 48, 56, 64, 65, 100, 127, 128 };
+  std::vector<Prefix> prefixes;
+  PrefixTrie<uint32_t> trie;
+  for (uint32_t i = 1; i <= 500; i++)
+    {
+      uint8_t buf[16];
+      for (uint32_t j = 0; j < 16; j++)
+        {
+          buf[j] = j < 2 || j >= 14 ? rng->GetInteger (0, 3) : 0;
+        }
+      Prefix prefix;
+      prefix.length = lengths[rng->GetInteger (0, 9)];
+      prefix.prefix = Ipv6Address (buf).CombinePrefix (Ipv6Prefix (prefix.length));
+      prefix.value = i;
+
+      bool found = false;
+      for (uint32_t j = 0; j < prefixes.size (); j++)
+        {
+          if (prefixes[j].prefix == prefix.prefix && prefixes[j].length == prefix.length)
+            {
+              prefixes[j].value = i;
+              found = true;
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ (trie.Insert (Ipv6Address (buf), prefix.length, i), !found, "wrong insert status");
+      if (!found)
+        {
+          prefixes.push_back (prefix);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (trie.GetSize (), prefixes.size (), "wrong size");
+  NS_TEST_EXPECT_MSG_EQ (trie.GetEntries ().size (), prefixes.size (), "wrong number of entries");
+
+  for (uint32_t round = 0; round < 2; round++)
+    {
+      for (uint32_t i = 0; i < 2000; i++)
+        {
+          uint8_t buf[16];
+          for (uint32_t j = 0; j < 16; j++)
+            {
+              buf[j] = j < 2 || j >= 14 ? rng->GetInteger (0, 3) : 0;
+            }
+          Ipv6Address address (buf);
+          const uint32_t *value = trie.Lookup (address);
+          NS_TEST_ASSERT_MSG_EQ ((value ? *value : 0), Lookup (prefixes, address), "wrong match for " << address);
+        }
+
+      /* remove half of the prefixes, the lookups must still match */
+      for (uint32_t i = 0; i < prefixes.size (); i++)
+        {
+          if (i % 2 == round)
+            {
+              NS_TEST_EXPECT_MSG_EQ (trie.Remove (prefixes[i].prefix, prefixes[i].length), true, "prefix not removed");
+              NS_TEST_EXPECT_MSG_EQ (trie.Remove (prefixes[i].prefix, prefixes[i].length), false, "prefix removed twice");
+              NS_TEST_EXPECT_MSG_EQ ((trie.Find (prefixes[i].prefix, prefixes[i].length) == 0), true, "removed prefix found");
+              prefixes.erase (prefixes.begin () + i);
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ (trie.GetSize (), prefixes.size (), "wrong size after removal");
+    }
+
+  trie.Clear ();
+  NS_TEST_EXPECT_MSG_EQ ((trie.Lookup (Ipv6Address ("::1")) == 0), true, "match in an empty trie");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Routes and SID forwarding table of Ipv6SrRouting: tx - headend - mid - rx.
+ *
+ * The head-end has no static route towards the receiver network.
+ */
+class SrRoutingTableTestCase : public TestCase
+{
+public:
+  SrRoutingTableTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+
+  /**
+   * \brief Send data.
+   * \param socket The sending socket.
+   * \param to Destination address.
+   */
+  void SendData (Ptr<Socket> socket, Ipv6Address to);
+
+  uint32_t m_receivedBytes; //!< Received bytes
+};
+
+SrRoutingTableTestCase::SrRoutingTableTestCase ()
+  : TestCase ("SR routing routes and SID table"),
+    m_receivedBytes (0)
+{
+}
+
+void
+SrRoutingTableTestCase::ReceivePkt (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet = socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_receivedBytes += packet->GetSize ();
+}
+
+void
+SrRoutingTableTestCase::SendData (Ptr<Socket> socket, Ipv6Address to)
+{
+  socket->SendTo (Create<Packet> (123), 0, Inet6SocketAddress (to, 1234));
+}
+
+void
+SrRoutingTableTestCase::DoRun (void)
+{
+  Ptr<Node> txNode = CreateObject<Node> ();
+  Ptr<Node> headNode = CreateObject<Node> ();
+  Ptr<Node> midNode = CreateObject<Node> ();
+  Ptr<Node> rxNode = CreateObject<Node> ();
+  NodeContainer nodes (txNode, headNode, midNode, rxNode);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net3 = helperChannel.Install (NodeContainer (txNode, headNode));
+  NetDeviceContainer net2 = helperChannel.Install (NodeContainer (headNode, midNode));
+  NetDeviceContainer net1 = helperChannel.Install (NodeContainer (midNode, rxNode));
+
+  Ipv6ListRoutingHelper listRouting;
+  listRouting.Add (Ipv6StaticRoutingHelper (), 0);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.SetRoutingHelper (listRouting);
+  internetv6.Install (nodes);
+
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); it++)
+    {
+      (*it)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+    }
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:3::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net3);
+  ipv6helper.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net2);
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer rxInterfaces = ipv6helper.Assign (net1);
+
+  headNode->GetObject<Ipv6> ()->SetAttribute ("IpForward", BooleanValue (true));
+  midNode->GetObject<Ipv6> ()->SetAttribute ("IpForward", BooleanValue (true));
+
+  Ipv6Address headAddress = headNode->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  Ipv6Address midAddress = midNode->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  Ipv6Address rxAddress = rxInterfaces.GetAddress (1, 1);
+
+  Ptr<Ipv6StaticRouting> txRouting = Ipv6RoutingHelper::GetRouting<Ipv6StaticRouting> (txNode->GetObject<Ipv6> ()->GetRoutingProtocol ());
+  txRouting->SetDefaultRoute (headAddress, 1);
+
+  Ptr<Ipv6SrRouting> sr = Ipv6SrRouting::GetSrRouting (headNode);
+  NS_TEST_ASSERT_MSG_EQ (bool (sr), true, "head-end has no Ipv6ListRouting");
+  uint32_t headIf = headNode->GetObject<Ipv6> ()->GetInterfaceForDevice (net2.Get (0));
+
+  Ptr<Socket> rxSocket = rxNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  rxSocket->Bind (Inet6SocketAddress (rxAddress, 1234));
+  rxSocket->SetRecvCallback (MakeCallback (&SrRoutingTableTestCase::ReceivePkt, this));
+
+  Ptr<Socket> txSocket = txNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+
+  // the route of the SR routing table is used instead of the missing static one
+  sr->AddRoute (Ipv6Address ("2001:1::"), Ipv6Prefix (64), headIf, midAddress);
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNRoutes (), 1, "route not added");
+  Simulator::Schedule (Seconds (1), &SrRoutingTableTestCase::SendData, this, txSocket, rxAddress);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 123, "packet not forwarded by the SR routing table");
+
+  sr->RemoveRoute (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNRoutes (), 0, "route not removed");
+  Simulator::Schedule (Seconds (2), &SrRoutingTableTestCase::SendData, this, txSocket, rxAddress);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 123, "packet forwarded after the route removal");
+
+  // a SID of the forwarding table is reached through its adjacency
+  sr->AddSid (Segment (rxAddress), headIf, midAddress);
+  sr->AddSid (Segment (rxAddress));
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNSids (), 1, "SID not added");
+  Simulator::Schedule (Seconds (3), &SrRoutingTableTestCase::SendData, this, txSocket, rxAddress);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 246, "packet not forwarded to the SID");
+
+  sr->RemoveSid (Segment (rxAddress));
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNSids (), 1, "SID removed with a reference left");
+  sr->RemoveSid (Segment (rxAddress));
+  NS_TEST_EXPECT_MSG_EQ (sr->GetNSids (), 0, "SID not removed");
+  Simulator::Schedule (Seconds (4), &SrRoutingTableTestCase::SendData, this, txSocket, rxAddress);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 246, "packet forwarded after the SID removal");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Compressed SIDs and SID lists.
+ */
+class SegmentListTestCase : public TestCase
+{
+public:
+  SegmentListTestCase ();
+  virtual void DoRun (void);
+};
+
+SegmentListTestCase::SegmentListTestCase ()
+  : TestCase ("C-SID containers and SID lists")
+{
+}
+
+void
+SegmentListTestCase::DoRun (void)
+{
+  // uSID: 32 bits block, 16 bits C-SIDs
+  std::vector<uint32_t> csids;
+  csids.push_back (1);
+  csids.push_back (2);
+  csids.push_back (0xabcd);
+  Segment container = Segment::MakeContainer (Ipv6Address ("2001:db8::"), 32, csids, 16);
+  NS_TEST_EXPECT_MSG_EQ (container.GetAddress (), Ipv6Address ("2001:db8:1:2:abcd::"), "wrong container");
+  NS_TEST_EXPECT_MSG_EQ (Segment::GetCsidCapacity (32, 16), 6, "wrong uSID capacity");
+  NS_TEST_EXPECT_MSG_EQ (Segment::GetCsidCapacity (48, 32), 2, "wrong 32 bits C-SID capacity");
+  NS_TEST_EXPECT_MSG_EQ (container.GetNCsids (32, 16), 3, "wrong number of C-SIDs");
+  NS_TEST_EXPECT_MSG_EQ (container.GetCsid (32, 16, 2), 0xabcd, "wrong C-SID");
+  NS_TEST_EXPECT_MSG_EQ (container.GetActiveSid (32, 16), Segment ("2001:db8:1::"), "wrong active SID");
+
+  Segment shifted = container.ShiftCsids (32, 16);
+  NS_TEST_EXPECT_MSG_EQ (shifted, Segment ("2001:db8:2:abcd::"), "wrong shift");
+  shifted = shifted.ShiftCsids (32, 16).ShiftCsids (32, 16);
+  NS_TEST_EXPECT_MSG_EQ (shifted.GetNCsids (32, 16), 0, "C-SIDs left after the last shift");
+
+  // consecutive SIDs of the block share containers, the others are kept
+  std::vector<Segment> sids;
+  for (uint32_t i = 1; i <= 8; i++)
+    {
+      std::ostringstream sid;
+      sid << "2001:db8:" << i << "::";
+      sids.push_back (Segment (sid.str ().c_str ()));
+    }
+  sids.push_back (Segment ("2001:2::2"));
+  sids.push_back (Segment ("2001:db8:9::"));
+  SegmentList list (sids);
+  NS_TEST_EXPECT_MSG_EQ (list.GetN (), 10, "wrong number of SIDs");
+  NS_TEST_EXPECT_MSG_EQ ((list.GetVector () == sids), true, "SIDs lost moving past the inline storage");
+
+  SegmentList compressed = list.Compress (32, 16);
+  NS_TEST_ASSERT_MSG_EQ (compressed.GetN (), 4, "wrong number of containers");
+  NS_TEST_EXPECT_MSG_EQ (compressed.Get (0), Segment ("2001:db8:1:2:3:4:5:6"), "wrong first container");
+  NS_TEST_EXPECT_MSG_EQ (compressed.Get (1), Segment ("2001:db8:7:8::"), "wrong second container");
+  NS_TEST_EXPECT_MSG_EQ (compressed.Get (2), Segment ("2001:2::2"), "uncompressible SID changed");
+  NS_TEST_EXPECT_MSG_EQ (compressed.Get (3), Segment ("2001:db8:9::"), "single C-SID container changed");
+  NS_TEST_EXPECT_MSG_EQ (list.Compress (0, 16), list, "list compressed without a block");
+
+  NS_TEST_EXPECT_MSG_EQ ((list == SegmentList (sids)), true, "equal lists differ");
+  NS_TEST_EXPECT_MSG_EQ ((list < compressed), true, "wrong order");
+  NS_TEST_EXPECT_MSG_EQ (SegmentListHash () (list), SegmentListHash () (SegmentList (sids)), "equal lists hash differently");
+
+  // the textual form of the attributes
+  SegmentListValue value;
+  NS_TEST_ASSERT_MSG_EQ (value.DeserializeFromString ("2001:db8:1::,2001:2::2", MakeSegmentListChecker ()), true,
+                         "SID list not parsed");
+  NS_TEST_EXPECT_MSG_EQ (value.Get ().GetN (), 2, "wrong number of parsed SIDs");
+  NS_TEST_EXPECT_MSG_EQ (value.Get ().Get (1), Segment ("2001:2::2"), "wrong parsed SID");
+  NS_TEST_EXPECT_MSG_EQ (value.SerializeToString (MakeSegmentListChecker ()), "2001:db8:1::,2001:2::2",
+                         "wrong textual form");
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief NEXT-C-SID steering test: tx - headend - sid1 - sid2 - rx.
+ *
+ * The SIDs fcbb:bb00:1:: and fcbb:bb00:2:: are bound with AddLocalSid. Once
+ * compressed, they share one container and the SRH loses an entry.
+ */
+class CsidSteeringTestCase : public TestCase
+{
+public:
+  CsidSteeringTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Receive data.
+   * \param socket The receiving socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+
+  /**
+   * \brief Packet received by the IPv6 layer of the receiver.
+   * \param packet the packet
+   * \param ipv6 the IPv6 protocol
+   * \param interface the interface index
+   */
+  void RxTrace (Ptr<const Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface);
+
+  /**
+   * \brief Send data.
+   * \param socket The sending socket.
+   * \param to Destination address.
+   */
+  void SendData (Ptr<Socket> socket, Ipv6Address to);
+
+  uint32_t m_receivedBytes; //!< Received bytes
+  uint32_t m_rxSegments;    //!< SIDs of the SRH seen by the receiver
+};
+
+CsidSteeringTestCase::CsidSteeringTestCase ()
+  : TestCase ("SRv6 NEXT-C-SID steering"),
+    m_receivedBytes (0),
+    m_rxSegments (0)
+{
+}
+
+void
+CsidSteeringTestCase::ReceivePkt (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet = socket->Recv (std::numeric_limits<uint32_t>::max (), 0);
+  m_receivedBytes += packet->GetSize ();
+}
+
+void
+CsidSteeringTestCase::RxTrace (Ptr<const Packet> packet, Ptr<Ipv6> ipv6, uint32_t interface)
+{
+  Ptr<Packet> p = packet->Copy ();
+  Ipv6Header header;
+  p->RemoveHeader (header);
+  if (header.GetNextHeader () == Ipv6Header::IPV6_EXT_ROUTING)
+    {
+      Ipv6ExtensionSegmentRoutingHeader srh;
+      p->PeekHeader (srh);
+      m_rxSegments = srh.GetSegmentList ().GetN ();
+    }
+}
+
+void
+CsidSteeringTestCase::SendData (Ptr<Socket> socket, Ipv6Address to)
+{
+  socket->SendTo (Create<Packet> (123), 0, Inet6SocketAddress (to, 1234));
+}
+
+void
+CsidSteeringTestCase::DoRun (void)
+{
+  Ptr<Node> txNode = CreateObject<Node> ();
+  Ptr<Node> headNode = CreateObject<Node> ();
+  Ptr<Node> sid1Node = CreateObject<Node> ();
+  Ptr<Node> sid2Node = CreateObject<Node> ();
+  Ptr<Node> rxNode = CreateObject<Node> ();
+  NodeContainer nodes (txNode, headNode, sid1Node, sid2Node, rxNode);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net4 = helperChannel.Install (NodeContainer (txNode, headNode));
+  NetDeviceContainer net3 = helperChannel.Install (NodeContainer (headNode, sid1Node));
+  NetDeviceContainer net2 = helperChannel.Install (NodeContainer (sid1Node, sid2Node));
+  NetDeviceContainer net1 = helperChannel.Install (NodeContainer (sid2Node, rxNode));
+
+  Ipv6ListRoutingHelper listRouting;
+  listRouting.Add (Ipv6StaticRoutingHelper (), 0);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.SetRoutingHelper (listRouting);
+  internetv6.Install (nodes);
+
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); it++)
+    {
+      (*it)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+      (*it)->GetObject<Ipv6> ()->SetAttribute ("IpForward", BooleanValue (true));
+    }
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:4::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net4);
+  ipv6helper.SetBase (Ipv6Address ("2001:3::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net3);
+  ipv6helper.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net2);
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer rxInterfaces = ipv6helper.Assign (net1);
+
+  Ipv6Address headAddress = headNode->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  Ipv6Address sid1Address = sid1Node->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  Ipv6Address sid2Address = sid2Node->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+  Ipv6Address rxAddress = rxInterfaces.GetAddress (1, 1);
+
+  Ptr<Ipv6StaticRouting> txRouting = Ipv6RoutingHelper::GetRouting<Ipv6StaticRouting> (txNode->GetObject<Ipv6> ()->GetRoutingProtocol ());
+  txRouting->SetDefaultRoute (headAddress, 1);
+  Ptr<Ipv6StaticRouting> sid1Routing = Ipv6RoutingHelper::GetRouting<Ipv6StaticRouting> (sid1Node->GetObject<Ipv6> ()->GetRoutingProtocol ());
+  sid1Routing->AddNetworkRouteTo (Ipv6Address ("fcbb:bb00:2::"), Ipv6Prefix (48), sid2Address, 2);
+
+  // the SID owners bind their SID and share the C-SID format
+  Segment sid1 ("fcbb:bb00:1::");
+  Segment sid2 ("fcbb:bb00:2::");
+  Ptr<Node> owners[] = { sid1Node, sid2Node };
+  Segment sids[] = { sid1, sid2 };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ipv6SrRouting::GetSrRouting (owners[i]);
+      Ptr<Ipv6ExtensionSegmentRouting> extension = DynamicCast<Ipv6ExtensionSegmentRouting> (
+        owners[i]->GetObject<Ipv6ExtensionRoutingDemux> ()->GetExtensionRouting (Ipv6ExtensionSegmentRouting::TYPE_ROUTING));
+      NS_TEST_ASSERT_MSG_EQ (bool (extension), true, "no SRv6 extension");
+      extension->SetAttribute ("CsidBlockLength", UintegerValue (32));
+      extension->AddLocalSid (sids[i], Ipv6ExtensionSegmentRouting::END);
+    }
+
+  Ptr<Ipv6SrRouting> sr = Ipv6SrRouting::GetSrRouting (headNode);
+  uint32_t headIf = headNode->GetObject<Ipv6> ()->GetInterfaceForDevice (net3.Get (0));
+  sr->AddSid (sid1, headIf, sid1Address);
+
+  rxNode->GetObject<Ipv6L3Protocol> ()->TraceConnectWithoutContext ("Rx", MakeCallback (&CsidSteeringTestCase::RxTrace, this));
+
+  Ptr<Socket> rxSocket = rxNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  rxSocket->Bind (Inet6SocketAddress (rxAddress, 1234));
+  rxSocket->SetRecvCallback (MakeCallback (&CsidSteeringTestCase::ReceivePkt, this));
+
+  Ptr<Socket> txSocket = txNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+
+  std::vector<Segment> segments;
+  segments.push_back (sid1);
+  segments.push_back (sid2);
+
+  // uncompressed: one SRH entry per SID and one for the destination
+  sr->AddPolicy (Ipv6Address ("2001:1::"), Ipv6Prefix (64), segments);
+  Simulator::Schedule (Seconds (1), &CsidSteeringTestCase::SendData, this, txSocket, rxAddress);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 123, "packet not steered through the SIDs");
+  NS_TEST_EXPECT_MSG_EQ (m_rxSegments, 3, "wrong uncompressed SRH");
+
+  // compressed: both SIDs in one container, shifted by sid1
+  sr->SetAttribute ("CsidBlockLength", UintegerValue (32));
+  sr->AddPolicy (Ipv6Address ("2001:1::"), Ipv6Prefix (64), segments);
+  Simulator::Schedule (Seconds (2), &CsidSteeringTestCase::SendData, this, txSocket, rxAddress);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivedBytes, 246, "packet not steered through the C-SIDs");
+  NS_TEST_EXPECT_MSG_EQ (m_rxSegments, 2, "wrong compressed SRH");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Segment routing TestSuite
+ */
+class SrRoutingTestSuite : public TestSuite
+{
+public:
+  SrRoutingTestSuite ()
+    : TestSuite ("segment-routing-srv6", UNIT)
+  {
+    AddTestCase (new SrSteeringTestCase, TestCase::QUICK);
+    AddTestCase (new PrefixTrieTestCase, TestCase::QUICK);
+    AddTestCase (new SrRoutingTableTestCase, TestCase::QUICK);
+    AddTestCase (new SegmentListTestCase, TestCase::QUICK);
+    AddTestCase (new CsidSteeringTestCase, TestCase::QUICK);
+  }
+};
+
+static SrRoutingTestSuite g_srRoutingTestSuite; //!< Static variable for test initialization
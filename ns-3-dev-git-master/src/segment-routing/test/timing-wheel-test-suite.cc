@@ -0,0 +1,265 @@
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/timing-wheel.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief TimingWheel expiry times, from the first level to the last one.
+ */
+class TimingWheelExpiryTestCase : public TestCase
+{
+public:
+  TimingWheelExpiryTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record an expiry.
+   * \param index timer index
+   */
+  void Expire (uint32_t index);
+
+  /**
+   * \brief Restart the first timer.
+   */
+  void Restart (void);
+
+  std::vector<Time> m_expiry;         //!< Expiry time of each timer
+  TimingWheelTimer m_timers[8];        //!< Timers under test
+};
+
+TimingWheelExpiryTestCase::TimingWheelExpiryTestCase ()
+  : TestCase ("TimingWheel expiry, cancel and restart")
+{
+}
+
+void
+TimingWheelExpiryTestCase::Expire (uint32_t index)
+{
+  m_expiry[index] = Simulator::Now ();
+}
+
+void
+TimingWheelExpiryTestCase::Restart (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_timers[0].IsRunning (), true, "timer not running");
+  NS_TEST_EXPECT_MSG_EQ (m_timers[0].GetDelayLeft (), MilliSeconds (40), "wrong delay left");
+  m_timers[0].Cancel ();
+  NS_TEST_EXPECT_MSG_EQ (m_timers[0].IsRunning (), false, "timer still running");
+  m_timers[0].Schedule (MilliSeconds (500));
+  m_timers[1].Cancel ();
+}
+
+void
+TimingWheelExpiryTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<TimingWheel> wheel = TimingWheel::GetTimingWheel (node);
+  NS_TEST_ASSERT_MSG_EQ (TimingWheel::GetTimingWheel (node), wheel, "wheel aggregated twice");
+
+  /* one per wheel level, and one past the last level */
+  Time delays[8] = { MilliSeconds (50), MilliSeconds (60), MilliSeconds (5), Seconds (1.5),
+                     Seconds (3), Seconds (700), Seconds (2 * 86400), Seconds (600 * 86400) };
+  m_expiry.assign (8, Seconds (-1));
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      m_timers[i].SetTimingWheel (wheel);
+      m_timers[i].SetFunction (MakeCallback (&TimingWheelExpiryTestCase::Expire, this).Bind (i));
+      m_timers[i].SetDelay (delays[i]);
+      m_timers[i].Schedule ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (wheel->GetNTimers (), 8, "timers not on the wheel");
+
+  Simulator::Schedule (MilliSeconds (10), &TimingWheelExpiryTestCase::Restart, this);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_expiry[0], MilliSeconds (510), "restarted timer");
+  NS_TEST_EXPECT_MSG_EQ (m_expiry[1], Seconds (-1), "cancelled timer expired");
+  NS_TEST_EXPECT_MSG_EQ (m_expiry[2], MilliSeconds (10), "delay not rounded up to the granularity");
+  for (uint32_t i = 3; i < 8; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_expiry[i], delays[i], "timer " << i << " expired at the wrong time");
+    }
+  NS_TEST_EXPECT_MSG_EQ (wheel->GetNTimers (), 0, "timers left on the wheel");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief TimingWheel posts one event per tick, not one per timer.
+ */
+class TimingWheelEventsTestCase : public TestCase
+{
+public:
+  TimingWheelEventsTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Run timers and count the scheduler events.
+   * \param wheel the timing wheel, or 0 for ns3::Timer
+   * \return the number of events
+   */
+  uint64_t CountEvents (Ptr<TimingWheel> wheel);
+
+  /**
+   * \brief Count an expiry.
+   */
+  void Expire (void);
+
+  uint32_t m_expired; //!< Expired timers
+};
+
+TimingWheelEventsTestCase::TimingWheelEventsTestCase ()
+  : TestCase ("TimingWheel scheduler events")
+{
+}
+
+void
+TimingWheelEventsTestCase::Expire (void)
+{
+  m_expired++;
+}
+
+uint64_t
+TimingWheelEventsTestCase::CountEvents (Ptr<TimingWheel> wheel)
+{
+  const uint32_t timers = 1000;
+  std::vector<TimingWheelTimer> wheelTimers (timers);
+
+  m_expired = 0;
+  uint64_t events = Simulator::GetEventCount ();
+  for (uint32_t i = 0; i < timers; i++)
+    {
+      /* retransmission backoffs restarted before expiring, then lifetimes */
+      wheelTimers[i].SetTimingWheel (wheel);
+      wheelTimers[i].SetFunction (&TimingWheelEventsTestCase::Expire, this);
+      wheelTimers[i].Schedule (MilliSeconds (1000 + i % 10));
+      wheelTimers[i].Cancel ();
+      wheelTimers[i].Schedule (Seconds (30) + MicroSeconds (i));
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_expired, timers, "timers did not expire");
+  return Simulator::GetEventCount () - events;
+}
+
+void
+TimingWheelEventsTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+
+  uint64_t timerEvents = CountEvents (0);
+  uint64_t wheelEvents = CountEvents (TimingWheel::GetTimingWheel (node));
+
+  /* cancelled events are still popped by the scheduler */
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (timerEvents, 2000, "one event per ns3::Timer schedule");
+  /* 30 s is past the first level: cascades plus the expiry tick */
+  NS_TEST_EXPECT_MSG_LT (wheelEvents, 20, "wheel events grow with the timers");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief TimingWheel timers started while a long timer is pending, as the
+ * BU refresh and retransmission timers next to a binding lifetime.
+ */
+class TimingWheelLateStartTestCase : public TestCase
+{
+public:
+  TimingWheelLateStartTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record an expiry.
+   * \param index timer index
+   */
+  void Expire (uint32_t index);
+
+  /**
+   * \brief Start a timer.
+   * \param index timer index
+   */
+  void Start (uint32_t index);
+
+  std::vector<Time> m_start;          //!< Start time of each timer
+  std::vector<Time> m_delay;          //!< Delay of each timer
+  std::vector<Time> m_expiry;         //!< Expiry time of each timer
+  TimingWheelTimer m_timers[6];        //!< Timers under test
+};
+
+TimingWheelLateStartTestCase::TimingWheelLateStartTestCase ()
+  : TestCase ("TimingWheel short timers next to a pending long timer")
+{
+}
+
+void
+TimingWheelLateStartTestCase::Expire (uint32_t index)
+{
+  m_expiry[index] = Simulator::Now ();
+}
+
+void
+TimingWheelLateStartTestCase::Start (uint32_t index)
+{
+  m_timers[index].Schedule (m_delay[index]);
+}
+
+void
+TimingWheelLateStartTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<TimingWheel> wheel = TimingWheel::GetTimingWheel (node);
+
+  /* a binding lifetime, then refresh and retransmission timers of each level */
+  Time start[6] = { Seconds (0), Seconds (6), Seconds (6), Seconds (9.99), Seconds (400), Seconds (650) };
+  Time delays[6] = { Seconds (700), MilliSeconds (100), Seconds (3), MilliSeconds (20),
+                     Seconds (200), Seconds (1) };
+  m_start.assign (start, start + 6);
+  m_delay.assign (delays, delays + 6);
+  m_expiry.assign (6, Seconds (-1));
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      m_timers[i].SetTimingWheel (wheel);
+      m_timers[i].SetFunction (MakeCallback (&TimingWheelLateStartTestCase::Expire, this).Bind (i));
+      Simulator::Schedule (start[i], &TimingWheelLateStartTestCase::Start, this, i);
+    }
+  Simulator::Run ();
+
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_expiry[i], m_start[i] + m_delay[i], "timer " << i << " expired at the wrong time");
+    }
+  NS_TEST_EXPECT_MSG_EQ (wheel->GetNTimers (), 0, "timers left on the wheel");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief TimingWheel TestSuite
+ */
+class TimingWheelTestSuite : public TestSuite
+{
+public:
+  TimingWheelTestSuite ()
+    : TestSuite ("segment-routing-timing-wheel", UNIT)
+  {
+    AddTestCase (new TimingWheelExpiryTestCase, TestCase::QUICK);
+    AddTestCase (new TimingWheelLateStartTestCase, TestCase::QUICK);
+    AddTestCase (new TimingWheelEventsTestCase, TestCase::QUICK);
+  }
+};
+
+static TimingWheelTestSuite g_timingWheelTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,620 @@
+#include "ns3/boolean.h"
+#include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv6-header.h"
+#include "ns3/ipv6-list-routing-helper.h"
+#include "ns3/ipv6.h"
+#include "ns3/ipv6-routing-helper.h"
+#include "ns3/ipv6-static-routing.h"
+#include "ns3/ipv6-static-routing-helper.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/udp-header.h"
+#include "ns3/sr-tun-l4-protocol.h"
+#include "ns3/tunnel-net-device.h"
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Tunnels of many bindings share one device and one interface.
+ */
+class TunnelTableTestCase : public TestCase
+{
+public:
+  TunnelTableTestCase ();
+  virtual void DoRun (void);
+};
+
+TunnelTableTestCase::TunnelTableTestCase ()
+  : TestCase ("Multipoint tunnel table")
+{
+}
+
+void
+TunnelTableTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (node);
+
+  Ptr<Ipv6TunnelL4Protocol> th = CreateObject<Ipv6TunnelL4Protocol> ();
+  node->AggregateObject (th);
+  th->SetNode (node);
+
+  Ptr<Ipv6> ipv6 = node->GetObject<Ipv6> ();
+  uint32_t nInterfaces = ipv6->GetNInterfaces ();
+  uint32_t nDevices = node->GetNDevices ();
+
+  const uint32_t bindings = 1000;
+  std::vector<Ipv6Address> coas;
+  std::vector<Ipv6Address> hoas;
+  for (uint32_t i = 0; i < bindings; i++)
+    {
+      uint8_t coa[16] = { 0x20, 0x01, 0, 0x01, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, (uint8_t)(i >> 8), (uint8_t)(i & 0xff) };
+      uint8_t hoa[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, (uint8_t)(i >> 8), (uint8_t)(i & 0xff) };
+      coas.push_back (Ipv6Address (coa));
+      hoas.push_back (Ipv6Address (hoa));
+    }
+
+  int32_t ifIndex = -1;
+  for (uint32_t i = 0; i < bindings; i++)
+    {
+      uint16_t tunnelIf = th->AddTunnel (coas[i]);
+      if (ifIndex == -1)
+        {
+          ifIndex = tunnelIf;
+        }
+      NS_TEST_ASSERT_MSG_EQ (tunnelIf, ifIndex, "tunnel " << i << " on its own interface");
+      th->GetTunnelDevice (coas[i])->AddDestination (hoas[i], Ipv6Prefix (128), coas[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (ipv6->GetNInterfaces (), nInterfaces + 1, "one interface per tunnel");
+  NS_TEST_EXPECT_MSG_EQ (node->GetNDevices (), nDevices + 1, "one device per tunnel");
+
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (coas[0]);
+  NS_TEST_ASSERT_MSG_EQ (bool (tunnel), true, "no tunnel device");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNRemotes (), bindings, "remotes not in the table");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (hoas[10]), coas[10], "wrong remote for a HoA");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (Ipv6Address ("2001:db9::1")), Ipv6Address::GetAny (), "remote for an unknown destination");
+
+  // an MNP of binding 10, and a longer prefix inside it
+  tunnel->AddDestination (Ipv6Address ("2002:0:0:10::"), Ipv6Prefix (64), coas[10]);
+  tunnel->AddDestination (Ipv6Address ("2002:0:0:10::"), Ipv6Prefix (96), coas[11]);
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (Ipv6Address ("2002:0:0:10:1::5")), coas[10], "wrong remote for an MNP");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (Ipv6Address ("2002:0:0:10::5")), coas[11], "longest prefix not preferred");
+  tunnel->RemoveDestination (Ipv6Address ("2002:0:0:10::"), Ipv6Prefix (96));
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (Ipv6Address ("2002:0:0:10::5")), coas[10], "prefix not removed");
+
+  // a second reference keeps the remote and its destinations
+  th->AddTunnel (coas[10]);
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetRemoteRefCount (coas[10]), 2, "ref count not increased");
+  th->RemoveTunnel (coas[10]);
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetRemoteRefCount (coas[10]), 1, "ref count not decreased");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (hoas[10]), coas[10], "destination removed with a reference left");
+
+  // the last reference drops the destinations of the remote
+  th->RemoveTunnel (coas[10]);
+  NS_TEST_EXPECT_MSG_EQ (bool (th->GetTunnelDevice (coas[10])), false, "remote not removed");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNRemotes (), bindings - 1, "wrong number of remotes");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (hoas[10]), Ipv6Address::GetAny (), "HoA still mapped");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->LookupRemote (Ipv6Address ("2002:0:0:10::5")), Ipv6Address::GetAny (), "MNP still mapped");
+
+  // a handover moves the binding to a new CoA on the same interface
+  uint16_t tunnelIf = th->ModifyTunnel (coas[20], coas[10]);
+  NS_TEST_EXPECT_MSG_EQ (tunnelIf, ifIndex, "handover changed the interface");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->HasRemote (coas[20]), false, "old CoA still in the table");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->HasRemote (coas[10]), true, "new CoA not in the table");
+
+  for (uint32_t i = 0; i < bindings; i++)
+    {
+      th->RemoveTunnel (coas[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNRemotes (), 0, "remotes left in the table");
+  NS_TEST_EXPECT_MSG_EQ (ipv6->GetNInterfaces (), nInterfaces + 1, "tunnel interface removed");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The multipoint tunnel encapsulates towards the remote of the inner destination.
+ */
+class TunnelEncapsulationTestCase : public TestCase
+{
+public:
+  TunnelEncapsulationTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the outer header of an encapsulated packet.
+   * \param packet the packet
+   * \param ih the inner header
+   * \param oh the outer header
+   */
+  void TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh);
+
+  /**
+   * \brief Send a packet through the tunnel device.
+   * \param tunnel the tunnel device
+   * \param dst the inner destination
+   * \return the value returned by the device
+   */
+  bool Send (Ptr<TunnelNetDevice> tunnel, Ipv6Address dst);
+
+  Ipv6Header m_outer; //!< Last outer header
+};
+
+TunnelEncapsulationTestCase::TunnelEncapsulationTestCase ()
+  : TestCase ("Multipoint tunnel encapsulation")
+{
+}
+
+void
+TunnelEncapsulationTestCase::TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh)
+{
+  m_outer = oh;
+}
+
+bool
+TunnelEncapsulationTestCase::Send (Ptr<TunnelNetDevice> tunnel, Ipv6Address dst)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  Ipv6Header inner;
+  inner.SetSource (Ipv6Address ("2001:2::1"));
+  inner.SetDestination (dst);
+  inner.SetNextHeader (59);
+  inner.SetPayloadLength (packet->GetSize ());
+  packet->AddHeader (inner);
+
+  m_outer = Ipv6Header ();
+  return tunnel->Send (packet, tunnel->GetBroadcast (), 0x86DD);
+}
+
+void
+TunnelEncapsulationTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (nodes);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  nodes.Get (0)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net);
+  Ipv6Address local = nodes.Get (0)->GetObject<Ipv6> ()->GetAddress (1, 1).GetAddress ();
+
+  Ptr<Ipv6TunnelL4Protocol> th = CreateObject<Ipv6TunnelL4Protocol> ();
+  nodes.Get (0)->AggregateObject (th);
+  th->SetNode (nodes.Get (0));
+
+  Ipv6Address coa1 ("2001:1::100");
+  Ipv6Address coa2 ("2001:1::200");
+  th->AddTunnel (coa1);
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (coa1);
+  tunnel->TraceConnectWithoutContext ("MacTx2", MakeCallback (&TunnelEncapsulationTestCase::TxTrace, this));
+
+  // a single remote takes all the traffic, as for an MN
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel, Ipv6Address ("2001:db8::1")), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetDestination (), coa1, "wrong outer destination");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local, "wrong outer source");
+
+  th->AddTunnel (coa2, Ipv6Address ("2001:1::1234"));
+  tunnel->AddDestination (Ipv6Address ("2001:db8::1"), Ipv6Prefix (128), coa1);
+  tunnel->AddDestination (Ipv6Address ("2002:0:0:2::"), Ipv6Prefix (64), coa2);
+
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel, Ipv6Address ("2001:db8::1")), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetDestination (), coa1, "HoA not sent to its CoA");
+
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel, Ipv6Address ("2002:0:0:2::7")), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetDestination (), coa2, "MNP not sent to its CoA");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), Ipv6Address ("2001:1::1234"), "local address not used");
+
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel, Ipv6Address ("2001:db8::2")), false, "packet sent without a remote");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetDestination (), Ipv6Address::GetAny (), "packet encapsulated without a remote");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The route to a remote is cached until the interface goes down or the routes are invalidated.
+ */
+class TunnelRouteCacheTestCase : public TestCase
+{
+public:
+  TunnelRouteCacheTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the outer header of an encapsulated packet.
+   * \param packet the packet
+   * \param ih the inner header
+   * \param oh the outer header
+   */
+  void TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh);
+
+  /**
+   * \brief Send a packet through the tunnel device.
+   * \param tunnel the tunnel device
+   * \return the value returned by the device
+   */
+  bool Send (Ptr<TunnelNetDevice> tunnel);
+
+  Ipv6Header m_outer; //!< Last outer header
+};
+
+TunnelRouteCacheTestCase::TunnelRouteCacheTestCase ()
+  : TestCase ("Tunnel route cache")
+{
+}
+
+void
+TunnelRouteCacheTestCase::TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh)
+{
+  m_outer = oh;
+}
+
+bool
+TunnelRouteCacheTestCase::Send (Ptr<TunnelNetDevice> tunnel)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  Ipv6Header inner;
+  inner.SetSource (Ipv6Address ("2001:db8::1"));
+  inner.SetDestination (Ipv6Address ("2001:db8::2"));
+  inner.SetNextHeader (59);
+  inner.SetPayloadLength (packet->GetSize ());
+  packet->AddHeader (inner);
+
+  m_outer = Ipv6Header ();
+  return tunnel->Send (packet, tunnel->GetBroadcast (), 0x86DD);
+}
+
+void
+TunnelRouteCacheTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net1 = helperChannel.Install (nodes);
+  NetDeviceContainer net2 = helperChannel.Install (nodes);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  nodes.Get (0)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net1);
+  ipv6helper.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net2);
+  Ptr<Ipv6> ipv6 = nodes.Get (0)->GetObject<Ipv6> ();
+  Ipv6Address local1 = ipv6->GetAddress (1, 1).GetAddress ();
+  Ipv6Address local2 = ipv6->GetAddress (2, 1).GetAddress ();
+
+  Ptr<Ipv6TunnelL4Protocol> th = CreateObject<Ipv6TunnelL4Protocol> ();
+  nodes.Get (0)->AggregateObject (th);
+  th->SetNode (nodes.Get (0));
+
+  Ipv6Address coa ("2001:1::100");
+  th->AddTunnel (coa);
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (coa);
+  tunnel->TraceConnectWithoutContext ("MacTx2", MakeCallback (&TunnelRouteCacheTestCase::TxTrace, this));
+
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local1, "wrong outer source");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetDestination (), coa, "wrong outer destination");
+
+  // the cached route is kept until the routes are invalidated
+  Ptr<Ipv6StaticRouting> routing = Ipv6RoutingHelper::GetRouting<Ipv6StaticRouting> (ipv6->GetRoutingProtocol ());
+  routing->AddHostRouteTo (coa, Ipv6Address ("2001:2::200"), 2, Ipv6Address ("2001:2::"), 0);
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local1, "route not cached");
+
+  tunnel->InvalidateRoutes ();
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local2, "route not invalidated");
+
+  // the cached route is dropped with its interface
+  ipv6->SetDown (2);
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local1, "route kept on a down interface");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The route to a remote is dropped on the route and address changes notified to a list routing.
+ */
+class TunnelRouteWatcherTestCase : public TestCase
+{
+public:
+  TunnelRouteWatcherTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the outer header of an encapsulated packet.
+   * \param packet the packet
+   * \param ih the inner header
+   * \param oh the outer header
+   */
+  void TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh);
+
+  /**
+   * \brief Send a packet through the tunnel device.
+   * \param tunnel the tunnel device
+   * \return the value returned by the device
+   */
+  bool Send (Ptr<TunnelNetDevice> tunnel);
+
+  Ipv6Header m_outer; //!< Last outer header
+};
+
+TunnelRouteWatcherTestCase::TunnelRouteWatcherTestCase ()
+  : TestCase ("Tunnel route cache invalidated by routing notifications")
+{
+}
+
+void
+TunnelRouteWatcherTestCase::TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh)
+{
+  m_outer = oh;
+}
+
+bool
+TunnelRouteWatcherTestCase::Send (Ptr<TunnelNetDevice> tunnel)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  Ipv6Header inner;
+  inner.SetSource (Ipv6Address ("2001:db8::1"));
+  inner.SetDestination (Ipv6Address ("2001:db8::2"));
+  inner.SetNextHeader (59);
+  inner.SetPayloadLength (packet->GetSize ());
+  packet->AddHeader (inner);
+
+  m_outer = Ipv6Header ();
+  return tunnel->Send (packet, tunnel->GetBroadcast (), 0x86DD);
+}
+
+void
+TunnelRouteWatcherTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net1 = helperChannel.Install (nodes);
+  NetDeviceContainer net2 = helperChannel.Install (nodes);
+
+  // the watcher needs a list routing to receive the notifications
+  Ipv6ListRoutingHelper listRouting;
+  listRouting.Add (Ipv6StaticRoutingHelper (), 0);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.SetRoutingHelper (listRouting);
+  internetv6.Install (nodes);
+  nodes.Get (0)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net1);
+  ipv6helper.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net2);
+  Ptr<Ipv6> ipv6 = nodes.Get (0)->GetObject<Ipv6> ();
+  Ipv6Address local1 = ipv6->GetAddress (1, 1).GetAddress ();
+  Ipv6Address local2 = ipv6->GetAddress (2, 1).GetAddress ();
+
+  Ptr<Ipv6TunnelL4Protocol> th = CreateObject<Ipv6TunnelL4Protocol> ();
+  nodes.Get (0)->AggregateObject (th);
+  th->SetNode (nodes.Get (0));
+
+  Ipv6Address coa ("2001:1::100");
+  th->AddTunnel (coa);
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (coa);
+  tunnel->TraceConnectWithoutContext ("MacTx2", MakeCallback (&TunnelRouteWatcherTestCase::TxTrace, this));
+
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local1, "wrong outer source");
+  NS_TEST_EXPECT_MSG_EQ (bool (TunnelRouteWatcher::GetRouteWatcher (nodes.Get (0))), true, "no watcher");
+
+  // a route notified to the routing protocol, as done for the ICMPv6 redirects
+  ipv6->GetRoutingProtocol ()->NotifyAddRoute (coa, Ipv6Prefix (128), Ipv6Address ("2001:2::200"), 2, Ipv6Address ("2001:2::"));
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local2, "route not invalidated on a notified route");
+
+  ipv6->GetRoutingProtocol ()->NotifyRemoveRoute (coa, Ipv6Prefix (128), Ipv6Address ("2001:2::200"), 2, Ipv6Address ("2001:2::"));
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local1, "route not invalidated on a removed route");
+
+  // an address added on the output interface becomes the outer source
+  Ipv6Address local3 ("2001:1::300");
+  ipv6->RemoveAddress (1, local1);
+  ipv6->AddAddress (1, Ipv6InterfaceAddress (local3, Ipv6Prefix (64)));
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel), true, "packet not sent");
+  NS_TEST_EXPECT_MSG_EQ (m_outer.GetSource (), local3, "route not invalidated on an address change");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief The flows of a multihomed destination are spread over its remotes by weight.
+ */
+class TunnelMultipathTestCase : public TestCase
+{
+public:
+  TunnelMultipathTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Record the outer header of an encapsulated packet.
+   * \param packet the packet
+   * \param ih the inner header
+   * \param oh the outer header
+   */
+  void TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh);
+
+  /**
+   * \brief Send a UDP packet of a flow through the tunnel device.
+   * \param tunnel the tunnel device
+   * \param port the source port of the flow
+   * \return the outer destination of the packet
+   */
+  Ipv6Address Send (Ptr<TunnelNetDevice> tunnel, uint16_t port);
+
+  Ipv6Header m_outer; //!< Last outer header
+};
+
+TunnelMultipathTestCase::TunnelMultipathTestCase ()
+  : TestCase ("Multipoint tunnel per-flow multipath")
+{
+}
+
+void
+TunnelMultipathTestCase::TxTrace (Ptr<Packet> packet, Ipv6Header ih, Ipv6Header oh)
+{
+  m_outer = oh;
+}
+
+Ipv6Address
+TunnelMultipathTestCase::Send (Ptr<TunnelNetDevice> tunnel, uint16_t port)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (port);
+  udp.SetDestinationPort (5000);
+  packet->AddHeader (udp);
+  Ipv6Header inner;
+  inner.SetSource (Ipv6Address ("2001:2::1"));
+  inner.SetDestination (Ipv6Address ("2001:db8::1"));
+  inner.SetNextHeader (17);
+  inner.SetPayloadLength (packet->GetSize ());
+
+  //the device picks the path the flow hash gives
+  Ipv6Address expected = tunnel->LookupPath (inner.GetDestination (), TunnelNetDevice::GetFlowHash (inner, packet));
+  packet->AddHeader (inner);
+
+  m_outer = Ipv6Header ();
+  tunnel->Send (packet, tunnel->GetBroadcast (), 0x86DD);
+  if (!expected.IsAny ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_outer.GetDestination (), expected, "flow not sent on its path");
+    }
+  return m_outer.GetDestination ();
+}
+
+void
+TunnelMultipathTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  SimpleNetDeviceHelper helperChannel;
+  NetDeviceContainer net = helperChannel.Install (nodes);
+
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (nodes);
+  nodes.Get (0)->GetObject<Icmpv6L4Protocol> ()->SetAttribute ("DAD", BooleanValue (false));
+
+  Ipv6AddressHelper ipv6helper;
+  ipv6helper.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6helper.Assign (net);
+
+  Ptr<Ipv6TunnelL4Protocol> th = CreateObject<Ipv6TunnelL4Protocol> ();
+  nodes.Get (0)->AggregateObject (th);
+  th->SetNode (nodes.Get (0));
+
+  // an MR reached through two radios, three quarters of the flows on the first one
+  Ipv6Address hoa ("2001:db8::1");
+  Ipv6Address coa1 ("2001:1::100");
+  Ipv6Address coa2 ("2001:1::200");
+  th->AddTunnel (coa1);
+  th->AddTunnel (coa2);
+  Ptr<TunnelNetDevice> tunnel = th->GetTunnelDevice (coa1);
+  tunnel->TraceConnectWithoutContext ("MacTx2", MakeCallback (&TunnelMultipathTestCase::TxTrace, this));
+  tunnel->AddDestination (hoa, Ipv6Prefix (128), coa1);
+  tunnel->AddPath (hoa, Ipv6Prefix (128), coa1, 3);
+  tunnel->AddPath (hoa, Ipv6Prefix (128), coa2, 1);
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNPaths (hoa), 2, "paths not added");
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNPaths (Ipv6Address ("2001:db8::2")), 0, "paths of another destination");
+
+  const uint16_t flows = 2000;
+  std::map<Ipv6Address, uint32_t> counts;
+  std::vector<Ipv6Address> paths;
+  for (uint16_t i = 0; i < flows; i++)
+    {
+      paths.push_back (Send (tunnel, 10000 + i));
+      counts[paths.back ()]++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (counts.size (), 2, "flows not spread over the two CoAs");
+  NS_TEST_EXPECT_MSG_EQ_TOL (counts[coa1] / double (flows), 0.75, 0.05, "flows not shared by weight");
+
+  // the packets of a flow keep their path
+  for (uint16_t i = 0; i < 100; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Send (tunnel, 10000 + i), paths[i], "flow changed path");
+    }
+
+  // a weight of 0 withdraws a CoA, its flows move to the other one
+  tunnel->AddPath (hoa, Ipv6Prefix (128), coa1, 0);
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNPaths (hoa), 1, "path not withdrawn");
+  for (uint16_t i = 0; i < 100; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (Send (tunnel, 10000 + i), coa2, "flow sent on a withdrawn path");
+    }
+
+  // the last reference of a remote drops its paths, the destination is used again
+  th->RemoveTunnel (coa2);
+  NS_TEST_EXPECT_MSG_EQ (tunnel->GetNPaths (hoa), 0, "paths of a removed remote kept");
+  NS_TEST_EXPECT_MSG_EQ (Send (tunnel, 10000), coa1, "destination not used without paths");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup segment-routing-test
+ *
+ * \brief Tunnel TestSuite
+ */
+class TunnelTestSuite : public TestSuite
+{
+public:
+  TunnelTestSuite ()
+    : TestSuite ("segment-routing-tunnel", UNIT)
+  {
+    AddTestCase (new TunnelTableTestCase, TestCase::QUICK);
+    AddTestCase (new TunnelEncapsulationTestCase, TestCase::QUICK);
+    AddTestCase (new TunnelRouteCacheTestCase, TestCase::QUICK);
+    AddTestCase (new TunnelRouteWatcherTestCase, TestCase::QUICK);
+    AddTestCase (new TunnelMultipathTestCase, TestCase::QUICK);
+  }
+};
+
+static TunnelTestSuite g_tunnelTestSuite; //!< Static variable for test initialization
@@ -108,6 +108,12 @@ VisualSimulatorImpl::GetSystemId() const
     return m_simulator->GetSystemId();
 }
 
+uint32_t
+VisualSimulatorImpl::GetPartitionId() const
+{
+    return m_simulator->GetPartitionId();
+}
+
 bool
 VisualSimulatorImpl::IsFinished() const
 {
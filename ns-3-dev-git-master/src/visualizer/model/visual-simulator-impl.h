@@ -70,6 +70,7 @@ class VisualSimulatorImpl : public SimulatorImpl
     Time GetMaximumSimulationTime() const override;
     void SetScheduler(ObjectFactory schedulerFactory) override;
     uint32_t GetSystemId() const override;
+    uint32_t GetPartitionId() const override;
     uint32_t GetContext() const override;
     uint64_t GetEventCount() const override;
 
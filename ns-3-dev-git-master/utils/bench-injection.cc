@@ -0,0 +1,160 @@
+#include "ns3/core-module.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup system-tests-perf
+ * Benchmark of the events scheduled by foreign threads.
+ *
+ * Several injector threads call Simulator::ScheduleWithContext() while
+ * the simulation runs, as the reader threads of the emulation devices do.
+ * The simulation only keeps itself alive with a polling event until all
+ * the injected events have run.
+ */
+
+using namespace ns3;
+
+/** Clock of the measurements. */
+typedef std::chrono::steady_clock Clock;
+
+/** The number of events to inject, by all the threads. */
+uint64_t g_total = 0;
+/** The number of injected events run. */
+uint64_t g_received = 0;
+/** The time the injector threads were released. */
+Clock::time_point g_start;
+/** The time the last injected event ran. */
+Clock::time_point g_end;
+/** Whether the injector threads may start. */
+std::atomic<bool> g_go{false};
+
+/** An injected event. */
+void
+Receive()
+{
+    if (++g_received == g_total)
+    {
+        g_end = Clock::now();
+        Simulator::Stop();
+    }
+}
+
+/** Keep the simulation alive until all the injected events have run. */
+void
+Poll()
+{
+    if (g_received < g_total)
+    {
+        Simulator::Schedule(MicroSeconds(1), &Poll);
+    }
+}
+
+/** Release the injector threads, from the simulation. */
+void
+Start()
+{
+    g_start = Clock::now();
+    g_go = true;
+    Poll();
+}
+
+/**
+ * Body of an injector thread.
+ * \param [in] context The context of the injected events.
+ * \param [in] count The number of events to inject.
+ * \param [out] ns The time spent in Simulator::ScheduleWithContext(), in ns.
+ */
+void
+Inject(uint32_t context, uint64_t count, double* ns)
+{
+    while (!g_go)
+    {
+        std::this_thread::yield();
+    }
+    Clock::time_point start = Clock::now();
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        Simulator::ScheduleWithContext(context, Time(0), &Receive);
+    }
+    *ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+/**
+ * Run the benchmark once.
+ * \param [in] threads The number of injector threads.
+ * \param [in] count The number of events each thread injects.
+ */
+void
+RunOnce(uint32_t threads, uint64_t count)
+{
+    g_total = threads * count;
+    g_received = 0;
+    g_go = false;
+    std::vector<double> ns(threads, 0);
+    std::vector<std::thread> injectors;
+
+    // Create the simulator before the injectors use it
+    Simulator::Schedule(Time(0), &Start);
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+        injectors.emplace_back(&Inject, i, count, &ns[i]);
+    }
+    Simulator::Run();
+    for (auto& injector : injectors)
+    {
+        injector.join();
+    }
+    Simulator::Destroy();
+
+    double seconds = std::chrono::duration<double>(g_end - g_start).count();
+    double injectNs = 0;
+    for (auto n : ns)
+    {
+        injectNs += n;
+    }
+    std::cout << std::setw(8) << threads << std::setw(12) << g_total << std::setw(12)
+              << std::setprecision(4) << seconds << std::setw(14) << g_total / seconds
+              << std::setw(14) << injectNs / g_total << std::endl;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t threads = 4;
+    uint64_t count = 100000;
+    uint32_t runs = 3;
+    bool realtime = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Benchmark the events scheduled by foreign threads.\n"
+              "\n"
+              "Injector threads call Simulator::ScheduleWithContext() while\n"
+              "the simulation runs; the events are drained by the main thread.");
+    cmd.AddValue("threads", "number of injector threads", threads);
+    cmd.AddValue("events", "number of events injected by each thread", count);
+    cmd.AddValue("runs", "number of runs", runs);
+    cmd.AddValue("realtime", "use the RealtimeSimulatorImpl", realtime);
+    cmd.Parse(argc, argv);
+
+    if (realtime)
+    {
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::RealtimeSimulatorImpl"));
+    }
+
+    std::cout << (realtime ? "RealtimeSimulatorImpl" : "DefaultSimulatorImpl") << std::endl;
+    std::cout << std::setw(8) << "Threads" << std::setw(12) << "Events" << std::setw(12)
+              << "Time (s)" << std::setw(14) << "Rate (ev/s)" << std::setw(14) << "Inject (ns)"
+              << std::endl;
+    for (uint32_t run = 0; run < runs; ++run)
+    {
+        RunOnce(threads, count);
+    }
+    return 0;
+}
@@ -20,9 +20,12 @@
 #include "ns3/core-module.h"
 
 #include <cmath> // sqrt
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <new>
+#include <sstream>
 #include <string.h>
 #include <vector>
 
@@ -47,6 +50,49 @@ std::string g_me;
 /** Output field width for numeric data. */
 int g_fwidth = 6;
 
+/** Flag to report the heap allocations per event. */
+bool g_allocs = false;
+
+/** Number of calls to the global operator new, by this program and the libraries. */
+uint64_t g_heapAllocations = 0;
+
+/**
+ * Replacement of the global operator new counting the heap allocations.
+ * \param [in] size The size of the block.
+ * \returns The block.
+ */
+void*
+operator new(std::size_t size)
+{
+    ++g_heapAllocations;
+    void* block = std::malloc(size == 0 ? 1 : size);
+    if (block == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+/**
+ * Replacement of the global operator delete matching operator new.
+ * \param [in] block The block.
+ */
+void
+operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+/**
+ * Replacement of the global sized operator delete matching operator new.
+ * \param [in] block The block.
+ */
+void
+operator delete(void* block, std::size_t /* size */) noexcept
+{
+    std::free(block);
+}
+
 /**
  *  Benchmark instance which can do a single run.
  *
@@ -103,10 +149,12 @@ class Bench
     /** The output. */
     struct Result
     {
-        double init;     /**< Time (s) for initialization. */
-        double simu;     /**< Time (s) for simulation. */
-        uint64_t pop;    /**< Event population. */
-        uint64_t events; /**< Number of events executed. */
+        double init;          /**< Time (s) for initialization. */
+        double simu;          /**< Time (s) for simulation. */
+        uint64_t pop;         /**< Event population. */
+        uint64_t events;      /**< Number of events executed. */
+        uint64_t initAllocs;  /**< Heap allocations during initialization. */
+        uint64_t simuAllocs;  /**< Heap allocations during simulation. */
     };
 
     /**
@@ -136,10 +184,13 @@ Bench::Run()
     SystemWallClockMs timer;
     double init;
     double simu;
+    uint64_t initAllocs;
+    uint64_t simuAllocs;
 
     DEB("initializing");
     m_count = 0;
 
+    uint64_t allocs = g_heapAllocations;
     timer.Start();
     for (uint64_t i = 0; i < m_population; ++i)
     {
@@ -147,17 +198,20 @@ Bench::Run()
         Simulator::Schedule(at, &Bench::Cb, this);
     }
     init = timer.End() / 1000.0;
+    initAllocs = g_heapAllocations - allocs;
     DEB("initialization took " << init << "s");
 
     DEB("running");
+    allocs = g_heapAllocations;
     timer.Start();
     Simulator::Run();
     simu = timer.End() / 1000.0;
+    simuAllocs = g_heapAllocations - allocs;
     DEB("run took " << simu << "s");
 
     Simulator::Destroy();
 
-    return Result{init, simu, m_population, m_count};
+    return Result{init, simu, m_population, m_count, initAllocs, simuAllocs};
 }
 
 void
@@ -214,6 +268,7 @@ class BenchSuite
         double time;   /**< Phase run time time (s). */
         double rate;   /**< Phase event rate (events/s). */
         double period; /**< Phase period (s/event). */
+        double allocs; /**< Phase heap allocations per event. */
     };
 
     /** Results from initialization and execution of a single run. */
@@ -248,8 +303,11 @@ class BenchSuite
 BenchSuite::Result
 BenchSuite::Result::Bench(Bench::Result r)
 {
-    return Result{{r.init, r.pop / r.init, r.init / r.pop},
-                  {r.simu, r.events / r.simu, r.simu / r.events}};
+    return Result{{r.init, r.pop / r.init, r.init / r.pop, double(r.initAllocs) / r.pop},
+                  {r.simu,
+                   r.events / r.simu,
+                   r.simu / r.events,
+                   double(r.simuAllocs) / r.events}};
 }
 
 template <typename T>
@@ -258,6 +316,15 @@ BenchSuite::Result::Log(T label) const
 {
     // Need std::left for string labels
 
+    if (g_allocs)
+    {
+        LOG(std::left << std::setw(g_fwidth) << label << std::setw(g_fwidth) << init.time
+                      << std::setw(g_fwidth) << init.rate << std::setw(g_fwidth) << init.period
+                      << std::setw(g_fwidth) << init.allocs << std::setw(g_fwidth) << run.time
+                      << std::setw(g_fwidth) << run.rate << std::setw(g_fwidth) << run.period
+                      << std::setw(g_fwidth) << run.allocs);
+        return;
+    }
     LOG(std::left << std::setw(g_fwidth) << label << std::setw(g_fwidth) << init.time
                   << std::setw(g_fwidth) << init.rate << std::setw(g_fwidth) << init.period
                   << std::setw(g_fwidth) << run.time << std::setw(g_fwidth) << run.rate
@@ -299,10 +366,17 @@ BenchSuite::BenchSuite(ObjectFactory& factory,
     // Perform the actual runs
     for (uint64_t i = 0; i < runs; i++)
     {
+        // Simulator::Destroy() in the previous run dropped the scheduler
+        Simulator::SetScheduler(factory);
         auto run = bench.Run();
         m_results.push_back(Result::Bench(run));
         m_results.back().Log(i);
     }
+    if (g_allocs)
+    {
+        LOG("event allocator slabs: " << EventAllocator::GetSlabCount()
+                                      << ", large events: " << EventAllocator::GetLargeCount());
+    }
 
     Simulator::Destroy();
 
@@ -314,6 +388,26 @@ BenchSuite::Header() const
     // table header
     LOG("");
     LOG(m_scheduler);
+    if (g_allocs)
+    {
+        LOG(std::left << std::setw(g_fwidth) << "Run #" << std::left << std::setw(4 * g_fwidth)
+                      << "Initialization:" << std::left << "Simulation:");
+        LOG(std::left << std::setw(g_fwidth) << "" << std::left << std::setw(g_fwidth)
+                      << "Time (s)" << std::left << std::setw(g_fwidth) << "Rate (ev/s)"
+                      << std::left << std::setw(g_fwidth) << "Per (s/ev)" << std::left
+                      << std::setw(g_fwidth) << "Allocs/ev" << std::left << std::setw(g_fwidth)
+                      << "Time (s)" << std::left << std::setw(g_fwidth) << "Rate (ev/s)"
+                      << std::left << std::setw(g_fwidth) << "Per (s/ev)" << std::left
+                      << "Allocs/ev");
+        LOG(std::setfill('-') << std::right << std::setw(g_fwidth) << " " << std::right
+                              << std::setw(g_fwidth) << " " << std::right << std::setw(g_fwidth)
+                              << " " << std::right << std::setw(g_fwidth) << " " << std::right
+                              << std::setw(g_fwidth) << " " << std::right << std::setw(g_fwidth)
+                              << " " << std::right << std::setw(g_fwidth) << " " << std::right
+                              << std::setw(g_fwidth) << " " << std::right << std::setw(g_fwidth)
+                              << " " << std::setfill(' '));
+        return;
+    }
     LOG(std::left << std::setw(g_fwidth) << "Run #" << std::left << std::setw(3 * g_fwidth)
                   << "Initialization:" << std::left << "Simulation:");
     LOG(std::left << std::setw(g_fwidth) << "" << std::left << std::setw(g_fwidth) << "Time (s)"
@@ -345,8 +439,8 @@ BenchSuite::Log() const
 
     uint64_t n{0};                // number of samples
     Result average{m_results[0]}; // average
-    Result moment2{{0, 0, 0},     // 2nd moment, to calculate stdev
-                   {0, 0, 0}};
+    Result moment2{{0, 0, 0, 0},  // 2nd moment, to calculate stdev
+                   {0, 0, 0, 0}};
 
     for (; n < m_results.size(); ++n)
     {
@@ -364,9 +458,11 @@ BenchSuite::Log() const
         ACCUMULATE(init, time);
         ACCUMULATE(init, rate);
         ACCUMULATE(init, period);
+        ACCUMULATE(init, allocs);
         ACCUMULATE(run, time);
         ACCUMULATE(run, rate);
         ACCUMULATE(run, period);
+        ACCUMULATE(run, allocs);
 
 #undef ACCUMULATE
     }
@@ -374,10 +470,12 @@ BenchSuite::Log() const
     auto stdev = Result{
         {std::sqrt(moment2.init.time / n),
          std::sqrt(moment2.init.rate / n),
-         std::sqrt(moment2.init.period / n)},
+         std::sqrt(moment2.init.period / n),
+         std::sqrt(moment2.init.allocs / n)},
         {std::sqrt(moment2.run.time / n),
          std::sqrt(moment2.run.rate / n),
-         std::sqrt(moment2.run.period / n)},
+         std::sqrt(moment2.run.period / n),
+         std::sqrt(moment2.run.allocs / n)},
     };
 
     average.Log("average");
@@ -451,12 +549,70 @@ GetRandomStream(std::string filename)
     return stream;
 }
 
+/**
+ *  Create a RandomVariableStream replaying the event delays of a DES Metrics
+ *  trace (see DesMetrics), e.g., recorded from a wifi or LTE example run
+ *  with DES Metrics enabled.
+ *
+ *  Each event record `["src",send,"dst",exec]` gives the delay `exec - send`,
+ *  in the Time resolution of the recorded run, assumed to be ns.
+ *
+ *  \param [in] filename The DES Metrics JSON trace file name.
+ *  \returns The RandomVariableStream.
+ */
+Ptr<RandomVariableStream>
+GetDesStream(std::string filename)
+{
+    LOG("  Event time distribution:      from DES Metrics trace " << filename);
+    std::ifstream input(filename);
+    std::vector<double> nsValues;
+    std::string line;
+    bool inEvents = false;
+    while (std::getline(input, line))
+    {
+        if (!inEvents)
+        {
+            inEvents = line.find("\"events\"") != std::string::npos;
+            continue;
+        }
+        auto open = line.find('[');
+        auto close = line.find(']', open);
+        if (open == std::string::npos || close == std::string::npos)
+        {
+            continue;
+        }
+        std::string record = line.substr(open + 1, close - open - 1);
+        for (auto& c : record)
+        {
+            if (c == '"' || c == ',')
+            {
+                c = ' ';
+            }
+        }
+        std::istringstream fields(record);
+        std::string source;
+        std::string destination;
+        double send;
+        double exec;
+        if (fields >> source >> send >> destination >> exec && exec >= send)
+        {
+            nsValues.push_back(exec - send);
+        }
+    }
+    LOG("    Found " << nsValues.size() << " events");
+    NS_ABORT_MSG_IF(nsValues.empty(), "no event in DES Metrics trace " << filename);
+    auto drv = CreateObject<DeterministicRandomVariable>();
+    drv->SetValueArray(&nsValues[0], nsValues.size());
+    return drv;
+}
+
 int
 main(int argc, char* argv[])
 {
     bool allSched = false;
     bool schedCal = false;
     bool schedHeap = false;
+    bool schedLadder = false;
     bool schedList = false;
     bool schedMap = false; // default scheduler
     bool schedPQ = false;
@@ -465,6 +621,7 @@ main(int argc, char* argv[])
     uint64_t total = 1000000;
     uint64_t runs = 1;
     std::string filename = "";
+    std::string desFilename = "";
     bool calRev = false;
 
     CommandLine cmd(__FILE__);
@@ -474,22 +631,28 @@ main(int argc, char* argv[])
               "  an exponential distribution, with mean 100 ns,\n"
               "  an ascii file, given by the --file=\"<filename>\" argument,\n"
               "  or standard input, by the argument --file=\"-\"\n"
+              "  a DES Metrics trace, given by the --des=\"<filename>\" argument.\n"
               "In the case of either --file form, the input is expected\n"
               "to be ascii, giving the relative event times in ns.\n"
+              "The DES Metrics traces of real runs, e.g., of the wifi or lte\n"
+              "examples, are recorded by configuring with --enable-des-metrics.\n"
               "\n"
               "If no scheduler is specified the MapScheduler will be run.");
     cmd.AddValue("all", "use all schedulers", allSched);
     cmd.AddValue("cal", "use CalendarScheduler", schedCal);
     cmd.AddValue("calrev", "reverse ordering in the CalendarScheduler", calRev);
     cmd.AddValue("heap", "use HeapScheduler", schedHeap);
+    cmd.AddValue("ladder", "use LadderScheduler", schedLadder);
     cmd.AddValue("list", "use ListScheduler", schedList);
     cmd.AddValue("map", "use MapScheduler (default)", schedMap);
     cmd.AddValue("pri", "use PriorityQueue", schedPQ);
+    cmd.AddValue("allocs", "report the heap allocations per event", g_allocs);
     cmd.AddValue("debug", "enable debugging output", g_debug);
     cmd.AddValue("pop", "event population size", pop);
     cmd.AddValue("total", "total number of events to run", total);
     cmd.AddValue("runs", "number of runs", runs);
     cmd.AddValue("file", "file of relative event times", filename);
+    cmd.AddValue("des", "DES Metrics trace file of the event times", desFilename);
     cmd.AddValue("prec", "printed output precision", g_fwidth);
     cmd.Parse(argc, argv);
 
@@ -502,18 +665,22 @@ main(int argc, char* argv[])
     LOG("  Total events per run:         " << total);
     LOG("  Number of runs per scheduler: " << runs);
     DEB("debugging is ON");
+    if (g_allocs)
+    {
+        LOG("  Allocations per event:        heap (operator new) allocations by the phase");
+    }
 
     if (allSched)
     {
-        schedCal = schedHeap = schedList = schedMap = schedPQ = true;
+        schedCal = schedHeap = schedLadder = schedList = schedMap = schedPQ = true;
     }
     // Set the default case if nothing else is set
-    if (!(schedCal || schedHeap || schedList || schedMap || schedPQ))
+    if (!(schedCal || schedHeap || schedLadder || schedList || schedMap || schedPQ))
     {
         schedMap = true;
     }
 
-    auto eventStream = GetRandomStream(filename);
+    auto eventStream = desFilename.empty() ? GetRandomStream(filename) : GetDesStream(desFilename);
 
     ObjectFactory factory("ns3::MapScheduler");
     if (schedCal)
@@ -532,6 +699,11 @@ main(int argc, char* argv[])
         factory.SetTypeId("ns3::HeapScheduler");
         BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
     }
+    if (schedLadder)
+    {
+        factory.SetTypeId("ns3::LadderScheduler");
+        BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
+    }
     if (schedList)
     {
         factory.SetTypeId("ns3::ListScheduler");